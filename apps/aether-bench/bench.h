@@ -0,0 +1,26 @@
+#pragma once
+#include <time.h>
+
+struct el_bench_timer
+{
+	struct timespec start;
+};
+
+void el_bench_timer_start(struct el_bench_timer * timer);
+double el_bench_timer_ns(struct el_bench_timer const * timer);
+
+// Compile each benchmark program to bytecode and call its run function num_calls times, or its default number of times if 0
+// Reports instructions executed per second
+int el_bench_vm(int num_calls);
+
+// Run each benchmark program on the vm and compiled by the jit, comparing their times
+int el_bench_jit(int num_calls);
+
+// Run element-wise loops over int[] and float[] on the vm and the jit, with and without lowering them to vector kernels
+int el_bench_vectors(int num_calls);
+
+// Step bodies laid out as data blocks and as soa columns on the vm and the jit, num_bodies of them or a range of sizes if 0
+int el_bench_layouts(int num_bodies);
+
+// Generate a file of num_functions small functions, or a default number if 0, then time re-parsing single line edits against a full parse
+int el_bench_reparse(int num_functions);
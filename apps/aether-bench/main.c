@@ -0,0 +1,297 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <allocators/fmalloc.h>
+#include <containers/string.h>
+#include <containers/hash-map.h>
+
+#define DEFAULT_NUM_KEYS (1 << 16)
+#define NUM_LOOKUP_ROUNDS 8
+
+// Separately chained table with one allocation per entry, the baseline el_hash_map is compared against
+struct el_chained_entry
+{
+	el_string key;
+	int value;
+	struct el_chained_entry * next;
+};
+
+struct el_chained_map
+{
+	struct el_chained_entry ** buckets;
+	int num_buckets;
+	int size;
+};
+
+static el_string * el_bench_make_identifiers(int num_keys, int seed);
+static void el_bench_delete_identifiers(el_string * keys, int num_keys);
+
+static bool el_chained_map_new(struct el_chained_map * map, int num_buckets);
+static void el_chained_map_delete(struct el_chained_map * map);
+static int * el_chained_map_find(struct el_chained_map const * map, el_string key);
+static int * el_chained_map_insert(struct el_chained_map * map, el_string key);
+
+static void el_bench_hash_map(el_string * keys, el_string * missing_keys, int num_keys);
+static void el_bench_chained_map(el_string * keys, el_string * missing_keys, int num_keys);
+
+// Compares el_hash_map with a chained table on identifier-shaped keys, or with --vm runs programs on the vm
+// With --jit the programs run on both the vm and the jit, with --vectors element-wise loops run with and without vector kernels
+// With --layouts bodies are stepped as data blocks and as soa columns, with --reparse edits to a large generated file are re-parsed incrementally
+// Usage: aether-bench [num_keys] | aether-bench --vm [num_calls] | aether-bench --jit [num_calls] | aether-bench --vectors [num_calls]
+//   | aether-bench --layouts [num_bodies] | aether-bench --reparse [num_functions]
+int main(int argc, char const * argv[])
+{
+	if(argc > 1 && strcmp(argv[1], "--vm") == 0)
+		return el_bench_vm(argc > 2 ? atoi(argv[2]) : 0);
+	if(argc > 1 && strcmp(argv[1], "--jit") == 0)
+		return el_bench_jit(argc > 2 ? atoi(argv[2]) : 0);
+	if(argc > 1 && strcmp(argv[1], "--vectors") == 0)
+		return el_bench_vectors(argc > 2 ? atoi(argv[2]) : 0);
+	if(argc > 1 && strcmp(argv[1], "--layouts") == 0)
+		return el_bench_layouts(argc > 2 ? atoi(argv[2]) : 0);
+	if(argc > 1 && strcmp(argv[1], "--reparse") == 0)
+		return el_bench_reparse(argc > 2 ? atoi(argv[2]) : 0);
+
+	int num_keys = argc > 1 ? atoi(argv[1]) : DEFAULT_NUM_KEYS;
+	if(num_keys <= 0)
+	{
+		fprintf(stderr, "Number of keys must be positive\n");
+		return 1;
+	}
+
+	el_string * keys = el_bench_make_identifiers(num_keys, 1);
+	el_string * missing_keys = el_bench_make_identifiers(num_keys, 2);
+	if(!keys || !missing_keys)
+	{
+		fprintf(stderr, "Failed to allocate keys\n");
+		return 1;
+	}
+
+	printf("%d identifier keys, ns per operation\n\n", num_keys);
+	printf("%-12s %10s %10s %10s\n", "map", "insert", "hit", "miss");
+	el_bench_hash_map(keys, missing_keys, num_keys);
+	el_bench_chained_map(keys, missing_keys, num_keys);
+
+	el_bench_delete_identifiers(keys, num_keys);
+	el_bench_delete_identifiers(missing_keys, num_keys);
+	return 0;
+}
+
+// Names built from common identifier parts and a numeric suffix, e.g. particle_count12
+// Keys from different seeds do not overlap
+static el_string * el_bench_make_identifiers(int num_keys, int seed)
+{
+	static char const * prefixes[] = { "particle", "velocity", "index", "tmp", "mesh", "result", "num", "get", "is", "node" };
+	static char const * suffixes[] = { "_count", "_x", "_y", "_list", "_size", "", "_id", "_buffer" };
+
+	el_string * keys = fmalloc(sizeof(el_string) * num_keys);
+	if(!keys)
+		return NULL;
+
+	srand(seed);
+	for(int i = 0; i < num_keys; ++i)
+	{
+		char name[64];
+		int length = snprintf(name, sizeof name, "%s%s%d%c",
+			prefixes[rand() % (sizeof prefixes / sizeof prefixes[0])],
+			suffixes[rand() % (sizeof suffixes / sizeof suffixes[0])],
+			i, seed == 1 ? 'a' : 'b');
+		keys[i] = el_string_new(name, length);
+		if(!keys[i])
+		{
+			el_bench_delete_identifiers(keys, i);
+			return NULL;
+		}
+	}
+	return keys;
+}
+
+static void el_bench_delete_identifiers(el_string * keys, int num_keys)
+{
+	for(int i = 0; i < num_keys; ++i)
+		el_string_delete(keys[i]);
+	ffree(keys);
+}
+
+static void el_bench_hash_map(el_string * keys, el_string * missing_keys, int num_keys)
+{
+	struct el_hash_map map;
+	if(!el_hash_map_new(&map, sizeof(el_string), sizeof(int), 0, el_hash_string_key, el_string_key_equals, NULL))
+	{
+		fprintf(stderr, "Failed to create hash map\n");
+		return;
+	}
+
+	struct el_bench_timer timer;
+	el_bench_timer_start(&timer);
+	for(int i = 0; i < num_keys; ++i)
+	{
+		int * value = el_hash_map_insert(&map, &keys[i], NULL);
+		if(value)
+			*value = i;
+	}
+	double insert_ns = el_bench_timer_ns(&timer);
+
+	long long checksum = 0;
+	el_bench_timer_start(&timer);
+	for(int r = 0; r < NUM_LOOKUP_ROUNDS; ++r)
+	{
+		for(int i = 0; i < num_keys; ++i)
+		{
+			int * value = el_hash_map_find(&map, &keys[i]);
+			checksum += value ? *value : -1;
+		}
+	}
+	double hit_ns = el_bench_timer_ns(&timer);
+
+	el_bench_timer_start(&timer);
+	for(int r = 0; r < NUM_LOOKUP_ROUNDS; ++r)
+	{
+		for(int i = 0; i < num_keys; ++i)
+			checksum += el_hash_map_find(&map, &missing_keys[i]) != NULL;
+	}
+	double miss_ns = el_bench_timer_ns(&timer);
+
+	printf("%-12s %10.1f %10.1f %10.1f (checksum %lld)\n", "el_hash_map",
+		insert_ns / num_keys, hit_ns / ((double)num_keys * NUM_LOOKUP_ROUNDS), miss_ns / ((double)num_keys * NUM_LOOKUP_ROUNDS), checksum);
+	el_hash_map_delete(&map);
+}
+
+static void el_bench_chained_map(el_string * keys, el_string * missing_keys, int num_keys)
+{
+	struct el_chained_map map;
+	if(!el_chained_map_new(&map, 16))
+	{
+		fprintf(stderr, "Failed to create chained map\n");
+		return;
+	}
+
+	struct el_bench_timer timer;
+	el_bench_timer_start(&timer);
+	for(int i = 0; i < num_keys; ++i)
+	{
+		int * value = el_chained_map_insert(&map, keys[i]);
+		if(value)
+			*value = i;
+	}
+	double insert_ns = el_bench_timer_ns(&timer);
+
+	long long checksum = 0;
+	el_bench_timer_start(&timer);
+	for(int r = 0; r < NUM_LOOKUP_ROUNDS; ++r)
+	{
+		for(int i = 0; i < num_keys; ++i)
+		{
+			int * value = el_chained_map_find(&map, keys[i]);
+			checksum += value ? *value : -1;
+		}
+	}
+	double hit_ns = el_bench_timer_ns(&timer);
+
+	el_bench_timer_start(&timer);
+	for(int r = 0; r < NUM_LOOKUP_ROUNDS; ++r)
+	{
+		for(int i = 0; i < num_keys; ++i)
+			checksum += el_chained_map_find(&map, missing_keys[i]) != NULL;
+	}
+	double miss_ns = el_bench_timer_ns(&timer);
+
+	printf("%-12s %10.1f %10.1f %10.1f (checksum %lld)\n", "chained",
+		insert_ns / num_keys, hit_ns / ((double)num_keys * NUM_LOOKUP_ROUNDS), miss_ns / ((double)num_keys * NUM_LOOKUP_ROUNDS), checksum);
+	el_chained_map_delete(&map);
+}
+
+static bool el_chained_map_new(struct el_chained_map * map, int num_buckets)
+{
+	map->buckets = fmalloc(sizeof(struct el_chained_entry *) * num_buckets);
+	if(!map->buckets)
+		return false;
+
+	memset(map->buckets, 0, sizeof(struct el_chained_entry *) * num_buckets);
+	map->num_buckets = num_buckets;
+	map->size = 0;
+	return true;
+}
+
+static void el_chained_map_delete(struct el_chained_map * map)
+{
+	for(int i = 0; i < map->num_buckets; ++i)
+	{
+		struct el_chained_entry * entry = map->buckets[i];
+		while(entry)
+		{
+			struct el_chained_entry * next = entry->next;
+			ffree(entry);
+			entry = next;
+		}
+	}
+	ffree(map->buckets);
+}
+
+static int * el_chained_map_find(struct el_chained_map const * map, el_string key)
+{
+	uint64_t hash = el_hash_bytes(key, el_string_length(key));
+	for(struct el_chained_entry * entry = map->buckets[hash % map->num_buckets]; entry; entry = entry->next)
+	{
+		if(el_string_equals(entry->key, key))
+			return &entry->value;
+	}
+	return NULL;
+}
+
+// Doubles the number of buckets whenever the average chain length reaches 1
+static int * el_chained_map_insert(struct el_chained_map * map, el_string key)
+{
+	int * value = el_chained_map_find(map, key);
+	if(value)
+		return value;
+
+	if(map->size >= map->num_buckets)
+	{
+		struct el_chained_map grown;
+		if(!el_chained_map_new(&grown, map->num_buckets * 2))
+			return NULL;
+
+		for(int i = 0; i < map->num_buckets; ++i)
+		{
+			struct el_chained_entry * entry = map->buckets[i];
+			while(entry)
+			{
+				struct el_chained_entry * next = entry->next;
+				uint64_t hash = el_hash_bytes(entry->key, el_string_length(entry->key));
+				entry->next = grown.buckets[hash % grown.num_buckets];
+				grown.buckets[hash % grown.num_buckets] = entry;
+				entry = next;
+			}
+		}
+
+		grown.size = map->size;
+		ffree(map->buckets);
+		*map = grown;
+	}
+
+	struct el_chained_entry * entry = fmalloc(sizeof(struct el_chained_entry));
+	if(!entry)
+		return NULL;
+
+	uint64_t hash = el_hash_bytes(key, el_string_length(key));
+	entry->key = key;
+	entry->value = 0;
+	entry->next = map->buckets[hash % map->num_buckets];
+	map->buckets[hash % map->num_buckets] = entry;
+	++map->size;
+	return &entry->value;
+}
+
+void el_bench_timer_start(struct el_bench_timer * timer)
+{
+	timespec_get(&timer->start, TIME_UTC);
+}
+
+double el_bench_timer_ns(struct el_bench_timer const * timer)
+{
+	struct timespec end;
+	timespec_get(&end, TIME_UTC);
+	return (end.tv_sec - timer->start.tv_sec) * 1e9 + (end.tv_nsec - timer->start.tv_nsec);
+}
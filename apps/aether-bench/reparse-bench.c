@@ -0,0 +1,118 @@
+#include "bench.h"
+#include <stdio.h>
+#include <string.h>
+#include <allocators/fmalloc.h>
+#include <file-system/file-system.h>
+#include <containers/string.h>
+#include <compiler/error.h>
+#include <compiler/lexing/lexer.h>
+#include <compiler/syntax-parsing/parser.h>
+
+#define DEFAULT_NUM_FUNCTIONS 4096
+#define NUM_STATEMENTS_PER_FUNCTION 8
+#define NUM_EDITS 1000
+
+static el_string el_bench_make_source(int num_functions, int * edit_offset);
+
+int el_bench_reparse(int num_functions)
+{
+	if(num_functions < 0)
+	{
+		fprintf(stderr, "Number of functions must not be negative\n");
+		return 1;
+	}
+	num_functions = num_functions > 0 ? num_functions : DEFAULT_NUM_FUNCTIONS;
+
+	// Edits land in the body of the middle function
+	int edit_offset = 0;
+	struct el_text_file f = { .contents = el_bench_make_source(num_functions, &edit_offset) };
+	if(!f.contents)
+	{
+		fprintf(stderr, "Failed to allocate source\n");
+		return 1;
+	}
+
+	struct el_bench_timer timer;
+	el_bench_timer_start(&timer);
+	struct el_token_stream token_stream = el_lex_file(&f);
+	struct el_ast ast = token_stream.tokens ? el_parse_token_stream(&token_stream, el_PARSE_DEFAULT) : (struct el_ast){ 0 };
+	double full_ns = el_bench_timer_ns(&timer);
+	if(!ast.allocator.memory)
+	{
+		fprintf(stderr, "Failed to parse source\n");
+		el_token_stream_delete(&token_stream);
+		el_string_delete(f.contents);
+		return 1;
+	}
+
+	// Alternately insert and remove a statement, s.t. the splice grows and shrinks the token stream
+	// An even number of edits leaves the source as it was generated
+	static char const inserted[] = "\tedited = 1 + 2\n";
+	int inserted_length = (int)strlen(inserted);
+	int err = el_SUCCESS;
+	double max_ns = 0.0;
+	el_bench_timer_start(&timer);
+	for(int i = 0; i < NUM_EDITS && err == el_SUCCESS; ++i)
+	{
+		struct el_text_edit edit = i % 2 == 0
+			? (struct el_text_edit){ edit_offset, 0, inserted, inserted_length }
+			: (struct el_text_edit){ edit_offset, inserted_length, "", 0 };
+
+		struct el_bench_timer edit_timer;
+		el_bench_timer_start(&edit_timer);
+		err = el_reparse_edits(&ast, &token_stream, &f, &edit, 1);
+		double edit_ns = el_bench_timer_ns(&edit_timer);
+		max_ns = edit_ns > max_ns ? edit_ns : max_ns;
+	}
+	double reparse_ns = el_bench_timer_ns(&timer);
+
+	if(err != el_SUCCESS)
+	{
+		fprintf(stderr, "Failed to re-parse edit\n");
+	}
+	else
+	{
+		printf("%d lines, %d tokens, %d statements\n\n", num_functions * (NUM_STATEMENTS_PER_FUNCTION + 3), token_stream.num_tokens, ast.root.num_statements);
+		printf("%-24s %10.3f ms\n", "full lex and parse", full_ns / 1e6);
+		printf("%-24s %10.3f ms\n", "re-parse edit (mean)", reparse_ns / (1e6 * NUM_EDITS));
+		printf("%-24s %10.3f ms\n", "re-parse edit (max)", max_ns / 1e6);
+	}
+
+	el_ast_delete(&ast);
+	el_token_stream_delete(&token_stream);
+	el_string_delete(f.contents);
+	return err == el_SUCCESS ? 0 : 1;
+}
+
+// Functions of a few statements each, like
+//   fnc f12(x int) int {
+//       a0 = x + 0
+//       ...
+//       ret a7
+//   }
+static el_string el_bench_make_source(int num_functions, int * edit_offset)
+{
+	size_t capacity = (size_t)num_functions * (64 + NUM_STATEMENTS_PER_FUNCTION * 32) + 64;
+	char * source = fmalloc(capacity);
+	if(!source)
+		return NULL;
+
+	size_t length = 0;
+	for(int i = 0; i < num_functions; ++i)
+	{
+		length += snprintf(source + length, capacity - length, "fnc f%d(x int) int {\n", i);
+		if(i == num_functions / 2)
+		{
+			*edit_offset = (int)length;
+		}
+		for(int j = 0; j < NUM_STATEMENTS_PER_FUNCTION; ++j)
+		{
+			length += snprintf(source + length, capacity - length, "\ta%d = x + %d\n", j, j);
+		}
+		length += snprintf(source + length, capacity - length, "\tret a%d\n}\n", NUM_STATEMENTS_PER_FUNCTION - 1);
+	}
+
+	el_string contents = el_string_new(source, (int)length);
+	ffree(source);
+	return contents;
+}
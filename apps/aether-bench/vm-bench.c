@@ -0,0 +1,559 @@
+#include "bench.h"
+#include <stdio.h>
+#include <string.h>
+#include <allocators/fmalloc.h>
+#include <file-system/file-system.h>
+#include <containers/string.h>
+#include <compiler/error.h>
+#include <compiler/lexing/lexer.h>
+#include <compiler/syntax-parsing/parser.h>
+#include <compiler/semantic-analysis/name-resolution.h>
+#include <compiler/semantic-analysis/type-table.h>
+#include <compiler/semantic-analysis/type-checker.h>
+#include <compiler/semantic-analysis/constant-folding.h>
+#include <compiler/ir/ir-lowering.h>
+#include <vm/bytecode-compiler.h>
+#include <vm/vm.h>
+#include <jit/jit.h>
+
+// Each program has a function run(n int), called with argument
+struct el_vm_benchmark
+{
+	char const * name;
+	char const * source;
+	long long argument;
+	int num_calls;
+};
+
+// Everything a program needs from source to bytecode, the later stages view the earlier ones
+struct el_bench_program
+{
+	struct el_text_file text_file;
+	struct el_token_stream token_stream;
+	struct el_ast ast;
+	struct el_symbol_table symbols;
+	struct el_type_table types;
+	struct el_ir_module ir_module;
+	struct el_bc_program program;
+};
+
+
+static struct el_vm_benchmark const benchmarks[] = {
+	{
+		"fib",
+		"fnc fib(n int) int {\n"
+		"	if n < 2 {\n"
+		"		ret n\n"
+		"	}\n"
+		"	ret fib(n - 1) + fib(n - 2)\n"
+		"}\n"
+		"fnc run(n int) int {\n"
+		"	ret fib(n)\n"
+		"}\n",
+		27, 1
+	},
+	{
+		"slice loops",
+		"fnc run(n int) int {\n"
+		"	xs = [3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 8, 9, 7, 9, 3, 2, 3, 8, 4, 6, 2, 6, 4, 3, 3, 8, 3, 2, 7, 9, 5]\n"
+		"	ys = [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0]\n"
+		"	for i, x in xs {\n"
+		"		for j, y in xs {\n"
+		"			ys[j] = ys[j] + x * y + n\n"
+		"		}\n"
+		"	}\n"
+		"	total = 0\n"
+		"	for i, y in ys {\n"
+		"		total = total + y\n"
+		"	}\n"
+		"	ret total\n"
+		"}\n",
+		1, 400
+	},
+	{
+		"structs",
+		"dat Vec {\n"
+		"	x float\n"
+		"	y float\n"
+		"}\n"
+		"dat Particle {\n"
+		"	pos Vec\n"
+		"	vel Vec\n"
+		"	mass float\n"
+		"}\n"
+		"fnc step(ps Particle[], dt float) float {\n"
+		"	energy = 0.0\n"
+		"	for i, p in ps {\n"
+		"		p.pos.x = p.pos.x + p.vel.x * dt\n"
+		"		p.pos.y = p.pos.y + p.vel.y * dt\n"
+		"		if p.pos.y < 0.0 {\n"
+		"			p.pos.y = 0.0 - p.pos.y\n"
+		"			p.vel.y = 0.0 - p.vel.y\n"
+		"		}\n"
+		"		p.vel.y = p.vel.y - 9.8 * dt\n"
+		"		energy = energy + 0.5 * p.mass * (p.vel.x * p.vel.x + p.vel.y * p.vel.y)\n"
+		"	}\n"
+		"	ret energy\n"
+		"}\n"
+		"fnc run(n int) float {\n"
+		"	ps = [Particle(Vec(0.0, 1.0), Vec(1.0, 0.0), 1.0), Particle(Vec(1.0, 2.0), Vec(0.5, 1.0), 2.0), Particle(Vec(2.0, 3.0), Vec(0.0, 2.0), 0.5), Particle(Vec(3.0, 4.0), Vec(2.0, 0.5), 1.5)]\n"
+		"	steps = [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31]\n"
+		"	energy = 0.0\n"
+		"	for s, t in steps {\n"
+		"		energy = energy + step(ps, 0.01)\n"
+		"	}\n"
+		"	ret energy\n"
+		"}\n",
+		1, 400
+	},
+	{
+		// Each function calls from its first statement, with its parameters live across the call
+		// Each check adds its power of 10 only if the call left the parameter intact
+		"first calls",
+		"fnc twice(a int) int {\n"
+		"	ret a * 2\n"
+		"}\n"
+		"fnc five() float {\n"
+		"	ret 5.0\n"
+		"}\n"
+		"fnc add_twice(p int) int {\n"
+		"	x = twice(p)\n"
+		"	ret x + p\n"
+		"}\n"
+		"fnc add_five(p float) float {\n"
+		"	x = five()\n"
+		"	ret x + p\n"
+		"}\n"
+		"fnc fma(p float2, q float2) float2 {\n"
+		"	ret p * q + p\n"
+		"}\n"
+		"fnc run(n int) int {\n"
+		"	x = add_twice(n)\n"
+		"	v = fma(float2(1.0, 2.0), float2(3.0, 4.0))\n"
+		"	ret (x == 3 * n) + (add_five(2.0) == 7.0) * 10 + (v[0] == 4.0) * 100 + (v[1] == 10.0) * 1000\n"
+		"}\n",
+		21, 100000
+	}
+};
+
+// The same loop over bodies laid out as an array of data blocks and, with layout " soa", as a column per field
+// The loop reads three of the eight fields and writes one, run 4 times per call over the bodies passed to run
+#define el_BODIES_SOURCE(layout) \
+	"dat Body" layout " {\n" \
+	"	x float\n" \
+	"	y float\n" \
+	"	z float\n" \
+	"	vx float\n" \
+	"	vy float\n" \
+	"	vz float\n" \
+	"	mass float\n" \
+	"	id int\n" \
+	"}\n" \
+	"fnc advance(bs Body[], dt float) float {\n" \
+	"	energy = 0.0\n" \
+	"	for i, b in bs {\n" \
+	"		b.x = b.x + b.vx * dt\n" \
+	"		energy = energy + b.mass * b.vx * b.vx\n" \
+	"	}\n" \
+	"	ret energy\n" \
+	"}\n" \
+	"fnc run(bs Body[]) float {\n" \
+	"	steps = [0, 1, 2, 3]\n" \
+	"	energy = 0.0\n" \
+	"	for s, t in steps {\n" \
+	"		energy = energy + advance(bs, 0.01)\n" \
+	"	}\n" \
+	"	ret energy\n" \
+	"}\n"
+#define el_BODY_NUM_FIELDS 8
+#define el_BODY_STEPS_PER_CALL 4
+
+// Each number of bodies is stepped about this many times in total, s.t. every size takes a similar time
+#define el_BODY_UPDATES (1 << 24)
+
+// An element-wise loop over 256 elements of each type, run 32 times per call, with vector loops lowered to kernels and without
+#define el_INTS_16 "3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 8, 9, 7, 9, 3"
+#define el_INTS_64 el_INTS_16 ", " el_INTS_16 ", " el_INTS_16 ", " el_INTS_16
+#define el_INTS_256 el_INTS_64 ", " el_INTS_64 ", " el_INTS_64 ", " el_INTS_64
+#define el_FLOATS_16 "0.5, 1.5, 2.5, 0.25, 4.0, 1.0, 3.5, 2.0, 0.75, 1.25, 6.0, 0.125, 5.5, 2.25, 3.0, 1.75"
+#define el_FLOATS_64 el_FLOATS_16 ", " el_FLOATS_16 ", " el_FLOATS_16 ", " el_FLOATS_16
+#define el_FLOATS_256 el_FLOATS_64 ", " el_FLOATS_64 ", " el_FLOATS_64 ", " el_FLOATS_64
+#define el_STEPS "[0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31]"
+
+static struct el_vm_benchmark const vector_benchmarks[] = {
+	{
+		"int[]",
+		"fnc run(n int) int {\n"
+		"	xs = [" el_INTS_256 "]\n"
+		"	ys = [" el_INTS_256 "]\n"
+		"	steps = " el_STEPS "\n"
+		"	for s, t in steps {\n"
+		"		k = n + t\n"
+		"		for i, x in xs {\n"
+		"			ys[i] = ys[i] * 3 + x * k - i + (x < 5) * 2\n"
+		"		}\n"
+		"	}\n"
+		"	total = 0\n"
+		"	for i, y in ys {\n"
+		"		total = total * 31 + y\n"
+		"	}\n"
+		"	ret total\n"
+		"}\n",
+		1, 400
+	},
+	{
+		"float[]",
+		"fnc run(n int) float {\n"
+		"	xs = [" el_FLOATS_256 "]\n"
+		"	ys = [" el_FLOATS_256 "]\n"
+		"	a = 0.0\n"
+		"	steps = " el_STEPS "\n"
+		"	for s, t in steps {\n"
+		"		a = a + 0.125\n"
+		"		for i, x in xs {\n"
+		"			ys[i] = ys[i] * 0.5 + x * a - x / 4.0\n"
+		"		}\n"
+		"	}\n"
+		"	total = 0.0\n"
+		"	for i, y in ys {\n"
+		"		total = total + y\n"
+		"	}\n"
+		"	ret total\n"
+		"}\n",
+		1, 400
+	}
+};
+
+static int el_bench_compile(struct el_bench_program * p, char const * name, char const * source, int flags);
+static void el_bench_program_delete(struct el_bench_program * p);
+static void el_bench_run(struct el_vm_benchmark const * benchmark, int num_calls);
+static void el_bench_compare(struct el_vm_benchmark const * benchmark, int num_calls);
+static void el_bench_compare_vectors(struct el_vm_benchmark const * benchmark, int num_calls);
+static bool el_bench_time_backends(char const * name, char const * source, union el_value argument, int num_calls, int flags, double * vm_ns, double * jit_ns, union el_value * result);
+static void el_bench_compare_layouts(int num_bodies);
+static void * el_bench_new_bodies(int num_bodies, bool is_soa, union el_value * bodies);
+
+int el_bench_vm(int num_calls)
+{
+	if(num_calls < 0)
+	{
+		fprintf(stderr, "Number of calls must not be negative\n");
+		return 1;
+	}
+
+	printf("%-12s %8s %14s %10s %12s\n", "program", "calls", "instructions", "ms", "Minstr/s");
+	for(size_t i = 0; i < sizeof benchmarks / sizeof benchmarks[0]; ++i)
+	{
+		el_bench_run(&benchmarks[i], num_calls > 0 ? num_calls : benchmarks[i].num_calls);
+	}
+	return 0;
+}
+
+int el_bench_jit(int num_calls)
+{
+	if(num_calls < 0)
+	{
+		fprintf(stderr, "Number of calls must not be negative\n");
+		return 1;
+	}
+
+	printf("%-12s %8s %10s %10s %8s\n", "program", "calls", "vm ms", "jit ms", "speedup");
+	for(size_t i = 0; i < sizeof benchmarks / sizeof benchmarks[0]; ++i)
+	{
+		el_bench_compare(&benchmarks[i], num_calls > 0 ? num_calls : benchmarks[i].num_calls);
+	}
+	return 0;
+}
+
+int el_bench_vectors(int num_calls)
+{
+	if(num_calls < 0)
+	{
+		fprintf(stderr, "Number of calls must not be negative\n");
+		return 1;
+	}
+
+	printf("%-12s %8s %10s %10s %8s %10s %10s %8s\n", "program", "calls", "vm ms", "vm vec ms", "speedup", "jit ms", "jit vec ms", "speedup");
+	for(size_t i = 0; i < sizeof vector_benchmarks / sizeof vector_benchmarks[0]; ++i)
+	{
+		el_bench_compare_vectors(&vector_benchmarks[i], num_calls > 0 ? num_calls : vector_benchmarks[i].num_calls);
+	}
+	return 0;
+}
+
+int el_bench_layouts(int num_bodies)
+{
+	if(num_bodies < 0)
+	{
+		fprintf(stderr, "Number of bodies must not be negative\n");
+		return 1;
+	}
+
+	// From fitting in l1 to well past the last level cache
+	static int const default_num_bodies[] = { 16, 16384, 1 << 20 };
+	printf("%-10s %8s %10s %10s %10s %10s\n", "bodies", "calls", "vm aos ms", "vm soa ms", "jit aos ms", "jit soa ms");
+	if(num_bodies > 0)
+	{
+		el_bench_compare_layouts(num_bodies);
+		return 0;
+	}
+	for(size_t i = 0; i < sizeof default_num_bodies / sizeof default_num_bodies[0]; ++i)
+	{
+		el_bench_compare_layouts(default_num_bodies[i]);
+	}
+	return 0;
+}
+
+static void el_bench_run(struct el_vm_benchmark const * benchmark, int num_calls)
+{
+	struct el_bench_program p = { 0 };
+	struct el_vm vm = { 0 };
+	int run = -1;
+	if(el_bench_compile(&p, benchmark->name, benchmark->source, el_IR_LOWER_DEFAULT) != el_SUCCESS || (run = el_bc_find_function(&p.program, "run")) < 0)
+	{
+		fprintf(stderr, "Failed to compile %s\n", benchmark->name);
+		el_bench_program_delete(&p);
+		return;
+	}
+	if(!el_vm_new(&vm, &p.program))
+	{
+		fprintf(stderr, "Failed to allocate vm\n");
+		el_bench_program_delete(&p);
+		return;
+	}
+
+	// Data blocks and slices are only freed with the vm, which is fine for the few each call allocates
+	union el_value argument = { .i = benchmark->argument };
+	union el_value result = { 0 };
+	int err = el_vm_call(&vm, p.program.init_function, NULL, NULL);
+	struct el_bench_timer timer;
+	el_bench_timer_start(&timer);
+	for(int i = 0; i < num_calls && err == el_SUCCESS; ++i)
+	{
+		err = el_vm_call(&vm, run, &argument, &result);
+	}
+	double ns = el_bench_timer_ns(&timer);
+
+	if(err == el_SUCCESS)
+	{
+		long long num_instructions = vm.num_executed_instructions;
+		printf("%-12s %8d %14lld %10.1f %12.1f (result %.17g)\n", benchmark->name, num_calls, num_instructions, ns / 1e6, num_instructions / (ns / 1e3),
+			p.program.functions[run].return_type == el_FLOAT_TYPE_ID ? result.f : (double)result.i);
+	}
+	el_vm_delete(&vm);
+	el_bench_program_delete(&p);
+}
+
+static void el_bench_compare(struct el_vm_benchmark const * benchmark, int num_calls)
+{
+	double vm_ns = 0.0;
+	double jit_ns = 0.0;
+	union el_value result;
+	union el_value argument = { .i = benchmark->argument };
+	if(el_bench_time_backends(benchmark->name, benchmark->source, argument, num_calls, el_IR_LOWER_DEFAULT, &vm_ns, &jit_ns, &result))
+	{
+		printf("%-12s %8d %10.1f %10.1f %7.1fx\n", benchmark->name, num_calls, vm_ns / 1e6, jit_ns / 1e6, vm_ns / jit_ns);
+	}
+}
+
+// Kernels run the same operations on each element as the loop, s.t. the results agree to the bit
+static void el_bench_compare_vectors(struct el_vm_benchmark const * benchmark, int num_calls)
+{
+	double vm_ns[2] = { 0.0 };
+	double jit_ns[2] = { 0.0 };
+	union el_value results[2];
+	union el_value argument = { .i = benchmark->argument };
+	if(!el_bench_time_backends(benchmark->name, benchmark->source, argument, num_calls, el_IR_LOWER_NO_KERNELS, &vm_ns[0], &jit_ns[0], &results[0])
+		|| !el_bench_time_backends(benchmark->name, benchmark->source, argument, num_calls, el_IR_LOWER_DEFAULT, &vm_ns[1], &jit_ns[1], &results[1]))
+		return;
+
+	if(results[0].i != results[1].i)
+	{
+		fprintf(stderr, "Results of %s with and without kernels differ\n", benchmark->name);
+		return;
+	}
+	printf("%-12s %8d %10.1f %10.1f %7.1fx %10.1f %10.1f %7.1fx\n", benchmark->name, num_calls, vm_ns[0] / 1e6, vm_ns[1] / 1e6, vm_ns[0] / vm_ns[1],
+		jit_ns[0] / 1e6, jit_ns[1] / 1e6, jit_ns[0] / jit_ns[1]);
+}
+
+// The bodies are built by the bench rather than by a slice literal, whose every element takes ir registers
+// Both layouts start from the same values, and the loop never writes the fields energy is summed from, s.t. all four results agree
+static void el_bench_compare_layouts(int num_bodies)
+{
+	int num_calls = el_BODY_UPDATES / el_BODY_STEPS_PER_CALL / num_bodies;
+	num_calls = num_calls > 0 ? num_calls : 1;
+
+	double vm_ns[2] = { 0.0 };
+	double jit_ns[2] = { 0.0 };
+	union el_value results[2];
+	for(int is_soa = 0; is_soa < 2; ++is_soa)
+	{
+		union el_value bodies;
+		void * memory = el_bench_new_bodies(num_bodies, is_soa, &bodies);
+		if(!memory)
+		{
+			fprintf(stderr, "Failed to allocate %d bodies\n", num_bodies);
+			return;
+		}
+
+		bool timed = el_bench_time_backends(is_soa ? "soa bodies" : "aos bodies", is_soa ? el_BODIES_SOURCE(" soa") : el_BODIES_SOURCE(""), bodies, num_calls,
+			el_IR_LOWER_DEFAULT, &vm_ns[is_soa], &jit_ns[is_soa], &results[is_soa]);
+		ffree(memory);
+		if(!timed)
+			return;
+	}
+
+	if(results[0].i != results[1].i)
+	{
+		fprintf(stderr, "Results of %d aos and soa bodies differ\n", num_bodies);
+		return;
+	}
+	printf("%-10d %8d %10.1f %10.1f %10.1f %10.1f\n", num_bodies, num_calls, vm_ns[0] / 1e6, vm_ns[1] / 1e6, jit_ns[0] / 1e6, jit_ns[1] / 1e6);
+}
+
+// Lay out num_bodies bodies as the vm and jit would, a field every 8 bytes in declaration order
+// bodies receives the Body[] value, the returned memory holds all of it and is freed with ffree
+static void * el_bench_new_bodies(int num_bodies, bool is_soa, union el_value * bodies)
+{
+	size_t num_values = is_soa
+		? el_BODY_NUM_FIELDS + el_BODY_NUM_FIELDS * (1 + (size_t)num_bodies)
+		: 1 + (size_t)num_bodies + el_BODY_NUM_FIELDS * (size_t)num_bodies;
+	union el_value * memory = fmalloc(sizeof(union el_value) * num_values);
+	if(!memory)
+		return NULL;
+
+	memset(memory, 0, sizeof(union el_value) * num_values);
+	struct el_vm_slice * slice = (struct el_vm_slice *)memory;
+	union el_value * blocks = memory + 1 + num_bodies;
+	union el_value * columns[el_BODY_NUM_FIELDS];
+	if(is_soa)
+	{
+		// A block of columns, each a slice of one field of every body
+		for(int field = 0; field < el_BODY_NUM_FIELDS; ++field)
+		{
+			struct el_vm_slice * column = (struct el_vm_slice *)(memory + el_BODY_NUM_FIELDS + field * (1 + (size_t)num_bodies));
+			column->length = num_bodies;
+			columns[field] = column->elements;
+			memory[field].p = column;
+		}
+		bodies->p = memory;
+	}
+	else
+	{
+		slice->length = num_bodies;
+		bodies->p = slice;
+	}
+
+	for(int i = 0; i < num_bodies; ++i)
+	{
+		union el_value * body = is_soa ? NULL : blocks + el_BODY_NUM_FIELDS * (size_t)i;
+		if(!is_soa)
+			slice->elements[i].p = body;
+
+		// x, y, z, vx, vy, vz, mass and id
+		union el_value values[el_BODY_NUM_FIELDS] = { { .f = i + 1.0 }, { .f = 1.0 }, { .f = 2.0 }, { .f = 1.0 / (i + 1.0) }, { .f = 0.5 }, { .f = 0.25 },
+			{ .f = 1.0 + (i % 1024) / 1024.0 }, { .i = i } };
+		for(int field = 0; field < el_BODY_NUM_FIELDS; ++field)
+		{
+			if(is_soa)
+				columns[field][i] = values[field];
+			else
+				body[field] = values[field];
+		}
+	}
+	return memory;
+}
+
+// Both backends start from the same ir, and must agree on the result
+static bool el_bench_time_backends(char const * name, char const * source, union el_value argument, int num_calls, int flags, double * vm_ns, double * jit_ns, union el_value * result)
+{
+	struct el_bench_program p = { 0 };
+	struct el_vm vm = { 0 };
+	struct el_jit jit = { 0 };
+	int run = -1;
+	if(el_bench_compile(&p, name, source, flags) != el_SUCCESS || (run = el_bc_find_function(&p.program, "run")) < 0
+		|| el_jit_compile(&jit, &p.ir_module) != el_SUCCESS)
+	{
+		fprintf(stderr, "Failed to compile %s\n", name);
+		el_bench_program_delete(&p);
+		return false;
+	}
+	if(!el_vm_new(&vm, &p.program))
+	{
+		fprintf(stderr, "Failed to allocate vm\n");
+		el_jit_delete(&jit);
+		el_bench_program_delete(&p);
+		return false;
+	}
+
+	union el_value vm_result = { 0 };
+	union el_value jit_result = { 0 };
+	int err = el_vm_call(&vm, p.program.init_function, NULL, NULL);
+	struct el_bench_timer timer;
+	el_bench_timer_start(&timer);
+	for(int i = 0; i < num_calls && err == el_SUCCESS; ++i)
+	{
+		err = el_vm_call(&vm, run, &argument, &vm_result);
+	}
+	*vm_ns = el_bench_timer_ns(&timer);
+
+	err = err || el_jit_call(&jit, p.ir_module.init_function, NULL, NULL);
+	el_bench_timer_start(&timer);
+	for(int i = 0; i < num_calls && err == el_SUCCESS; ++i)
+	{
+		err = el_jit_call(&jit, run, &argument, &jit_result);
+	}
+	*jit_ns = el_bench_timer_ns(&timer);
+
+	bool agree = err == el_SUCCESS && vm_result.i == jit_result.i;
+	if(err == el_SUCCESS && !agree)
+	{
+		fprintf(stderr, "Results of %s differ\n", name);
+	}
+	*result = vm_result;
+	el_vm_delete(&vm);
+	el_jit_delete(&jit);
+	el_bench_program_delete(&p);
+	return agree;
+}
+
+static int el_bench_compile(struct el_bench_program * p, char const * name, char const * source, int flags)
+{
+	p->text_file.contents = el_string_new(source, (int)strlen(source));
+	p->text_file.path = el_string_new(name, (int)strlen(name));
+	if(!p->text_file.contents || !p->text_file.path)
+		return el_ALLOCATION_ERROR;
+
+	p->token_stream = el_lex_file(&p->text_file);
+	if(!p->token_stream.tokens)
+		return el_ALLOCATION_ERROR;
+
+	p->ast = el_parse_token_stream(&p->token_stream, el_PARSE_DEFAULT);
+	if(!p->ast.allocator.memory)
+		return el_MATCH_TOKEN_PARSE_ERROR;
+
+	if(!el_symbol_table_new(&p->symbols))
+		return el_ALLOCATION_ERROR;
+
+	int err = el_resolve_names(&p->ast, &p->symbols);
+	if(!err && !el_type_table_new(&p->types, &p->symbols))
+		return el_ALLOCATION_ERROR;
+
+	err = err || el_intern_ast_types(&p->ast, &p->types);
+	err = err || el_type_check(&p->ast, &p->symbols, &p->types, el_TYPE_CHECK_DEFAULT);
+	err = err || el_fold_constants(&p->ast);
+	err = err || el_ir_lower(&p->ir_module, &p->ast, &p->symbols, &p->types, flags);
+	err = err || el_bc_compile(&p->program, &p->ir_module);
+	return err;
+}
+
+static void el_bench_program_delete(struct el_bench_program * p)
+{
+	el_bc_program_delete(&p->program);
+	el_ir_module_delete(&p->ir_module);
+	el_type_table_delete(&p->types);
+	el_symbol_table_delete(&p->symbols);
+	el_ast_delete(&p->ast);
+	el_token_stream_delete(&p->token_stream);
+	el_text_file_delete(&p->text_file);
+}
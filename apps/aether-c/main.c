@@ -1,29 +1,211 @@
 #include <stdio.h>
+#include <string.h>
 #include <file-system/path.h>
 #include <file-system/file-system.h>
+#include <file-system/buffered-writer.h>
+#include <containers/string.h>
+#include <containers/string-builder.h>
+#include <compiler/error.h>
 #include <compiler/lexing/token-stream.h>
 #include <compiler/lexing/lexer.h>
 #include <compiler/syntax-parsing/ast.h>
 #include <compiler/syntax-parsing/parser.h>
+#include <compiler/syntax-parsing/ast-cache.h>
+#include <compiler/syntax-parsing/ast-dump.h>
+#include <compiler/semantic-analysis/name-resolution.h>
+#include <compiler/semantic-analysis/type-table.h>
+#include <compiler/semantic-analysis/type-checker.h>
+#include <compiler/semantic-analysis/constant-folding.h>
+#include <compiler/ir/ir-lowering.h>
+#include <compiler/ir/ir-dump.h>
+#include <compiler/code-generation/c-emitter.h>
+#include <compiler/code-generation/c-toolchain.h>
+#include <vm/bytecode-compiler.h>
+#include <vm/vm.h>
+#include <jit/jit.h>
+
+static int el_run_program(struct el_ir_module const * ir_module);
+static int el_jit_program(struct el_ir_module const * ir_module);
+static int el_write_c(char const * path, struct el_ast * ast, struct el_symbol_table const * symbols, struct el_type_table const * types, int flags);
+static int el_build_native(char const * output_path, int output, struct el_ast * ast, struct el_symbol_table const * symbols, struct el_type_table const * types);
 
 int main(int argc, char const * argv[])
 {
-	if(argc < 2)
+	char const * path = NULL;
+	char const * ast_cache_path = NULL;
+	int parse_flags = el_PARSE_DEFAULT;
+	int dump_format = -1;
+	bool dump_ir = false;
+	bool run = false;
+	bool jit = false;
+	char const * c_path = NULL;
+	bool c_main = false;
+	char const * native_path = NULL;
+	int native_output = el_NATIVE_EXECUTABLE;
+	for(int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i], "--lazy-bodies") == 0)
+		{
+			parse_flags |= el_PARSE_LAZY_FUNCTION_BODIES;
+		}
+		else if(strcmp(argv[i], "--parallel") == 0)
+		{
+			parse_flags |= el_PARSE_PARALLEL;
+		}
+		else if(strcmp(argv[i], "--dump-ast") == 0)
+		{
+			dump_format = el_AST_DUMP_TEXT;
+		}
+		else if(strcmp(argv[i], "--dump-ast=sexpr") == 0)
+		{
+			dump_format = el_AST_DUMP_SEXPR;
+		}
+		else if(strcmp(argv[i], "--dump-ast=json") == 0)
+		{
+			dump_format = el_AST_DUMP_JSON;
+		}
+		else if(strcmp(argv[i], "--dump-ir") == 0)
+		{
+			dump_ir = true;
+		}
+		else if(strcmp(argv[i], "--run") == 0)
+		{
+			run = true;
+		}
+		else if(strcmp(argv[i], "--jit") == 0)
+		{
+			jit = true;
+		}
+		else if(strcmp(argv[i], "--emit-c") == 0 && i + 1 < argc)
+		{
+			c_path = argv[++i];
+		}
+		else if(strcmp(argv[i], "--c-main") == 0)
+		{
+			c_main = true;
+		}
+		else if(strcmp(argv[i], "--native") == 0 && i + 1 < argc)
+		{
+			native_path = argv[++i];
+			native_output = el_NATIVE_EXECUTABLE;
+		}
+		else if(strcmp(argv[i], "--shared") == 0 && i + 1 < argc)
+		{
+			native_path = argv[++i];
+			native_output = el_NATIVE_SHARED_LIBRARY;
+		}
+		else if(strcmp(argv[i], "--ast-cache") == 0 && i + 1 < argc)
+		{
+			ast_cache_path = argv[++i];
+		}
+		else
+		{
+			path = argv[i];
+		}
+	}
+
+	if(!path)
 		return 0;
 
-	char const * path = argv[1];
 	printf("Compiling %s\n\n", path);
 
+	// Exits non-zero unless every stage the options asked for succeeded
+	int exit_code = 1;
+
 	struct el_text_file text_file = el_text_file_new(path);
 	if(!text_file.contents)
 		goto close_file;
 
-	struct el_token_stream token_stream = el_lex_file(&text_file);
+	struct el_token_stream token_stream = { 0 };
+	struct el_ast ast = { 0 };
+	struct el_symbol_table symbol_table = { 0 };
+	struct el_type_table type_table = { 0 };
+	struct el_ir_module ir_module = { 0 };
+
+	// An unchanged source file is loaded straight from its cached ast without lexing or parsing
+	uint64_t source_hash = el_ast_cache_hash(text_file.contents, el_string_length(text_file.contents));
+	if(ast_cache_path && el_ast_cache_load(&ast, source_hash, ast_cache_path) == el_SUCCESS)
+	{
+		printf("Loaded ast from %s\n", ast_cache_path);
+		goto resolve_names;
+	}
+
+	token_stream = el_lex_file(&text_file);
 	if(!token_stream.tokens)
 		goto free_token_stream;
 
-	struct el_ast ast = el_parse_token_stream(&token_stream);
+	ast = el_parse_token_stream(&token_stream, parse_flags);
+	if(ast_cache_path && ast.allocator.memory)
+	{
+		el_ast_cache_save(&ast, source_hash, ast_cache_path);
+	}
+
+resolve_names:
+	if(!ast.allocator.memory && !ast.cache_image)
+		goto delete_ast;
+
+	// Each stage reports its own errors, a program which fails one is not passed on to the next
+	int err = el_symbol_table_new(&symbol_table) ? el_SUCCESS : el_ALLOCATION_ERROR;
+	err = err || el_resolve_names(&ast, &symbol_table);
+	if(err == el_SUCCESS && !el_type_table_new(&type_table, &symbol_table))
+	{
+		err = el_ALLOCATION_ERROR;
+	}
+	err = err || el_intern_ast_types(&ast, &type_table);
+	err = err || el_type_check(&ast, &symbol_table, &type_table, (parse_flags & el_PARSE_PARALLEL) ? el_TYPE_CHECK_PARALLEL : el_TYPE_CHECK_DEFAULT);
+	err = err || el_fold_constants(&ast);
+
+	// Only the ir dump, vm and jit read the ir, code generation works from the ast
+	if(err == el_SUCCESS && (dump_ir || run || jit))
+	{
+		err = el_ir_lower(&ir_module, &ast, &symbol_table, &type_table, el_IR_LOWER_DEFAULT);
+	}
+
+	if(dump_format >= 0)
+	{
+		// Anything already printed through stdio must come out before the dump
+		fflush(stdout);
+		struct el_buffered_writer writer;
+		if(el_buffered_writer_new(&writer, fileno(stdout), 0))
+		{
+			el_ast_dump(&ast, &writer, dump_format);
+		}
+		el_buffered_writer_delete(&writer);
+	}
 
+	if(dump_ir && err == el_SUCCESS)
+	{
+		fflush(stdout);
+		struct el_buffered_writer writer;
+		if(el_buffered_writer_new(&writer, fileno(stdout), 0))
+		{
+			el_ir_dump(&ir_module, &writer);
+		}
+		el_buffered_writer_delete(&writer);
+	}
+
+	if(run && err == el_SUCCESS)
+	{
+		err = el_run_program(&ir_module);
+	}
+
+	if(jit && err == el_SUCCESS)
+	{
+		err = el_jit_program(&ir_module);
+	}
+
+	if(err == el_SUCCESS && (c_path || native_path))
+	{
+		err = c_path ? el_write_c(c_path, &ast, &symbol_table, &type_table, c_main ? el_C_EMIT_MAIN : el_C_EMIT_DEFAULT) : el_SUCCESS;
+		err = err || (native_path ? el_build_native(native_path, native_output, &ast, &symbol_table, &type_table) : el_SUCCESS);
+	}
+	exit_code = err == el_SUCCESS ? 0 : 1;
+
+	el_ir_module_delete(&ir_module);
+	el_type_table_delete(&type_table);
+	el_symbol_table_delete(&symbol_table);
+
+delete_ast:
 	el_ast_delete(&ast);
 
 free_token_stream:
@@ -32,5 +214,119 @@ free_token_stream:
 close_file:
 	el_text_file_delete(&text_file);
 
-	return 0;
+	return exit_code;
+}
+
+// Run the file scope statements, then main if the program has one
+// Returns the error which stopped the program, which has already been reported
+static int el_run_program(struct el_ir_module const * ir_module)
+{
+	fflush(stdout);
+	struct el_bc_program program;
+	int err = el_bc_compile(&program, ir_module);
+	if(err != el_SUCCESS)
+		return err;
+
+	struct el_vm vm;
+	if(!el_vm_new(&vm, &program))
+	{
+		fprintf(stderr, "Failed to allocate vm\n");
+		el_bc_program_delete(&program);
+		return el_ALLOCATION_ERROR;
+	}
+
+	int main_function = el_bc_find_function(&program, "main");
+	union el_value result = { 0 };
+	err = el_vm_call(&vm, program.init_function, NULL, NULL);
+	if(err == el_SUCCESS && main_function >= 0 && program.functions[main_function].num_parameters == 0)
+	{
+		err = el_vm_call(&vm, main_function, NULL, &result);
+		if(err == el_SUCCESS && program.functions[main_function].return_type == el_INT_TYPE_ID)
+		{
+			printf("main returned %lld\n", result.i);
+		}
+		else if(err == el_SUCCESS && program.functions[main_function].return_type == el_FLOAT_TYPE_ID)
+		{
+			printf("main returned %.17g\n", result.f);
+		}
+	}
+	printf("Executed %lld instructions\n", vm.num_executed_instructions);
+
+	el_vm_delete(&vm);
+	el_bc_program_delete(&program);
+	return err;
+}
+
+// Run the program as el_run_program does, compiled to machine code
+static int el_jit_program(struct el_ir_module const * ir_module)
+{
+	fflush(stdout);
+	struct el_jit jit;
+	int err = el_jit_compile(&jit, ir_module);
+	if(err != el_SUCCESS)
+		return err;
+
+	int main_function = -1;
+	for(int i = 0; i < ir_module->num_functions && main_function < 0; ++i)
+	{
+		main_function = ir_module->functions[i].name && strcmp(ir_module->functions[i].name, "main") == 0 ? i : -1;
+	}
+
+	union el_value result = { 0 };
+	err = el_jit_call(&jit, ir_module->init_function, NULL, NULL);
+	if(err == el_SUCCESS && main_function >= 0 && ir_module->functions[main_function].num_parameters == 0)
+	{
+		err = el_jit_call(&jit, main_function, NULL, &result);
+		if(err == el_SUCCESS && ir_module->functions[main_function].return_type == el_INT_TYPE_ID)
+		{
+			printf("main returned %lld\n", result.i);
+		}
+		else if(err == el_SUCCESS && ir_module->functions[main_function].return_type == el_FLOAT_TYPE_ID)
+		{
+			printf("main returned %.17g\n", result.f);
+		}
+	}
+	el_jit_delete(&jit);
+	return err;
+}
+
+static int el_write_c(char const * path, struct el_ast * ast, struct el_symbol_table const * symbols, struct el_type_table const * types, int flags)
+{
+	FILE * file = fopen(path, "wb");
+	if(!file)
+	{
+		fprintf(stderr, "Failed to open %s\n", path);
+		return el_IO_ERROR;
+	}
+
+	struct el_buffered_writer writer;
+	int err = el_ALLOCATION_ERROR;
+	if(el_buffered_writer_new(&writer, fileno(file), 0))
+	{
+		err = el_emit_c(ast, symbols, types, &writer, flags);
+		el_buffered_writer_delete(&writer);
+	}
+	fclose(file);
+	return err;
+}
+
+// The C source is kept next to the output, s.t. it can be inspected or rebuilt by hand
+static int el_build_native(char const * output_path, int output, struct el_ast * ast, struct el_symbol_table const * symbols, struct el_type_table const * types)
+{
+	struct el_string_builder c_path;
+	if(!el_string_builder_new(&c_path, 0) || !el_string_builder_appendf(&c_path, "%s.c", output_path))
+	{
+		fprintf(stderr, "Failed to allocate path\n");
+		el_string_builder_delete(&c_path);
+		return el_ALLOCATION_ERROR;
+	}
+
+	int err = el_write_c(c_path.chars, ast, symbols, types, output == el_NATIVE_EXECUTABLE ? el_C_EMIT_MAIN : el_C_EMIT_DEFAULT);
+	err = err || el_compile_c(c_path.chars, output_path, output);
+	if(err == el_SUCCESS)
+	{
+		printf("Built %s\n", output_path);
+	}
+	el_string_builder_delete(&c_path);
+	return err;
 }
@@ -0,0 +1,38 @@
+# Build an aether source file natively: aether-c emits it as C, which is compiled by the project's own C toolchain
+# Functions keep their names prefixed with ae_, a library's users call el_init before any of them
+
+macro(el_add_aether_executable t source)
+	get_filename_component(el_aether_source "${source}" ABSOLUTE)
+	add_custom_command(
+		OUTPUT "${CMAKE_CURRENT_BINARY_DIR}/${t}.c"
+		COMMAND aether-c --emit-c "${CMAKE_CURRENT_BINARY_DIR}/${t}.c" --c-main "${el_aether_source}"
+		DEPENDS aether-c "${el_aether_source}"
+		COMMENT "Emitting C for ${source}")
+	add_executable(${t} "${CMAKE_CURRENT_BINARY_DIR}/${t}.c")
+	set_property(TARGET ${t} PROPERTY C_STANDARD 17)
+	if(NOT MSVC)
+		target_link_libraries(${t} PRIVATE m)
+	endif()
+	find_package(OpenMP QUIET COMPONENTS C)
+	if(OpenMP_C_FOUND)
+		target_link_libraries(${t} PRIVATE OpenMP::OpenMP_C)
+	endif()
+endmacro()
+
+macro(el_add_aether_library t source)
+	get_filename_component(el_aether_source "${source}" ABSOLUTE)
+	add_custom_command(
+		OUTPUT "${CMAKE_CURRENT_BINARY_DIR}/${t}.c"
+		COMMAND aether-c --emit-c "${CMAKE_CURRENT_BINARY_DIR}/${t}.c" "${el_aether_source}"
+		DEPENDS aether-c "${el_aether_source}"
+		COMMENT "Emitting C for ${source}")
+	add_library(${t} "${CMAKE_CURRENT_BINARY_DIR}/${t}.c")
+	set_property(TARGET ${t} PROPERTY C_STANDARD 17)
+	if(NOT MSVC)
+		target_link_libraries(${t} PRIVATE m)
+	endif()
+	find_package(OpenMP QUIET COMPONENTS C)
+	if(OpenMP_C_FOUND)
+		target_link_libraries(${t} PRIVATE OpenMP::OpenMP_C)
+	endif()
+endmacro()
@@ -13,3 +13,15 @@ endmacro()
 macro(el_build_lib_file_system)
 	add_subdirectory("${PROJECT_SOURCE_DIR}/libs/file-system" "${PROJECT_BINARY_DIR}/libs/file-system")
 endmacro()
+
+macro(el_build_lib_jit)
+	add_subdirectory("${PROJECT_SOURCE_DIR}/libs/jit" "${PROJECT_BINARY_DIR}/libs/jit")
+endmacro()
+
+macro(el_build_lib_threads)
+	add_subdirectory("${PROJECT_SOURCE_DIR}/libs/threads" "${PROJECT_BINARY_DIR}/libs/threads")
+endmacro()
+
+macro(el_build_lib_vm)
+	add_subdirectory("${PROJECT_SOURCE_DIR}/libs/vm" "${PROJECT_BINARY_DIR}/libs/vm")
+endmacro()
@@ -13,3 +13,15 @@ endmacro()
 macro(el_link_lib_file_system t)
 	target_link_libraries(${t} PRIVATE el_lib_file_system)
 endmacro()
+
+macro(el_link_lib_jit t)
+	target_link_libraries(${t} PRIVATE el_lib_jit)
+endmacro()
+
+macro(el_link_lib_threads t)
+	target_link_libraries(${t} PRIVATE el_lib_threads)
+endmacro()
+
+macro(el_link_lib_vm t)
+	target_link_libraries(${t} PRIVATE el_lib_vm)
+endmacro()
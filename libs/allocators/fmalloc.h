@@ -6,6 +6,11 @@ static inline void * fmalloc(size_t size)
 	return malloc(size);
 }
 
+static inline void * frealloc(void * ptr, size_t size)
+{
+	return realloc(ptr, size);
+}
+
 static inline void ffree(void * ptr)
 {
 	free(ptr);
@@ -1,6 +1,35 @@
 #include "linear-allocator.h"
+#include "fmalloc.h"
+#include <stdalign.h>
 #include <string.h>
 
+struct el_linear_block
+{
+	struct el_linear_block * previous;
+	alignas(max_align_t) unsigned char memory[];
+};
+
+static bool el_linear_allocator_push_block(struct el_linear_allocator * allocator, size_t capacity);
+static void el_linear_allocator_free_previous_blocks(struct el_linear_allocator * allocator);
+
+bool el_linear_allocator_new(struct el_linear_allocator * allocator, size_t block_size)
+{
+	*allocator = (struct el_linear_allocator){ .block_size = block_size };
+	return block_size > 0 && el_linear_allocator_push_block(allocator, block_size);
+}
+
+void el_linear_allocator_delete(struct el_linear_allocator * allocator)
+{
+	if(!allocator)
+	{
+		return;
+	}
+
+	el_linear_allocator_free_previous_blocks(allocator);
+	ffree(allocator->block);
+	*allocator = (struct el_linear_allocator){ 0 };
+}
+
 void * el_linear_alloc(struct el_linear_allocator * allocator, size_t num_bytes)
 {
 	if(!allocator || !allocator->memory)
@@ -8,10 +37,14 @@ void * el_linear_alloc(struct el_linear_allocator * allocator, size_t num_bytes)
 		return NULL;
 	}
 
-	int remaining_capacity = allocator->capacity - allocator->size;
-	if(remaining_capacity < num_bytes)
+	if(allocator->capacity - allocator->size < num_bytes)
 	{
-		return NULL;
+		// The rest of a full block is left unused rather than tracked
+		size_t capacity = num_bytes > allocator->block_size ? num_bytes : allocator->block_size;
+		if(allocator->block_size == 0 || !el_linear_allocator_push_block(allocator, capacity))
+		{
+			return NULL;
+		}
 	}
 
 	unsigned char * ptr = allocator->memory + allocator->size;
@@ -26,6 +59,9 @@ void el_linear_allocator_reset(struct el_linear_allocator * allocator, bool zero
 		return;
 	}
 
+	// Only the most recent block is kept
+	el_linear_allocator_free_previous_blocks(allocator);
+
 	if(zero_memory)
 	{
 		memset(allocator->memory, 0, allocator->size);
@@ -33,3 +69,36 @@ void el_linear_allocator_reset(struct el_linear_allocator * allocator, bool zero
 
 	allocator->size = 0;
 }
+
+static bool el_linear_allocator_push_block(struct el_linear_allocator * allocator, size_t capacity)
+{
+	struct el_linear_block * block = fmalloc(sizeof(struct el_linear_block) + capacity);
+	if(!block)
+	{
+		return false;
+	}
+
+	block->previous = allocator->block;
+	allocator->block = block;
+	allocator->memory = block->memory;
+	allocator->capacity = capacity;
+	allocator->size = 0;
+	return true;
+}
+
+static void el_linear_allocator_free_previous_blocks(struct el_linear_allocator * allocator)
+{
+	if(!allocator->block)
+	{
+		return;
+	}
+
+	struct el_linear_block * block = allocator->block->previous;
+	while(block)
+	{
+		struct el_linear_block * previous = block->previous;
+		ffree(block);
+		block = previous;
+	}
+	allocator->block->previous = NULL;
+}
@@ -1,14 +1,28 @@
 #pragma once
 #include <stdbool.h>
+#include <stddef.h>
 #include <uchar.h>
 
+struct el_linear_block;
+
+// Allocations are taken from the end of memory and only released all at once
+// A fixed allocator hands out memory its owner allocated, a growable allocator chains on a new block when
+// the current one is full, s.t. earlier allocations never move
 struct el_linear_allocator
 {
-	unsigned char * memory;
+	unsigned char * memory; // Current block
 	size_t capacity;
 	size_t size;
+	struct el_linear_block * block; // Only set if growable
+	size_t block_size; // Minimum capacity of chained blocks, 0 if fixed
 };
 
+// Create a growable allocator whose first block holds block_size bytes, returns false if it could not be allocated
+bool el_linear_allocator_new(struct el_linear_allocator * allocator, size_t block_size);
+
+// Free every block of a growable allocator
+void el_linear_allocator_delete(struct el_linear_allocator * allocator);
+
 void * el_linear_alloc(struct el_linear_allocator * allocator, size_t num_bytes);
 
 void el_linear_allocator_reset(struct el_linear_allocator * allocator, bool zero_memory);
@@ -0,0 +1,1438 @@
+#include "c-emitter.h"
+#include <compiler/error.h>
+#include <compiler/semantic-analysis/data-layout.h>
+#include <compiler/semantic-analysis/symbol-table.h>
+#include <compiler/semantic-analysis/type-table.h>
+#include <compiler/semantic-analysis/vector-loops.h>
+#include <containers/string-builder.h>
+#include <containers/vector.h>
+#include <file-system/buffered-writer.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <assert.h>
+
+enum el_c_item_kind
+{
+	el_C_ITEM_TEXT,
+	el_C_ITEM_EXPRESSION,
+	el_C_ITEM_ZERO
+};
+
+// Part of an expression still to be written, see el_emit_expression
+struct el_c_item
+{
+	int kind;
+	union
+	{
+		char const * text;
+		struct el_ast_expression * expression;
+		int type;
+	};
+};
+
+// Value variable of a for statement over a soa slice, which names the element of the range at the index rather than a copy of it
+struct el_c_view
+{
+	int symbol;
+	int range;
+	struct el_ast_for_statement const * for_statement;
+};
+
+struct el_c_emitter
+{
+	struct el_ast * ast;
+	struct el_symbol_table const * symbols;
+	struct el_type_table const * types;
+	struct el_string_builder sb;
+	el_VECTOR_MEMBERS(struct el_c_item, items);
+	el_VECTOR_MEMBERS(struct el_c_view, views); // Of the for statements being written
+	int num_ranges; // Number of for statements written, s.t. each copy of a range has its own name
+	int depth;
+	int err;
+};
+
+// Helpers every translation unit starts with
+// Int arithmetic goes through unsigned s.t. it wraps as it does in the vm
+// Vector loops run EL_LANES elements at a time on the compiler's vector extensions, of 16 bytes which every x86-64 and arm64 cpu has
+// Vector types are vectors of the same extensions, whose arithmetic the compiler lowers to sse or avx, otherwise structs of their lanes
+// They only cross calls within the translation unit, so the warnings that wide vectors change the abi are ignored
+static char const el_c_prelude[] =
+	"#include <stdio.h>\n"
+	"#include <stdlib.h>\n"
+	"#include <string.h>\n"
+	"#include <math.h>\n"
+	"\n"
+	"typedef struct { char const * chars; long long length; } el_str;\n"
+	"\n"
+	"static inline void el_runtime_error(char const * message)\n"
+	"{\n"
+	"\tfprintf(stderr, \"Runtime error: %s\\n\", message);\n"
+	"\texit(1);\n"
+	"}\n"
+	"\n"
+	"static inline void * el_alloc(size_t size)\n"
+	"{\n"
+	"\tvoid * memory = calloc(1, size > 0 ? size : 1);\n"
+	"\tif(!memory)\n"
+	"\t\tel_runtime_error(\"out of memory\");\n"
+	"\treturn memory;\n"
+	"}\n"
+	"\n"
+	"static inline long long el_add_int(long long a, long long b) { return (long long)((unsigned long long)a + (unsigned long long)b); }\n"
+	"static inline long long el_sub_int(long long a, long long b) { return (long long)((unsigned long long)a - (unsigned long long)b); }\n"
+	"static inline long long el_mul_int(long long a, long long b) { return (long long)((unsigned long long)a * (unsigned long long)b); }\n"
+	"\n"
+	"static inline long long el_div_int(long long a, long long b)\n"
+	"{\n"
+	"\tif(b == 0)\n"
+	"\t\tel_runtime_error(\"division by zero\");\n"
+	"\treturn b == -1 ? el_sub_int(0, a) : a / b;\n"
+	"}\n"
+	"\n"
+	"static inline long long el_str_equals(el_str a, el_str b)\n"
+	"{\n"
+	"\treturn a.length == b.length && (a.length == 0 || memcmp(a.chars, b.chars, (size_t)a.length) == 0);\n"
+	"}\n"
+	"\n"
+	"#if defined(__GNUC__) || defined(__clang__)\n"
+	"#define EL_LANES 2\n"
+	"typedef long long el_ints __attribute__((vector_size(16)));\n"
+	"typedef unsigned long long el_uints __attribute__((vector_size(16)));\n"
+	"typedef double el_floats __attribute__((vector_size(16)));\n"
+	"\n"
+	"static inline el_ints el_splat_ints(long long x) { return (el_ints){ x, x }; }\n"
+	"static inline el_floats el_splat_floats(double x) { return (el_floats){ x, x }; }\n"
+	"static inline el_ints el_lane_ints(long long i) { return (el_ints){ i, i + 1 }; }\n"
+	"static inline el_ints el_load_ints(long long const * p) { el_ints v; memcpy(&v, p, sizeof v); return v; }\n"
+	"static inline el_floats el_load_floats(double const * p) { el_floats v; memcpy(&v, p, sizeof v); return v; }\n"
+	"static inline void el_store_ints(long long * p, el_ints v) { memcpy(p, &v, sizeof v); }\n"
+	"static inline void el_store_floats(double * p, el_floats v) { memcpy(p, &v, sizeof v); }\n"
+	"static inline el_ints el_add_ints(el_ints a, el_ints b) { return (el_ints)((el_uints)a + (el_uints)b); }\n"
+	"static inline el_ints el_sub_ints(el_ints a, el_ints b) { return (el_ints)((el_uints)a - (el_uints)b); }\n"
+	"static inline el_ints el_mul_ints(el_ints a, el_ints b) { return (el_ints)((el_uints)a * (el_uints)b); }\n"
+	"\n"
+	"#pragma GCC diagnostic ignored \"-Wpsabi\"\n"
+	"#define EL_LANE(v, i) ((v)[i])\n"
+	"#define EL_VECTOR_OF(name, ...) ((el_##name){ __VA_ARGS__ })\n"
+	"#define EL_INT_VECTOR(name, n) \\\n"
+	"\ttypedef long long el_##name __attribute__((vector_size(n * 8), aligned(8))); \\\n"
+	"\ttypedef unsigned long long el_##name##_bits __attribute__((vector_size(n * 8), aligned(8))); \\\n"
+	"\tstatic inline el_##name el_splat_##name(long long x) { return (el_##name){ 0 } + x; } \\\n"
+	"\tstatic inline el_##name el_add_##name(el_##name a, el_##name b) { return (el_##name)((el_##name##_bits)a + (el_##name##_bits)b); } \\\n"
+	"\tstatic inline el_##name el_sub_##name(el_##name a, el_##name b) { return (el_##name)((el_##name##_bits)a - (el_##name##_bits)b); } \\\n"
+	"\tstatic inline el_##name el_mul_##name(el_##name a, el_##name b) { return (el_##name)((el_##name##_bits)a * (el_##name##_bits)b); }\n"
+	"#define EL_FLOAT_VECTOR(name, n) \\\n"
+	"\ttypedef double el_##name __attribute__((vector_size(n * 8), aligned(8))); \\\n"
+	"\tstatic inline el_##name el_splat_##name(double x) { return (el_##name){ 0 } + x; } \\\n"
+	"\tstatic inline el_##name el_add_##name(el_##name a, el_##name b) { return a + b; } \\\n"
+	"\tstatic inline el_##name el_sub_##name(el_##name a, el_##name b) { return a - b; } \\\n"
+	"\tstatic inline el_##name el_mul_##name(el_##name a, el_##name b) { return a * b; } \\\n"
+	"\tstatic inline el_##name el_div_##name(el_##name a, el_##name b) { return a / b; }\n"
+	"#else\n"
+	"#define EL_LANES 0\n"
+	"\n"
+	"#define EL_LANE(v, i) ((v).lanes[i])\n"
+	"#define EL_VECTOR_OF(name, ...) ((el_##name){ { __VA_ARGS__ } })\n"
+	"#define EL_LANE_OP(name, op, expression) \\\n"
+	"\tstatic inline el_##name el_##op##_##name(el_##name a, el_##name b) \\\n"
+	"\t{ for(size_t i = 0; i < sizeof a.lanes / sizeof a.lanes[0]; ++i) a.lanes[i] = expression; return a; }\n"
+	"#define EL_SPLAT(name, lane) \\\n"
+	"\tstatic inline el_##name el_splat_##name(lane x) \\\n"
+	"\t{ el_##name v; for(size_t i = 0; i < sizeof v.lanes / sizeof v.lanes[0]; ++i) v.lanes[i] = x; return v; }\n"
+	"#define EL_INT_VECTOR(name, n) \\\n"
+	"\ttypedef struct { long long lanes[n]; } el_##name; \\\n"
+	"\tEL_SPLAT(name, long long) \\\n"
+	"\tEL_LANE_OP(name, add, el_add_int(a.lanes[i], b.lanes[i])) \\\n"
+	"\tEL_LANE_OP(name, sub, el_sub_int(a.lanes[i], b.lanes[i])) \\\n"
+	"\tEL_LANE_OP(name, mul, el_mul_int(a.lanes[i], b.lanes[i]))\n"
+	"#define EL_FLOAT_VECTOR(name, n) \\\n"
+	"\ttypedef struct { double lanes[n]; } el_##name; \\\n"
+	"\tEL_SPLAT(name, double) \\\n"
+	"\tEL_LANE_OP(name, add, a.lanes[i] + b.lanes[i]) \\\n"
+	"\tEL_LANE_OP(name, sub, a.lanes[i] - b.lanes[i]) \\\n"
+	"\tEL_LANE_OP(name, mul, a.lanes[i] * b.lanes[i]) \\\n"
+	"\tEL_LANE_OP(name, div, a.lanes[i] / b.lanes[i])\n"
+	"#endif\n"
+	"\n"
+	"EL_INT_VECTOR(int2, 2)\n"
+	"EL_INT_VECTOR(int4, 4)\n"
+	"EL_INT_VECTOR(int8, 8)\n"
+	"EL_FLOAT_VECTOR(float2, 2)\n"
+	"EL_FLOAT_VECTOR(float4, 4)\n"
+	"EL_FLOAT_VECTOR(float8, 8)\n";
+
+static int el_emit_types(struct el_c_emitter * c);
+static void el_emit_slice_type(struct el_c_emitter * c, int type);
+static void el_emit_soa_slice_type(struct el_c_emitter * c, int type);
+static void el_emit_soa_helpers(struct el_c_emitter * c, int type);
+static void el_emit_data_block(struct el_c_emitter * c, struct el_ast_data_block const * data_block);
+static void el_emit_function_signature(struct el_c_emitter * c, struct el_ast_function_definition const * function);
+static int el_emit_function(struct el_c_emitter * c, struct el_ast_function_definition * function);
+static void el_emit_main(struct el_c_emitter * c);
+static void el_emit_statements(struct el_c_emitter * c, struct el_ast_statement_list * list);
+static void el_emit_statement(struct el_c_emitter * c, struct el_ast_statement * statement);
+static void el_emit_assignment(struct el_c_emitter * c, struct el_ast_assignment * assignment);
+static void el_emit_if_statement(struct el_c_emitter * c, struct el_ast_if_statement * if_statement);
+static void el_emit_for_statement(struct el_c_emitter * c, struct el_ast_for_statement * for_statement);
+static void el_emit_loop_body(struct el_c_emitter * c, struct el_ast_for_statement * for_statement, int range);
+static void el_emit_parallel_for(struct el_c_emitter * c, struct el_ast_for_statement * for_statement, int range);
+static void el_emit_vector_loop(struct el_c_emitter * c, struct el_vector_loop const * loop, int range);
+static void el_emit_vector_expression(struct el_c_emitter * c, struct el_vector_loop const * loop, struct el_ast_expression const * e);
+static char const * el_lanes_name(struct el_c_emitter const * c, int type);
+static void el_emit_block(struct el_c_emitter * c, struct el_ast_statement_list * list);
+static void el_emit_expression(struct el_c_emitter * c, struct el_ast_expression * expression);
+static void el_expand_expression(struct el_c_emitter * c, struct el_ast_expression * e);
+static void el_expand_call(struct el_c_emitter * c, struct el_ast_expression * e);
+static void el_push_text(struct el_c_emitter * c, char const * text);
+static void el_push_expression(struct el_c_emitter * c, struct el_ast_expression * expression);
+static void el_push_zero(struct el_c_emitter * c, int type);
+
+static void el_append_c_type(struct el_c_emitter * c, int type);
+static void el_append_zero(struct el_c_emitter * c, int type);
+static void el_append_vector_name(struct el_c_emitter * c, int type);
+static void el_append_number(struct el_c_emitter * c, struct el_ast_expression const * e);
+static void el_append_string(struct el_c_emitter * c, el_string s);
+static void el_append_indent(struct el_c_emitter * c);
+static struct el_ast_data_block const * el_type_data_block(struct el_c_emitter const * c, int type);
+static struct el_c_view const * el_find_view(struct el_c_emitter const * c, int symbol);
+static bool el_is_global(struct el_c_emitter const * c, int symbol);
+static void el_flush(struct el_c_emitter * c, struct el_buffered_writer * writer);
+
+int el_emit_c(struct el_ast * ast, struct el_symbol_table const * symbols, struct el_type_table const * types, struct el_buffered_writer * writer, int flags)
+{
+	assert(ast && symbols && types && writer);
+	struct el_c_emitter c = { .ast = ast, .symbols = symbols, .types = types, .err = el_SUCCESS };
+	if(!el_string_builder_new(&c.sb, 0))
+		return el_ALLOCATION_ERROR;
+
+	el_string_builder_append(&c.sb, el_c_prelude, (int)sizeof el_c_prelude - 1);
+	int err = el_emit_types(&c);
+	el_flush(&c, writer);
+
+	// Globals are zeroed and given their values by el_init
+	bool has_globals = false;
+	for(int i = 0; i < symbols->num_symbols && err == 0; ++i)
+	{
+		if(!el_is_global(&c, i))
+			continue;
+
+		el_string_builder_append_cstr(&c.sb, has_globals ? "static " : "\nstatic ");
+		has_globals = true;
+		el_append_c_type(&c, symbols->symbols[i].type_id);
+		el_string_builder_append_cstr(&c.sb, " ae_");
+		el_string_builder_append_view(&c.sb, el_symbol_name(symbols, i));
+		el_string_builder_append_cstr(&c.sb, ";\n");
+	}
+
+	// Prototypes let functions call each other in any order
+	struct el_ast_statement_list * root = &ast->root;
+	el_string_builder_append_char(&c.sb, '\n');
+	for(int i = 0; i < root->num_statements && err == 0; ++i)
+	{
+		if(root->statements[i].type == el_AST_NODE_FUNCTION_DEFINITION)
+		{
+			el_emit_function_signature(&c, &root->statements[i].function_definition);
+			el_string_builder_append_cstr(&c.sb, ";\n");
+		}
+	}
+	el_string_builder_append_cstr(&c.sb, "void el_init(void);\n");
+	el_flush(&c, writer);
+
+	// Each function is built then written whole, s.t. the builder stays small
+	for(int i = 0; i < root->num_statements && err == 0; ++i)
+	{
+		if(root->statements[i].type == el_AST_NODE_FUNCTION_DEFINITION)
+		{
+			err = el_emit_function(&c, &root->statements[i].function_definition);
+			el_flush(&c, writer);
+		}
+	}
+
+	if(err == 0)
+	{
+		err = el_emit_function(&c, NULL);
+	}
+	if(err == 0 && (flags & el_C_EMIT_MAIN))
+	{
+		el_emit_main(&c);
+	}
+	el_flush(&c, writer);
+
+	el_string_builder_delete(&c.sb);
+	el_vector_free(&c, items, NULL);
+	el_vector_free(&c, views, NULL);
+	if(err == el_ALLOCATION_ERROR)
+	{
+		fprintf(stderr, "Failed to allocate c source\n");
+	}
+	if(!el_buffered_writer_flush(writer))
+	{
+		fprintf(stderr, "Failed to write c source\n");
+		return err ? err : el_IO_ERROR;
+	}
+	return err;
+}
+
+// Every data block and slice is declared first, as data blocks and slices may hold each other
+// Slices are then defined in id order, which puts each after its element type, and data blocks after every slice
+// Columns of a soa slice only point to their fields, s.t. its helpers which read the fields follow the data blocks
+static int el_emit_types(struct el_c_emitter * c)
+{
+	struct el_type_table const * types = c->types;
+	el_string_builder_append_char(&c->sb, '\n');
+	for(int i = 0; i < types->num_types; ++i)
+	{
+		struct el_type const * type = el_get_type(types, i);
+		struct el_ast_data_block const * data_block = el_type_data_block(c, i);
+		if(data_block)
+		{
+			el_string_builder_appendf(&c->sb, "typedef struct ae_%s ae_%s;\n", data_block->name, data_block->name);
+		}
+		else if(type->kind == el_TYPE_SLICE && type->base_type != el_VOID_TYPE_ID)
+		{
+			el_string_builder_appendf(&c->sb, "typedef struct el_slice_%d el_slice_%d;\n", i, i);
+		}
+	}
+
+	for(int i = 0; i < types->num_types; ++i)
+	{
+		struct el_type const * type = el_get_type(types, i);
+		if(el_is_soa_slice(types, i))
+		{
+			el_emit_soa_slice_type(c, i);
+		}
+		else if(type->kind == el_TYPE_SLICE && type->base_type != el_VOID_TYPE_ID)
+		{
+			el_emit_slice_type(c, i);
+		}
+	}
+
+	for(int i = 0; i < types->num_types; ++i)
+	{
+		struct el_ast_data_block const * data_block = el_type_data_block(c, i);
+		if(data_block)
+		{
+			el_emit_data_block(c, data_block);
+		}
+	}
+
+	for(int i = 0; i < types->num_types; ++i)
+	{
+		if(el_is_soa_slice(types, i))
+		{
+			el_emit_soa_helpers(c, i);
+		}
+	}
+	return c->err;
+}
+
+// A slice is passed by value, its elements are shared by every copy
+static void el_emit_slice_type(struct el_c_emitter * c, int type)
+{
+	struct el_string_builder * sb = &c->sb;
+	int element_type = el_get_type(c->types, type)->element_type;
+	el_string_builder_appendf(sb, "\nstruct el_slice_%d { ", type);
+	el_append_c_type(c, element_type);
+	el_string_builder_append_cstr(sb, " * elements; long long length; };\n\n");
+
+	el_string_builder_appendf(sb, "static inline el_slice_%d el_new_slice_%d(long long length, ", type, type);
+	el_append_c_type(c, element_type);
+	el_string_builder_append_cstr(sb, " const * elements)\n{\n");
+	el_string_builder_appendf(sb, "\tel_slice_%d s = { el_alloc(sizeof *s.elements * (size_t)length), length };\n", type);
+	el_string_builder_append_cstr(sb, "\tmemcpy(s.elements, elements, sizeof *s.elements * (size_t)length);\n\treturn s;\n}\n\n");
+
+	el_string_builder_append_cstr(sb, "static inline ");
+	el_append_c_type(c, element_type);
+	el_string_builder_appendf(sb, " * el_at_%d(el_slice_%d s, long long i)\n{\n", type, type);
+	el_string_builder_append_cstr(sb, "#ifndef EL_UNCHECKED\n\tif(i < 0 || i >= s.length)\n\t\tel_runtime_error(\"index out of range\");\n#endif\n");
+	el_string_builder_append_cstr(sb, "\treturn &s.elements[i];\n}\n");
+}
+
+// A slice of a soa data block holds an array per field, its elements are copied in and out of data blocks
+// el_at_N checks an index, and el_at_N_F points to field F of an element
+static void el_emit_soa_slice_type(struct el_c_emitter * c, int type)
+{
+	struct el_string_builder * sb = &c->sb;
+	struct el_ast_data_block const * data_block = el_type_data_block(c, el_get_type(c->types, type)->element_type);
+	el_string_builder_appendf(sb, "\nstruct el_slice_%d\n{\n\tlong long length;\n", type);
+	for(int i = 0; i < data_block->num_var_declarations; ++i)
+	{
+		el_string_builder_append_char(sb, '\t');
+		el_append_c_type(c, data_block->var_declarations[i].type.type_id);
+		el_string_builder_appendf(sb, " * ae_%s;\n", data_block->var_declarations[i].name);
+	}
+	el_string_builder_append_cstr(sb, "};\n\n");
+
+	el_string_builder_appendf(sb, "static inline long long el_at_%d(el_slice_%d s, long long i)\n{\n", type, type);
+	el_string_builder_append_cstr(sb, "#ifndef EL_UNCHECKED\n\tif(i < 0 || i >= s.length)\n\t\tel_runtime_error(\"index out of range\");\n#endif\n");
+	el_string_builder_append_cstr(sb, "\treturn i;\n}\n");
+	for(int i = 0; i < data_block->num_var_declarations; ++i)
+	{
+		el_string_builder_append_cstr(sb, "\nstatic inline ");
+		el_append_c_type(c, data_block->var_declarations[i].type.type_id);
+		el_string_builder_appendf(sb, " * el_at_%d_%d(el_slice_%d s, long long i)\n{\n", type, i, type);
+		el_string_builder_appendf(sb, "\treturn &s.ae_%s[el_at_%d(s, i)];\n}\n", data_block->var_declarations[i].name, type);
+	}
+}
+
+// el_new_slice_N copies the fields of each element into the columns, el_get_N copies an element out and el_set_N copies one in
+static void el_emit_soa_helpers(struct el_c_emitter * c, int type)
+{
+	struct el_string_builder * sb = &c->sb;
+	struct el_ast_data_block const * data_block = el_type_data_block(c, el_get_type(c->types, type)->element_type);
+	char const * name = data_block->name;
+	int num_fields = data_block->num_var_declarations;
+	el_string_builder_appendf(sb, "\nstatic inline el_slice_%d el_new_slice_%d(long long length, ae_%s * const * elements)\n{\n", type, type, name);
+	el_string_builder_appendf(sb, "\tel_slice_%d s = { length };\n", type);
+	for(int i = 0; i < num_fields; ++i)
+	{
+		char const * field = data_block->var_declarations[i].name;
+		el_string_builder_appendf(sb, "\ts.ae_%s = el_alloc(sizeof *s.ae_%s * (size_t)length);\n", field, field);
+	}
+	el_string_builder_append_cstr(sb, "\tfor(long long i = 0; i < length; ++i)\n\t{\n");
+	el_string_builder_appendf(sb, "\t\tae_%s * p = el_check_dat_%s(elements[i]);\n", name, name);
+	for(int i = 0; i < num_fields; ++i)
+	{
+		char const * field = data_block->var_declarations[i].name;
+		el_string_builder_appendf(sb, "\t\ts.ae_%s[i] = p->ae_%s;\n", field, field);
+	}
+	el_string_builder_append_cstr(sb, "\t}\n\treturn s;\n}\n\n");
+
+	el_string_builder_appendf(sb, "static inline ae_%s * el_get_%d(el_slice_%d s, long long i)\n{\n", name, type, type);
+	el_string_builder_appendf(sb, "\ti = el_at_%d(s, i);\n\treturn el_new_dat_%s(", type, name);
+	for(int i = 0; i < num_fields; ++i)
+	{
+		el_string_builder_appendf(sb, i > 0 ? ", s.ae_%s[i]" : "s.ae_%s[i]", data_block->var_declarations[i].name);
+	}
+	el_string_builder_append_cstr(sb, ");\n}\n\n");
+
+	el_string_builder_appendf(sb, "static inline void el_set_%d(el_slice_%d s, long long i, ae_%s * p)\n{\n", type, type, name);
+	el_string_builder_appendf(sb, "\tp = el_check_dat_%s(p);\n\ti = el_at_%d(s, i);\n", name, type);
+	for(int i = 0; i < num_fields; ++i)
+	{
+		char const * field = data_block->var_declarations[i].name;
+		el_string_builder_appendf(sb, "\ts.ae_%s[i] = p->ae_%s;\n", field, field);
+	}
+	el_string_builder_append_cstr(sb, "}\n");
+}
+
+// A data block is referenced by pointer, s.t. assigning one shares it as in the vm
+static void el_emit_data_block(struct el_c_emitter * c, struct el_ast_data_block const * data_block)
+{
+	struct el_string_builder * sb = &c->sb;
+	el_string_builder_appendf(sb, "\nstruct ae_%s\n{\n", data_block->name);
+	for(int i = 0; i < data_block->num_var_declarations; ++i)
+	{
+		el_string_builder_append_char(sb, '\t');
+		el_append_c_type(c, data_block->var_declarations[i].type.type_id);
+		el_string_builder_appendf(sb, " ae_%s;\n", data_block->var_declarations[i].name);
+	}
+	if(data_block->num_var_declarations == 0)
+	{
+		el_string_builder_append_cstr(sb, "\tchar el_unused;\n");
+	}
+	el_string_builder_append_cstr(sb, "};\n\n");
+
+	el_string_builder_appendf(sb, "static inline ae_%s * el_new_dat_%s(", data_block->name, data_block->name);
+	for(int i = 0; i < data_block->num_var_declarations; ++i)
+	{
+		el_string_builder_append_cstr(sb, i > 0 ? ", " : "");
+		el_append_c_type(c, data_block->var_declarations[i].type.type_id);
+		el_string_builder_appendf(sb, " ae_%s", data_block->var_declarations[i].name);
+	}
+	el_string_builder_appendf(sb, "%s)\n{\n\tae_%s * p = el_alloc(sizeof *p);\n", data_block->num_var_declarations == 0 ? "void" : "", data_block->name);
+	for(int i = 0; i < data_block->num_var_declarations; ++i)
+	{
+		el_string_builder_appendf(sb, "\tp->ae_%s = ae_%s;\n", data_block->var_declarations[i].name, data_block->var_declarations[i].name);
+	}
+	el_string_builder_append_cstr(sb, "\treturn p;\n}\n\n");
+
+	el_string_builder_appendf(sb, "static inline ae_%s * el_check_dat_%s(ae_%s * p)\n{\n", data_block->name, data_block->name, data_block->name);
+	el_string_builder_append_cstr(sb, "#ifndef EL_UNCHECKED\n\tif(!p)\n\t\tel_runtime_error(\"field of a zero data block\");\n#endif\n");
+	el_string_builder_append_cstr(sb, "\treturn p;\n}\n");
+}
+
+static void el_emit_function_signature(struct el_c_emitter * c, struct el_ast_function_definition const * function)
+{
+	struct el_ast_parameter_list const * parameters = &function->parameter_list;
+	el_append_c_type(c, function->return_type.type_id);
+	el_string_builder_appendf(&c->sb, " ae_%s(", function->name);
+	for(int i = 0; i < parameters->num_parameters; ++i)
+	{
+		el_string_builder_append_cstr(&c->sb, i > 0 ? ", " : "");
+		el_append_c_type(c, parameters->parameters[i].type.type_id);
+		el_string_builder_appendf(&c->sb, " ae_%s", parameters->parameters[i].name);
+	}
+	el_string_builder_append_cstr(&c->sb, parameters->num_parameters == 0 ? "void)" : ")");
+}
+
+// Write the function, or el_init for the file scope statements if function is NULL
+static int el_emit_function(struct el_c_emitter * c, struct el_ast_function_definition * function)
+{
+	if(function && !function->is_code_block_parsed)
+	{
+		fprintf(stderr, "Cannot emit %s, its body was not parsed\n", function->name);
+		return el_UNPARSED_FUNCTION_BODY_ERROR;
+	}
+
+	el_string_builder_append_char(&c->sb, '\n');
+	if(function)
+	{
+		el_emit_function_signature(c, function);
+	}
+	else
+	{
+		el_string_builder_append_cstr(&c->sb, "void el_init(void)");
+	}
+	el_string_builder_append_cstr(&c->sb, "\n{\n");
+
+	struct el_ast_statement_list * body = function ? &function->code_block : &c->ast->root;
+	c->depth = 1;
+	el_emit_statements(c, body);
+
+	// Falling off the end of a function returns the zero value of its return type
+	int return_type = function ? function->return_type.type_id : el_VOID_TYPE_ID;
+	bool is_returned = body->num_statements > 0 && body->statements[body->num_statements - 1].type == el_AST_NODE_RETURN_STATEMENT;
+	if(return_type != el_VOID_TYPE_ID && !is_returned)
+	{
+		el_string_builder_append_cstr(&c->sb, "\treturn ");
+		el_append_zero(c, return_type);
+		el_string_builder_append_cstr(&c->sb, ";\n");
+	}
+	el_string_builder_append_cstr(&c->sb, "}\n");
+	return c->err;
+}
+
+// Run the file scope statements, then main if it takes no arguments, printing its result as aether-c --run does
+static void el_emit_main(struct el_c_emitter * c)
+{
+	struct el_ast_function_definition const * main_function = NULL;
+	struct el_ast_statement_list const * root = &c->ast->root;
+	for(int i = 0; i < root->num_statements; ++i)
+	{
+		struct el_ast_statement const * statement = &root->statements[i];
+		if(statement->type == el_AST_NODE_FUNCTION_DEFINITION && strcmp(statement->function_definition.name, "main") == 0)
+		{
+			main_function = &statement->function_definition;
+		}
+	}
+
+	el_string_builder_append_cstr(&c->sb, "\nint main(void)\n{\n\tel_init();\n");
+	if(main_function && main_function->parameter_list.num_parameters == 0)
+	{
+		int return_type = main_function->return_type.type_id;
+		if(return_type == el_INT_TYPE_ID)
+		{
+			el_string_builder_append_cstr(&c->sb, "\tprintf(\"main returned %lld\\n\", ae_main());\n");
+		}
+		else if(return_type == el_FLOAT_TYPE_ID)
+		{
+			el_string_builder_append_cstr(&c->sb, "\tprintf(\"main returned %.17g\\n\", ae_main());\n");
+		}
+		else
+		{
+			el_string_builder_append_cstr(&c->sb, "\tae_main();\n");
+		}
+	}
+	el_string_builder_append_cstr(&c->sb, "\treturn 0;\n}\n");
+}
+
+static void el_emit_statements(struct el_c_emitter * c, struct el_ast_statement_list * list)
+{
+	for(int i = 0; i < list->num_statements && c->err == 0; ++i)
+	{
+		el_emit_statement(c, &list->statements[i]);
+	}
+}
+
+static void el_emit_statement(struct el_c_emitter * c, struct el_ast_statement * statement)
+{
+	switch(statement->type)
+	{
+	case el_AST_NODE_DATA_BLOCK:
+	case el_AST_NODE_FUNCTION_DEFINITION:
+		break;
+	case el_AST_NODE_FOR_STATEMENT:
+		el_emit_for_statement(c, &statement->for_statement);
+		break;
+	case el_AST_NODE_IF_STATEMENT:
+		el_emit_if_statement(c, &statement->if_statement);
+		break;
+	case el_AST_NODE_ASSIGNMENT:
+		el_emit_assignment(c, &statement->assignment);
+		break;
+	case el_AST_NODE_RETURN_STATEMENT:
+		el_append_indent(c);
+		el_string_builder_append_cstr(&c->sb, "return ");
+		el_emit_expression(c, &statement->return_statement.expression);
+		el_string_builder_append_cstr(&c->sb, ";\n");
+		break;
+	case el_AST_NODE_EXPRESSION:
+	{
+		// Only calls are written bare, other values are discarded explicitly s.t. C compilers do not warn
+		struct el_ast_expression * e = &statement->expression;
+		bool is_call = e->type == el_AST_EXPR_FUNCTION_CALL && c->symbols->symbols[e->binary_op.lhs->symbol].kind == el_SYMBOL_FUNCTION;
+		el_append_indent(c);
+		el_string_builder_append_cstr(&c->sb, is_call ? "" : "(void)");
+		el_emit_expression(c, e);
+		el_string_builder_append_cstr(&c->sb, ";\n");
+		break;
+	}
+	}
+}
+
+// Each variable is declared by the assignment which declares it in the ast, except globals which are declared at file scope
+static void el_emit_assignment(struct el_c_emitter * c, struct el_ast_assignment * assignment)
+{
+	struct el_ast_expression * lhs = &assignment->lhs;
+	el_append_indent(c);
+	if(lhs->type == el_AST_EXPR_IDENTIFIER && !el_is_global(c, lhs->symbol))
+	{
+		struct el_symbol const * symbol = &c->symbols->symbols[lhs->symbol];
+		if(symbol->kind == el_SYMBOL_VARIABLE && symbol->variable == lhs)
+		{
+			el_append_c_type(c, symbol->type_id);
+			el_string_builder_append_char(&c->sb, ' ');
+		}
+	}
+	// An element of a soa slice is a copy, which is scattered into the columns
+	if(lhs->type == el_AST_EXPR_SLICE_INDEX && el_is_soa_slice(c->types, lhs->binary_op.lhs->type_id))
+	{
+		el_string_builder_appendf(&c->sb, "el_set_%d(", lhs->binary_op.lhs->type_id);
+		el_emit_expression(c, lhs->binary_op.lhs);
+		el_string_builder_append_cstr(&c->sb, ", ");
+		el_emit_expression(c, lhs->binary_op.rhs);
+		el_string_builder_append_cstr(&c->sb, ", ");
+		el_emit_expression(c, &assignment->rhs);
+		el_string_builder_append_cstr(&c->sb, ");\n");
+		return;
+	}
+	el_emit_expression(c, lhs);
+	el_string_builder_append_cstr(&c->sb, " = ");
+	el_emit_expression(c, &assignment->rhs);
+	el_string_builder_append_cstr(&c->sb, ";\n");
+}
+
+static void el_emit_if_statement(struct el_c_emitter * c, struct el_ast_if_statement * if_statement)
+{
+	el_append_indent(c);
+	el_string_builder_append_cstr(&c->sb, "if(");
+	el_emit_expression(c, &if_statement->expression);
+	el_string_builder_append_cstr(&c->sb, ")\n");
+	el_emit_block(c, &if_statement->code_block);
+	for(int i = 0; i < if_statement->num_elif_statements && c->err == 0; ++i)
+	{
+		el_append_indent(c);
+		el_string_builder_append_cstr(&c->sb, "else if(");
+		el_emit_expression(c, &if_statement->elif_statements[i].expression);
+		el_string_builder_append_cstr(&c->sb, ")\n");
+		el_emit_block(c, &if_statement->elif_statements[i].code_block);
+	}
+	if(if_statement->else_statement)
+	{
+		el_append_indent(c);
+		el_string_builder_append_cstr(&c->sb, "else\n");
+		el_emit_block(c, if_statement->else_statement);
+	}
+}
+
+// The range is copied once, s.t. assigning to its variable in the body does not change the slice being iterated
+static void el_emit_for_statement(struct el_c_emitter * c, struct el_ast_for_statement * for_statement)
+{
+	struct el_string_builder * sb = &c->sb;
+	int range_type = for_statement->range.type_id;
+	int range = c->num_ranges++;
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "{\n");
+	++c->depth;
+	el_append_indent(c);
+	el_string_builder_appendf(sb, "el_slice_%d el_range_%d = ", range_type, range);
+	el_emit_expression(c, &for_statement->range);
+	el_string_builder_append_cstr(sb, ";\n");
+
+	// A vector loop runs its leading elements in lanes, then the elements left over in the loop as it is written
+	struct el_vector_loop loop;
+	char const * index = for_statement->index_var_name;
+	if(for_statement->is_parallel)
+	{
+		el_emit_parallel_for(c, for_statement, range);
+	}
+	else if(el_analyze_vector_loop(&loop, for_statement, c->symbols, c->types))
+	{
+		el_append_indent(c);
+		el_string_builder_appendf(sb, "long long ae_%s = 0;\n", index);
+		el_emit_vector_loop(c, &loop, range);
+		el_append_indent(c);
+		el_string_builder_appendf(sb, "for(; ae_%s < el_range_%d.length; ++ae_%s)\n", index, range, index);
+		el_emit_loop_body(c, for_statement, range);
+	}
+	else
+	{
+		el_append_indent(c);
+		el_string_builder_appendf(sb, "for(long long ae_%s = 0; ae_%s < el_range_%d.length; ++ae_%s)\n", index, index, range, index);
+		el_emit_loop_body(c, for_statement, range);
+	}
+	--c->depth;
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "}\n");
+}
+
+static void el_emit_loop_body(struct el_c_emitter * c, struct el_ast_for_statement * for_statement, int range)
+{
+	struct el_string_builder * sb = &c->sb;
+	int range_type = for_statement->range.type_id;
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "{\n");
+	++c->depth;
+
+	// The value of a soa range is a view, whose fields are read and written in the columns
+	bool has_value = for_statement->value_symbol != for_statement->index_symbol;
+	struct el_c_view * view = NULL;
+	if(has_value && el_is_soa_slice(c->types, range_type))
+	{
+		view = el_vector_push(c, views, NULL);
+		if(!view)
+		{
+			c->err = el_ALLOCATION_ERROR;
+			return;
+		}
+		*view = (struct el_c_view){ for_statement->value_symbol, range, for_statement };
+	}
+	else if(has_value)
+	{
+		el_append_indent(c);
+		el_append_c_type(c, c->symbols->symbols[for_statement->value_symbol].type_id);
+		el_string_builder_appendf(sb, " ae_%s = *el_at_%d(el_range_%d, ae_%s);\n", for_statement->value_var_name, range_type, range, for_statement->index_var_name);
+	}
+	el_emit_statements(c, &for_statement->code_block);
+	c->num_views -= view ? 1 : 0;
+	--c->depth;
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "}\n");
+}
+
+// Chunks of the range run as the vm runs them, on OpenMP threads if the C compiler enables it and otherwise in serial
+// Each reduction is shadowed in a chunk by its own accumulator, sums from zero and minimums and maximums from the value before the loop
+// Chunks' results are combined in chunk order, s.t. float sums come out the same as in the vm
+static void el_emit_parallel_for(struct el_c_emitter * c, struct el_ast_for_statement * for_statement, int range)
+{
+	struct el_string_builder * sb = &c->sb;
+	char const * index = for_statement->index_var_name;
+	el_append_indent(c);
+	el_string_builder_appendf(sb, "long long el_chunks_%d = el_range_%d.length < 256 ? el_range_%d.length : 256;\n", range, range, range);
+	for(int i = 0; i < for_statement->num_reductions; ++i)
+	{
+		struct el_ast_reduction const * reduction = &for_statement->reductions[i];
+		int type = c->symbols->symbols[reduction->symbol].type_id;
+		el_append_indent(c);
+		el_append_c_type(c, type);
+		el_string_builder_appendf(sb, " el_partials_%d_%d[256];\n", range, i);
+		if(reduction->type != el_AST_REDUCE_SUM)
+		{
+			el_append_indent(c);
+			el_append_c_type(c, type);
+			el_string_builder_appendf(sb, " el_initial_%d_%d = ae_%s;\n", range, i, reduction->var_name);
+		}
+	}
+	el_string_builder_append_cstr(sb, "#ifdef _OPENMP\n");
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "#pragma omp parallel for schedule(dynamic)\n");
+	el_string_builder_append_cstr(sb, "#endif\n");
+	el_append_indent(c);
+	el_string_builder_appendf(sb, "for(long long el_chunk_%d = 0; el_chunk_%d < el_chunks_%d; ++el_chunk_%d)\n", range, range, range, range);
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "{\n");
+	++c->depth;
+	el_append_indent(c);
+	el_string_builder_appendf(sb, "unsigned long long el_length_%d = (unsigned long long)el_range_%d.length;\n", range, range);
+	el_append_indent(c);
+	el_string_builder_appendf(sb, "long long el_end_%d = (long long)(el_length_%d * (unsigned long long)(el_chunk_%d + 1) / (unsigned long long)el_chunks_%d);\n", range, range, range, range);
+	for(int i = 0; i < for_statement->num_reductions; ++i)
+	{
+		struct el_ast_reduction const * reduction = &for_statement->reductions[i];
+		int type = c->symbols->symbols[reduction->symbol].type_id;
+		el_append_indent(c);
+		el_append_c_type(c, type);
+		el_string_builder_appendf(sb, " ae_%s = ", reduction->var_name);
+		if(reduction->type == el_AST_REDUCE_SUM)
+		{
+			el_append_zero(c, type);
+		}
+		else
+		{
+			el_string_builder_appendf(sb, "el_initial_%d_%d", range, i);
+		}
+		el_string_builder_append_cstr(sb, ";\n");
+	}
+	el_append_indent(c);
+	el_string_builder_appendf(sb, "for(long long ae_%s = (long long)(el_length_%d * (unsigned long long)el_chunk_%d / (unsigned long long)el_chunks_%d); ae_%s < el_end_%d; ++ae_%s)\n",
+		index, range, range, range, index, range, index);
+	el_emit_loop_body(c, for_statement, range);
+	for(int i = 0; i < for_statement->num_reductions; ++i)
+	{
+		el_append_indent(c);
+		el_string_builder_appendf(sb, "el_partials_%d_%d[el_chunk_%d] = ae_%s;\n", range, i, range, for_statement->reductions[i].var_name);
+	}
+	--c->depth;
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "}\n");
+	if(for_statement->num_reductions == 0)
+		return;
+
+	el_append_indent(c);
+	el_string_builder_appendf(sb, "for(long long el_chunk_%d = 0; el_chunk_%d < el_chunks_%d; ++el_chunk_%d)\n", range, range, range, range);
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "{\n");
+	++c->depth;
+	for(int i = 0; i < for_statement->num_reductions; ++i)
+	{
+		struct el_ast_reduction const * reduction = &for_statement->reductions[i];
+		char const * name = reduction->var_name;
+		bool is_int = c->symbols->symbols[reduction->symbol].type_id == el_INT_TYPE_ID;
+		el_append_indent(c);
+		switch(reduction->type)
+		{
+		case el_AST_REDUCE_SUM:
+			if(is_int)
+			{
+				el_string_builder_appendf(sb, "ae_%s = el_add_int(ae_%s, el_partials_%d_%d[el_chunk_%d]);\n", name, name, range, i, range);
+			}
+			else
+			{
+				el_string_builder_appendf(sb, "ae_%s = ae_%s + el_partials_%d_%d[el_chunk_%d];\n", name, name, range, i, range);
+			}
+			break;
+		case el_AST_REDUCE_MIN:
+			el_string_builder_appendf(sb, "ae_%s = el_partials_%d_%d[el_chunk_%d] < ae_%s ? el_partials_%d_%d[el_chunk_%d] : ae_%s;\n", name, range, i, range, name, range, i, range, name);
+			break;
+		default:
+			el_string_builder_appendf(sb, "ae_%s = ae_%s < el_partials_%d_%d[el_chunk_%d] ? el_partials_%d_%d[el_chunk_%d] : ae_%s;\n", name, name, range, i, range, range, i, range, name);
+			break;
+		}
+	}
+	--c->depth;
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "}\n");
+}
+
+// Lanes are only run if every slice the body indexes is at least as long as the range, s.t. none of their indices is out of range
+// Otherwise the scalar loop runs every element and reports the first index out of range
+static void el_emit_vector_loop(struct el_c_emitter * c, struct el_vector_loop const * loop, int range)
+{
+	struct el_string_builder * sb = &c->sb;
+	struct el_ast_for_statement const * for_statement = loop->for_statement;
+	char const * index = for_statement->index_var_name;
+	el_string_builder_append_cstr(sb, "#if EL_LANES\n");
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "if(");
+	bool is_first = true;
+	for(int i = 0; i < loop->num_arguments; ++i)
+	{
+		struct el_symbol const * argument = &c->symbols->symbols[loop->arguments[i]];
+		if(!el_is_vector_slice(c->types, argument->type_id))
+			continue;
+
+		el_string_builder_appendf(sb, "%sel_range_%d.length <= ae_", is_first ? "" : " && ", range);
+		el_string_builder_append_view(sb, el_symbol_name(c->symbols, loop->arguments[i]));
+		el_string_builder_append_cstr(sb, ".length");
+		is_first = false;
+	}
+	el_string_builder_append_cstr(sb, is_first ? "1)\n" : ")\n");
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "{\n");
+	++c->depth;
+	el_append_indent(c);
+	el_string_builder_appendf(sb, "for(; ae_%s + EL_LANES <= el_range_%d.length; ae_%s += EL_LANES)\n", index, range, index);
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "{\n");
+	++c->depth;
+	if(loop->reads_value)
+	{
+		char const * lanes = el_lanes_name(c, for_statement->range.type_id);
+		el_append_indent(c);
+		el_string_builder_appendf(sb, "el_%s ae_%s = el_load_%s(el_range_%d.elements + ae_%s);\n", lanes, for_statement->value_var_name, lanes, range, index);
+	}
+	struct el_ast_statement_list const * body = &for_statement->code_block;
+	for(int i = 0; i < body->num_statements; ++i)
+	{
+		struct el_ast_expression const * lhs = &body->statements[i].assignment.lhs;
+		el_append_indent(c);
+		el_string_builder_appendf(sb, "el_store_%s(ae_%s.elements + ae_%s, ", el_lanes_name(c, lhs->binary_op.lhs->type_id), lhs->binary_op.lhs->identifier, index);
+		el_emit_vector_expression(c, loop, &body->statements[i].assignment.rhs);
+		el_string_builder_append_cstr(sb, ");\n");
+	}
+	--c->depth;
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "}\n");
+	--c->depth;
+	el_append_indent(c);
+	el_string_builder_append_cstr(sb, "}\n#endif\n");
+}
+
+// Recurses at most el_VECTOR_LOOP_MAX_EXPRESSIONS deep, comparisons give -1 in each lane which holds, negated to 1
+static void el_emit_vector_expression(struct el_c_emitter * c, struct el_vector_loop const * loop, struct el_ast_expression const * e)
+{
+	struct el_string_builder * sb = &c->sb;
+	struct el_ast_for_statement const * for_statement = loop->for_statement;
+	char const * lanes = el_lanes_name(c, e->type_id);
+	char const * op = NULL;
+	switch(e->type)
+	{
+	case el_AST_EXPR_NUMBER_LITERAL:
+		el_string_builder_appendf(sb, "el_splat_%s(", lanes);
+		el_append_number(c, e);
+		el_string_builder_append_char(sb, ')');
+		return;
+	case el_AST_EXPR_IDENTIFIER:
+		if(e->symbol == for_statement->index_symbol)
+		{
+			el_string_builder_appendf(sb, "el_lane_ints(ae_%s)", e->identifier);
+		}
+		else if(e->symbol == for_statement->value_symbol)
+		{
+			el_string_builder_appendf(sb, "ae_%s", e->identifier);
+		}
+		else
+		{
+			el_string_builder_appendf(sb, "el_splat_%s(ae_%s)", lanes, e->identifier);
+		}
+		return;
+	case el_AST_EXPR_SLICE_INDEX:
+		el_string_builder_appendf(sb, "el_load_%s(ae_%s.elements + ae_%s)", lanes, e->binary_op.lhs->identifier, for_statement->index_var_name);
+		return;
+	case el_AST_EXPR_ADD:
+		op = " + ";
+		break;
+	case el_AST_EXPR_SUB:
+		op = " - ";
+		break;
+	case el_AST_EXPR_MUL:
+		op = " * ";
+		break;
+	case el_AST_EXPR_DIV:
+		op = " / ";
+		break;
+	case el_AST_EXPR_EQUALS:
+		op = " == ";
+		break;
+	case el_AST_EXPR_GREATER_THAN:
+		op = " > ";
+		break;
+	case el_AST_EXPR_LESS_THAN:
+		op = " < ";
+		break;
+	case el_AST_EXPR_GEQUALS:
+		op = " >= ";
+		break;
+	case el_AST_EXPR_LEQUALS:
+		op = " <= ";
+		break;
+	case el_AST_EXPR_BOOLEAN_AND:
+	case el_AST_EXPR_BOOLEAN_OR:
+		el_string_builder_append_cstr(sb, "(-(el_ints)((");
+		el_emit_vector_expression(c, loop, e->binary_op.lhs);
+		el_string_builder_append_cstr(sb, e->type == el_AST_EXPR_BOOLEAN_AND ? " != 0) & (" : " != 0) | (");
+		el_emit_vector_expression(c, loop, e->binary_op.rhs);
+		el_string_builder_append_cstr(sb, " != 0)))");
+		return;
+	default:
+		assert(false);
+		return;
+	}
+
+	// Int arithmetic wraps through the helpers, everything else is a C operator on the lanes
+	bool is_comparison = e->type >= el_AST_EXPR_EQUALS && e->type <= el_AST_EXPR_LEQUALS;
+	bool is_int_arithmetic = !is_comparison && e->type_id == el_INT_TYPE_ID;
+	if(is_int_arithmetic)
+	{
+		el_string_builder_appendf(sb, "el_%s_ints(", e->type == el_AST_EXPR_ADD ? "add" : e->type == el_AST_EXPR_SUB ? "sub" : "mul");
+	}
+	else
+	{
+		el_string_builder_append_cstr(sb, is_comparison ? "(-(el_ints)(" : "(");
+	}
+	el_emit_vector_expression(c, loop, e->binary_op.lhs);
+	el_string_builder_append_cstr(sb, is_int_arithmetic ? ", " : op);
+	el_emit_vector_expression(c, loop, e->binary_op.rhs);
+	el_string_builder_append_cstr(sb, is_comparison ? "))" : ")");
+}
+
+// Suffix of the lane helpers for an int, a float or a slice of either
+static char const * el_lanes_name(struct el_c_emitter const * c, int type)
+{
+	struct el_type const * t = el_get_type(c->types, type);
+	int element_type = t->kind == el_TYPE_SLICE ? t->element_type : type;
+	return element_type == el_FLOAT_TYPE_ID ? "floats" : "ints";
+}
+
+static void el_emit_block(struct el_c_emitter * c, struct el_ast_statement_list * list)
+{
+	el_append_indent(c);
+	el_string_builder_append_cstr(&c->sb, "{\n");
+	++c->depth;
+	el_emit_statements(c, list);
+	--c->depth;
+	el_append_indent(c);
+	el_string_builder_append_cstr(&c->sb, "}\n");
+}
+
+// Expressions are written from a stack of the parts still to be written rather than by recursion,
+// s.t. long chains of operators cannot overflow the call stack
+static void el_emit_expression(struct el_c_emitter * c, struct el_ast_expression * expression)
+{
+	int num_items = c->num_items;
+	el_push_expression(c, expression);
+	while(c->num_items > num_items && c->err == 0)
+	{
+		struct el_c_item item = c->items[--c->num_items];
+		switch(item.kind)
+		{
+		case el_C_ITEM_TEXT:
+			el_string_builder_append_cstr(&c->sb, item.text);
+			break;
+		case el_C_ITEM_EXPRESSION:
+			el_expand_expression(c, item.expression);
+			break;
+		case el_C_ITEM_ZERO:
+			el_append_zero(c, item.type);
+			break;
+		}
+	}
+	c->num_items = num_items;
+}
+
+// Write the start of the expression and push the rest of it, children are pushed after the text which follows them
+static void el_expand_expression(struct el_c_emitter * c, struct el_ast_expression * e)
+{
+	struct el_string_builder * sb = &c->sb;
+	int operand_type = e->type <= el_AST_EXPR_DIV ? e->binary_op.lhs->type_id : el_NO_TYPE;
+	char const * op = NULL;
+	switch(e->type)
+	{
+	case el_AST_EXPR_EQUALS:
+		op = operand_type == el_STRING_TYPE_ID ? NULL : " == ";
+		break;
+	case el_AST_EXPR_GREATER_THAN:
+		op = " > ";
+		break;
+	case el_AST_EXPR_LESS_THAN:
+		op = " < ";
+		break;
+	case el_AST_EXPR_GEQUALS:
+		op = " >= ";
+		break;
+	case el_AST_EXPR_LEQUALS:
+		op = " <= ";
+		break;
+	case el_AST_EXPR_ADD:
+		op = operand_type == el_FLOAT_TYPE_ID ? " + " : NULL;
+		break;
+	case el_AST_EXPR_SUB:
+		op = operand_type == el_FLOAT_TYPE_ID ? " - " : NULL;
+		break;
+	case el_AST_EXPR_MUL:
+		op = operand_type == el_FLOAT_TYPE_ID ? " * " : NULL;
+		break;
+	case el_AST_EXPR_DIV:
+		op = operand_type == el_FLOAT_TYPE_ID ? " / " : NULL;
+		break;
+	default:
+		break;
+	}
+
+	switch(e->type)
+	{
+	case el_AST_EXPR_EQUALS:
+	case el_AST_EXPR_GREATER_THAN:
+	case el_AST_EXPR_LESS_THAN:
+	case el_AST_EXPR_GEQUALS:
+	case el_AST_EXPR_LEQUALS:
+	case el_AST_EXPR_ADD:
+	case el_AST_EXPR_SUB:
+	case el_AST_EXPR_MUL:
+	case el_AST_EXPR_DIV:
+	{
+		// Float arithmetic and comparisons are C operators, int arithmetic, vector arithmetic and string equality are helpers
+		static char const * const helpers[] = {
+			[el_AST_EXPR_EQUALS] = "el_str_equals(",
+			[el_AST_EXPR_ADD] = "el_add_int(",
+			[el_AST_EXPR_SUB] = "el_sub_int(",
+			[el_AST_EXPR_MUL] = "el_mul_int(",
+			[el_AST_EXPR_DIV] = "el_div_int("
+		};
+		static char const * const vector_helpers[] = {
+			[el_AST_EXPR_ADD] = "el_add_",
+			[el_AST_EXPR_SUB] = "el_sub_",
+			[el_AST_EXPR_MUL] = "el_mul_",
+			[el_AST_EXPR_DIV] = "el_div_"
+		};
+		if(el_get_type(c->types, operand_type)->kind == el_TYPE_VECTOR)
+		{
+			el_string_builder_append_cstr(sb, vector_helpers[e->type]);
+			el_append_vector_name(c, operand_type);
+			el_string_builder_append_char(sb, '(');
+			op = NULL;
+		}
+		else
+		{
+			el_string_builder_append_cstr(sb, op ? "(" : helpers[e->type]);
+		}
+		el_push_text(c, ")");
+		el_push_expression(c, e->binary_op.rhs);
+		el_push_text(c, op ? op : ", ");
+		el_push_expression(c, e->binary_op.lhs);
+		break;
+	}
+	case el_AST_EXPR_BOOLEAN_AND:
+	case el_AST_EXPR_BOOLEAN_OR:
+		// Both operands are evaluated, as they are by the vm
+		el_string_builder_append_cstr(sb, "(((");
+		el_push_text(c, ") != 0))");
+		el_push_expression(c, e->binary_op.rhs);
+		el_push_text(c, e->type == el_AST_EXPR_BOOLEAN_AND ? ") != 0) & ((" : ") != 0) | ((");
+		el_push_expression(c, e->binary_op.lhs);
+		break;
+	case el_AST_EXPR_DOT:
+	{
+		// A field of an element of a soa slice is read in place, the index of a view is always in range
+		struct el_ast_expression * object = e->binary_op.lhs;
+		struct el_c_view const * view = object->type == el_AST_EXPR_IDENTIFIER ? el_find_view(c, object->symbol) : NULL;
+		struct el_ast_data_block const * data_block = el_type_data_block(c, object->type_id);
+		assert(data_block);
+		char const * field = data_block->var_declarations[e->binary_op.rhs->symbol].name;
+		if(view)
+		{
+			el_string_builder_appendf(sb, "el_range_%d.ae_%s[ae_%s]", view->range, field, view->for_statement->index_var_name);
+			break;
+		}
+		if(object->type == el_AST_EXPR_SLICE_INDEX && el_is_soa_slice(c->types, object->binary_op.lhs->type_id))
+		{
+			el_string_builder_appendf(sb, "(*el_at_%d_%d(", object->binary_op.lhs->type_id, e->binary_op.rhs->symbol);
+			el_push_text(c, "))");
+			el_push_expression(c, object->binary_op.rhs);
+			el_push_text(c, ", ");
+			el_push_expression(c, object->binary_op.lhs);
+			break;
+		}
+		el_string_builder_appendf(sb, "el_check_dat_%s(", data_block->name);
+		el_push_text(c, data_block->var_declarations[e->binary_op.rhs->symbol].name);
+		el_push_text(c, ")->ae_");
+		el_push_expression(c, e->binary_op.lhs);
+		break;
+	}
+	case el_AST_EXPR_FUNCTION_CALL:
+		el_expand_call(c, e);
+		break;
+	case el_AST_EXPR_SLICE_INDEX:
+		if(el_get_type(c->types, e->binary_op.lhs->type_id)->kind == el_TYPE_VECTOR)
+		{
+			el_string_builder_append_cstr(sb, "EL_LANE(");
+			el_push_text(c, ")");
+		}
+		else if(el_is_soa_slice(c->types, e->binary_op.lhs->type_id))
+		{
+			el_string_builder_appendf(sb, "el_get_%d(", e->binary_op.lhs->type_id);
+			el_push_text(c, ")");
+		}
+		else
+		{
+			el_string_builder_appendf(sb, "(*el_at_%d(", e->binary_op.lhs->type_id);
+			el_push_text(c, "))");
+		}
+		el_push_expression(c, e->binary_op.rhs);
+		el_push_text(c, ", ");
+		el_push_expression(c, e->binary_op.lhs);
+		break;
+	case el_AST_EXPR_NUMBER_LITERAL:
+		el_append_number(c, e);
+		break;
+	case el_AST_EXPR_STRING_LITERAL:
+		el_append_string(c, e->string_literal);
+		break;
+	case el_AST_EXPR_SLICE_LITERAL:
+	{
+		// The elements are copied out of a compound literal
+		struct el_ast_expression_list * list = e->expression_list;
+		if(list->num_expressions == 0)
+		{
+			el_append_zero(c, e->type_id);
+			break;
+		}
+		el_string_builder_appendf(sb, "el_new_slice_%d(%dLL, (", e->type_id, list->num_expressions);
+		el_append_c_type(c, el_get_type(c->types, e->type_id)->element_type);
+		el_string_builder_append_cstr(sb, "[]){ ");
+		el_push_text(c, " })");
+		for(int i = list->num_expressions - 1; i >= 0; --i)
+		{
+			el_push_expression(c, &list->expressions[i]);
+			if(i > 0)
+			{
+				el_push_text(c, ", ");
+			}
+		}
+		break;
+	}
+	case el_AST_EXPR_IDENTIFIER:
+	{
+		struct el_c_view const * view = el_find_view(c, e->symbol);
+		if(view)
+		{
+			el_string_builder_appendf(sb, "el_get_%d(el_range_%d, ae_%s)", view->for_statement->range.type_id, view->range, view->for_statement->index_var_name);
+			break;
+		}
+		el_string_builder_append_cstr(sb, "ae_");
+		el_string_builder_append_cstr(sb, e->identifier);
+		break;
+	}
+	default:
+		assert(false);
+		break;
+	}
+}
+
+// Data blocks are constructed by a helper taking every field, those without an argument are zero
+// Vectors are built from every lane, or a lane splat across them or zero
+static void el_expand_call(struct el_c_emitter * c, struct el_ast_expression * e)
+{
+	struct el_ast_expression_list * arguments = e->binary_op.rhs->expression_list;
+	int num_arguments = arguments->num_expressions;
+	struct el_ast_data_block const * data_block = NULL;
+	if(e->binary_op.lhs->type == el_AST_EXPR_VECTOR_TYPE)
+	{
+		el_string_builder_append_cstr(&c->sb, num_arguments == 1 ? "el_splat_" : "EL_VECTOR_OF(");
+		el_append_vector_name(c, e->type_id);
+		el_string_builder_append_cstr(&c->sb, num_arguments == 0 ? ", 0" : num_arguments == 1 ? "(" : ", ");
+	}
+	else if(c->symbols->symbols[e->binary_op.lhs->symbol].kind == el_SYMBOL_DATA_BLOCK)
+	{
+		data_block = c->symbols->symbols[e->binary_op.lhs->symbol].data_block;
+		el_string_builder_appendf(&c->sb, "el_new_dat_%s(", data_block->name);
+		num_arguments = data_block->num_var_declarations;
+	}
+	else
+	{
+		el_string_builder_appendf(&c->sb, "ae_%s(", c->symbols->symbols[e->binary_op.lhs->symbol].function_definition->name);
+	}
+
+	el_push_text(c, ")");
+	for(int i = num_arguments - 1; i >= 0; --i)
+	{
+		if(i < arguments->num_expressions)
+		{
+			el_push_expression(c, &arguments->expressions[i]);
+		}
+		else
+		{
+			el_push_zero(c, data_block->var_declarations[i].type.type_id);
+		}
+		if(i > 0)
+		{
+			el_push_text(c, ", ");
+		}
+	}
+}
+
+static void el_push_text(struct el_c_emitter * c, char const * text)
+{
+	struct el_c_item * item = c->err ? NULL : el_vector_push(c, items, NULL);
+	if(item)
+	{
+		*item = (struct el_c_item){ .kind = el_C_ITEM_TEXT, .text = text };
+	}
+	else
+	{
+		c->err = c->err ? c->err : el_ALLOCATION_ERROR;
+	}
+}
+
+static void el_push_expression(struct el_c_emitter * c, struct el_ast_expression * expression)
+{
+	struct el_c_item * item = c->err ? NULL : el_vector_push(c, items, NULL);
+	if(item)
+	{
+		*item = (struct el_c_item){ .kind = el_C_ITEM_EXPRESSION, .expression = expression };
+	}
+	else
+	{
+		c->err = c->err ? c->err : el_ALLOCATION_ERROR;
+	}
+}
+
+static void el_push_zero(struct el_c_emitter * c, int type)
+{
+	struct el_c_item * item = c->err ? NULL : el_vector_push(c, items, NULL);
+	if(item)
+	{
+		*item = (struct el_c_item){ .kind = el_C_ITEM_ZERO, .type = type };
+	}
+	else
+	{
+		c->err = c->err ? c->err : el_ALLOCATION_ERROR;
+	}
+}
+
+static void el_append_c_type(struct el_c_emitter * c, int type)
+{
+	struct el_string_builder * sb = &c->sb;
+	switch(el_get_type(c->types, type)->kind)
+	{
+	case el_TYPE_VOID:
+		el_string_builder_append_cstr(sb, "void");
+		break;
+	case el_TYPE_INT:
+		el_string_builder_append_cstr(sb, "long long");
+		break;
+	case el_TYPE_FLOAT:
+		el_string_builder_append_cstr(sb, "double");
+		break;
+	case el_TYPE_STRING:
+		el_string_builder_append_cstr(sb, "el_str");
+		break;
+	case el_TYPE_DATA_BLOCK:
+		el_string_builder_appendf(sb, "ae_%s *", el_type_data_block(c, type)->name);
+		break;
+	case el_TYPE_SLICE:
+		el_string_builder_appendf(sb, "el_slice_%d", type);
+		break;
+	case el_TYPE_VECTOR:
+		el_string_builder_append_cstr(sb, "el_");
+		el_append_vector_name(c, type);
+		break;
+	}
+}
+
+static void el_append_zero(struct el_c_emitter * c, int type)
+{
+	struct el_string_builder * sb = &c->sb;
+	switch(el_get_type(c->types, type)->kind)
+	{
+	case el_TYPE_INT:
+		el_string_builder_append_cstr(sb, "0LL");
+		break;
+	case el_TYPE_FLOAT:
+		el_string_builder_append_cstr(sb, "0.0");
+		break;
+	case el_TYPE_STRING:
+		el_string_builder_append_cstr(sb, "(el_str){ 0 }");
+		break;
+	case el_TYPE_DATA_BLOCK:
+		el_string_builder_append_cstr(sb, "NULL");
+		break;
+	case el_TYPE_SLICE:
+		el_string_builder_appendf(sb, "(el_slice_%d){ 0 }", type);
+		break;
+	case el_TYPE_VECTOR:
+		el_string_builder_append_cstr(sb, "EL_VECTOR_OF(");
+		el_append_vector_name(c, type);
+		el_string_builder_append_cstr(sb, ", 0)");
+		break;
+	}
+}
+
+// The prelude defines el_int2 to el_float8 and their helpers, which share the name of the type
+static void el_append_vector_name(struct el_c_emitter * c, int type)
+{
+	if(!el_append_type_name(&c->sb, c->types, type))
+	{
+		c->err = c->err ? c->err : el_ALLOCATION_ERROR;
+	}
+}
+
+// Negative literals come from folded constants and are parenthesised s.t. they cannot merge with a preceding minus
+static void el_append_number(struct el_c_emitter * c, struct el_ast_expression const * e)
+{
+	struct el_string_builder * sb = &c->sb;
+	if(e->type_id != el_FLOAT_TYPE_ID)
+	{
+		if(e->int_value == LLONG_MIN)
+		{
+			el_string_builder_append_cstr(sb, "(-9223372036854775807LL - 1)");
+		}
+		else
+		{
+			el_string_builder_appendf(sb, e->int_value < 0 ? "(%lldLL)" : "%lldLL", e->int_value);
+		}
+		return;
+	}
+
+	double value = e->float_value;
+	if(isnan(value))
+	{
+		el_string_builder_append_cstr(sb, "NAN");
+		return;
+	}
+	if(isinf(value))
+	{
+		el_string_builder_append_cstr(sb, value > 0 ? "INFINITY" : "(-INFINITY)");
+		return;
+	}
+
+	// %.17g round trips every double, a point is added to integral values s.t. they stay doubles
+	char digits[32];
+	int length = snprintf(digits, sizeof digits, "%.17g", value);
+	bool is_integral = strpbrk(digits, ".e") == NULL;
+	el_string_builder_appendf(sb, signbit(value) ? "(%.*s%s)" : "%.*s%s", length, digits, is_integral ? ".0" : "");
+}
+
+// Bytes which are not printable are written as octal escapes, as are none of the characters which start a trigraph
+static void el_append_string(struct el_c_emitter * c, el_string s)
+{
+	struct el_string_builder * sb = &c->sb;
+	int length = el_string_length(s);
+	el_string_builder_append_cstr(sb, "(el_str){ \"");
+	for(int i = 0; i < length; ++i)
+	{
+		unsigned char byte = (unsigned char)s[i];
+		if(byte == '\\' || byte == '"' || byte == '?')
+		{
+			el_string_builder_append_char(sb, '\\');
+			el_string_builder_append_char(sb, (char)byte);
+		}
+		else if(byte < 0x20 || byte >= 0x7f)
+		{
+			el_string_builder_appendf(sb, "\\%03o", byte);
+		}
+		else
+		{
+			el_string_builder_append_char(sb, (char)byte);
+		}
+	}
+	el_string_builder_appendf(sb, "\", %dLL }", length);
+}
+
+static void el_append_indent(struct el_c_emitter * c)
+{
+	el_string_builder_append_chars(&c->sb, '\t', c->depth);
+}
+
+// Returns the data block a type names, or NULL if it is not a data block
+static struct el_ast_data_block const * el_type_data_block(struct el_c_emitter const * c, int type)
+{
+	struct el_type const * t = el_get_type(c->types, type);
+	return t->kind == el_TYPE_DATA_BLOCK ? c->symbols->symbols[t->data_block].data_block : NULL;
+}
+
+// Returns the view whose value variable is symbol, or NULL if it is not a view
+static struct el_c_view const * el_find_view(struct el_c_emitter const * c, int symbol)
+{
+	for(int i = c->num_views - 1; i >= 0; --i)
+	{
+		if(c->views[i].symbol == symbol)
+			return &c->views[i];
+	}
+	return NULL;
+}
+
+static bool el_is_global(struct el_c_emitter const * c, int symbol)
+{
+	struct el_symbol const * s = &c->symbols->symbols[symbol];
+	return s->kind == el_SYMBOL_VARIABLE && c->symbols->scopes[s->scope].kind == el_SCOPE_FILE;
+}
+
+static void el_flush(struct el_c_emitter * c, struct el_buffered_writer * writer)
+{
+	el_buffered_writer_write_view(writer, el_string_builder_view(&c->sb));
+	el_string_builder_clear(&c->sb);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <compiler/syntax-parsing/ast.h>
+
+struct el_buffered_writer;
+struct el_symbol_table;
+struct el_type_table;
+
+enum el_c_emit_flags
+{
+	el_C_EMIT_DEFAULT = 0,
+
+	// Add a C main which runs the file scope statements, then main if the program has one
+	el_C_EMIT_MAIN = 1 << 0
+};
+
+// Write the ast as a self contained C17 translation unit to writer, flushing it once the whole unit is written
+// Each data block becomes a struct referenced by pointer and each slice a (pointer, length) pair, as in the vm
+// Functions keep their names prefixed with ae_, the file scope statements become void el_init(void)
+// Int arithmetic wraps and division by zero is a runtime error, as are indices out of range and fields of zero data blocks unless EL_UNCHECKED is defined
+// Unlike the vm, recursion is only limited by the native stack
+// Parallel for statements run on OpenMP threads when the C compiler enables it, otherwise in serial, either way with the vm's results
+// The operands of an expression are evaluated in whatever order the C compiler picks
+// The ast must have passed el_type_check and el_fold_constants, the values of number literals are read from the ast
+int el_emit_c(struct el_ast * ast, struct el_symbol_table const * symbols, struct el_type_table const * types, struct el_buffered_writer * writer, int flags);
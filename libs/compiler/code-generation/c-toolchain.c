@@ -0,0 +1,93 @@
+#include "c-toolchain.h"
+#include <compiler/error.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#ifdef SYSTEM_WINDOWS
+	#include <process.h>
+#else
+	#include <spawn.h>
+	#include <sys/wait.h>
+	extern char ** environ;
+#endif
+
+// Set by CMake to the compiler the project itself is built with
+#ifndef EL_C_COMPILER
+	#define EL_C_COMPILER "cc"
+#endif
+
+#define C_TOOLCHAIN_MAX_ARGUMENTS 16
+
+static int el_run_compiler(char const * const * arguments);
+
+int el_compile_c(char const * c_path, char const * output_path, int output)
+{
+	assert(c_path && output_path);
+	char const * compiler = getenv("CC");
+	compiler = compiler && compiler[0] ? compiler : EL_C_COMPILER;
+
+	char const * arguments[C_TOOLCHAIN_MAX_ARGUMENTS];
+	int num_arguments = 0;
+	arguments[num_arguments++] = compiler;
+#ifdef EL_C_COMPILER_IS_MSVC
+	arguments[num_arguments++] = "/nologo";
+	arguments[num_arguments++] = "/std:c17";
+	arguments[num_arguments++] = "/O2";
+#ifdef EL_C_OPENMP_FLAG
+	arguments[num_arguments++] = EL_C_OPENMP_FLAG;
+#endif
+	if(output == el_NATIVE_SHARED_LIBRARY)
+	{
+		arguments[num_arguments++] = "/LD";
+	}
+	arguments[num_arguments++] = c_path;
+	arguments[num_arguments++] = "/Fe:";
+	arguments[num_arguments++] = output_path;
+#else
+	arguments[num_arguments++] = "-std=c17";
+	arguments[num_arguments++] = "-O2";
+	arguments[num_arguments++] = "-Wno-psabi"; // Vector types passed between the program's own functions
+#ifdef EL_C_OPENMP_FLAG
+	arguments[num_arguments++] = EL_C_OPENMP_FLAG; // Parallel for statements
+#endif
+	if(output == el_NATIVE_SHARED_LIBRARY)
+	{
+		arguments[num_arguments++] = "-shared";
+		arguments[num_arguments++] = "-fPIC";
+	}
+	arguments[num_arguments++] = "-o";
+	arguments[num_arguments++] = output_path;
+	arguments[num_arguments++] = c_path;
+	arguments[num_arguments++] = "-lm";
+#endif
+	arguments[num_arguments++] = NULL;
+	assert(num_arguments <= C_TOOLCHAIN_MAX_ARGUMENTS);
+
+	int status = el_run_compiler(arguments);
+	if(status != 0)
+	{
+		fprintf(stderr, "Failed to compile %s with %s%s\n", c_path, compiler, status < 0 ? ", the compiler could not be started" : "");
+		return el_NATIVE_COMPILER_ERROR;
+	}
+	return el_SUCCESS;
+}
+
+// Returns the exit status of the compiler, or -1 if it could not be started or did not exit normally
+static int el_run_compiler(char const * const * arguments)
+{
+	fflush(stdout);
+#ifdef SYSTEM_WINDOWS
+	intptr_t status = _spawnvp(_P_WAIT, arguments[0], arguments);
+	return status == -1 ? -1 : (int)status;
+#else
+	pid_t pid;
+	if(posix_spawnp(&pid, arguments[0], NULL, NULL, (char * const *)arguments, environ) != 0)
+		return -1;
+
+	int status = 0;
+	if(waitpid(pid, &status, 0) < 0 || !WIFEXITED(status))
+		return -1;
+	return WEXITSTATUS(status);
+#endif
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+enum el_native_output
+{
+	el_NATIVE_EXECUTABLE,
+	el_NATIVE_SHARED_LIBRARY
+};
+
+// Compile the C file written by el_emit_c into an executable or shared library at output_path
+// The compiler is $CC if it is set, otherwise the C compiler CMake configured the compiler library with
+// OpenMP is enabled if CMake found it for that compiler, s.t. parallel for statements run on its threads
+// Blocks until the compiler exits, its diagnostics go to this process's stderr
+int el_compile_c(char const * c_path, char const * output_path, int output);
@@ -4,6 +4,7 @@ enum el_error
 {
 	el_SUCCESS,
 	el_ALLOCATION_ERROR,
+	el_IO_ERROR,
 
 	// Lexing errors
 	el_EXCEEDED_TOKENS_LIMIT_LEX_ERROR = 1000,
@@ -12,5 +13,45 @@ enum el_error
 	// Parsing errors
 	el_MATCH_TOKEN_PARSE_ERROR = 2000,
 	el_EXPECTED_FACTOR_EXPR_PARSE_ERROR,
-	el_EXPECTED_TYPE_PARSE_ERROR
+	el_EXPECTED_TYPE_PARSE_ERROR,
+	el_EXCEEDED_EXPR_NESTING_LIMIT_PARSE_ERROR,
+	el_EXCEEDED_BLOCK_NESTING_LIMIT_PARSE_ERROR,
+	el_STALE_AST_PARSE_ERROR,
+	el_STATEMENT_PAST_RANGE_PARSE_ERROR,
+	el_EXPECTED_REDUCTION_PARSE_ERROR,
+
+	// AST cache errors
+	el_AST_CACHE_IO_ERROR = 3000,
+	el_AST_CACHE_STALE_ERROR,
+	el_AST_CACHE_CORRUPT_ERROR,
+
+	// Semantic errors
+	el_UNDECLARED_IDENTIFIER_ERROR = 4000,
+	el_UNDECLARED_TYPE_ERROR,
+	el_REDECLARED_SYMBOL_ERROR,
+	el_MISMATCHED_TYPES_ERROR,
+	el_INVALID_OPERAND_ERROR,
+	el_WRONG_NUMBER_OF_ARGUMENTS_ERROR,
+	el_UNKNOWN_FIELD_ERROR,
+	el_NOT_ASSIGNABLE_ERROR,
+	el_UNINFERRABLE_TYPE_ERROR,
+	el_INVALID_NUMBER_LITERAL_ERROR,
+	el_RETURN_OUTSIDE_FUNCTION_ERROR,
+	el_NUMBER_LITERAL_OUT_OF_RANGE_ERROR,
+	el_UNSAFE_PARALLEL_FOR_ERROR,
+	el_SOA_ELEMENT_COPY_ERROR,
+
+	// IR errors
+	el_EXCEEDED_IR_LIMIT_ERROR = 5000,
+
+	// Execution errors
+	el_UNPARSED_FUNCTION_BODY_ERROR = 6000,
+	el_DIVISION_BY_ZERO_RUNTIME_ERROR,
+	el_INDEX_OUT_OF_RANGE_RUNTIME_ERROR,
+	el_NULL_REFERENCE_RUNTIME_ERROR,
+	el_STACK_OVERFLOW_RUNTIME_ERROR,
+
+	// Code generation errors
+	el_NATIVE_COMPILER_ERROR = 7000,
+	el_JIT_UNSUPPORTED_PLATFORM_ERROR
 };
@@ -0,0 +1,242 @@
+#include "ir-dump.h"
+#include <compiler/error.h>
+#include <compiler/semantic-analysis/type-table.h>
+#include <containers/string-builder.h>
+#include <file-system/buffered-writer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+static void el_dump_function(struct el_string_builder * sb, struct el_ir_module const * module, struct el_ir_function const * function);
+static void el_dump_function_name(struct el_string_builder * sb, struct el_ir_module const * module, int function);
+static void el_dump_instruction(struct el_string_builder * sb, struct el_ir_module const * module, struct el_ir_function const * function, struct el_ir_instruction const * instruction);
+static void el_dump_operand(struct el_string_builder * sb, struct el_ir_module const * module, struct el_ir_function const * function, struct el_ir_instruction const * instruction, int kind, int operand);
+static void el_dump_kernel(struct el_string_builder * sb, struct el_ir_module const * module, struct el_ir_kernel const * kernel, int index);
+static void el_dump_float(struct el_string_builder * sb, double value);
+
+int el_ir_dump(struct el_ir_module const * module, struct el_buffered_writer * writer)
+{
+	assert(module && writer);
+	struct el_string_builder sb;
+	if(!el_string_builder_new(&sb, 0))
+		return el_ALLOCATION_ERROR;
+
+	struct el_symbol_table const * symbols = module->types->symbols;
+	for(int i = 0; i < module->num_globals; ++i)
+	{
+		el_string_builder_append_cstr(&sb, "global ");
+		el_string_builder_append_view(&sb, el_symbol_name(symbols, module->global_symbols[i]));
+		el_string_builder_append_char(&sb, ' ');
+		el_append_type_name(&sb, module->types, module->global_types[i]);
+		el_string_builder_append_char(&sb, '\n');
+	}
+
+	// Each function is built then written whole, s.t. the builder stays small
+	for(int i = 0; i < module->num_functions; ++i)
+	{
+		el_dump_function(&sb, module, &module->functions[i]);
+		el_buffered_writer_write_view(writer, el_string_builder_view(&sb));
+		el_string_builder_clear(&sb);
+	}
+	el_string_builder_delete(&sb);
+
+	if(!el_buffered_writer_flush(writer))
+	{
+		fprintf(stderr, "Failed to write ir dump\n");
+		return el_IO_ERROR;
+	}
+	return el_SUCCESS;
+}
+
+static void el_dump_function(struct el_string_builder * sb, struct el_ir_module const * module, struct el_ir_function const * function)
+{
+	if(!function->name && function->outlined_from < 0)
+	{
+		el_string_builder_append_cstr(sb, "init\n");
+	}
+	else
+	{
+		el_string_builder_append_cstr(sb, "fnc ");
+		el_dump_function_name(sb, module, (int)(function - module->functions));
+		el_string_builder_append_char(sb, '(');
+		for(int i = 0; i < function->num_parameters; ++i)
+		{
+			el_string_builder_appendf(sb, i > 0 ? ", r%d " : "r%d ", i);
+			el_append_type_name(sb, module->types, i < function->num_registers ? function->register_types[i] : el_NO_TYPE);
+		}
+		el_string_builder_append_cstr(sb, ") ");
+		el_append_type_name(sb, module->types, function->return_type);
+		el_string_builder_append_char(sb, '\n');
+	}
+
+	if(function->num_blocks == 0)
+	{
+		el_string_builder_append_cstr(sb, "  (not parsed)\n");
+	}
+	for(int i = 0; i < function->num_blocks; ++i)
+	{
+		struct el_ir_block const * block = &function->blocks[i];
+		el_string_builder_appendf(sb, "  b%d:\n", i);
+		for(int j = 0; j < block->num_instructions; ++j)
+		{
+			el_dump_instruction(sb, module, function, &function->instructions[block->first_instruction + j]);
+		}
+	}
+	for(int i = 0; i < function->num_kernels; ++i)
+	{
+		el_dump_kernel(sb, module, &function->kernels[i], i);
+	}
+}
+
+// Chunk functions are named after the function they are outlined from and their own index, e.g. main.parallel3
+static void el_dump_function_name(struct el_string_builder * sb, struct el_ir_module const * module, int function)
+{
+	struct el_ir_function const * f = &module->functions[function];
+	if(f->outlined_from < 0)
+	{
+		el_string_builder_append_cstr(sb, f->name);
+		return;
+	}
+	el_string_builder_appendf(sb, "%s.parallel%d", f->name ? f->name : "init", function);
+}
+
+// Written as "r2: int = add.int r0 r1", or "set.field r0 x r1" for ops without a result
+// A vector built in the block its register owns is followed by "(in place)"
+static void el_dump_instruction(struct el_string_builder * sb, struct el_ir_module const * module, struct el_ir_function const * function, struct el_ir_instruction const * instruction)
+{
+	struct el_ir_op_info const * info = el_ir_op_info(instruction->op);
+	int operands[3] = { instruction->a, instruction->b, instruction->c };
+	int first_operand = 0;
+	el_string_builder_append_cstr(sb, "    ");
+	if(info->writes_a)
+	{
+		first_operand = 1;
+		if(instruction->a != el_IR_NO_REGISTER)
+		{
+			el_string_builder_appendf(sb, "r%d: ", instruction->a);
+			el_append_type_name(sb, module->types, function->register_types[instruction->a]);
+			el_string_builder_append_cstr(sb, " = ");
+		}
+	}
+
+	el_string_builder_append_cstr(sb, info->name);
+	for(int i = first_operand; i < 3; ++i)
+	{
+		el_dump_operand(sb, module, function, instruction, info->operand_kinds[i], operands[i]);
+	}
+	if(el_ir_builds_vector(instruction->op) && function->owned_vectors[instruction->a])
+	{
+		el_string_builder_append_cstr(sb, " (in place)");
+	}
+	el_string_builder_append_char(sb, '\n');
+}
+
+static void el_dump_operand(struct el_string_builder * sb, struct el_ir_module const * module, struct el_ir_function const * function, struct el_ir_instruction const * instruction, int kind, int operand)
+{
+	struct el_symbol_table const * symbols = module->types->symbols;
+	switch(kind)
+	{
+	case el_IR_OPERAND_NONE:
+	case el_IR_OPERAND_COUNT:
+		break;
+	case el_IR_OPERAND_REGISTER:
+		el_string_builder_appendf(sb, " r%d", operand);
+		break;
+	case el_IR_OPERAND_INT_CONSTANT:
+		el_string_builder_append_char(sb, ' ');
+		el_string_builder_append_int(sb, module->int_constants[operand]);
+		break;
+	case el_IR_OPERAND_FLOAT_CONSTANT:
+		el_string_builder_append_char(sb, ' ');
+		el_dump_float(sb, module->float_constants[operand]);
+		break;
+	case el_IR_OPERAND_STRING:
+		el_string_builder_appendf(sb, " \"%s\"", module->strings[operand]);
+		break;
+	case el_IR_OPERAND_GLOBAL:
+		el_string_builder_append_char(sb, ' ');
+		el_string_builder_append_view(sb, el_symbol_name(symbols, module->global_symbols[operand]));
+		break;
+	case el_IR_OPERAND_FIELD:
+	{
+		// The object is the register written by get.field and get.column and the first operand of set.field
+		// Columns of a soa slice are named after the fields of its element type
+		int object = instruction->op == el_IR_SET_FIELD ? instruction->a : instruction->b;
+		struct el_type const * type = el_get_type(module->types, function->register_types[object]);
+		if(type->kind == el_TYPE_SLICE)
+		{
+			type = el_get_type(module->types, type->element_type);
+		}
+		el_string_builder_appendf(sb, " %s", symbols->symbols[type->data_block].data_block->var_declarations[operand].name);
+		break;
+	}
+	case el_IR_OPERAND_FUNCTION:
+		el_string_builder_append_char(sb, ' ');
+		el_dump_function_name(sb, module, operand);
+		break;
+	case el_IR_OPERAND_BLOCK:
+		el_string_builder_appendf(sb, " b%d", operand);
+		break;
+	case el_IR_OPERAND_KERNEL:
+		el_string_builder_appendf(sb, " k%d", operand);
+		break;
+	case el_IR_OPERAND_LANE:
+		el_string_builder_appendf(sb, " %d", operand);
+		break;
+	case el_IR_OPERAND_OPERANDS:
+	{
+		int num_operands = instruction->op == el_IR_NEW_SLICE || instruction->op == el_IR_NEW_VECTOR ? instruction->b
+			: instruction->op == el_IR_KERNEL ? 1 + function->kernels[instruction->b].num_arguments
+			: instruction->op == el_IR_PARALLEL_FOR ? module->functions[instruction->b].num_parameters - 2 : module->functions[instruction->b].num_parameters;
+		el_string_builder_append_cstr(sb, " (");
+		for(int i = 0; i < num_operands; ++i)
+		{
+			el_string_builder_appendf(sb, i > 0 ? ", r%d" : "r%d", function->operands[operand + i]);
+		}
+		el_string_builder_append_char(sb, ')');
+		break;
+	}
+	}
+}
+
+// Written as "  k0(r0 float[], r1 float) r2:" followed by its instructions, whose registers are its own
+static void el_dump_kernel(struct el_string_builder * sb, struct el_ir_module const * module, struct el_ir_kernel const * kernel, int index)
+{
+	el_string_builder_appendf(sb, "  k%d(", index);
+	for(int i = 0; i < kernel->num_arguments; ++i)
+	{
+		el_string_builder_appendf(sb, i > 0 ? ", r%d " : "r%d ", i);
+		el_append_type_name(sb, module->types, kernel->register_types[i]);
+	}
+	el_string_builder_appendf(sb, ") r%d:\n", kernel->num_arguments);
+
+	struct el_ir_function const body = { .register_types = kernel->register_types, .num_registers = kernel->num_registers };
+	for(int i = 0; i < kernel->num_instructions; ++i)
+	{
+		el_dump_instruction(sb, module, &body, &kernel->instructions[i]);
+	}
+}
+
+// Shortest text which reads back as the same double
+static void el_dump_float(struct el_string_builder * sb, double value)
+{
+	char text[32];
+	for(int precision = 15; precision <= 17; ++precision)
+	{
+		snprintf(text, sizeof text, "%.*g", precision, value);
+		if(strtod(text, NULL) == value)
+			break;
+	}
+	el_string_builder_append_cstr(sb, text);
+
+	// Floats keep a decimal point s.t. they do not read as ints
+	bool reads_as_float = false;
+	for(int i = 0; text[i]; ++i)
+	{
+		reads_as_float = reads_as_float || text[i] == '.' || text[i] == 'e' || text[i] == 'n' || text[i] == 'i';
+	}
+	if(!reads_as_float)
+	{
+		el_string_builder_append_cstr(sb, ".0");
+	}
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include "ir.h"
+
+struct el_buffered_writer;
+
+// Write the module to writer as text, one instruction per line, flushing it once the whole module is written
+// Names of globals, fields and types are read from the module's type table, whose symbol table and ast must still exist
+int el_ir_dump(struct el_ir_module const * module, struct el_buffered_writer * writer);
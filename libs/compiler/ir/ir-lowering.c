@@ -0,0 +1,1855 @@
+#include "ir-lowering.h"
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <compiler/semantic-analysis/symbol-table.h>
+#include <compiler/semantic-analysis/type-table.h>
+#include <compiler/semantic-analysis/vector-loops.h>
+#include <compiler/syntax-parsing/ast-visitor.h>
+#include <containers/vector.h>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <assert.h>
+
+// Every array in the module's allocator starts on an 8 byte boundary
+#define IR_ALIGNMENT 8
+
+// Most chunks a parallel for splits its range into, each of which leaves its partial reductions in a slot of their slices
+#define IR_MAX_NUM_CHUNKS 256
+
+struct el_ir_block_builder
+{
+	el_VECTOR_MEMBERS(struct el_ir_instruction, instructions);
+};
+
+// The kernel of a vector loop, lowered beside the blocks of its function
+struct el_ir_kernel_builder
+{
+	int num_arguments;
+	el_VECTOR_MEMBERS(struct el_ir_instruction, instructions);
+	el_VECTOR_MEMBERS(int, register_types);
+};
+
+// A function is lowered into growable vectors, which are packed into the module's allocator once every function is lowered
+struct el_ir_function_builder
+{
+	struct el_ir_function function;
+	struct el_ast_function_definition * definition; // NULL for the init function and the chunk functions of parallel for statements
+	el_VECTOR_MEMBERS(struct el_ir_block_builder, blocks);
+	el_VECTOR_MEMBERS(int, register_types);
+	el_VECTOR_MEMBERS(uint16_t, operands);
+	el_VECTOR_MEMBERS(struct el_ir_kernel_builder, kernels);
+};
+
+// A for statement over a soa slice, whose columns are read in the block before its loop
+// Its value variable is a view of the element rather than a register, whose fields are read and written in the columns
+struct el_soa_view
+{
+	int symbol; // Of the value variable, el_NO_SYMBOL if there is none
+	int slice_type;
+	int range;
+	int index; // Register of the index variable
+	int preheader;
+	int first_column; // Of the view's columns in view_columns
+};
+
+// A variable the body of a parallel for reads or reduces, which its chunk function is given as a parameter
+// The reductions of the loop come first, followed by the variables of the enclosing function the body reads
+struct el_ir_capture
+{
+	int symbol;
+	int view; // Of the enclosing function if the variable is the value of a for over a soa slice, whose range and index are passed instead, or -1
+	int outer_register; // Of the variable in the enclosing function
+	int saved_index; // Of the variable in symbol_indices, restored once the chunk function is lowered
+};
+
+struct el_ir_lowerer
+{
+	struct el_ast * ast;
+	struct el_symbol_table const * symbols;
+	struct el_type_table const * types;
+	struct el_data_layout const * layout;
+	int flags;
+
+	// Register of each variable in the function declaring it, index of each global and index of each function
+	int * symbol_indices;
+
+	el_VECTOR_MEMBERS(struct el_ir_function_builder, functions);
+	int init_function;
+	el_VECTOR_MEMBERS(long long, int_constants);
+	el_VECTOR_MEMBERS(double, float_constants);
+	el_VECTOR_MEMBERS(el_string, strings);
+	el_VECTOR_MEMBERS(int, global_types);
+	el_VECTOR_MEMBERS(int, global_symbols);
+
+	struct el_ir_function_builder * function;
+	int current_block;
+
+	// Registers of the expressions lowered but not yet used by their parent
+	el_VECTOR_MEMBERS(int, values);
+
+	// Rhs of the dots being lowered, which name a field rather than a value
+	el_VECTOR_MEMBERS(struct el_ast_expression *, fields);
+
+	// For statements over soa slices being lowered, and the registers of their columns, el_IR_NO_REGISTER until first read
+	el_VECTOR_MEMBERS(struct el_soa_view, views);
+	el_VECTOR_MEMBERS(int, view_columns);
+
+	// Variables of the parallel for statements being lowered, those of the innermost from first_capture on
+	el_VECTOR_MEMBERS(struct el_ir_capture, captures);
+	struct el_ast_for_statement const * capturing; // Parallel for whose body capture_visitor is walking
+	int first_capture;
+
+	struct el_ast_visitor visitor;
+	struct el_ast_visitor capture_visitor;
+	int err;
+};
+
+static int el_prepare_lowering(struct el_ir_lowerer * l);
+static void el_lower_function(struct el_ir_lowerer * l, int function_index);
+static void el_lower_statements(struct el_ir_lowerer * l, struct el_ast_statement_list * list);
+static void el_lower_statement(struct el_ir_lowerer * l, struct el_ast_statement * statement);
+static void el_lower_assignment(struct el_ir_lowerer * l, struct el_ast_assignment * assignment);
+static void el_lower_if_statement(struct el_ir_lowerer * l, struct el_ast_if_statement * if_statement);
+static void el_lower_for_statement(struct el_ir_lowerer * l, struct el_ast_for_statement * for_statement);
+static void el_lower_loop(struct el_ir_lowerer * l, struct el_ast_for_statement * for_statement, int range, int first, int end);
+static void el_lower_parallel_for(struct el_ir_lowerer * l, struct el_ast_for_statement * for_statement);
+static int el_lower_chunk_function(struct el_ir_lowerer * l, struct el_ast_for_statement * for_statement);
+static void el_lower_combine(struct el_ir_lowerer * l, struct el_ast_for_statement const * for_statement, int num_chunks, int first_partial);
+static bool el_is_declared_in_loop(struct el_ir_lowerer const * l, struct el_ast_for_statement const * for_statement, int symbol);
+static int el_lower_expression(struct el_ir_lowerer * l, struct el_ast_expression * expression);
+static int el_binary_op(struct el_ast_expression const * e, bool * is_swapped);
+static void el_lower_kernel_call(struct el_ir_lowerer * l, struct el_vector_loop const * loop, int range, int length, int index);
+static void el_lower_kernel(struct el_ir_lowerer * l, struct el_ir_kernel_builder * kernel, struct el_vector_loop const * loop);
+static int el_lower_kernel_expression(struct el_ir_lowerer * l, struct el_ir_kernel_builder * kernel, struct el_vector_loop const * loop, struct el_ast_expression const * e);
+static int el_kernel_register(struct el_ir_lowerer * l, struct el_ir_kernel_builder * kernel, int type);
+static void el_kernel_emit(struct el_ir_lowerer * l, struct el_ir_kernel_builder * kernel, int op, int a, int b, int c);
+static int el_pack_module(struct el_ir_lowerer * l, struct el_ir_module * module);
+static void el_ir_lowerer_delete(struct el_ir_lowerer * l);
+
+static int el_new_register(struct el_ir_lowerer * l, int type);
+static int el_new_block(struct el_ir_lowerer * l);
+static void el_emit(struct el_ir_lowerer * l, int op, int a, int b, int c);
+static bool el_is_terminated(struct el_ir_lowerer const * l);
+static bool el_retarget_vector(struct el_ir_lowerer * l, int block, int first_instruction, int value, int reg);
+static void el_find_owned_vectors(struct el_ir_lowerer const * l, struct el_ir_function * function);
+static int el_variable_register(struct el_ir_lowerer * l, int symbol);
+static bool el_is_global(struct el_ir_lowerer const * l, int symbol);
+static int el_push_operands(struct el_ir_lowerer * l, int num_operands);
+static void el_push_value(struct el_ir_lowerer * l, int value);
+static int el_pop_value(struct el_ir_lowerer * l);
+static int el_checked_index(struct el_ir_lowerer * l, int index);
+static int el_int_constant(struct el_ir_lowerer * l, long long value);
+static int el_float_constant(struct el_ir_lowerer * l, double value);
+
+static int el_push_view(struct el_ir_lowerer * l, int symbol, int slice_type, int range, int index);
+static int el_find_view(struct el_ir_lowerer const * l, int symbol);
+static int el_view_column(struct el_ir_lowerer * l, int view, int field);
+static int el_soa_column(struct el_ir_lowerer * l, int slice_type, int slice, int field);
+static bool el_lower_soa_field(struct el_ir_lowerer * l, struct el_ast_expression * dot, int * column, int * index);
+static void el_gather_element(struct el_ir_lowerer * l, int slice_type, int slice, int view, int index, int value);
+static void el_scatter_element(struct el_ir_lowerer * l, int slice_type, int slice, int index, int value);
+
+static bool el_enter_dot(struct el_ast_expression * e, void * context);
+static void el_leave_number_literal(struct el_ast_expression * e, void * context);
+static void el_leave_string_literal(struct el_ast_expression * e, void * context);
+static void el_leave_identifier(struct el_ast_expression * e, void * context);
+static void el_leave_vector_type(struct el_ast_expression * e, void * context);
+static void el_leave_binary_op(struct el_ast_expression * e, void * context);
+static void el_leave_dot(struct el_ast_expression * e, void * context);
+static void el_leave_function_call(struct el_ast_expression * e, void * context);
+static int el_lower_vector(struct el_ir_lowerer * l, struct el_ast_expression const * call, int first_argument);
+static void el_leave_slice_index(struct el_ast_expression * e, void * context);
+static void el_leave_slice_literal(struct el_ast_expression * e, void * context);
+static void el_leave_arguments(struct el_ast_expression * e, void * context);
+static bool el_enter_captured_dot(struct el_ast_expression * e, void * context);
+static void el_leave_captured_identifier(struct el_ast_expression * e, void * context);
+
+static void * el_ir_alloc(struct el_linear_allocator * allocator, size_t num_bytes);
+static void * el_ir_alloc_copy(struct el_linear_allocator * allocator, void const * source, size_t num_bytes);
+static size_t el_ir_aligned_size(size_t num_bytes);
+
+int el_ir_lower(struct el_ir_module * module, struct el_ast * ast, struct el_symbol_table const * symbols, struct el_type_table const * types, int flags)
+{
+	assert(module && ast && symbols && types);
+	*module = (struct el_ir_module){ .types = types };
+	struct el_ir_lowerer l = { .ast = ast, .symbols = symbols, .types = types, .layout = &module->layout, .flags = flags, .err = el_SUCCESS };
+	int err = el_compute_data_layout(&module->layout, types);
+	err = err || el_prepare_lowering(&l);
+
+	// The chunk functions of parallel for statements are appended as they are lowered, after the init function
+	for(int i = 0; i <= l.init_function && err == 0; ++i)
+	{
+		el_lower_function(&l, i);
+		err = l.err;
+	}
+
+	err = err || el_pack_module(&l, module);
+	el_ir_lowerer_delete(&l);
+	if(err)
+	{
+		el_data_layout_delete(&module->layout);
+	}
+	if(err == el_ALLOCATION_ERROR)
+	{
+		fprintf(stderr, "Failed to allocate ir\n");
+	}
+	else if(err == el_EXCEEDED_IR_LIMIT_ERROR)
+	{
+		fprintf(stderr, "Failed to lower ir, a function has more than %d registers, blocks or operands\n", el_IR_MAX_INDEX);
+	}
+	return err;
+}
+
+// Number every function and global, s.t. calls and global accesses can be lowered in any order
+static int el_prepare_lowering(struct el_ir_lowerer * l)
+{
+	struct el_symbol_table const * symbols = l->symbols;
+	struct el_ast_statement_list * root = &l->ast->root;
+	l->symbol_indices = fmalloc(sizeof(int) * (symbols->num_symbols > 0 ? symbols->num_symbols : 1));
+	int * root_functions = fmalloc(sizeof(int) * (root->num_statements > 0 ? root->num_statements : 1));
+	if(!l->symbol_indices || !root_functions)
+	{
+		ffree(root_functions);
+		return el_ALLOCATION_ERROR;
+	}
+
+	// Functions are only declared at file scope
+	for(int i = 0; i < root->num_statements; ++i)
+	{
+		root_functions[i] = -1;
+		if(root->statements[i].type != el_AST_NODE_FUNCTION_DEFINITION)
+			continue;
+
+		struct el_ir_function_builder * function = el_vector_push(l, functions, NULL);
+		if(!function)
+		{
+			ffree(root_functions);
+			return el_ALLOCATION_ERROR;
+		}
+
+		struct el_ast_function_definition * definition = &root->statements[i].function_definition;
+		*function = (struct el_ir_function_builder){
+			.function.name = definition->name,
+			.function.symbol = el_NO_SYMBOL,
+			.function.return_type = definition->return_type.type_id,
+			.function.num_parameters = definition->parameter_list.num_parameters,
+			.function.outlined_from = -1,
+			.definition = definition
+		};
+		root_functions[i] = l->num_functions - 1;
+	}
+
+	struct el_ir_function_builder * init_function = el_vector_push(l, functions, NULL);
+	if(!init_function)
+	{
+		ffree(root_functions);
+		return el_ALLOCATION_ERROR;
+	}
+	*init_function = (struct el_ir_function_builder){
+		.function.name = NULL,
+		.function.symbol = el_NO_SYMBOL,
+		.function.return_type = el_VOID_TYPE_ID,
+		.function.num_parameters = 0,
+		.function.outlined_from = -1,
+		.definition = NULL
+	};
+	l->init_function = l->num_functions - 1;
+
+	for(int i = 0; i < symbols->num_symbols; ++i)
+	{
+		struct el_symbol const * symbol = &symbols->symbols[i];
+		l->symbol_indices[i] = -1;
+		if(symbol->kind == el_SYMBOL_FUNCTION)
+		{
+			// The definition is a member of a root statement, which gives the function's index
+			struct el_ast_statement const * statement = (void const *)((char const *)symbol->function_definition - offsetof(struct el_ast_statement, function_definition));
+			int function = root_functions[statement - root->statements];
+			l->symbol_indices[i] = function;
+			l->functions[function].function.symbol = i;
+		}
+		else if(el_is_global(l, i))
+		{
+			int * global_type = el_vector_push(l, global_types, NULL);
+			int * global_symbol = el_vector_push(l, global_symbols, NULL);
+			if(!global_type || !global_symbol)
+			{
+				ffree(root_functions);
+				return el_ALLOCATION_ERROR;
+			}
+			*global_type = symbol->type_id;
+			*global_symbol = i;
+			l->symbol_indices[i] = l->num_global_types - 1;
+		}
+	}
+	ffree(root_functions);
+
+	struct el_ast_visitor * visitor = &l->visitor;
+	visitor->context = l;
+	visitor->enter_expression[el_AST_EXPR_DOT] = el_enter_dot;
+	visitor->leave_expression[el_AST_EXPR_NUMBER_LITERAL] = el_leave_number_literal;
+	visitor->leave_expression[el_AST_EXPR_STRING_LITERAL] = el_leave_string_literal;
+	visitor->leave_expression[el_AST_EXPR_IDENTIFIER] = el_leave_identifier;
+	visitor->leave_expression[el_AST_EXPR_VECTOR_TYPE] = el_leave_vector_type;
+	for(int type = el_AST_EXPR_EQUALS; type <= el_AST_EXPR_DIV; ++type)
+	{
+		visitor->leave_expression[type] = el_leave_binary_op;
+	}
+	visitor->leave_expression[el_AST_EXPR_DOT] = el_leave_dot;
+	visitor->leave_expression[el_AST_EXPR_FUNCTION_CALL] = el_leave_function_call;
+	visitor->leave_expression[el_AST_EXPR_SLICE_INDEX] = el_leave_slice_index;
+	visitor->leave_expression[el_AST_EXPR_SLICE_LITERAL] = el_leave_slice_literal;
+	visitor->leave_expression[el_AST_EXPR_ARGUMENTS] = el_leave_arguments;
+
+	l->capture_visitor.context = l;
+	l->capture_visitor.enter_expression[el_AST_EXPR_DOT] = el_enter_captured_dot;
+	l->capture_visitor.leave_expression[el_AST_EXPR_IDENTIFIER] = el_leave_captured_identifier;
+	return el_SUCCESS;
+}
+
+// Lowering a parallel for appends to the functions, s.t. the function is referred to by index
+static void el_lower_function(struct el_ir_lowerer * l, int function_index)
+{
+	struct el_ast_function_definition * definition = l->functions[function_index].definition;
+	l->function = &l->functions[function_index];
+
+	// Parameters take the first registers, in order
+	for(int i = 0; definition && i < definition->parameter_list.num_parameters; ++i)
+	{
+		el_new_register(l, definition->parameter_list.parameters[i].type.type_id);
+	}
+
+	if(definition && !definition->is_code_block_parsed)
+	{
+		l->function = NULL;
+		return;
+	}
+
+	l->current_block = el_new_block(l);
+	if(definition)
+	{
+		el_lower_statements(l, &definition->code_block);
+	}
+	else
+	{
+		el_lower_statements(l, &l->ast->root);
+	}
+
+	if(!el_is_terminated(l))
+	{
+		el_emit(l, el_IR_RET_VOID, 0, 0, 0);
+	}
+	l->function = NULL;
+}
+
+static void el_lower_statements(struct el_ir_lowerer * l, struct el_ast_statement_list * list)
+{
+	for(int i = 0; i < list->num_statements && l->err == 0 && !el_is_terminated(l); ++i)
+	{
+		el_lower_statement(l, &list->statements[i]);
+	}
+}
+
+static void el_lower_statement(struct el_ir_lowerer * l, struct el_ast_statement * statement)
+{
+	switch(statement->type)
+	{
+	case el_AST_NODE_DATA_BLOCK:
+	case el_AST_NODE_FUNCTION_DEFINITION:
+		break;
+	case el_AST_NODE_FOR_STATEMENT:
+		el_lower_for_statement(l, &statement->for_statement);
+		break;
+	case el_AST_NODE_IF_STATEMENT:
+		el_lower_if_statement(l, &statement->if_statement);
+		break;
+	case el_AST_NODE_ASSIGNMENT:
+		el_lower_assignment(l, &statement->assignment);
+		break;
+	case el_AST_NODE_RETURN_STATEMENT:
+		el_emit(l, el_IR_RET, el_lower_expression(l, &statement->return_statement.expression), 0, 0);
+		break;
+	case el_AST_NODE_EXPRESSION:
+		el_lower_expression(l, &statement->expression);
+		break;
+	}
+}
+
+static void el_lower_assignment(struct el_ir_lowerer * l, struct el_ast_assignment * assignment)
+{
+	struct el_ast_expression * lhs = &assignment->lhs;
+	int column = 0;
+	int column_index = 0;
+	if(lhs->type == el_AST_EXPR_DOT && el_lower_soa_field(l, lhs, &column, &column_index))
+	{
+		int value = el_lower_expression(l, &assignment->rhs);
+		el_emit(l, el_IR_SET_ELEMENT, column, column_index, value);
+	}
+	else if(lhs->type == el_AST_EXPR_DOT)
+	{
+		int object = el_lower_expression(l, lhs->binary_op.lhs);
+		int value = el_lower_expression(l, &assignment->rhs);
+		el_emit(l, el_IR_SET_FIELD, object, lhs->binary_op.rhs->symbol, value);
+	}
+	else if(lhs->type == el_AST_EXPR_SLICE_INDEX)
+	{
+		int slice_type = lhs->binary_op.lhs->type_id;
+		int slice = el_lower_expression(l, lhs->binary_op.lhs);
+		int index = el_lower_expression(l, lhs->binary_op.rhs);
+		int value = el_lower_expression(l, &assignment->rhs);
+		if(el_get_layout(l->layout, slice_type)->is_soa)
+		{
+			el_scatter_element(l, slice_type, slice, index, value);
+		}
+		else
+		{
+			el_emit(l, el_IR_SET_ELEMENT, slice, index, value);
+		}
+	}
+	else
+	{
+		assert(lhs->type == el_AST_EXPR_IDENTIFIER);
+		int block = l->current_block;
+		int first_instruction = l->function->blocks[block].num_instructions;
+		int value = el_lower_expression(l, &assignment->rhs);
+		if(el_is_global(l, lhs->symbol))
+		{
+			el_emit(l, el_IR_STORE_GLOBAL, l->symbol_indices[lhs->symbol], value, 0);
+		}
+		else if(!el_retarget_vector(l, block, first_instruction, value, el_variable_register(l, lhs->symbol)))
+		{
+			el_emit(l, el_IR_MOVE, el_variable_register(l, lhs->symbol), value, 0);
+		}
+	}
+}
+
+static void el_lower_if_statement(struct el_ir_lowerer * l, struct el_ast_if_statement * if_statement)
+{
+	// Each condition branches to its body or on to the next condition, the last of which is the else body or the end
+	bool has_else = if_statement->else_statement != NULL;
+	int end_block = -1;
+	for(int i = -1; i < if_statement->num_elif_statements && l->err == 0; ++i)
+	{
+		struct el_ast_expression * condition = i < 0 ? &if_statement->expression : &if_statement->elif_statements[i].expression;
+		struct el_ast_statement_list * body = i < 0 ? &if_statement->code_block : &if_statement->elif_statements[i].code_block;
+		bool is_last = i + 1 == if_statement->num_elif_statements;
+
+		int value = el_lower_expression(l, condition);
+		int body_block = el_new_block(l);
+		int next_block = -1;
+		if(is_last && !has_else)
+		{
+			next_block = end_block >= 0 ? end_block : el_new_block(l);
+			end_block = next_block;
+		}
+		else
+		{
+			next_block = el_new_block(l);
+			end_block = end_block >= 0 ? end_block : el_new_block(l);
+		}
+		el_emit(l, el_IR_BRANCH, value, body_block, next_block);
+
+		l->current_block = body_block;
+		el_lower_statements(l, body);
+		if(!el_is_terminated(l))
+		{
+			el_emit(l, el_IR_JUMP, end_block, 0, 0);
+		}
+		l->current_block = next_block;
+	}
+
+	// Without an else the last condition falls through to the end
+	if(has_else && l->err == 0)
+	{
+		el_lower_statements(l, if_statement->else_statement);
+		if(!el_is_terminated(l))
+		{
+			el_emit(l, el_IR_JUMP, end_block, 0, 0);
+		}
+		l->current_block = end_block;
+	}
+}
+
+static void el_lower_for_statement(struct el_ir_lowerer * l, struct el_ast_for_statement * for_statement)
+{
+	if(for_statement->is_parallel)
+	{
+		el_lower_parallel_for(l, for_statement);
+		return;
+	}
+
+	// The range is read once, s.t. assigning to its variable in the body does not change the slice being iterated
+	int range = el_lower_expression(l, &for_statement->range);
+	if(for_statement->range.type == el_AST_EXPR_IDENTIFIER && !el_is_global(l, for_statement->range.symbol))
+	{
+		int copy = el_new_register(l, for_statement->range.type_id);
+		el_emit(l, el_IR_MOVE, copy, range, 0);
+		range = copy;
+	}
+	el_lower_loop(l, for_statement, range, el_IR_NO_REGISTER, el_IR_NO_REGISTER);
+}
+
+// Loop over elements [first, end) of range, or over every element if first is el_IR_NO_REGISTER
+static void el_lower_loop(struct el_ir_lowerer * l, struct el_ast_for_statement * for_statement, int range, int first, int end)
+{
+	// Columns of a soa slice are read before the loop, s.t. the block before it is only terminated once the body is lowered
+	// Every column has the slice's length
+	// Neither variable of a for statement can be assigned, s.t. the view is the element at the index throughout the body
+	bool is_soa = el_get_layout(l->layout, for_statement->range.type_id)->is_soa;
+	int index = el_variable_register(l, for_statement->index_symbol);
+	int value_symbol = for_statement->value_symbol != for_statement->index_symbol ? for_statement->value_symbol : el_NO_SYMBOL;
+	int view = is_soa ? el_push_view(l, value_symbol, for_statement->range.type_id, range, index) : -1;
+	int length = end;
+	if(first != el_IR_NO_REGISTER)
+	{
+		el_emit(l, el_IR_MOVE, index, first, 0);
+	}
+	else
+	{
+		length = el_new_register(l, el_INT_TYPE_ID);
+		el_emit(l, el_IR_LENGTH, length, is_soa ? el_view_column(l, view, 0) : range, 0);
+		el_emit(l, el_IR_LOAD_INT, index, el_int_constant(l, 0), 0);
+
+		// A vector loop's kernel runs first, the loop below continues from the first element it left
+		struct el_vector_loop loop;
+		if(!is_soa && !(l->flags & el_IR_LOWER_NO_KERNELS) && el_analyze_vector_loop(&loop, for_statement, l->symbols, l->types))
+		{
+			el_lower_kernel_call(l, &loop, range, length, index);
+		}
+	}
+
+	int preheader_block = l->current_block;
+	int header_block = el_new_block(l);
+	int body_block = el_new_block(l);
+	int exit_block = el_new_block(l);
+	if(!is_soa)
+	{
+		el_emit(l, el_IR_JUMP, header_block, 0, 0);
+	}
+
+	l->current_block = header_block;
+	int is_in_range = el_new_register(l, el_INT_TYPE_ID);
+	el_emit(l, el_IR_LT_INT, is_in_range, index, length);
+	el_emit(l, el_IR_BRANCH, is_in_range, body_block, exit_block);
+
+	l->current_block = body_block;
+	if(!is_soa && value_symbol != el_NO_SYMBOL)
+	{
+		el_emit(l, el_IR_GET_ELEMENT, el_variable_register(l, value_symbol), range, index);
+	}
+	el_lower_statements(l, &for_statement->code_block);
+	if(!el_is_terminated(l))
+	{
+		int step = el_new_register(l, el_INT_TYPE_ID);
+		el_emit(l, el_IR_LOAD_INT, step, el_int_constant(l, 1), 0);
+		el_emit(l, el_IR_ADD_INT, index, index, step);
+		el_emit(l, el_IR_JUMP, header_block, 0, 0);
+	}
+
+	if(is_soa && l->err == 0)
+	{
+		l->num_view_columns = l->views[view].first_column;
+		--l->num_views;
+		l->current_block = preheader_block;
+		el_emit(l, el_IR_JUMP, header_block, 0, 0);
+	}
+	l->current_block = exit_block;
+}
+
+// The body of a parallel for is outlined into a chunk function, which runs the loop over one chunk of the range
+// Each reduction has a slice with a slot for the partial result of each chunk, combined in chunk order once every chunk has run
+static void el_lower_parallel_for(struct el_ir_lowerer * l, struct el_ast_for_statement * for_statement)
+{
+	int range_type = for_statement->range.type_id;
+	int range = el_lower_expression(l, &for_statement->range);
+	int length = el_new_register(l, el_INT_TYPE_ID);
+	bool is_soa = el_get_layout(l->layout, range_type)->is_soa;
+	el_emit(l, el_IR_LENGTH, length, is_soa ? el_soa_column(l, range_type, range, 0) : range, 0);
+
+	// A chunk per element of a short range, otherwise the most chunks
+	int num_chunks = el_new_register(l, el_INT_TYPE_ID);
+	int max_num_chunks = el_new_register(l, el_INT_TYPE_ID);
+	int is_short = el_new_register(l, el_INT_TYPE_ID);
+	int long_block = el_new_block(l);
+	int chunks_block = el_new_block(l);
+	el_emit(l, el_IR_MOVE, num_chunks, length, 0);
+	el_emit(l, el_IR_LOAD_INT, max_num_chunks, el_int_constant(l, IR_MAX_NUM_CHUNKS), 0);
+	el_emit(l, el_IR_LT_INT, is_short, length, max_num_chunks);
+	el_emit(l, el_IR_BRANCH, is_short, chunks_block, long_block);
+	l->current_block = long_block;
+	el_emit(l, el_IR_MOVE, num_chunks, max_num_chunks, 0);
+	el_emit(l, el_IR_JUMP, chunks_block, 0, 0);
+	l->current_block = chunks_block;
+
+	// Reductions are captured first, followed by the variables the body reads which are declared outside of it
+	int first_capture = l->num_captures;
+	for(int i = 0; i < for_statement->num_reductions; ++i)
+	{
+		struct el_ir_capture * capture = l->err ? NULL : el_vector_push(l, captures, NULL);
+		if(!capture)
+		{
+			l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+			return;
+		}
+		int symbol = for_statement->reductions[i].symbol;
+		*capture = (struct el_ir_capture){ symbol, -1, el_variable_register(l, symbol), l->symbol_indices[symbol] };
+	}
+	struct el_ast_for_statement const * capturing = l->capturing;
+	int enclosing_first_capture = l->first_capture;
+	l->capturing = for_statement;
+	l->first_capture = first_capture;
+	int err = el_ast_visit_statements(&for_statement->code_block, &l->capture_visitor);
+	l->err = l->err ? l->err : err;
+	l->capturing = capturing;
+
+	int first_partial = l->num_values;
+	for(int i = 0; i < for_statement->num_reductions; ++i)
+	{
+		int partials_type = el_get_type(l->types, l->symbols->symbols[for_statement->reductions[i].symbol].type_id)->slice_type;
+		int partials = el_new_register(l, partials_type);
+		el_emit(l, el_IR_NEW_ZERO_SLICE, partials, num_chunks, 0);
+		el_push_value(l, partials);
+	}
+
+	int function = el_lower_chunk_function(l, for_statement);
+	l->first_capture = enclosing_first_capture;
+	if(l->err)
+		return;
+
+	// The chunk function's parameters after its first, end and chunk, see el_lower_chunk_function
+	int num_partials = for_statement->num_reductions;
+	el_push_value(l, length);
+	el_push_value(l, range);
+	for(int i = 0; i < num_partials; ++i)
+	{
+		el_push_value(l, l->values[first_partial + i]);
+	}
+	for(int i = first_capture; i < l->num_captures; ++i)
+	{
+		struct el_ir_capture const * capture = &l->captures[i];
+		if(capture->view >= 0)
+		{
+			el_push_value(l, l->views[capture->view].range);
+			el_push_value(l, l->views[capture->view].index);
+		}
+		else
+		{
+			el_push_value(l, capture->outer_register);
+		}
+	}
+	int operands = el_push_operands(l, l->functions[function].function.num_parameters - 2);
+	el_emit(l, el_IR_PARALLEL_FOR, num_chunks, function, operands);
+	l->num_captures = first_capture;
+
+	el_lower_combine(l, for_statement, num_chunks, first_partial);
+	l->num_values = first_partial;
+}
+
+// Returns the index of a function running the loop of for_statement over one chunk of its range, taking the parameters
+// first, end, chunk, range, the slice of partial results of each reduction, the value of each reduction before the loop,
+// then the variables captured from the enclosing function
+// Sums start from zero in each chunk, minimums and maximums from the value before the loop
+static int el_lower_chunk_function(struct el_ir_lowerer * l, struct el_ast_for_statement * for_statement)
+{
+	int enclosing = (int)(l->function - l->functions);
+	int enclosing_block = l->current_block;
+	int num_views = l->num_views;
+	int num_view_columns = l->num_view_columns;
+	int first_capture = l->first_capture;
+	int function_index = el_checked_index(l, l->num_functions);
+	struct el_ir_function_builder * function = l->err ? NULL : el_vector_push(l, functions, NULL);
+	if(!function)
+	{
+		l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+		return 0;
+	}
+	*function = (struct el_ir_function_builder){
+		.function.name = l->functions[enclosing].function.name,
+		.function.symbol = el_NO_SYMBOL,
+		.function.return_type = el_VOID_TYPE_ID,
+		.function.outlined_from = enclosing,
+		.definition = NULL
+	};
+	l->function = function;
+
+	// The entry block stays open for the columns of captured views, jumping to the loop once it is lowered
+	int entry_block = el_new_block(l);
+	l->current_block = entry_block;
+
+	int first = el_new_register(l, el_INT_TYPE_ID);
+	int end = el_new_register(l, el_INT_TYPE_ID);
+	int chunk = el_new_register(l, el_INT_TYPE_ID);
+	int range = el_new_register(l, for_statement->range.type_id);
+	int num_reductions = for_statement->num_reductions;
+	int first_partial = l->function->num_register_types;
+	for(int i = 0; i < num_reductions; ++i)
+	{
+		int type = l->symbols->symbols[for_statement->reductions[i].symbol].type_id;
+		el_new_register(l, el_get_type(l->types, type)->slice_type);
+	}
+	int first_initial = l->function->num_register_types;
+	for(int i = 0; i < num_reductions; ++i)
+	{
+		el_new_register(l, l->symbols->symbols[for_statement->reductions[i].symbol].type_id);
+	}
+
+	// Captured variables become parameters, a captured view is given its range and index and viewed again
+	for(int i = first_capture + num_reductions; i < l->num_captures && l->err == 0; ++i)
+	{
+		struct el_ir_capture * capture = &l->captures[i];
+		capture->saved_index = l->symbol_indices[capture->symbol];
+		if(capture->view >= 0)
+		{
+			int slice_type = l->views[capture->view].slice_type;
+			int view_range = el_new_register(l, slice_type);
+			int view_index = el_new_register(l, el_INT_TYPE_ID);
+			el_push_view(l, capture->symbol, slice_type, view_range, view_index);
+		}
+		else
+		{
+			l->symbol_indices[capture->symbol] = el_new_register(l, l->symbols->symbols[capture->symbol].type_id);
+		}
+	}
+	l->function->function.num_parameters = l->function->num_register_types;
+
+	for(int i = 0; i < num_reductions; ++i)
+	{
+		struct el_ast_reduction const * reduction = &for_statement->reductions[i];
+		struct el_ir_capture * capture = &l->captures[first_capture + i];
+		int type = l->symbols->symbols[reduction->symbol].type_id;
+		int accumulator = el_new_register(l, type);
+		capture->saved_index = l->symbol_indices[reduction->symbol];
+		l->symbol_indices[reduction->symbol] = accumulator;
+		if(reduction->type != el_AST_REDUCE_SUM)
+		{
+			el_emit(l, el_IR_MOVE, accumulator, first_initial + i, 0);
+		}
+		else if(type == el_FLOAT_TYPE_ID)
+		{
+			el_emit(l, el_IR_LOAD_FLOAT, accumulator, el_float_constant(l, 0.0), 0);
+		}
+		else
+		{
+			el_emit(l, el_IR_LOAD_INT, accumulator, el_int_constant(l, 0), 0);
+		}
+	}
+	int loop_block = el_new_block(l);
+	l->current_block = loop_block;
+	el_lower_loop(l, for_statement, range, first, end);
+	for(int i = 0; i < num_reductions; ++i)
+	{
+		el_emit(l, el_IR_SET_ELEMENT, first_partial + i, chunk, l->symbol_indices[for_statement->reductions[i].symbol]);
+	}
+	el_emit(l, el_IR_RET_VOID, 0, 0, 0);
+	l->current_block = entry_block;
+	el_emit(l, el_IR_JUMP, loop_block, 0, 0);
+
+	for(int i = first_capture; i < l->num_captures; ++i)
+	{
+		if(i < first_capture + num_reductions || l->captures[i].view < 0)
+		{
+			l->symbol_indices[l->captures[i].symbol] = l->captures[i].saved_index;
+		}
+	}
+	l->num_views = num_views;
+	l->num_view_columns = num_view_columns;
+	l->function = &l->functions[enclosing];
+	l->current_block = enclosing_block;
+	return function_index;
+}
+
+// Fold the partial results of each chunk into the reductions, in chunk order s.t. float sums are the same on every run
+static void el_lower_combine(struct el_ir_lowerer * l, struct el_ast_for_statement const * for_statement, int num_chunks, int first_partial)
+{
+	int k = el_new_register(l, el_INT_TYPE_ID);
+	int step = el_new_register(l, el_INT_TYPE_ID);
+	el_emit(l, el_IR_LOAD_INT, k, el_int_constant(l, 0), 0);
+	el_emit(l, el_IR_LOAD_INT, step, el_int_constant(l, 1), 0);
+	int header_block = el_new_block(l);
+	int body_block = el_new_block(l);
+	int exit_block = el_new_block(l);
+	el_emit(l, el_IR_JUMP, header_block, 0, 0);
+
+	l->current_block = header_block;
+	int is_in_range = el_new_register(l, el_INT_TYPE_ID);
+	el_emit(l, el_IR_LT_INT, is_in_range, k, num_chunks);
+	el_emit(l, el_IR_BRANCH, is_in_range, body_block, exit_block);
+
+	l->current_block = body_block;
+	for(int i = 0; i < for_statement->num_reductions && l->err == 0; ++i)
+	{
+		struct el_ast_reduction const * reduction = &for_statement->reductions[i];
+		int type = l->symbols->symbols[reduction->symbol].type_id;
+		bool is_float = type == el_FLOAT_TYPE_ID;
+		int accumulator = el_variable_register(l, reduction->symbol);
+		int partial = el_new_register(l, type);
+		el_emit(l, el_IR_GET_ELEMENT, partial, l->values[first_partial + i], k);
+		if(reduction->type == el_AST_REDUCE_SUM)
+		{
+			el_emit(l, is_float ? el_IR_ADD_FLOAT : el_IR_ADD_INT, accumulator, accumulator, partial);
+			continue;
+		}
+
+		// The partial replaces the accumulator if it is less than it for a minimum, greater than it for a maximum
+		int is_better = el_new_register(l, el_INT_TYPE_ID);
+		int better_block = el_new_block(l);
+		int next_block = el_new_block(l);
+		bool is_min = reduction->type == el_AST_REDUCE_MIN;
+		el_emit(l, is_float ? el_IR_LT_FLOAT : el_IR_LT_INT, is_better, is_min ? partial : accumulator, is_min ? accumulator : partial);
+		el_emit(l, el_IR_BRANCH, is_better, better_block, next_block);
+		l->current_block = better_block;
+		el_emit(l, el_IR_MOVE, accumulator, partial, 0);
+		el_emit(l, el_IR_JUMP, next_block, 0, 0);
+		l->current_block = next_block;
+	}
+	el_emit(l, el_IR_ADD_INT, k, k, step);
+	el_emit(l, el_IR_JUMP, header_block, 0, 0);
+	l->current_block = exit_block;
+}
+
+// Returns true if symbol is declared in the body of for_statement, including its index and value variables
+static bool el_is_declared_in_loop(struct el_ir_lowerer const * l, struct el_ast_for_statement const * for_statement, int symbol)
+{
+	struct el_symbol_table const * symbols = l->symbols;
+	int loop_scope = symbols->symbols[for_statement->index_symbol].scope;
+	for(int scope = symbols->symbols[symbol].scope; scope >= 0; scope = symbols->scopes[scope].parent)
+	{
+		if(scope == loop_scope)
+			return true;
+	}
+	return false;
+}
+
+// Returns the register holding the expression's value, or el_IR_NO_REGISTER if it has none
+static int el_lower_expression(struct el_ir_lowerer * l, struct el_ast_expression * expression)
+{
+	int num_values = l->num_values;
+	int err = el_ast_visit_expression(expression, &l->visitor);
+	l->err = l->err ? l->err : err;
+	if(l->err)
+	{
+		l->num_values = num_values;
+		return el_IR_NO_REGISTER;
+	}
+
+	assert(l->num_values == num_values + 1);
+	return el_pop_value(l);
+}
+
+// Run the loop's kernel in the block before the loop if every slice it indexes is at least as long as the range
+// Otherwise the loop runs alone and reports the first element out of bounds as it would without a kernel
+static void el_lower_kernel_call(struct el_ir_lowerer * l, struct el_vector_loop const * loop, int range, int length, int index)
+{
+	struct el_ir_function_builder * function = l->function;
+	int kernel_index = el_checked_index(l, function->num_kernels);
+	struct el_ir_kernel_builder * kernel = l->err ? NULL : el_vector_push(function, kernels, NULL);
+	if(!kernel)
+	{
+		l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+		return;
+	}
+	*kernel = (struct el_ir_kernel_builder){ .num_arguments = 1 + loop->num_arguments };
+
+	// Globals are read once, the body assigns no variable
+	el_push_value(l, length);
+	el_push_value(l, range);
+	int fits = el_IR_NO_REGISTER;
+	for(int i = 0; i < loop->num_arguments; ++i)
+	{
+		int symbol = loop->arguments[i];
+		int type = l->symbols->symbols[symbol].type_id;
+		int argument = el_IR_NO_REGISTER;
+		if(el_is_global(l, symbol))
+		{
+			argument = el_new_register(l, type);
+			el_emit(l, el_IR_LOAD_GLOBAL, argument, l->symbol_indices[symbol], 0);
+		}
+		else
+		{
+			argument = el_variable_register(l, symbol);
+		}
+		el_push_value(l, argument);
+		if(el_get_type(l->types, type)->kind != el_TYPE_SLICE)
+			continue;
+
+		int argument_length = el_new_register(l, el_INT_TYPE_ID);
+		int argument_fits = el_new_register(l, el_INT_TYPE_ID);
+		el_emit(l, el_IR_LENGTH, argument_length, argument, 0);
+		el_emit(l, el_IR_LE_INT, argument_fits, length, argument_length);
+		if(fits != el_IR_NO_REGISTER)
+		{
+			int all_fit = el_new_register(l, el_INT_TYPE_ID);
+			el_emit(l, el_IR_AND, all_fit, fits, argument_fits);
+			argument_fits = all_fit;
+		}
+		fits = argument_fits;
+	}
+	int operands = el_push_operands(l, 2 + loop->num_arguments);
+	el_lower_kernel(l, kernel, loop);
+
+	int kernel_block = fits != el_IR_NO_REGISTER ? el_new_block(l) : l->current_block;
+	int loop_block = fits != el_IR_NO_REGISTER ? el_new_block(l) : l->current_block;
+	if(fits != el_IR_NO_REGISTER)
+	{
+		el_emit(l, el_IR_BRANCH, fits, kernel_block, loop_block);
+		l->current_block = kernel_block;
+	}
+	el_emit(l, el_IR_KERNEL, index, kernel_index, operands);
+	if(fits != el_IR_NO_REGISTER)
+	{
+		el_emit(l, el_IR_JUMP, loop_block, 0, 0);
+		l->current_block = loop_block;
+	}
+}
+
+static void el_lower_kernel(struct el_ir_lowerer * l, struct el_ir_kernel_builder * kernel, struct el_vector_loop const * loop)
+{
+	struct el_ast_for_statement const * for_statement = loop->for_statement;
+	el_kernel_register(l, kernel, for_statement->range.type_id);
+	for(int i = 0; i < loop->num_arguments; ++i)
+	{
+		el_kernel_register(l, kernel, l->symbols->symbols[loop->arguments[i]].type_id);
+	}
+	int index = el_kernel_register(l, kernel, el_INT_TYPE_ID);
+	if(loop->reads_value)
+	{
+		int value = el_kernel_register(l, kernel, l->symbols->symbols[for_statement->value_symbol].type_id);
+		el_kernel_emit(l, kernel, el_IR_GET_ELEMENT, value, 0, index);
+	}
+
+	struct el_ast_statement_list const * body = &for_statement->code_block;
+	for(int i = 0; i < body->num_statements && l->err == 0; ++i)
+	{
+		struct el_ast_assignment const * assignment = &body->statements[i].assignment;
+		int value = el_lower_kernel_expression(l, kernel, loop, &assignment->rhs);
+		int slice = el_lower_kernel_expression(l, kernel, loop, assignment->lhs.binary_op.lhs);
+		el_kernel_emit(l, kernel, el_IR_SET_ELEMENT, slice, index, value);
+	}
+}
+
+// Returns the kernel register holding e's value, recursing at most el_VECTOR_LOOP_MAX_EXPRESSIONS deep
+static int el_lower_kernel_expression(struct el_ir_lowerer * l, struct el_ir_kernel_builder * kernel, struct el_vector_loop const * loop, struct el_ast_expression const * e)
+{
+	struct el_ast_for_statement const * for_statement = loop->for_statement;
+	int index = kernel->num_arguments;
+	switch(e->type)
+	{
+	case el_AST_EXPR_NUMBER_LITERAL:
+	{
+		int value = el_kernel_register(l, kernel, e->type_id);
+		if(e->type_id == el_FLOAT_TYPE_ID)
+		{
+			el_kernel_emit(l, kernel, el_IR_LOAD_FLOAT, value, el_float_constant(l, e->float_value), 0);
+		}
+		else
+		{
+			el_kernel_emit(l, kernel, el_IR_LOAD_INT, value, el_int_constant(l, e->int_value), 0);
+		}
+		return value;
+	}
+	case el_AST_EXPR_IDENTIFIER:
+		if(e->symbol == for_statement->index_symbol)
+			return index;
+		if(e->symbol == for_statement->value_symbol)
+			return index + 1;
+		for(int i = 0; i < loop->num_arguments; ++i)
+		{
+			if(loop->arguments[i] == e->symbol)
+				return 1 + i;
+		}
+		assert(false);
+		return el_IR_NO_REGISTER;
+	case el_AST_EXPR_SLICE_INDEX:
+	{
+		int slice = el_lower_kernel_expression(l, kernel, loop, e->binary_op.lhs);
+		int value = el_kernel_register(l, kernel, e->type_id);
+		el_kernel_emit(l, kernel, el_IR_GET_ELEMENT, value, slice, index);
+		return value;
+	}
+	default:
+	{
+		int lhs = el_lower_kernel_expression(l, kernel, loop, e->binary_op.lhs);
+		int rhs = el_lower_kernel_expression(l, kernel, loop, e->binary_op.rhs);
+		bool is_swapped = false;
+		int op = el_binary_op(e, &is_swapped);
+		int value = el_kernel_register(l, kernel, e->type_id);
+		el_kernel_emit(l, kernel, op, value, is_swapped ? rhs : lhs, is_swapped ? lhs : rhs);
+		return value;
+	}
+	}
+}
+
+static int el_kernel_register(struct el_ir_lowerer * l, struct el_ir_kernel_builder * kernel, int type)
+{
+	if(l->err || el_checked_index(l, kernel->num_register_types) < 0)
+		return el_IR_NO_REGISTER;
+
+	int * register_type = el_vector_push(kernel, register_types, NULL);
+	if(!register_type)
+	{
+		l->err = el_ALLOCATION_ERROR;
+		return el_IR_NO_REGISTER;
+	}
+	*register_type = type;
+	return kernel->num_register_types - 1;
+}
+
+static void el_kernel_emit(struct el_ir_lowerer * l, struct el_ir_kernel_builder * kernel, int op, int a, int b, int c)
+{
+	struct el_ir_instruction * instruction = l->err ? NULL : el_vector_push(kernel, instructions, NULL);
+	if(!instruction)
+	{
+		l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+		return;
+	}
+	*instruction = (struct el_ir_instruction){ (uint16_t)op, (uint16_t)a, (uint16_t)b, (uint16_t)c };
+}
+
+// Move each function's vectors into the module's allocator
+static int el_pack_module(struct el_ir_lowerer * l, struct el_ir_module * module)
+{
+	size_t size = el_ir_aligned_size(sizeof(struct el_ir_function) * l->num_functions)
+		+ el_ir_aligned_size(sizeof(long long) * l->num_int_constants)
+		+ el_ir_aligned_size(sizeof(double) * l->num_float_constants)
+		+ el_ir_aligned_size(sizeof(el_string) * l->num_strings)
+		+ 2 * el_ir_aligned_size(sizeof(int) * l->num_global_types);
+	for(int i = 0; i < l->num_strings; ++i)
+	{
+		size += el_ir_aligned_size(el_string_byte_size(l->strings[i]));
+	}
+	for(int i = 0; i < l->num_functions; ++i)
+	{
+		struct el_ir_function_builder const * function = &l->functions[i];
+		int num_instructions = 0;
+		for(int j = 0; j < function->num_blocks; ++j)
+		{
+			num_instructions += function->blocks[j].num_instructions;
+		}
+		size += el_ir_aligned_size(sizeof(struct el_ir_block) * function->num_blocks)
+			+ el_ir_aligned_size(sizeof(struct el_ir_instruction) * num_instructions)
+			+ el_ir_aligned_size(sizeof(int) * function->num_register_types)
+			+ el_ir_aligned_size(sizeof(bool) * function->num_register_types)
+			+ el_ir_aligned_size(sizeof(uint16_t) * function->num_operands)
+			+ el_ir_aligned_size(sizeof(struct el_ir_kernel) * function->num_kernels);
+		for(int j = 0; j < function->num_kernels; ++j)
+		{
+			size += el_ir_aligned_size(sizeof(struct el_ir_instruction) * function->kernels[j].num_instructions)
+				+ el_ir_aligned_size(sizeof(int) * function->kernels[j].num_register_types);
+		}
+	}
+
+	struct el_linear_allocator * allocator = &module->allocator;
+	allocator->memory = fmalloc(size > 0 ? size : 1);
+	allocator->capacity = size;
+	allocator->size = 0;
+	if(!allocator->memory)
+		return el_ALLOCATION_ERROR;
+
+	module->num_functions = l->num_functions;
+	module->init_function = l->init_function;
+	module->functions = el_ir_alloc(allocator, sizeof(struct el_ir_function) * l->num_functions);
+	for(int i = 0; i < l->num_functions; ++i)
+	{
+		struct el_ir_function_builder const * builder = &l->functions[i];
+		struct el_ir_function * function = &module->functions[i];
+		*function = builder->function;
+		function->num_blocks = builder->num_blocks;
+		function->blocks = el_ir_alloc(allocator, sizeof(struct el_ir_block) * builder->num_blocks);
+		for(int j = 0; j < builder->num_blocks; ++j)
+		{
+			function->blocks[j].first_instruction = function->num_instructions;
+			function->blocks[j].num_instructions = builder->blocks[j].num_instructions;
+			function->num_instructions += builder->blocks[j].num_instructions;
+		}
+
+		function->instructions = el_ir_alloc(allocator, sizeof(struct el_ir_instruction) * function->num_instructions);
+		for(int j = 0; j < builder->num_blocks; ++j)
+		{
+			if(builder->blocks[j].num_instructions > 0)
+			{
+				memcpy(&function->instructions[function->blocks[j].first_instruction], builder->blocks[j].instructions, sizeof(struct el_ir_instruction) * builder->blocks[j].num_instructions);
+			}
+		}
+
+		function->num_registers = builder->num_register_types;
+		function->register_types = el_ir_alloc_copy(allocator, builder->register_types, sizeof(int) * builder->num_register_types);
+		function->num_operands = builder->num_operands;
+		function->operands = el_ir_alloc_copy(allocator, builder->operands, sizeof(uint16_t) * builder->num_operands);
+
+		function->num_kernels = builder->num_kernels;
+		function->kernels = el_ir_alloc(allocator, sizeof(struct el_ir_kernel) * builder->num_kernels);
+		for(int j = 0; j < builder->num_kernels; ++j)
+		{
+			struct el_ir_kernel_builder const * kernel_builder = &builder->kernels[j];
+			struct el_ir_kernel * kernel = &function->kernels[j];
+			kernel->num_arguments = kernel_builder->num_arguments;
+			kernel->num_instructions = kernel_builder->num_instructions;
+			kernel->instructions = el_ir_alloc_copy(allocator, kernel_builder->instructions, sizeof(struct el_ir_instruction) * kernel_builder->num_instructions);
+			kernel->num_registers = kernel_builder->num_register_types;
+			kernel->register_types = el_ir_alloc_copy(allocator, kernel_builder->register_types, sizeof(int) * kernel_builder->num_register_types);
+		}
+
+		function->owned_vectors = el_ir_alloc(allocator, sizeof(bool) * builder->num_register_types);
+		el_find_owned_vectors(l, function);
+	}
+
+	module->num_int_constants = l->num_int_constants;
+	module->int_constants = el_ir_alloc_copy(allocator, l->int_constants, sizeof(long long) * l->num_int_constants);
+	module->num_float_constants = l->num_float_constants;
+	module->float_constants = el_ir_alloc_copy(allocator, l->float_constants, sizeof(double) * l->num_float_constants);
+
+	// Strings are copied s.t. the module does not depend on the ast
+	module->num_strings = l->num_strings;
+	module->strings = el_ir_alloc(allocator, sizeof(el_string) * l->num_strings);
+	for(int i = 0; i < l->num_strings; ++i)
+	{
+		int byte_size = el_string_byte_size(l->strings[i]);
+		char * dst = el_ir_alloc(allocator, byte_size);
+		module->strings[i] = el_string_inplace_new(dst, byte_size, l->strings[i], el_string_length(l->strings[i]));
+	}
+
+	module->num_globals = l->num_global_types;
+	module->global_types = el_ir_alloc_copy(allocator, l->global_types, sizeof(int) * l->num_global_types);
+	module->global_symbols = el_ir_alloc_copy(allocator, l->global_symbols, sizeof(int) * l->num_global_symbols);
+	assert(allocator->size == allocator->capacity);
+	return el_SUCCESS;
+}
+
+static void el_ir_lowerer_delete(struct el_ir_lowerer * l)
+{
+	for(int i = 0; i < l->num_functions; ++i)
+	{
+		struct el_ir_function_builder * function = &l->functions[i];
+		for(int j = 0; j < function->num_blocks; ++j)
+		{
+			el_vector_free(&function->blocks[j], instructions, NULL);
+		}
+		el_vector_free(function, blocks, NULL);
+		el_vector_free(function, register_types, NULL);
+		el_vector_free(function, operands, NULL);
+		for(int j = 0; j < function->num_kernels; ++j)
+		{
+			el_vector_free(&function->kernels[j], instructions, NULL);
+			el_vector_free(&function->kernels[j], register_types, NULL);
+		}
+		el_vector_free(function, kernels, NULL);
+	}
+	el_vector_free(l, functions, NULL);
+	el_vector_free(l, int_constants, NULL);
+	el_vector_free(l, float_constants, NULL);
+	el_vector_free(l, strings, NULL);
+	el_vector_free(l, global_types, NULL);
+	el_vector_free(l, global_symbols, NULL);
+	el_vector_free(l, values, NULL);
+	el_vector_free(l, fields, NULL);
+	el_vector_free(l, views, NULL);
+	el_vector_free(l, view_columns, NULL);
+	el_vector_free(l, captures, NULL);
+	ffree(l->symbol_indices);
+}
+
+static int el_new_register(struct el_ir_lowerer * l, int type)
+{
+	if(l->err || el_checked_index(l, l->function->num_register_types) < 0)
+		return el_IR_NO_REGISTER;
+
+	int * register_type = el_vector_push(l->function, register_types, NULL);
+	if(!register_type)
+	{
+		l->err = el_ALLOCATION_ERROR;
+		return el_IR_NO_REGISTER;
+	}
+	*register_type = type;
+	return l->function->num_register_types - 1;
+}
+
+static int el_new_block(struct el_ir_lowerer * l)
+{
+	if(l->err || el_checked_index(l, l->function->num_blocks) < 0)
+		return 0;
+
+	struct el_ir_block_builder * block = el_vector_push(l->function, blocks, NULL);
+	if(!block)
+	{
+		l->err = el_ALLOCATION_ERROR;
+		return 0;
+	}
+	*block = (struct el_ir_block_builder){ 0 };
+	return l->function->num_blocks - 1;
+}
+
+static void el_emit(struct el_ir_lowerer * l, int op, int a, int b, int c)
+{
+	if(l->err)
+		return;
+
+	struct el_ir_block_builder * block = &l->function->blocks[l->current_block];
+	assert(!el_is_terminated(l));
+	struct el_ir_instruction * instruction = el_vector_push(block, instructions, NULL);
+	if(!instruction)
+	{
+		l->err = el_ALLOCATION_ERROR;
+		return;
+	}
+	*instruction = (struct el_ir_instruction){ (uint16_t)op, (uint16_t)a, (uint16_t)b, (uint16_t)c };
+}
+
+static bool el_is_terminated(struct el_ir_lowerer const * l)
+{
+	struct el_ir_block_builder const * block = &l->function->blocks[l->current_block];
+	return block->num_instructions > 0 && el_ir_is_terminator(block->instructions[block->num_instructions - 1].op);
+}
+
+// Registers of locals are created on their first use, parameters already have theirs
+// A chunk function maps the variables it captures, parameters among them, to its own parameters in symbol_indices
+// If value is a vector built by the last instruction, which the block has gained since first_instruction, build it in reg instead
+// The variable's register is then written by the op rather than a move, s.t. it may own its block, see owned_vectors
+static bool el_retarget_vector(struct el_ir_lowerer * l, int block, int first_instruction, int value, int reg)
+{
+	struct el_ir_block_builder * builder = &l->function->blocks[block];
+	if(l->err || reg == el_IR_NO_REGISTER || l->current_block != block || builder->num_instructions <= first_instruction)
+		return false;
+
+	struct el_ir_instruction * last = &builder->instructions[builder->num_instructions - 1];
+	if(last->a != value || !el_ir_builds_vector(last->op))
+		return false;
+
+	last->a = reg;
+	return true;
+}
+
+// Every write of an owned register builds a vector in it, and every read only looks at its lanes
+// Registers passed in, moved, stored, returned or passed on may share their block, as may parameters, whose blocks are the caller's
+static void el_find_owned_vectors(struct el_ir_lowerer const * l, struct el_ir_function * function)
+{
+	for(int r = 0; r < function->num_registers; ++r)
+	{
+		function->owned_vectors[r] = r >= function->num_parameters && el_get_type(l->types, function->register_types[r])->kind == el_TYPE_VECTOR;
+	}
+	for(int i = 0; i < function->num_instructions; ++i)
+	{
+		struct el_ir_instruction const * in = &function->instructions[i];
+		struct el_ir_op_info const * info = el_ir_op_info(in->op);
+		uint16_t const values[3] = { in->a, in->b, in->c };
+		bool is_lane_read = el_ir_builds_vector(in->op) || in->op == el_IR_GET_LANE;
+		for(int j = 0; j < 3; ++j)
+		{
+			if(info->operand_kinds[j] != el_IR_OPERAND_REGISTER || values[j] == el_IR_NO_REGISTER)
+				continue;
+
+			bool is_write = j == 0 && info->writes_a;
+			if(is_write ? !el_ir_builds_vector(in->op) : !is_lane_read)
+			{
+				function->owned_vectors[values[j]] = false;
+			}
+		}
+
+		int num_list = 0;
+		if(in->op == el_IR_CALL)
+		{
+			num_list = l->functions[in->b].function.num_parameters;
+		}
+		else if(in->op == el_IR_NEW_SLICE || in->op == el_IR_NEW_VECTOR)
+		{
+			num_list = in->b;
+		}
+		else if(in->op == el_IR_KERNEL)
+		{
+			num_list = 1 + function->kernels[in->b].num_arguments;
+		}
+		else if(in->op == el_IR_PARALLEL_FOR)
+		{
+			num_list = l->functions[in->b].function.num_parameters - 2;
+		}
+		for(int j = 0; j < num_list; ++j)
+		{
+			function->owned_vectors[function->operands[in->c + j]] = false;
+		}
+	}
+}
+
+static int el_variable_register(struct el_ir_lowerer * l, int symbol)
+{
+	struct el_symbol const * s = &l->symbols->symbols[symbol];
+	if(s->kind == el_SYMBOL_PARAMETER && l->symbol_indices[symbol] < 0)
+		return (int)(s->parameter - l->function->definition->parameter_list.parameters);
+
+	if(l->symbol_indices[symbol] < 0)
+	{
+		l->symbol_indices[symbol] = el_new_register(l, s->type_id);
+	}
+	return l->symbol_indices[symbol];
+}
+
+static bool el_is_global(struct el_ir_lowerer const * l, int symbol)
+{
+	struct el_symbol const * s = &l->symbols->symbols[symbol];
+	return s->kind == el_SYMBOL_VARIABLE && l->symbols->scopes[s->scope].kind == el_SCOPE_FILE;
+}
+
+// Move the top num_operands values to the function's operands, returns the index of the first
+static int el_push_operands(struct el_ir_lowerer * l, int num_operands)
+{
+	struct el_ir_function_builder * function = l->function;
+	int first_operand = function->num_operands;
+	if(l->err || el_checked_index(l, first_operand + num_operands) < 0)
+		return 0;
+
+	if(!el_vector_reserve(function, operands, first_operand + num_operands, NULL))
+	{
+		l->err = el_ALLOCATION_ERROR;
+		return 0;
+	}
+	for(int i = 0; i < num_operands; ++i)
+	{
+		function->operands[first_operand + i] = (uint16_t)l->values[l->num_values - num_operands + i];
+	}
+	function->num_operands += num_operands;
+	l->num_values -= num_operands;
+	return first_operand;
+}
+
+static void el_push_value(struct el_ir_lowerer * l, int value)
+{
+	int * pushed = el_vector_push(l, values, NULL);
+	if(!pushed)
+	{
+		l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+		return;
+	}
+	*pushed = value;
+}
+
+static int el_pop_value(struct el_ir_lowerer * l)
+{
+	// Values are only missing once lowering has failed
+	return l->num_values > 0 ? l->values[--l->num_values] : el_IR_NO_REGISTER;
+}
+
+// Returns index, or -1 if it does not fit in an operand
+static int el_checked_index(struct el_ir_lowerer * l, int index)
+{
+	if(index <= el_IR_MAX_INDEX)
+		return index;
+
+	l->err = l->err ? l->err : el_EXCEEDED_IR_LIMIT_ERROR;
+	return -1;
+}
+
+// Each returns the index of a new constant holding value
+static int el_int_constant(struct el_ir_lowerer * l, long long value)
+{
+	int constant = el_checked_index(l, l->num_int_constants);
+	long long * pushed = l->err ? NULL : el_vector_push(l, int_constants, NULL);
+	if(!pushed)
+	{
+		l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+		return 0;
+	}
+	*pushed = value;
+	return constant;
+}
+
+static int el_float_constant(struct el_ir_lowerer * l, double value)
+{
+	int constant = el_checked_index(l, l->num_float_constants);
+	double * pushed = l->err ? NULL : el_vector_push(l, float_constants, NULL);
+	if(!pushed)
+	{
+		l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+		return 0;
+	}
+	*pushed = value;
+	return constant;
+}
+
+// Returns the index of a view of the element at index of the soa slice range, or -1 if lowering has failed
+// symbol is the variable the view stands for, el_NO_SYMBOL if there is none
+static int el_push_view(struct el_ir_lowerer * l, int symbol, int slice_type, int range, int index)
+{
+	int num_fields = el_get_layout(l->layout, slice_type)->num_fields;
+	int first_column = l->num_view_columns;
+	struct el_soa_view * view = l->err ? NULL : el_vector_push(l, views, NULL);
+	if(!view || !el_vector_reserve(l, view_columns, first_column + num_fields, NULL))
+	{
+		l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+		return -1;
+	}
+	for(int i = 0; i < num_fields; ++i)
+	{
+		l->view_columns[first_column + i] = el_IR_NO_REGISTER;
+	}
+	l->num_view_columns += num_fields;
+
+	*view = (struct el_soa_view){
+		.symbol = symbol,
+		.slice_type = slice_type,
+		.range = range,
+		.index = index,
+		.preheader = l->current_block,
+		.first_column = first_column
+	};
+	return l->num_views - 1;
+}
+
+// Returns the innermost view whose value variable is symbol, or -1 if there is none
+static int el_find_view(struct el_ir_lowerer const * l, int symbol)
+{
+	for(int i = l->num_views - 1; i >= 0; --i)
+	{
+		if(l->views[i].symbol == symbol)
+			return i;
+	}
+	return -1;
+}
+
+// Columns are read once, in the block before the view's loop
+static int el_view_column(struct el_ir_lowerer * l, int view, int field)
+{
+	if(view < 0)
+		return el_IR_NO_REGISTER;
+
+	struct el_soa_view const * v = &l->views[view];
+	int column = l->view_columns[v->first_column + field];
+	if(column == el_IR_NO_REGISTER)
+	{
+		int block = l->current_block;
+		l->current_block = v->preheader;
+		column = el_soa_column(l, v->slice_type, v->range, field);
+		l->current_block = block;
+		l->view_columns[v->first_column + field] = column;
+	}
+	return column;
+}
+
+static int el_soa_column(struct el_ir_lowerer * l, int slice_type, int slice, int field)
+{
+	int column = el_new_register(l, el_get_layout(l->layout, slice_type)->field_types[field]);
+	el_emit(l, el_IR_GET_COLUMN, column, slice, field);
+	return column;
+}
+
+// If the object of dot is an element of a soa slice, lower it to the column and index the field is stored at and return true
+static bool el_lower_soa_field(struct el_ir_lowerer * l, struct el_ast_expression * dot, int * column, int * index)
+{
+	struct el_ast_expression * object = dot->binary_op.lhs;
+	int field = dot->binary_op.rhs->symbol;
+	if(object->type == el_AST_EXPR_IDENTIFIER)
+	{
+		int view = el_find_view(l, object->symbol);
+		if(view < 0)
+			return false;
+
+		*column = el_view_column(l, view, field);
+		*index = l->views[view].index;
+		return true;
+	}
+
+	struct el_ast_expression * slice = object->binary_op.lhs;
+	if(object->type != el_AST_EXPR_SLICE_INDEX || !el_get_layout(l->layout, slice->type_id)->is_soa)
+		return false;
+
+	int slice_value = el_lower_expression(l, slice);
+	*index = el_lower_expression(l, object->binary_op.rhs);
+	*column = el_soa_column(l, slice->type_id, slice_value, field);
+	return true;
+}
+
+// Copy the element at index of a soa slice into value, a new data block, reading the view's columns unless view is -1
+static void el_gather_element(struct el_ir_lowerer * l, int slice_type, int slice, int view, int index, int value)
+{
+	struct el_type_layout const * element = el_get_layout(l->layout, el_get_type(l->types, slice_type)->element_type);
+	el_emit(l, el_IR_NEW_DAT, value, 0, 0);
+	for(int i = 0; i < element->num_fields && l->err == 0; ++i)
+	{
+		int column = view >= 0 ? el_view_column(l, view, i) : el_soa_column(l, slice_type, slice, i);
+		int field = el_new_register(l, element->field_types[i]);
+		el_emit(l, el_IR_GET_ELEMENT, field, column, index);
+		el_emit(l, el_IR_SET_FIELD, value, i, field);
+	}
+}
+
+// Copy the data block value into the element at index of a soa slice, a NULL value is a null reference
+static void el_scatter_element(struct el_ir_lowerer * l, int slice_type, int slice, int index, int value)
+{
+	struct el_type_layout const * element = el_get_layout(l->layout, el_get_type(l->types, slice_type)->element_type);
+	for(int i = 0; i < element->num_fields && l->err == 0; ++i)
+	{
+		int field = el_new_register(l, element->field_types[i]);
+		el_emit(l, el_IR_GET_FIELD, field, value, i);
+		el_emit(l, el_IR_SET_ELEMENT, el_soa_column(l, slice_type, slice, i), index, field);
+	}
+}
+
+// A field of an element of a soa slice is read from its column, without lowering the dot's children
+static bool el_enter_dot(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	int column = 0;
+	int index = 0;
+	if(el_lower_soa_field(l, e, &column, &index))
+	{
+		int value = el_new_register(l, e->type_id);
+		el_emit(l, el_IR_GET_ELEMENT, value, column, index);
+		el_push_value(l, value);
+		return false;
+	}
+
+	struct el_ast_expression ** field = el_vector_push(l, fields, NULL);
+	if(!field)
+	{
+		l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+		return false;
+	}
+	*field = e->binary_op.rhs;
+	return true;
+}
+
+static void el_leave_number_literal(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	int value = el_new_register(l, e->type_id);
+	if(e->type_id == el_FLOAT_TYPE_ID)
+	{
+		el_emit(l, el_IR_LOAD_FLOAT, value, el_float_constant(l, e->float_value), 0);
+	}
+	else
+	{
+		el_emit(l, el_IR_LOAD_INT, value, el_int_constant(l, e->int_value), 0);
+	}
+	el_push_value(l, value);
+}
+
+static void el_leave_string_literal(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	int value = el_new_register(l, el_STRING_TYPE_ID);
+	int string = el_checked_index(l, l->num_strings);
+	el_string * pushed = l->err ? NULL : el_vector_push(l, strings, NULL);
+	if(pushed)
+	{
+		*pushed = e->string_literal;
+	}
+	else
+	{
+		l->err = l->err ? l->err : el_ALLOCATION_ERROR;
+	}
+	el_emit(l, el_IR_LOAD_STRING, value, string, 0);
+	el_push_value(l, value);
+}
+
+static void el_leave_identifier(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+
+	// Fields are read by their dot, as are functions and data blocks by their call
+	if(l->num_fields > 0 && l->fields[l->num_fields - 1] == e)
+	{
+		--l->num_fields;
+		el_push_value(l, el_IR_NO_REGISTER);
+		return;
+	}
+
+	int kind = l->symbols->symbols[e->symbol].kind;
+	if(kind == el_SYMBOL_FUNCTION || kind == el_SYMBOL_DATA_BLOCK)
+	{
+		el_push_value(l, el_IR_NO_REGISTER);
+		return;
+	}
+
+	if(el_is_global(l, e->symbol))
+	{
+		int value = el_new_register(l, e->type_id);
+		el_emit(l, el_IR_LOAD_GLOBAL, value, l->symbol_indices[e->symbol], 0);
+		el_push_value(l, value);
+		return;
+	}
+
+	// A view has no register of its own, its value is a copy of the element
+	int view = el_find_view(l, e->symbol);
+	if(view >= 0)
+	{
+		struct el_soa_view const * v = &l->views[view];
+		int value = el_new_register(l, e->type_id);
+		el_gather_element(l, v->slice_type, v->range, view, v->index, value);
+		el_push_value(l, value);
+		return;
+	}
+	el_push_value(l, el_variable_register(l, e->symbol));
+}
+
+// Vector types are only called, which builds the vector
+static void el_leave_vector_type(struct el_ast_expression * e, void * context)
+{
+	el_push_value(context, el_IR_NO_REGISTER);
+}
+
+static void el_leave_binary_op(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	int rhs = el_pop_value(l);
+	int lhs = el_pop_value(l);
+	bool is_swapped = false;
+	int op = el_binary_op(e, &is_swapped);
+	int value = el_new_register(l, e->type_id);
+	el_emit(l, op, value, is_swapped ? rhs : lhs, is_swapped ? lhs : rhs);
+	el_push_value(l, value);
+}
+
+// Returns the op computing e, > and >= swap their operands
+static int el_binary_op(struct el_ast_expression const * e, bool * is_swapped)
+{
+	int operand_type = e->binary_op.lhs->type_id;
+	int op = 0;
+	*is_swapped = false;
+	if(operand_type >= el_INT2_TYPE_ID && operand_type <= el_INT8_TYPE_ID)
+	{
+		return e->type == el_AST_EXPR_ADD ? el_IR_ADD_INT_VECTOR : e->type == el_AST_EXPR_SUB ? el_IR_SUB_INT_VECTOR : el_IR_MUL_INT_VECTOR;
+	}
+	if(operand_type >= el_FLOAT2_TYPE_ID && operand_type <= el_FLOAT8_TYPE_ID)
+	{
+		return e->type == el_AST_EXPR_ADD ? el_IR_ADD_FLOAT_VECTOR : e->type == el_AST_EXPR_SUB ? el_IR_SUB_FLOAT_VECTOR
+			: e->type == el_AST_EXPR_MUL ? el_IR_MUL_FLOAT_VECTOR : el_IR_DIV_FLOAT_VECTOR;
+	}
+
+	switch(e->type)
+	{
+	case el_AST_EXPR_ADD:
+		op = operand_type == el_FLOAT_TYPE_ID ? el_IR_ADD_FLOAT : el_IR_ADD_INT;
+		break;
+	case el_AST_EXPR_SUB:
+		op = operand_type == el_FLOAT_TYPE_ID ? el_IR_SUB_FLOAT : el_IR_SUB_INT;
+		break;
+	case el_AST_EXPR_MUL:
+		op = operand_type == el_FLOAT_TYPE_ID ? el_IR_MUL_FLOAT : el_IR_MUL_INT;
+		break;
+	case el_AST_EXPR_DIV:
+		op = operand_type == el_FLOAT_TYPE_ID ? el_IR_DIV_FLOAT : el_IR_DIV_INT;
+		break;
+	case el_AST_EXPR_EQUALS:
+		op = operand_type == el_FLOAT_TYPE_ID ? el_IR_EQ_FLOAT : operand_type == el_STRING_TYPE_ID ? el_IR_EQ_STRING : el_IR_EQ_INT;
+		break;
+	case el_AST_EXPR_GREATER_THAN:
+		*is_swapped = true;
+		// fall through
+	case el_AST_EXPR_LESS_THAN:
+		op = operand_type == el_FLOAT_TYPE_ID ? el_IR_LT_FLOAT : el_IR_LT_INT;
+		break;
+	case el_AST_EXPR_GEQUALS:
+		*is_swapped = true;
+		// fall through
+	case el_AST_EXPR_LEQUALS:
+		op = operand_type == el_FLOAT_TYPE_ID ? el_IR_LE_FLOAT : el_IR_LE_INT;
+		break;
+	case el_AST_EXPR_BOOLEAN_AND:
+		op = el_IR_AND;
+		break;
+	case el_AST_EXPR_BOOLEAN_OR:
+		op = el_IR_OR;
+		break;
+	}
+	return op;
+}
+
+static void el_leave_dot(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	el_pop_value(l);
+	int object = el_pop_value(l);
+	int value = el_new_register(l, e->type_id);
+	el_emit(l, el_IR_GET_FIELD, value, object, e->binary_op.rhs->symbol);
+	el_push_value(l, value);
+}
+
+static void el_leave_function_call(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	int first_argument = el_pop_value(l);
+	el_pop_value(l);
+
+	if(e->binary_op.lhs->type == el_AST_EXPR_VECTOR_TYPE)
+	{
+		el_push_value(l, el_lower_vector(l, e, first_argument));
+		return;
+	}
+
+	int callee = e->binary_op.lhs->symbol;
+	struct el_symbol const * symbol = &l->symbols->symbols[callee];
+	int value = el_IR_NO_REGISTER;
+	if(symbol->kind == el_SYMBOL_FUNCTION)
+	{
+		value = e->type_id == el_VOID_TYPE_ID ? el_IR_NO_REGISTER : el_new_register(l, e->type_id);
+		el_emit(l, el_IR_CALL, value, l->symbol_indices[callee], first_argument);
+	}
+	else
+	{
+		// A data block is constructed zeroed, then given any arguments field by field
+		struct el_ast_expression_list const * arguments = e->binary_op.rhs->expression_list;
+		value = el_new_register(l, e->type_id);
+		el_emit(l, el_IR_NEW_DAT, value, 0, 0);
+		for(int i = 0; i < arguments->num_expressions && l->err == 0; ++i)
+		{
+			el_emit(l, el_IR_SET_FIELD, value, i, l->function->operands[first_argument + i]);
+		}
+		l->function->num_operands -= l->err ? 0 : arguments->num_expressions;
+	}
+	el_push_value(l, value);
+}
+
+// Returns the register of the vector a call of a vector type builds from its arguments, which start at operand first_argument
+// A single argument is every lane and without arguments every lane is zero
+static int el_lower_vector(struct el_ir_lowerer * l, struct el_ast_expression const * call, int first_argument)
+{
+	struct el_type const * type = el_get_type(l->types, call->type_id);
+	int num_arguments = call->binary_op.rhs->expression_list->num_expressions;
+	int value = el_new_register(l, call->type_id);
+	if(num_arguments == type->num_lanes)
+	{
+		el_emit(l, el_IR_NEW_VECTOR, value, type->num_lanes, first_argument);
+		return value;
+	}
+
+	int lane = 0;
+	if(num_arguments == 0)
+	{
+		lane = el_new_register(l, type->element_type);
+		bool is_float = type->element_type == el_FLOAT_TYPE_ID;
+		el_emit(l, is_float ? el_IR_LOAD_FLOAT : el_IR_LOAD_INT, lane, is_float ? el_float_constant(l, 0.0) : el_int_constant(l, 0), 0);
+	}
+	else
+	{
+		lane = l->err ? 0 : l->function->operands[first_argument];
+		l->function->num_operands -= l->err ? 0 : 1;
+	}
+	for(int i = 0; i < type->num_lanes; ++i)
+	{
+		el_push_value(l, lane);
+	}
+	el_emit(l, el_IR_NEW_VECTOR, value, type->num_lanes, el_push_operands(l, type->num_lanes));
+	return value;
+}
+
+static void el_leave_slice_index(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	int index = el_pop_value(l);
+	int slice = el_pop_value(l);
+	int value = el_new_register(l, e->type_id);
+	int slice_type = e->binary_op.lhs->type_id;
+
+	// Lanes are int literals, the register loading the index is left unread
+	if(el_get_type(l->types, slice_type)->kind == el_TYPE_VECTOR)
+	{
+		el_emit(l, el_IR_GET_LANE, value, slice, (int)e->binary_op.rhs->int_value);
+	}
+	else if(el_get_layout(l->layout, slice_type)->is_soa)
+	{
+		el_gather_element(l, slice_type, slice, -1, index, value);
+	}
+	else
+	{
+		el_emit(l, el_IR_GET_ELEMENT, value, slice, index);
+	}
+	el_push_value(l, value);
+}
+
+static void el_leave_slice_literal(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	int num_elements = e->expression_list->num_expressions;
+	struct el_type_layout const * layout = el_get_layout(l->layout, e->type_id);
+	if(!layout->is_soa)
+	{
+		int first_element = el_push_operands(l, num_elements);
+		int value = el_new_register(l, e->type_id);
+		el_emit(l, el_IR_NEW_SLICE, value, num_elements, first_element);
+		el_push_value(l, value);
+		return;
+	}
+
+	// Each column is a slice literal of a field of every element
+	int first_value = l->num_values - num_elements;
+	int value = el_new_register(l, e->type_id);
+	el_emit(l, el_IR_NEW_DAT, value, 0, 0);
+	for(int i = 0; i < layout->num_fields && l->err == 0; ++i)
+	{
+		int field_type = el_get_type(l->types, layout->field_types[i])->element_type;
+		for(int j = 0; j < num_elements && l->err == 0; ++j)
+		{
+			int field = el_new_register(l, field_type);
+			el_emit(l, el_IR_GET_FIELD, field, l->values[first_value + j], i);
+			el_push_value(l, field);
+		}
+		int column = el_new_register(l, layout->field_types[i]);
+		el_emit(l, el_IR_NEW_SLICE, column, num_elements, el_push_operands(l, num_elements));
+		el_emit(l, el_IR_SET_FIELD, value, i, column);
+	}
+	l->num_values = l->err ? l->num_values : first_value;
+	el_push_value(l, value);
+}
+
+// Arguments are left as the index of their first operand, which the call consumes
+static void el_leave_arguments(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	el_push_value(l, el_push_operands(l, e->expression_list->num_expressions));
+}
+
+// Only the object of a dot is a variable, its rhs names a field
+static bool el_enter_captured_dot(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	int err = el_ast_visit_expression(e->binary_op.lhs, &l->capture_visitor);
+	l->err = l->err ? l->err : err;
+	return false;
+}
+
+// Variables of the enclosing functions are captured once each, globals are read as they are anywhere else
+static void el_leave_captured_identifier(struct el_ast_expression * e, void * context)
+{
+	struct el_ir_lowerer * l = context;
+	int symbol = e->symbol;
+	if(l->err || symbol == el_NO_SYMBOL)
+		return;
+
+	int kind = l->symbols->symbols[symbol].kind;
+	if(kind == el_SYMBOL_FUNCTION || kind == el_SYMBOL_DATA_BLOCK || el_is_global(l, symbol) || el_is_declared_in_loop(l, l->capturing, symbol))
+		return;
+	for(int i = l->first_capture; i < l->num_captures; ++i)
+	{
+		if(l->captures[i].symbol == symbol)
+			return;
+	}
+
+	int view = el_find_view(l, symbol);
+	struct el_ir_capture * capture = el_vector_push(l, captures, NULL);
+	if(!capture)
+	{
+		l->err = el_ALLOCATION_ERROR;
+		return;
+	}
+	*capture = (struct el_ir_capture){ symbol, view, view < 0 ? el_variable_register(l, symbol) : el_IR_NO_REGISTER, -1 };
+}
+
+static void * el_ir_alloc(struct el_linear_allocator * allocator, size_t num_bytes)
+{
+	void * memory = el_linear_alloc(allocator, el_ir_aligned_size(num_bytes));
+	assert(memory || num_bytes == 0);
+	return memory;
+}
+
+// Empty builder arrays may never have been allocated, and memcpy must not be given a null pointer
+static void * el_ir_alloc_copy(struct el_linear_allocator * allocator, void const * source, size_t num_bytes)
+{
+	void * memory = el_ir_alloc(allocator, num_bytes);
+	if(num_bytes > 0)
+	{
+		memcpy(memory, source, num_bytes);
+	}
+	return memory;
+}
+
+static size_t el_ir_aligned_size(size_t num_bytes)
+{
+	return (num_bytes + IR_ALIGNMENT - 1) / IR_ALIGNMENT * IR_ALIGNMENT;
+}
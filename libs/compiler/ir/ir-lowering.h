@@ -0,0 +1,18 @@
+#pragma once
+#include "ir.h"
+#include <compiler/syntax-parsing/ast.h>
+
+struct el_symbol_table;
+
+enum el_ir_lower_flags
+{
+	el_IR_LOWER_DEFAULT = 0,
+	el_IR_LOWER_NO_KERNELS = 1 << 0 // Lower vector loops as every other for statement, e.g. to measure what their kernels gain
+};
+
+// Lower every function of the ast, and its file scope statements into the init function, to a new module
+// The ast must have passed el_type_check and el_fold_constants, the values of number literals are read from the ast
+// Statements after a ret in the same block cannot run and are not lowered
+// The element-wise body of each vector loop is also lowered to a kernel, see el_ir_kernel, unless flags has el_IR_LOWER_NO_KERNELS
+// On failure the module is left empty
+int el_ir_lower(struct el_ir_module * module, struct el_ast * ast, struct el_symbol_table const * symbols, struct el_type_table const * types, int flags);
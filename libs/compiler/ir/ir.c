@@ -0,0 +1,76 @@
+#include "ir.h"
+#include <allocators/fmalloc.h>
+#include <assert.h>
+
+#define NONE el_IR_OPERAND_NONE
+#define REGISTER el_IR_OPERAND_REGISTER
+
+static struct el_ir_op_info const op_infos[el_ir_op_count] = {
+	[el_IR_LOAD_INT] = { "load", { REGISTER, el_IR_OPERAND_INT_CONSTANT, NONE }, true },
+	[el_IR_LOAD_FLOAT] = { "load", { REGISTER, el_IR_OPERAND_FLOAT_CONSTANT, NONE }, true },
+	[el_IR_LOAD_STRING] = { "load", { REGISTER, el_IR_OPERAND_STRING, NONE }, true },
+	[el_IR_MOVE] = { "move", { REGISTER, REGISTER, NONE }, true },
+	[el_IR_LOAD_GLOBAL] = { "load.global", { REGISTER, el_IR_OPERAND_GLOBAL, NONE }, true },
+	[el_IR_STORE_GLOBAL] = { "store.global", { el_IR_OPERAND_GLOBAL, REGISTER, NONE }, false },
+	[el_IR_ADD_INT] = { "add.int", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_SUB_INT] = { "sub.int", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_MUL_INT] = { "mul.int", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_DIV_INT] = { "div.int", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_ADD_FLOAT] = { "add.float", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_SUB_FLOAT] = { "sub.float", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_MUL_FLOAT] = { "mul.float", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_DIV_FLOAT] = { "div.float", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_EQ_INT] = { "eq.int", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_LT_INT] = { "lt.int", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_LE_INT] = { "le.int", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_EQ_FLOAT] = { "eq.float", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_LT_FLOAT] = { "lt.float", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_LE_FLOAT] = { "le.float", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_EQ_STRING] = { "eq.string", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_AND] = { "and", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_OR] = { "or", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_NEW_DAT] = { "new.dat", { REGISTER, NONE, NONE }, true },
+	[el_IR_GET_FIELD] = { "get.field", { REGISTER, REGISTER, el_IR_OPERAND_FIELD }, true },
+	[el_IR_SET_FIELD] = { "set.field", { REGISTER, el_IR_OPERAND_FIELD, REGISTER }, false },
+	[el_IR_NEW_SLICE] = { "new.slice", { REGISTER, el_IR_OPERAND_COUNT, el_IR_OPERAND_OPERANDS }, true },
+	[el_IR_NEW_ZERO_SLICE] = { "new.zero.slice", { REGISTER, REGISTER, NONE }, true },
+	[el_IR_GET_ELEMENT] = { "get.element", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_SET_ELEMENT] = { "set.element", { REGISTER, REGISTER, REGISTER }, false },
+	[el_IR_LENGTH] = { "length", { REGISTER, REGISTER, NONE }, true },
+	[el_IR_GET_COLUMN] = { "get.column", { REGISTER, REGISTER, el_IR_OPERAND_FIELD }, true },
+	[el_IR_CALL] = { "call", { REGISTER, el_IR_OPERAND_FUNCTION, el_IR_OPERAND_OPERANDS }, true },
+	[el_IR_KERNEL] = { "kernel", { REGISTER, el_IR_OPERAND_KERNEL, el_IR_OPERAND_OPERANDS }, true },
+	[el_IR_PARALLEL_FOR] = { "parallel.for", { REGISTER, el_IR_OPERAND_FUNCTION, el_IR_OPERAND_OPERANDS }, false },
+	[el_IR_NEW_VECTOR] = { "new.vector", { REGISTER, el_IR_OPERAND_COUNT, el_IR_OPERAND_OPERANDS }, true },
+	[el_IR_GET_LANE] = { "get.lane", { REGISTER, REGISTER, el_IR_OPERAND_LANE }, true },
+	[el_IR_ADD_INT_VECTOR] = { "add.int.vector", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_SUB_INT_VECTOR] = { "sub.int.vector", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_MUL_INT_VECTOR] = { "mul.int.vector", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_ADD_FLOAT_VECTOR] = { "add.float.vector", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_SUB_FLOAT_VECTOR] = { "sub.float.vector", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_MUL_FLOAT_VECTOR] = { "mul.float.vector", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_DIV_FLOAT_VECTOR] = { "div.float.vector", { REGISTER, REGISTER, REGISTER }, true },
+	[el_IR_JUMP] = { "jump", { el_IR_OPERAND_BLOCK, NONE, NONE }, false },
+	[el_IR_BRANCH] = { "branch", { REGISTER, el_IR_OPERAND_BLOCK, el_IR_OPERAND_BLOCK }, false },
+	[el_IR_RET] = { "ret", { REGISTER, NONE, NONE }, false },
+	[el_IR_RET_VOID] = { "ret", { NONE, NONE, NONE }, false }
+};
+
+#undef NONE
+#undef REGISTER
+
+void el_ir_module_delete(struct el_ir_module * module)
+{
+	if(module)
+	{
+		ffree(module->allocator.memory);
+		el_data_layout_delete(&module->layout);
+		*module = (struct el_ir_module){ 0 };
+	}
+}
+
+struct el_ir_op_info const * el_ir_op_info(int op)
+{
+	assert(op >= 0 && op < el_ir_op_count);
+	return &op_infos[op];
+}
@@ -0,0 +1,218 @@
+#pragma once
+#include <allocators/linear-allocator.h>
+#include <compiler/semantic-analysis/data-layout.h>
+#include <containers/string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Operands of an instruction are named a, b and c, each op below lists what they hold
+// Registers are mutable and typed, a variable keeps one register for the whole function and temporaries get a fresh one each
+enum el_ir_op
+{
+	el_IR_LOAD_INT, // a = int_constants[b]
+	el_IR_LOAD_FLOAT, // a = float_constants[b]
+	el_IR_LOAD_STRING, // a = strings[b]
+	el_IR_MOVE, // a = b
+	el_IR_LOAD_GLOBAL, // a = globals[b]
+	el_IR_STORE_GLOBAL, // globals[a] = b
+
+	// a = b op c
+	el_IR_ADD_INT,
+	el_IR_SUB_INT,
+	el_IR_MUL_INT,
+	el_IR_DIV_INT, // Truncates towards zero
+	el_IR_ADD_FLOAT,
+	el_IR_SUB_FLOAT,
+	el_IR_MUL_FLOAT,
+	el_IR_DIV_FLOAT,
+
+	// a = b op c as an int of 0 or 1, > and >= are lowered to < and <= with their operands swapped
+	el_IR_EQ_INT,
+	el_IR_LT_INT,
+	el_IR_LE_INT,
+	el_IR_EQ_FLOAT,
+	el_IR_LT_FLOAT,
+	el_IR_LE_FLOAT,
+	el_IR_EQ_STRING,
+	el_IR_AND, // Both operands are always evaluated
+	el_IR_OR,
+
+	// Fields are those of a's or b's block, which for a soa slice are its columns, see el_type_layout
+	el_IR_NEW_DAT, // a = block of a's type with every field zeroed, a data block or the columns of a soa slice
+	el_IR_GET_FIELD, // a = b.fields[c]
+	el_IR_SET_FIELD, // a.fields[b] = c
+	el_IR_NEW_SLICE, // a = slice of a's type holding the b registers operands[c], operands[c + 1], ...
+	el_IR_NEW_ZERO_SLICE, // a = slice of a's type holding b elements, every element zeroed
+	el_IR_GET_ELEMENT, // a = b[c]
+	el_IR_SET_ELEMENT, // a[b] = c
+	el_IR_LENGTH, // a = number of elements of slice b
+	el_IR_GET_COLUMN, // a = b.fields[c] of soa slice b, or the empty column NULL if b is the empty slice NULL
+	el_IR_CALL, // a = functions[b](operands[c], operands[c + 1], ...), a is el_IR_NO_REGISTER if the function returns void
+	el_IR_KERNEL, // Run kernels[b] for elements [0, operands[c]) of its arguments operands[c + 1], ..., a = how many leading elements it ran for
+
+	// Run functions[b](first, end, chunk, operands[c + 1], operands[c + 2], ...) for each chunk in [0, a), which may run at once on any thread
+	// Chunk k covers elements [operands[c] * k / a, operands[c] * (k + 1) / a) of a range of operands[c] elements, see el_ir_chunk_bounds
+	// The op returns once every chunk has run, a runtime error in a chunk is raised by the op
+	el_IR_PARALLEL_FOR,
+
+	// Vectors are never written once built, see el_type_layout
+	// Except that a register which owns its block, see owned_vectors, has each vector written to it built in that block
+	el_IR_NEW_VECTOR, // a = vector of a's type whose lanes are the b registers operands[c], operands[c + 1], ...
+	el_IR_GET_LANE, // a = lane c of vector b, or 0 if b is the vector of zeros NULL
+
+	// a = b op c lane by lane, as a new vector of the operands' type, b and c may be a
+	el_IR_ADD_INT_VECTOR,
+	el_IR_SUB_INT_VECTOR,
+	el_IR_MUL_INT_VECTOR,
+	el_IR_ADD_FLOAT_VECTOR,
+	el_IR_SUB_FLOAT_VECTOR,
+	el_IR_MUL_FLOAT_VECTOR,
+	el_IR_DIV_FLOAT_VECTOR,
+
+	// Terminators, the last instruction of every block and only the last
+	el_IR_JUMP, // Continue at block a
+	el_IR_BRANCH, // Continue at block b if a is not 0, otherwise at block c
+	el_IR_RET, // Return a
+	el_IR_RET_VOID, // Return, or if the function has a return type return its zero value
+
+	el_ir_op_count
+};
+
+// What an operand of an op holds, see el_ir_op_info
+enum el_ir_operand_kind
+{
+	el_IR_OPERAND_NONE,
+	el_IR_OPERAND_REGISTER,
+	el_IR_OPERAND_INT_CONSTANT,
+	el_IR_OPERAND_FLOAT_CONSTANT,
+	el_IR_OPERAND_STRING,
+	el_IR_OPERAND_GLOBAL,
+	el_IR_OPERAND_FIELD,
+	el_IR_OPERAND_FUNCTION,
+	el_IR_OPERAND_BLOCK,
+	el_IR_OPERAND_KERNEL,
+	el_IR_OPERAND_LANE,
+	el_IR_OPERAND_COUNT,
+	el_IR_OPERAND_OPERANDS // Index of the first of a list in the function's operands
+};
+
+struct el_ir_op_info
+{
+	char const * name;
+	unsigned char operand_kinds[3];
+	bool writes_a; // a is the register the op's result is written to
+};
+
+#define el_IR_NO_REGISTER UINT16_MAX
+
+// Largest index of a register, block, operand or constant
+#define el_IR_MAX_INDEX (UINT16_MAX - 1)
+
+// 8 bytes, s.t. a function's instructions are a dense array the backends stream through
+struct el_ir_instruction
+{
+	uint16_t op;
+	uint16_t a;
+	uint16_t b;
+	uint16_t c;
+};
+
+// Instructions [first_instruction, first_instruction + num_instructions) of the function, the last of which is a terminator
+struct el_ir_block
+{
+	int first_instruction;
+	int num_instructions;
+};
+
+// The body of a vector loop, see el_vector_loop, run by el_IR_KERNEL for many elements at once
+// Registers [0, num_arguments) hold its arguments, the slice iterated first, and register num_arguments the element's index
+// The body is straight line code without a terminator, whose only ops are loads of constants, int and float arithmetic except
+// div.int, comparisons, and/or, and get.element and set.element at the index of int[] and float[] arguments
+// A backend may run it for any number of leading elements, the rest are left to the scalar loop which follows
+struct el_ir_kernel
+{
+	struct el_ir_instruction * instructions;
+	int num_instructions;
+
+	int * register_types;
+	int num_registers;
+	int num_arguments;
+};
+
+struct el_ir_function
+{
+	el_string name; // NULL for the module's init function
+	int symbol; // el_NO_SYMBOL for the module's init function
+	int return_type;
+	int num_parameters; // Parameters are passed in registers [0, num_parameters)
+
+	// Block 0 is the entry, a function whose body was skipped by a lazy parse has no blocks
+	struct el_ir_block * blocks;
+	int num_blocks;
+
+	struct el_ir_instruction * instructions;
+	int num_instructions;
+
+	int * register_types; // Type id of each register
+	int num_registers;
+
+	uint16_t * operands; // Registers of the calls, slice literals and kernels which take more than two
+	int num_operands;
+
+	struct el_ir_kernel * kernels;
+	int num_kernels;
+
+	// Whether each register owns the block of its vector, i.e. the block is referenced by no other register, field, element or global
+	// Such a register is only written by new.vector and vector arithmetic, and only read by vector arithmetic and get.lane
+	bool * owned_vectors;
+
+	// Function whose parallel for this function is the body of, or -1, such a function shares its name
+	int outlined_from;
+};
+
+// Every array of a module lives in its allocator, which is freed as a whole
+struct el_ir_module
+{
+	struct el_linear_allocator allocator;
+	struct el_type_table const * types; // Must outlive the module
+	struct el_data_layout layout; // Of every type in types
+
+	// Functions are in the order they are declared, followed by the init function which runs the file scope statements
+	struct el_ir_function * functions;
+	int num_functions;
+	int init_function;
+
+	long long * int_constants;
+	int num_int_constants;
+	double * float_constants;
+	int num_float_constants;
+	el_string * strings;
+	int num_strings;
+
+	// Variables assigned at file scope
+	int * global_types;
+	int * global_symbols;
+	int num_globals;
+};
+
+void el_ir_module_delete(struct el_ir_module * module);
+
+// Ops which build a vector into a, see el_IR_NEW_VECTOR
+static inline bool el_ir_builds_vector(int op)
+{
+	return op == el_IR_NEW_VECTOR || (op >= el_IR_ADD_INT_VECTOR && op <= el_IR_DIV_FLOAT_VECTOR);
+}
+
+struct el_ir_op_info const * el_ir_op_info(int op);
+
+// Elements [*first, *end) of a range of length elements are those of chunk of num_chunks, see el_IR_PARALLEL_FOR
+static inline void el_ir_chunk_bounds(long long length, long long num_chunks, long long chunk, long long * first, long long * end)
+{
+	*first = (long long)((unsigned long long)length * (unsigned long long)chunk / (unsigned long long)num_chunks);
+	*end = (long long)((unsigned long long)length * (unsigned long long)(chunk + 1) / (unsigned long long)num_chunks);
+}
+
+static inline bool el_ir_is_terminator(int op)
+{
+	return op >= el_IR_JUMP;
+}
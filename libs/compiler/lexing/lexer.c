@@ -16,12 +16,13 @@
 #define DEBUG_LEXING 0
 
 #define MAX_TOKEN_LENGTH 128
-#define MAX_NUM_TOKENS_PER_FILE 4096
+#define BYTES_PER_TOKEN_ESTIMATE 4
 
 static char const * token_strings[] = {
 	"N/A",		// el_NONE
 
 	"N/A",		// el_END_LINE
+	"N/A",		// el_END_OF_FILE
 
 	"N/A",		// el_LINE_COMMENT
 
@@ -32,6 +33,12 @@ static char const * token_strings[] = {
 
 	"int",		// el_INT_TYPE
 	"float",	// el_FLOAT_TYPE
+	"int2",		// el_INT2_TYPE
+	"int4",		// el_INT4_TYPE
+	"int8",		// el_INT8_TYPE
+	"float2",	// el_FLOAT2_TYPE
+	"float4",	// el_FLOAT4_TYPE
+	"float8",	// el_FLOAT8_TYPE
 
 	"fnc",		// el_FNC_KEYWORD
 	"dat",		// el_DAT_KEYWORD
@@ -41,6 +48,8 @@ static char const * token_strings[] = {
 	"if",		// el_IF_KEYWORD
 	"elif",		// el_ELIF_KEYWORD
 	"else",		// el_ELSE_KEYWORD
+	"soa",		// el_SOA_KEYWORD
+	"parallel",	// el_PARALLEL_KEYWORD
 
 	"{",		// el_BLOCK_START
 	"}",		// el_BLOCK_END
@@ -72,23 +81,29 @@ static char const * token_strings[] = {
 
 static_assert(ARRAY_SIZE(token_strings) == el_token_type_count, "Lexer's token_strings array is not up-to-date with el_token_type");
 
-static int el_push_token(struct el_token_stream * stream, int type, el_string source)
+char const * el_token_string(int type)
 {
-	if(stream->num_tokens >= MAX_NUM_TOKENS_PER_FILE)
+	assert(type >= 0 && type < el_token_type_count);
+	return token_strings[type];
+}
+
+static int el_push_token(struct el_token_stream * stream, int type, int offset, struct el_string_view source)
+{
+	struct el_token * token = el_vector_push(stream, tokens, NULL);
+	if(!token)
 	{
-		fprintf(stderr, "Failed to push token, %d, reached max number of tokens\n", type);
-		return el_EXCEEDED_TOKENS_LIMIT_LEX_ERROR;
+		fprintf(stderr, "Failed to push token, %d, could not grow tokens list\n", type);
+		return el_ALLOCATION_ERROR;
 	}
 
-	struct el_token token = {
-		.type = type,
-		.source = source
-	};
-	stream->tokens[stream->num_tokens++] = token;
+	token->type = type;
+	token->offset = offset;
+	token->source = source;
 	return el_SUCCESS;
 }
 
-static int el_lex_line(char const * line, struct el_token_stream * stream)
+// Lex a single line of length bytes, starting at byte offset in the source
+static int el_lex_line(char const * line, int length, int offset, struct el_token_stream * stream)
 {
 	bool forming_string = false;
 
@@ -96,10 +111,6 @@ static int el_lex_line(char const * line, struct el_token_stream * stream)
 	int token_idx = 0;
 	token_buf[0] = '\0';
 
-	int num_tokens = 0;
-
-	int length = (int)strlen(line);
-	int start_i = 0;
 	for(int i = 0; i < length + 1; ++i)
 	{
 		char c = (i < length ? line[i] : '\n');
@@ -110,11 +121,14 @@ static int el_lex_line(char const * line, struct el_token_stream * stream)
 			return el_EXCEEDED_TOKEN_LENGTH_LIMIT_LEX_ERROR;
 		}
 
+		// A dot within a number literal is its decimal point rather than the dot operator
+		bool forming_number = token_idx > 0 && token_buf[0] >= '0' && token_buf[0] <= '9';
+
 		// If the character is a delimiter then the token currently being built is complete
 		if(!forming_string
 			&& (c == ' ' || c == '\n' || c == '\r' || c == '\t'
 			|| c == '}' || c == '{' || c == '(' || c == ')'
-			|| c == '[' || c == ']' || c == '.' || c == ','))
+			|| c == '[' || c == ']' || (c == '.' && !forming_number) || c == ','))
 		{
 			int token_type = el_NONE;
 			int delim_type = el_NONE;
@@ -146,7 +160,7 @@ static int el_lex_line(char const * line, struct el_token_stream * stream)
 			#if DEBUG_LEXING
 				printf("Token: %s   %d\n", token_buf, token_type);
 			#endif
-				int err = el_push_token(stream, token_type, el_string_new(token_buf, -1));
+				int err = el_push_token(stream, token_type, offset + i - token_idx, el_string_view_new(line + i - token_idx, token_idx));
 				if(err != el_SUCCESS)
 					return err;
 			}
@@ -157,7 +171,7 @@ static int el_lex_line(char const * line, struct el_token_stream * stream)
 			#if DEBUG_LEXING
 				printf("Token: %c   %d\n", c, delim_type);
 			#endif
-				int err = el_push_token(stream, delim_type, el_string_new(&c, 1));
+				int err = el_push_token(stream, delim_type, offset + i, el_string_view_new(line + i, 1));
 				if(err != el_SUCCESS)
 					return err;
 			}
@@ -174,7 +188,7 @@ static int el_lex_line(char const * line, struct el_token_stream * stream)
 			#if DEBUG_LEXING
 				printf("String: %s\n", token_buf);
 			#endif
-				int err = el_push_token(stream, el_STRING_LITERAL, el_string_new(token_buf, -1));
+				int err = el_push_token(stream, el_STRING_LITERAL, offset + i - token_idx, el_string_view_new(line + i - token_idx, token_idx));
 				if(err != el_SUCCESS)
 					return err;
 
@@ -205,43 +219,136 @@ static int el_lex_line(char const * line, struct el_token_stream * stream)
 	return el_SUCCESS;
 }
 
+// Lex the lines of contents between byte offsets start and end, start must be the beginning of a line
+// Empty lines produce no tokens, every other line is followed by an end line token
+static int el_lex_lines(char const * contents, int start, int end, struct el_token_stream * stream)
+{
+	int line_start = start;
+	while(line_start < end)
+	{
+		char const * newline = memchr(contents + line_start, '\n', end - line_start);
+		int line_end = newline ? (int)(newline - contents) : end;
+
+		if(line_end > line_start)
+		{
+		#if DEBUG_LEXING
+			printf("Line: %.*s\n", line_end - line_start, contents + line_start);
+		#endif
+
+			int err = el_lex_line(contents + line_start, line_end - line_start, line_start, stream);
+			if(err != el_SUCCESS)
+				return err;
+
+			err = el_push_token(stream, el_END_LINE, line_end, el_string_view_new("\n", 1));
+			if(err != el_SUCCESS)
+				return err;
+		}
+
+		line_start = line_end + 1;
+	}
+	return el_SUCCESS;
+}
+
 struct el_token_stream el_lex_file(struct el_text_file * f)
 {
 	assert(f);
-	struct el_token_stream stream = {
-		.tokens = fmalloc(MAX_NUM_TOKENS_PER_FILE * sizeof(struct el_token)), // TODO - Change to variable size array
-		.num_tokens = 0,
-		.current_token = 0
-	};
+	struct el_token_stream stream = { 0 };
 
-	if(!stream.tokens)
+	// Source averages a few bytes per token, so reserving from the length avoids most regrowth
+	int length = el_string_length(f->contents);
+	if(!el_vector_reserve(&stream, tokens, length / BYTES_PER_TOKEN_ESTIMATE + 1, NULL))
 	{
 		fprintf(stderr, "Failed to allocate tokens list\n");
 		return stream;
 	}
 
-	char * next_line = NULL;
-	char * line = strtok_r(f->contents, "\n", &next_line);
-	while(line != NULL)
+	// The contents are left untouched s.t. edited regions can be re-lexed later
+	if(el_lex_lines(f->contents, 0, length, &stream) != el_SUCCESS
+		|| el_push_token(&stream, el_END_OF_FILE, length, el_string_view_new("", 0)) != el_SUCCESS)
 	{
-	#if DEBUG_LEXING
-		printf("Line: %s\n", line);
-	#endif
+		el_token_stream_delete(&stream);
+		return stream;
+	}
+
+	return stream;
+}
 
-		if(el_lex_line(line, &stream) != el_SUCCESS)
+// Returns the index of the first token in [lo, hi) at or after offset, or hi if there is none
+static int el_find_token_at(struct el_token_stream const * stream, int lo, int hi, int offset)
+{
+	while(lo < hi)
+	{
+		int mid = lo + (hi - lo) / 2;
+		if(stream->tokens[mid].offset < offset)
 		{
-			el_token_stream_delete(&stream);
-			return stream;
+			lo = mid + 1;
 		}
-
-		if(el_push_token(&stream, el_END_LINE, el_string_new("\n", 1)) != el_SUCCESS)
+		else
 		{
-			el_token_stream_delete(&stream);
-			return stream;
+			hi = mid;
 		}
+	}
+	return lo;
+}
+
+int el_relex_edit(struct el_token_stream * stream, el_string contents, int start, int end, struct el_relexed_range * range)
+{
+	assert(stream && contents && range && start <= end);
+	int length = el_string_length(contents);
+
+	// Tokens never span lines, so only the lines touched by the edit are re-lexed
+	while(start > 0 && contents[start - 1] != '\n')
+	{
+		start--;
+	}
+	char const * newline = memchr(contents + end, '\n', length - end);
+	int line_end = newline ? (int)(newline - contents) : length;
+
+	// The end of file token still holds the old length
+	int delta = length - stream->tokens[stream->num_tokens - 1].offset;
+	int old_end = line_end - delta;
+
+	// Tokens are ordered by offset, the replaced tokens are those of the old lines including their end line token
+	int eof_token = stream->num_tokens - 1;
+	int first_token = el_find_token_at(stream, 0, eof_token, start);
+	int end_token = el_find_token_at(stream, first_token, eof_token, old_end + 1);
+
+	struct el_token_stream lines = { 0 };
+	int err = el_lex_lines(contents, start, line_end < length ? line_end + 1 : length, &lines);
+	int num_removed_tokens = end_token - first_token;
+	if(err == el_SUCCESS && !el_vector_reserve(stream, tokens, stream->num_tokens - num_removed_tokens + lines.num_tokens, NULL))
+	{
+		fprintf(stderr, "Failed to re-lex edit, could not grow tokens list\n");
+		err = el_ALLOCATION_ERROR;
+	}
+	if(err != el_SUCCESS)
+	{
+		el_token_stream_delete(&lines);
+		return err;
+	}
 
-		line = strtok_r(NULL, "\n", &next_line);
+	// Shift the tokens after the edit to their new indices and offsets
+	int num_tail_tokens = stream->num_tokens - end_token;
+	memmove(&stream->tokens[first_token + lines.num_tokens], &stream->tokens[end_token], sizeof(struct el_token) * num_tail_tokens);
+	memcpy(&stream->tokens[first_token], lines.tokens, sizeof(struct el_token) * lines.num_tokens);
+	int num_added_tokens = lines.num_tokens;
+	stream->num_tokens += num_added_tokens - num_removed_tokens;
+	el_token_stream_delete(&lines);
+
+	// Unchanged tokens still view the old source, which the caller is free to delete
+	// Each is visited once, the tokens after the edit also move by delta
+	for(int i = 0; i < stream->num_tokens; ++i)
+	{
+		struct el_token * token = &stream->tokens[i];
+		token->offset += i < first_token + num_added_tokens ? 0 : delta;
+		if(token->type != el_END_LINE && token->type != el_END_OF_FILE)
+		{
+			token->source.data = contents + token->offset;
+		}
 	}
 
-	return stream;
+	range->first_token = first_token;
+	range->num_removed_tokens = num_removed_tokens;
+	range->num_added_tokens = num_added_tokens;
+	return el_SUCCESS;
 }
@@ -5,4 +5,21 @@ struct el_text_file;
 
 // Generate a token stream from a source file
 // Streams created with this fn must be deleted by calling el_token_stream_delete
+// Tokens view the file's contents rather than copying them, so the stream must not outlive them
 struct el_token_stream el_lex_file(struct el_text_file * f);
+
+// Text of a keyword, native type, operator or separator token, "N/A" for tokens whose text varies
+char const * el_token_string(int type);
+
+struct el_relexed_range
+{
+	int first_token;
+	int num_removed_tokens;
+	int num_added_tokens;
+};
+
+// Update a token stream after its source was edited, contents is the edited source
+// Bytes before start and from end onwards in contents must be unchanged from the source the stream was lexed from
+// Only the lines overlapping [start, end) are re-lexed, range receives the tokens which were replaced
+// Every token views contents afterwards, s.t. the old source may be deleted
+int el_relex_edit(struct el_token_stream * stream, el_string contents, int start, int end, struct el_relexed_range * range);
@@ -1,11 +1,15 @@
 #pragma once
-#include <containers/string.h>
+#include <containers/string-view.h>
+#include <containers/vector.h>
+#include <stdint.h>
+#include <assert.h>
 
 enum el_token_type
 {
 	el_NONE = 0,
 
 	el_END_LINE,
+	el_END_OF_FILE, // Sentinel, always the last token in a stream
 
 	el_LINE_COMMENT,
 
@@ -16,6 +20,12 @@ enum el_token_type
 
 	el_INT_TYPE,
 	el_FLOAT_TYPE,
+	el_INT2_TYPE,
+	el_INT4_TYPE,
+	el_INT8_TYPE,
+	el_FLOAT2_TYPE,
+	el_FLOAT4_TYPE,
+	el_FLOAT8_TYPE,
 
 	el_FNC_KEYWORD,
 	el_DAT_KEYWORD,
@@ -25,6 +35,8 @@ enum el_token_type
 	el_IF_KEYWORD,
 	el_ELIF_KEYWORD,
 	el_ELSE_KEYWORD,
+	el_SOA_KEYWORD,
+	el_PARALLEL_KEYWORD,
 
 	el_BLOCK_START,
 	el_BLOCK_END,
@@ -56,16 +68,23 @@ enum el_token_type
 	el_token_type_count
 };
 
+// A set of token types, with one bit per type
+typedef uint64_t el_token_set;
+
+#define el_TOKEN_BIT(type) ((el_token_set)1 << (type))
+
+static_assert(el_token_type_count <= 64, "el_token_type no longer fits in an el_token_set");
+
 struct el_token
 {
 	enum el_token_type type;
-	el_string source;
+	int offset; // Byte offset of the token in the source
+	struct el_string_view source; // Refers to the source, except for end line and end of file tokens
 };
 
 struct el_token_stream
 {
-	struct el_token * tokens;
-	int num_tokens;
+	el_VECTOR_MEMBERS(struct el_token, tokens);
 	int current_token;
 };
 
@@ -0,0 +1,297 @@
+#include "constant-folding.h"
+#include "type-table.h"
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <compiler/syntax-parsing/ast-visitor.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <assert.h>
+
+// Bytes reserved for the text of each folded literal, enough for any int or shortest round trip double
+#define FOLDED_LITERAL_SIZE 48
+
+struct el_constant_folder
+{
+	int num_folded;
+	int err;
+};
+
+static bool el_is_constant(struct el_ast_expression const * e);
+static bool el_fold_int_op(int op, long long lhs, long long rhs, long long * result);
+static double el_fold_float_op(int op, double lhs, double rhs);
+static long long el_compare(int op, int cmp);
+static void el_replace_with_literal(struct el_ast_expression * e, struct el_constant_folder * folder);
+static bool el_format_folded_literal(struct el_ast_expression * e, void * context);
+
+static void el_leave_number_literal(struct el_ast_expression * e, void * context);
+static void el_leave_arithmetic(struct el_ast_expression * e, void * context);
+static void el_leave_comparison(struct el_ast_expression * e, void * context);
+static void el_leave_boolean(struct el_ast_expression * e, void * context);
+
+int el_fold_constants(struct el_ast * ast)
+{
+	assert(ast && !ast->folded_literal_allocator.memory);
+	struct el_constant_folder folder = { .num_folded = 0, .err = el_SUCCESS };
+	struct el_ast_visitor visitor = { .context = &folder };
+	visitor.leave_expression[el_AST_EXPR_NUMBER_LITERAL] = el_leave_number_literal;
+	visitor.leave_expression[el_AST_EXPR_ADD] = el_leave_arithmetic;
+	visitor.leave_expression[el_AST_EXPR_SUB] = el_leave_arithmetic;
+	visitor.leave_expression[el_AST_EXPR_MUL] = el_leave_arithmetic;
+	visitor.leave_expression[el_AST_EXPR_DIV] = el_leave_arithmetic;
+	visitor.leave_expression[el_AST_EXPR_EQUALS] = el_leave_comparison;
+	visitor.leave_expression[el_AST_EXPR_GREATER_THAN] = el_leave_comparison;
+	visitor.leave_expression[el_AST_EXPR_LESS_THAN] = el_leave_comparison;
+	visitor.leave_expression[el_AST_EXPR_GEQUALS] = el_leave_comparison;
+	visitor.leave_expression[el_AST_EXPR_LEQUALS] = el_leave_comparison;
+	visitor.leave_expression[el_AST_EXPR_BOOLEAN_AND] = el_leave_boolean;
+	visitor.leave_expression[el_AST_EXPR_BOOLEAN_OR] = el_leave_boolean;
+
+	// Children are left before their parent, so a subtree folds bottom up in one walk
+	int err = el_ast_visit(ast, &visitor);
+	err = err ? err : folder.err;
+	if(err || folder.num_folded == 0)
+		return err;
+
+	// Folded literals get their text once folding is done, s.t. text is only written for the roots of folded subtrees
+	// Each slot is a multiple of sizeof(int), keeping the length prefix of every string aligned
+	struct el_linear_allocator * allocator = &ast->folded_literal_allocator;
+	allocator->capacity = (size_t)folder.num_folded * FOLDED_LITERAL_SIZE;
+	allocator->size = 0;
+	allocator->memory = fmalloc(allocator->capacity);
+	if(!allocator->memory)
+	{
+		fprintf(stderr, "Failed to allocate folded literals\n");
+		*allocator = (struct el_linear_allocator){ 0 };
+		return el_ALLOCATION_ERROR;
+	}
+
+	struct el_ast_visitor format_visitor = { .context = allocator };
+	format_visitor.enter_expression[el_AST_EXPR_NUMBER_LITERAL] = el_format_folded_literal;
+	return el_ast_visit(ast, &format_visitor);
+}
+
+static bool el_is_constant(struct el_ast_expression const * e)
+{
+	return e->type == el_AST_EXPR_NUMBER_LITERAL && (e->type_id == el_INT_TYPE_ID || e->type_id == el_FLOAT_TYPE_ID);
+}
+
+// Returns false if the exact result is not a 64 bit int
+static bool el_fold_int_op(int op, long long lhs, long long rhs, long long * result)
+{
+	switch(op)
+	{
+	case el_AST_EXPR_ADD:
+		if((rhs > 0 && lhs > LLONG_MAX - rhs) || (rhs < 0 && lhs < LLONG_MIN - rhs))
+			return false;
+		*result = lhs + rhs;
+		return true;
+	case el_AST_EXPR_SUB:
+		if((rhs < 0 && lhs > LLONG_MAX + rhs) || (rhs > 0 && lhs < LLONG_MIN + rhs))
+			return false;
+		*result = lhs - rhs;
+		return true;
+	case el_AST_EXPR_MUL:
+	{
+		if(lhs == 0 || rhs == 0)
+		{
+			*result = 0;
+			return true;
+		}
+
+		// Compare magnitudes through unsigned division, which cannot overflow
+		bool is_negative = (lhs < 0) != (rhs < 0);
+		unsigned long long limit = is_negative ? (unsigned long long)LLONG_MAX + 1 : (unsigned long long)LLONG_MAX;
+		unsigned long long lhs_magnitude = lhs < 0 ? 0ULL - (unsigned long long)lhs : (unsigned long long)lhs;
+		unsigned long long rhs_magnitude = rhs < 0 ? 0ULL - (unsigned long long)rhs : (unsigned long long)rhs;
+		if(lhs_magnitude > limit / rhs_magnitude)
+			return false;
+
+		unsigned long long magnitude = lhs_magnitude * rhs_magnitude;
+		*result = !is_negative ? (long long)magnitude : magnitude > LLONG_MAX ? LLONG_MIN : -(long long)magnitude;
+		return true;
+	}
+	case el_AST_EXPR_DIV:
+		// Division truncates towards zero
+		if(rhs == 0 || (lhs == LLONG_MIN && rhs == -1))
+			return false;
+		*result = lhs / rhs;
+		return true;
+	}
+	return false;
+}
+
+static double el_fold_float_op(int op, double lhs, double rhs)
+{
+	switch(op)
+	{
+	case el_AST_EXPR_ADD:
+		return lhs + rhs;
+	case el_AST_EXPR_SUB:
+		return lhs - rhs;
+	case el_AST_EXPR_MUL:
+		return lhs * rhs;
+	default:
+		return lhs / rhs;
+	}
+}
+
+// cmp is negative, zero or positive as lhs is less than, equal to or greater than rhs
+static long long el_compare(int op, int cmp)
+{
+	switch(op)
+	{
+	case el_AST_EXPR_EQUALS:
+		return cmp == 0;
+	case el_AST_EXPR_GREATER_THAN:
+		return cmp > 0;
+	case el_AST_EXPR_LESS_THAN:
+		return cmp < 0;
+	case el_AST_EXPR_GEQUALS:
+		return cmp >= 0;
+	default:
+		return cmp <= 0;
+	}
+}
+
+// The value must already be set, the text is written once the walk is done
+static void el_replace_with_literal(struct el_ast_expression * e, struct el_constant_folder * folder)
+{
+	e->type = el_AST_EXPR_NUMBER_LITERAL;
+	e->symbol = el_NO_SYMBOL;
+	e->number_literal = NULL;
+	++folder->num_folded;
+}
+
+static bool el_format_folded_literal(struct el_ast_expression * e, void * context)
+{
+	if(e->number_literal)
+		return true;
+
+	char text[FOLDED_LITERAL_SIZE];
+	int length = 0;
+	if(e->type_id == el_INT_TYPE_ID)
+	{
+		length = snprintf(text, sizeof text, "%lld", e->int_value);
+	}
+	else
+	{
+		// Shortest text which reads back as the same double
+		for(int precision = 15; precision <= 17; ++precision)
+		{
+			length = snprintf(text, sizeof text, "%.*g", precision, e->float_value);
+			if(strtod(text, NULL) == e->float_value)
+				break;
+		}
+
+		// Floats keep a decimal point s.t. they do not read as ints
+		bool reads_as_float = false;
+		for(int i = 0; i < length; ++i)
+		{
+			reads_as_float = reads_as_float || text[i] == '.' || text[i] == 'e' || text[i] == 'n' || text[i] == 'i';
+		}
+		if(!reads_as_float)
+		{
+			length += snprintf(text + length, sizeof text - length, ".0");
+		}
+	}
+
+	struct el_linear_allocator * allocator = context;
+	char * dst = el_linear_alloc(allocator, FOLDED_LITERAL_SIZE);
+	e->number_literal = el_string_inplace_new(dst, FOLDED_LITERAL_SIZE, text, length);
+	assert(e->number_literal);
+	return true;
+}
+
+static void el_leave_number_literal(struct el_ast_expression * e, void * context)
+{
+	struct el_constant_folder * folder = context;
+	if(e->type_id == el_FLOAT_TYPE_ID)
+	{
+		e->float_value = strtod(e->number_literal, NULL);
+		return;
+	}
+
+	// The type checker has already checked the literal is made of digits
+	e->int_value = 0;
+	char const * digits = e->number_literal;
+	int length = el_string_length(e->number_literal);
+	for(int i = 0; i < length; ++i)
+	{
+		int digit = digits[i] - '0';
+		if(e->int_value > (LLONG_MAX - digit) / 10)
+		{
+			fprintf(stderr, "Number literal out of range %s\n", e->number_literal);
+			folder->err = folder->err ? folder->err : el_NUMBER_LITERAL_OUT_OF_RANGE_ERROR;
+			e->int_value = 0;
+			return;
+		}
+		e->int_value = e->int_value * 10 + digit;
+	}
+}
+
+static void el_leave_arithmetic(struct el_ast_expression * e, void * context)
+{
+	struct el_ast_expression const * lhs = e->binary_op.lhs;
+	struct el_ast_expression const * rhs = e->binary_op.rhs;
+	if(!el_is_constant(lhs) || !el_is_constant(rhs) || lhs->type_id != e->type_id || rhs->type_id != e->type_id)
+		return;
+
+	if(e->type_id == el_FLOAT_TYPE_ID)
+	{
+		double value = el_fold_float_op(e->type, lhs->float_value, rhs->float_value);
+		el_replace_with_literal(e, context);
+		e->float_value = value;
+		return;
+	}
+
+	long long value = 0;
+	if(el_fold_int_op(e->type, lhs->int_value, rhs->int_value, &value))
+	{
+		el_replace_with_literal(e, context);
+		e->int_value = value;
+	}
+}
+
+static void el_leave_comparison(struct el_ast_expression * e, void * context)
+{
+	struct el_ast_expression const * lhs = e->binary_op.lhs;
+	struct el_ast_expression const * rhs = e->binary_op.rhs;
+	long long value = 0;
+	if(lhs->type == el_AST_EXPR_STRING_LITERAL && rhs->type == el_AST_EXPR_STRING_LITERAL && e->type == el_AST_EXPR_EQUALS)
+	{
+		value = el_string_equals(lhs->string_literal, rhs->string_literal);
+	}
+	else if(!el_is_constant(lhs) || !el_is_constant(rhs) || lhs->type_id != rhs->type_id)
+	{
+		return;
+	}
+	else if(lhs->type_id == el_FLOAT_TYPE_ID)
+	{
+		// Every comparison with a NaN is false, as (a > b) - (a < b) would say they are equal
+		double a = lhs->float_value;
+		double b = rhs->float_value;
+		value = a != a || b != b ? 0 : el_compare(e->type, (a > b) - (a < b));
+	}
+	else
+	{
+		long long a = lhs->int_value;
+		long long b = rhs->int_value;
+		value = el_compare(e->type, (a > b) - (a < b));
+	}
+
+	el_replace_with_literal(e, context);
+	e->int_value = value;
+}
+
+static void el_leave_boolean(struct el_ast_expression * e, void * context)
+{
+	struct el_ast_expression const * lhs = e->binary_op.lhs;
+	struct el_ast_expression const * rhs = e->binary_op.rhs;
+	if(!el_is_constant(lhs) || !el_is_constant(rhs) || lhs->type_id != el_INT_TYPE_ID || rhs->type_id != el_INT_TYPE_ID)
+		return;
+
+	long long value = e->type == el_AST_EXPR_BOOLEAN_AND ? lhs->int_value != 0 && rhs->int_value != 0 : lhs->int_value != 0 || rhs->int_value != 0;
+	el_replace_with_literal(e, context);
+	e->int_value = value;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <compiler/syntax-parsing/ast.h>
+
+// Evaluate every number literal into its int_value or float_value, then replace each constant subtree with a single number literal
+// Arithmetic, comparisons and and/or of literals are folded, as are comparisons of string literals with ==
+// Ints are 64 bit and folded exactly, an operation which would overflow or divide by zero is left to run
+// Floats are folded with IEEE double semantics, so e.g. 1.0 / 0 folds to inf
+// The ast must have passed el_type_check, as folding relies on the type_id of each expression
+// Call at most once per ast, the text of folded literals is kept in ast->folded_literal_allocator
+int el_fold_constants(struct el_ast * ast);
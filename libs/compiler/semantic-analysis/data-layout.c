@@ -0,0 +1,135 @@
+#include "data-layout.h"
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <stdio.h>
+#include <assert.h>
+
+// Size and alignment of an int, float, string or reference
+#define VALUE_SIZE 8
+
+static struct el_ast_data_block const * el_data_block_of(struct el_type_table const * types, int type);
+static int el_num_block_fields(struct el_type_table const * types, int type);
+static void el_lay_out_block(struct el_type_layout * layout, int * offsets, struct el_type_layout const * layouts);
+static int el_align(int offset, int alignment);
+
+int el_compute_data_layout(struct el_data_layout * layout, struct el_type_table const * types)
+{
+	assert(layout && types);
+	*layout = (struct el_data_layout){ 0 };
+
+	int num_fields = 0;
+	for(int i = 0; i < types->num_types; ++i)
+	{
+		num_fields += el_num_block_fields(types, i);
+	}
+
+	layout->types = fmalloc(sizeof(struct el_type_layout) * (types->num_types > 0 ? types->num_types : 1));
+	layout->fields = fmalloc(sizeof(int) * 2 * (num_fields > 0 ? num_fields : 1));
+	if(!layout->types || !layout->fields)
+	{
+		el_data_layout_delete(layout);
+		fprintf(stderr, "Failed to allocate data layout\n");
+		return el_ALLOCATION_ERROR;
+	}
+	layout->num_types = types->num_types;
+
+	// Every value is the same size, s.t. blocks can be laid out once every type's value is
+	for(int i = 0; i < types->num_types; ++i)
+	{
+		struct el_type const * type = el_get_type(types, i);
+		bool is_void = type->kind == el_TYPE_VOID;
+		layout->types[i] = (struct el_type_layout){
+			.size = is_void ? 0 : VALUE_SIZE,
+			.alignment = is_void ? 1 : VALUE_SIZE,
+			.is_soa = el_is_soa_slice(types, i),
+			.block_size = VALUE_SIZE * type->num_lanes,
+			.block_alignment = type->kind == el_TYPE_VECTOR ? VALUE_SIZE : 0
+		};
+	}
+
+	int * offsets = layout->fields;
+	int * field_types = layout->fields + num_fields;
+	for(int i = 0; i < types->num_types; ++i)
+	{
+		struct el_type_layout * type_layout = &layout->types[i];
+		type_layout->num_fields = el_num_block_fields(types, i);
+		if(type_layout->num_fields == 0)
+			continue;
+
+		struct el_type const * type = el_get_type(types, i);
+		struct el_ast_data_block const * data_block = el_data_block_of(types, type->kind == el_TYPE_SLICE ? type->element_type : i);
+		for(int j = 0; j < type_layout->num_fields; ++j)
+		{
+			int field_type = data_block->var_declarations[j].type.type_id;
+			if(type_layout->is_soa)
+			{
+				field_type = el_get_type(types, field_type)->slice_type;
+				assert(field_type != el_NO_TYPE);
+			}
+			field_types[j] = field_type;
+		}
+		type_layout->field_offsets = offsets;
+		type_layout->field_types = field_types;
+		el_lay_out_block(type_layout, offsets, layout->types);
+		offsets += type_layout->num_fields;
+		field_types += type_layout->num_fields;
+	}
+	return el_SUCCESS;
+}
+
+void el_data_layout_delete(struct el_data_layout * layout)
+{
+	if(layout)
+	{
+		ffree(layout->types);
+		ffree(layout->fields);
+		*layout = (struct el_data_layout){ 0 };
+	}
+}
+
+bool el_is_soa_slice(struct el_type_table const * types, int type)
+{
+	struct el_type const * t = el_get_type(types, type);
+	if(t->kind != el_TYPE_SLICE || el_get_type(types, t->element_type)->kind != el_TYPE_DATA_BLOCK)
+		return false;
+
+	struct el_ast_data_block const * data_block = el_data_block_of(types, t->element_type);
+	return data_block->is_soa && data_block->num_var_declarations > 0;
+}
+
+static struct el_ast_data_block const * el_data_block_of(struct el_type_table const * types, int type)
+{
+	return types->symbols->symbols[el_get_type(types, type)->data_block].data_block;
+}
+
+static int el_num_block_fields(struct el_type_table const * types, int type)
+{
+	struct el_type const * t = el_get_type(types, type);
+	if(t->kind == el_TYPE_DATA_BLOCK)
+		return el_data_block_of(types, type)->num_var_declarations;
+	if(el_is_soa_slice(types, type))
+		return el_data_block_of(types, t->element_type)->num_var_declarations;
+	return 0;
+}
+
+// Fields are placed in order, each at the first offset aligned for it
+static void el_lay_out_block(struct el_type_layout * layout, int * offsets, struct el_type_layout const * layouts)
+{
+	int offset = 0;
+	int alignment = 1;
+	for(int i = 0; i < layout->num_fields; ++i)
+	{
+		struct el_type_layout const * field = &layouts[layout->field_types[i]];
+		offset = el_align(offset, field->alignment);
+		offsets[i] = offset;
+		offset += field->size;
+		alignment = field->alignment > alignment ? field->alignment : alignment;
+	}
+	layout->block_size = el_align(offset, alignment);
+	layout->block_alignment = alignment;
+}
+
+static int el_align(int offset, int alignment)
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "type-table.h"
+
+// How the vm and jit lay out a value of a type, every value they hold in a register, field or element takes 8 bytes
+// Data blocks and soa slices are references to a block, the block of a soa slice holds a column per field of its element type
+// Vectors are references to a block of their lanes, which are never written once built, NULL is the vector of zeros
+struct el_type_layout
+{
+	int size; // Of a value of the type, 0 for void
+	int alignment;
+
+	bool is_soa; // A slice of a soa data block, whose elements are stored field by field in its columns
+	int num_fields; // Fields of the block the type references, or columns of a soa slice, 0 for any other type
+	int const * field_offsets; // Byte offset of each field in the block
+	int const * field_types; // Type of each field, the slice type of each column
+	int block_size; // A multiple of block_alignment
+	int block_alignment;
+};
+
+struct el_data_layout
+{
+	struct el_type_layout * types; // Indexed by type id
+	int num_types;
+	int * fields; // Offsets and types of the fields of every block, which the layouts view
+};
+
+// Lay out every type of the table, which must be complete, i.e. the ast has been type checked
+// The slice type of every field of a soa data block must have been interned, see el_intern_ast_types
+int el_compute_data_layout(struct el_data_layout * layout, struct el_type_table const * types);
+
+void el_data_layout_delete(struct el_data_layout * layout);
+
+// Returns true if type is a slice whose element type is a soa data block with at least one field
+// Slices of a data block without fields keep references to its elements, as there are no columns to hold their length
+bool el_is_soa_slice(struct el_type_table const * types, int type);
+
+static inline struct el_type_layout const * el_get_layout(struct el_data_layout const * layout, int type)
+{
+	return &layout->types[type];
+}
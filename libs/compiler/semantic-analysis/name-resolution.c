@@ -0,0 +1,344 @@
+#include "name-resolution.h"
+#include <compiler/error.h>
+#include <compiler/syntax-parsing/parser.h>
+#include <stdio.h>
+#include <assert.h>
+
+#define INITIAL_NUM_PENDING_EXPRESSIONS 64
+
+struct el_name_resolver
+{
+	struct el_ast * ast;
+	struct el_symbol_table * table;
+
+	// Expressions still to be resolved, s.t. deep expressions are walked without recursion
+	el_VECTOR_MEMBERS(struct el_ast_expression *, pending);
+
+	// First undeclared or redeclared name, resolution carries on past these to report every one
+	int err;
+};
+
+static int el_hoist_declarations(struct el_name_resolver * r, struct el_ast_statement_list * list, bool is_file_scope);
+static int el_resolve_statement_list(struct el_name_resolver * r, struct el_ast_statement_list * list);
+static int el_resolve_block(struct el_name_resolver * r, struct el_ast_statement_list * list, int scope_kind);
+static int el_resolve_statement(struct el_name_resolver * r, struct el_ast_statement * statement);
+static int el_resolve_data_block(struct el_name_resolver * r, struct el_ast_data_block * data_block);
+static int el_resolve_function(struct el_name_resolver * r, struct el_ast_function_definition * function);
+static int el_resolve_for_statement(struct el_name_resolver * r, struct el_ast_for_statement * for_statement);
+static int el_resolve_if_statement(struct el_name_resolver * r, struct el_ast_if_statement * if_statement);
+static int el_resolve_assignment(struct el_name_resolver * r, struct el_ast_assignment * assignment);
+static int el_resolve_expression(struct el_name_resolver * r, struct el_ast_expression * expression);
+static void el_resolve_type(struct el_name_resolver * r, struct el_ast_var_type * var_type);
+
+static int el_declare(struct el_name_resolver * r, int kind, el_string name, void * node, int * symbol);
+static void el_report(struct el_name_resolver * r, int err, char const * message, el_string name);
+
+int el_resolve_names(struct el_ast * ast, struct el_symbol_table * table)
+{
+	assert(ast && table && table->num_scopes == 0);
+	struct el_name_resolver r = { .ast = ast, .table = table, .err = el_SUCCESS };
+	if(!el_vector_reserve(&r, pending, INITIAL_NUM_PENDING_EXPRESSIONS, NULL) || !el_open_scope(table, el_SCOPE_FILE))
+	{
+		el_vector_free(&r, pending, NULL);
+		fprintf(stderr, "Failed to allocate name resolver\n");
+		return el_ALLOCATION_ERROR;
+	}
+
+	// The file scope is left open s.t. its symbols can still be looked up afterwards
+	int err = el_hoist_declarations(&r, &ast->root, true);
+	err = err || el_resolve_statement_list(&r, &ast->root);
+
+	el_vector_free(&r, pending, NULL);
+	if(err == el_ALLOCATION_ERROR)
+	{
+		fprintf(stderr, "Failed to allocate symbol table\n");
+	}
+	return err ? err : r.err;
+}
+
+// Declare the data blocks and functions of a statement list before any statement is resolved, s.t. they may be used before their definition
+// Variables assigned at file scope are declared likewise
+static int el_hoist_declarations(struct el_name_resolver * r, struct el_ast_statement_list * list, bool is_file_scope)
+{
+	int err = 0;
+	int symbol = el_NO_SYMBOL;
+	for(int i = 0; i < list->num_statements && err == 0; ++i)
+	{
+		struct el_ast_statement * statement = &list->statements[i];
+		switch(statement->type)
+		{
+		case el_AST_NODE_DATA_BLOCK:
+			err = el_declare(r, el_SYMBOL_DATA_BLOCK, statement->data_block.name, &statement->data_block, &symbol);
+			break;
+		case el_AST_NODE_FUNCTION_DEFINITION:
+			err = el_declare(r, el_SYMBOL_FUNCTION, statement->function_definition.name, &statement->function_definition, &symbol);
+			break;
+		case el_AST_NODE_ASSIGNMENT:
+		{
+			// Later assignments to the same name refer back to the first
+			struct el_ast_expression * lhs = &statement->assignment.lhs;
+			if(is_file_scope && lhs->type == el_AST_EXPR_IDENTIFIER && el_lookup_symbol(r->table, el_string_view_of(lhs->identifier)) == el_NO_SYMBOL)
+			{
+				err = el_declare(r, el_SYMBOL_VARIABLE, lhs->identifier, lhs, &symbol);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	return err;
+}
+
+static int el_resolve_statement_list(struct el_name_resolver * r, struct el_ast_statement_list * list)
+{
+	int err = 0;
+	for(int i = 0; i < list->num_statements && err == 0; ++i)
+	{
+		err = el_resolve_statement(r, &list->statements[i]);
+	}
+	return err;
+}
+
+// Resolve a statement list in a scope of its own
+static int el_resolve_block(struct el_name_resolver * r, struct el_ast_statement_list * list, int scope_kind)
+{
+	if(!el_open_scope(r->table, scope_kind))
+		return el_ALLOCATION_ERROR;
+
+	int err = el_hoist_declarations(r, list, false);
+	err = err || el_resolve_statement_list(r, list);
+	el_close_scope(r->table);
+	return err;
+}
+
+static int el_resolve_statement(struct el_name_resolver * r, struct el_ast_statement * statement)
+{
+	switch(statement->type)
+	{
+	case el_AST_NODE_DATA_BLOCK:
+		return el_resolve_data_block(r, &statement->data_block);
+	case el_AST_NODE_FUNCTION_DEFINITION:
+		return el_resolve_function(r, &statement->function_definition);
+	case el_AST_NODE_FOR_STATEMENT:
+		return el_resolve_for_statement(r, &statement->for_statement);
+	case el_AST_NODE_IF_STATEMENT:
+		return el_resolve_if_statement(r, &statement->if_statement);
+	case el_AST_NODE_ASSIGNMENT:
+		return el_resolve_assignment(r, &statement->assignment);
+	case el_AST_NODE_RETURN_STATEMENT:
+		return el_resolve_expression(r, &statement->return_statement.expression);
+	case el_AST_NODE_EXPRESSION:
+		return el_resolve_expression(r, &statement->expression);
+	default:
+		assert(false);
+		return el_SUCCESS;
+	}
+}
+
+static int el_resolve_data_block(struct el_name_resolver * r, struct el_ast_data_block * data_block)
+{
+	for(int i = 0; i < data_block->num_var_declarations; ++i)
+	{
+		el_resolve_type(r, &data_block->var_declarations[i].type);
+	}
+	return el_SUCCESS;
+}
+
+static int el_resolve_function(struct el_name_resolver * r, struct el_ast_function_definition * function)
+{
+	el_resolve_type(r, &function->return_type);
+	if(!el_open_scope(r->table, el_SCOPE_FUNCTION))
+		return el_ALLOCATION_ERROR;
+
+	int err = 0;
+	int symbol = el_NO_SYMBOL;
+	for(int i = 0; i < function->parameter_list.num_parameters && err == 0; ++i)
+	{
+		struct el_ast_var_decl * parameter = &function->parameter_list.parameters[i];
+		el_resolve_type(r, &parameter->type);
+		err = el_declare(r, el_SYMBOL_PARAMETER, parameter->name, parameter, &symbol);
+	}
+
+	// A body skipped by a lazy parse is parsed when it is first reached, one which fails to parse is reported and left unresolved
+	if(err == 0 && !function->is_code_block_parsed)
+	{
+		int parse_err = el_parse_function_body(r->ast, function);
+		r->err = r->err ? r->err : parse_err;
+	}
+
+	// The body shares the scope of the parameters, s.t. assigning to a parameter does not declare a new variable
+	if(function->is_code_block_parsed)
+	{
+		err = err || el_hoist_declarations(r, &function->code_block, false);
+		err = err || el_resolve_statement_list(r, &function->code_block);
+	}
+	el_close_scope(r->table);
+	return err;
+}
+
+static int el_resolve_for_statement(struct el_name_resolver * r, struct el_ast_for_statement * for_statement)
+{
+	// The range is evaluated before the loop variables exist
+	int err = el_resolve_expression(r, &for_statement->range);
+
+	// Reductions name variables declared before the loop, which its chunks accumulate into
+	for(int i = 0; i < for_statement->num_reductions; ++i)
+	{
+		struct el_ast_reduction * reduction = &for_statement->reductions[i];
+		reduction->symbol = el_lookup_symbol(r->table, el_string_view_of(reduction->var_name));
+		if(reduction->symbol == el_NO_SYMBOL)
+		{
+			el_report(r, el_UNDECLARED_IDENTIFIER_ERROR, "Undeclared reduction variable", reduction->var_name);
+		}
+	}
+	if(err || !el_open_scope(r->table, el_SCOPE_FOR))
+		return err ? err : el_ALLOCATION_ERROR;
+
+	err = err || el_declare(r, el_SYMBOL_FOR_INDEX, for_statement->index_var_name, for_statement, &for_statement->index_symbol);
+	err = err || el_declare(r, el_SYMBOL_FOR_VALUE, for_statement->value_var_name, for_statement, &for_statement->value_symbol);
+	err = err || el_hoist_declarations(r, &for_statement->code_block, false);
+	err = err || el_resolve_statement_list(r, &for_statement->code_block);
+	el_close_scope(r->table);
+	return err;
+}
+
+static int el_resolve_if_statement(struct el_name_resolver * r, struct el_ast_if_statement * if_statement)
+{
+	int err = el_resolve_expression(r, &if_statement->expression);
+	err = err || el_resolve_block(r, &if_statement->code_block, el_SCOPE_BLOCK);
+	for(int i = 0; i < if_statement->num_elif_statements && err == 0; ++i)
+	{
+		struct el_ast_elif_statement * elif_statement = &if_statement->elif_statements[i];
+		err = err || el_resolve_expression(r, &elif_statement->expression);
+		err = err || el_resolve_block(r, &elif_statement->code_block, el_SCOPE_BLOCK);
+	}
+	if(if_statement->else_statement)
+	{
+		err = err || el_resolve_block(r, if_statement->else_statement, el_SCOPE_BLOCK);
+	}
+	return err;
+}
+
+static int el_resolve_assignment(struct el_name_resolver * r, struct el_ast_assignment * assignment)
+{
+	// The rhs is resolved first, s.t. a variable cannot be used in the assignment which declares it
+	int err = el_resolve_expression(r, &assignment->rhs);
+	if(err)
+		return err;
+
+	struct el_ast_expression * lhs = &assignment->lhs;
+	if(lhs->type != el_AST_EXPR_IDENTIFIER)
+		return el_resolve_expression(r, lhs);
+
+	int symbol = el_lookup_symbol(r->table, el_string_view_of(lhs->identifier));
+	if(symbol == el_NO_SYMBOL)
+	{
+		err = el_declare(r, el_SYMBOL_VARIABLE, lhs->identifier, lhs, &symbol);
+	}
+	lhs->symbol = symbol;
+	return err;
+}
+
+static int el_resolve_expression(struct el_name_resolver * r, struct el_ast_expression * expression)
+{
+	r->num_pending = 0;
+	*el_vector_push(r, pending, NULL) = expression;
+	while(r->num_pending > 0)
+	{
+		struct el_ast_expression * e = r->pending[--r->num_pending];
+
+		// Children are pushed in reverse s.t. names are reported in source order
+		struct el_ast_expression * children[2] = { NULL, NULL };
+		switch(e->type)
+		{
+		case el_AST_EXPR_IDENTIFIER:
+			e->symbol = el_lookup_symbol(r->table, el_string_view_of(e->identifier));
+			if(e->symbol == el_NO_SYMBOL)
+			{
+				el_report(r, el_UNDECLARED_IDENTIFIER_ERROR, "Undeclared identifier", e->identifier);
+			}
+			break;
+		case el_AST_EXPR_NUMBER_LITERAL:
+		case el_AST_EXPR_STRING_LITERAL:
+		case el_AST_EXPR_VECTOR_TYPE:
+			break;
+		case el_AST_EXPR_DOT:
+			children[0] = e->binary_op.lhs;
+			break;
+		case el_AST_EXPR_SLICE_LITERAL:
+		case el_AST_EXPR_ARGUMENTS:
+			if(!el_vector_reserve(r, pending, r->num_pending + e->expression_list->num_expressions, NULL))
+				return el_ALLOCATION_ERROR;
+			for(int i = e->expression_list->num_expressions - 1; i >= 0; --i)
+			{
+				r->pending[r->num_pending++] = &e->expression_list->expressions[i];
+			}
+			break;
+		default:
+			children[0] = e->binary_op.rhs;
+			children[1] = e->binary_op.lhs;
+			break;
+		}
+
+		for(int i = 0; i < 2; ++i)
+		{
+			if(!children[i])
+				continue;
+			struct el_ast_expression ** pending = el_vector_push(r, pending, NULL);
+			if(!pending)
+				return el_ALLOCATION_ERROR;
+			*pending = children[i];
+		}
+	}
+	return el_SUCCESS;
+}
+
+static void el_resolve_type(struct el_name_resolver * r, struct el_ast_var_type * var_type)
+{
+	if(var_type->is_native)
+		return;
+
+	var_type->symbol = el_lookup_symbol(r->table, el_string_view_of(var_type->custom_type));
+	if(var_type->symbol == el_NO_SYMBOL || r->table->symbols[var_type->symbol].kind != el_SYMBOL_DATA_BLOCK)
+	{
+		var_type->symbol = el_NO_SYMBOL;
+		el_report(r, el_UNDECLARED_TYPE_ERROR, "Undeclared type", var_type->custom_type);
+	}
+}
+
+// Declare name in the current scope, a name declared twice in one scope keeps its first symbol
+static int el_declare(struct el_name_resolver * r, int kind, el_string name, void * node, int * symbol)
+{
+	struct el_symbol_table * table = r->table;
+	int id = el_intern_name(table, el_string_view_of(name));
+	if(id < 0)
+		return el_ALLOCATION_ERROR;
+
+	int bound = table->bindings[id];
+	if(bound != el_NO_SYMBOL && table->symbols[bound].scope == table->current_scope)
+	{
+		el_report(r, el_REDECLARED_SYMBOL_ERROR, "Redeclared symbol", name);
+		*symbol = bound;
+		return el_SUCCESS;
+	}
+
+	*symbol = el_declare_symbol(table, kind, id, node);
+	if(*symbol == el_NO_SYMBOL)
+		return el_ALLOCATION_ERROR;
+
+	if(kind == el_SYMBOL_VARIABLE)
+	{
+		((struct el_ast_expression *)node)->symbol = *symbol;
+	}
+	return el_SUCCESS;
+}
+
+static void el_report(struct el_name_resolver * r, int err, char const * message, el_string name)
+{
+	fprintf(stderr, "%s %s\n", message, name);
+	if(r->err == el_SUCCESS)
+	{
+		r->err = err;
+	}
+}
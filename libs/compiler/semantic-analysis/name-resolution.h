@@ -0,0 +1,11 @@
+#pragma once
+#include "symbol-table.h"
+
+// Bind every identifier and custom type in the ast to the symbol of its declaration, see el_ast_expression.symbol
+// table must be new, it receives a scope for the file, each function, each for statement and each if, elif and else body
+// Data blocks and functions are visible throughout the statement list they are declared in, as are variables assigned at file scope
+// Other variables are declared by the first assignment to a name which is not yet bound, and are visible until the end of their scope
+// The rhs of a dot names a field, which is left for type checking to resolve
+// Bodies of functions skipped by a lazy parse are parsed as they are reached, see el_parse_function_body
+// Every undeclared name is reported, the error returned is the first encountered
+int el_resolve_names(struct el_ast * ast, struct el_symbol_table * table);
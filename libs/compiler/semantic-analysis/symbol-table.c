@@ -0,0 +1,142 @@
+#include "symbol-table.h"
+#include <assert.h>
+
+#define INITIAL_NUM_NAMES 256
+#define INITIAL_NUM_SYMBOLS 256
+#define INITIAL_NUM_SCOPES 64
+
+static uint64_t el_hashed_name_hash(void const * key);
+static bool el_hashed_name_equals(void const * key1, void const * key2);
+
+bool el_symbol_table_new(struct el_symbol_table * table)
+{
+	assert(table);
+	*table = (struct el_symbol_table){ .current_scope = -1 };
+	bool created = el_hash_map_new(&table->name_ids, sizeof(struct el_hashed_string_view), sizeof(int), INITIAL_NUM_NAMES, el_hashed_name_hash, el_hashed_name_equals, NULL);
+	created = created && el_vector_reserve(table, names, INITIAL_NUM_NAMES, NULL);
+	created = created && el_vector_reserve(table, bindings, INITIAL_NUM_NAMES, NULL);
+	created = created && el_vector_reserve(table, symbols, INITIAL_NUM_SYMBOLS, NULL);
+	created = created && el_vector_reserve(table, scopes, INITIAL_NUM_SCOPES, NULL);
+	created = created && el_vector_reserve(table, open_symbols, INITIAL_NUM_SYMBOLS, NULL);
+	if(!created)
+	{
+		el_symbol_table_delete(table);
+	}
+	return created;
+}
+
+void el_symbol_table_delete(struct el_symbol_table * table)
+{
+	if(!table)
+		return;
+
+	el_hash_map_delete(&table->name_ids);
+	el_vector_free(table, names, NULL);
+	el_vector_free(table, bindings, NULL);
+	el_vector_free(table, symbols, NULL);
+	el_vector_free(table, scopes, NULL);
+	el_vector_free(table, open_symbols, NULL);
+	table->current_scope = -1;
+}
+
+int el_intern_name(struct el_symbol_table * table, struct el_string_view name)
+{
+	struct el_hashed_string_view key = el_hashed_string_view_new(name);
+	bool inserted = false;
+	int * id = el_hash_map_insert_hashed(&table->name_ids, &key, key.hash, &inserted);
+	if(!id)
+		return -1;
+	if(!inserted)
+		return *id;
+
+	// Every name starts out unbound
+	struct el_string_view * interned = el_vector_push(table, names, NULL);
+	int * binding = el_vector_push(table, bindings, NULL);
+	if(!interned || !binding)
+	{
+		table->num_names -= interned ? 1 : 0;
+		table->num_bindings -= binding ? 1 : 0;
+		el_hash_map_remove(&table->name_ids, &key);
+		return -1;
+	}
+	*interned = name;
+	*binding = el_NO_SYMBOL;
+	*id = table->num_names - 1;
+	return *id;
+}
+
+int el_find_name(struct el_symbol_table const * table, struct el_string_view name)
+{
+	struct el_hashed_string_view key = el_hashed_string_view_new(name);
+	int const * id = el_hash_map_find_hashed(&table->name_ids, &key, key.hash);
+	return id ? *id : -1;
+}
+
+int el_lookup_symbol(struct el_symbol_table const * table, struct el_string_view name)
+{
+	int id = el_find_name(table, name);
+	return id >= 0 ? table->bindings[id] : el_NO_SYMBOL;
+}
+
+bool el_open_scope(struct el_symbol_table * table, int kind)
+{
+	struct el_scope * scope = el_vector_push(table, scopes, NULL);
+	if(!scope)
+		return false;
+
+	scope->kind = kind;
+	scope->parent = table->current_scope;
+	scope->num_open_symbols = table->num_open_symbols;
+	table->current_scope = table->num_scopes - 1;
+	return true;
+}
+
+void el_close_scope(struct el_symbol_table * table)
+{
+	assert(table->current_scope >= 0);
+	struct el_scope const * scope = &table->scopes[table->current_scope];
+
+	// Symbols are unbound in reverse, s.t. each name ends up bound to what it was before the scope opened
+	while(table->num_open_symbols > scope->num_open_symbols)
+	{
+		struct el_symbol const * symbol = &table->symbols[table->open_symbols[--table->num_open_symbols]];
+		table->bindings[symbol->name] = symbol->shadowed;
+	}
+	table->current_scope = scope->parent;
+}
+
+int el_declare_symbol(struct el_symbol_table * table, int kind, int name, void * node)
+{
+	assert(table->current_scope >= 0 && name >= 0 && name < table->num_bindings);
+	struct el_symbol * symbol = el_vector_push(table, symbols, NULL);
+	if(!symbol)
+		return el_NO_SYMBOL;
+
+	int * open_symbol = el_vector_push(table, open_symbols, NULL);
+	if(!open_symbol)
+	{
+		--table->num_symbols;
+		return el_NO_SYMBOL;
+	}
+
+	int index = table->num_symbols - 1;
+	symbol->kind = kind;
+	symbol->name = name;
+	symbol->scope = table->current_scope;
+	symbol->shadowed = table->bindings[name];
+	symbol->type_id = el_NO_TYPE;
+	symbol->node = node;
+	*open_symbol = index;
+	table->bindings[name] = index;
+	return index;
+}
+
+static uint64_t el_hashed_name_hash(void const * key)
+{
+	return ((struct el_hashed_string_view const *)key)->hash;
+}
+
+static bool el_hashed_name_equals(void const * key1, void const * key2)
+{
+	return el_hashed_string_view_equals(key1, key2);
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <compiler/syntax-parsing/ast.h>
+#include <containers/hash-map.h>
+#include <containers/string-view.h>
+#include <containers/vector.h>
+
+enum el_symbol_kind
+{
+	el_SYMBOL_DATA_BLOCK,
+	el_SYMBOL_FUNCTION,
+	el_SYMBOL_PARAMETER,
+	el_SYMBOL_VARIABLE, // Declared by the first assignment to its name
+	el_SYMBOL_FOR_INDEX,
+	el_SYMBOL_FOR_VALUE
+};
+
+enum el_scope_kind
+{
+	el_SCOPE_FILE,
+	el_SCOPE_FUNCTION,
+	el_SCOPE_FOR,
+	el_SCOPE_BLOCK // Body of an if, elif or else
+};
+
+struct el_symbol
+{
+	int kind;
+	int name; // Interned, see el_intern_name
+	int scope;
+	int shadowed; // Symbol of the same name hidden by this one while its scope is open, or el_NO_SYMBOL
+	int type_id; // Type of a variable, the return type of a function, set by el_type_check
+
+	union
+	{
+		struct el_ast_data_block * data_block;
+		struct el_ast_function_definition * function_definition;
+		struct el_ast_var_decl * parameter;
+		struct el_ast_for_statement * for_statement;
+		struct el_ast_expression * variable; // Identifier of the assignment which declared the variable
+		void * node;
+	};
+};
+
+struct el_scope
+{
+	int kind;
+	int parent; // -1 for the file scope
+	int num_open_symbols; // Number of open symbols when the scope was opened
+};
+
+// Symbols of every scope of a module, along with the names they were declared with
+// Each name is interned once, s.t. a name is an int and looking up the symbol it is bound to is an array index
+struct el_symbol_table
+{
+	// Names view the strings of the ast, which must outlive the table
+	struct el_hash_map name_ids; // el_hashed_string_view -> int
+	el_VECTOR_MEMBERS(struct el_string_view, names);
+
+	// Innermost symbol each name is bound to in the open scopes, indexed by name
+	// Once names are resolved only the file scope is open
+	el_VECTOR_MEMBERS(int, bindings);
+
+	el_VECTOR_MEMBERS(struct el_symbol, symbols);
+	el_VECTOR_MEMBERS(struct el_scope, scopes);
+
+	// Symbols of the open scopes in the order they were declared
+	el_VECTOR_MEMBERS(int, open_symbols);
+	int current_scope;
+};
+
+bool el_symbol_table_new(struct el_symbol_table * table);
+
+void el_symbol_table_delete(struct el_symbol_table * table);
+
+// Returns the id of name, interning it if it has not been seen before, or -1 if the table failed to grow
+int el_intern_name(struct el_symbol_table * table, struct el_string_view name);
+
+// Returns the id of name or -1 if it was never interned
+int el_find_name(struct el_symbol_table const * table, struct el_string_view name);
+
+// Returns the innermost symbol name is bound to in the open scopes, or el_NO_SYMBOL
+int el_lookup_symbol(struct el_symbol_table const * table, struct el_string_view name);
+
+// Open a scope nested in the current scope, returns false if the table failed to grow
+bool el_open_scope(struct el_symbol_table * table, int kind);
+
+// Close the current scope, unbinding its symbols s.t. the symbols they shadowed are visible again
+void el_close_scope(struct el_symbol_table * table);
+
+// Declare a symbol in the current scope and bind its name to it
+// node is the ast node of the declaration, see el_symbol
+// Returns the symbol or el_NO_SYMBOL if the table failed to grow
+int el_declare_symbol(struct el_symbol_table * table, int kind, int name, void * node);
+
+static inline struct el_string_view el_symbol_name(struct el_symbol_table const * table, int symbol)
+{
+	return table->names[table->symbols[symbol].name];
+}
@@ -0,0 +1,1066 @@
+#include "type-checker.h"
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <compiler/lexing/lexer.h>
+#include <compiler/semantic-analysis/data-layout.h>
+#include <compiler/syntax-parsing/ast-visitor.h>
+#include <threads/thread-pool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define NUM_CHECK_TASKS_PER_THREAD 4
+#define MIN_FUNCTIONS_PER_CHECK_TASK 16
+
+// Symbol of the rhs of a dot until its field is found, s.t. field names are not taken for undeclared identifiers
+#define FIELD_NAME_SYMBOL (el_NO_SYMBOL - 1)
+
+// State shared by every checker, which is only read once function bodies are being checked
+struct el_type_check
+{
+	struct el_symbol_table * symbols;
+	struct el_type_table * types;
+
+	// Interned names of the fields of every data block, those of each block contiguous
+	el_VECTOR_MEMBERS(int, field_names);
+	int * first_field_names; // Indexed by data block symbol
+
+	el_VECTOR_MEMBERS(struct el_ast_function_definition *, functions);
+};
+
+struct el_type_checker
+{
+	struct el_type_check const * check;
+	struct el_ast_function_definition * function; // NULL at file scope
+	struct el_ast_for_statement * parallel_for; // Innermost parallel for being checked, NULL outside of one
+	struct el_ast_visitor visitor;
+
+	// Types cannot be interned while checkers run concurrently, so a checker which needs a new type gives up and is re-run alone
+	bool is_concurrent;
+	bool needs_serial_check;
+
+	// Reports are collected s.t. they can be printed in source order however the checks were scheduled
+	struct el_string_builder messages;
+	int err;
+};
+
+// Functions [first_function, end_function) are checked by one task
+struct el_check_task
+{
+	int first_function;
+	int end_function;
+	struct el_type_checker checker;
+};
+
+struct el_parallel_check
+{
+	struct el_type_check const * check;
+	struct el_check_task * tasks;
+};
+
+static int el_gather_declarations(struct el_type_check * check, struct el_ast * ast);
+static int el_check_functions(struct el_type_check const * check, int flags, struct el_check_task ** out_tasks, int * out_num_tasks);
+static void el_check_task_main(void * context, int task_index, int thread_index);
+static void el_run_check_task(struct el_type_check const * check, struct el_check_task * task);
+
+static void el_type_checker_new(struct el_type_checker * c, struct el_type_check const * check, bool is_concurrent);
+static void el_type_checker_delete(struct el_type_checker * c);
+static void el_check_function(struct el_type_checker * c, struct el_ast_function_definition * function);
+static void el_check_statements(struct el_type_checker * c, struct el_ast_statement_list * list);
+static void el_check_statement(struct el_type_checker * c, struct el_ast_statement * statement);
+static void el_check_for_statement(struct el_type_checker * c, struct el_ast_for_statement * for_statement);
+static void el_check_reductions(struct el_type_checker * c, struct el_ast_for_statement * for_statement);
+static bool el_is_private_to(struct el_type_checker const * c, struct el_ast_for_statement const * for_statement, int symbol);
+static void el_check_if_statement(struct el_type_checker * c, struct el_ast_if_statement * if_statement);
+static void el_check_assignment(struct el_type_checker * c, struct el_ast_assignment * assignment);
+static void el_check_return(struct el_type_checker * c, struct el_ast_return_statement * return_statement);
+static void el_check_condition(struct el_type_checker * c, struct el_ast_expression * condition);
+static int el_check_expression(struct el_type_checker * c, struct el_ast_expression * expression);
+
+static bool el_enter_dot(struct el_ast_expression * e, void * context);
+static void el_leave_number_literal(struct el_ast_expression * e, void * context);
+static void el_leave_string_literal(struct el_ast_expression * e, void * context);
+static void el_leave_identifier(struct el_ast_expression * e, void * context);
+static void el_leave_vector_type(struct el_ast_expression * e, void * context);
+static void el_leave_arithmetic(struct el_ast_expression * e, void * context);
+static void el_leave_comparison(struct el_ast_expression * e, void * context);
+static void el_leave_boolean(struct el_ast_expression * e, void * context);
+static void el_leave_dot(struct el_ast_expression * e, void * context);
+static void el_leave_function_call(struct el_ast_expression * e, void * context);
+static void el_leave_slice_index(struct el_ast_expression * e, void * context);
+static void el_leave_slice_literal(struct el_ast_expression * e, void * context);
+static void el_leave_arguments(struct el_ast_expression * e, void * context);
+
+static int el_operand_type(struct el_type_checker * c, struct el_ast_expression * e);
+static int el_unify_operands(struct el_type_checker * c, struct el_ast_expression * e, char const * operator);
+static bool el_coerce(struct el_type_checker * c, struct el_ast_expression * e, int expected);
+static void el_coerce_or_report(struct el_type_checker * c, struct el_ast_expression * e, int expected, char const * what);
+static void el_check_arguments(struct el_type_checker * c, struct el_ast_expression_list * arguments, struct el_ast_var_decl const * var_decls, int num_var_decls, el_string callee);
+static int el_find_slice_type(struct el_type_checker * c, int element_type);
+static bool el_is_numeric(struct el_type_checker const * c, int type);
+static bool el_is_vector(struct el_type_checker const * c, int type);
+static bool el_is_soa_element(struct el_type_checker const * c, struct el_ast_expression const * e);
+static void el_check_not_soa_element(struct el_type_checker * c, struct el_ast_expression const * e);
+static void el_check_soa_store(struct el_type_checker * c, struct el_ast_expression const * e);
+
+static void el_report(struct el_type_checker * c, int err, char const * message, el_string name);
+static void el_report_types(struct el_type_checker * c, int err, char const * message, int expected, int actual);
+static void el_report_operand(struct el_type_checker * c, char const * operator, int type);
+static void el_begin_report(struct el_type_checker * c, int err);
+
+static char const * operator_names[el_ast_expression_type_count] = {
+	[el_AST_EXPR_EQUALS] = "==",
+	[el_AST_EXPR_GREATER_THAN] = ">",
+	[el_AST_EXPR_LESS_THAN] = "<",
+	[el_AST_EXPR_GEQUALS] = ">=",
+	[el_AST_EXPR_LEQUALS] = "<=",
+	[el_AST_EXPR_BOOLEAN_AND] = "and",
+	[el_AST_EXPR_BOOLEAN_OR] = "or",
+	[el_AST_EXPR_ADD] = "+",
+	[el_AST_EXPR_SUB] = "-",
+	[el_AST_EXPR_MUL] = "*",
+	[el_AST_EXPR_DIV] = "/"
+};
+
+int el_type_check(struct el_ast * ast, struct el_symbol_table * symbols, struct el_type_table * types, int flags)
+{
+	assert(ast && symbols && types);
+	struct el_type_check check = { .symbols = symbols, .types = types };
+	struct el_check_task * tasks = NULL;
+	int num_tasks = 0;
+
+	int err = el_gather_declarations(&check, ast);
+
+	// File scope statements may declare the global variables any function uses, so are checked first
+	struct el_type_checker file_checker;
+	el_type_checker_new(&file_checker, &check, false);
+	if(err == 0)
+	{
+		el_check_statements(&file_checker, &ast->root);
+	}
+
+	if(err == 0 && check.num_functions > 0)
+	{
+		err = el_check_functions(&check, flags, &tasks, &num_tasks);
+	}
+
+	// Reports are printed in order, file scope first then each function
+	fwrite(file_checker.messages.chars, 1, file_checker.messages.num_chars, stderr);
+	int check_err = file_checker.err;
+	el_type_checker_delete(&file_checker);
+	for(int i = 0; i < num_tasks; ++i)
+	{
+		fwrite(tasks[i].checker.messages.chars, 1, tasks[i].checker.messages.num_chars, stderr);
+		check_err = check_err ? check_err : tasks[i].checker.err;
+		el_type_checker_delete(&tasks[i].checker);
+	}
+	ffree(tasks);
+
+	el_vector_free(&check, field_names, NULL);
+	el_vector_free(&check, functions, NULL);
+	ffree(check.first_field_names);
+
+	if(err == el_ALLOCATION_ERROR)
+	{
+		fprintf(stderr, "Failed to allocate type checker\n");
+	}
+	return err ? err : check_err;
+}
+
+// Set the types of every function, parameter and data block symbol, s.t. any function body can be checked without the others
+static int el_gather_declarations(struct el_type_check * check, struct el_ast * ast)
+{
+	struct el_symbol_table * symbols = check->symbols;
+	struct el_type_table * types = check->types;
+	check->first_field_names = fmalloc(sizeof(int) * (symbols->num_symbols > 0 ? symbols->num_symbols : 1));
+	if(!check->first_field_names)
+		return el_ALLOCATION_ERROR;
+
+	for(int i = 0; i < symbols->num_symbols; ++i)
+	{
+		struct el_symbol * symbol = &symbols->symbols[i];
+		check->first_field_names[i] = -1;
+		switch(symbol->kind)
+		{
+		case el_SYMBOL_DATA_BLOCK:
+		{
+			symbol->type_id = el_data_block_type(types, i);
+			if(symbol->type_id == el_NO_TYPE)
+				return el_ALLOCATION_ERROR;
+
+			check->first_field_names[i] = check->num_field_names;
+			struct el_ast_data_block const * data_block = symbol->data_block;
+			for(int j = 0; j < data_block->num_var_declarations; ++j)
+			{
+				int * field_name = el_vector_push(check, field_names, NULL);
+				if(!field_name)
+					return el_ALLOCATION_ERROR;
+				*field_name = el_intern_name(symbols, el_string_view_of(data_block->var_declarations[j].name));
+				if(*field_name < 0)
+					return el_ALLOCATION_ERROR;
+			}
+			break;
+		}
+		case el_SYMBOL_FUNCTION:
+			symbol->type_id = symbol->function_definition->return_type.type_id;
+			break;
+		case el_SYMBOL_PARAMETER:
+			symbol->type_id = symbol->parameter->type.type_id;
+			break;
+		default:
+			symbol->type_id = el_NO_TYPE;
+			break;
+		}
+	}
+
+	// Functions are only declared at file scope
+	for(int i = 0; i < ast->root.num_statements; ++i)
+	{
+		struct el_ast_statement * statement = &ast->root.statements[i];
+		if(statement->type != el_AST_NODE_FUNCTION_DEFINITION || !statement->function_definition.is_code_block_parsed)
+			continue;
+
+		struct el_ast_function_definition ** function = el_vector_push(check, functions, NULL);
+		if(!function)
+			return el_ALLOCATION_ERROR;
+		*function = &statement->function_definition;
+	}
+
+	// Slices of every type so far are interned up front, s.t. concurrent checkers rarely need a type which does not exist
+	int num_types = types->num_types;
+	for(int i = 0; i < num_types; ++i)
+	{
+		if(el_slice_type(types, i) == el_NO_TYPE)
+			return el_ALLOCATION_ERROR;
+	}
+	return el_SUCCESS;
+}
+
+// Check every function body, split into tasks of roughly equal numbers of functions
+static int el_check_functions(struct el_type_check const * check, int flags, struct el_check_task ** out_tasks, int * out_num_tasks)
+{
+	struct el_thread_pool pool;
+	bool is_parallel = (flags & el_TYPE_CHECK_PARALLEL) != 0;
+	if(is_parallel && (!el_thread_pool_new(&pool, 0) || pool.num_threads == 0))
+	{
+		el_thread_pool_delete(&pool);
+		is_parallel = false;
+	}
+
+	int num_tasks = is_parallel ? NUM_CHECK_TASKS_PER_THREAD * (pool.num_threads + 1) : 1;
+	if(num_tasks > check->num_functions / MIN_FUNCTIONS_PER_CHECK_TASK)
+		num_tasks = check->num_functions / MIN_FUNCTIONS_PER_CHECK_TASK;
+	if(num_tasks < 2)
+	{
+		// Too few functions to be worth splitting
+		if(is_parallel)
+		{
+			el_thread_pool_delete(&pool);
+		}
+		is_parallel = false;
+		num_tasks = 1;
+	}
+
+	struct el_check_task * tasks = fmalloc(sizeof(struct el_check_task) * num_tasks);
+	if(!tasks)
+	{
+		if(is_parallel)
+		{
+			el_thread_pool_delete(&pool);
+		}
+		return el_ALLOCATION_ERROR;
+	}
+	for(int i = 0; i < num_tasks; ++i)
+	{
+		tasks[i].first_function = (int)((long long)check->num_functions * i / num_tasks);
+		tasks[i].end_function = (int)((long long)check->num_functions * (i + 1) / num_tasks);
+		el_type_checker_new(&tasks[i].checker, check, is_parallel);
+	}
+	*out_tasks = tasks;
+	*out_num_tasks = num_tasks;
+
+	if(!is_parallel)
+	{
+		el_run_check_task(check, &tasks[0]);
+		return el_SUCCESS;
+	}
+
+	struct el_parallel_check parallel_check = { .check = check, .tasks = tasks };
+	el_thread_pool_for(&pool, num_tasks, el_check_task_main, &parallel_check);
+	el_thread_pool_delete(&pool);
+
+	// Tasks which needed a new type start again alone, s.t. they may intern it
+	for(int i = 0; i < num_tasks; ++i)
+	{
+		struct el_type_checker * c = &tasks[i].checker;
+		if(!c->needs_serial_check)
+			continue;
+
+		el_type_checker_delete(c);
+		el_type_checker_new(c, check, false);
+		el_run_check_task(check, &tasks[i]);
+	}
+	return el_SUCCESS;
+}
+
+static void el_check_task_main(void * context, int task_index, int thread_index)
+{
+	struct el_parallel_check * parallel_check = context;
+	el_run_check_task(parallel_check->check, &parallel_check->tasks[task_index]);
+}
+
+static void el_run_check_task(struct el_type_check const * check, struct el_check_task * task)
+{
+	for(int i = task->first_function; i < task->end_function && !task->checker.needs_serial_check; ++i)
+	{
+		el_check_function(&task->checker, check->functions[i]);
+	}
+}
+
+static void el_type_checker_new(struct el_type_checker * c, struct el_type_check const * check, bool is_concurrent)
+{
+	*c = (struct el_type_checker){ .check = check, .is_concurrent = is_concurrent, .err = el_SUCCESS };
+	el_string_builder_new(&c->messages, 0);
+
+	struct el_ast_visitor * visitor = &c->visitor;
+	visitor->context = c;
+	visitor->enter_expression[el_AST_EXPR_DOT] = el_enter_dot;
+	visitor->leave_expression[el_AST_EXPR_NUMBER_LITERAL] = el_leave_number_literal;
+	visitor->leave_expression[el_AST_EXPR_STRING_LITERAL] = el_leave_string_literal;
+	visitor->leave_expression[el_AST_EXPR_IDENTIFIER] = el_leave_identifier;
+	visitor->leave_expression[el_AST_EXPR_VECTOR_TYPE] = el_leave_vector_type;
+	visitor->leave_expression[el_AST_EXPR_ADD] = el_leave_arithmetic;
+	visitor->leave_expression[el_AST_EXPR_SUB] = el_leave_arithmetic;
+	visitor->leave_expression[el_AST_EXPR_MUL] = el_leave_arithmetic;
+	visitor->leave_expression[el_AST_EXPR_DIV] = el_leave_arithmetic;
+	visitor->leave_expression[el_AST_EXPR_EQUALS] = el_leave_comparison;
+	visitor->leave_expression[el_AST_EXPR_GREATER_THAN] = el_leave_comparison;
+	visitor->leave_expression[el_AST_EXPR_LESS_THAN] = el_leave_comparison;
+	visitor->leave_expression[el_AST_EXPR_GEQUALS] = el_leave_comparison;
+	visitor->leave_expression[el_AST_EXPR_LEQUALS] = el_leave_comparison;
+	visitor->leave_expression[el_AST_EXPR_BOOLEAN_AND] = el_leave_boolean;
+	visitor->leave_expression[el_AST_EXPR_BOOLEAN_OR] = el_leave_boolean;
+	visitor->leave_expression[el_AST_EXPR_DOT] = el_leave_dot;
+	visitor->leave_expression[el_AST_EXPR_FUNCTION_CALL] = el_leave_function_call;
+	visitor->leave_expression[el_AST_EXPR_SLICE_INDEX] = el_leave_slice_index;
+	visitor->leave_expression[el_AST_EXPR_SLICE_LITERAL] = el_leave_slice_literal;
+	visitor->leave_expression[el_AST_EXPR_ARGUMENTS] = el_leave_arguments;
+}
+
+static void el_type_checker_delete(struct el_type_checker * c)
+{
+	el_string_builder_delete(&c->messages);
+}
+
+static void el_check_function(struct el_type_checker * c, struct el_ast_function_definition * function)
+{
+	c->function = function;
+	el_check_statements(c, &function->code_block);
+	c->function = NULL;
+}
+
+static void el_check_statements(struct el_type_checker * c, struct el_ast_statement_list * list)
+{
+	for(int i = 0; i < list->num_statements && !c->needs_serial_check; ++i)
+	{
+		el_check_statement(c, &list->statements[i]);
+	}
+}
+
+static void el_check_statement(struct el_type_checker * c, struct el_ast_statement * statement)
+{
+	switch(statement->type)
+	{
+	case el_AST_NODE_DATA_BLOCK:
+	case el_AST_NODE_FUNCTION_DEFINITION:
+		// Declarations were gathered up front and function bodies are checked apart from file scope
+		break;
+	case el_AST_NODE_FOR_STATEMENT:
+		el_check_for_statement(c, &statement->for_statement);
+		break;
+	case el_AST_NODE_IF_STATEMENT:
+		el_check_if_statement(c, &statement->if_statement);
+		break;
+	case el_AST_NODE_ASSIGNMENT:
+		el_check_assignment(c, &statement->assignment);
+		break;
+	case el_AST_NODE_RETURN_STATEMENT:
+		el_check_return(c, &statement->return_statement);
+		break;
+	case el_AST_NODE_EXPRESSION:
+		el_check_expression(c, &statement->expression);
+		break;
+	}
+}
+
+static void el_check_for_statement(struct el_type_checker * c, struct el_ast_for_statement * for_statement)
+{
+	struct el_type_table const * types = c->check->types;
+	struct el_symbol * symbols = c->check->symbols->symbols;
+	el_check_expression(c, &for_statement->range);
+	int range_type = el_operand_type(c, &for_statement->range);
+
+	int value_type = el_NO_TYPE;
+	if(range_type != el_NO_TYPE && el_get_type(types, range_type)->kind != el_TYPE_SLICE)
+	{
+		el_report_types(c, el_INVALID_OPERAND_ERROR, "For statements iterate slices", el_NO_TYPE, range_type);
+	}
+	else if(range_type != el_NO_TYPE)
+	{
+		value_type = el_get_type(types, range_type)->element_type;
+	}
+
+	symbols[for_statement->index_symbol].type_id = el_INT_TYPE_ID;
+	if(for_statement->value_symbol != for_statement->index_symbol)
+	{
+		symbols[for_statement->value_symbol].type_id = value_type;
+	}
+
+	struct el_ast_for_statement * enclosing = c->parallel_for;
+	if(for_statement->is_parallel)
+	{
+		el_check_reductions(c, for_statement);
+		c->parallel_for = for_statement;
+	}
+	el_check_statements(c, &for_statement->code_block);
+	c->parallel_for = enclosing;
+}
+
+// Reductions are local ints or floats, the partial result of each chunk is gathered in a slice and combined once every chunk has run
+static void el_check_reductions(struct el_type_checker * c, struct el_ast_for_statement * for_statement)
+{
+	struct el_symbol_table const * symbols = c->check->symbols;
+	for(int i = 0; i < for_statement->num_reductions; ++i)
+	{
+		struct el_ast_reduction const * reduction = &for_statement->reductions[i];
+		if(reduction->symbol == el_NO_SYMBOL)
+			continue;
+
+		struct el_symbol const * symbol = &symbols->symbols[reduction->symbol];
+		bool is_local = symbol->kind == el_SYMBOL_PARAMETER || (symbol->kind == el_SYMBOL_VARIABLE && symbols->scopes[symbol->scope].kind != el_SCOPE_FILE);
+		if(!is_local)
+		{
+			el_report(c, el_UNSAFE_PARALLEL_FOR_ERROR, "Cannot reduce %s, only local variables can be reduced", reduction->var_name);
+			continue;
+		}
+		if(symbol->type_id == el_NO_TYPE)
+			continue;
+		if(!el_is_numeric(c, symbol->type_id))
+		{
+			el_report_types(c, el_INVALID_OPERAND_ERROR, "Reductions must be int or float", el_NO_TYPE, symbol->type_id);
+			continue;
+		}
+		for(int j = 0; j < i; ++j)
+		{
+			if(for_statement->reductions[j].symbol == reduction->symbol)
+			{
+				el_report(c, el_UNSAFE_PARALLEL_FOR_ERROR, "%s is reduced twice", reduction->var_name);
+			}
+		}
+
+		// Combining the chunks assigns the variable, which an enclosing parallel for must allow
+		if(c->parallel_for && !el_is_private_to(c, c->parallel_for, reduction->symbol))
+		{
+			el_report(c, el_UNSAFE_PARALLEL_FOR_ERROR, "Cannot reduce %s, which is shared by the chunks of the enclosing parallel for", reduction->var_name);
+		}
+		el_find_slice_type(c, symbol->type_id);
+	}
+}
+
+// Returns true if symbol is declared in the body of for_statement or is one of its reductions, s.t. each chunk has a copy of its own
+static bool el_is_private_to(struct el_type_checker const * c, struct el_ast_for_statement const * for_statement, int symbol)
+{
+	for(int i = 0; i < for_statement->num_reductions; ++i)
+	{
+		if(for_statement->reductions[i].symbol == symbol)
+			return true;
+	}
+
+	struct el_symbol_table const * symbols = c->check->symbols;
+	int loop_scope = symbols->symbols[for_statement->index_symbol].scope;
+	for(int scope = symbols->symbols[symbol].scope; scope >= 0; scope = symbols->scopes[scope].parent)
+	{
+		if(scope == loop_scope)
+			return true;
+	}
+	return false;
+}
+
+static void el_check_if_statement(struct el_type_checker * c, struct el_ast_if_statement * if_statement)
+{
+	el_check_condition(c, &if_statement->expression);
+	el_check_statements(c, &if_statement->code_block);
+	for(int i = 0; i < if_statement->num_elif_statements; ++i)
+	{
+		el_check_condition(c, &if_statement->elif_statements[i].expression);
+		el_check_statements(c, &if_statement->elif_statements[i].code_block);
+	}
+	if(if_statement->else_statement)
+	{
+		el_check_statements(c, if_statement->else_statement);
+	}
+}
+
+static void el_check_assignment(struct el_type_checker * c, struct el_ast_assignment * assignment)
+{
+	struct el_type_table const * types = c->check->types;
+	struct el_ast_expression * lhs = &assignment->lhs;
+	el_check_expression(c, &assignment->rhs);
+	int rhs_type = el_operand_type(c, &assignment->rhs);
+	el_check_not_soa_element(c, &assignment->rhs);
+
+	// The assignment which declares a variable gives it its type
+	struct el_symbol * symbol = lhs->type == el_AST_EXPR_IDENTIFIER && lhs->symbol != el_NO_SYMBOL ? &c->check->symbols->symbols[lhs->symbol] : NULL;
+	if(symbol && symbol->kind == el_SYMBOL_VARIABLE && symbol->variable == lhs)
+	{
+		if(rhs_type == el_VOID_TYPE_ID)
+		{
+			el_report(c, el_UNINFERRABLE_TYPE_ERROR, "Cannot assign void to %s", lhs->identifier);
+			rhs_type = el_NO_TYPE;
+		}
+		else if(rhs_type != el_NO_TYPE && el_get_type(types, rhs_type)->base_type == el_VOID_TYPE_ID)
+		{
+			el_report(c, el_UNINFERRABLE_TYPE_ERROR, "Cannot infer the type of %s from an empty slice", lhs->identifier);
+			rhs_type = el_NO_TYPE;
+		}
+		symbol->type_id = rhs_type;
+		lhs->type_id = rhs_type;
+		return;
+	}
+
+	// Chunks of a parallel for run at once, s.t. a variable they share is only written through a reduction
+	if(c->parallel_for && symbol && !el_is_private_to(c, c->parallel_for, lhs->symbol))
+	{
+		el_report(c, el_UNSAFE_PARALLEL_FOR_ERROR, "Cannot assign to %s in a parallel for, which shares it between chunks unless it is reduced", lhs->identifier);
+		return;
+	}
+
+	int lhs_type = el_check_expression(c, lhs);
+	bool is_assignable = lhs->type == el_AST_EXPR_DOT || lhs->type == el_AST_EXPR_SLICE_INDEX
+		|| (symbol && (symbol->kind == el_SYMBOL_VARIABLE || symbol->kind == el_SYMBOL_PARAMETER));
+	if(!is_assignable)
+	{
+		el_report(c, el_NOT_ASSIGNABLE_ERROR, "Cannot assign to %s", lhs->type == el_AST_EXPR_IDENTIFIER ? lhs->identifier : "an expression");
+		return;
+	}
+
+	// Vectors are values, a lane is changed by building a new vector
+	if(lhs->type == el_AST_EXPR_SLICE_INDEX && el_is_vector(c, lhs->binary_op.lhs->type_id))
+	{
+		el_report_types(c, el_NOT_ASSIGNABLE_ERROR, "Cannot assign to a lane", el_NO_TYPE, lhs->binary_op.lhs->type_id);
+		return;
+	}
+	if(lhs->type == el_AST_EXPR_SLICE_INDEX && el_is_soa_slice(types, lhs->binary_op.lhs->type_id))
+	{
+		el_check_soa_store(c, &assignment->rhs);
+	}
+	el_coerce_or_report(c, &assignment->rhs, lhs_type, "Mismatched types in assignment");
+}
+
+static void el_check_return(struct el_type_checker * c, struct el_ast_return_statement * return_statement)
+{
+	el_check_expression(c, &return_statement->expression);
+	if(!c->function)
+	{
+		el_report(c, el_RETURN_OUTSIDE_FUNCTION_ERROR, "Return outside of a function%s", "");
+		return;
+	}
+	if(c->parallel_for)
+	{
+		el_report(c, el_UNSAFE_PARALLEL_FOR_ERROR, "Return from %s inside a parallel for", c->function->name);
+		return;
+	}
+
+	int return_type = c->function->return_type.type_id;
+	if(return_type == el_VOID_TYPE_ID)
+	{
+		el_report(c, el_MISMATCHED_TYPES_ERROR, "Return with a value from %s, which has no return type", c->function->name);
+		return;
+	}
+	el_operand_type(c, &return_statement->expression);
+	el_check_not_soa_element(c, &return_statement->expression);
+	el_coerce_or_report(c, &return_statement->expression, return_type, "Mismatched types in return");
+}
+
+static void el_check_condition(struct el_type_checker * c, struct el_ast_expression * condition)
+{
+	el_check_expression(c, condition);
+	el_operand_type(c, condition);
+	el_coerce_or_report(c, condition, el_INT_TYPE_ID, "Conditions must be int");
+}
+
+// Returns the type of the expression, which is also stored in its type_id
+static int el_check_expression(struct el_type_checker * c, struct el_ast_expression * expression)
+{
+	int err = el_ast_visit_expression(expression, &c->visitor);
+	if(err && c->err == el_SUCCESS)
+	{
+		c->err = err;
+	}
+	return expression->type_id;
+}
+
+// The rhs of a dot names a field, which may have been set by an earlier check
+static bool el_enter_dot(struct el_ast_expression * e, void * context)
+{
+	e->binary_op.rhs->symbol = FIELD_NAME_SYMBOL;
+	return true;
+}
+
+static void el_leave_number_literal(struct el_ast_expression * e, void * context)
+{
+	// Literals are digits with at most one decimal point between digits
+	char const * s = e->number_literal;
+	int length = el_string_length(e->number_literal);
+	int num_points = 0;
+	bool is_valid = length > 0 && s[0] != '.' && s[length - 1] != '.';
+	for(int i = 0; i < length && is_valid; ++i)
+	{
+		num_points += s[i] == '.';
+		is_valid = (s[i] >= '0' && s[i] <= '9') || (s[i] == '.' && num_points == 1);
+	}
+
+	e->type_id = num_points > 0 ? el_FLOAT_TYPE_ID : el_INT_TYPE_ID;
+	if(!is_valid)
+	{
+		el_report(context, el_INVALID_NUMBER_LITERAL_ERROR, "Invalid number literal %s", e->number_literal);
+		e->type_id = el_NO_TYPE;
+	}
+}
+
+static void el_leave_string_literal(struct el_ast_expression * e, void * context)
+{
+	e->type_id = el_STRING_TYPE_ID;
+}
+
+static void el_leave_identifier(struct el_ast_expression * e, void * context)
+{
+	// Fields are typed by their dot
+	struct el_type_checker * c = context;
+	e->type_id = e->symbol < 0 ? el_NO_TYPE : c->check->symbols->symbols[e->symbol].type_id;
+
+	// Undeclared names were reported by name resolution, but must still fail the check
+	if(e->symbol == el_NO_SYMBOL && c->err == el_SUCCESS)
+	{
+		c->err = el_UNDECLARED_IDENTIFIER_ERROR;
+	}
+}
+
+static void el_leave_vector_type(struct el_ast_expression * e, void * context)
+{
+	e->type_id = el_native_type_id(e->native_type);
+}
+
+static void el_leave_arithmetic(struct el_ast_expression * e, void * context)
+{
+	struct el_type_checker * c = context;
+	int type = el_unify_operands(c, e, operator_names[e->type]);
+
+	// Vectors of the same type are added, subtracted and multiplied lane by lane, only float vectors are divided as there is no packed int division
+	bool is_vector_op = el_is_vector(c, type) && (e->type != el_AST_EXPR_DIV || el_get_type(c->check->types, type)->element_type == el_FLOAT_TYPE_ID);
+	if(type != el_NO_TYPE && !el_is_numeric(c, type) && !is_vector_op)
+	{
+		el_report_operand(c, operator_names[e->type], type);
+		type = el_NO_TYPE;
+	}
+	e->type_id = type;
+}
+
+static void el_leave_comparison(struct el_ast_expression * e, void * context)
+{
+	struct el_type_checker * c = context;
+	int type = el_unify_operands(c, e, operator_names[e->type]);
+
+	// Numbers are ordered and strings may also be compared for equality
+	bool is_comparable = el_is_numeric(c, type) || (e->type == el_AST_EXPR_EQUALS && type == el_STRING_TYPE_ID);
+	if(type != el_NO_TYPE && !is_comparable)
+	{
+		el_report_operand(c, operator_names[e->type], type);
+	}
+	e->type_id = el_INT_TYPE_ID;
+}
+
+static void el_leave_boolean(struct el_ast_expression * e, void * context)
+{
+	struct el_type_checker * c = context;
+	el_operand_type(c, e->binary_op.lhs);
+	el_operand_type(c, e->binary_op.rhs);
+	char const * what = e->type == el_AST_EXPR_BOOLEAN_AND ? "Operands of and must be int" : "Operands of or must be int";
+	el_coerce_or_report(c, e->binary_op.lhs, el_INT_TYPE_ID, what);
+	el_coerce_or_report(c, e->binary_op.rhs, el_INT_TYPE_ID, what);
+	e->type_id = el_INT_TYPE_ID;
+}
+
+static void el_leave_dot(struct el_ast_expression * e, void * context)
+{
+	struct el_type_checker * c = context;
+	struct el_type_check const * check = c->check;
+	struct el_ast_expression * field = e->binary_op.rhs;
+	int type = el_operand_type(c, e->binary_op.lhs);
+	e->type_id = el_NO_TYPE;
+	field->type_id = el_NO_TYPE;
+	if(type == el_NO_TYPE)
+		return;
+
+	struct el_type const * t = el_get_type(check->types, type);
+	if(t->kind != el_TYPE_DATA_BLOCK)
+	{
+		el_report_types(c, el_INVALID_OPERAND_ERROR, "Fields belong to data blocks", el_NO_TYPE, type);
+		return;
+	}
+
+	// Field names were interned when declarations were gathered, s.t. fields are found by comparing ints
+	struct el_ast_data_block const * data_block = check->symbols->symbols[t->data_block].data_block;
+	int const * field_names = &check->field_names[check->first_field_names[t->data_block]];
+	int name = el_find_name(check->symbols, el_string_view_of(field->identifier));
+	for(int i = 0; i < data_block->num_var_declarations && name >= 0; ++i)
+	{
+		if(field_names[i] == name)
+		{
+			field->symbol = i;
+			field->type_id = data_block->var_declarations[i].type.type_id;
+			e->type_id = field->type_id;
+			return;
+		}
+	}
+	el_report(c, el_UNKNOWN_FIELD_ERROR, "Unknown field %s", field->identifier);
+}
+
+static void el_leave_function_call(struct el_ast_expression * e, void * context)
+{
+	struct el_type_checker * c = context;
+	struct el_ast_expression * callee = e->binary_op.lhs;
+	struct el_ast_expression_list * arguments = e->binary_op.rhs->expression_list;
+	e->type_id = el_NO_TYPE;
+	if(callee->type == el_AST_EXPR_IDENTIFIER && callee->symbol == el_NO_SYMBOL)
+		return;
+
+	// Vectors are constructed zeroed, from one value for every lane or from a value for each lane
+	if(callee->type == el_AST_EXPR_VECTOR_TYPE)
+	{
+		struct el_type const * t = el_get_type(c->check->types, callee->type_id);
+		if(arguments->num_expressions > 1 && arguments->num_expressions != t->num_lanes)
+		{
+			el_report(c, el_WRONG_NUMBER_OF_ARGUMENTS_ERROR, "Wrong number of arguments to %s", (el_string)el_token_string(callee->native_type));
+			return;
+		}
+		for(int i = 0; i < arguments->num_expressions; ++i)
+		{
+			el_operand_type(c, &arguments->expressions[i]);
+			el_coerce_or_report(c, &arguments->expressions[i], t->element_type, "Mismatched argument type");
+		}
+		e->type_id = callee->type_id;
+		return;
+	}
+
+	struct el_symbol const * symbol = callee->type == el_AST_EXPR_IDENTIFIER ? &c->check->symbols->symbols[callee->symbol] : NULL;
+	if(symbol && symbol->kind == el_SYMBOL_FUNCTION)
+	{
+		struct el_ast_parameter_list const * parameters = &symbol->function_definition->parameter_list;
+		el_check_arguments(c, arguments, parameters->parameters, parameters->num_parameters, callee->identifier);
+		e->type_id = symbol->type_id;
+	}
+	else if(symbol && symbol->kind == el_SYMBOL_DATA_BLOCK)
+	{
+		// Data blocks are constructed zeroed or from a value for each field
+		struct el_ast_data_block const * data_block = symbol->data_block;
+		if(arguments->num_expressions > 0)
+		{
+			el_check_arguments(c, arguments, data_block->var_declarations, data_block->num_var_declarations, callee->identifier);
+		}
+		e->type_id = symbol->type_id;
+	}
+	else
+	{
+		el_report(c, el_INVALID_OPERAND_ERROR, "Cannot call %s", callee->type == el_AST_EXPR_IDENTIFIER ? callee->identifier : "an expression");
+	}
+}
+
+static void el_leave_slice_index(struct el_ast_expression * e, void * context)
+{
+	struct el_type_checker * c = context;
+	int type = el_operand_type(c, e->binary_op.lhs);
+	el_operand_type(c, e->binary_op.rhs);
+	el_coerce_or_report(c, e->binary_op.rhs, el_INT_TYPE_ID, "Slice indices must be int");
+
+	e->type_id = el_NO_TYPE;
+	if(type == el_NO_TYPE)
+		return;
+
+	struct el_type const * t = el_get_type(c->check->types, type);
+	if(t->kind == el_TYPE_VECTOR)
+	{
+		// Lanes are picked when compiling, s.t. reading one never needs a range check
+		struct el_ast_expression const * index = e->binary_op.rhs;
+		long long lane = index->type == el_AST_EXPR_NUMBER_LITERAL && index->type_id == el_INT_TYPE_ID ? strtoll(index->number_literal, NULL, 10) : -1;
+		if(lane < 0 || lane >= t->num_lanes)
+		{
+			el_report_types(c, el_INVALID_OPERAND_ERROR, "Lanes must be indexed by an int literal less than the number of lanes", el_NO_TYPE, type);
+			return;
+		}
+		e->type_id = t->element_type;
+		return;
+	}
+	if(t->kind != el_TYPE_SLICE)
+	{
+		el_report_types(c, el_INVALID_OPERAND_ERROR, "Only slices and vectors can be indexed", el_NO_TYPE, type);
+		return;
+	}
+	e->type_id = t->element_type;
+}
+
+static void el_leave_slice_literal(struct el_ast_expression * e, void * context)
+{
+	struct el_type_checker * c = context;
+	struct el_type_table const * types = c->check->types;
+	struct el_ast_expression_list * list = e->expression_list;
+
+	// Elements take the type of the first which is not an empty slice, or float if any element is a float and the rest int literals
+	int element_type = el_NO_TYPE;
+	for(int i = 0; i < list->num_expressions; ++i)
+	{
+		int type = el_operand_type(c, &list->expressions[i]);
+		bool is_empty_slice = type != el_NO_TYPE && el_get_type(types, type)->base_type == el_VOID_TYPE_ID && type != el_VOID_TYPE_ID;
+		if(element_type == el_NO_TYPE && !is_empty_slice)
+		{
+			element_type = type;
+		}
+		else if(element_type == el_INT_TYPE_ID && type == el_FLOAT_TYPE_ID)
+		{
+			element_type = el_FLOAT_TYPE_ID;
+		}
+	}
+
+	// An empty slice literal is a slice of void until it is coerced to the slice it is assigned to
+	if(list->num_expressions == 0)
+	{
+		element_type = el_VOID_TYPE_ID;
+	}
+
+	for(int i = 0; i < list->num_expressions; ++i)
+	{
+		el_coerce_or_report(c, &list->expressions[i], element_type, "Mismatched types in slice literal");
+	}
+	e->type_id = element_type == el_NO_TYPE ? el_NO_TYPE : el_find_slice_type(c, element_type);
+
+	for(int i = 0; i < list->num_expressions && e->type_id != el_NO_TYPE && el_is_soa_slice(types, e->type_id); ++i)
+	{
+		el_check_soa_store(c, &list->expressions[i]);
+	}
+}
+
+static void el_leave_arguments(struct el_ast_expression * e, void * context)
+{
+	e->type_id = el_VOID_TYPE_ID;
+}
+
+// Type of an expression used as a value, functions and data blocks named without being called are not values
+static int el_operand_type(struct el_type_checker * c, struct el_ast_expression * e)
+{
+	if(e->type == el_AST_EXPR_VECTOR_TYPE)
+	{
+		el_report(c, el_INVALID_OPERAND_ERROR, "Expected a value, got %s", (el_string)el_token_string(e->native_type));
+		e->type_id = el_NO_TYPE;
+	}
+	if(e->type == el_AST_EXPR_IDENTIFIER && e->symbol != el_NO_SYMBOL)
+	{
+		int kind = c->check->symbols->symbols[e->symbol].kind;
+		if(kind == el_SYMBOL_FUNCTION || kind == el_SYMBOL_DATA_BLOCK)
+		{
+			el_report(c, el_INVALID_OPERAND_ERROR, "Expected a value, got %s", e->identifier);
+			e->type_id = el_NO_TYPE;
+		}
+	}
+	return e->type_id;
+}
+
+// Returns the type both operands of a binary op have once int literals are coerced to floats, or el_NO_TYPE if they differ
+static int el_unify_operands(struct el_type_checker * c, struct el_ast_expression * e, char const * operator)
+{
+	struct el_ast_expression * lhs = e->binary_op.lhs;
+	struct el_ast_expression * rhs = e->binary_op.rhs;
+	int lhs_type = el_operand_type(c, lhs);
+	int rhs_type = el_operand_type(c, rhs);
+	if(lhs_type == el_NO_TYPE || rhs_type == el_NO_TYPE)
+		return el_NO_TYPE;
+
+	if(el_coerce(c, rhs, lhs_type))
+		return lhs_type;
+	if(el_coerce(c, lhs, rhs_type))
+		return rhs_type;
+
+	struct el_string_builder * sb = &c->messages;
+	el_begin_report(c, el_MISMATCHED_TYPES_ERROR);
+	el_string_builder_appendf(sb, "Mismatched operands of %s, ", operator);
+	el_append_type_name(sb, c->check->types, lhs_type);
+	el_string_builder_append_cstr(sb, " and ");
+	el_append_type_name(sb, c->check->types, rhs_type);
+	el_string_builder_append_char(sb, '\n');
+	return el_NO_TYPE;
+}
+
+// Returns true if the expression has the expected type or is a literal which can take it
+// Expressions which failed to check are taken to have any type, s.t. one error is not reported over and over
+static bool el_coerce(struct el_type_checker * c, struct el_ast_expression * e, int expected)
+{
+	if(e->type_id == expected || e->type_id == el_NO_TYPE || expected == el_NO_TYPE)
+		return true;
+
+	if(e->type == el_AST_EXPR_NUMBER_LITERAL && e->type_id == el_INT_TYPE_ID && expected == el_FLOAT_TYPE_ID)
+	{
+		e->type_id = el_FLOAT_TYPE_ID;
+		return true;
+	}
+
+	// Slice literals take the type of the slice they are used as if each of their elements can
+	struct el_type const * t = el_get_type(c->check->types, expected);
+	if(e->type == el_AST_EXPR_SLICE_LITERAL && t->kind == el_TYPE_SLICE)
+	{
+		struct el_ast_expression_list * list = e->expression_list;
+		for(int i = 0; i < list->num_expressions; ++i)
+		{
+			if(!el_coerce(c, &list->expressions[i], t->element_type))
+				return false;
+		}
+		e->type_id = expected;
+		return true;
+	}
+	return false;
+}
+
+static void el_coerce_or_report(struct el_type_checker * c, struct el_ast_expression * e, int expected, char const * what)
+{
+	if(!el_coerce(c, e, expected))
+	{
+		el_report_types(c, el_MISMATCHED_TYPES_ERROR, what, expected, e->type_id);
+	}
+}
+
+static void el_check_arguments(struct el_type_checker * c, struct el_ast_expression_list * arguments, struct el_ast_var_decl const * var_decls, int num_var_decls, el_string callee)
+{
+	if(arguments->num_expressions != num_var_decls)
+	{
+		el_report(c, el_WRONG_NUMBER_OF_ARGUMENTS_ERROR, "Wrong number of arguments to %s", callee);
+		return;
+	}
+
+	for(int i = 0; i < num_var_decls; ++i)
+	{
+		el_operand_type(c, &arguments->expressions[i]);
+		el_check_not_soa_element(c, &arguments->expressions[i]);
+		el_coerce_or_report(c, &arguments->expressions[i], var_decls[i].type.type_id, "Mismatched argument type");
+	}
+}
+
+// Elements of a soa slice are stored field by field, so a whole element can only be copied in or out of it
+// Slices of references share their elements instead, so copies would make the two layouts behave differently
+// Returns true if e indexes a soa slice or is the value of a for over one
+static bool el_is_soa_element(struct el_type_checker const * c, struct el_ast_expression const * e)
+{
+	struct el_type_table const * types = c->check->types;
+	if(e->type == el_AST_EXPR_SLICE_INDEX)
+		return e->binary_op.lhs->type_id != el_NO_TYPE && el_is_soa_slice(types, e->binary_op.lhs->type_id);
+	if(e->type != el_AST_EXPR_IDENTIFIER || e->symbol < 0)
+		return false;
+
+	struct el_symbol const * symbol = &c->check->symbols->symbols[e->symbol];
+	int range_type = symbol->kind == el_SYMBOL_FOR_VALUE ? symbol->for_statement->range.type_id : el_NO_TYPE;
+	return range_type != el_NO_TYPE && el_is_soa_slice(types, range_type);
+}
+
+// Soa elements are only used through their fields
+static void el_check_not_soa_element(struct el_type_checker * c, struct el_ast_expression const * e)
+{
+	if(el_is_soa_element(c, e))
+	{
+		el_report(c, el_SOA_ELEMENT_COPY_ERROR, "Cannot copy %s out of a soa slice, only its fields can be used", e->type == el_AST_EXPR_IDENTIFIER ? e->identifier : "an element");
+	}
+}
+
+// Only a new data block can be stored in a soa slice, as no other reference can see it is a copy
+static void el_check_soa_store(struct el_type_checker * c, struct el_ast_expression const * e)
+{
+	struct el_ast_expression const * callee = e->type == el_AST_EXPR_FUNCTION_CALL ? e->binary_op.lhs : NULL;
+	bool is_new = callee && callee->type == el_AST_EXPR_IDENTIFIER && callee->symbol >= 0
+		&& c->check->symbols->symbols[callee->symbol].kind == el_SYMBOL_DATA_BLOCK;
+	if(!is_new && e->type_id != el_NO_TYPE)
+	{
+		el_report(c, el_SOA_ELEMENT_COPY_ERROR, "Cannot store %s in a soa slice, which copies it, only new data blocks can be stored", e->type == el_AST_EXPR_IDENTIFIER ? e->identifier : "an existing data block");
+	}
+}
+
+static int el_find_slice_type(struct el_type_checker * c, int element_type)
+{
+	struct el_type_table * types = c->check->types;
+	if(!c->is_concurrent)
+	{
+		int slice_type = el_slice_type(types, element_type);
+		if(slice_type == el_NO_TYPE && c->err == el_SUCCESS)
+		{
+			c->err = el_ALLOCATION_ERROR;
+		}
+		return slice_type;
+	}
+
+	int slice_type = el_get_type(types, element_type)->slice_type;
+	if(slice_type == el_NO_TYPE)
+	{
+		c->needs_serial_check = true;
+	}
+	return slice_type;
+}
+
+static bool el_is_numeric(struct el_type_checker const * c, int type)
+{
+	return type == el_INT_TYPE_ID || type == el_FLOAT_TYPE_ID;
+}
+
+static bool el_is_vector(struct el_type_checker const * c, int type)
+{
+	return type != el_NO_TYPE && el_get_type(c->check->types, type)->kind == el_TYPE_VECTOR;
+}
+
+// format takes the one name the report is about
+static void el_report(struct el_type_checker * c, int err, char const * format, el_string name)
+{
+	el_begin_report(c, err);
+	el_string_builder_appendf(&c->messages, format, name);
+	el_string_builder_append_char(&c->messages, '\n');
+}
+
+static void el_report_types(struct el_type_checker * c, int err, char const * message, int expected, int actual)
+{
+	struct el_type_table const * types = c->check->types;
+	struct el_string_builder * sb = &c->messages;
+	el_begin_report(c, err);
+	el_string_builder_append_cstr(sb, message);
+	if(expected != el_NO_TYPE)
+	{
+		el_string_builder_append_cstr(sb, ", expected ");
+		el_append_type_name(sb, types, expected);
+	}
+	el_string_builder_append_cstr(sb, ", got ");
+	el_append_type_name(sb, types, actual);
+	el_string_builder_append_char(sb, '\n');
+}
+
+static void el_report_operand(struct el_type_checker * c, char const * operator, int type)
+{
+	el_begin_report(c, el_INVALID_OPERAND_ERROR);
+	el_string_builder_appendf(&c->messages, "Invalid operands of %s, ", operator);
+	el_append_type_name(&c->messages, c->check->types, type);
+	el_string_builder_append_char(&c->messages, '\n');
+}
+
+static void el_begin_report(struct el_type_checker * c, int err)
+{
+	if(c->err == el_SUCCESS)
+	{
+		c->err = err;
+	}
+	if(c->function)
+	{
+		el_string_builder_appendf(&c->messages, "In %s: ", c->function->name);
+	}
+}
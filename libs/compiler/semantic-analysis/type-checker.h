@@ -0,0 +1,22 @@
+#pragma once
+#include "symbol-table.h"
+#include "type-table.h"
+
+enum el_type_check_flags
+{
+	el_TYPE_CHECK_DEFAULT = 0,
+	el_TYPE_CHECK_PARALLEL = 1 << 0 // Check function bodies concurrently on a thread pool
+};
+
+// Check every statement and expression of the ast, setting the type_id of each expression and of each symbol
+// Names must have been resolved into symbols and the ast's declared types interned into types
+// File scope statements are checked in order first, s.t. the types of global variables are known before any function body is checked
+// Function bodies depend on nothing else, so with el_TYPE_CHECK_PARALLEL they are checked concurrently
+//
+// A variable takes the type of the assignment which declares it
+// Arithmetic and comparison operands must have the same type, except that an int literal may be used as a float
+// Conditions, comparisons and the operands of and and or are int
+// Calling a data block constructs it, from either no arguments or one per field
+//
+// Errors at file scope are reported first, followed by those of each function in source order, the error returned is the first
+int el_type_check(struct el_ast * ast, struct el_symbol_table * symbols, struct el_type_table * types, int flags);
@@ -0,0 +1,260 @@
+#include "type-table.h"
+#include <compiler/error.h>
+#include <compiler/lexing/token-stream.h>
+#include <compiler/syntax-parsing/ast-visitor.h>
+#include <stdio.h>
+#include <assert.h>
+
+#define INITIAL_NUM_TYPES 64
+
+struct el_type_interner
+{
+	struct el_type_table * types;
+	int err;
+};
+
+static int el_push_type(struct el_type_table * types, struct el_type type);
+static bool el_intern_statement_types(struct el_ast_statement * statement, void * context);
+static uint64_t el_symbol_key_hash(void const * key);
+static bool el_symbol_key_equals(void const * key1, void const * key2);
+
+bool el_type_table_new(struct el_type_table * types, struct el_symbol_table const * symbols)
+{
+	assert(types && symbols);
+	*types = (struct el_type_table){ .symbols = symbols };
+	bool created = el_vector_reserve(types, types, INITIAL_NUM_TYPES, NULL);
+	created = created && el_hash_map_new(&types->data_block_types, sizeof(int), sizeof(int), 0, el_symbol_key_hash, el_symbol_key_equals, NULL);
+	if(!created)
+	{
+		el_type_table_delete(types);
+		return false;
+	}
+
+	// Builtin types are pushed in the order of their ids
+	static struct el_type const builtins[el_builtin_type_id_count] = {
+		{ .kind = el_TYPE_VOID, .element_type = el_NO_TYPE },
+		{ .kind = el_TYPE_INT, .element_type = el_NO_TYPE },
+		{ .kind = el_TYPE_FLOAT, .element_type = el_NO_TYPE },
+		{ .kind = el_TYPE_STRING, .element_type = el_NO_TYPE },
+		{ .kind = el_TYPE_VECTOR, .element_type = el_INT_TYPE_ID, .num_lanes = 2 },
+		{ .kind = el_TYPE_VECTOR, .element_type = el_INT_TYPE_ID, .num_lanes = 4 },
+		{ .kind = el_TYPE_VECTOR, .element_type = el_INT_TYPE_ID, .num_lanes = 8 },
+		{ .kind = el_TYPE_VECTOR, .element_type = el_FLOAT_TYPE_ID, .num_lanes = 2 },
+		{ .kind = el_TYPE_VECTOR, .element_type = el_FLOAT_TYPE_ID, .num_lanes = 4 },
+		{ .kind = el_TYPE_VECTOR, .element_type = el_FLOAT_TYPE_ID, .num_lanes = 8 },
+	};
+	for(int i = 0; i < el_builtin_type_id_count; ++i)
+	{
+		struct el_type type = builtins[i];
+		type.base_type = i;
+		type.data_block = el_NO_SYMBOL;
+		el_push_type(types, type);
+	}
+	return true;
+}
+
+void el_type_table_delete(struct el_type_table * types)
+{
+	if(!types)
+		return;
+
+	el_vector_free(types, types, NULL);
+	el_hash_map_delete(&types->data_block_types);
+}
+
+int el_data_block_type(struct el_type_table * types, int data_block_symbol)
+{
+	assert(data_block_symbol >= 0 && types->symbols->symbols[data_block_symbol].kind == el_SYMBOL_DATA_BLOCK);
+	bool inserted = false;
+	int * type = el_hash_map_insert(&types->data_block_types, &data_block_symbol, &inserted);
+	if(!type)
+		return el_NO_TYPE;
+	if(!inserted)
+		return *type;
+
+	*type = el_push_type(types, (struct el_type){ .kind = el_TYPE_DATA_BLOCK, .element_type = el_NO_TYPE, .base_type = types->num_types, .data_block = data_block_symbol });
+	if(*type == el_NO_TYPE)
+	{
+		el_hash_map_remove(&types->data_block_types, &data_block_symbol);
+		return el_NO_TYPE;
+	}
+	return *type;
+}
+
+int el_slice_type(struct el_type_table * types, int element_type)
+{
+	assert(element_type >= 0 && element_type < types->num_types);
+
+	// Each type links to its slice type, s.t. interning a slice never hashes
+	if(types->types[element_type].slice_type != el_NO_TYPE)
+		return types->types[element_type].slice_type;
+
+	struct el_type const * element = &types->types[element_type];
+	int slice_type = el_push_type(types, (struct el_type){
+		.kind = el_TYPE_SLICE,
+		.num_dimensions = element->num_dimensions + 1,
+		.element_type = element_type,
+		.base_type = element->base_type,
+		.data_block = el_NO_SYMBOL
+	});
+	if(slice_type != el_NO_TYPE)
+	{
+		types->types[element_type].slice_type = slice_type;
+	}
+	return slice_type;
+}
+
+int el_type_with_dimensions(struct el_type_table * types, int base_type, int num_dimensions)
+{
+	int type = base_type;
+	for(int i = 0; i < num_dimensions && type != el_NO_TYPE; ++i)
+	{
+		type = el_slice_type(types, type);
+	}
+	return type;
+}
+
+int el_native_type_id(int native_type)
+{
+	static_assert(el_FLOAT8_TYPE - el_INT2_TYPE == el_FLOAT8_TYPE_ID - el_INT2_TYPE_ID, "Vector type tokens and ids are not in the same order");
+	switch(native_type)
+	{
+	case el_NONE:
+		return el_VOID_TYPE_ID;
+	case el_INT_TYPE:
+		return el_INT_TYPE_ID;
+	case el_FLOAT_TYPE:
+		return el_FLOAT_TYPE_ID;
+	default:
+		assert(native_type >= el_INT2_TYPE && native_type <= el_FLOAT8_TYPE);
+		return el_INT2_TYPE_ID + native_type - el_INT2_TYPE;
+	}
+}
+
+int el_intern_var_type(struct el_type_table * types, struct el_ast_var_type * var_type)
+{
+	int base_type = el_NO_TYPE;
+	if(!var_type->is_native)
+	{
+		if(var_type->symbol == el_NO_SYMBOL)
+		{
+			var_type->type_id = el_NO_TYPE;
+			return el_SUCCESS;
+		}
+		base_type = el_data_block_type(types, var_type->symbol);
+	}
+	else
+	{
+		base_type = el_native_type_id(var_type->native_type);
+	}
+
+	var_type->type_id = base_type == el_NO_TYPE ? el_NO_TYPE : el_type_with_dimensions(types, base_type, var_type->num_dimensions);
+	return var_type->type_id == el_NO_TYPE ? el_ALLOCATION_ERROR : el_SUCCESS;
+}
+
+int el_intern_ast_types(struct el_ast * ast, struct el_type_table * types)
+{
+	struct el_type_interner interner = { .types = types, .err = el_SUCCESS };
+	struct el_ast_visitor visitor = { .context = &interner };
+	visitor.enter_statement[el_AST_NODE_DATA_BLOCK] = el_intern_statement_types;
+	visitor.enter_statement[el_AST_NODE_FUNCTION_DEFINITION] = el_intern_statement_types;
+
+	int err = el_ast_visit(ast, &visitor);
+	err = err ? err : interner.err;
+	if(err == el_ALLOCATION_ERROR)
+	{
+		fprintf(stderr, "Failed to allocate type table\n");
+	}
+	return err;
+}
+
+bool el_append_type_name(struct el_string_builder * sb, struct el_type_table const * types, int type)
+{
+	if(type == el_NO_TYPE)
+		return el_string_builder_append_cstr(sb, "<unknown>");
+
+	struct el_type const * t = &types->types[type];
+	struct el_type const * base = &types->types[t->base_type];
+	bool appended = false;
+	switch(base->kind)
+	{
+	case el_TYPE_VOID:
+		appended = el_string_builder_append_cstr(sb, "void");
+		break;
+	case el_TYPE_INT:
+		appended = el_string_builder_append_cstr(sb, "int");
+		break;
+	case el_TYPE_FLOAT:
+		appended = el_string_builder_append_cstr(sb, "float");
+		break;
+	case el_TYPE_STRING:
+		appended = el_string_builder_append_cstr(sb, "string");
+		break;
+	case el_TYPE_DATA_BLOCK:
+		appended = el_string_builder_append_view(sb, el_symbol_name(types->symbols, base->data_block));
+		break;
+	case el_TYPE_VECTOR:
+		appended = el_string_builder_append_cstr(sb, base->element_type == el_INT_TYPE_ID ? "int" : "float");
+		appended = appended && el_string_builder_append_int(sb, base->num_lanes);
+		break;
+	}
+
+	for(int i = 0; i < t->num_dimensions && appended; ++i)
+	{
+		appended = el_string_builder_append(sb, "[]", 2);
+	}
+	return appended;
+}
+
+static int el_push_type(struct el_type_table * types, struct el_type type)
+{
+	struct el_type * pushed = el_vector_push(types, types, NULL);
+	if(!pushed)
+		return el_NO_TYPE;
+
+	*pushed = type;
+	pushed->slice_type = el_NO_TYPE;
+	return types->num_types - 1;
+}
+
+static bool el_intern_statement_types(struct el_ast_statement * statement, void * context)
+{
+	struct el_type_interner * interner = context;
+	int err = interner->err;
+	if(statement->type == el_AST_NODE_DATA_BLOCK)
+	{
+		struct el_ast_data_block * data_block = &statement->data_block;
+		for(int i = 0; i < data_block->num_var_declarations && err == 0; ++i)
+		{
+			struct el_ast_var_type * type = &data_block->var_declarations[i].type;
+			err = el_intern_var_type(interner->types, type);
+
+			// Slices of a soa block keep a slice of each field, the types of its columns
+			if(err == 0 && data_block->is_soa && type->type_id != el_NO_TYPE && el_slice_type(interner->types, type->type_id) == el_NO_TYPE)
+				err = el_ALLOCATION_ERROR;
+		}
+	}
+	else
+	{
+		struct el_ast_function_definition * function = &statement->function_definition;
+		err = err || el_intern_var_type(interner->types, &function->return_type);
+		for(int i = 0; i < function->parameter_list.num_parameters && err == 0; ++i)
+		{
+			err = el_intern_var_type(interner->types, &function->parameter_list.parameters[i].type);
+		}
+	}
+
+	// Stop descending once interning fails, the walk itself cannot be stopped
+	interner->err = err;
+	return err == el_SUCCESS;
+}
+
+static uint64_t el_symbol_key_hash(void const * key)
+{
+	return el_hash_bytes(key, sizeof(int));
+}
+
+static bool el_symbol_key_equals(void const * key1, void const * key2)
+{
+	return *(int const *)key1 == *(int const *)key2;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "symbol-table.h"
+#include <containers/hash-map.h>
+#include <containers/string-builder.h>
+#include <containers/vector.h>
+
+struct el_ast;
+
+enum el_type_kind
+{
+	el_TYPE_VOID,
+	el_TYPE_INT,
+	el_TYPE_FLOAT,
+	el_TYPE_STRING,
+	el_TYPE_DATA_BLOCK,
+	el_TYPE_SLICE,
+	el_TYPE_VECTOR
+};
+
+// Ids of the types every table starts with
+enum el_builtin_type_id
+{
+	el_VOID_TYPE_ID,
+	el_INT_TYPE_ID,
+	el_FLOAT_TYPE_ID,
+	el_STRING_TYPE_ID,
+
+	// Vector types, in the order of their tokens
+	el_INT2_TYPE_ID,
+	el_INT4_TYPE_ID,
+	el_INT8_TYPE_ID,
+	el_FLOAT2_TYPE_ID,
+	el_FLOAT4_TYPE_ID,
+	el_FLOAT8_TYPE_ID,
+
+	el_builtin_type_id_count
+};
+
+struct el_type
+{
+	int kind;
+	int num_dimensions; // 0 unless a slice
+	int element_type; // Type of the elements of a slice or the lanes of a vector, el_NO_TYPE otherwise
+	int base_type; // Type of the innermost elements of a slice, the type itself otherwise
+	int slice_type; // Slice of this type if it has been interned, otherwise el_NO_TYPE
+	int data_block; // Symbol of a data block type, el_NO_SYMBOL otherwise
+	int num_lanes; // 0 unless a vector
+};
+
+// One canonical id per distinct (base type, number of dimensions), s.t. types are equal iff their ids are
+// Ids are dense indices, s.t. later passes can keep data per type in arrays indexed by id
+struct el_type_table
+{
+	el_VECTOR_MEMBERS(struct el_type, types);
+	struct el_hash_map data_block_types; // Symbol of a data block -> type id
+	struct el_symbol_table const * symbols;
+};
+
+// symbols is the table data block types were resolved with, which must outlive the type table
+bool el_type_table_new(struct el_type_table * types, struct el_symbol_table const * symbols);
+
+void el_type_table_delete(struct el_type_table * types);
+
+// Each returns the id of the type, interning it if needed, or el_NO_TYPE if the table failed to grow
+int el_data_block_type(struct el_type_table * types, int data_block_symbol);
+int el_slice_type(struct el_type_table * types, int element_type);
+int el_type_with_dimensions(struct el_type_table * types, int base_type, int num_dimensions);
+
+// Id of the builtin type a native type token names, void for el_NONE
+int el_native_type_id(int native_type);
+
+// Set var_type's type_id to its canonical type
+// A custom type which names no data block is left as el_NO_TYPE, as name resolution has already reported it
+int el_intern_var_type(struct el_type_table * types, struct el_ast_var_type * var_type);
+
+// Intern the types of every data block field, parameter and return type in the ast
+// Fields of soa data blocks also have their slice types interned
+// Names must have been resolved with the table's symbol table
+int el_intern_ast_types(struct el_ast * ast, struct el_type_table * types);
+
+static inline struct el_type const * el_get_type(struct el_type_table const * types, int type)
+{
+	return &types->types[type];
+}
+
+// Write the type as it would be written in source, e.g. "int[][]", to sb
+bool el_append_type_name(struct el_string_builder * sb, struct el_type_table const * types, int type);
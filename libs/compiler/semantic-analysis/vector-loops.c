@@ -0,0 +1,132 @@
+#include "vector-loops.h"
+#include <assert.h>
+
+struct el_vector_loop_analysis
+{
+	struct el_vector_loop * loop;
+	struct el_symbol_table const * symbols;
+	struct el_type_table const * types;
+	int num_expressions;
+};
+
+static bool el_is_element_at_index(struct el_vector_loop_analysis * a, struct el_ast_expression const * e);
+static bool el_is_vector_expression(struct el_vector_loop_analysis * a, struct el_ast_expression const * e);
+static bool el_use_variable(struct el_vector_loop_analysis * a, struct el_ast_expression const * identifier, bool is_slice);
+
+bool el_analyze_vector_loop(struct el_vector_loop * loop, struct el_ast_for_statement const * for_statement, struct el_symbol_table const * symbols, struct el_type_table const * types)
+{
+	assert(loop && for_statement && symbols && types);
+	*loop = (struct el_vector_loop){ .for_statement = for_statement };
+	struct el_vector_loop_analysis a = { .loop = loop, .symbols = symbols, .types = types };
+	struct el_ast_statement_list const * body = &for_statement->code_block;
+	if(!el_is_vector_slice(types, for_statement->range.type_id) || body->num_statements == 0)
+		return false;
+
+	for(int i = 0; i < body->num_statements; ++i)
+	{
+		struct el_ast_statement const * statement = &body->statements[i];
+		if(statement->type != el_AST_NODE_ASSIGNMENT
+			|| !el_is_element_at_index(&a, &statement->assignment.lhs)
+			|| !el_is_vector_expression(&a, &statement->assignment.rhs))
+			return false;
+	}
+	return true;
+}
+
+bool el_is_vector_slice(struct el_type_table const * types, int type)
+{
+	if(type < 0)
+		return false;
+
+	struct el_type const * t = el_get_type(types, type);
+	return t->kind == el_TYPE_SLICE && (t->element_type == el_INT_TYPE_ID || t->element_type == el_FLOAT_TYPE_ID);
+}
+
+// s[i] where s is an int[] or float[] variable and i is the loop's index
+static bool el_is_element_at_index(struct el_vector_loop_analysis * a, struct el_ast_expression const * e)
+{
+	if(e->type != el_AST_EXPR_SLICE_INDEX)
+		return false;
+
+	struct el_ast_expression const * slice = e->binary_op.lhs;
+	struct el_ast_expression const * index = e->binary_op.rhs;
+	return slice->type == el_AST_EXPR_IDENTIFIER
+		&& index->type == el_AST_EXPR_IDENTIFIER
+		&& index->symbol == a->loop->for_statement->index_symbol
+		&& el_use_variable(a, slice, true);
+}
+
+static bool el_is_vector_expression(struct el_vector_loop_analysis * a, struct el_ast_expression const * e)
+{
+	// Counted before recursing, s.t. the depth is bounded too
+	if(++a->num_expressions > el_VECTOR_LOOP_MAX_EXPRESSIONS)
+		return false;
+
+	switch(e->type)
+	{
+	case el_AST_EXPR_NUMBER_LITERAL:
+		return true;
+	case el_AST_EXPR_IDENTIFIER:
+	{
+		struct el_ast_for_statement const * for_statement = a->loop->for_statement;
+		if(e->symbol == for_statement->index_symbol)
+			return true;
+		if(e->symbol == for_statement->value_symbol)
+		{
+			a->loop->reads_value = true;
+			return true;
+		}
+		return el_use_variable(a, e, false);
+	}
+	case el_AST_EXPR_SLICE_INDEX:
+		return el_is_element_at_index(a, e);
+	case el_AST_EXPR_DIV:
+		// Int division traps on 0, which lanes cannot report in order
+		if(e->binary_op.lhs->type_id != el_FLOAT_TYPE_ID)
+			return false;
+		// fall through
+	case el_AST_EXPR_ADD:
+	case el_AST_EXPR_SUB:
+	case el_AST_EXPR_MUL:
+	case el_AST_EXPR_EQUALS:
+	case el_AST_EXPR_GREATER_THAN:
+	case el_AST_EXPR_LESS_THAN:
+	case el_AST_EXPR_GEQUALS:
+	case el_AST_EXPR_LEQUALS:
+	case el_AST_EXPR_BOOLEAN_AND:
+	case el_AST_EXPR_BOOLEAN_OR:
+	{
+		int operand_type = e->binary_op.lhs->type_id;
+		return (operand_type == el_INT_TYPE_ID || operand_type == el_FLOAT_TYPE_ID)
+			&& el_is_vector_expression(a, e->binary_op.lhs)
+			&& el_is_vector_expression(a, e->binary_op.rhs);
+	}
+	default:
+		return false;
+	}
+}
+
+// Add the variable an identifier names to the loop's arguments, if it is an int[] or float[] when is_slice and otherwise an int or float
+static bool el_use_variable(struct el_vector_loop_analysis * a, struct el_ast_expression const * identifier, bool is_slice)
+{
+	int kind = a->symbols->symbols[identifier->symbol].kind;
+	if(kind == el_SYMBOL_FUNCTION || kind == el_SYMBOL_DATA_BLOCK)
+		return false;
+
+	int type = identifier->type_id;
+	bool has_type = is_slice ? el_is_vector_slice(a->types, type) : type == el_INT_TYPE_ID || type == el_FLOAT_TYPE_ID;
+	if(!has_type)
+		return false;
+
+	struct el_vector_loop * loop = a->loop;
+	for(int i = 0; i < loop->num_arguments; ++i)
+	{
+		if(loop->arguments[i] == identifier->symbol)
+			return true;
+	}
+	if(loop->num_arguments == el_VECTOR_LOOP_MAX_ARGUMENTS)
+		return false;
+
+	loop->arguments[loop->num_arguments++] = identifier->symbol;
+	return true;
+}
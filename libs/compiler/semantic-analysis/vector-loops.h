@@ -0,0 +1,29 @@
+#pragma once
+#include "type-table.h"
+#include <compiler/syntax-parsing/ast.h>
+
+// Most variables a vector loop reads or writes other than its own
+#define el_VECTOR_LOOP_MAX_ARGUMENTS 8
+
+// Most expressions in the body of a vector loop
+#define el_VECTOR_LOOP_MAX_EXPRESSIONS 64
+
+// A for statement over an int[] or float[] whose iterations are independent, s.t. a backend may run many of them at once
+// Every statement of its body is an assignment s[i] = e, where s is an int[] or float[] variable and i is the loop's index
+// e is built from +, -, *, comparisons and and/or of ints or floats and / of floats, whose leaves are number literals,
+// the loop's variables, int and float variables and elements t[i] of int[] and float[] variables
+// Iteration i only reads and writes element i of each slice, and slices never overlap unless they are the same slice
+struct el_vector_loop
+{
+	struct el_ast_for_statement const * for_statement;
+	int arguments[el_VECTOR_LOOP_MAX_ARGUMENTS]; // Symbols of the variables the body uses other than the loop's, in the order they first appear
+	int num_arguments;
+	bool reads_value; // The body reads the value variable
+};
+
+// Returns true and fills loop if for_statement is a vector loop
+// The ast must have passed el_type_check with the symbols and types given
+bool el_analyze_vector_loop(struct el_vector_loop * loop, struct el_ast_for_statement const * for_statement, struct el_symbol_table const * symbols, struct el_type_table const * types);
+
+// Returns true if type is int[] or float[], the slices a vector loop can iterate and index
+bool el_is_vector_slice(struct el_type_table const * types, int type);
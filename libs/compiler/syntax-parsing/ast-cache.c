@@ -0,0 +1,571 @@
+#include "ast-cache.h"
+#include "parser.h"
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <containers/string.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#ifndef SYSTEM_WINDOWS
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+static_assert(sizeof(void *) == sizeof(uint64_t), "ast cache images store pointers as 64-bit values");
+
+#define AST_CACHE_INITIAL_CAPACITY (64 * 1024) // 64KiB
+#define AST_CACHE_ALIGNMENT 16
+
+// Images are laid out for an address in a range the platform rarely hands out, spread by source hash
+// s.t. several cached modules can each be mapped at their own preferred base
+#define AST_CACHE_BASE_ADDRESS 0x300000000000ull
+#define AST_CACHE_BASE_STRIDE (1ull << 28) // 256MiB
+#define AST_CACHE_NUM_BASES 4096
+
+static char const ast_cache_magic[4] = { 'E', 'L', 'A', 'C' };
+
+struct el_ast_cache_header
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t source_hash;
+	uint64_t preferred_base;
+	uint64_t image_size; // Bytes from the start of the file, including this header
+	uint64_t num_relocations; // Image offsets of every pointer in the image, stored after it
+	uint64_t root_offset;
+	uint32_t statement_size; // Node sizes guard against layout changes without a version bump
+	uint32_t expression_size;
+};
+
+struct el_ast_cache_writer
+{
+	struct el_ast * ast;
+	uint64_t preferred_base;
+
+	unsigned char * image;
+	uint64_t image_size;
+	uint64_t image_capacity;
+
+	uint64_t * relocations;
+	uint64_t num_relocations;
+	uint64_t max_num_relocations;
+};
+
+static int el_ast_cache_reserve(void ** buffer, uint64_t * capacity, uint64_t required);
+static int el_ast_cache_append(struct el_ast_cache_writer * w, void const * src, uint64_t num_bytes, uint64_t * offset);
+static int el_ast_cache_set_pointer(struct el_ast_cache_writer * w, uint64_t field_offset, uint64_t target_offset, bool is_null);
+static void el_ast_cache_set_int(struct el_ast_cache_writer * w, uint64_t field_offset, int value);
+
+static int el_ast_cache_write_string(struct el_ast_cache_writer * w, uint64_t field_offset, el_string s);
+static int el_ast_cache_write_var_type(struct el_ast_cache_writer * w, uint64_t offset, struct el_ast_var_type const * var_type);
+static int el_ast_cache_write_var_decls(struct el_ast_cache_writer * w, uint64_t field_offset, struct el_ast_var_decl const * var_decls, int num_var_decls);
+static int el_ast_cache_write_statement_list(struct el_ast_cache_writer * w, uint64_t offset, struct el_ast_statement_list const * list);
+static int el_ast_cache_write_statement(struct el_ast_cache_writer * w, uint64_t offset, struct el_ast_statement const * statement);
+static int el_ast_cache_write_expression(struct el_ast_cache_writer * w, uint64_t offset, struct el_ast_expression const * expression);
+static int el_ast_cache_write_expression_pointer(struct el_ast_cache_writer * w, uint64_t field_offset, struct el_ast_expression const * expression);
+
+static int el_ast_cache_relocate(unsigned char * image, struct el_ast_cache_header const * header);
+
+uint64_t el_ast_cache_hash(char const * data, int length)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for(int i = 0; i < length; ++i)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+int el_ast_cache_save(struct el_ast * ast, uint64_t source_hash, char const * path)
+{
+	assert(ast && path);
+	int err = el_SUCCESS;
+
+	// The image holds complete function bodies, so bodies skipped by a lazy parse are parsed now
+	for(int i = 0; i < ast->root.num_statements; ++i)
+	{
+		struct el_ast_statement * s = &ast->root.statements[i];
+		if(s->type == el_AST_NODE_FUNCTION_DEFINITION)
+		{
+			err = err || el_parse_function_body(ast, &s->function_definition);
+		}
+	}
+	if(err != 0)
+		return err;
+
+	struct el_ast_cache_writer w = {
+		.ast = ast,
+		.preferred_base = AST_CACHE_BASE_ADDRESS + (source_hash % AST_CACHE_NUM_BASES) * AST_CACHE_BASE_STRIDE
+	};
+
+	uint64_t header_offset = 0;
+	uint64_t root_offset = 0;
+	err = err || el_ast_cache_append(&w, NULL, sizeof(struct el_ast_cache_header), &header_offset);
+	err = err || el_ast_cache_append(&w, &ast->root, sizeof(struct el_ast_statement_list), &root_offset);
+	err = err || el_ast_cache_write_statement_list(&w, root_offset, &ast->root);
+
+	// Pad s.t. the relocation table following the image is aligned
+	uint64_t end_offset = 0;
+	err = err || el_ast_cache_append(&w, NULL, 0, &end_offset);
+
+	if(err == 0)
+	{
+		struct el_ast_cache_header header = {
+			.version = el_AST_CACHE_VERSION,
+			.source_hash = source_hash,
+			.preferred_base = w.preferred_base,
+			.image_size = w.image_size,
+			.num_relocations = w.num_relocations,
+			.root_offset = root_offset,
+			.statement_size = sizeof(struct el_ast_statement),
+			.expression_size = sizeof(struct el_ast_expression)
+		};
+		memcpy(header.magic, ast_cache_magic, sizeof header.magic);
+		memcpy(w.image + header_offset, &header, sizeof header);
+
+		FILE * fptr = fopen(path, "wb");
+		if(!fptr)
+		{
+			fprintf(stderr, "Failed to open ast cache for writing: %s\n", path);
+			err = el_AST_CACHE_IO_ERROR;
+		}
+		else
+		{
+			if(fwrite(w.image, 1, w.image_size, fptr) != w.image_size
+				|| fwrite(w.relocations, sizeof(uint64_t), w.num_relocations, fptr) != w.num_relocations)
+			{
+				fprintf(stderr, "Failed to write ast cache: %s\n", path);
+				err = el_AST_CACHE_IO_ERROR;
+			}
+			if(fclose(fptr) != 0)
+			{
+				err = el_AST_CACHE_IO_ERROR;
+			}
+		}
+	}
+
+	ffree(w.image);
+	ffree(w.relocations);
+	return err;
+}
+
+int el_ast_cache_load(struct el_ast * ast, uint64_t source_hash, char const * path)
+{
+	assert(ast && path);
+	struct el_ast_cache_header header;
+	unsigned char * image = NULL;
+	uint64_t file_size = 0;
+
+#ifdef SYSTEM_WINDOWS
+	// Without a mapping at the preferred base the image is read into memory and always relocated
+	FILE * fptr = fopen(path, "rb");
+	if(!fptr)
+		return el_AST_CACHE_IO_ERROR;
+
+	bool valid = fread(&header, sizeof header, 1, fptr) == 1;
+#else
+	int fd = open(path, O_RDONLY);
+	if(fd < 0)
+		return el_AST_CACHE_IO_ERROR;
+
+	struct stat st;
+	bool valid = fstat(fd, &st) == 0 && pread(fd, &header, sizeof header, 0) == sizeof header;
+	file_size = valid ? (uint64_t)st.st_size : 0;
+#endif
+
+	// A missing or out of date cache is expected, so only a corrupt file is reported
+	int err = el_SUCCESS;
+	if(!valid || memcmp(header.magic, ast_cache_magic, sizeof header.magic) != 0 || header.version != el_AST_CACHE_VERSION
+		|| header.statement_size != sizeof(struct el_ast_statement) || header.expression_size != sizeof(struct el_ast_expression))
+	{
+		err = el_AST_CACHE_STALE_ERROR;
+	}
+	else if(header.source_hash != source_hash)
+	{
+		err = el_AST_CACHE_STALE_ERROR;
+	}
+#ifdef SYSTEM_WINDOWS
+	else
+	{
+		file_size = header.image_size + header.num_relocations * sizeof(uint64_t);
+		image = fmalloc(file_size);
+		if(!image)
+		{
+			err = el_ALLOCATION_ERROR;
+		}
+		else if(fseek(fptr, 0, SEEK_SET) != 0 || fread(image, 1, file_size, fptr) != file_size)
+		{
+			fprintf(stderr, "Failed to read ast cache: %s\n", path);
+			err = el_AST_CACHE_CORRUPT_ERROR;
+		}
+		else
+		{
+			err = el_ast_cache_relocate(image, &header);
+		}
+
+		if(err != 0)
+		{
+			ffree(image);
+			image = NULL;
+		}
+	}
+	fclose(fptr);
+#else
+	else if(file_size != header.image_size + header.num_relocations * sizeof(uint64_t))
+	{
+		fprintf(stderr, "Corrupt ast cache: %s\n", path);
+		err = el_AST_CACHE_CORRUPT_ERROR;
+	}
+	else
+	{
+		// Private mappings are copy-on-write, so relocation and later edits never reach the file
+		void * preferred_base = (void *)(uintptr_t)header.preferred_base;
+		image = mmap(preferred_base, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if(image == MAP_FAILED)
+		{
+			fprintf(stderr, "Failed to map ast cache: %s\n", path);
+			image = NULL;
+			err = el_AST_CACHE_IO_ERROR;
+		}
+		else if(image != preferred_base)
+		{
+			err = el_ast_cache_relocate(image, &header);
+		}
+
+		if(err != 0 && image)
+		{
+			munmap(image, file_size);
+			image = NULL;
+		}
+	}
+	close(fd);
+#endif
+
+	if(err != 0)
+		return err;
+
+	struct el_ast loaded = {
+		.root = *(struct el_ast_statement_list *)(image + header.root_offset),
+		.cache_image = image,
+		.cache_image_size = file_size
+	};
+	*ast = loaded;
+	return el_SUCCESS;
+}
+
+void el_ast_cache_unload(struct el_ast * ast)
+{
+	if(ast && ast->cache_image)
+	{
+#ifdef SYSTEM_WINDOWS
+		ffree(ast->cache_image);
+#else
+		munmap(ast->cache_image, ast->cache_image_size);
+#endif
+		ast->cache_image = NULL;
+		ast->cache_image_size = 0;
+	}
+}
+
+static int el_ast_cache_relocate(unsigned char * image, struct el_ast_cache_header const * header)
+{
+	uint64_t delta = (uint64_t)(uintptr_t)image - header->preferred_base;
+	uint64_t const * relocations = (uint64_t const *)(image + header->image_size);
+	for(uint64_t i = 0; i < header->num_relocations; ++i)
+	{
+		if(relocations[i] > header->image_size - sizeof(uint64_t))
+		{
+			fprintf(stderr, "Corrupt ast cache relocation %llu\n", (unsigned long long)relocations[i]);
+			return el_AST_CACHE_CORRUPT_ERROR;
+		}
+
+		uint64_t pointer;
+		memcpy(&pointer, image + relocations[i], sizeof pointer);
+		pointer += delta;
+		memcpy(image + relocations[i], &pointer, sizeof pointer);
+	}
+	return el_SUCCESS;
+}
+
+static int el_ast_cache_reserve(void ** buffer, uint64_t * capacity, uint64_t required)
+{
+	if(required <= *capacity)
+		return el_SUCCESS;
+
+	uint64_t new_capacity = *capacity > 0 ? *capacity : AST_CACHE_INITIAL_CAPACITY;
+	while(new_capacity < required)
+	{
+		new_capacity *= 2;
+	}
+
+	void * new_buffer = fmalloc(new_capacity);
+	if(!new_buffer)
+	{
+		fprintf(stderr, "Failed to grow ast cache buffer\n");
+		return el_ALLOCATION_ERROR;
+	}
+
+	if(*buffer)
+	{
+		memcpy(new_buffer, *buffer, *capacity);
+		ffree(*buffer);
+	}
+	*buffer = new_buffer;
+	*capacity = new_capacity;
+	return el_SUCCESS;
+}
+
+// Copy num_bytes from src to the end of the image, or zeroes if src is NULL
+// Only offsets into the image are kept while writing as the image moves when it grows
+static int el_ast_cache_append(struct el_ast_cache_writer * w, void const * src, uint64_t num_bytes, uint64_t * offset)
+{
+	uint64_t aligned_size = (w->image_size + AST_CACHE_ALIGNMENT - 1) & ~(uint64_t)(AST_CACHE_ALIGNMENT - 1);
+	if(el_ast_cache_reserve((void **)&w->image, &w->image_capacity, aligned_size + num_bytes) != 0)
+		return el_ALLOCATION_ERROR;
+
+	memset(w->image + w->image_size, 0, aligned_size - w->image_size);
+	if(src)
+	{
+		memcpy(w->image + aligned_size, src, num_bytes);
+	}
+	else
+	{
+		memset(w->image + aligned_size, 0, num_bytes);
+	}
+
+	*offset = aligned_size;
+	w->image_size = aligned_size + num_bytes;
+	return el_SUCCESS;
+}
+
+static int el_ast_cache_set_pointer(struct el_ast_cache_writer * w, uint64_t field_offset, uint64_t target_offset, bool is_null)
+{
+	uint64_t pointer = is_null ? 0 : w->preferred_base + target_offset;
+	memcpy(w->image + field_offset, &pointer, sizeof pointer);
+	if(is_null)
+		return el_SUCCESS;
+
+	uint64_t capacity = w->max_num_relocations * sizeof(uint64_t);
+	if(el_ast_cache_reserve((void **)&w->relocations, &capacity, (w->num_relocations + 1) * sizeof(uint64_t)) != 0)
+		return el_ALLOCATION_ERROR;
+
+	w->max_num_relocations = capacity / sizeof(uint64_t);
+	w->relocations[w->num_relocations++] = field_offset;
+	return el_SUCCESS;
+}
+
+static void el_ast_cache_set_int(struct el_ast_cache_writer * w, uint64_t field_offset, int value)
+{
+	memcpy(w->image + field_offset, &value, sizeof value);
+}
+
+// NOTE - The writers below are given the offset of a node already copied into the image
+// They rewrite its pointers, and trim list capacities to their sizes s.t. the image stays compact
+
+static int el_ast_cache_write_string(struct el_ast_cache_writer * w, uint64_t field_offset, el_string s)
+{
+	if(!s)
+		return el_ast_cache_set_pointer(w, field_offset, 0, true);
+
+	// Strings are prefixed by their length
+	uint64_t offset = 0;
+	int err = el_ast_cache_append(w, s - sizeof(int), el_string_byte_size(s), &offset);
+	err = err || el_ast_cache_set_pointer(w, field_offset, offset + sizeof(int), false);
+	return err;
+}
+
+static int el_ast_cache_write_var_type(struct el_ast_cache_writer * w, uint64_t offset, struct el_ast_var_type const * var_type)
+{
+	if(var_type->is_native)
+		return el_SUCCESS;
+	return el_ast_cache_write_string(w, offset + offsetof(struct el_ast_var_type, custom_type), var_type->custom_type);
+}
+
+static int el_ast_cache_write_var_decls(struct el_ast_cache_writer * w, uint64_t field_offset, struct el_ast_var_decl const * var_decls, int num_var_decls)
+{
+	uint64_t offset = 0;
+	int err = el_ast_cache_append(w, var_decls, sizeof(struct el_ast_var_decl) * num_var_decls, &offset);
+	err = err || el_ast_cache_set_pointer(w, field_offset, offset, var_decls == NULL);
+	for(int i = 0; i < num_var_decls && err == 0; ++i)
+	{
+		uint64_t var_decl_offset = offset + sizeof(struct el_ast_var_decl) * i;
+		err = err || el_ast_cache_write_string(w, var_decl_offset + offsetof(struct el_ast_var_decl, name), var_decls[i].name);
+		err = err || el_ast_cache_write_var_type(w, var_decl_offset + offsetof(struct el_ast_var_decl, type), &var_decls[i].type);
+	}
+	return err;
+}
+
+static int el_ast_cache_write_statement_list(struct el_ast_cache_writer * w, uint64_t offset, struct el_ast_statement_list const * list)
+{
+	uint64_t statements_offset = 0;
+	int err = el_ast_cache_append(w, list->statements, sizeof(struct el_ast_statement) * list->num_statements, &statements_offset);
+	err = err || el_ast_cache_set_pointer(w, offset + offsetof(struct el_ast_statement_list, statements), statements_offset, list->statements == NULL);
+	el_ast_cache_set_int(w, offset + offsetof(struct el_ast_statement_list, max_num_statements), list->num_statements);
+
+	for(int i = 0; i < list->num_statements && err == 0; ++i)
+	{
+		err = err || el_ast_cache_write_statement(w, statements_offset + sizeof(struct el_ast_statement) * i, &list->statements[i]);
+	}
+	return err;
+}
+
+static int el_ast_cache_write_statement(struct el_ast_cache_writer * w, uint64_t offset, struct el_ast_statement const * s)
+{
+	int err = 0;
+	switch(s->type)
+	{
+	case el_AST_NODE_DATA_BLOCK:
+	{
+		uint64_t base = offset + offsetof(struct el_ast_statement, data_block);
+		struct el_ast_data_block const * data_block = &s->data_block;
+		err = err || el_ast_cache_write_string(w, base + offsetof(struct el_ast_data_block, name), data_block->name);
+		err = err || el_ast_cache_write_var_decls(w, base + offsetof(struct el_ast_data_block, var_declarations), data_block->var_declarations, data_block->num_var_declarations);
+		el_ast_cache_set_int(w, base + offsetof(struct el_ast_data_block, max_num_var_declarations), data_block->num_var_declarations);
+		break;
+	}
+	case el_AST_NODE_FUNCTION_DEFINITION:
+	{
+		uint64_t base = offset + offsetof(struct el_ast_statement, function_definition);
+		struct el_ast_function_definition const * function_definition = &s->function_definition;
+		assert(function_definition->is_code_block_parsed);
+		err = err || el_ast_cache_write_string(w, base + offsetof(struct el_ast_function_definition, name), function_definition->name);
+		err = err || el_ast_cache_write_var_decls(w, base + offsetof(struct el_ast_function_definition, parameter_list.parameters),
+			function_definition->parameter_list.parameters, function_definition->parameter_list.num_parameters);
+		el_ast_cache_set_int(w, base + offsetof(struct el_ast_function_definition, parameter_list.max_num_parameters), function_definition->parameter_list.num_parameters);
+		err = err || el_ast_cache_write_var_type(w, base + offsetof(struct el_ast_function_definition, return_type), &function_definition->return_type);
+		err = err || el_ast_cache_write_statement_list(w, base + offsetof(struct el_ast_function_definition, code_block), &function_definition->code_block);
+		break;
+	}
+	case el_AST_NODE_FOR_STATEMENT:
+	{
+		uint64_t base = offset + offsetof(struct el_ast_statement, for_statement);
+		struct el_ast_for_statement const * for_statement = &s->for_statement;
+		err = err || el_ast_cache_write_string(w, base + offsetof(struct el_ast_for_statement, index_var_name), for_statement->index_var_name);
+		err = err || el_ast_cache_write_string(w, base + offsetof(struct el_ast_for_statement, value_var_name), for_statement->value_var_name);
+		err = err || el_ast_cache_write_expression(w, base + offsetof(struct el_ast_for_statement, range), &for_statement->range);
+		err = err || el_ast_cache_write_statement_list(w, base + offsetof(struct el_ast_for_statement, code_block), &for_statement->code_block);
+
+		uint64_t reductions_offset = 0;
+		err = err || el_ast_cache_append(w, for_statement->reductions, sizeof(struct el_ast_reduction) * for_statement->num_reductions, &reductions_offset);
+		err = err || el_ast_cache_set_pointer(w, base + offsetof(struct el_ast_for_statement, reductions), reductions_offset, for_statement->reductions == NULL);
+		el_ast_cache_set_int(w, base + offsetof(struct el_ast_for_statement, max_num_reductions), for_statement->num_reductions);
+		for(int i = 0; i < for_statement->num_reductions && err == 0; ++i)
+		{
+			uint64_t reduction_offset = reductions_offset + sizeof(struct el_ast_reduction) * i;
+			err = err || el_ast_cache_write_string(w, reduction_offset + offsetof(struct el_ast_reduction, var_name), for_statement->reductions[i].var_name);
+		}
+		break;
+	}
+	case el_AST_NODE_IF_STATEMENT:
+	{
+		uint64_t base = offset + offsetof(struct el_ast_statement, if_statement);
+		struct el_ast_if_statement const * if_statement = &s->if_statement;
+		err = err || el_ast_cache_write_expression(w, base + offsetof(struct el_ast_if_statement, expression), &if_statement->expression);
+		err = err || el_ast_cache_write_statement_list(w, base + offsetof(struct el_ast_if_statement, code_block), &if_statement->code_block);
+
+		uint64_t elifs_offset = 0;
+		err = err || el_ast_cache_append(w, if_statement->elif_statements, sizeof(struct el_ast_elif_statement) * if_statement->num_elif_statements, &elifs_offset);
+		err = err || el_ast_cache_set_pointer(w, base + offsetof(struct el_ast_if_statement, elif_statements), elifs_offset, if_statement->elif_statements == NULL);
+		el_ast_cache_set_int(w, base + offsetof(struct el_ast_if_statement, max_num_elif_statements), if_statement->num_elif_statements);
+		for(int i = 0; i < if_statement->num_elif_statements && err == 0; ++i)
+		{
+			uint64_t elif_offset = elifs_offset + sizeof(struct el_ast_elif_statement) * i;
+			err = err || el_ast_cache_write_expression(w, elif_offset + offsetof(struct el_ast_elif_statement, expression), &if_statement->elif_statements[i].expression);
+			err = err || el_ast_cache_write_statement_list(w, elif_offset + offsetof(struct el_ast_elif_statement, code_block), &if_statement->elif_statements[i].code_block);
+		}
+
+		uint64_t else_offset = 0;
+		if(if_statement->else_statement)
+		{
+			err = err || el_ast_cache_append(w, if_statement->else_statement, sizeof(struct el_ast_statement_list), &else_offset);
+			err = err || el_ast_cache_write_statement_list(w, else_offset, if_statement->else_statement);
+		}
+		err = err || el_ast_cache_set_pointer(w, base + offsetof(struct el_ast_if_statement, else_statement), else_offset, if_statement->else_statement == NULL);
+		break;
+	}
+	case el_AST_NODE_ASSIGNMENT:
+		err = err || el_ast_cache_write_expression(w, offset + offsetof(struct el_ast_statement, assignment.lhs), &s->assignment.lhs);
+		err = err || el_ast_cache_write_expression(w, offset + offsetof(struct el_ast_statement, assignment.rhs), &s->assignment.rhs);
+		break;
+	case el_AST_NODE_RETURN_STATEMENT:
+		err = err || el_ast_cache_write_expression(w, offset + offsetof(struct el_ast_statement, return_statement.expression), &s->return_statement.expression);
+		break;
+	case el_AST_NODE_EXPRESSION:
+		err = err || el_ast_cache_write_expression(w, offset + offsetof(struct el_ast_statement, expression), &s->expression);
+		break;
+	}
+	return err;
+}
+
+static int el_ast_cache_write_expression(struct el_ast_cache_writer * w, uint64_t offset, struct el_ast_expression const * e)
+{
+	int err = 0;
+	switch(e->type)
+	{
+	case el_AST_EXPR_EQUALS:
+	case el_AST_EXPR_GREATER_THAN:
+	case el_AST_EXPR_LESS_THAN:
+	case el_AST_EXPR_GEQUALS:
+	case el_AST_EXPR_LEQUALS:
+	case el_AST_EXPR_BOOLEAN_AND:
+	case el_AST_EXPR_BOOLEAN_OR:
+	case el_AST_EXPR_ADD:
+	case el_AST_EXPR_SUB:
+	case el_AST_EXPR_MUL:
+	case el_AST_EXPR_DIV:
+	case el_AST_EXPR_DOT:
+	case el_AST_EXPR_FUNCTION_CALL:
+	case el_AST_EXPR_SLICE_INDEX:
+		err = err || el_ast_cache_write_expression_pointer(w, offset + offsetof(struct el_ast_expression, binary_op.lhs), e->binary_op.lhs);
+		err = err || el_ast_cache_write_expression_pointer(w, offset + offsetof(struct el_ast_expression, binary_op.rhs), e->binary_op.rhs);
+		break;
+	case el_AST_EXPR_ARGUMENTS:
+	case el_AST_EXPR_SLICE_LITERAL:
+	{
+		struct el_ast_expression_list const * list = e->expression_list;
+		uint64_t list_offset = 0;
+		uint64_t expressions_offset = 0;
+		err = err || el_ast_cache_append(w, list, sizeof(struct el_ast_expression_list), &list_offset);
+		err = err || el_ast_cache_set_pointer(w, offset + offsetof(struct el_ast_expression, expression_list), list_offset, false);
+		err = err || el_ast_cache_append(w, list->expressions, sizeof(struct el_ast_expression) * list->num_expressions, &expressions_offset);
+		err = err || el_ast_cache_set_pointer(w, list_offset + offsetof(struct el_ast_expression_list, expressions), expressions_offset, list->expressions == NULL);
+		if(err == 0)
+		{
+			el_ast_cache_set_int(w, list_offset + offsetof(struct el_ast_expression_list, max_num_expressions), list->num_expressions);
+		}
+		for(int i = 0; i < list->num_expressions && err == 0; ++i)
+		{
+			err = err || el_ast_cache_write_expression(w, expressions_offset + sizeof(struct el_ast_expression) * i, &list->expressions[i]);
+		}
+		break;
+	}
+	case el_AST_EXPR_NUMBER_LITERAL:
+		err = err || el_ast_cache_write_string(w, offset + offsetof(struct el_ast_expression, number_literal), e->number_literal);
+		break;
+	case el_AST_EXPR_STRING_LITERAL:
+		err = err || el_ast_cache_write_string(w, offset + offsetof(struct el_ast_expression, string_literal), e->string_literal);
+		break;
+	case el_AST_EXPR_IDENTIFIER:
+		err = err || el_ast_cache_write_string(w, offset + offsetof(struct el_ast_expression, identifier), e->identifier);
+		break;
+	}
+	return err;
+}
+
+static int el_ast_cache_write_expression_pointer(struct el_ast_cache_writer * w, uint64_t field_offset, struct el_ast_expression const * e)
+{
+	if(!e)
+		return el_ast_cache_set_pointer(w, field_offset, 0, true);
+
+	uint64_t offset = 0;
+	int err = el_ast_cache_append(w, e, sizeof(struct el_ast_expression), &offset);
+	err = err || el_ast_cache_set_pointer(w, field_offset, offset, false);
+	err = err || el_ast_cache_write_expression(w, offset, e);
+	return err;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "ast.h"
+#include <stdint.h>
+
+// Bump whenever the layout of any ast node changes
+#define el_AST_CACHE_VERSION 6
+
+// Hash of a source file's contents, used to detect stale caches
+uint64_t el_ast_cache_hash(char const * data, int length);
+
+// Write the ast to a binary cache file at path
+// Nodes are compacted into a single image in which pointers are image offsets biased by a preferred base address
+// Function bodies skipped by a lazy parse are parsed first, so the ast may be modified
+int el_ast_cache_save(struct el_ast * ast, uint64_t source_hash, char const * path);
+
+// Map a cache file written by el_ast_cache_save into memory and use it as the ast
+// If the image can be mapped at its preferred base address it is used in place without any pointer fix-ups
+// Fails if the file is missing, was written by a different version or source_hash does not match
+// The ast must be deleted with el_ast_delete
+int el_ast_cache_load(struct el_ast * ast, uint64_t source_hash, char const * path);
+
+// Unmap an image loaded by el_ast_cache_load, called by el_ast_delete
+void el_ast_cache_unload(struct el_ast * ast);
@@ -0,0 +1,512 @@
+#include "ast-dump.h"
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <compiler/lexing/lexer.h>
+#include <containers/array.h>
+#include <containers/string.h>
+#include <file-system/buffered-writer.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define DUMP_INITIAL_STACK_CAPACITY 256
+#define MAX_NUM_DUMP_ATTRS 3
+#define MAX_TYPE_NAME_LENGTH 256
+
+static int const indent_incr = 2;
+
+static char const * const reduction_names[] = {
+	"sum",
+	"min",
+	"max"
+};
+
+static_assert(ARRAY_SIZE(reduction_names) == el_ast_reduction_type_count, "ast-dump's reduction_names array is not up-to-date with el_ast_reduction_type");
+
+static char const * expr_names[] = {
+	"==",
+	">",
+	"<",
+	">=",
+	"<=",
+
+	"and",
+	"or",
+
+	"+",
+	"-",
+	"*",
+	"/",
+
+	".",
+
+	"call",
+	"index",
+
+	"number",
+	"string",
+	"slice",
+
+	"args",
+
+	"identifier",
+	"vector type",
+};
+
+static_assert(ARRAY_SIZE(expr_names) == el_ast_expression_type_count, "ast-dump's expr_names array is not up-to-date with el_ast_expression_type");
+
+enum el_dump_item_type
+{
+	el_DUMP_STATEMENT,
+	el_DUMP_EXPRESSION,
+	el_DUMP_BLOCK, // A statement list, labelled by the item
+	el_DUMP_UNPARSED_BLOCK,
+	el_DUMP_VAR_DECL, // Labelled by the item
+	el_DUMP_ELIF,
+	el_DUMP_REDUCTION,
+	el_DUMP_CLOSE
+};
+
+struct el_dump_item
+{
+	int type;
+	int depth;
+	bool is_first_child;
+	char const * label;
+	void const * node;
+};
+
+struct el_dump_attr
+{
+	char const * key;
+	char const * value;
+};
+
+struct el_ast_dumper
+{
+	struct el_buffered_writer * writer;
+	int format;
+
+	struct el_dump_item * stack;
+	int stack_size;
+	int stack_capacity;
+};
+
+static void el_dump_write(struct el_ast_dumper * d, char const * s, int length);
+static void el_dump_write_string(struct el_ast_dumper * d, char const * s);
+static void el_dump_write_json_string(struct el_ast_dumper * d, char const * s);
+static void el_dump_write_indent(struct el_ast_dumper * d, int depth);
+
+static void el_dump_open(struct el_ast_dumper * d, struct el_dump_item const * item, char const * label, struct el_dump_attr const * attrs, int num_attrs);
+static void el_dump_close(struct el_ast_dumper * d, struct el_dump_item const * item);
+static void el_dump_format_type(struct el_ast_var_type const * type, char * buffer, int buffer_size);
+
+static int el_dump_push(struct el_ast_dumper * d, int type, int depth, char const * label, void const * node);
+static int el_dump_push_children(struct el_ast_dumper * d, struct el_dump_item const * parent, struct el_dump_item const * children, int num_children);
+static int el_dump_push_statement_list(struct el_ast_dumper * d, struct el_ast_statement_list const * list, int depth);
+static int el_dump_item(struct el_ast_dumper * d, struct el_dump_item const * item);
+
+int el_ast_dump(struct el_ast * ast, struct el_buffered_writer * writer, int format)
+{
+	assert(ast && writer);
+	struct el_ast_dumper d = {
+		.writer = writer,
+		.format = format,
+		.stack = NULL,
+		.stack_size = 0,
+		.stack_capacity = 0
+	};
+
+	if(format == el_AST_DUMP_JSON)
+	{
+		el_dump_write_string(&d, "[");
+	}
+
+	// The stack holds nodes still to be written and the closing of nodes whose children are pending
+	int err = el_dump_push_statement_list(&d, &ast->root, 0);
+	while(err == 0 && d.stack_size > 0)
+	{
+		struct el_dump_item item = d.stack[--d.stack_size];
+		err = el_dump_item(&d, &item);
+	}
+
+	if(format == el_AST_DUMP_JSON)
+	{
+		el_dump_write_string(&d, "]\n");
+	}
+
+	ffree(d.stack);
+
+	if(err == 0 && !el_buffered_writer_flush(writer))
+	{
+		fprintf(stderr, "Failed to write ast dump\n");
+		err = el_IO_ERROR;
+	}
+	return err;
+}
+
+static int el_dump_item(struct el_ast_dumper * d, struct el_dump_item const * item)
+{
+	struct el_dump_item children[2];
+	struct el_dump_attr attrs[MAX_NUM_DUMP_ATTRS];
+	char type_name[MAX_TYPE_NAME_LENGTH];
+	int depth = item->depth + 1;
+	int err = 0;
+
+	switch(item->type)
+	{
+	case el_DUMP_CLOSE:
+		el_dump_close(d, item);
+		return el_SUCCESS;
+	case el_DUMP_BLOCK:
+		el_dump_open(d, item, item->label, NULL, 0);
+		err = err || el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+		err = err || el_dump_push_statement_list(d, item->node, depth);
+		return err;
+	case el_DUMP_UNPARSED_BLOCK:
+		attrs[0] = (struct el_dump_attr){ "parsed", "false" };
+		el_dump_open(d, item, item->label, attrs, 1);
+		return el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+	case el_DUMP_VAR_DECL:
+	{
+		struct el_ast_var_decl const * var_decl = item->node;
+		el_dump_format_type(&var_decl->type, type_name, sizeof type_name);
+		attrs[0] = (struct el_dump_attr){ "name", var_decl->name };
+		attrs[1] = (struct el_dump_attr){ "type", type_name };
+		el_dump_open(d, item, item->label, attrs, 2);
+		return el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+	}
+	case el_DUMP_ELIF:
+	{
+		struct el_ast_elif_statement const * elif_statement = item->node;
+		el_dump_open(d, item, "elif", NULL, 0);
+		children[0] = (struct el_dump_item){ el_DUMP_EXPRESSION, depth, true, NULL, &elif_statement->expression };
+		children[1] = (struct el_dump_item){ el_DUMP_BLOCK, depth, false, "body", &elif_statement->code_block };
+		return el_dump_push_children(d, item, children, 2);
+	}
+	case el_DUMP_REDUCTION:
+	{
+		struct el_ast_reduction const * reduction = item->node;
+		attrs[0] = (struct el_dump_attr){ "op", reduction_names[reduction->type] };
+		attrs[1] = (struct el_dump_attr){ "name", reduction->var_name };
+		el_dump_open(d, item, "reduce", attrs, 2);
+		return el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+	}
+	case el_DUMP_EXPRESSION:
+	{
+		struct el_ast_expression const * e = item->node;
+		switch(e->type)
+		{
+		case el_AST_EXPR_NUMBER_LITERAL:
+		case el_AST_EXPR_STRING_LITERAL:
+		case el_AST_EXPR_IDENTIFIER:
+			// Literals and identifiers share the same string member
+			attrs[0] = (struct el_dump_attr){ e->type == el_AST_EXPR_IDENTIFIER ? "name" : "value", e->identifier };
+			el_dump_open(d, item, expr_names[e->type], attrs, 1);
+			return el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+		case el_AST_EXPR_VECTOR_TYPE:
+			attrs[0] = (struct el_dump_attr){ "name", el_token_string(e->native_type) };
+			el_dump_open(d, item, expr_names[e->type], attrs, 1);
+			return el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+		case el_AST_EXPR_ARGUMENTS:
+		case el_AST_EXPR_SLICE_LITERAL:
+		{
+			el_dump_open(d, item, expr_names[e->type], NULL, 0);
+			err = err || el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+			struct el_ast_expression_list const * list = e->expression_list;
+			for(int i = list->num_expressions - 1; i >= 0 && err == 0; --i)
+			{
+				err = err || el_dump_push(d, el_DUMP_EXPRESSION, depth, NULL, &list->expressions[i]);
+				d->stack[d->stack_size - 1].is_first_child = i == 0;
+			}
+			return err;
+		}
+		default:
+			el_dump_open(d, item, expr_names[e->type], NULL, 0);
+			children[0] = (struct el_dump_item){ el_DUMP_EXPRESSION, depth, true, NULL, e->binary_op.lhs };
+			children[1] = (struct el_dump_item){ el_DUMP_EXPRESSION, depth, false, NULL, e->binary_op.rhs };
+			return el_dump_push_children(d, item, children, 2);
+		}
+	}
+	case el_DUMP_STATEMENT:
+		break;
+	}
+
+	struct el_ast_statement const * s = item->node;
+	switch(s->type)
+	{
+	case el_AST_NODE_DATA_BLOCK:
+	{
+		struct el_ast_data_block const * data_block = &s->data_block;
+		attrs[0] = (struct el_dump_attr){ "name", data_block->name };
+		attrs[1] = (struct el_dump_attr){ "layout", "soa" };
+		el_dump_open(d, item, "dat", attrs, data_block->is_soa ? 2 : 1);
+		err = err || el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+		for(int i = data_block->num_var_declarations - 1; i >= 0 && err == 0; --i)
+		{
+			err = err || el_dump_push(d, el_DUMP_VAR_DECL, depth, "field", &data_block->var_declarations[i]);
+			d->stack[d->stack_size - 1].is_first_child = i == 0;
+		}
+		return err;
+	}
+	case el_AST_NODE_FUNCTION_DEFINITION:
+	{
+		struct el_ast_function_definition const * function_definition = &s->function_definition;
+		el_dump_format_type(&function_definition->return_type, type_name, sizeof type_name);
+		attrs[0] = (struct el_dump_attr){ "name", function_definition->name };
+		attrs[1] = (struct el_dump_attr){ "returns", type_name };
+		el_dump_open(d, item, "fnc", attrs, 2);
+		err = err || el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+		err = err || el_dump_push(d, function_definition->is_code_block_parsed ? el_DUMP_BLOCK : el_DUMP_UNPARSED_BLOCK, depth, "body", &function_definition->code_block);
+		d->stack[d->stack_size - 1].is_first_child = function_definition->parameter_list.num_parameters == 0;
+		for(int i = function_definition->parameter_list.num_parameters - 1; i >= 0 && err == 0; --i)
+		{
+			err = err || el_dump_push(d, el_DUMP_VAR_DECL, depth, "param", &function_definition->parameter_list.parameters[i]);
+			d->stack[d->stack_size - 1].is_first_child = i == 0;
+		}
+		return err;
+	}
+	case el_AST_NODE_FOR_STATEMENT:
+	{
+		struct el_ast_for_statement const * for_statement = &s->for_statement;
+		attrs[0] = (struct el_dump_attr){ "index", for_statement->index_var_name };
+		attrs[1] = (struct el_dump_attr){ "value", for_statement->value_var_name };
+		el_dump_open(d, item, for_statement->is_parallel ? "parallel for" : "for", attrs, 2);
+		err = err || el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+		err = err || el_dump_push(d, el_DUMP_BLOCK, depth, "body", &for_statement->code_block);
+		d->stack[d->stack_size - 1].is_first_child = false;
+		err = err || el_dump_push(d, el_DUMP_EXPRESSION, depth, NULL, &for_statement->range);
+		d->stack[d->stack_size - 1].is_first_child = for_statement->num_reductions == 0;
+		for(int i = for_statement->num_reductions - 1; i >= 0 && err == 0; --i)
+		{
+			err = err || el_dump_push(d, el_DUMP_REDUCTION, depth, NULL, &for_statement->reductions[i]);
+			d->stack[d->stack_size - 1].is_first_child = i == 0;
+		}
+		return err;
+	}
+	case el_AST_NODE_IF_STATEMENT:
+	{
+		struct el_ast_if_statement const * if_statement = &s->if_statement;
+		el_dump_open(d, item, "if", NULL, 0);
+		err = err || el_dump_push(d, el_DUMP_CLOSE, item->depth, NULL, NULL);
+		if(if_statement->else_statement)
+		{
+			err = err || el_dump_push(d, el_DUMP_BLOCK, depth, "else", if_statement->else_statement);
+			d->stack[d->stack_size - 1].is_first_child = false;
+		}
+		for(int i = if_statement->num_elif_statements - 1; i >= 0 && err == 0; --i)
+		{
+			err = err || el_dump_push(d, el_DUMP_ELIF, depth, NULL, &if_statement->elif_statements[i]);
+			d->stack[d->stack_size - 1].is_first_child = false;
+		}
+		err = err || el_dump_push(d, el_DUMP_BLOCK, depth, "body", &if_statement->code_block);
+		d->stack[d->stack_size - 1].is_first_child = false;
+		err = err || el_dump_push(d, el_DUMP_EXPRESSION, depth, NULL, &if_statement->expression);
+		return err;
+	}
+	case el_AST_NODE_ASSIGNMENT:
+		el_dump_open(d, item, "=", NULL, 0);
+		children[0] = (struct el_dump_item){ el_DUMP_EXPRESSION, depth, true, NULL, &s->assignment.lhs };
+		children[1] = (struct el_dump_item){ el_DUMP_EXPRESSION, depth, false, NULL, &s->assignment.rhs };
+		return el_dump_push_children(d, item, children, 2);
+	case el_AST_NODE_RETURN_STATEMENT:
+		el_dump_open(d, item, "ret", NULL, 0);
+		children[0] = (struct el_dump_item){ el_DUMP_EXPRESSION, depth, true, NULL, &s->return_statement.expression };
+		return el_dump_push_children(d, item, children, 1);
+	case el_AST_NODE_EXPRESSION:
+	{
+		// An expression statement is written as the expression itself
+		struct el_dump_item expression = *item;
+		expression.type = el_DUMP_EXPRESSION;
+		expression.node = &s->expression;
+		return el_dump_item(d, &expression);
+	}
+	}
+	return err;
+}
+
+// Push the closing of parent, then its children in reverse s.t. they are popped in order
+static int el_dump_push_children(struct el_ast_dumper * d, struct el_dump_item const * parent, struct el_dump_item const * children, int num_children)
+{
+	int err = el_dump_push(d, el_DUMP_CLOSE, parent->depth, NULL, NULL);
+	for(int i = num_children - 1; i >= 0 && err == 0; --i)
+	{
+		err = err || el_dump_push(d, children[i].type, children[i].depth, children[i].label, children[i].node);
+		d->stack[d->stack_size - 1].is_first_child = children[i].is_first_child;
+	}
+	return err;
+}
+
+static int el_dump_push_statement_list(struct el_ast_dumper * d, struct el_ast_statement_list const * list, int depth)
+{
+	int err = 0;
+	for(int i = list->num_statements - 1; i >= 0 && err == 0; --i)
+	{
+		err = err || el_dump_push(d, el_DUMP_STATEMENT, depth, NULL, &list->statements[i]);
+		d->stack[d->stack_size - 1].is_first_child = i == 0;
+	}
+	return err;
+}
+
+static int el_dump_push(struct el_ast_dumper * d, int type, int depth, char const * label, void const * node)
+{
+	if(d->stack_size >= d->stack_capacity)
+	{
+		int capacity = d->stack_capacity > 0 ? d->stack_capacity * 2 : DUMP_INITIAL_STACK_CAPACITY;
+		struct el_dump_item * stack = fmalloc(sizeof(struct el_dump_item) * capacity);
+		if(!stack)
+		{
+			fprintf(stderr, "Failed to grow ast dump stack\n");
+			return el_ALLOCATION_ERROR;
+		}
+
+		if(d->stack)
+		{
+			memcpy(stack, d->stack, sizeof(struct el_dump_item) * d->stack_size);
+			ffree(d->stack);
+		}
+		d->stack = stack;
+		d->stack_capacity = capacity;
+	}
+
+	struct el_dump_item item = {
+		.type = type,
+		.depth = depth,
+		.is_first_child = true,
+		.label = label,
+		.node = node
+	};
+	d->stack[d->stack_size++] = item;
+	return el_SUCCESS;
+}
+
+static void el_dump_open(struct el_ast_dumper * d, struct el_dump_item const * item, char const * label, struct el_dump_attr const * attrs, int num_attrs)
+{
+	switch(d->format)
+	{
+	case el_AST_DUMP_TEXT:
+		el_dump_write_indent(d, item->depth);
+		el_dump_write_string(d, label);
+		for(int i = 0; i < num_attrs; ++i)
+		{
+			el_dump_write_string(d, " ");
+			el_dump_write_string(d, attrs[i].value);
+		}
+		el_dump_write_string(d, "\n");
+		break;
+	case el_AST_DUMP_SEXPR:
+		if(item->depth > 0)
+		{
+			el_dump_write_string(d, "\n");
+			el_dump_write_indent(d, item->depth);
+		}
+		el_dump_write_string(d, "(");
+		el_dump_write_string(d, label);
+		for(int i = 0; i < num_attrs; ++i)
+		{
+			el_dump_write_string(d, " :");
+			el_dump_write_string(d, attrs[i].key);
+			el_dump_write_string(d, " ");
+			el_dump_write_json_string(d, attrs[i].value);
+		}
+		break;
+	case el_AST_DUMP_JSON:
+		el_dump_write_string(d, item->is_first_child ? "{\"node\":" : ",{\"node\":");
+		el_dump_write_json_string(d, label);
+		for(int i = 0; i < num_attrs; ++i)
+		{
+			el_dump_write_string(d, ",");
+			el_dump_write_json_string(d, attrs[i].key);
+			el_dump_write_string(d, ":");
+			el_dump_write_json_string(d, attrs[i].value);
+		}
+		el_dump_write_string(d, ",\"children\":[");
+		break;
+	}
+}
+
+static void el_dump_close(struct el_ast_dumper * d, struct el_dump_item const * item)
+{
+	switch(d->format)
+	{
+	case el_AST_DUMP_TEXT:
+		// Top-level statements are separated by a blank line
+		if(item->depth == 0)
+		{
+			el_dump_write_string(d, "\n");
+		}
+		break;
+	case el_AST_DUMP_SEXPR:
+		el_dump_write_string(d, item->depth == 0 ? ")\n" : ")");
+		break;
+	case el_AST_DUMP_JSON:
+		el_dump_write_string(d, "]}");
+		break;
+	}
+}
+
+static void el_dump_format_type(struct el_ast_var_type const * type, char * buffer, int buffer_size)
+{
+	char const * name = "N/A";
+	if(!type->is_native)
+	{
+		name = type->custom_type;
+	}
+	else if(type->native_type == el_NONE)
+	{
+		name = "void";
+	}
+	else
+	{
+		name = el_token_string(type->native_type);
+	}
+
+	int length = snprintf(buffer, buffer_size, "%s", name);
+	for(int i = 0; i < type->num_dimensions && length + 2 < buffer_size; ++i)
+	{
+		buffer[length++] = '[';
+		buffer[length++] = ']';
+		buffer[length] = '\0';
+	}
+}
+
+static void el_dump_write(struct el_ast_dumper * d, char const * s, int length)
+{
+	el_buffered_writer_write(d->writer, s, length);
+}
+
+static void el_dump_write_string(struct el_ast_dumper * d, char const * s)
+{
+	el_dump_write(d, s, (int)strlen(s));
+}
+
+static void el_dump_write_json_string(struct el_ast_dumper * d, char const * s)
+{
+	el_dump_write(d, "\"", 1);
+	char const * run = s;
+	for(; *s; ++s)
+	{
+		if(*s != '"' && *s != '\\' && (unsigned char)*s >= 0x20)
+			continue;
+
+		el_dump_write(d, run, (int)(s - run));
+		char escaped[8];
+		int length = (*s == '"' || *s == '\\') ? snprintf(escaped, sizeof escaped, "\\%c", *s) : snprintf(escaped, sizeof escaped, "\\u%04x", (unsigned char)*s);
+		el_dump_write(d, escaped, length);
+		run = s + 1;
+	}
+	el_dump_write(d, run, (int)(s - run));
+	el_dump_write(d, "\"", 1);
+}
+
+static void el_dump_write_indent(struct el_ast_dumper * d, int depth)
+{
+	static char const spaces[] = "                                                                ";
+	int num_spaces = depth * indent_incr;
+	while(num_spaces > 0)
+	{
+		int num_bytes = num_spaces < (int)sizeof spaces - 1 ? num_spaces : (int)sizeof spaces - 1;
+		el_dump_write(d, spaces, num_bytes);
+		num_spaces -= num_bytes;
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "ast.h"
+
+struct el_buffered_writer;
+
+enum el_ast_dump_format
+{
+	el_AST_DUMP_TEXT, // One node per line, children indented beneath their parent
+	el_AST_DUMP_SEXPR,
+	el_AST_DUMP_JSON
+};
+
+// Write the ast to writer in the given format, flushing it once the whole tree is written
+// The tree is walked without recursion, s.t. deep expressions are safe to dump
+int el_ast_dump(struct el_ast * ast, struct el_buffered_writer * writer, int format);
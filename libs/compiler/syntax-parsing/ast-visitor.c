@@ -0,0 +1,274 @@
+#include "ast-visitor.h"
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define VISIT_INITIAL_STACK_CAPACITY 256
+
+#if defined(__GNUC__) || defined(__clang__)
+#define EL_PREFETCH(address) __builtin_prefetch(address)
+#elif defined(_MSC_VER)
+#include <xmmintrin.h>
+#define EL_PREFETCH(address) _mm_prefetch((char const *)(address), _MM_HINT_T0)
+#else
+#define EL_PREFETCH(address) ((void)(address))
+#endif
+
+enum el_visit_item_type
+{
+	el_VISIT_STATEMENT,
+	el_VISIT_EXPRESSION,
+	el_VISIT_LEAVE_STATEMENT,
+	el_VISIT_LEAVE_EXPRESSION
+};
+
+struct el_visit_item
+{
+	int type;
+	void * node;
+};
+
+struct el_ast_walk
+{
+	struct el_ast_visitor const * visitor;
+
+	// Starts out in initial_stack and only moves to the heap for deep or wide trees
+	struct el_visit_item * stack;
+	int stack_size;
+	int stack_capacity;
+	struct el_visit_item initial_stack[VISIT_INITIAL_STACK_CAPACITY];
+};
+
+static void el_walk_init(struct el_ast_walk * w, struct el_ast_visitor const * visitor);
+static int el_walk_run(struct el_ast_walk * w);
+static void el_walk_delete(struct el_ast_walk * w);
+
+static int el_walk_grow(struct el_ast_walk * w, int num_items);
+static int el_walk_push_statement_list(struct el_ast_walk * w, struct el_ast_statement_list * list);
+static int el_walk_push_expression_list(struct el_ast_walk * w, struct el_ast_expression_list * list);
+static int el_walk_push_expression(struct el_ast_walk * w, struct el_ast_expression * e);
+static int el_walk_statement(struct el_ast_walk * w, struct el_ast_statement * s);
+static int el_walk_expression(struct el_ast_walk * w, struct el_ast_expression * e);
+
+int el_ast_visit(struct el_ast * ast, struct el_ast_visitor const * visitor)
+{
+	assert(ast);
+	return el_ast_visit_statements(&ast->root, visitor);
+}
+
+int el_ast_visit_statements(struct el_ast_statement_list * list, struct el_ast_visitor const * visitor)
+{
+	assert(list && visitor);
+	struct el_ast_walk w;
+	el_walk_init(&w, visitor);
+	int err = el_walk_push_statement_list(&w, list);
+	err = err || el_walk_run(&w);
+	el_walk_delete(&w);
+	return err;
+}
+
+int el_ast_visit_expression(struct el_ast_expression * expression, struct el_ast_visitor const * visitor)
+{
+	assert(expression && visitor);
+	struct el_ast_walk w;
+	el_walk_init(&w, visitor);
+	int err = el_walk_push_expression(&w, expression);
+	err = err || el_walk_run(&w);
+	el_walk_delete(&w);
+	return err;
+}
+
+static void el_walk_init(struct el_ast_walk * w, struct el_ast_visitor const * visitor)
+{
+	w->visitor = visitor;
+	w->stack = w->initial_stack;
+	w->stack_size = 0;
+	w->stack_capacity = VISIT_INITIAL_STACK_CAPACITY;
+}
+
+static int el_walk_run(struct el_ast_walk * w)
+{
+	struct el_ast_visitor const * v = w->visitor;
+	int err = 0;
+	while(w->stack_size > 0 && err == 0)
+	{
+		struct el_visit_item item = w->stack[--w->stack_size];
+		switch(item.type)
+		{
+		case el_VISIT_STATEMENT:
+			err = el_walk_statement(w, item.node);
+			break;
+		case el_VISIT_EXPRESSION:
+			err = el_walk_expression(w, item.node);
+			break;
+		case el_VISIT_LEAVE_STATEMENT:
+		{
+			struct el_ast_statement * s = item.node;
+			v->leave_statement[s->type](s, v->context);
+			break;
+		}
+		case el_VISIT_LEAVE_EXPRESSION:
+		{
+			struct el_ast_expression * e = item.node;
+			v->leave_expression[e->type](e, v->context);
+			break;
+		}
+		}
+	}
+	return err;
+}
+
+static void el_walk_delete(struct el_ast_walk * w)
+{
+	if(w->stack != w->initial_stack)
+		ffree(w->stack);
+}
+
+// Make room for num_items more items on the stack
+static int el_walk_grow(struct el_ast_walk * w, int num_items)
+{
+	if(w->stack_size + num_items <= w->stack_capacity)
+		return el_SUCCESS;
+
+	int capacity = w->stack_capacity * 2;
+	while(capacity < w->stack_size + num_items)
+		capacity *= 2;
+
+	struct el_visit_item * stack = fmalloc(sizeof(struct el_visit_item) * capacity);
+	if(!stack)
+	{
+		fprintf(stderr, "Failed to grow ast visitor stack\n");
+		return el_ALLOCATION_ERROR;
+	}
+
+	memcpy(stack, w->stack, sizeof(struct el_visit_item) * w->stack_size);
+	el_walk_delete(w);
+	w->stack = stack;
+	w->stack_capacity = capacity;
+	return el_SUCCESS;
+}
+
+// Children are pushed in reverse s.t. they are popped in source order
+// Each is prefetched as it is pushed, s.t. it is likely cached by the time its earlier siblings have been visited
+static int el_walk_push_statement_list(struct el_ast_walk * w, struct el_ast_statement_list * list)
+{
+	int err = el_walk_grow(w, list->num_statements);
+	for(int i = list->num_statements - 1; i >= 0 && err == 0; --i)
+	{
+		EL_PREFETCH(&list->statements[i]);
+		w->stack[w->stack_size++] = (struct el_visit_item){ el_VISIT_STATEMENT, &list->statements[i] };
+	}
+	return err;
+}
+
+static int el_walk_push_expression_list(struct el_ast_walk * w, struct el_ast_expression_list * list)
+{
+	int err = el_walk_grow(w, list->num_expressions);
+	for(int i = list->num_expressions - 1; i >= 0 && err == 0; --i)
+	{
+		EL_PREFETCH(&list->expressions[i]);
+		w->stack[w->stack_size++] = (struct el_visit_item){ el_VISIT_EXPRESSION, &list->expressions[i] };
+	}
+	return err;
+}
+
+static int el_walk_push_expression(struct el_ast_walk * w, struct el_ast_expression * e)
+{
+	int err = el_walk_grow(w, 1);
+	if(err == 0)
+	{
+		EL_PREFETCH(e);
+		w->stack[w->stack_size++] = (struct el_visit_item){ el_VISIT_EXPRESSION, e };
+	}
+	return err;
+}
+
+static int el_walk_statement(struct el_ast_walk * w, struct el_ast_statement * s)
+{
+	struct el_ast_visitor const * v = w->visitor;
+	if(v->enter_statement[s->type] && !v->enter_statement[s->type](s, v->context))
+		return el_SUCCESS;
+
+	// The leave item is pushed first s.t. it is popped after all of the children
+	int err = 0;
+	if(v->leave_statement[s->type])
+	{
+		err = err || el_walk_grow(w, 1);
+		if(err == 0)
+			w->stack[w->stack_size++] = (struct el_visit_item){ el_VISIT_LEAVE_STATEMENT, s };
+	}
+
+	switch(s->type)
+	{
+	case el_AST_NODE_DATA_BLOCK:
+		break;
+	case el_AST_NODE_FUNCTION_DEFINITION:
+		if(s->function_definition.is_code_block_parsed)
+			err = err || el_walk_push_statement_list(w, &s->function_definition.code_block);
+		break;
+	case el_AST_NODE_FOR_STATEMENT:
+		err = err || el_walk_push_statement_list(w, &s->for_statement.code_block);
+		err = err || el_walk_push_expression(w, &s->for_statement.range);
+		break;
+	case el_AST_NODE_IF_STATEMENT:
+	{
+		struct el_ast_if_statement * if_statement = &s->if_statement;
+		if(if_statement->else_statement)
+			err = err || el_walk_push_statement_list(w, if_statement->else_statement);
+		for(int i = if_statement->num_elif_statements - 1; i >= 0 && err == 0; --i)
+		{
+			err = err || el_walk_push_statement_list(w, &if_statement->elif_statements[i].code_block);
+			err = err || el_walk_push_expression(w, &if_statement->elif_statements[i].expression);
+		}
+		err = err || el_walk_push_statement_list(w, &if_statement->code_block);
+		err = err || el_walk_push_expression(w, &if_statement->expression);
+		break;
+	}
+	case el_AST_NODE_ASSIGNMENT:
+		err = err || el_walk_push_expression(w, &s->assignment.rhs);
+		err = err || el_walk_push_expression(w, &s->assignment.lhs);
+		break;
+	case el_AST_NODE_RETURN_STATEMENT:
+		err = err || el_walk_push_expression(w, &s->return_statement.expression);
+		break;
+	case el_AST_NODE_EXPRESSION:
+		err = err || el_walk_push_expression(w, &s->expression);
+		break;
+	}
+	return err;
+}
+
+static int el_walk_expression(struct el_ast_walk * w, struct el_ast_expression * e)
+{
+	struct el_ast_visitor const * v = w->visitor;
+	if(v->enter_expression[e->type] && !v->enter_expression[e->type](e, v->context))
+		return el_SUCCESS;
+
+	int err = 0;
+	if(v->leave_expression[e->type])
+	{
+		err = err || el_walk_grow(w, 1);
+		if(err == 0)
+			w->stack[w->stack_size++] = (struct el_visit_item){ el_VISIT_LEAVE_EXPRESSION, e };
+	}
+
+	switch(e->type)
+	{
+	case el_AST_EXPR_NUMBER_LITERAL:
+	case el_AST_EXPR_STRING_LITERAL:
+	case el_AST_EXPR_IDENTIFIER:
+	case el_AST_EXPR_VECTOR_TYPE:
+		break;
+	case el_AST_EXPR_ARGUMENTS:
+	case el_AST_EXPR_SLICE_LITERAL:
+		err = err || el_walk_push_expression_list(w, e->expression_list);
+		break;
+	default:
+		err = err || el_walk_push_expression(w, e->binary_op.rhs);
+		err = err || el_walk_push_expression(w, e->binary_op.lhs);
+		break;
+	}
+	return err;
+}
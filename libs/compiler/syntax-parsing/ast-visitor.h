@@ -0,0 +1,37 @@
+#pragma once
+#include "ast.h"
+
+// Return false to skip the node's children and its leave callback
+typedef bool (*el_ast_enter_statement_fn)(struct el_ast_statement * statement, void * context);
+typedef bool (*el_ast_enter_expression_fn)(struct el_ast_expression * expression, void * context);
+
+typedef void (*el_ast_leave_statement_fn)(struct el_ast_statement * statement, void * context);
+typedef void (*el_ast_leave_expression_fn)(struct el_ast_expression * expression, void * context);
+
+// Callbacks indexed by node type, any of which may be NULL
+// Children are visited in source order:
+// for statements visit their range then body, if statements their condition, body, elifs (condition then body) and else body,
+// assignments their lhs then rhs, binary expressions their lhs then rhs and lists their expressions
+// Bodies of functions skipped by a lazy parse are not visited
+struct el_ast_visitor
+{
+	// Pre-order, called before the node's children are visited
+	el_ast_enter_statement_fn enter_statement[el_ast_statement_type_count];
+	el_ast_enter_expression_fn enter_expression[el_ast_expression_type_count];
+
+	// Post-order, called after the node's children are visited
+	el_ast_leave_statement_fn leave_statement[el_ast_statement_type_count];
+	el_ast_leave_expression_fn leave_expression[el_ast_expression_type_count];
+
+	void * context;
+};
+
+// Visit every node of the ast
+// The walk uses an explicit stack rather than recursion, s.t. deeply nested asts cannot overflow the call stack
+int el_ast_visit(struct el_ast * ast, struct el_ast_visitor const * visitor);
+
+// Visit every statement in the list and their decendant nodes
+int el_ast_visit_statements(struct el_ast_statement_list * list, struct el_ast_visitor const * visitor);
+
+// Visit the expression and its decendant nodes
+int el_ast_visit_expression(struct el_ast_expression * expression, struct el_ast_visitor const * visitor);
@@ -11,7 +11,9 @@ enum el_ast_statement_type
 	el_AST_NODE_IF_STATEMENT,
 	el_AST_NODE_ASSIGNMENT,
 	el_AST_NODE_RETURN_STATEMENT,
-	el_AST_NODE_EXPRESSION
+	el_AST_NODE_EXPRESSION,
+
+	el_ast_statement_type_count
 };
 
 enum el_ast_expression_type
@@ -42,6 +44,9 @@ enum el_ast_expression_type
 	el_AST_EXPR_ARGUMENTS,
 
 	el_AST_EXPR_IDENTIFIER,
+	el_AST_EXPR_VECTOR_TYPE, // The callee of a vector constructor, e.g. float4(x, y, z, w)
+
+	el_ast_expression_type_count
 };
 
 struct el_ast_statement_list
@@ -51,15 +56,23 @@ struct el_ast_statement_list
 	int num_statements;
 };
 
+// Index of a symbol in an el_symbol_table, before names are resolved or if a name has no declaration
+#define el_NO_SYMBOL -1
+
+// Id of a type in an el_type_table, before types are interned or if a type has no declaration
+#define el_NO_TYPE -1
+
 struct el_ast_var_type
 {
 	bool is_native;
+	int symbol; // Data block a custom type names, set by el_resolve_names
 	union
 	{
 		int native_type;
 		el_string custom_type;
 	};
 	int num_dimensions; // 0 for single, 1 for slice, 2 for 2-dimensional slice, etc.
+	int type_id; // Canonical type, set by el_intern_var_type
 };
 
 struct el_ast_var_decl
@@ -80,11 +93,23 @@ struct el_ast_expression_list
 struct el_ast_expression
 {
 	int type;
+	int symbol; // Declaration an identifier refers to, set by el_resolve_names, or for the rhs of a dot the index of its field, set by el_type_check
+	int type_id; // Set by el_type_check
 	union
 	{
-		el_string number_literal;
+		// Number literals also hold their value, by type_id, set by el_fold_constants
+		struct
+		{
+			el_string number_literal;
+			union
+			{
+				long long int_value;
+				double float_value;
+			};
+		};
 		el_string string_literal;
 		el_string identifier;
+		int native_type; // Token type of a vector type
 
 		struct el_ast_expression_list * expression_list;
 
@@ -102,6 +127,7 @@ struct el_ast_data_block
 	struct el_ast_var_decl * var_declarations;
 	int max_num_var_declarations;
 	int num_var_declarations;
+	bool is_soa; // Slices of the block store each field in an array of its own
 };
 
 struct el_ast_parameter_list
@@ -117,14 +143,44 @@ struct el_ast_function_definition
 	struct el_ast_parameter_list parameter_list;
 	struct el_ast_var_type return_type;
 	struct el_ast_statement_list code_block;
+
+	// False if the body was skipped by a lazy parse, see el_parse_function_body
+	bool is_code_block_parsed;
+	int code_block_start_token;
+	int code_block_end_token;
+};
+
+enum el_ast_reduction_type
+{
+	el_AST_REDUCE_SUM,
+	el_AST_REDUCE_MIN,
+	el_AST_REDUCE_MAX,
+
+	el_ast_reduction_type_count
+};
+
+// A variable the chunks of a parallel for each accumulate into privately, combined once every chunk has run
+struct el_ast_reduction
+{
+	int type;
+	el_string var_name;
+	int symbol; // Set by el_resolve_names
 };
 
 struct el_ast_for_statement
 {
 	el_string index_var_name;
 	el_string value_var_name;
+	int index_symbol; // Set by el_resolve_names
+	int value_symbol;
 	struct el_ast_expression range;
 	struct el_ast_statement_list code_block;
+
+	// Iterations of a parallel for may run in any order and at once, e.g. parallel(sum total) for i, x in xs
+	bool is_parallel;
+	struct el_ast_reduction * reductions;
+	int max_num_reductions;
+	int num_reductions;
 };
 
 struct el_ast_elif_statement
@@ -170,13 +226,34 @@ struct el_ast_statement
 	};
 };
 
+// Indices into the token stream
+struct el_ast_token_list
+{
+	int * tokens;
+	int max_num_tokens;
+	int num_tokens;
+};
+
 struct el_ast
 {
 	struct el_linear_allocator allocator;
 	struct el_ast_statement_list root;
-};
+	struct el_token_stream * token_stream; // Only set if function bodies are parsed lazily
+
+	// Arenas of the tasks which parsed part of the ast, only set if parsed in parallel
+	struct el_linear_allocator * task_allocators;
+	int num_task_allocators;
 
-void el_ast_print(struct el_ast * ast);
+	// Token index each root statement starts at, used by el_reparse_edits to find the statements an edit overlaps
+	struct el_ast_token_list root_start_tokens;
+
+	// Text of the literals constant subtrees were folded into, only set by el_fold_constants
+	struct el_linear_allocator folded_literal_allocator;
+
+	// Mapped image holding every node, only set if loaded by el_ast_cache_load
+	void * cache_image;
+	size_t cache_image_size;
+};
 
 // Delete the ast and its decendant nodes
 void el_ast_delete(struct el_ast * ast);
@@ -3,9 +3,14 @@
 #include <allocators/linear-allocator.h>
 #include <compiler/error.h>
 #include <compiler/lexing/token-stream.h>
+#include <compiler/lexing/lexer.h>
+#include <file-system/file-system.h>
 #include <containers/string.h>
+#include <containers/vector.h>
+#include <threads/thread-pool.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 
 #if 0
@@ -16,804 +21,1602 @@
 
 #define DEBUG_TOKEN_MATCHING 0
 
-#define ALLOCATOR_CAPACITY (10 * 1024 * 1024) // 10MiB
+// Arenas chain on blocks as the ast grows, the first block is sized from the tokens it will hold
+#define AST_BYTES_PER_TOKEN 64
+#define MIN_ARENA_BLOCK_SIZE (64 * 1024)
 
-#define MAX_NUM_NODES_PER_NODE_LIST 256
-#define MAX_NUM_EXPRS_PER_EXPR_LIST 128
-#define MAX_NUM_PARAMS_PER_PARAM_LIST 8
-#define MAX_NUM_ELIFS_PER_IF 8
-#define MAX_NUM_VARS_PER_DATA_BLOCK 16
+// Lists of nodes grow as needed, the root is only given room for a typical file up front
+#define INITIAL_NUM_ROOT_STATEMENTS 64
 
-static int el_parse_new_line(struct el_token_stream * token_stream);
-static int el_parse_new_lines(struct el_token_stream * token_stream);
-static int el_parse_statements(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list);
-static int el_parse_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list);
+// Expressions are parsed using an explicit stack so this bounds memory use rather than call stack depth
+#define MAX_EXPR_STACK_DEPTH 1024
+#define MAX_BLOCK_NESTING_DEPTH 256
 
-static int el_parse_function(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * parent);
-static int el_parse_parameter_list(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_parameter_list * parameter_list);
-static int el_parse_parameters(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_parameter_list * parameter_list);
-static int el_parse_parameter(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_var_decl * var_decl);
+// Parallel parsing splits the file into more tasks than threads s.t. uneven declarations balance out
+// Files too small to give each task this many tokens are parsed in serial
+#define NUM_PARSE_TASKS_PER_THREAD 4
+#define MIN_TOKENS_PER_PARSE_TASK 256
 
-static int el_parse_code_block(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list);
-static int el_parse_code_block_statements(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list);
-static int el_parse_code_block_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list);
-
-static int el_parse_for_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * parent);
-static int el_parse_if_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * parent);
-static int el_parse_elif_statements(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_if_statement * parent);
-static int el_parse_else_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_if_statement * parent);
-
-static int el_parse_assignment(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression);
-static int el_parse_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression);
-static int el_parse_function_call(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression_list * expression_list);
-static int el_parse_arguments(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression_list * expression_list);
-
-static int el_parse_data_block(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * parent);
-static int el_parse_data_block_statements(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_data_block * data_block);
-static int el_parse_data_block_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_data_block * data_block);
-
-static int el_parse_optional_type(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_var_type * var_type);
-static int el_parse_type(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_var_type * var_type);
-
-static int el_parse_complex_identifier(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression);
-static int el_parse_complex_identifier_inner(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression);
+enum el_expr_frame_type
+{
+	el_EXPR_FRAME_BINARY_OP,
+	el_EXPR_FRAME_PARENTHESIS,
+	el_EXPR_FRAME_SLICE_LITERAL,
+	el_EXPR_FRAME_ARGUMENTS,
+	el_EXPR_FRAME_SLICE_INDEX
+};
+
+// A pending binary operator or an unclosed bracket
+struct el_expr_frame
+{
+	int type;
+	int binding_power; // Binary ops only, the right binding power of the operator
+	int expr_type; // Binary ops only
+	struct el_ast_expression * expression; // Lists only, the list being built
+};
+
+// Heap-backed stacks used to parse expressions without recursion
+// Operands are nodes already allocated in the ast, s.t. binary ops can be built without copying
+struct el_expr_stack
+{
+	struct el_expr_frame * frames;
+	struct el_ast_expression ** operands;
+	int num_frames;
+	int num_operands;
+};
 
-static int el_parse_boolean_or_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression);
-static int el_parse_boolean_and_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression);
-static int el_parse_add_or_sub_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression);
-static int el_parse_mult_or_div_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression);
-static int el_parse_factor_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression);
+struct el_parser
+{
+	struct el_token_stream * token_stream;
+	struct el_linear_allocator * allocator;
+	struct el_expr_stack expr_stack;
+	int block_depth;
+	int end_token; // Top-level statements are parsed up to but excluding this token
+	struct el_ast_token_list * statement_starts; // If set, receives the token each top-level statement starts at
+	int lookahead; // Type of the current token, cached s.t. productions can dispatch without re-reading the stream
+	int flags; // enum el_parse_flags
+};
+
+// A range of top-level statements parsed by one task of el_parse_root_parallel
+struct el_parse_task
+{
+	int start_token;
+	int end_token;
+	struct el_ast_statement_list statements;
+	struct el_ast_token_list statement_starts;
+	int err;
+};
+
+struct el_parallel_parse
+{
+	struct el_token_stream * token_stream;
+	struct el_parse_task * tasks;
+	struct el_linear_allocator * task_allocators; // Indexed by task
+	int flags;
+};
 
-static int el_convert_to_binary_op(struct el_linear_allocator * allocator, struct el_ast_expression * expression, int type);
+struct el_binding_power
+{
+	unsigned char left;
+	unsigned char right;
+	unsigned char expr_type;
+};
+
+// Binding powers of binary operators, indexed by token type
+// Tokens which are not binary operators have a left binding power of 0
+// A right binding power greater than the left makes an operator left associative
+static struct el_binding_power const infix_binding_powers[el_token_type_count] = {
+	[el_EQUALS_COMPARATOR]			= { 1, 2, el_AST_EXPR_EQUALS },
+	[el_GREATER_THAN_COMPARATOR]	= { 1, 2, el_AST_EXPR_GREATER_THAN },
+	[el_LESS_THAN_COMPARATOR]		= { 1, 2, el_AST_EXPR_LESS_THAN },
+	[el_LEQUALS_COMPARATOR]			= { 1, 2, el_AST_EXPR_LEQUALS },
+	[el_GEQUALS_COMPARATOR]			= { 1, 2, el_AST_EXPR_GEQUALS },
+
+	[el_BOOLEAN_OR]					= { 3, 4, el_AST_EXPR_BOOLEAN_OR },
+	[el_BOOLEAN_AND]				= { 5, 6, el_AST_EXPR_BOOLEAN_AND },
+
+	[el_ADD_OPERATOR]				= { 7, 8, el_AST_EXPR_ADD },
+	[el_SUBTRACT_OPERATOR]			= { 7, 8, el_AST_EXPR_SUB },
+	[el_MULTIPLY_OPERATOR]			= { 9, 10, el_AST_EXPR_MUL },
+	[el_DIVIDE_OPERATOR]			= { 9, 10, el_AST_EXPR_DIV },
+};
+
+// FIRST and FOLLOW sets used to choose between productions with a single mask test
+#define FIRST_VECTOR_TYPE (el_TOKEN_BIT(el_INT2_TYPE) | el_TOKEN_BIT(el_INT4_TYPE) | el_TOKEN_BIT(el_INT8_TYPE) \
+	| el_TOKEN_BIT(el_FLOAT2_TYPE) | el_TOKEN_BIT(el_FLOAT4_TYPE) | el_TOKEN_BIT(el_FLOAT8_TYPE))
+#define FIRST_TYPE (el_TOKEN_BIT(el_IDENTIFIER) | el_TOKEN_BIT(el_INT_TYPE) | el_TOKEN_BIT(el_FLOAT_TYPE) | FIRST_VECTOR_TYPE)
+#define FIRST_POSTFIX (el_TOKEN_BIT(el_SLICE_START) | el_TOKEN_BIT(el_PARENTHESIS_OPEN) | el_TOKEN_BIT(el_DOT_OPERATOR))
+#define FOLLOW_GROUPED_EXPR (el_TOKEN_BIT(el_COMMA_SEPARATOR) | el_TOKEN_BIT(el_PARENTHESIS_CLOSE) | el_TOKEN_BIT(el_SLICE_END))
+
+static int el_parser_new(struct el_parser * parser, struct el_token_stream * token_stream, struct el_linear_allocator * allocator, int flags);
+static size_t el_arena_block_size(int num_tokens);
+static void el_parser_delete(struct el_parser * parser);
+
+static int el_parse_root(struct el_token_stream * token_stream, struct el_ast * ast, int flags);
+static int el_parse_root_parallel(struct el_token_stream * token_stream, struct el_ast * ast, int flags);
+static int el_partition_top_level_declarations(struct el_token_stream * token_stream, struct el_parse_task * tasks, int max_num_tasks);
+static void el_parse_task_main(void * context, int task_index, int thread_index);
+static int el_parse_statement_range(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, int flags, int start_token, int end_token, struct el_ast_statement_list * list, struct el_ast_token_list * statement_starts);
+
+static int el_apply_text_edits(el_string source, struct el_text_edit const * edits, int num_edits, el_string * edited);
+static bool el_is_range_balanced(struct el_token_stream * token_stream, int start_token, int end_token);
+static int el_count_statement_starts(int const * starts, int num_starts, int token);
+
+static int el_parse_new_line(struct el_parser * parser);
+static int el_parse_new_lines(struct el_parser * parser);
+static int el_parse_statements(struct el_parser * parser, struct el_ast_statement_list * list);
+static int el_parse_statement(struct el_parser * parser, struct el_ast_statement_list * list);
+
+static int el_parse_function(struct el_parser * parser, struct el_ast_statement_list * parent);
+static int el_parse_parameter_list(struct el_parser * parser, struct el_ast_parameter_list * parameter_list);
+static int el_parse_parameters(struct el_parser * parser, struct el_ast_parameter_list * parameter_list);
+static int el_parse_parameter(struct el_parser * parser, struct el_ast_var_decl * var_decl);
+
+static int el_parse_code_block(struct el_parser * parser, struct el_ast_statement_list * list);
+static int el_skip_code_block(struct el_parser * parser, struct el_ast_function_definition * function_definition);
+static int el_parse_code_block_statements(struct el_parser * parser, struct el_ast_statement_list * list);
+static int el_parse_code_block_statement(struct el_parser * parser, struct el_ast_statement_list * list);
+
+static int el_parse_for_statement(struct el_parser * parser, struct el_ast_statement_list * parent);
+static int el_parse_reductions(struct el_parser * parser, struct el_ast_for_statement * parent);
+static int el_parse_if_statement(struct el_parser * parser, struct el_ast_statement_list * parent);
+static int el_parse_elif_statements(struct el_parser * parser, struct el_ast_if_statement * parent);
+static int el_parse_else_statement(struct el_parser * parser, struct el_ast_if_statement * parent);
+
+static int el_parse_assignment(struct el_parser * parser, struct el_ast_expression * expression);
+static int el_parse_expr(struct el_parser * parser, struct el_ast_expression * expression);
+
+static int el_parse_data_block(struct el_parser * parser, struct el_ast_statement_list * parent);
+static int el_parse_data_block_statements(struct el_parser * parser, struct el_ast_data_block * data_block);
+static int el_parse_data_block_statement(struct el_parser * parser, struct el_ast_data_block * data_block);
+
+static int el_parse_optional_type(struct el_parser * parser, struct el_ast_var_type * var_type);
+static int el_parse_type(struct el_parser * parser, struct el_ast_var_type * var_type);
+
+static int el_parse_complex_identifier(struct el_parser * parser, struct el_ast_expression * expression);
+
+static int el_parse_expression(struct el_parser * parser, struct el_ast_expression * expression, bool complex_identifier_only);
+static int el_parse_expression_operand(struct el_parser * parser, bool * expect_operand, bool * allow_postfix);
+static int el_parse_expression_postfix(struct el_parser * parser);
+static int el_close_expression_group(struct el_parser * parser, bool append_operand, bool * allow_postfix);
+static int el_reduce_binary_ops(struct el_parser * parser, int binding_power);
+
+static int el_push_expr_frame(struct el_parser * parser, int type, int binding_power, int expr_type, struct el_ast_expression * expression);
+static int el_push_expr_operand(struct el_parser * parser, struct el_ast_expression * operand);
+static int el_new_binary_op(struct el_linear_allocator * allocator, int type, struct el_ast_expression * lhs, struct el_ast_expression * rhs, struct el_ast_expression ** result);
 static int el_new_expr_list(struct el_linear_allocator * allocator, struct el_ast_expression * expression, int type);
+static int el_append_expr_list(struct el_linear_allocator * allocator, struct el_ast_expression_list * list, struct el_ast_expression * expression);
 
-static int el_match_token(struct el_token_stream * token_stream, int type);
-static struct el_token * el_lookahead(struct el_token_stream * token_stream);
-static bool el_is_lookahead(struct el_token_stream * token_stream, int type);
-static el_string el_copy_lookahead(struct el_token_stream * token_stream, struct el_linear_allocator * allocator);
+static int el_match_token(struct el_parser * parser, int type);
+static inline bool el_is_lookahead(struct el_parser * parser, int type);
+static inline bool el_is_lookahead_in(struct el_parser * parser, el_token_set set);
+static el_string el_copy_lookahead(struct el_parser * parser);
 
-struct el_ast el_parse_token_stream(struct el_token_stream * token_stream)
+struct el_ast el_parse_token_stream(struct el_token_stream * token_stream, int flags)
 {
+	assert(token_stream->num_tokens > 0 && token_stream->tokens[token_stream->num_tokens - 1].type == el_END_OF_FILE);
 	struct el_ast ast = {
-		.allocator.memory = fmalloc(ALLOCATOR_CAPACITY),
-		.allocator.capacity = ALLOCATOR_CAPACITY,
-		.allocator.size = 0,
 		.root.statements = NULL,
-		.root.max_num_statements = MAX_NUM_NODES_PER_NODE_LIST,
-		.root.num_statements = 0
+		.root.max_num_statements = 0,
+		.root.num_statements = 0,
+		.token_stream = (flags & el_PARSE_LAZY_FUNCTION_BODIES) ? token_stream : NULL
 	};
-	ast.root.statements = el_linear_alloc(&ast.allocator, sizeof(struct el_ast_statement) * MAX_NUM_NODES_PER_NODE_LIST);
 
-	if(!ast.root.statements)
+	if(!el_linear_allocator_new(&ast.allocator, el_arena_block_size(token_stream->num_tokens))
+		|| !el_vector_reserve(&ast.root, statements, INITIAL_NUM_ROOT_STATEMENTS, &ast.allocator)
+		|| !el_vector_reserve(&ast.root_start_tokens, tokens, INITIAL_NUM_ROOT_STATEMENTS, NULL))
 	{
 		fprintf(stderr, "Failed to allocate root ast statements node\n");
+		el_ast_delete(&ast);
 		return ast;
 	}
 
-	if(el_parse_statements(token_stream, &ast.allocator, &ast.root) != 0)
+	int err = (flags & el_PARSE_PARALLEL) ? el_parse_root_parallel(token_stream, &ast, flags) : el_parse_root(token_stream, &ast, flags);
+	if(err != 0)
 	{
 		fprintf(stderr, "Failed to parse token stream\n");
 		el_ast_delete(&ast);
 	}
-	else
+	return ast;
+}
+
+int el_parse_function_body(struct el_ast * ast, struct el_ast_function_definition * function_definition)
+{
+	assert(ast && function_definition);
+	if(function_definition->is_code_block_parsed)
+		return el_SUCCESS;
+
+	// Bodies are only skipped when the ast holds onto the token stream
+	assert(ast->token_stream);
+	struct el_token_stream * token_stream = ast->token_stream;
+	int current_token = token_stream->current_token;
+	token_stream->current_token = function_definition->code_block_start_token;
+
+	struct el_parser parser;
+	int err = el_parser_new(&parser, token_stream, &ast->allocator, el_PARSE_DEFAULT);
+	err = err || el_parse_code_block(&parser, &function_definition->code_block);
+	el_parser_delete(&parser);
+
+	token_stream->current_token = current_token;
+	if(err != 0)
 	{
-		el_ast_print(&ast);
+		fprintf(stderr, "Failed to parse body of function %s\n", function_definition->name);
+		return err;
 	}
 
-	return ast;
+	function_definition->is_code_block_parsed = true;
+	return el_SUCCESS;
+}
+
+int el_reparse_edits(struct el_ast * ast, struct el_token_stream * token_stream, struct el_text_file * f, struct el_text_edit const * edits, int num_edits)
+{
+	assert(ast && token_stream && f && f->contents && (edits || num_edits == 0));
+	assert(!ast->token_stream || ast->token_stream == token_stream);
+	if(num_edits == 0)
+		return el_SUCCESS;
+
+	// Asts loaded from a cache have no allocator to add nodes to
+	if(!ast->allocator.memory)
+	{
+		fprintf(stderr, "Failed to re-parse edits, ast has no allocator\n");
+		return el_STALE_AST_PARSE_ERROR;
+	}
+
+	// Statement starts are cleared when a previous re-parse failed
+	struct el_ast_statement_list * root = &ast->root;
+	if(!ast->root_start_tokens.tokens)
+	{
+		fprintf(stderr, "Failed to re-parse edits, ast does not match token stream\n");
+		return el_STALE_AST_PARSE_ERROR;
+	}
+
+	el_string edited = NULL;
+	int err = el_apply_text_edits(f->contents, edits, num_edits, &edited);
+	if(err != 0)
+		return err;
+
+	// The changed bytes run from the first edit to the end of the last edit's replacement text
+	struct el_text_edit const * last_edit = &edits[num_edits - 1];
+	int edit_start = edits[0].offset;
+	int edit_end = last_edit->offset + last_edit->num_removed_bytes + el_string_length(edited) - el_string_length(f->contents);
+
+	struct el_relexed_range relexed;
+	err = el_relex_edit(token_stream, edited, edit_start, edit_end, &relexed);
+	if(err != 0)
+	{
+		el_string_delete(edited);
+		return err;
+	}
+	el_string_delete(f->contents);
+	f->contents = edited;
+
+	// The statements overlapping the replaced tokens are re-parsed, statement i spans the tokens up to start i + 1
+	int * starts = ast->root_start_tokens.tokens;
+	int num_statements = root->num_statements;
+	int token_delta = relexed.num_added_tokens - relexed.num_removed_tokens;
+	int last_changed_token = relexed.first_token + (relexed.num_removed_tokens > 0 ? relexed.num_removed_tokens - 1 : 0);
+	int first_statement = el_count_statement_starts(starts, num_statements, relexed.first_token) - 1;
+	int end_statement = el_count_statement_starts(starts, num_statements, last_changed_token);
+	if(end_statement < first_statement + 1)
+	{
+		end_statement = first_statement + 1;
+	}
+
+	// Tokens before the first statement only hold blank lines, so they join the first statement's range
+	int start_token = first_statement < 0 ? 0 : starts[first_statement];
+	first_statement = first_statement < 0 ? 0 : first_statement;
+	int eof_token = token_stream->num_tokens - 1;
+	int end_token = end_statement < num_statements ? starts[end_statement] + token_delta : eof_token;
+
+	// An edit which opens or closes a code block can change every statement after it
+	if(!el_is_range_balanced(token_stream, start_token, end_token))
+	{
+		end_statement = num_statements;
+		end_token = eof_token;
+	}
+
+	// The new statements are parsed into the ast's arena, only their starts need freeing
+	struct el_ast_statement_list list = { 0 };
+	struct el_ast_token_list new_starts = { 0 };
+	int flags = ast->token_stream ? el_PARSE_LAZY_FUNCTION_BODIES : el_PARSE_DEFAULT;
+	err = el_parse_statement_range(token_stream, &ast->allocator, flags, start_token, end_token, &list, &new_starts);
+	if(err == el_STATEMENT_PAST_RANGE_PARSE_ERROR)
+	{
+		// The edit joined the last statement with the one after it, so everything after the edit is re-parsed
+		end_statement = num_statements;
+		end_token = eof_token;
+		list.num_statements = 0;
+		new_starts.num_tokens = 0;
+		err = el_parse_statement_range(token_stream, &ast->allocator, flags, start_token, end_token, &list, &new_starts);
+	}
+
+	int num_old_statements = end_statement - first_statement;
+	int num_new_statements = num_statements - num_old_statements + list.num_statements;
+	if(err == 0 && (!el_vector_reserve(root, statements, num_new_statements, &ast->allocator)
+		|| !el_vector_reserve(&ast->root_start_tokens, tokens, num_new_statements, NULL)))
+	{
+		fprintf(stderr, "Failed to grow root statements\n");
+		err = el_ALLOCATION_ERROR;
+	}
+	if(err != 0)
+		goto failed;
+
+	// Splice the new statements in place of the old ones, later statements are reused as they are
+	starts = ast->root_start_tokens.tokens;
+	int num_tail_statements = num_statements - end_statement;
+	int tail_statement = first_statement + list.num_statements;
+	memmove(&root->statements[tail_statement], &root->statements[end_statement], sizeof(struct el_ast_statement) * num_tail_statements);
+	memmove(&starts[tail_statement], &starts[end_statement], sizeof(int) * num_tail_statements);
+	memcpy(&root->statements[first_statement], list.statements, sizeof(struct el_ast_statement) * list.num_statements);
+	memcpy(&starts[first_statement], new_starts.tokens, sizeof(int) * list.num_statements);
+	root->num_statements = tail_statement + num_tail_statements;
+	ast->root_start_tokens.num_tokens = root->num_statements;
+
+	for(int i = tail_statement; i < root->num_statements; i++)
+	{
+		starts[i] += token_delta;
+
+		// Token ranges of skipped function bodies move with the tokens
+		struct el_ast_statement * s = &root->statements[i];
+		if(s->type == el_AST_NODE_FUNCTION_DEFINITION && !s->function_definition.is_code_block_parsed)
+		{
+			s->function_definition.code_block_start_token += token_delta;
+			s->function_definition.code_block_end_token += token_delta;
+		}
+	}
+
+	el_vector_free(&new_starts, tokens, NULL);
+	return el_SUCCESS;
+
+failed:
+	// The source and tokens hold the edit but the ast no longer matches them
+	el_vector_free(&new_starts, tokens, NULL);
+	el_vector_free(&ast->root_start_tokens, tokens, NULL);
+	return err;
+}
+
+static int el_apply_text_edits(el_string source, struct el_text_edit const * edits, int num_edits, el_string * edited)
+{
+	int source_length = el_string_length(source);
+	int length = source_length;
+	for(int i = 0; i < num_edits; i++)
+	{
+		assert(edits[i].offset >= 0 && edits[i].num_removed_bytes >= 0 && edits[i].offset + edits[i].num_removed_bytes <= source_length);
+		assert(i == 0 || edits[i].offset >= edits[i - 1].offset + edits[i - 1].num_removed_bytes);
+		length += edits[i].text_length - edits[i].num_removed_bytes;
+	}
+
+	*edited = el_string_new(NULL, length);
+	if(!*edited)
+	{
+		fprintf(stderr, "Failed to allocate edited source\n");
+		return el_ALLOCATION_ERROR;
+	}
+
+	char * dst = *edited;
+	int copied = 0;
+	for(int i = 0; i < num_edits; i++)
+	{
+		memcpy(dst, source + copied, edits[i].offset - copied);
+		dst += edits[i].offset - copied;
+		memcpy(dst, edits[i].text, edits[i].text_length);
+		dst += edits[i].text_length;
+		copied = edits[i].offset + edits[i].num_removed_bytes;
+	}
+	memcpy(dst, source + copied, source_length - copied);
+	return el_SUCCESS;
+}
+
+static int el_parser_new(struct el_parser * parser, struct el_token_stream * token_stream, struct el_linear_allocator * allocator, int flags)
+{
+	struct el_parser p = {
+		.token_stream = token_stream,
+		.allocator = allocator,
+		.expr_stack.frames = fmalloc(sizeof(struct el_expr_frame) * MAX_EXPR_STACK_DEPTH),
+		.expr_stack.operands = fmalloc(sizeof(struct el_ast_expression *) * MAX_EXPR_STACK_DEPTH),
+		.expr_stack.num_frames = 0,
+		.expr_stack.num_operands = 0,
+		.block_depth = 0,
+		.end_token = token_stream->num_tokens,
+		.statement_starts = NULL,
+		.lookahead = token_stream->tokens[token_stream->current_token].type,
+		.flags = flags
+	};
+	*parser = p;
+
+	if(!parser->expr_stack.frames || !parser->expr_stack.operands)
+	{
+		fprintf(stderr, "Failed to allocate expression stack\n");
+		return el_ALLOCATION_ERROR;
+	}
+	return el_SUCCESS;
+}
+
+static size_t el_arena_block_size(int num_tokens)
+{
+	size_t block_size = (size_t)num_tokens * AST_BYTES_PER_TOKEN;
+	return block_size > MIN_ARENA_BLOCK_SIZE ? block_size : MIN_ARENA_BLOCK_SIZE;
+}
+
+static void el_parser_delete(struct el_parser * parser)
+{
+	ffree(parser->expr_stack.frames);
+	ffree(parser->expr_stack.operands);
+	parser->expr_stack.frames = NULL;
+	parser->expr_stack.operands = NULL;
+}
+
+static int el_parse_root(struct el_token_stream * token_stream, struct el_ast * ast, int flags)
+{
+	struct el_parser parser;
+	int err = el_parser_new(&parser, token_stream, &ast->allocator, flags);
+	parser.statement_starts = &ast->root_start_tokens;
+	err = err || el_parse_statements(&parser, &ast->root);
+	el_parser_delete(&parser);
+	return err;
+}
+
+// Top-level declarations are independent, so the file is split at fnc and dat declarations and the
+// ranges are parsed concurrently, each task into its own arena, then spliced into the root in order
+static int el_parse_root_parallel(struct el_token_stream * token_stream, struct el_ast * ast, int flags)
+{
+	struct el_thread_pool pool;
+	if(!el_thread_pool_new(&pool, 0) || pool.num_threads == 0)
+	{
+		el_thread_pool_delete(&pool);
+		return el_parse_root(token_stream, ast, flags & ~el_PARSE_PARALLEL);
+	}
+
+	int max_num_tasks = NUM_PARSE_TASKS_PER_THREAD * (pool.num_threads + 1);
+	if(max_num_tasks > token_stream->num_tokens / MIN_TOKENS_PER_PARSE_TASK)
+		max_num_tasks = token_stream->num_tokens / MIN_TOKENS_PER_PARSE_TASK;
+
+	struct el_parse_task * tasks = max_num_tasks >= 2 ? fmalloc(sizeof(struct el_parse_task) * max_num_tasks) : NULL;
+	int num_tasks = tasks ? el_partition_top_level_declarations(token_stream, tasks, max_num_tasks) : 1;
+	if(num_tasks < 2)
+	{
+		ffree(tasks);
+		el_thread_pool_delete(&pool);
+		return el_parse_root(token_stream, ast, flags & ~el_PARSE_PARALLEL);
+	}
+
+	// Arenas are owned by the ast from here on, s.t. el_ast_delete frees them on failure
+	int err = el_SUCCESS;
+	for(int i = 0; i < num_tasks; i++)
+	{
+		tasks[i].statements = (struct el_ast_statement_list){ 0 };
+		tasks[i].statement_starts = (struct el_ast_token_list){ 0 };
+		tasks[i].err = el_SUCCESS;
+	}
+
+	ast->task_allocators = fmalloc(sizeof(struct el_linear_allocator) * num_tasks);
+	if(!ast->task_allocators)
+	{
+		fprintf(stderr, "Failed to allocate parallel parse tasks\n");
+		err = el_ALLOCATION_ERROR;
+		goto cleanup;
+	}
+
+	// Each task gets its own arena sized from its token range, s.t. tasks never share an arena whichever thread runs them
+	for(int i = 0; i < num_tasks; i++)
+	{
+		struct el_linear_allocator * allocator = &ast->task_allocators[ast->num_task_allocators];
+		if(!el_linear_allocator_new(allocator, el_arena_block_size(tasks[i].end_token - tasks[i].start_token)))
+		{
+			fprintf(stderr, "Failed to allocate parse task arena\n");
+			err = el_ALLOCATION_ERROR;
+			goto cleanup;
+		}
+		ast->num_task_allocators++;
+	}
+
+	struct el_parallel_parse parse = {
+		.token_stream = token_stream,
+		.tasks = tasks,
+		.task_allocators = ast->task_allocators,
+		.flags = flags
+	};
+	el_thread_pool_for(&pool, num_tasks, el_parse_task_main, &parse);
+
+	int num_statements = 0;
+	for(int i = 0; i < num_tasks && err == 0; i++)
+	{
+		err = tasks[i].err;
+		num_statements += tasks[i].statements.num_statements;
+	}
+	if(err == 0 && (!el_vector_reserve(&ast->root, statements, num_statements, &ast->allocator)
+		|| !el_vector_reserve(&ast->root_start_tokens, tokens, num_statements, NULL)))
+	{
+		fprintf(stderr, "Failed to grow root statements\n");
+		err = el_ALLOCATION_ERROR;
+	}
+
+	// Splice in source order, statements are copied by value but their children stay in the worker arenas
+	for(int i = 0; i < num_tasks && err == 0; i++)
+	{
+		struct el_ast_statement_list * list = &tasks[i].statements;
+		memcpy(&ast->root.statements[ast->root.num_statements], list->statements, sizeof(struct el_ast_statement) * list->num_statements);
+		memcpy(&ast->root_start_tokens.tokens[ast->root.num_statements], tasks[i].statement_starts.tokens, sizeof(int) * list->num_statements);
+		ast->root.num_statements += list->num_statements;
+		ast->root_start_tokens.num_tokens = ast->root.num_statements;
+	}
+
+cleanup:
+	for(int i = 0; i < num_tasks; i++)
+	{
+		el_vector_free(&tasks[i].statement_starts, tokens, NULL);
+	}
+	ffree(tasks);
+	el_thread_pool_delete(&pool);
+	return err;
+}
+
+// Split the token stream into at most max_num_tasks ranges of roughly equal length
+// Ranges start at fnc or dat keywords which begin a line outside of any code block
+static int el_partition_top_level_declarations(struct el_token_stream * token_stream, struct el_parse_task * tasks, int max_num_tasks)
+{
+	struct el_token * tokens = token_stream->tokens;
+	int end_of_file = token_stream->num_tokens - 1;
+	int min_tokens_per_task = end_of_file / max_num_tasks;
+	int num_tasks = 1;
+	int depth = 0;
+
+	tasks[0].start_token = 0;
+	for(int i = 1; i < end_of_file && num_tasks < max_num_tasks; i++)
+	{
+		int type = tokens[i].type;
+		if(type == el_BLOCK_START)
+		{
+			depth++;
+		}
+		else if(type == el_BLOCK_END)
+		{
+			depth--;
+		}
+		else if(depth == 0 && (type == el_FNC_KEYWORD || type == el_DAT_KEYWORD) && tokens[i - 1].type == el_END_LINE
+			&& i - tasks[num_tasks - 1].start_token >= min_tokens_per_task)
+		{
+			tasks[num_tasks - 1].end_token = i;
+			tasks[num_tasks++].start_token = i;
+		}
+	}
+	tasks[num_tasks - 1].end_token = end_of_file;
+	return num_tasks;
+}
+
+static void el_parse_task_main(void * context, int task_index, int thread_index)
+{
+	struct el_parallel_parse * parse = context;
+	struct el_parse_task * task = &parse->tasks[task_index];
+	struct el_linear_allocator * allocator = &parse->task_allocators[task_index];
+	task->err = el_parse_statement_range(parse->token_stream, allocator, parse->flags, task->start_token, task->end_token, &task->statements, &task->statement_starts);
+	if(task->err == el_STATEMENT_PAST_RANGE_PARSE_ERROR)
+	{
+		fprintf(stderr, "Statement continues past the top-level declaration at token %d\n", task->end_token);
+	}
+}
+
+// Parse the top-level statements between start_token and end_token into list, recording the token each starts at
+static int el_parse_statement_range(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, int flags, int start_token, int end_token, struct el_ast_statement_list * list, struct el_ast_token_list * statement_starts)
+{
+	// Ranges share the tokens but each reads them through its own cursor
+	struct el_token_stream range_stream = *token_stream;
+	range_stream.current_token = start_token;
+
+	struct el_parser parser;
+	int err = el_parser_new(&parser, &range_stream, allocator, flags);
+	parser.end_token = end_token;
+	parser.statement_starts = statement_starts;
+	err = err || el_parse_statements(&parser, list);
+	if(err == 0 && range_stream.current_token != end_token)
+	{
+		err = el_STATEMENT_PAST_RANGE_PARSE_ERROR;
+	}
+	el_parser_delete(&parser);
+	return err;
+}
+
+// True if every code block opened in [start_token, end_token) is also closed within it
+static bool el_is_range_balanced(struct el_token_stream * token_stream, int start_token, int end_token)
+{
+	int depth = 0;
+	for(int i = start_token; i < end_token && depth >= 0; i++)
+	{
+		if(token_stream->tokens[i].type == el_BLOCK_START)
+		{
+			depth++;
+		}
+		else if(token_stream->tokens[i].type == el_BLOCK_END)
+		{
+			depth--;
+		}
+	}
+	return depth == 0;
+}
+
+// Returns the number of sorted statement starts at or before token
+static int el_count_statement_starts(int const * starts, int num_starts, int token)
+{
+	int lo = 0;
+	int hi = num_starts;
+	while(lo < hi)
+	{
+		int mid = lo + (hi - lo) / 2;
+		if(starts[mid] <= token)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
 }
 
 // NOTE - In the production functions below the pattern err = err || ... is used
 // Do NOT change to err |= as short circuiting is desired
 
-static int el_parse_new_line(struct el_token_stream * token_stream)
+// NOTE - Sequences (statements, parameters, elifs, etc.) are parsed with loops rather than by
+// recursing once per element, s.t. stack depth does not grow with the length of the file
+
+static int el_parse_new_line(struct el_parser * parser)
 {
 	DEBUG_PRODUCTION("el_parse_new_line");
-	return el_match_token(token_stream, el_END_LINE);
+	return el_match_token(parser, el_END_LINE);
 }
 
-static int el_parse_new_lines(struct el_token_stream * token_stream)
+static int el_parse_new_lines(struct el_parser * parser)
 {
 	DEBUG_PRODUCTION("el_parse_new_lines");
 	int err = 0;
-	while(el_is_lookahead(token_stream, el_END_LINE))
+	while(el_is_lookahead(parser, el_END_LINE))
 	{
-		err = err || el_parse_new_line(token_stream);
+		err = err || el_parse_new_line(parser);
 	}
 	return err;
 }
 
-static int el_parse_statements(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list)
+static int el_parse_statements(struct el_parser * parser, struct el_ast_statement_list * list)
 {
 	DEBUG_PRODUCTION("el_parse_statements");
 	int err = 0;
-	if(token_stream->current_token < token_stream->num_tokens)
+	while(err == 0)
 	{
-		// Parse a single statement
-		err = err || el_parse_new_lines(token_stream);
-		err = err || el_parse_statement(token_stream, allocator, list);
-		err = err || el_parse_new_lines(token_stream);
+		err = err || el_parse_new_lines(parser);
+		if(el_is_lookahead(parser, el_END_OF_FILE) || parser->token_stream->current_token >= parser->end_token)
+			break;
+
+		if(parser->statement_starts)
+		{
+			int * start = el_vector_push(parser->statement_starts, tokens, NULL);
+			if(!start)
+				return el_ALLOCATION_ERROR;
+			*start = parser->token_stream->current_token;
+		}
 
-		// Parse additional statements by recursing into this fn
-		err = err || el_parse_statements(token_stream, allocator, list);
+		// Parse a single statement
+		err = err || el_parse_statement(parser, list);
 	}
 	return err;
 }
 
-static int el_parse_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list)
+static int el_parse_statement(struct el_parser * parser, struct el_ast_statement_list * list)
 {
 	DEBUG_PRODUCTION("el_parse_statement");
-	int err = 0;
-	if(el_is_lookahead(token_stream, el_FNC_KEYWORD))
-	{
-		err = err || el_parse_function(token_stream, allocator, list);
-	}
-	else if(el_is_lookahead(token_stream, el_DAT_KEYWORD))
-	{
-		err = err || el_parse_data_block(token_stream, allocator, list);
-	}
-	else
+	switch(parser->lookahead)
 	{
+	case el_FNC_KEYWORD:
+		return el_parse_function(parser, list);
+	case el_DAT_KEYWORD:
+		return el_parse_data_block(parser, list);
+	default:
 		// Statements which are valid within code blocks are also valid at file scope
-		err = err || el_parse_code_block_statement(token_stream, allocator, list);
+		return el_parse_code_block_statement(parser, list);
 	}
-	return err;
 }
 
-static int el_parse_function(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * parent)
+static int el_parse_function(struct el_parser * parser, struct el_ast_statement_list * parent)
 {
 	DEBUG_PRODUCTION("el_parse_function");
 	int err = 0;
-	assert(parent->num_statements < parent->max_num_statements);
-	parent->statements[parent->num_statements].type = el_AST_NODE_FUNCTION_DEFINITION;
-	struct el_ast_function_definition * function_definition = &parent->statements[parent->num_statements++].function_definition;
+	struct el_ast_statement * statement = el_vector_push(parent, statements, parser->allocator);
+	if(!statement)
+		return el_ALLOCATION_ERROR;
+	statement->type = el_AST_NODE_FUNCTION_DEFINITION;
+	struct el_ast_function_definition * function_definition = &statement->function_definition;
 
-	err = err || el_match_token(token_stream, el_FNC_KEYWORD);
-	function_definition->name = el_copy_lookahead(token_stream, allocator);
+	err = err || el_match_token(parser, el_FNC_KEYWORD);
+	function_definition->name = el_copy_lookahead(parser);
 	if(!function_definition->name)
 		return el_ALLOCATION_ERROR;
 
-	err = err || el_match_token(token_stream, el_IDENTIFIER);
-	err = err || el_parse_parameter_list(token_stream, allocator, &function_definition->parameter_list);
-	err = err || el_parse_optional_type(token_stream, allocator, &function_definition->return_type);
-	err = err || el_parse_code_block(token_stream, allocator, &function_definition->code_block);
+	err = err || el_match_token(parser, el_IDENTIFIER);
+	err = err || el_parse_parameter_list(parser, &function_definition->parameter_list);
+	err = err || el_parse_optional_type(parser, &function_definition->return_type);
+	if(parser->flags & el_PARSE_LAZY_FUNCTION_BODIES)
+	{
+		err = err || el_skip_code_block(parser, function_definition);
+	}
+	else
+	{
+		err = err || el_parse_code_block(parser, &function_definition->code_block);
+		function_definition->is_code_block_parsed = true;
+	}
 	return err;
 }
 
-static int el_parse_parameter_list(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_parameter_list * parameter_list)
+static int el_parse_parameter_list(struct el_parser * parser, struct el_ast_parameter_list * parameter_list)
 {
 	DEBUG_PRODUCTION("el_parse_parameter_list");
 	int err = 0;
-	parameter_list->parameters = el_linear_alloc(allocator, sizeof(struct el_ast_var_decl) * MAX_NUM_PARAMS_PER_PARAM_LIST);
-	if(!parameter_list->parameters)
-		return el_ALLOCATION_ERROR;
-	parameter_list->max_num_parameters = MAX_NUM_PARAMS_PER_PARAM_LIST;
+	parameter_list->parameters = NULL;
+	parameter_list->max_num_parameters = 0;
 	parameter_list->num_parameters = 0;
-	err = err || el_match_token(token_stream, el_PARENTHESIS_OPEN);
-	err = err || el_parse_parameters(token_stream, allocator, parameter_list);
-	err = err || el_match_token(token_stream, el_PARENTHESIS_CLOSE);
+	err = err || el_match_token(parser, el_PARENTHESIS_OPEN);
+	err = err || el_parse_parameters(parser, parameter_list);
+	err = err || el_match_token(parser, el_PARENTHESIS_CLOSE);
 	return err;
 }
 
-static int el_parse_parameters(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_parameter_list * parameter_list)
+static int el_parse_parameters(struct el_parser * parser, struct el_ast_parameter_list * parameter_list)
 {
 	DEBUG_PRODUCTION("el_parse_parameters");
 	int err = 0;
-	if(el_is_lookahead(token_stream, el_PARENTHESIS_CLOSE))
-		return err;
-
-	assert(parameter_list->num_parameters < parameter_list->max_num_parameters);
-	err = err || el_parse_parameter(token_stream, allocator, &parameter_list->parameters[parameter_list->num_parameters++]);
-	if(el_is_lookahead(token_stream, el_COMMA_SEPARATOR))
+	while(err == 0 && !el_is_lookahead(parser, el_PARENTHESIS_CLOSE))
 	{
+		struct el_ast_var_decl * parameter = el_vector_push(parameter_list, parameters, parser->allocator);
+		if(!parameter)
+			return el_ALLOCATION_ERROR;
+		err = err || el_parse_parameter(parser, parameter);
+		if(!el_is_lookahead(parser, el_COMMA_SEPARATOR))
+			break;
+
 		// NOTE - This allows a trailing comma before the closing bracket
-		err = err || el_match_token(token_stream, el_COMMA_SEPARATOR);
-		err = err || el_parse_parameters(token_stream, allocator, parameter_list);
+		err = err || el_match_token(parser, el_COMMA_SEPARATOR);
 	}
 	return err;
 }
 
-static int el_parse_parameter(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_var_decl * var_decl)
+static int el_parse_parameter(struct el_parser * parser, struct el_ast_var_decl * var_decl)
 {
 	DEBUG_PRODUCTION("el_parse_parameter");
 	int err = 0;
-	var_decl->name = el_copy_lookahead(token_stream, allocator);
+	var_decl->name = el_copy_lookahead(parser);
 	if(!var_decl->name)
 		return el_ALLOCATION_ERROR;
-	err = err || el_match_token(token_stream, el_IDENTIFIER);
-	err = err || el_parse_optional_type(token_stream, allocator, &var_decl->type);
+	err = err || el_match_token(parser, el_IDENTIFIER);
+	err = err || el_parse_optional_type(parser, &var_decl->type);
 	return err;
 }
 
-static int el_parse_code_block(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list)
+static int el_parse_code_block(struct el_parser * parser, struct el_ast_statement_list * list)
 {
 	DEBUG_PRODUCTION("el_parse_code_block");
 	int err = 0;
+	list->statements = NULL;
+	list->max_num_statements = 0;
 	list->num_statements = 0;
-	list->max_num_statements = MAX_NUM_NODES_PER_NODE_LIST;
-	list->statements = el_linear_alloc(allocator, sizeof(struct el_ast_statement) * list->max_num_statements);
-	if(!list->statements)
-		return el_ALLOCATION_ERROR;
 
-	err = err || el_match_token(token_stream, el_BLOCK_START);
-	err = err || el_parse_code_block_statements(token_stream, allocator, list);
-	err = err || el_match_token(token_stream, el_BLOCK_END);
-	err = err || el_parse_new_line(token_stream);
+	// Nested blocks still recurse, so bound how deep they can go
+	if(parser->block_depth >= MAX_BLOCK_NESTING_DEPTH)
+	{
+		fprintf(stderr, "Failed to parse code block, exceeded max nesting depth of %d\n", MAX_BLOCK_NESTING_DEPTH);
+		return el_EXCEEDED_BLOCK_NESTING_LIMIT_PARSE_ERROR;
+	}
+
+	++parser->block_depth;
+	err = err || el_match_token(parser, el_BLOCK_START);
+	err = err || el_parse_code_block_statements(parser, list);
+	err = err || el_match_token(parser, el_BLOCK_END);
+	err = err || el_parse_new_line(parser);
+	--parser->block_depth;
 	return err;
 }
 
-static int el_parse_code_block_statements(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list)
+// Record the token range of a function body without parsing it, by matching braces
+// The body is parsed on first access by el_parse_function_body
+static int el_skip_code_block(struct el_parser * parser, struct el_ast_function_definition * function_definition)
+{
+	DEBUG_PRODUCTION("el_skip_code_block");
+	struct el_token_stream * token_stream = parser->token_stream;
+	function_definition->is_code_block_parsed = false;
+	function_definition->code_block.statements = NULL;
+	function_definition->code_block.max_num_statements = 0;
+	function_definition->code_block.num_statements = 0;
+	function_definition->code_block_start_token = token_stream->current_token;
+
+	int err = el_match_token(parser, el_BLOCK_START);
+	if(err != 0)
+		return err;
+
+	// The end of file token stops the scan if the braces are unbalanced
+	struct el_token * tokens = token_stream->tokens;
+	int depth = 1;
+	int i = token_stream->current_token;
+	for(; tokens[i].type != el_END_OF_FILE; ++i)
+	{
+		if(tokens[i].type == el_BLOCK_START)
+		{
+			++depth;
+		}
+		else if(tokens[i].type == el_BLOCK_END && --depth == 0)
+		{
+			break;
+		}
+	}
+
+	token_stream->current_token = i;
+	parser->lookahead = tokens[i].type;
+	err = err || el_match_token(parser, el_BLOCK_END);
+	err = err || el_parse_new_line(parser);
+	function_definition->code_block_end_token = token_stream->current_token;
+	return err;
+}
+
+static int el_parse_code_block_statements(struct el_parser * parser, struct el_ast_statement_list * list)
 {
 	DEBUG_PRODUCTION("el_parse_code_block_statements");
 	int err = 0;
-	err = err || el_parse_new_lines(token_stream);
-	if(el_is_lookahead(token_stream, el_BLOCK_END))
+	while(err == 0)
 	{
-		return err;
+		err = err || el_parse_new_lines(parser);
+		if(el_is_lookahead(parser, el_BLOCK_END))
+			break;
+
+		// Parse a single statement
+		err = err || el_parse_code_block_statement(parser, list);
 	}
-	// Parse a single statement
-	err = err || el_parse_code_block_statement(token_stream, allocator, list);
-	// Parse additional statements by recursing into this fn
-	err = err || el_parse_code_block_statements(token_stream, allocator, list);
 	return err;
 }
 
-static int el_parse_code_block_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * list)
+static int el_parse_code_block_statement(struct el_parser * parser, struct el_ast_statement_list * list)
 {
 	DEBUG_PRODUCTION("el_parse_code_block_statement");
 	int err = 0;
-	assert(list->num_statements < list->max_num_statements);
-	if(el_is_lookahead(token_stream, el_FOR_KEYWORD))
-	{
-		err = err || el_parse_for_statement(token_stream, allocator, list);
-	}
-	else if(el_is_lookahead(token_stream, el_IF_KEYWORD))
+	struct el_ast_statement * statement;
+	switch(parser->lookahead)
 	{
-		err = err || el_parse_if_statement(token_stream, allocator, list);
-	}
-	else if(el_is_lookahead(token_stream, el_RET_KEYWORD))
-	{
-		int statement_index = list->num_statements++;
-		err = err || el_match_token(token_stream, el_RET_KEYWORD);
-		list->statements[statement_index].type = el_AST_NODE_RETURN_STATEMENT;
-		err = err || el_parse_expr(token_stream, allocator, &list->statements[statement_index].return_statement.expression);
-	}
-	else
-	{
-		int statement_index = list->num_statements++;
-		list->statements[statement_index].type = el_AST_NODE_EXPRESSION;
-		err = err || el_parse_complex_identifier(token_stream, allocator, &list->statements[statement_index].expression);
-		if(el_is_lookahead(token_stream, el_ASSIGN_OPERATOR))
+	case el_FOR_KEYWORD:
+	case el_PARALLEL_KEYWORD:
+		err = err || el_parse_for_statement(parser, list);
+		break;
+	case el_IF_KEYWORD:
+		err = err || el_parse_if_statement(parser, list);
+		break;
+	case el_RET_KEYWORD:
+		statement = el_vector_push(list, statements, parser->allocator);
+		if(!statement)
+			return el_ALLOCATION_ERROR;
+		err = err || el_match_token(parser, el_RET_KEYWORD);
+		statement->type = el_AST_NODE_RETURN_STATEMENT;
+		err = err || el_parse_expr(parser, &statement->return_statement.expression);
+		break;
+	default:
+		statement = el_vector_push(list, statements, parser->allocator);
+		if(!statement)
+			return el_ALLOCATION_ERROR;
+		statement->type = el_AST_NODE_EXPRESSION;
+		err = err || el_parse_complex_identifier(parser, &statement->expression);
+		if(el_is_lookahead(parser, el_ASSIGN_OPERATOR))
 		{
 			// Move the identifier node into the lhs of an assignment node
-			list->statements[statement_index].assignment.lhs = list->statements[statement_index].expression;
-			list->statements[statement_index].type = el_AST_NODE_ASSIGNMENT;
-			err = err || el_parse_assignment(token_stream, allocator, &list->statements[statement_index].assignment.rhs);
+			statement->assignment.lhs = statement->expression;
+			statement->type = el_AST_NODE_ASSIGNMENT;
+			err = err || el_parse_assignment(parser, &statement->assignment.rhs);
 		}
+		break;
 	}
 	return err;
 }
 
-static int el_parse_for_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * parent)
+static int el_parse_for_statement(struct el_parser * parser, struct el_ast_statement_list * parent)
 {
 	DEBUG_PRODUCTION("el_parse_for_statement");
 	int err = 0;
-	assert(parent->num_statements < parent->max_num_statements);
-	parent->statements[parent->num_statements].type = el_AST_NODE_FOR_STATEMENT;
-	struct el_ast_for_statement * for_statement = &parent->statements[parent->num_statements++].for_statement;
+	struct el_ast_statement * statement = el_vector_push(parent, statements, parser->allocator);
+	if(!statement)
+		return el_ALLOCATION_ERROR;
+	statement->type = el_AST_NODE_FOR_STATEMENT;
+	struct el_ast_for_statement * for_statement = &statement->for_statement;
+
+	for_statement->is_parallel = false;
+	for_statement->reductions = NULL;
+	for_statement->max_num_reductions = 0;
+	for_statement->num_reductions = 0;
+	if(el_is_lookahead(parser, el_PARALLEL_KEYWORD))
+	{
+		for_statement->is_parallel = true;
+		err = err || el_match_token(parser, el_PARALLEL_KEYWORD);
+		if(el_is_lookahead(parser, el_PARENTHESIS_OPEN))
+		{
+			err = err || el_parse_reductions(parser, for_statement);
+		}
+	}
 
-	err = err || el_match_token(token_stream, el_FOR_KEYWORD);
-	for_statement->index_var_name = el_copy_lookahead(token_stream, allocator);
+	err = err || el_match_token(parser, el_FOR_KEYWORD);
+	for_statement->index_var_name = el_copy_lookahead(parser);
 	if(!for_statement->index_var_name)
 		return el_ALLOCATION_ERROR;
 
-	err = err || el_match_token(token_stream, el_IDENTIFIER); // Index variable
-	err = err || el_match_token(token_stream, el_COMMA_SEPARATOR);
-	for_statement->value_var_name = el_copy_lookahead(token_stream, allocator);
+	err = err || el_match_token(parser, el_IDENTIFIER); // Index variable
+	err = err || el_match_token(parser, el_COMMA_SEPARATOR);
+	for_statement->value_var_name = el_copy_lookahead(parser);
 	if(!for_statement->value_var_name)
 		return el_ALLOCATION_ERROR;
 
-	err = err || el_match_token(token_stream, el_IDENTIFIER); // Element variable
-	err = err || el_match_token(token_stream, el_IN_KEYWORD);
-	err = err || el_parse_complex_identifier(token_stream, allocator, &for_statement->range);
-	err = err || el_parse_code_block(token_stream, allocator, &for_statement->code_block);
+	err = err || el_match_token(parser, el_IDENTIFIER); // Element variable
+	err = err || el_match_token(parser, el_IN_KEYWORD);
+	err = err || el_parse_complex_identifier(parser, &for_statement->range);
+	err = err || el_parse_code_block(parser, &for_statement->code_block);
 	return err;
 }
 
-static int el_parse_if_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * parent)
+// Reductions are listed as the operation followed by the variable, e.g. (sum total, max highest)
+static int el_parse_reductions(struct el_parser * parser, struct el_ast_for_statement * parent)
+{
+	DEBUG_PRODUCTION("el_parse_reductions");
+	static char const * const reduction_names[el_ast_reduction_type_count] = { "sum", "min", "max" };
+	int err = el_match_token(parser, el_PARENTHESIS_OPEN);
+	while(err == 0)
+	{
+		struct el_ast_reduction * reduction = el_vector_push(parent, reductions, parser->allocator);
+		if(!reduction)
+			return el_ALLOCATION_ERROR;
+
+		struct el_string_view source = parser->token_stream->tokens[parser->token_stream->current_token].source;
+		reduction->type = -1;
+		reduction->symbol = el_NO_SYMBOL;
+		for(int i = 0; i < el_ast_reduction_type_count && el_is_lookahead(parser, el_IDENTIFIER); ++i)
+		{
+			if((size_t)source.length == strlen(reduction_names[i]) && strncmp(source.data, reduction_names[i], source.length) == 0)
+			{
+				reduction->type = i;
+			}
+		}
+		if(reduction->type < 0)
+		{
+			fprintf(stderr, "Expected sum, min or max to reduce by, got %.*s\n", source.length, source.data);
+			return el_EXPECTED_REDUCTION_PARSE_ERROR;
+		}
+
+		err = err || el_match_token(parser, el_IDENTIFIER);
+		reduction->var_name = el_copy_lookahead(parser);
+		if(!reduction->var_name)
+			return el_ALLOCATION_ERROR;
+
+		err = err || el_match_token(parser, el_IDENTIFIER);
+		if(!el_is_lookahead(parser, el_COMMA_SEPARATOR))
+			break;
+		err = err || el_match_token(parser, el_COMMA_SEPARATOR);
+	}
+	err = err || el_match_token(parser, el_PARENTHESIS_CLOSE);
+	return err;
+}
+
+static int el_parse_if_statement(struct el_parser * parser, struct el_ast_statement_list * parent)
 {
 	DEBUG_PRODUCTION("el_parse_if_statement");
 	int err = 0;
-	assert(parent->num_statements < parent->max_num_statements);
-	parent->statements[parent->num_statements].type = el_AST_NODE_IF_STATEMENT;
-	struct el_ast_if_statement * if_statement = &parent->statements[parent->num_statements++].if_statement;
-	
-	if_statement->num_elif_statements = 0;
-	if_statement->max_num_elif_statements = MAX_NUM_ELIFS_PER_IF;
-	if_statement->elif_statements = el_linear_alloc(allocator, sizeof(struct el_ast_elif_statement) * if_statement->max_num_elif_statements);
-	if(!if_statement->elif_statements)
+	struct el_ast_statement * statement = el_vector_push(parent, statements, parser->allocator);
+	if(!statement)
 		return el_ALLOCATION_ERROR;
+	statement->type = el_AST_NODE_IF_STATEMENT;
+	struct el_ast_if_statement * if_statement = &statement->if_statement;
+
+	if_statement->elif_statements = NULL;
+	if_statement->max_num_elif_statements = 0;
+	if_statement->num_elif_statements = 0;
+	if_statement->else_statement = NULL;
 
-	err = err || el_match_token(token_stream, el_IF_KEYWORD);
-	err = err || el_parse_expr(token_stream, allocator, &if_statement->expression);
-	err = err || el_parse_code_block(token_stream, allocator, &if_statement->code_block);
-	if(el_is_lookahead(token_stream, el_ELIF_KEYWORD))
+	err = err || el_match_token(parser, el_IF_KEYWORD);
+	err = err || el_parse_expr(parser, &if_statement->expression);
+	err = err || el_parse_code_block(parser, &if_statement->code_block);
+	if(el_is_lookahead(parser, el_ELIF_KEYWORD))
 	{
-		err = err || el_parse_elif_statements(token_stream, allocator, if_statement);
+		err = err || el_parse_elif_statements(parser, if_statement);
 	}
-	if(el_is_lookahead(token_stream, el_ELSE_KEYWORD))
+	if(el_is_lookahead(parser, el_ELSE_KEYWORD))
 	{
-		err = err || el_parse_else_statement(token_stream, allocator, if_statement);
+		err = err || el_parse_else_statement(parser, if_statement);
 	}
 	return err;
 }
 
-static int el_parse_elif_statements(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_if_statement * parent)
+static int el_parse_elif_statements(struct el_parser * parser, struct el_ast_if_statement * parent)
 {
 	DEBUG_PRODUCTION("el_parse_elif_statements");
 	int err = 0;
-	assert(parent->num_elif_statements < parent->max_num_elif_statements);
-	struct el_ast_elif_statement * elif_statement = &parent->elif_statements[parent->num_elif_statements++];
-	err = err || el_match_token(token_stream, el_ELIF_KEYWORD);
-	err = err || el_parse_expr(token_stream, allocator, &elif_statement->expression);
-	err = err || el_parse_code_block(token_stream, allocator, &elif_statement->code_block);
-	if(el_is_lookahead(token_stream, el_ELIF_KEYWORD))
+	while(err == 0 && el_is_lookahead(parser, el_ELIF_KEYWORD))
 	{
-		err = err || el_parse_elif_statements(token_stream, allocator, parent);
+		struct el_ast_elif_statement * elif_statement = el_vector_push(parent, elif_statements, parser->allocator);
+		if(!elif_statement)
+			return el_ALLOCATION_ERROR;
+		err = err || el_match_token(parser, el_ELIF_KEYWORD);
+		err = err || el_parse_expr(parser, &elif_statement->expression);
+		err = err || el_parse_code_block(parser, &elif_statement->code_block);
 	}
 	return err;
 }
 
-static int el_parse_else_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_if_statement * parent)
+static int el_parse_else_statement(struct el_parser * parser, struct el_ast_if_statement * parent)
 {
 	DEBUG_PRODUCTION("el_parse_else_statement");
 	int err = 0;
-	parent->else_statement = el_linear_alloc(allocator, sizeof(struct el_ast_statement_list));
+	parent->else_statement = el_linear_alloc(parser->allocator, sizeof(struct el_ast_statement_list));
 	if(!parent->else_statement)
 		return el_ALLOCATION_ERROR;
-	err = err || el_match_token(token_stream, el_ELSE_KEYWORD);
-	err = err || el_parse_code_block(token_stream, allocator, parent->else_statement);
+	err = err || el_match_token(parser, el_ELSE_KEYWORD);
+	err = err || el_parse_code_block(parser, parent->else_statement);
 	return err;
 }
 
-static int el_parse_assignment(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression)
+static int el_parse_assignment(struct el_parser * parser, struct el_ast_expression * expression)
 {
 	DEBUG_PRODUCTION("el_parse_assignment");
 	int err = 0;
-	err = err || el_match_token(token_stream, el_ASSIGN_OPERATOR);
-	err = err || el_parse_expr(token_stream, allocator, expression);
+	err = err || el_match_token(parser, el_ASSIGN_OPERATOR);
+	err = err || el_parse_expr(parser, expression);
 	return err;
 }
 
-static int el_parse_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression)
+static int el_parse_expr(struct el_parser * parser, struct el_ast_expression * expression)
 {
 	DEBUG_PRODUCTION("el_parse_expr");
-	int err = 0;
-	err = err || el_parse_boolean_or_expr(token_stream, allocator, expression);
-	if(
-		el_is_lookahead(token_stream, el_EQUALS_COMPARATOR) ||
-		el_is_lookahead(token_stream, el_GREATER_THAN_COMPARATOR) ||
-		el_is_lookahead(token_stream, el_LESS_THAN_COMPARATOR) ||
-		el_is_lookahead(token_stream, el_LEQUALS_COMPARATOR) ||
-		el_is_lookahead(token_stream, el_GEQUALS_COMPARATOR))
-	{
-		if(el_is_lookahead(token_stream, el_EQUALS_COMPARATOR))
-		{
-			err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_EQUALS);
-			err = err || el_match_token(token_stream, el_EQUALS_COMPARATOR);
-			err = err || el_parse_expr(token_stream, allocator, expression->binary_op.rhs);
-		}
-		else if(el_is_lookahead(token_stream, el_GREATER_THAN_COMPARATOR))
-		{
-			err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_GREATER_THAN);
-			err = err || el_match_token(token_stream, el_GREATER_THAN_COMPARATOR);
-			err = err || el_parse_expr(token_stream, allocator, expression->binary_op.rhs);
-		}
-		else if(el_is_lookahead(token_stream, el_LESS_THAN_COMPARATOR))
-		{
-			err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_LESS_THAN);
-			err = err || el_match_token(token_stream, el_LESS_THAN_COMPARATOR);
-			err = err || el_parse_expr(token_stream, allocator, expression->binary_op.rhs);
-		}
-		else if(el_is_lookahead(token_stream, el_LEQUALS_COMPARATOR))
-		{
-			err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_LEQUALS);
-			err = err || el_match_token(token_stream, el_LEQUALS_COMPARATOR);
-			err = err || el_parse_expr(token_stream, allocator, expression->binary_op.rhs);
-		}
-		else if(el_is_lookahead(token_stream, el_GEQUALS_COMPARATOR))
-		{
-			err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_GEQUALS);
-			err = err || el_match_token(token_stream, el_GEQUALS_COMPARATOR);
-			err = err || el_parse_expr(token_stream, allocator, expression->binary_op.rhs);
-		}
-	}
-	return err;
-}
-
-static int el_parse_function_call(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression_list * expression_list)
-{
-	DEBUG_PRODUCTION("el_parse_function_call");
-	int err = 0;
-	err = err || el_match_token(token_stream, el_PARENTHESIS_OPEN);
-	err = err || el_parse_arguments(token_stream, allocator, expression_list);
-	err = err || el_match_token(token_stream, el_PARENTHESIS_CLOSE);
-	return err;
+	return el_parse_expression(parser, expression, false);
 }
 
-static int el_parse_arguments(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression_list * expression_list)
-{
-	DEBUG_PRODUCTION("el_parse_arguments");
-	int err = 0;
-	if(el_is_lookahead(token_stream, el_PARENTHESIS_CLOSE))
-		return err;
-
-	assert(expression_list->num_expressions < expression_list->max_num_expressions);
-	err = err || el_parse_expr(token_stream, allocator, &expression_list->expressions[expression_list->num_expressions++]);
-	if(el_is_lookahead(token_stream, el_COMMA_SEPARATOR))
-	{
-		// NOTE - This allows a trailing comma before the closing bracket
-		err = err || el_match_token(token_stream, el_COMMA_SEPARATOR);
-		err = err || el_parse_arguments(token_stream, allocator, expression_list);
-	}
-	return err;
-}
-
-static int el_parse_data_block(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_statement_list * parent)
+static int el_parse_data_block(struct el_parser * parser, struct el_ast_statement_list * parent)
 {
 	DEBUG_PRODUCTION("el_parse_data_block");
 	int err = 0;
-	assert(parent->num_statements < parent->max_num_statements);
-	parent->statements[parent->num_statements].type = el_AST_NODE_DATA_BLOCK;
-	struct el_ast_data_block * data_block = &parent->statements[parent->num_statements++].data_block;
+	struct el_ast_statement * statement = el_vector_push(parent, statements, parser->allocator);
+	if(!statement)
+		return el_ALLOCATION_ERROR;
+	statement->type = el_AST_NODE_DATA_BLOCK;
+	struct el_ast_data_block * data_block = &statement->data_block;
 
+	data_block->var_declarations = NULL;
+	data_block->max_num_var_declarations = 0;
 	data_block->num_var_declarations = 0;
-	data_block->max_num_var_declarations = MAX_NUM_VARS_PER_DATA_BLOCK;
-	data_block->var_declarations = el_linear_alloc(allocator, sizeof(struct el_ast_var_decl) * data_block->max_num_var_declarations);
-	if(!data_block->var_declarations)
-		return el_ALLOCATION_ERROR;
+	data_block->is_soa = false;
 
-	err = err || el_match_token(token_stream, el_DAT_KEYWORD);
-	data_block->name = el_copy_lookahead(token_stream, allocator);
+	err = err || el_match_token(parser, el_DAT_KEYWORD);
+	data_block->name = el_copy_lookahead(parser);
 	if(!data_block->name)
 		return el_ALLOCATION_ERROR;
 
-	err = err || el_match_token(token_stream, el_IDENTIFIER);
-	err = err || el_match_token(token_stream, el_BLOCK_START);
-	err = err || el_parse_data_block_statements(token_stream, allocator, data_block);
-	err = err || el_match_token(token_stream, el_BLOCK_END);
-	err = err || el_parse_new_line(token_stream);
+	err = err || el_match_token(parser, el_IDENTIFIER);
+	if(err == 0 && el_is_lookahead(parser, el_SOA_KEYWORD))
+	{
+		data_block->is_soa = true;
+		err = el_match_token(parser, el_SOA_KEYWORD);
+	}
+	err = err || el_match_token(parser, el_BLOCK_START);
+	err = err || el_parse_data_block_statements(parser, data_block);
+	err = err || el_match_token(parser, el_BLOCK_END);
+	err = err || el_parse_new_line(parser);
 	return err;
 }
 
-static int el_parse_data_block_statements(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_data_block * data_block)
+static int el_parse_data_block_statements(struct el_parser * parser, struct el_ast_data_block * data_block)
 {
 	DEBUG_PRODUCTION("el_parse_data_block_statements");
 	int err = 0;
-	err = err || el_parse_new_lines(token_stream);
-	if(el_is_lookahead(token_stream, el_BLOCK_END))
-		return err;
+	while(err == 0)
+	{
+		err = err || el_parse_new_lines(parser);
+		if(el_is_lookahead(parser, el_BLOCK_END))
+			break;
 
-	// Parse a single statement
-	err = err || el_parse_data_block_statement(token_stream, allocator, data_block);
-	// Parse additional statements by recursing into this fn
-	err = err || el_parse_data_block_statements(token_stream, allocator, data_block);
+		// Parse a single statement
+		err = err || el_parse_data_block_statement(parser, data_block);
+	}
 	return err;
 }
 
-static int el_parse_data_block_statement(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_data_block * data_block)
+static int el_parse_data_block_statement(struct el_parser * parser, struct el_ast_data_block * data_block)
 {
 	DEBUG_PRODUCTION("el_parse_data_block_statement");
 	int err = 0;
-	assert(data_block->num_var_declarations < data_block->max_num_var_declarations);
-	struct el_ast_var_decl * var_decl = &data_block->var_declarations[data_block->num_var_declarations++];
-	var_decl->name = el_copy_lookahead(token_stream, allocator);
+	struct el_ast_var_decl * var_decl = el_vector_push(data_block, var_declarations, parser->allocator);
+	if(!var_decl)
+		return el_ALLOCATION_ERROR;
+	var_decl->name = el_copy_lookahead(parser);
 	if(!var_decl->name)
 		return el_ALLOCATION_ERROR;
-	err = err || el_match_token(token_stream, el_IDENTIFIER);
-	err = err || el_parse_type(token_stream, allocator, &var_decl->type);
+	err = err || el_match_token(parser, el_IDENTIFIER);
+	err = err || el_parse_type(parser, &var_decl->type);
 	return err;
 }
 
-static int el_parse_optional_type(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_var_type * var_type)
+static int el_parse_optional_type(struct el_parser * parser, struct el_ast_var_type * var_type)
 {
 	DEBUG_PRODUCTION("el_parse_optional_type");
 	int err = 0;
 	var_type->is_native = true;
+	var_type->symbol = el_NO_SYMBOL;
 	var_type->native_type = el_NONE;
 	var_type->num_dimensions = 0;
-	if(
-		el_is_lookahead(token_stream, el_IDENTIFIER) ||
-		el_is_lookahead(token_stream, el_INT_TYPE) ||
-		el_is_lookahead(token_stream, el_FLOAT_TYPE))
+	var_type->type_id = el_NO_TYPE;
+	if(el_is_lookahead_in(parser, FIRST_TYPE))
 	{
-		err = err || el_parse_type(token_stream, allocator, var_type);
+		err = err || el_parse_type(parser, var_type);
 	}
 	return err;
 }
 
-static int el_parse_type(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_var_type * var_type)
+static int el_parse_type(struct el_parser * parser, struct el_ast_var_type * var_type)
 {
 	DEBUG_PRODUCTION("el_parse_type");
 	int err = 0;
-	if(el_is_lookahead(token_stream, el_IDENTIFIER))
+	switch(parser->lookahead)
 	{
+	case el_IDENTIFIER:
 		var_type->is_native = false;
-		var_type->custom_type = el_copy_lookahead(token_stream, allocator);
+		var_type->symbol = el_NO_SYMBOL;
+		var_type->custom_type = el_copy_lookahead(parser);
 		if(!var_type->custom_type)
 			return el_ALLOCATION_ERROR;
-		err = err || el_match_token(token_stream, el_IDENTIFIER);
-	}
-	else if(el_is_lookahead(token_stream, el_INT_TYPE))
-	{
+		err = err || el_match_token(parser, el_IDENTIFIER);
+		break;
+	case el_INT_TYPE:
+	case el_FLOAT_TYPE:
+	case el_INT2_TYPE:
+	case el_INT4_TYPE:
+	case el_INT8_TYPE:
+	case el_FLOAT2_TYPE:
+	case el_FLOAT4_TYPE:
+	case el_FLOAT8_TYPE:
 		var_type->is_native = true;
-		var_type->native_type = el_INT_TYPE;
-		err = err || el_match_token(token_stream, el_INT_TYPE);
-	}
-	else if(el_is_lookahead(token_stream, el_FLOAT_TYPE))
-	{
-		var_type->is_native = true;
-		var_type->native_type = el_FLOAT_TYPE;
-		err = err || el_match_token(token_stream, el_FLOAT_TYPE);
-	}
-	else
-	{
-		fprintf(stderr, "Expected a type, got %d %s\n", token_stream->tokens[token_stream->current_token].type, token_stream->tokens[token_stream->current_token].source);
+		var_type->symbol = el_NO_SYMBOL;
+		var_type->native_type = parser->lookahead;
+		err = err || el_match_token(parser, parser->lookahead);
+		break;
+	default:
+		fprintf(stderr, "Expected a type, got %d\n", parser->lookahead);
 		return el_EXPECTED_TYPE_PARSE_ERROR;
 	}
-	
+
 	// Parse multiple slice open & close tokens to support multi-dimensional slices
 	var_type->num_dimensions = 0;
-	while(el_is_lookahead(token_stream, el_SLICE_START) && err == 0)
+	var_type->type_id = el_NO_TYPE;
+	while(el_is_lookahead(parser, el_SLICE_START) && err == 0)
 	{
 		var_type->num_dimensions++;
-		err = err || el_match_token(token_stream, el_SLICE_START);
-		err = err || el_match_token(token_stream, el_SLICE_END);
+		err = err || el_match_token(parser, el_SLICE_START);
+		err = err || el_match_token(parser, el_SLICE_END);
 	}
 	return err;
 }
 
-static int el_parse_complex_identifier(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression)
+static int el_parse_complex_identifier(struct el_parser * parser, struct el_ast_expression * expression)
 {
 	DEBUG_PRODUCTION("el_parse_complex_identifier");
-	int err = 0;
-	expression->type = el_AST_EXPR_IDENTIFIER;
-	expression->identifier = el_copy_lookahead(token_stream, allocator);
-	if(!expression->identifier)
-		return el_ALLOCATION_ERROR;
-	err = err || el_match_token(token_stream, el_IDENTIFIER);
-	err = err || el_parse_complex_identifier_inner(token_stream, allocator, expression);
-	return err;
+	return el_parse_expression(parser, expression, true);
 }
 
-static int el_parse_complex_identifier_inner(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression)
+// Parse an expression with a single precedence climbing loop, driven by infix_binding_powers
+// Pending operators and unclosed brackets are held on the parser's explicit stack rather than the call stack
+// If complex_identifier_only is set, only an identifier followed by chained slice indexes, function calls
+// and dot operations is accepted at the outermost level (e.g. the lhs of an assignment)
+static int el_parse_expression(struct el_parser * parser, struct el_ast_expression * expression, bool complex_identifier_only)
 {
-	DEBUG_PRODUCTION("el_parse_complex_identifier_inner");
+	DEBUG_PRODUCTION("el_parse_expression");
+	struct el_expr_stack * stack = &parser->expr_stack;
+	assert(stack->num_frames == 0 && stack->num_operands == 0);
+
 	int err = 0;
-	if(el_is_lookahead(token_stream, el_SLICE_START))
+	bool expect_operand = true;
+	bool allow_postfix = false;
+	bool done = false;
+	while(err == 0 && !done)
 	{
-		err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_SLICE_INDEX);
-		err = err || el_match_token(token_stream, el_SLICE_START);
-		err = err || el_parse_expr(token_stream, allocator, expression->binary_op.rhs);
-		err = err || el_match_token(token_stream, el_SLICE_END);
+		int lookahead = parser->lookahead;
+		if(expect_operand)
+		{
+			if(complex_identifier_only && stack->num_frames == 0 && lookahead != el_IDENTIFIER)
+			{
+				err = el_match_token(parser, el_IDENTIFIER);
+				break;
+			}
+			err = el_parse_expression_operand(parser, &expect_operand, &allow_postfix);
+			continue;
+		}
+
+		struct el_binding_power const * binding_power = &infix_binding_powers[lookahead];
+		if(allow_postfix && el_is_lookahead_in(parser, FIRST_POSTFIX))
+		{
+			// Slice indexes and argument lists open a new group, dot operations complete immediately
+			int num_frames = stack->num_frames;
+			err = el_parse_expression_postfix(parser);
+			expect_operand = stack->num_frames > num_frames;
+		}
+		else if(binding_power->left > 0 && !(complex_identifier_only && stack->num_frames == 0))
+		{
+			err = err || el_reduce_binary_ops(parser, binding_power->left);
+			err = err || el_push_expr_frame(parser, el_EXPR_FRAME_BINARY_OP, binding_power->right, binding_power->expr_type, NULL);
+			err = err || el_match_token(parser, lookahead);
+			expect_operand = true;
+		}
+		else if(el_is_lookahead_in(parser, FOLLOW_GROUPED_EXPR))
+		{
+			// Separators and closing brackets either belong to an unclosed group or end the expression
+			err = err || el_reduce_binary_ops(parser, 0);
+			int group = stack->num_frames > 0 ? stack->frames[stack->num_frames - 1].type : -1;
+			if(lookahead == el_COMMA_SEPARATOR && (group == el_EXPR_FRAME_SLICE_LITERAL || group == el_EXPR_FRAME_ARGUMENTS))
+			{
+				struct el_ast_expression * list = stack->frames[stack->num_frames - 1].expression;
+				err = err || el_append_expr_list(parser->allocator, list->expression_list, stack->operands[--stack->num_operands]);
+				err = err || el_match_token(parser, el_COMMA_SEPARATOR);
+
+				// NOTE - This allows a trailing comma before the closing bracket
+				int closer = group == el_EXPR_FRAME_ARGUMENTS ? el_PARENTHESIS_CLOSE : el_SLICE_END;
+				if(el_is_lookahead(parser, closer))
+				{
+					err = err || el_close_expression_group(parser, false, &allow_postfix);
+				}
+				else
+				{
+					expect_operand = true;
+				}
+			}
+			else if(
+				(lookahead == el_PARENTHESIS_CLOSE && (group == el_EXPR_FRAME_PARENTHESIS || group == el_EXPR_FRAME_ARGUMENTS)) ||
+				(lookahead == el_SLICE_END && (group == el_EXPR_FRAME_SLICE_LITERAL || group == el_EXPR_FRAME_SLICE_INDEX)))
+			{
+				err = err || el_close_expression_group(parser, true, &allow_postfix);
+			}
+			else
+			{
+				done = true;
+			}
+		}
+		else
+		{
+			done = true;
+		}
 	}
-	else if(el_is_lookahead(token_stream, el_PARENTHESIS_OPEN))
+
+	if(err == 0)
 	{
-		err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_FUNCTION_CALL);
-		err = err || el_new_expr_list(allocator, expression->binary_op.rhs, el_AST_EXPR_ARGUMENTS);
-		err = err || el_parse_function_call(token_stream, allocator, expression->binary_op.rhs->expression_list);
+		err = el_reduce_binary_ops(parser, 0);
 	}
-	else if(el_is_lookahead(token_stream, el_DOT_OPERATOR))
+
+	// Any bracket still on the stack was never closed
+	if(err == 0 && stack->num_frames > 0)
 	{
-		err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_DOT);
-		err = err || el_match_token(token_stream, el_DOT_OPERATOR);
-		expression->binary_op.rhs->type = el_AST_EXPR_IDENTIFIER;
-		expression->binary_op.rhs->identifier = el_copy_lookahead(token_stream, allocator);
-		if(!expression->binary_op.rhs->identifier)
-			return el_ALLOCATION_ERROR;
-		err = err || el_match_token(token_stream, el_IDENTIFIER);
+		int group = stack->frames[stack->num_frames - 1].type;
+		err = el_match_token(parser, group == el_EXPR_FRAME_PARENTHESIS || group == el_EXPR_FRAME_ARGUMENTS ? el_PARENTHESIS_CLOSE : el_SLICE_END);
 	}
-	else
+
+	if(err == 0)
 	{
-		// NOTE - This is not an error condition
-		return err;
+		assert(stack->num_operands == 1);
+		*expression = *stack->operands[0];
 	}
-	// Recurse into fn s.t. slice indexes, function calls, and dot operations can be chained
-	err = err || el_parse_complex_identifier_inner(token_stream, allocator, expression->binary_op.rhs);
+
+	stack->num_frames = 0;
+	stack->num_operands = 0;
 	return err;
 }
 
-static int el_parse_boolean_or_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression)
+// Parse a factor, or the opening bracket of a factor which contains nested expressions
+static int el_parse_expression_operand(struct el_parser * parser, bool * expect_operand, bool * allow_postfix)
 {
-	DEBUG_PRODUCTION("el_parse_boolean_or_expr");
+	DEBUG_PRODUCTION("el_parse_expression_operand");
+	int lookahead = parser->lookahead;
 	int err = 0;
-	err = err || el_parse_boolean_and_expr(token_stream, allocator, expression);
-	if(el_is_lookahead(token_stream, el_BOOLEAN_OR))
+	if(lookahead == el_PARENTHESIS_OPEN)
 	{
-		err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_BOOLEAN_OR);
-		err = err || el_match_token(token_stream, el_BOOLEAN_OR);
-		err = err || el_parse_boolean_or_expr(token_stream, allocator, expression->binary_op.rhs);
+		err = err || el_match_token(parser, el_PARENTHESIS_OPEN);
+		err = err || el_push_expr_frame(parser, el_EXPR_FRAME_PARENTHESIS, 0, 0, NULL);
+		return err;
 	}
-	return err;
-}
 
-static int el_parse_boolean_and_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression)
-{
-	DEBUG_PRODUCTION("el_parse_boolean_and_expr");
-	int err = 0;
-	err = err || el_parse_add_or_sub_expr(token_stream, allocator, expression);
-	if(el_is_lookahead(token_stream, el_BOOLEAN_AND))
+	struct el_ast_expression * operand = el_linear_alloc(parser->allocator, sizeof *operand);
+	if(!operand)
+		return el_ALLOCATION_ERROR;
+
+	switch(lookahead)
 	{
-		err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_BOOLEAN_AND);
-		err = err || el_match_token(token_stream, el_BOOLEAN_AND);
-		err = err || el_parse_boolean_and_expr(token_stream, allocator, expression->binary_op.rhs);
+	case el_NUMBER_LITERAL:
+		operand->type = el_AST_EXPR_NUMBER_LITERAL;
+		operand->symbol = el_NO_SYMBOL;
+		operand->type_id = el_NO_TYPE;
+		operand->number_literal = el_copy_lookahead(parser);
+		operand->int_value = 0;
+		if(!operand->number_literal)
+			return el_ALLOCATION_ERROR;
+		err = err || el_match_token(parser, el_NUMBER_LITERAL);
+		err = err || el_push_expr_operand(parser, operand);
+		*expect_operand = false;
+		*allow_postfix = false;
+		break;
+	case el_STRING_LITERAL:
+		operand->type = el_AST_EXPR_STRING_LITERAL;
+		operand->symbol = el_NO_SYMBOL;
+		operand->type_id = el_NO_TYPE;
+		operand->string_literal = el_copy_lookahead(parser);
+		if(!operand->string_literal)
+			return el_ALLOCATION_ERROR;
+		err = err || el_match_token(parser, el_STRING_LITERAL);
+		err = err || el_push_expr_operand(parser, operand);
+		*expect_operand = false;
+		*allow_postfix = false;
+		break;
+	case el_IDENTIFIER:
+		operand->type = el_AST_EXPR_IDENTIFIER;
+		operand->symbol = el_NO_SYMBOL;
+		operand->type_id = el_NO_TYPE;
+		operand->identifier = el_copy_lookahead(parser);
+		if(!operand->identifier)
+			return el_ALLOCATION_ERROR;
+		err = err || el_match_token(parser, el_IDENTIFIER);
+		err = err || el_push_expr_operand(parser, operand);
+		*expect_operand = false;
+		*allow_postfix = true;
+		break;
+	case el_INT2_TYPE:
+	case el_INT4_TYPE:
+	case el_INT8_TYPE:
+	case el_FLOAT2_TYPE:
+	case el_FLOAT4_TYPE:
+	case el_FLOAT8_TYPE:
+		operand->type = el_AST_EXPR_VECTOR_TYPE;
+		operand->symbol = el_NO_SYMBOL;
+		operand->type_id = el_NO_TYPE;
+		operand->native_type = lookahead;
+		err = err || el_match_token(parser, lookahead);
+		err = err || el_push_expr_operand(parser, operand);
+		*expect_operand = false;
+		*allow_postfix = true;
+		break;
+	case el_SLICE_START:
+		err = err || el_new_expr_list(parser->allocator, operand, el_AST_EXPR_SLICE_LITERAL);
+		err = err || el_match_token(parser, el_SLICE_START);
+		if(err == 0 && el_is_lookahead(parser, el_SLICE_END))
+		{
+			err = err || el_match_token(parser, el_SLICE_END);
+			err = err || el_push_expr_operand(parser, operand);
+			*expect_operand = false;
+			*allow_postfix = false;
+		}
+		else
+		{
+			err = err || el_push_expr_frame(parser, el_EXPR_FRAME_SLICE_LITERAL, 0, 0, operand);
+		}
+		break;
+	default:
+		fprintf(stderr, "Expected a factor expression\n");
+		return el_EXPECTED_FACTOR_EXPR_PARSE_ERROR;
 	}
 	return err;
 }
 
-static int el_parse_add_or_sub_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression)
+// Parse a slice index, function call or dot operation applied to the operand on top of the stack
+static int el_parse_expression_postfix(struct el_parser * parser)
 {
-	DEBUG_PRODUCTION("el_parse_add_or_sub_expr");
+	DEBUG_PRODUCTION("el_parse_expression_postfix");
+	struct el_expr_stack * stack = &parser->expr_stack;
+	struct el_ast_expression ** target = &stack->operands[stack->num_operands - 1];
 	int err = 0;
-	err = err || el_parse_mult_or_div_expr(token_stream, allocator, expression);
-	if(el_is_lookahead(token_stream, el_ADD_OPERATOR))
+	if(el_is_lookahead(parser, el_SLICE_START))
 	{
-		err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_ADD);
-		err = err || el_match_token(token_stream, el_ADD_OPERATOR);
-		err = err || el_parse_add_or_sub_expr(token_stream, allocator, expression->binary_op.rhs);
+		err = err || el_match_token(parser, el_SLICE_START);
+		err = err || el_push_expr_frame(parser, el_EXPR_FRAME_SLICE_INDEX, 0, 0, NULL);
+		return err;
 	}
-	else if(el_is_lookahead(token_stream, el_SUBTRACT_OPERATOR))
+
+	struct el_ast_expression * rhs = el_linear_alloc(parser->allocator, sizeof *rhs);
+	if(!rhs)
+		return el_ALLOCATION_ERROR;
+
+	if(el_is_lookahead(parser, el_PARENTHESIS_OPEN))
 	{
-		err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_SUB);
-		err = err || el_match_token(token_stream, el_SUBTRACT_OPERATOR);
-		err = err || el_parse_add_or_sub_expr(token_stream, allocator, expression->binary_op.rhs);
+		err = err || el_new_expr_list(parser->allocator, rhs, el_AST_EXPR_ARGUMENTS);
+		err = err || el_match_token(parser, el_PARENTHESIS_OPEN);
+		if(err == 0 && el_is_lookahead(parser, el_PARENTHESIS_CLOSE))
+		{
+			err = err || el_match_token(parser, el_PARENTHESIS_CLOSE);
+			err = err || el_new_binary_op(parser->allocator, el_AST_EXPR_FUNCTION_CALL, *target, rhs, target);
+		}
+		else
+		{
+			err = err || el_push_expr_frame(parser, el_EXPR_FRAME_ARGUMENTS, 0, 0, rhs);
+		}
+	}
+	else
+	{
+		err = err || el_match_token(parser, el_DOT_OPERATOR);
+		rhs->type = el_AST_EXPR_IDENTIFIER;
+		rhs->symbol = el_NO_SYMBOL;
+		rhs->type_id = el_NO_TYPE;
+		rhs->identifier = el_copy_lookahead(parser);
+		if(!rhs->identifier)
+			return el_ALLOCATION_ERROR;
+		err = err || el_match_token(parser, el_IDENTIFIER);
+		err = err || el_new_binary_op(parser->allocator, el_AST_EXPR_DOT, *target, rhs, target);
 	}
 	return err;
 }
 
-static int el_parse_mult_or_div_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression)
+// Close the bracket on top of the frame stack, replacing its contents with a single operand
+// The closing bracket must be the lookahead token
+static int el_close_expression_group(struct el_parser * parser, bool append_operand, bool * allow_postfix)
 {
-	DEBUG_PRODUCTION("el_parse_mult_or_div_expr");
+	struct el_expr_stack * stack = &parser->expr_stack;
+	struct el_expr_frame * frame = &stack->frames[--stack->num_frames];
+	struct el_ast_expression ** top = &stack->operands[stack->num_operands - 1];
 	int err = 0;
-	err = err || el_parse_factor_expr(token_stream, allocator, expression);
-	if(el_is_lookahead(token_stream, el_MULTIPLY_OPERATOR))
-	{
-		err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_MUL);
-		err = err || el_match_token(token_stream, el_MULTIPLY_OPERATOR);
-		err = err || el_parse_mult_or_div_expr(token_stream, allocator, expression->binary_op.rhs);
-	}
-	else if(el_is_lookahead(token_stream, el_DIVIDE_OPERATOR))
+	switch(frame->type)
 	{
-		err = err || el_convert_to_binary_op(allocator, expression, el_AST_EXPR_DIV);
-		err = err || el_match_token(token_stream, el_DIVIDE_OPERATOR);
-		err = err || el_parse_mult_or_div_expr(token_stream, allocator, expression->binary_op.rhs);
+	case el_EXPR_FRAME_PARENTHESIS:
+		err = err || el_match_token(parser, el_PARENTHESIS_CLOSE);
+		*allow_postfix = false;
+		break;
+	case el_EXPR_FRAME_SLICE_LITERAL:
+		if(append_operand)
+		{
+			err = err || el_append_expr_list(parser->allocator, frame->expression->expression_list, stack->operands[--stack->num_operands]);
+		}
+		err = err || el_match_token(parser, el_SLICE_END);
+		err = err || el_push_expr_operand(parser, frame->expression);
+		*allow_postfix = false;
+		break;
+	case el_EXPR_FRAME_ARGUMENTS:
+		if(append_operand)
+		{
+			err = err || el_append_expr_list(parser->allocator, frame->expression->expression_list, stack->operands[--stack->num_operands]);
+		}
+		err = err || el_match_token(parser, el_PARENTHESIS_CLOSE);
+		top = &stack->operands[stack->num_operands - 1];
+		err = err || el_new_binary_op(parser->allocator, el_AST_EXPR_FUNCTION_CALL, *top, frame->expression, top);
+		*allow_postfix = true;
+		break;
+	case el_EXPR_FRAME_SLICE_INDEX:
+		err = err || el_match_token(parser, el_SLICE_END);
+		--stack->num_operands;
+		err = err || el_new_binary_op(parser->allocator, el_AST_EXPR_SLICE_INDEX, top[-1], top[0], top - 1);
+		*allow_postfix = true;
+		break;
+	default:
+		assert(false);
+		break;
 	}
 	return err;
 }
 
-static int el_parse_factor_expr(struct el_token_stream * token_stream, struct el_linear_allocator * allocator, struct el_ast_expression * expression)
+// Combine operands for pending binary operators whose right binding power is greater than that given
+// Stops at the innermost unclosed bracket
+static int el_reduce_binary_ops(struct el_parser * parser, int binding_power)
 {
-	DEBUG_PRODUCTION("el_parse_factor_expr");
+	struct el_expr_stack * stack = &parser->expr_stack;
 	int err = 0;
-	if(el_is_lookahead(token_stream, el_NUMBER_LITERAL))
+	while(err == 0 && stack->num_frames > 0)
 	{
-		expression->type = el_AST_EXPR_NUMBER_LITERAL;
-		expression->number_literal = el_copy_lookahead(token_stream, allocator);
-		if(!expression->number_literal)
-			return el_ALLOCATION_ERROR;
-		err = err || el_match_token(token_stream, el_NUMBER_LITERAL);
+		struct el_expr_frame * frame = &stack->frames[stack->num_frames - 1];
+		if(frame->type != el_EXPR_FRAME_BINARY_OP || frame->binding_power <= binding_power)
+			break;
+
+		--stack->num_frames;
+		--stack->num_operands;
+		struct el_ast_expression ** lhs = &stack->operands[stack->num_operands - 1];
+		err = el_new_binary_op(parser->allocator, frame->expr_type, lhs[0], lhs[1], lhs);
 	}
-	else if(el_is_lookahead(token_stream, el_STRING_LITERAL))
-	{
-		expression->type = el_AST_EXPR_STRING_LITERAL;
-		expression->string_literal = el_copy_lookahead(token_stream, allocator);
-		if(!expression->string_literal)
-			return el_ALLOCATION_ERROR;
-		err = err || el_match_token(token_stream, el_STRING_LITERAL);
-	}
-	else if(el_is_lookahead(token_stream, el_IDENTIFIER))
-	{
-		err = err || el_parse_complex_identifier(token_stream, allocator, expression);
-	}
-	else if(el_is_lookahead(token_stream, el_PARENTHESIS_OPEN))
-	{
-		err = err || el_match_token(token_stream, el_PARENTHESIS_OPEN);
-		err = err || el_parse_expr(token_stream, allocator, expression);
-		err = err || el_match_token(token_stream, el_PARENTHESIS_CLOSE);
-	}
-	else if(el_is_lookahead(token_stream, el_SLICE_START))
+	return err;
+}
+
+static int el_push_expr_frame(struct el_parser * parser, int type, int binding_power, int expr_type, struct el_ast_expression * expression)
+{
+	struct el_expr_stack * stack = &parser->expr_stack;
+	if(stack->num_frames >= MAX_EXPR_STACK_DEPTH)
 	{
-		err = err || el_new_expr_list(allocator, expression, el_AST_EXPR_SLICE_LITERAL);
-		err = err || el_match_token(token_stream, el_SLICE_START);
-		err = err || el_parse_arguments(token_stream, allocator, expression->expression_list);
-		err = err || el_match_token(token_stream, el_SLICE_END);
+		fprintf(stderr, "Failed to parse expression, exceeded max nesting depth of %d\n", MAX_EXPR_STACK_DEPTH);
+		return el_EXCEEDED_EXPR_NESTING_LIMIT_PARSE_ERROR;
 	}
-	else
+
+	struct el_expr_frame * frame = &stack->frames[stack->num_frames++];
+	frame->type = type;
+	frame->binding_power = binding_power;
+	frame->expr_type = expr_type;
+	frame->expression = expression;
+	return 0;
+}
+
+static int el_push_expr_operand(struct el_parser * parser, struct el_ast_expression * operand)
+{
+	struct el_expr_stack * stack = &parser->expr_stack;
+	if(stack->num_operands >= MAX_EXPR_STACK_DEPTH)
 	{
-		fprintf(stderr, "Expected a factor expression\n");
-		return el_EXPECTED_FACTOR_EXPR_PARSE_ERROR;
+		fprintf(stderr, "Failed to parse expression, exceeded max nesting depth of %d\n", MAX_EXPR_STACK_DEPTH);
+		return el_EXCEEDED_EXPR_NESTING_LIMIT_PARSE_ERROR;
 	}
-	return err;
+
+	stack->operands[stack->num_operands++] = operand;
+	return 0;
 }
 
-int el_convert_to_binary_op(struct el_linear_allocator * allocator, struct el_ast_expression * expression, int type)
+// Allocate a binary op node which takes ownership of lhs and rhs, writing the new node to result
+static int el_new_binary_op(struct el_linear_allocator * allocator, int type, struct el_ast_expression * lhs, struct el_ast_expression * rhs, struct el_ast_expression ** result)
 {
-	struct el_ast_expression lhs = *expression;
-	expression->type = type;
-	expression->binary_op.lhs = el_linear_alloc(allocator, sizeof *expression);
-	expression->binary_op.rhs = el_linear_alloc(allocator, sizeof *expression);
-	if(!expression->binary_op.lhs || !expression->binary_op.rhs)
+	struct el_ast_expression * node = el_linear_alloc(allocator, sizeof *node);
+	if(!node)
 	{
 		// NOTE - Don't need to call ffree as ast will be freed on error
 		return el_ALLOCATION_ERROR;
 	}
-	*expression->binary_op.lhs = lhs;
+	node->type = type;
+	node->symbol = el_NO_SYMBOL;
+	node->type_id = el_NO_TYPE;
+	node->binary_op.lhs = lhs;
+	node->binary_op.rhs = rhs;
+	*result = node;
 	return 0;
 }
 
-int el_new_expr_list(struct el_linear_allocator * allocator, struct el_ast_expression * expression, int type)
+static int el_new_expr_list(struct el_linear_allocator * allocator, struct el_ast_expression * expression, int type)
 {
 	expression->type = type;
+	expression->symbol = el_NO_SYMBOL;
+	expression->type_id = el_NO_TYPE;
 	expression->expression_list = el_linear_alloc(allocator, sizeof(struct el_ast_expression_list));
 	if(!expression->expression_list)
 	{
 		return el_ALLOCATION_ERROR;
 	}
-	expression->expression_list->expressions = el_linear_alloc(allocator, sizeof(struct el_ast_expression) * MAX_NUM_EXPRS_PER_EXPR_LIST);
-	if(!expression->expression_list->expressions)
+	expression->expression_list->expressions = NULL;
+	expression->expression_list->max_num_expressions = 0;
+	expression->expression_list->num_expressions = 0;
+	return 0;
+}
+
+static int el_append_expr_list(struct el_linear_allocator * allocator, struct el_ast_expression_list * list, struct el_ast_expression * expression)
+{
+	struct el_ast_expression * item = el_vector_push(list, expressions, allocator);
+	if(!item)
 	{
 		// NOTE - Don't need to call ffree as ast will be freed on error
 		return el_ALLOCATION_ERROR;
 	}
-	expression->expression_list->max_num_expressions = MAX_NUM_EXPRS_PER_EXPR_LIST;
-	expression->expression_list->num_expressions = 0;
+	*item = *expression;
 	return 0;
 }
 
 // Match the current lookahead token to the type given
 // If the types do not match, a non-zero error code is returned
-static int el_match_token(struct el_token_stream * token_stream, int type)
+// The end of file token is never matched, so the lookahead can never run past the end of the stream
+static int el_match_token(struct el_parser * parser, int type)
 {
-	int lookahead = token_stream->tokens[token_stream->current_token].type;
-	if(lookahead == type)
+	if(parser->lookahead == type && type != el_END_OF_FILE)
 	{
+		struct el_token_stream * token_stream = parser->token_stream;
 	#if DEBUG_TOKEN_MATCHING
-		printf("Matched token: %d %s\n", type, token_stream->tokens[token_stream->current_token].source);
+		struct el_string_view source = token_stream->tokens[token_stream->current_token].source;
+		printf("Matched token: %d %.*s\n", type, source.length, source.data);
 	#endif
-		++token_stream->current_token;
+		parser->lookahead = token_stream->tokens[++token_stream->current_token].type;
 		return 0;
 	}
 
-	fprintf(stderr, "Failed to match token at lookahead index %d: expected %d, got %d\n", token_stream->current_token, type, lookahead);
+	fprintf(stderr, "Failed to match token at lookahead index %d: expected %d, got %d\n", parser->token_stream->current_token, type, parser->lookahead);
 	return el_MATCH_TOKEN_PARSE_ERROR;
 }
 
-static struct el_token * el_lookahead(struct el_token_stream * token_stream)
+static inline bool el_is_lookahead(struct el_parser * parser, int type)
 {
-	if(token_stream->current_token >= token_stream->num_tokens)
-	{
-		printf("Failed to get lookahead, ran out of tokens\n");
-		return NULL;
-	}
-
-	return &token_stream->tokens[token_stream->current_token];
+	return parser->lookahead == type;
 }
 
-static bool el_is_lookahead(struct el_token_stream * token_stream, int type)
+static inline bool el_is_lookahead_in(struct el_parser * parser, el_token_set set)
 {
-	if(token_stream->current_token >= token_stream->num_tokens)
-	{
-		printf("Failed to check lookahead type, ran out of tokens\n");
-		return false;
-	}
-
-	return token_stream->tokens[token_stream->current_token].type == type;
+	return (el_TOKEN_BIT(parser->lookahead) & set) != 0;
 }
 
-static el_string el_copy_lookahead(struct el_token_stream * token_stream, struct el_linear_allocator * allocator)
+static el_string el_copy_lookahead(struct el_parser * parser)
 {
-	el_string source = el_lookahead(token_stream)->source;
-	int num_bytes = el_string_byte_size(source);
-	void * memory = el_linear_alloc(allocator, num_bytes);
-	return el_string_inplace_new(memory, num_bytes, source, -1);
+	struct el_string_view source = parser->token_stream->tokens[parser->token_stream->current_token].source;
+	int num_bytes = source.length + sizeof(int) + 1;
+	void * memory = el_linear_alloc(parser->allocator, num_bytes);
+	return el_string_inplace_new(memory, num_bytes, source.data, source.length);
 }
@@ -2,5 +2,39 @@
 #include "ast.h"
 
 struct el_token_stream;
+struct el_text_file;
 
-struct el_ast el_parse_token_stream(struct el_token_stream * token_stream);
+enum el_parse_flags
+{
+	el_PARSE_DEFAULT = 0,
+
+	// Record the token range of each function body instead of parsing it
+	// Bodies are parsed on first access by el_parse_function_body
+	// The token stream must outlive the ast
+	el_PARSE_LAZY_FUNCTION_BODIES = 1 << 0,
+
+	// Parse top-level fnc and dat declarations concurrently on a thread pool
+	// Falls back to a serial parse for files too small to benefit
+	el_PARSE_PARALLEL = 1 << 1
+};
+
+struct el_ast el_parse_token_stream(struct el_token_stream * token_stream, int flags);
+
+// Parse the body of a function skipped by el_PARSE_LAZY_FUNCTION_BODIES into the ast's allocator
+// Does nothing if the body has already been parsed
+// Not thread safe, bodies of the same ast must not be parsed concurrently
+int el_parse_function_body(struct el_ast * ast, struct el_ast_function_definition * function_definition);
+
+struct el_text_edit
+{
+	int offset; // Byte offset in the source before any of the edits are applied
+	int num_removed_bytes;
+	char const * text; // Inserted in place of the removed bytes
+	int text_length;
+};
+
+// Apply edits to the source, then re-lex only the edited lines and re-parse only the top-level statements they overlap
+// Statements not touched by the edits keep their nodes, the replaced nodes stay in the ast's allocator until it is deleted
+// Edits must be sorted by offset and must not overlap
+// On failure the source and token stream hold the edited text but the ast must be parsed again in full
+int el_reparse_edits(struct el_ast * ast, struct el_token_stream * token_stream, struct el_text_file * f, struct el_text_edit const * edits, int num_edits);
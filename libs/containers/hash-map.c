@@ -0,0 +1,382 @@
+#include "hash-map.h"
+#include "string.h"
+#include <allocators/fmalloc.h>
+#include <allocators/linear-allocator.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EL_HASH_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define GROUP_WIDTH 16
+#define MIN_CAPACITY GROUP_WIDTH
+
+// Control bytes of full slots hold the low 7 bits of the hash, s.t. only empty and deleted slots are negative
+#define CTRL_EMPTY ((int8_t)-128)
+#define CTRL_DELETED ((int8_t)-2)
+
+static int el_hash_map_max_size(int capacity);
+static bool el_hash_map_alloc(struct el_hash_map * map, int capacity);
+static void el_hash_map_free(struct el_hash_map * map);
+static bool el_hash_map_grow(struct el_hash_map * map);
+static int el_hash_map_find_index(struct el_hash_map const * map, void const * key, uint64_t hash);
+static int el_hash_map_find_free_index(struct el_hash_map const * map, uint64_t hash);
+static void el_hash_map_set_control(struct el_hash_map * map, int index, int8_t control);
+
+static inline uint32_t el_group_match(int8_t const * group, int8_t h2);
+static inline uint32_t el_group_match_empty(int8_t const * group);
+static inline uint32_t el_group_match_empty_or_deleted(int8_t const * group);
+static inline int el_count_trailing_zeros(uint32_t bits);
+
+static inline int8_t el_hash_h2(uint64_t hash)
+{
+	return (int8_t)(hash & 0x7F);
+}
+
+static inline unsigned char * el_hash_map_slot(struct el_hash_map const * map, int index)
+{
+	return map->slots + (size_t)index * map->slot_size;
+}
+
+bool el_hash_map_new(struct el_hash_map * map, int key_size, int value_size, int capacity, el_hash_fn hash, el_equals_fn equals, struct el_linear_allocator * allocator)
+{
+	assert(map && key_size > 0 && value_size >= 0 && hash && equals);
+
+	// Keys and values are 8 byte aligned within slots
+	map->key_size = key_size;
+	map->value_offset = (key_size + 7) & ~7;
+	map->slot_size = (map->value_offset + value_size + 7) & ~7;
+	map->hash = hash;
+	map->equals = equals;
+	map->allocator = allocator;
+	map->size = 0;
+
+	int c = MIN_CAPACITY;
+	while(el_hash_map_max_size(c) < capacity)
+		c *= 2;
+
+	if(!el_hash_map_alloc(map, c))
+	{
+		map->control = NULL;
+		map->hashes = NULL;
+		map->slots = NULL;
+		map->capacity = 0;
+		map->growth_left = 0;
+		return false;
+	}
+	return true;
+}
+
+void el_hash_map_delete(struct el_hash_map * map)
+{
+	if(!map)
+		return;
+
+	el_hash_map_free(map);
+	map->control = NULL;
+	map->hashes = NULL;
+	map->slots = NULL;
+	map->capacity = 0;
+	map->size = 0;
+	map->growth_left = 0;
+}
+
+void * el_hash_map_find(struct el_hash_map const * map, void const * key)
+{
+	return el_hash_map_find_hashed(map, key, map->hash(key));
+}
+
+void * el_hash_map_find_hashed(struct el_hash_map const * map, void const * key, uint64_t hash)
+{
+	int index = el_hash_map_find_index(map, key, hash);
+	return index >= 0 ? el_hash_map_slot(map, index) + map->value_offset : NULL;
+}
+
+void * el_hash_map_insert(struct el_hash_map * map, void const * key, bool * inserted)
+{
+	return el_hash_map_insert_hashed(map, key, map->hash(key), inserted);
+}
+
+void * el_hash_map_insert_hashed(struct el_hash_map * map, void const * key, uint64_t hash, bool * inserted)
+{
+	if(inserted)
+		*inserted = false;
+
+	int index = el_hash_map_find_index(map, key, hash);
+	if(index >= 0)
+		return el_hash_map_slot(map, index) + map->value_offset;
+
+	if(map->growth_left == 0 && !el_hash_map_grow(map))
+		return NULL;
+
+	index = el_hash_map_find_free_index(map, hash);
+
+	// Reusing a deleted slot does not use up an empty one
+	if(map->control[index] == CTRL_EMPTY)
+		--map->growth_left;
+
+	el_hash_map_set_control(map, index, el_hash_h2(hash));
+	map->hashes[index] = hash;
+	++map->size;
+
+	unsigned char * slot = el_hash_map_slot(map, index);
+	memcpy(slot, key, map->key_size);
+	memset(slot + map->value_offset, 0, map->slot_size - map->value_offset);
+
+	if(inserted)
+		*inserted = true;
+	return slot + map->value_offset;
+}
+
+bool el_hash_map_remove(struct el_hash_map * map, void const * key)
+{
+	int index = el_hash_map_find_index(map, key, map->hash(key));
+	if(index < 0)
+		return false;
+
+	// The slot cannot be marked empty as that would end the probe of any key placed beyond it
+	el_hash_map_set_control(map, index, CTRL_DELETED);
+	--map->size;
+	return true;
+}
+
+bool el_hash_map_next(struct el_hash_map const * map, int * index, void ** key, void ** value)
+{
+	for(int i = *index; i < map->capacity; ++i)
+	{
+		if(map->control[i] >= 0)
+		{
+			unsigned char * slot = el_hash_map_slot(map, i);
+			if(key)
+				*key = slot;
+			if(value)
+				*value = slot + map->value_offset;
+			*index = i + 1;
+			return true;
+		}
+	}
+	*index = map->capacity;
+	return false;
+}
+
+void el_hash_map_clear(struct el_hash_map * map)
+{
+	if(map->capacity == 0)
+		return;
+
+	memset(map->control, CTRL_EMPTY, map->capacity + GROUP_WIDTH);
+	map->size = 0;
+	map->growth_left = el_hash_map_max_size(map->capacity);
+}
+
+// FNV-1a followed by a finalizer, s.t. both the low bits used by control bytes and the high bits used for probing are well mixed
+uint64_t el_hash_bytes(void const * data, size_t length)
+{
+	unsigned char const * bytes = data;
+	uint64_t hash = 14695981039346656037ULL;
+	for(size_t i = 0; i < length; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+uint64_t el_hash_string_key(void const * key)
+{
+	el_string s = *(el_string const *)key;
+	return el_hash_bytes(s, el_string_length(s));
+}
+
+bool el_string_key_equals(void const * key1, void const * key2)
+{
+	return el_string_equals(*(el_string const *)key1, *(el_string const *)key2);
+}
+
+// Maximum number of full and deleted slots in a map of the given capacity, a load factor of 7/8
+static int el_hash_map_max_size(int capacity)
+{
+	return capacity - capacity / 8;
+}
+
+// Allocate empty arrays for capacity slots
+// The group of control bytes past the end mirrors the first group, s.t. a group can be loaded from any slot without wrapping
+static bool el_hash_map_alloc(struct el_hash_map * map, int capacity)
+{
+	size_t hashes_size = sizeof(uint64_t) * capacity;
+	size_t slots_size = (size_t)map->slot_size * capacity;
+	size_t control_size = capacity + GROUP_WIDTH;
+	size_t size = hashes_size + slots_size + control_size;
+
+	unsigned char * memory;
+	if(map->allocator)
+	{
+		memory = el_linear_alloc(map->allocator, size + 7);
+		memory = memory ? (unsigned char *)(((uintptr_t)memory + 7) & ~(uintptr_t)7) : NULL;
+	}
+	else
+	{
+		memory = fmalloc(size);
+	}
+
+	if(!memory)
+		return false;
+
+	map->hashes = (uint64_t *)memory;
+	map->slots = memory + hashes_size;
+	map->control = (int8_t *)(memory + hashes_size + slots_size);
+	map->capacity = capacity;
+	map->growth_left = el_hash_map_max_size(capacity) - map->size;
+	memset(map->control, CTRL_EMPTY, control_size);
+	return true;
+}
+
+static void el_hash_map_free(struct el_hash_map * map)
+{
+	if(!map->allocator)
+		ffree(map->hashes);
+}
+
+// Move every entry into new arrays, doubling the capacity unless most used slots are deleted ones
+static bool el_hash_map_grow(struct el_hash_map * map)
+{
+	struct el_hash_map old = *map;
+	int capacity = map->size * 2 > el_hash_map_max_size(map->capacity) ? map->capacity * 2 : map->capacity;
+	if(!el_hash_map_alloc(map, capacity))
+	{
+		*map = old;
+		return false;
+	}
+
+	// Stored hashes are reused and keys need not be compared as they are known to be unique
+	for(int i = 0; i < old.capacity; ++i)
+	{
+		if(old.control[i] < 0)
+			continue;
+
+		int index = el_hash_map_find_free_index(map, old.hashes[i]);
+		el_hash_map_set_control(map, index, old.control[i]);
+		map->hashes[index] = old.hashes[i];
+		memcpy(el_hash_map_slot(map, index), el_hash_map_slot(&old, i), map->slot_size);
+	}
+
+	el_hash_map_free(&old);
+	return true;
+}
+
+// Probe a group at a time until the key is found or a group with an empty slot ends the probe
+static int el_hash_map_find_index(struct el_hash_map const * map, void const * key, uint64_t hash)
+{
+	if(map->capacity == 0)
+		return -1;
+
+	int8_t h2 = el_hash_h2(hash);
+	size_t mask = map->capacity - 1;
+	size_t pos = (hash >> 7) & mask;
+	for(size_t stride = GROUP_WIDTH;; stride += GROUP_WIDTH)
+	{
+		int8_t const * group = map->control + pos;
+		for(uint32_t matches = el_group_match(group, h2); matches; matches &= matches - 1)
+		{
+			int index = (int)((pos + el_count_trailing_zeros(matches)) & mask);
+			if(map->hashes[index] == hash && map->equals(key, el_hash_map_slot(map, index)))
+				return index;
+		}
+
+		if(el_group_match_empty(group))
+			return -1;
+
+		pos = (pos + stride) & mask;
+	}
+}
+
+// The load factor guarantees an empty slot, s.t. the probe always ends
+static int el_hash_map_find_free_index(struct el_hash_map const * map, uint64_t hash)
+{
+	size_t mask = map->capacity - 1;
+	size_t pos = (hash >> 7) & mask;
+	for(size_t stride = GROUP_WIDTH;; stride += GROUP_WIDTH)
+	{
+		uint32_t matches = el_group_match_empty_or_deleted(map->control + pos);
+		if(matches)
+			return (int)((pos + el_count_trailing_zeros(matches)) & mask);
+
+		pos = (pos + stride) & mask;
+	}
+}
+
+static void el_hash_map_set_control(struct el_hash_map * map, int index, int8_t control)
+{
+	map->control[index] = control;
+	if(index < GROUP_WIDTH)
+		map->control[map->capacity + index] = control;
+}
+
+#ifdef EL_HASH_MAP_SSE2
+
+static inline uint32_t el_group_match(int8_t const * group, int8_t h2)
+{
+	__m128i control = _mm_loadu_si128((__m128i const *)group);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(h2)));
+}
+
+static inline uint32_t el_group_match_empty(int8_t const * group)
+{
+	__m128i control = _mm_loadu_si128((__m128i const *)group);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(CTRL_EMPTY)));
+}
+
+static inline uint32_t el_group_match_empty_or_deleted(int8_t const * group)
+{
+	// Only empty and deleted control bytes have their sign bit set
+	__m128i control = _mm_loadu_si128((__m128i const *)group);
+	return (uint32_t)_mm_movemask_epi8(control);
+}
+
+#else
+
+static inline uint32_t el_group_match(int8_t const * group, int8_t h2)
+{
+	uint32_t matches = 0;
+	for(int i = 0; i < GROUP_WIDTH; ++i)
+		matches |= (uint32_t)(group[i] == h2) << i;
+	return matches;
+}
+
+static inline uint32_t el_group_match_empty(int8_t const * group)
+{
+	return el_group_match(group, CTRL_EMPTY);
+}
+
+static inline uint32_t el_group_match_empty_or_deleted(int8_t const * group)
+{
+	uint32_t matches = 0;
+	for(int i = 0; i < GROUP_WIDTH; ++i)
+		matches |= (uint32_t)(group[i] < 0) << i;
+	return matches;
+}
+
+#endif
+
+static inline int el_count_trailing_zeros(uint32_t bits)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return (int)index;
+#else
+	return __builtin_ctz(bits);
+#endif
+}
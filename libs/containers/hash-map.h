@@ -0,0 +1,67 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+struct el_linear_allocator;
+
+typedef uint64_t (*el_hash_fn)(void const * key);
+typedef bool (*el_equals_fn)(void const * key1, void const * key2);
+
+// Open-addressing hash map of fixed size keys and values
+// Each slot has a control byte, stored apart from the slots, holding 7 bits of its key's hash or marking it empty or deleted
+// A lookup compares a group of 16 control bytes at a time (with SSE2 where available) and only touches slots whose bits match
+// The full hash of every key is stored s.t. growing the map never rehashes a key
+struct el_hash_map
+{
+	int8_t * control;
+	uint64_t * hashes;
+	unsigned char * slots; // Key followed by value
+
+	int key_size;
+	int value_offset;
+	int slot_size;
+
+	int capacity; // Power of 2
+	int size;
+	int growth_left; // Number of inserts before the map must grow
+
+	el_hash_fn hash;
+	el_equals_fn equals;
+
+	// Backing memory, fmalloc if NULL
+	// Memory of a map backed by an allocator is only reclaimed when the allocator is reset
+	struct el_linear_allocator * allocator;
+};
+
+// Create an empty map
+// capacity is the number of entries the map can hold without growing, may be 0
+bool el_hash_map_new(struct el_hash_map * map, int key_size, int value_size, int capacity, el_hash_fn hash, el_equals_fn equals, struct el_linear_allocator * allocator);
+
+void el_hash_map_delete(struct el_hash_map * map);
+
+// Returns the value of key or NULL if it is not in the map
+void * el_hash_map_find(struct el_hash_map const * map, void const * key);
+void * el_hash_map_find_hashed(struct el_hash_map const * map, void const * key, uint64_t hash);
+
+// Returns the value of key, inserting key with a zeroed value if it is not in the map
+// Returns NULL if the map failed to grow
+// The returned pointer is invalidated by the next insert
+void * el_hash_map_insert(struct el_hash_map * map, void const * key, bool * inserted);
+void * el_hash_map_insert_hashed(struct el_hash_map * map, void const * key, uint64_t hash, bool * inserted);
+
+// Returns false if key is not in the map
+bool el_hash_map_remove(struct el_hash_map * map, void const * key);
+
+// Iterate the entries of the map in slot order, starting with *index set to 0
+// Returns false once there are no more entries
+bool el_hash_map_next(struct el_hash_map const * map, int * index, void ** key, void ** value);
+
+void el_hash_map_clear(struct el_hash_map * map);
+
+// 64-bit hash of length bytes of data
+uint64_t el_hash_bytes(void const * data, size_t length);
+
+// Hash and equals functions for maps keyed by el_string
+uint64_t el_hash_string_key(void const * key);
+bool el_string_key_equals(void const * key1, void const * key2);
@@ -0,0 +1,244 @@
+#include "string-builder.h"
+#include "vector.h"
+#include <allocators/fmalloc.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define MAX_NUM_FLOAT_DECIMALS 18
+#define MAX_UINT_DIGITS 20
+
+static char const digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static unsigned long long const powers_of_10[MAX_NUM_FLOAT_DECIMALS + 1] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+	10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+	1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL
+};
+
+bool el_string_builder_new(struct el_string_builder * sb, int capacity)
+{
+	assert(sb && capacity >= 0);
+	sb->chars = NULL;
+	sb->max_num_chars = 0;
+	sb->num_chars = 0;
+	return el_string_builder_reserve(sb, capacity);
+}
+
+void el_string_builder_delete(struct el_string_builder * sb)
+{
+	if(sb)
+	{
+		el_vector_free(sb, chars, NULL);
+	}
+}
+
+void el_string_builder_clear(struct el_string_builder * sb)
+{
+	sb->num_chars = 0;
+	if(sb->chars)
+	{
+		sb->chars[0] = '\0';
+	}
+}
+
+bool el_string_builder_reserve(struct el_string_builder * sb, int num_bytes)
+{
+	// One more byte is always kept for the null terminator
+	if(!el_vector_reserve(sb, chars, sb->num_chars + num_bytes + 1, NULL))
+	{
+		return false;
+	}
+	sb->chars[sb->num_chars] = '\0';
+	return true;
+}
+
+bool el_string_builder_append(struct el_string_builder * sb, char const * s, int length)
+{
+	assert(s || length == 0);
+	if(!el_string_builder_reserve(sb, length))
+	{
+		return false;
+	}
+	memcpy(sb->chars + sb->num_chars, s, length);
+	sb->num_chars += length;
+	sb->chars[sb->num_chars] = '\0';
+	return true;
+}
+
+bool el_string_builder_append_cstr(struct el_string_builder * sb, char const * s)
+{
+	return el_string_builder_append(sb, s, (int)strlen(s));
+}
+
+bool el_string_builder_append_view(struct el_string_builder * sb, struct el_string_view v)
+{
+	return el_string_builder_append(sb, v.data, v.length);
+}
+
+bool el_string_builder_append_char(struct el_string_builder * sb, char c)
+{
+	return el_string_builder_append(sb, &c, 1);
+}
+
+bool el_string_builder_append_chars(struct el_string_builder * sb, char c, int count)
+{
+	if(!el_string_builder_reserve(sb, count))
+	{
+		return false;
+	}
+	memset(sb->chars + sb->num_chars, c, count);
+	sb->num_chars += count;
+	sb->chars[sb->num_chars] = '\0';
+	return true;
+}
+
+bool el_string_builder_append_int(struct el_string_builder * sb, long long value)
+{
+	char buffer[MAX_UINT_DIGITS + 1];
+	int length = 0;
+
+	// Negating as unsigned s.t. the most negative value does not overflow
+	unsigned long long magnitude = (unsigned long long)value;
+	if(value < 0)
+	{
+		buffer[length++] = '-';
+		magnitude = 0ULL - magnitude;
+	}
+	length += el_format_uint(magnitude, buffer + length);
+	return el_string_builder_append(sb, buffer, length);
+}
+
+bool el_string_builder_append_uint(struct el_string_builder * sb, unsigned long long value)
+{
+	char buffer[MAX_UINT_DIGITS];
+	int length = el_format_uint(value, buffer);
+	return el_string_builder_append(sb, buffer, length);
+}
+
+bool el_string_builder_append_float(struct el_string_builder * sb, double value, int num_decimals)
+{
+	// NaN is the only value not equal to itself and infinities are the only others which subtract to non-zero
+	if(value != value)
+	{
+		return el_string_builder_append_cstr(sb, "nan");
+	}
+	if(value - value != 0)
+	{
+		return el_string_builder_append_cstr(sb, value < 0 ? "-inf" : "inf");
+	}
+
+	num_decimals = num_decimals < 0 ? 0 : num_decimals;
+	num_decimals = num_decimals > MAX_NUM_FLOAT_DECIMALS ? MAX_NUM_FLOAT_DECIMALS : num_decimals;
+
+	// The value is written as an integer number of units of the last decimal place, s.t. it must fit in 64 bits
+	double magnitude = value < 0 ? -value : value;
+	double scaled = magnitude * (double)powers_of_10[num_decimals] + 0.5;
+	if(scaled >= 18446744073709551615.0)
+	{
+		return el_string_builder_appendf(sb, "%.*e", num_decimals, value);
+	}
+
+	unsigned long long units = (unsigned long long)scaled;
+	unsigned long long integer = units / powers_of_10[num_decimals];
+	unsigned long long fraction = units % powers_of_10[num_decimals];
+
+	char buffer[1 + MAX_UINT_DIGITS + 1 + MAX_NUM_FLOAT_DECIMALS];
+	int length = 0;
+	if(value < 0 && units > 0)
+	{
+		buffer[length++] = '-';
+	}
+	length += el_format_uint(integer, buffer + length);
+
+	if(num_decimals > 0)
+	{
+		// Leading zeros of the fraction are padded in before its digits
+		char digits[MAX_UINT_DIGITS];
+		int num_digits = fraction > 0 ? el_format_uint(fraction, digits) : 0;
+		buffer[length++] = '.';
+		memset(buffer + length, '0', num_decimals - num_digits);
+		length += num_decimals - num_digits;
+		memcpy(buffer + length, digits, num_digits);
+		length += num_digits;
+	}
+	return el_string_builder_append(sb, buffer, length);
+}
+
+bool el_string_builder_appendf(struct el_string_builder * sb, char const * format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	va_list retry_args;
+	va_copy(retry_args, args);
+
+	// Most formats fit in the spare capacity, otherwise the builder grows to the exact size and formats again
+	int spare = sb->max_num_chars - sb->num_chars;
+	int length = vsnprintf(spare > 0 ? sb->chars + sb->num_chars : NULL, spare > 0 ? spare : 0, format, args);
+	va_end(args);
+
+	bool appended = length >= 0;
+	if(appended && length >= spare)
+	{
+		appended = el_string_builder_reserve(sb, length);
+		if(appended)
+		{
+			vsnprintf(sb->chars + sb->num_chars, length + 1, format, retry_args);
+		}
+	}
+	va_end(retry_args);
+
+	if(appended)
+	{
+		sb->num_chars += length;
+	}
+	else if(sb->chars)
+	{
+		sb->chars[sb->num_chars] = '\0';
+	}
+	return appended;
+}
+
+el_string el_string_builder_to_string(struct el_string_builder const * sb)
+{
+	return el_string_new(sb->chars ? sb->chars : "", sb->num_chars);
+}
+
+int el_format_uint(unsigned long long value, char * buffer)
+{
+	// Digits are produced two at a time from the end of a scratch buffer
+	char digits[MAX_UINT_DIGITS];
+	int i = MAX_UINT_DIGITS;
+	while(value >= 100)
+	{
+		int pair = (int)(value % 100) * 2;
+		value /= 100;
+		digits[--i] = digit_pairs[pair + 1];
+		digits[--i] = digit_pairs[pair];
+	}
+	if(value >= 10)
+	{
+		int pair = (int)value * 2;
+		digits[--i] = digit_pairs[pair + 1];
+		digits[--i] = digit_pairs[pair];
+	}
+	else
+	{
+		digits[--i] = (char)('0' + value);
+	}
+
+	int length = MAX_UINT_DIGITS - i;
+	memcpy(buffer, digits + i, length);
+	return length;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "string.h"
+#include "string-view.h"
+#include <stdbool.h>
+
+// A growable, null terminated run of chars
+// Capacity grows geometrically s.t. building a string of n bytes from small appends is O(n)
+// Appends return false if the builder failed to grow, leaving its contents unchanged
+struct el_string_builder
+{
+	char * chars;
+	int max_num_chars; // Includes space for the null terminator
+	int num_chars;
+};
+
+// capacity is the number of bytes the builder can hold before it first grows, may be 0
+bool el_string_builder_new(struct el_string_builder * sb, int capacity);
+
+void el_string_builder_delete(struct el_string_builder * sb);
+
+// Empty the builder but keep its capacity
+void el_string_builder_clear(struct el_string_builder * sb);
+
+// Ensure num_bytes more bytes can be appended without growing
+bool el_string_builder_reserve(struct el_string_builder * sb, int num_bytes);
+
+bool el_string_builder_append(struct el_string_builder * sb, char const * s, int length);
+bool el_string_builder_append_cstr(struct el_string_builder * sb, char const * s);
+bool el_string_builder_append_view(struct el_string_builder * sb, struct el_string_view v);
+bool el_string_builder_append_char(struct el_string_builder * sb, char c);
+bool el_string_builder_append_chars(struct el_string_builder * sb, char c, int count);
+
+// Integers and floats are formatted directly, without parsing a printf format
+bool el_string_builder_append_int(struct el_string_builder * sb, long long value);
+bool el_string_builder_append_uint(struct el_string_builder * sb, unsigned long long value);
+
+// Fixed point with num_decimals digits after the point, rounded half away from zero
+// Values too large for fixed point are written in exponent form
+bool el_string_builder_append_float(struct el_string_builder * sb, double value, int num_decimals);
+
+// printf style formatting, written straight into the builder's memory
+bool el_string_builder_appendf(struct el_string_builder * sb, char const * format, ...);
+
+static inline struct el_string_view el_string_builder_view(struct el_string_builder const * sb)
+{
+	return el_string_view_new(sb->chars ? sb->chars : "", sb->num_chars);
+}
+
+// Copy the contents into a new el_string, which must be deleted with el_string_delete
+el_string el_string_builder_to_string(struct el_string_builder const * sb);
+
+// Format value into buffer, which must hold at least 20 bytes, and return the number of digits written
+// The digits are not null terminated
+int el_format_uint(unsigned long long value, char * buffer);
@@ -0,0 +1,86 @@
+#include "string-view.h"
+#include "hash-map.h"
+#include <assert.h>
+#include <string.h>
+
+struct el_string_view el_string_view_of(el_string s)
+{
+	assert(s);
+	return el_string_view_new(s, el_string_length(s));
+}
+
+struct el_string_view el_string_view_substring(struct el_string_view v, int start, int length)
+{
+	if(start < 0)
+	{
+		start = 0;
+	}
+	if(start > v.length)
+	{
+		start = v.length;
+	}
+	if(length < 0 || length > v.length - start)
+	{
+		length = v.length - start;
+	}
+	return el_string_view_new(v.data + start, length);
+}
+
+struct el_string_view el_string_view_strip(struct el_string_view v)
+{
+	int start = 0;
+	int end = v.length;
+	while(start < end && (v.data[start] == ' ' || v.data[start] == '\t'))
+	{
+		++start;
+	}
+	while(end > start && (v.data[end - 1] == ' ' || v.data[end - 1] == '\t'))
+	{
+		--end;
+	}
+	return el_string_view_new(v.data + start, end - start);
+}
+
+bool el_string_view_split(struct el_string_view * rest, char separator, struct el_string_view * piece)
+{
+	assert(rest && piece);
+	if(rest->length == 0)
+	{
+		return false;
+	}
+
+	char const * found = memchr(rest->data, separator, rest->length);
+	int length = found ? (int)(found - rest->data) : rest->length;
+	*piece = el_string_view_new(rest->data, length);
+
+	// The separator itself belongs to neither side
+	int consumed = found ? length + 1 : length;
+	*rest = el_string_view_new(rest->data + consumed, rest->length - consumed);
+	return true;
+}
+
+bool el_string_view_equals(struct el_string_view v1, struct el_string_view v2)
+{
+	return v1.length == v2.length && (v1.data == v2.data || memcmp(v1.data, v2.data, v1.length) == 0);
+}
+
+bool el_string_view_equals_cstr(struct el_string_view v, char const * s)
+{
+	assert(s);
+	return strncmp(v.data, s, v.length) == 0 && s[v.length] == '\0';
+}
+
+uint64_t el_string_view_hash(struct el_string_view v)
+{
+	return el_hash_bytes(v.data, v.length);
+}
+
+struct el_hashed_string_view el_hashed_string_view_new(struct el_string_view v)
+{
+	return (struct el_hashed_string_view){ v, el_string_view_hash(v) };
+}
+
+bool el_hashed_string_view_equals(struct el_hashed_string_view const * v1, struct el_hashed_string_view const * v2)
+{
+	return v1->hash == v2->hash && el_string_view_equals(v1->view, v2->view);
+}
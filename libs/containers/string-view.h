@@ -0,0 +1,50 @@
+#pragma once
+#include "string.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// A non-owning span of length bytes, which need not be null terminated
+// Views never allocate, so they are only valid while the memory they refer to is
+struct el_string_view
+{
+	char const * data;
+	int length;
+};
+
+// A view along with the hash of its bytes, s.t. repeated lookups and comparisons need not rehash
+struct el_hashed_string_view
+{
+	struct el_string_view view;
+	uint64_t hash;
+};
+
+static inline struct el_string_view el_string_view_new(char const * data, int length)
+{
+	return (struct el_string_view){ data, length };
+}
+
+// View the whole of an el_string
+struct el_string_view el_string_view_of(el_string s);
+
+// View the length bytes from start, clamped to the view
+struct el_string_view el_string_view_substring(struct el_string_view v, int start, int length);
+
+// View without leading and trailing spaces and tabs
+struct el_string_view el_string_view_strip(struct el_string_view v);
+
+// Split off the bytes up to the next separator into piece, leaving the bytes after it in rest
+// Returns false once rest is empty
+bool el_string_view_split(struct el_string_view * rest, char separator, struct el_string_view * piece);
+
+// Lengths are compared before any bytes
+bool el_string_view_equals(struct el_string_view v1, struct el_string_view v2);
+
+// True if the view holds exactly the bytes of the null terminated string s
+bool el_string_view_equals_cstr(struct el_string_view v, char const * s);
+
+uint64_t el_string_view_hash(struct el_string_view v);
+
+struct el_hashed_string_view el_hashed_string_view_new(struct el_string_view v);
+
+// Hashes are compared before lengths and bytes
+bool el_hashed_string_view_equals(struct el_hashed_string_view const * v1, struct el_hashed_string_view const * v2);
@@ -1,4 +1,5 @@
 #include "string.h"
+#include "string-view.h"
 #include <allocators/fmalloc.h>
 #include <assert.h>
 #include <string.h>
@@ -21,7 +22,7 @@ el_string el_string_new(char const * c, int length)
 
 	if(c != NULL)
 	{
-		memcpy(contents, c, (size_t)length + 1);
+		memcpy(contents, c, (size_t)length);
 	}
 
 	contents[length] = '\0';
@@ -50,7 +51,7 @@ el_string el_string_inplace_new(char * restrict dst, int dst_size, char const *
 
 	if(c != NULL)
 	{
-		memcpy(contents, c, (size_t)length + 1);
+		memcpy(contents, c, (size_t)length);
 	}
 
 	contents[length] = '\0';
@@ -81,7 +82,7 @@ int el_string_byte_size(el_string s)
 bool el_string_equals(el_string s1, el_string s2)
 {
 	assert(s1 && s2);
-	return strcmp(s1, s2) == 0;
+	return el_string_view_equals(el_string_view_of(s1), el_string_view_of(s2));
 }
 
 void el_string_shrink(el_string s, int length)
@@ -97,26 +98,6 @@ void el_string_shrink(el_string s, int length)
 el_string el_string_strip(el_string s)
 {
 	assert(s);
-	char const * start = s;
-	char const * end = start + el_string_length(s) - 1;
-
-	// Find first non-whitespace character
-	for(; start < end; ++start)
-	{
-		if(*start != ' ' && *start != '\t')
-		{
-			break;
-		}
-	}
-
-	// Find last non-whitespace character
-	for(; end > start; --end)
-	{
-		if(*end != ' ' && *end != '\t')
-		{
-			break;
-		}
-	}
-
-	return el_string_new(start, (int)(end - start + 1));
+	struct el_string_view stripped = el_string_view_strip(el_string_view_of(s));
+	return el_string_new(stripped.data, stripped.length);
 }
@@ -22,8 +22,10 @@ int el_string_length(el_string s);
 // The underlying memory allocated for the string is at least this large
 int el_string_byte_size(el_string s);
 
+// Lengths are compared before any bytes
 bool el_string_equals(el_string s1, el_string s2);
 
 void el_string_shrink(el_string s, int length);
 
+// Returns a new string, see el_string_view_strip to strip without allocating
 el_string el_string_strip(el_string s);
@@ -0,0 +1,97 @@
+#include "vector.h"
+#include <allocators/fmalloc.h>
+#include <allocators/linear-allocator.h>
+#include <string.h>
+#include <assert.h>
+
+#define MIN_VECTOR_CAPACITY 4
+
+static bool el_vector_resize(void ** items, int * max_num_items, int num_items, int capacity, size_t item_size, struct el_linear_allocator * allocator);
+static bool el_vector_is_last_allocation(void * items, int max_num_items, size_t item_size, struct el_linear_allocator * allocator);
+
+bool el_vector_reserve_items(void ** items, int * max_num_items, int num_items, int min_num_items, size_t item_size, struct el_linear_allocator * allocator)
+{
+	assert(items && max_num_items && num_items <= *max_num_items);
+	if(min_num_items <= *max_num_items)
+		return true;
+
+	int capacity = *max_num_items > MIN_VECTOR_CAPACITY ? *max_num_items : MIN_VECTOR_CAPACITY;
+	while(capacity < min_num_items)
+		capacity *= 2;
+
+	return el_vector_resize(items, max_num_items, num_items, capacity, item_size, allocator);
+}
+
+bool el_vector_shrink_items(void ** items, int * max_num_items, int num_items, size_t item_size, struct el_linear_allocator * allocator)
+{
+	assert(items && max_num_items && num_items <= *max_num_items);
+	if(num_items == *max_num_items)
+		return true;
+
+	if(num_items == 0)
+	{
+		el_vector_free_items(items, max_num_items, item_size, allocator);
+		return true;
+	}
+	return el_vector_resize(items, max_num_items, num_items, num_items, item_size, allocator);
+}
+
+void el_vector_free_items(void ** items, int * max_num_items, size_t item_size, struct el_linear_allocator * allocator)
+{
+	assert(items && max_num_items);
+	if(!allocator)
+	{
+		ffree(*items);
+	}
+	else if(el_vector_is_last_allocation(*items, *max_num_items, item_size, allocator))
+	{
+		allocator->size -= item_size * *max_num_items;
+	}
+	*items = NULL;
+	*max_num_items = 0;
+}
+
+static bool el_vector_resize(void ** items, int * max_num_items, int num_items, int capacity, size_t item_size, struct el_linear_allocator * allocator)
+{
+	if(!allocator)
+	{
+		void * resized = frealloc(*items, item_size * capacity);
+		if(!resized)
+			return false;
+
+		*items = resized;
+		*max_num_items = capacity;
+		return true;
+	}
+
+	// The most recent allocation in an arena can grow or shrink in place
+	if(el_vector_is_last_allocation(*items, *max_num_items, item_size, allocator))
+	{
+		size_t size = allocator->size - item_size * *max_num_items + item_size * capacity;
+		if(size <= allocator->capacity)
+		{
+			allocator->size = size;
+			*max_num_items = capacity;
+			return true;
+		}
+	}
+
+	// Memory elsewhere in an arena cannot be released, so shrinking it does nothing
+	if(capacity <= *max_num_items)
+		return true;
+
+	void * resized = el_linear_alloc(allocator, item_size * capacity);
+	if(!resized)
+		return false;
+
+	if(num_items > 0)
+		memcpy(resized, *items, item_size * num_items);
+	*items = resized;
+	*max_num_items = capacity;
+	return true;
+}
+
+static bool el_vector_is_last_allocation(void * items, int max_num_items, size_t item_size, struct el_linear_allocator * allocator)
+{
+	return items && (unsigned char *)items + item_size * max_num_items == allocator->memory + allocator->size;
+}
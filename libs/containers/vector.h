@@ -0,0 +1,40 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+struct el_linear_allocator;
+
+// Vectors are any struct with an items pointer and num_ and max_num_ counts named after it, e.g.
+//   struct el_ast_parameter_list { struct el_ast_var_decl * parameters; int max_num_parameters; int num_parameters; };
+// The macros below take the vector and the name of its items member
+// Items are allocated from allocator, or with fmalloc if it is NULL, and a vector must always be given the same allocator
+// Growing a vector moves its items, s.t. pointers to them are invalidated
+// The vector argument may be evaluated more than once
+
+// Declare the members of a vector of type named items
+#define el_VECTOR_MEMBERS(type, items) type * items; int max_num_##items; int num_##items
+
+// Returns a pointer to a new uninitialised item at the end of the vector, or NULL if the vector failed to grow
+#define el_vector_push(vector, items, allocator) \
+	(((vector)->num_##items < (vector)->max_num_##items \
+		|| el_vector_reserve_items((void **)&(vector)->items, &(vector)->max_num_##items, (vector)->num_##items, (vector)->num_##items + 1, sizeof *(vector)->items, (allocator))) \
+		? &(vector)->items[(vector)->num_##items++] : NULL)
+
+// Ensure the vector can hold num_items items without growing, returns false if it failed to grow
+#define el_vector_reserve(vector, items, num_items, allocator) \
+	el_vector_reserve_items((void **)&(vector)->items, &(vector)->max_num_##items, (vector)->num_##items, (num_items), sizeof *(vector)->items, (allocator))
+
+// Release capacity beyond the number of items
+// Capacity of a vector backed by an allocator is only released if it is the allocator's most recent allocation
+#define el_vector_shrink_to_fit(vector, items, allocator) \
+	el_vector_shrink_items((void **)&(vector)->items, &(vector)->max_num_##items, (vector)->num_##items, sizeof *(vector)->items, (allocator))
+
+// Release all items, leaving an empty vector
+#define el_vector_free(vector, items, allocator) \
+	(el_vector_free_items((void **)&(vector)->items, &(vector)->max_num_##items, sizeof *(vector)->items, (allocator)), (vector)->num_##items = 0)
+
+// Untyped implementations of the macros above
+// Capacity doubles s.t. pushes are amortised constant time
+bool el_vector_reserve_items(void ** items, int * max_num_items, int num_items, int min_num_items, size_t item_size, struct el_linear_allocator * allocator);
+bool el_vector_shrink_items(void ** items, int * max_num_items, int num_items, size_t item_size, struct el_linear_allocator * allocator);
+void el_vector_free_items(void ** items, int * max_num_items, size_t item_size, struct el_linear_allocator * allocator);
@@ -0,0 +1,100 @@
+#include "buffered-writer.h"
+#include <allocators/fmalloc.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#ifdef SYSTEM_WINDOWS
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+#define BUFFERED_WRITER_DEFAULT_CAPACITY (64 * 1024) // 64KiB
+
+static bool el_write_fd(int fd, char const * data, int length);
+
+bool el_buffered_writer_new(struct el_buffered_writer * w, int fd, int capacity)
+{
+	assert(w && capacity >= 0);
+	w->fd = fd;
+	w->capacity = capacity > 0 ? capacity : BUFFERED_WRITER_DEFAULT_CAPACITY;
+	w->size = 0;
+	w->buffer = fmalloc(w->capacity);
+	w->failed = !w->buffer;
+	return !w->failed;
+}
+
+bool el_buffered_writer_delete(struct el_buffered_writer * w)
+{
+	if(!w)
+		return false;
+
+	bool flushed = el_buffered_writer_flush(w);
+	ffree(w->buffer);
+	w->buffer = NULL;
+	w->capacity = 0;
+	return flushed;
+}
+
+bool el_buffered_writer_write(struct el_buffered_writer * w, char const * data, int length)
+{
+	assert(w && (data || length == 0));
+	if(w->failed)
+		return false;
+
+	if(length > w->capacity - w->size)
+	{
+		if(!el_buffered_writer_flush(w))
+			return false;
+
+		// The buffer would only add a copy to a write this large
+		if(length >= w->capacity)
+		{
+			w->failed = !el_write_fd(w->fd, data, length);
+			return !w->failed;
+		}
+	}
+
+	memcpy(w->buffer + w->size, data, length);
+	w->size += length;
+	return true;
+}
+
+bool el_buffered_writer_write_cstr(struct el_buffered_writer * w, char const * s)
+{
+	return el_buffered_writer_write(w, s, (int)strlen(s));
+}
+
+bool el_buffered_writer_flush(struct el_buffered_writer * w)
+{
+	assert(w);
+	if(!w->failed && w->size > 0)
+	{
+		w->failed = !el_write_fd(w->fd, w->buffer, w->size);
+	}
+	w->size = 0;
+	return !w->failed;
+}
+
+static bool el_write_fd(int fd, char const * data, int length)
+{
+	// Writes may be cut short by signals or by pipes and sockets taking only part of the data
+	while(length > 0)
+	{
+#ifdef SYSTEM_WINDOWS
+		int written = _write(fd, data, (unsigned int)length);
+#else
+		int written = (int)write(fd, data, (size_t)length);
+#endif
+		if(written < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			return false;
+		}
+		data += written;
+		length -= written;
+	}
+	return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <containers/string-view.h>
+#include <stdbool.h>
+
+// Collects small writes in memory and passes them on to a file descriptor in large blocks
+// Once a write to the descriptor fails the writer discards everything written to it and reports the failure
+struct el_buffered_writer
+{
+	int fd;
+	char * buffer;
+	int capacity;
+	int size;
+	bool failed;
+};
+
+// capacity is the size of the buffer in bytes, or 0 for the default of 64KiB
+// The writer does not own fd, which is left open when the writer is deleted
+bool el_buffered_writer_new(struct el_buffered_writer * w, int fd, int capacity);
+
+// Flush and free the writer, returns false if any write to the descriptor failed
+bool el_buffered_writer_delete(struct el_buffered_writer * w);
+
+// Writes at least as large as the buffer skip it and go straight to the descriptor
+bool el_buffered_writer_write(struct el_buffered_writer * w, char const * data, int length);
+bool el_buffered_writer_write_cstr(struct el_buffered_writer * w, char const * s);
+
+static inline bool el_buffered_writer_write_view(struct el_buffered_writer * w, struct el_string_view v)
+{
+	return el_buffered_writer_write(w, v.data, v.length);
+}
+
+static inline bool el_buffered_writer_write_char(struct el_buffered_writer * w, char c)
+{
+	if(w->size < w->capacity)
+	{
+		w->buffer[w->size++] = c;
+		return !w->failed;
+	}
+	return el_buffered_writer_write(w, &c, 1);
+}
+
+// Pass everything buffered on to the descriptor
+bool el_buffered_writer_flush(struct el_buffered_writer * w);
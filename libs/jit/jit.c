@@ -0,0 +1,2131 @@
+#include "jit.h"
+#include "x64-encoder.h"
+#include "linear-scan.h"
+#include <vm/vm-kernels.h>
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <compiler/semantic-analysis/type-table.h>
+#include <threads/thread-pool.h>
+#include <stdio.h>
+#include <limits.h>
+#include <string.h>
+#include <setjmp.h>
+#include <assert.h>
+
+// The code generator follows the System V calling convention, which Windows does not use
+// Compiled code finds its thread's stack limit through the fs segment, as ELF lays out thread local storage
+#if defined(__x86_64__) && defined(__ELF__) && !defined(SYSTEM_WINDOWS)
+#define el_JIT_SUPPORTED
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+// Values per heap chunk, larger objects get a chunk of their own
+#define JIT_HEAP_CHUNK_SIZE (1 << 13)
+
+// Most stack el_jit_call lets compiled code use, less if the stack's limit is small
+#define JIT_MAX_STACK_SIZE (4 << 20)
+
+// Stack the chunks of a parallel for may use on a thread of the pool, which has the platform's default stack size
+#define JIT_WORKER_STACK_SIZE (1 << 20)
+
+#define JIT_NUM_ARGUMENT_GPRS 6
+#define JIT_NUM_ARGUMENT_XMMS 8
+
+// How far back in a block an operand's load is looked for, s.t. it can be an immediate
+#define JIT_CONSTANT_WINDOW 8
+
+// Kernels keep their vector registers in ymm0 to ymm13, or xmm0 to xmm13 without avx2, ymm14 and ymm15 are scratch
+#define JIT_KERNEL_NUM_VECTORS 14
+#define JIT_KERNEL_NUM_SLICES 6
+#define JIT_KERNEL_MAX_NUM_REGISTERS 128
+
+static int const argument_gprs[JIT_NUM_ARGUMENT_GPRS] = { el_X64_RDI, el_X64_RSI, el_X64_RDX, el_X64_RCX, el_X64_R8, el_X64_R9 };
+
+// Registers holding the addresses of the slices a kernel indexes, rcx holds the index and rdx the end of its loop
+static int const kernel_slice_gprs[JIT_KERNEL_NUM_SLICES] = { el_X64_RSI, el_X64_RDI, el_X64_R8, el_X64_R9, el_X64_R10, el_X64_R11 };
+
+// The index of each lane of a kernel's first iteration, followed by the step between iterations of up to 4 lanes
+static long long const kernel_lane_indices[5] = { 0, 1, 2, 3, 4 };
+
+// The lanes vector arithmetic reads for a NULL vector
+static union el_value const vector_zeros[el_VM_MAX_NUM_LANES];
+
+// Runtime errors the code of a function branches to, each has a stub at the end of the function
+enum el_jit_stub
+{
+	el_JIT_STUB_DIVISION_BY_ZERO,
+	el_JIT_STUB_INDEX_OUT_OF_RANGE,
+	el_JIT_STUB_NULL_REFERENCE,
+	el_JIT_STUB_STACK_OVERFLOW,
+
+	el_jit_stub_count
+};
+
+static int const stub_errors[el_jit_stub_count] = {
+	[el_JIT_STUB_DIVISION_BY_ZERO] = el_DIVISION_BY_ZERO_RUNTIME_ERROR,
+	[el_JIT_STUB_INDEX_OUT_OF_RANGE] = el_INDEX_OUT_OF_RANGE_RUNTIME_ERROR,
+	[el_JIT_STUB_NULL_REFERENCE] = el_NULL_REFERENCE_RUNTIME_ERROR,
+	[el_JIT_STUB_STACK_OVERFLOW] = el_STACK_OVERFLOW_RUNTIME_ERROR
+};
+
+struct el_jit_heap_chunk
+{
+	struct el_jit_heap_chunk * next;
+	size_t size;
+	size_t capacity;
+	union el_value values[];
+};
+
+// State of a thread running compiled code, s.t. the chunks of a parallel for allocate and fail independently of each other
+struct el_jit_thread
+{
+	struct el_jit_heap_chunk * heap;
+	jmp_buf on_error; // Where a runtime error unwinds to, out of every compiled frame at once
+	int error;
+	int error_function;
+	bool is_chunk; // A parallel for run by a chunk runs its own chunks in serial
+};
+
+// Compiled code holds the address of the runtime and its members, s.t. it must not move
+struct el_jit_runtime
+{
+	union el_value * globals;
+	struct el_ir_module const * module;
+	struct el_jit_thread thread; // Of el_jit_call, whose heap holds everything allocated by the calls so far
+	struct el_thread_pool * pool; // Created by the first parallel for run
+
+	// The jit's, set once its code is mapped
+	uint8_t const * code;
+	int const * entries;
+};
+
+// The parallel for being run, shared by its chunks
+struct el_jit_parallel_for
+{
+	void (*entry)(union el_value const *, union el_value *);
+	int num_parameters;
+	int num_chunks;
+	long long length;
+	union el_value * arguments; // num_parameters for each thread, the chunk's bounds followed by the captured values
+	struct el_jit_thread * threads;
+	int volatile num_failed;
+	int error;
+	int error_function;
+};
+
+// A rel32 in the code to point at a block, function or stub once its offset is known
+struct el_jit_fixup
+{
+	int offset;
+	int target;
+};
+
+// Frames are laid out below rbp as the callee saved registers, the stack slots, then the staging area for arguments
+// Outgoing stack arguments are at the bottom of the frame, at rsp
+struct el_jit_compiler
+{
+	struct el_ir_module const * module;
+	struct el_jit_runtime * runtime;
+	struct el_x64_assembler a;
+	el_VECTOR_MEMBERS(int, function_starts);
+	el_VECTOR_MEMBERS(struct el_jit_fixup, call_fixups);
+
+	// State of the function being compiled
+	struct el_ir_function const * function;
+	int function_index;
+	struct el_lsra_allocation allocation;
+	el_VECTOR_MEMBERS(int, block_starts);
+	el_VECTOR_MEMBERS(struct el_jit_fixup, block_fixups);
+	el_VECTOR_MEMBERS(struct el_jit_fixup, stub_fixups);
+	el_VECTOR_MEMBERS(int, return_fixups);
+	int block;
+	int instruction; // Being emitted, as an index into the function's instructions
+	int saved_registers[el_x64_register_count];
+	int num_saved_registers;
+	int slots_displacement; // Of stack slot 0 from rbp
+	int staging_displacement; // Of staging slot 0 from rbp, staging slots ascend s.t. they can be passed as an array
+	int vector_width; // Bytes of the vectors kernels run on, 32 with avx2, 16 with sse4.2, otherwise 0 and kernels are left to the scalar loop
+	int stack_limit_offset; // Of el_jit_stack_limit from the thread pointer
+};
+
+// Where each register of a kernel lives while it runs, -1 if nowhere
+// Registers read in every iteration the same are invariants, which keep their vector register for the whole kernel
+struct el_jit_kernel_plan
+{
+	int vectors[JIT_KERNEL_MAX_NUM_REGISTERS];
+	int gprs[JIT_KERNEL_MAX_NUM_REGISTERS]; // Of slices
+	int step; // Vector added to the index after each iteration, -1 if the index is not read as a value
+};
+
+#ifdef el_JIT_SUPPORTED
+// Lowest stack pointer a compiled function may start with on this thread
+// Initial exec thread local storage is at the same offset from the thread pointer on every thread, s.t. compiled code can address it
+static _Thread_local uintptr_t el_jit_stack_limit __attribute__((tls_model("initial-exec")));
+
+// Of the el_jit_call or chunk the thread is running, NULL on a thread of the pool between chunks
+static _Thread_local struct el_jit_thread * el_jit_current;
+
+static int el_jit_compile_function(struct el_jit_compiler * c, int function_index);
+static void el_jit_emit_prologue(struct el_jit_compiler * c, int num_staging_slots, int num_outgoing_slots);
+static void el_jit_emit_epilogue(struct el_jit_compiler * c);
+static void el_jit_emit_block(struct el_jit_compiler * c, int block);
+static bool el_jit_emit_fused_branch(struct el_jit_compiler * c, struct el_ir_instruction const * in, struct el_ir_instruction const * branch, int block, int index);
+static void el_jit_emit_instruction(struct el_jit_compiler * c, struct el_ir_instruction const * in, int block, bool is_last);
+static void el_jit_emit_call(struct el_jit_compiler * c, struct el_ir_instruction const * in);
+static void el_jit_emit_kernel(struct el_jit_compiler * c, struct el_ir_instruction const * in);
+static bool el_jit_plan_kernel(struct el_jit_compiler const * c, struct el_ir_kernel const * kernel, struct el_jit_kernel_plan * plan);
+static void el_jit_emit_kernel_instruction(struct el_jit_compiler * c, struct el_jit_kernel_plan const * plan, struct el_ir_instruction const * in);
+static bool el_jit_take_vector(uint32_t * free_vectors, int * vector);
+static void el_jit_emit_vector_op(struct el_jit_compiler * c, struct el_ir_instruction const * in);
+static void el_jit_emit_owned_vector(struct el_jit_compiler * c, int reg, int num_lanes);
+static void el_jit_emit_vector_address(struct el_jit_compiler * c, int machine_register, int slot);
+static void el_jit_emit_entry(struct el_jit_compiler * c, int function_index);
+static void el_jit_emit_stubs(struct el_jit_compiler * c);
+static void el_jit_emit_helper_call(struct el_jit_compiler * c, void (*helper)(void));
+static void el_jit_emit_branch(struct el_jit_compiler * c, int condition, int true_block, int false_block, int block);
+static void el_jit_emit_jump(struct el_jit_compiler * c, int condition, int block);
+static void el_jit_emit_stub_jump(struct el_jit_compiler * c, int condition, int stub);
+static void el_jit_emit_load_parameters(struct el_jit_compiler * c);
+static struct el_x64_operand el_jit_location(struct el_jit_compiler const * c, int reg);
+static struct el_x64_operand el_jit_staging(struct el_jit_compiler const * c, int slot);
+static bool el_jit_is_in_register(struct el_jit_compiler const * c, int reg, int machine_register);
+static bool el_jit_is_float(struct el_ir_function const * function, int reg);
+static int el_jit_result_register(struct el_jit_compiler const * c, struct el_ir_instruction const * in, int scratch);
+static bool el_jit_constant_of(struct el_jit_compiler const * c, int reg, long long * value);
+static bool el_jit_is_imm32(long long value);
+static void el_jit_emit_compare(struct el_jit_compiler * c, struct el_ir_instruction const * in);
+static bool el_jit_emit_constant_division(struct el_jit_compiler * c, struct el_ir_instruction const * in);
+static void el_jit_division_magic(long long divisor, long long * multiplier, int * shift);
+static void el_jit_load_gpr(struct el_jit_compiler * c, int machine_register, int reg);
+static void el_jit_load_xmm(struct el_jit_compiler * c, int machine_register, int reg);
+static int el_jit_gpr_of(struct el_jit_compiler * c, int reg, int scratch);
+static int el_jit_xmm_of(struct el_jit_compiler * c, int reg, int scratch);
+static void el_jit_set_gpr(struct el_jit_compiler * c, int reg, int machine_register);
+static void el_jit_set_xmm(struct el_jit_compiler * c, int reg, int machine_register);
+static void el_jit_set_constant(struct el_jit_compiler * c, int reg, long long bits);
+static void el_jit_move(struct el_jit_compiler * c, int dst, int src);
+static void el_jit_load_value(struct el_jit_compiler * c, int reg, struct el_x64_operand src);
+static void el_jit_store_value(struct el_jit_compiler * c, struct el_x64_operand dst, int reg);
+static int el_jit_field_offset(struct el_jit_compiler const * c, int reg, int field);
+static int el_jit_map_code(struct el_jit * jit, struct el_x64_assembler const * a);
+static void el_jit_compiler_delete(struct el_jit_compiler * c);
+
+static void el_jit_raise(struct el_jit_runtime * runtime, int err, int function);
+static void el_jit_parallel_for(struct el_jit_runtime * runtime, int function, int chunk_function, long long num_chunks, union el_value const * operands);
+static void el_jit_run_chunk(void * context, int chunk, int thread_index);
+static union el_value * el_jit_new_dat(struct el_jit_runtime * runtime, int function, long long num_fields);
+static struct el_vm_slice * el_jit_new_slice(struct el_jit_runtime * runtime, int function, long long length, union el_value const * values);
+static union el_value * el_jit_new_vector(struct el_jit_runtime * runtime, int function, long long num_lanes, union el_value const * values);
+static long long el_jit_strings_equal(el_string lhs, el_string rhs);
+static union el_value * el_jit_alloc(struct el_jit_thread * thread, size_t num_values);
+static size_t el_jit_stack_size(void);
+static int el_jit_stack_limit_offset(void);
+#endif
+
+int el_jit_compile(struct el_jit * jit, struct el_ir_module const * module)
+{
+	assert(jit && module);
+	*jit = (struct el_jit){ .module = module };
+#ifndef el_JIT_SUPPORTED
+	fprintf(stderr, "The jit only supports x86-64 System V platforms\n");
+	return el_JIT_UNSUPPORTED_PLATFORM_ERROR;
+#else
+	jit->runtime = fmalloc(sizeof(struct el_jit_runtime));
+	jit->entries = fmalloc(sizeof(int) * (module->num_functions > 0 ? module->num_functions : 1));
+	if(jit->runtime)
+	{
+		*jit->runtime = (struct el_jit_runtime){
+			.globals = fmalloc(sizeof(union el_value) * (module->num_globals > 0 ? module->num_globals : 1)),
+			.module = module,
+			.entries = jit->entries
+		};
+	}
+	if(!jit->runtime || !jit->entries || !jit->runtime->globals)
+	{
+		fprintf(stderr, "Failed to allocate jit\n");
+		el_jit_delete(jit);
+		return el_ALLOCATION_ERROR;
+	}
+	memset(jit->runtime->globals, 0, sizeof(union el_value) * module->num_globals);
+
+	struct el_jit_compiler c = { .module = module, .runtime = jit->runtime, .stack_limit_offset = el_jit_stack_limit_offset() };
+	c.vector_width = __builtin_cpu_supports("avx2") ? 32 : __builtin_cpu_supports("sse4.2") ? 16 : 0;
+	int err = el_vector_reserve(&c, function_starts, module->num_functions, NULL) ? el_SUCCESS : el_ALLOCATION_ERROR;
+	for(int i = 0; i < module->num_functions && err == el_SUCCESS; ++i)
+	{
+		c.function_starts[c.num_function_starts++] = el_x64_offset(&c.a);
+		err = el_jit_compile_function(&c, i);
+	}
+	for(int i = 0; i < module->num_functions && err == el_SUCCESS; ++i)
+	{
+		jit->entries[i] = el_x64_offset(&c.a);
+		el_jit_emit_entry(&c, i);
+	}
+
+	// Calls are patched once every function they may call has been laid out
+	for(int i = 0; i < c.num_call_fixups && err == el_SUCCESS; ++i)
+	{
+		el_x64_patch(&c.a, c.call_fixups[i].offset, c.function_starts[c.call_fixups[i].target]);
+	}
+
+	// Errors from compiling a function are returned as they are, only failures to hold the code are reported here
+	if(err == el_SUCCESS)
+	{
+		err = c.a.failed ? el_ALLOCATION_ERROR : el_jit_map_code(jit, &c.a);
+		if(err == el_ALLOCATION_ERROR)
+		{
+			fprintf(stderr, "Failed to allocate machine code\n");
+		}
+	}
+	el_jit_compiler_delete(&c);
+	if(err)
+	{
+		el_jit_delete(jit);
+		return err;
+	}
+	jit->runtime->code = jit->code;
+	return el_SUCCESS;
+#endif
+}
+
+void el_jit_delete(struct el_jit * jit)
+{
+	if(!jit)
+		return;
+
+#ifdef el_JIT_SUPPORTED
+	if(jit->code)
+	{
+		munmap(jit->code, jit->code_size);
+	}
+#endif
+	if(jit->runtime)
+	{
+		struct el_jit_heap_chunk * chunk = jit->runtime->thread.heap;
+		while(chunk)
+		{
+			struct el_jit_heap_chunk * next = chunk->next;
+			ffree(chunk);
+			chunk = next;
+		}
+		if(jit->runtime->pool)
+		{
+			el_thread_pool_delete(jit->runtime->pool);
+			ffree(jit->runtime->pool);
+		}
+		ffree(jit->runtime->globals);
+	}
+	ffree(jit->runtime);
+	ffree(jit->entries);
+	*jit = (struct el_jit){ 0 };
+}
+
+int el_jit_call(struct el_jit * jit, int function, union el_value const * arguments, union el_value * result)
+{
+	assert(jit && function >= 0 && function < jit->module->num_functions);
+#ifndef el_JIT_SUPPORTED
+	(void)arguments;
+	(void)result;
+	return el_JIT_UNSUPPORTED_PLATFORM_ERROR;
+#else
+	struct el_jit_runtime * runtime = jit->runtime;
+	void (*entry)(union el_value const *, union el_value *) = (void (*)(union el_value const *, union el_value *))(uintptr_t)(jit->code + jit->entries[function]);
+
+	// Compiled functions compare the stack pointer to the thread's limit on entry, it is measured from here
+	char stack_top;
+	el_jit_stack_limit = (uintptr_t)&stack_top - el_jit_stack_size();
+	el_jit_current = &runtime->thread;
+	runtime->thread.error = el_SUCCESS;
+	union el_value value = { 0 };
+	if(setjmp(runtime->thread.on_error) != 0)
+	{
+		el_string name = runtime->module->functions[runtime->thread.error_function].name;
+		fprintf(stderr, "Runtime error in %s: %s\n", name ? name : "the file scope", el_runtime_error_message(runtime->thread.error));
+		el_jit_current = NULL;
+		return runtime->thread.error;
+	}
+
+	entry(arguments, &value);
+	el_jit_current = NULL;
+	if(result)
+	{
+		*result = value;
+	}
+	return el_SUCCESS;
+#endif
+}
+
+#ifdef el_JIT_SUPPORTED
+static int el_jit_compile_function(struct el_jit_compiler * c, int function_index)
+{
+	struct el_ir_function const * function = &c->module->functions[function_index];
+	c->function = function;
+	c->function_index = function_index;
+	c->num_block_fixups = 0;
+	c->num_stub_fixups = 0;
+	c->num_return_fixups = 0;
+
+	if(function->num_blocks == 0)
+	{
+		fprintf(stderr, "Cannot compile %s, its body was not parsed\n", function->name);
+		return el_UNPARSED_FUNCTION_BODY_ERROR;
+	}
+
+	el_lsra_allocation_delete(&c->allocation);
+	int err = el_lsra_allocate(&c->allocation, c->module, function);
+	if(err)
+		return err;
+
+	if(!el_vector_reserve(c, block_starts, function->num_blocks, NULL))
+		return el_ALLOCATION_ERROR;
+
+	// Calls stage their arguments, which the function's own parameters also pass through on entry
+	int num_staging_slots = function->num_parameters;
+	int num_outgoing_slots = 0;
+	for(int i = 0; i < function->num_instructions; ++i)
+	{
+		struct el_ir_instruction const * in = &function->instructions[i];
+		int num_operands = in->op == el_IR_NEW_SLICE ? in->b : in->op == el_IR_CALL ? c->module->functions[in->b].num_parameters : 0;
+		num_operands = in->op == el_IR_KERNEL ? 1 + function->kernels[in->b].num_arguments : num_operands;
+		num_operands = in->op == el_IR_PARALLEL_FOR ? c->module->functions[in->b].num_parameters - 2 : num_operands;
+		num_operands = in->op == el_IR_NEW_VECTOR ? in->b : in->op >= el_IR_ADD_INT_VECTOR && in->op <= el_IR_DIV_FLOAT_VECTOR ? 2 : num_operands;
+		num_staging_slots = num_operands > num_staging_slots ? num_operands : num_staging_slots;
+		if(in->op == el_IR_CALL)
+		{
+			struct el_ir_function const * callee = &c->module->functions[in->b];
+			int num_gprs = 0;
+			int num_xmms = 0;
+			int num_stack = 0;
+			for(int k = 0; k < callee->num_parameters; ++k)
+			{
+				bool is_float = el_jit_is_float(callee, k);
+				num_stack += is_float ? num_xmms++ >= JIT_NUM_ARGUMENT_XMMS : num_gprs++ >= JIT_NUM_ARGUMENT_GPRS;
+			}
+			num_outgoing_slots = num_stack > num_outgoing_slots ? num_stack : num_outgoing_slots;
+		}
+	}
+
+	el_jit_emit_prologue(c, num_staging_slots, num_outgoing_slots);
+	el_jit_emit_load_parameters(c);
+	c->num_block_starts = function->num_blocks;
+	for(int i = 0; i < function->num_blocks; ++i)
+	{
+		c->block_starts[i] = el_x64_offset(&c->a);
+		el_jit_emit_block(c, i);
+	}
+
+	int epilogue = el_x64_offset(&c->a);
+	el_jit_emit_epilogue(c);
+	for(int i = 0; i < c->num_return_fixups; ++i)
+	{
+		el_x64_patch(&c->a, c->return_fixups[i], epilogue);
+	}
+	for(int i = 0; i < c->num_block_fixups; ++i)
+	{
+		el_x64_patch(&c->a, c->block_fixups[i].offset, c->block_starts[c->block_fixups[i].target]);
+	}
+	el_jit_emit_stubs(c);
+	return c->a.failed ? el_ALLOCATION_ERROR : el_SUCCESS;
+}
+
+// Stack slots are 8 bytes, the frame is padded s.t. rsp stays 16 byte aligned at calls
+static void el_jit_emit_prologue(struct el_jit_compiler * c, int num_staging_slots, int num_outgoing_slots)
+{
+	struct el_x64_assembler * a = &c->a;
+	el_x64_push(a, el_X64_RBP);
+	el_x64_mov(a, el_X64_RBP, el_x64_reg(el_X64_RSP));
+
+	c->num_saved_registers = 0;
+	for(int r = 0; r < el_x64_register_count; ++r)
+	{
+		if(c->allocation.used_callee_saved & (1u << r))
+		{
+			c->saved_registers[c->num_saved_registers++] = r;
+			el_x64_push(a, r);
+		}
+	}
+
+	int num_slots = c->allocation.num_stack_slots;
+	c->slots_displacement = -8 * (c->num_saved_registers + num_slots);
+	c->staging_displacement = c->slots_displacement - 8 * num_staging_slots;
+	int frame_size = 8 * (num_slots + num_staging_slots + num_outgoing_slots);
+	frame_size += (8 * c->num_saved_registers + frame_size) % 16;
+	if(frame_size > 0)
+	{
+		el_x64_alu_imm(a, el_X64_SUB, el_x64_reg(el_X64_RSP), frame_size);
+	}
+
+	el_x64_mov_fs(a, el_X64_RAX, c->stack_limit_offset);
+	el_x64_alu(a, el_X64_CMP, el_X64_RSP, el_x64_reg(el_X64_RAX));
+	el_jit_emit_stub_jump(c, el_X64_BELOW, el_JIT_STUB_STACK_OVERFLOW);
+}
+
+static void el_jit_emit_epilogue(struct el_jit_compiler * c)
+{
+	struct el_x64_assembler * a = &c->a;
+	el_x64_lea(a, el_X64_RSP, el_x64_mem(el_X64_RBP, -8 * c->num_saved_registers));
+	for(int i = c->num_saved_registers - 1; i >= 0; --i)
+	{
+		el_x64_pop(a, c->saved_registers[i]);
+	}
+	el_x64_pop(a, el_X64_RBP);
+	el_x64_ret(a);
+}
+
+// Parameters arrive in argument registers which other parameters may be allocated to, so each is staged before any is loaded
+// Registers the vm would read zeroed are zeroed
+static void el_jit_emit_load_parameters(struct el_jit_compiler * c)
+{
+	struct el_ir_function const * function = c->function;
+	struct el_lsra_register const * registers = c->allocation.registers;
+	struct el_x64_assembler * a = &c->a;
+	int num_gprs = 0;
+	int num_xmms = 0;
+	int num_stack = 0;
+	for(int k = 0; k < function->num_parameters; ++k)
+	{
+		bool is_float = el_jit_is_float(function, k);
+		bool is_used = registers[k].location != el_LSRA_UNUSED;
+		if(is_float && num_xmms < JIT_NUM_ARGUMENT_XMMS)
+		{
+			int xmm = num_xmms++;
+			if(is_used)
+			{
+				el_x64_movsd_store(a, el_jit_staging(c, k), xmm);
+			}
+		}
+		else if(!is_float && num_gprs < JIT_NUM_ARGUMENT_GPRS)
+		{
+			int gpr = argument_gprs[num_gprs++];
+			if(is_used)
+			{
+				el_x64_mov_store(a, el_jit_staging(c, k), gpr);
+			}
+		}
+		else
+		{
+			// Stack arguments are above the return address and the caller's rbp
+			if(is_used)
+			{
+				el_x64_mov(a, el_X64_R11, el_x64_mem(el_X64_RBP, 16 + 8 * num_stack));
+				el_x64_mov_store(a, el_jit_staging(c, k), el_X64_R11);
+			}
+			++num_stack;
+		}
+	}
+
+	for(int k = 0; k < function->num_parameters; ++k)
+	{
+		el_jit_load_value(c, k, el_jit_staging(c, k));
+	}
+	for(int r = function->num_parameters; r < function->num_registers; ++r)
+	{
+		if(registers[r].is_live_at_entry)
+		{
+			el_jit_set_constant(c, r, 0);
+		}
+	}
+}
+
+static void el_jit_emit_block(struct el_jit_compiler * c, int block)
+{
+	struct el_ir_function const * function = c->function;
+	struct el_ir_block const * b = &function->blocks[block];
+	int last = b->first_instruction + b->num_instructions - 1;
+	c->block = block;
+	for(int i = b->first_instruction; i <= last; ++i)
+	{
+		struct el_ir_instruction const * in = &function->instructions[i];
+		c->instruction = i;
+
+		// A comparison whose only reader is the branch after it sets the flags the branch jumps on
+		if(i + 1 == last && el_jit_emit_fused_branch(c, in, &function->instructions[last], block, i))
+			return;
+
+		el_jit_emit_instruction(c, in, block, block == function->num_blocks - 1 && i == last);
+	}
+}
+
+static bool el_jit_emit_fused_branch(struct el_jit_compiler * c, struct el_ir_instruction const * in, struct el_ir_instruction const * branch, int block, int index)
+{
+	if(branch->op != el_IR_BRANCH || branch->a != in->a || c->allocation.registers[in->a].end != 2 * (index + 1))
+		return false;
+
+	struct el_x64_assembler * a = &c->a;
+	switch(in->op)
+	{
+	case el_IR_EQ_INT:
+	case el_IR_LT_INT:
+	case el_IR_LE_INT:
+	{
+		el_jit_emit_compare(c, in);
+		int condition = in->op == el_IR_EQ_INT ? el_X64_EQUAL : in->op == el_IR_LT_INT ? el_X64_LESS : el_X64_LESS_OR_EQUAL;
+		el_jit_emit_branch(c, condition, branch->b, branch->c, block);
+		return true;
+	}
+	case el_IR_LT_FLOAT:
+	case el_IR_LE_FLOAT:
+		// b < c is c > b, which unlike b < c is false when either is NaN with a single condition
+		el_x64_ucomisd(a, el_jit_xmm_of(c, in->c, 0), el_jit_location(c, in->b));
+		el_jit_emit_branch(c, in->op == el_IR_LT_FLOAT ? el_X64_ABOVE : el_X64_ABOVE_OR_EQUAL, branch->b, branch->c, block);
+		return true;
+	case el_IR_EQ_FLOAT:
+		// Unordered operands set the parity flag along with the zero flag
+		el_x64_ucomisd(a, el_jit_xmm_of(c, in->b, 0), el_jit_location(c, in->c));
+		el_jit_emit_jump(c, el_X64_PARITY, branch->c);
+		el_jit_emit_branch(c, el_X64_EQUAL, branch->b, branch->c, block);
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void el_jit_emit_instruction(struct el_jit_compiler * c, struct el_ir_instruction const * in, int block, bool is_last)
+{
+	struct el_ir_module const * module = c->module;
+	struct el_x64_assembler * a = &c->a;
+	switch(in->op)
+	{
+	case el_IR_LOAD_INT:
+		el_jit_set_constant(c, in->a, module->int_constants[in->b]);
+		break;
+	case el_IR_LOAD_FLOAT:
+	{
+		long long bits;
+		memcpy(&bits, &module->float_constants[in->b], sizeof bits);
+		el_jit_set_constant(c, in->a, bits);
+		break;
+	}
+	case el_IR_LOAD_STRING:
+		el_jit_set_constant(c, in->a, (long long)(uintptr_t)module->strings[in->b]);
+		break;
+	case el_IR_MOVE:
+		el_jit_move(c, in->a, in->b);
+		break;
+	case el_IR_LOAD_GLOBAL:
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RAX), (long long)(uintptr_t)&c->runtime->globals[in->b]);
+		el_jit_load_value(c, in->a, el_x64_mem(el_X64_RAX, 0));
+		break;
+	case el_IR_STORE_GLOBAL:
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RAX), (long long)(uintptr_t)&c->runtime->globals[in->a]);
+		el_jit_store_value(c, el_x64_mem(el_X64_RAX, 0), in->b);
+		break;
+	case el_IR_ADD_INT:
+	case el_IR_SUB_INT:
+	case el_IR_MUL_INT:
+	{
+		// Int arithmetic wraps, as the two's complement instructions do
+		int dst = el_jit_result_register(c, in, el_X64_RAX);
+		long long value;
+		bool is_immediate = el_jit_constant_of(c, in->c, &value) && el_jit_is_imm32(value);
+		if(in->op == el_IR_MUL_INT && is_immediate)
+		{
+			el_x64_imul_imm(a, dst, el_jit_location(c, in->b), (int)value);
+			el_jit_set_gpr(c, in->a, dst);
+			break;
+		}
+
+		el_jit_load_gpr(c, dst, in->b);
+		if(is_immediate)
+		{
+			el_x64_alu_imm(a, in->op == el_IR_ADD_INT ? el_X64_ADD : el_X64_SUB, el_x64_reg(dst), (int)value);
+		}
+		else if(in->op == el_IR_MUL_INT)
+		{
+			el_x64_imul(a, dst, el_jit_location(c, in->c));
+		}
+		else
+		{
+			el_x64_alu(a, in->op == el_IR_ADD_INT ? el_X64_ADD : el_X64_SUB, dst, el_jit_location(c, in->c));
+		}
+		el_jit_set_gpr(c, in->a, dst);
+		break;
+	}
+	case el_IR_DIV_INT:
+	{
+		if(el_jit_emit_constant_division(c, in))
+			break;
+
+		// idiv faults on the smallest int divided by -1, which negating wraps like the vm does
+		el_jit_load_gpr(c, el_X64_RCX, in->c);
+		el_x64_test(a, el_x64_reg(el_X64_RCX), el_X64_RCX);
+		el_jit_emit_stub_jump(c, el_X64_EQUAL, el_JIT_STUB_DIVISION_BY_ZERO);
+		el_jit_load_gpr(c, el_X64_RAX, in->b);
+		el_x64_alu_imm(a, el_X64_CMP, el_x64_reg(el_X64_RCX), -1);
+		int divide = el_x64_jcc(a, el_X64_NOT_EQUAL);
+		el_x64_neg(a, el_x64_reg(el_X64_RAX));
+		int done = el_x64_jmp(a);
+		el_x64_patch(a, divide, el_x64_offset(a));
+		el_x64_cqo(a);
+		el_x64_idiv(a, el_x64_reg(el_X64_RCX));
+		el_x64_patch(a, done, el_x64_offset(a));
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	}
+	case el_IR_ADD_FLOAT:
+	case el_IR_SUB_FLOAT:
+	case el_IR_MUL_FLOAT:
+	case el_IR_DIV_FLOAT:
+	{
+		static int const ops[] = { el_X64_ADDSD, el_X64_SUBSD, el_X64_MULSD, el_X64_DIVSD };
+		int dst = el_jit_result_register(c, in, 0);
+		el_jit_load_xmm(c, dst, in->b);
+		el_x64_sse(a, ops[in->op - el_IR_ADD_FLOAT], dst, el_jit_location(c, in->c));
+		el_jit_set_xmm(c, in->a, dst);
+		break;
+	}
+	case el_IR_EQ_INT:
+	case el_IR_LT_INT:
+	case el_IR_LE_INT:
+	{
+		el_jit_emit_compare(c, in);
+		el_x64_setcc(a, in->op == el_IR_EQ_INT ? el_X64_EQUAL : in->op == el_IR_LT_INT ? el_X64_LESS : el_X64_LESS_OR_EQUAL, el_X64_RAX);
+		el_x64_movzx8(a, el_X64_RAX, el_X64_RAX);
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	}
+	case el_IR_LT_FLOAT:
+	case el_IR_LE_FLOAT:
+		el_x64_ucomisd(a, el_jit_xmm_of(c, in->c, 0), el_jit_location(c, in->b));
+		el_x64_setcc(a, in->op == el_IR_LT_FLOAT ? el_X64_ABOVE : el_X64_ABOVE_OR_EQUAL, el_X64_RAX);
+		el_x64_movzx8(a, el_X64_RAX, el_X64_RAX);
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	case el_IR_EQ_FLOAT:
+		el_x64_ucomisd(a, el_jit_xmm_of(c, in->b, 0), el_jit_location(c, in->c));
+		el_x64_setcc(a, el_X64_EQUAL, el_X64_RAX);
+		el_x64_setcc(a, el_X64_NOT_PARITY, el_X64_RCX);
+		el_x64_movzx8(a, el_X64_RAX, el_X64_RAX);
+		el_x64_movzx8(a, el_X64_RCX, el_X64_RCX);
+		el_x64_alu(a, el_X64_AND, el_X64_RAX, el_x64_reg(el_X64_RCX));
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	case el_IR_EQ_STRING:
+		el_jit_load_gpr(c, el_X64_RAX, in->b);
+		el_jit_load_gpr(c, el_X64_RSI, in->c);
+		el_x64_mov(a, el_X64_RDI, el_x64_reg(el_X64_RAX));
+		el_jit_emit_helper_call(c, (void (*)(void))el_jit_strings_equal);
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	case el_IR_AND:
+	case el_IR_OR:
+		el_jit_load_gpr(c, el_X64_RAX, in->b);
+		el_x64_test(a, el_x64_reg(el_X64_RAX), el_X64_RAX);
+		el_x64_setcc(a, el_X64_NOT_EQUAL, el_X64_RAX);
+		el_x64_movzx8(a, el_X64_RAX, el_X64_RAX);
+		el_jit_load_gpr(c, el_X64_RCX, in->c);
+		el_x64_test(a, el_x64_reg(el_X64_RCX), el_X64_RCX);
+		el_x64_setcc(a, el_X64_NOT_EQUAL, el_X64_RCX);
+		el_x64_movzx8(a, el_X64_RCX, el_X64_RCX);
+		el_x64_alu(a, in->op == el_IR_AND ? el_X64_AND : el_X64_OR, el_X64_RAX, el_x64_reg(el_X64_RCX));
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	case el_IR_NEW_DAT:
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDI), (long long)(uintptr_t)c->runtime);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RSI), c->function_index);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDX), el_get_layout(&module->layout, c->function->register_types[in->a])->block_size / (int)sizeof(union el_value));
+		el_jit_emit_helper_call(c, (void (*)(void))el_jit_new_dat);
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	case el_IR_GET_FIELD:
+		el_jit_load_gpr(c, el_X64_RAX, in->b);
+		el_x64_test(a, el_x64_reg(el_X64_RAX), el_X64_RAX);
+		el_jit_emit_stub_jump(c, el_X64_EQUAL, el_JIT_STUB_NULL_REFERENCE);
+		el_jit_load_value(c, in->a, el_x64_mem(el_X64_RAX, el_jit_field_offset(c, in->b, in->c)));
+		break;
+	case el_IR_SET_FIELD:
+		el_jit_load_gpr(c, el_X64_RAX, in->a);
+		el_x64_test(a, el_x64_reg(el_X64_RAX), el_X64_RAX);
+		el_jit_emit_stub_jump(c, el_X64_EQUAL, el_JIT_STUB_NULL_REFERENCE);
+		el_jit_store_value(c, el_x64_mem(el_X64_RAX, el_jit_field_offset(c, in->a, in->b)), in->c);
+		break;
+	case el_IR_NEW_SLICE:
+		for(int k = 0; k < in->b; ++k)
+		{
+			el_jit_store_value(c, el_jit_staging(c, k), c->function->operands[in->c + k]);
+		}
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDI), (long long)(uintptr_t)c->runtime);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RSI), c->function_index);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDX), in->b);
+		el_x64_lea(a, el_X64_RCX, el_jit_staging(c, 0));
+		el_jit_emit_helper_call(c, (void (*)(void))el_jit_new_slice);
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	case el_IR_NEW_ZERO_SLICE:
+		el_jit_load_gpr(c, el_X64_RDX, in->b);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDI), (long long)(uintptr_t)c->runtime);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RSI), c->function_index);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RCX), 0);
+		el_jit_emit_helper_call(c, (void (*)(void))el_jit_new_slice);
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	case el_IR_NEW_VECTOR:
+		for(int k = 0; k < in->b; ++k)
+		{
+			el_jit_store_value(c, el_jit_staging(c, k), c->function->operands[in->c + k]);
+		}
+		if(c->function->owned_vectors[in->a])
+		{
+			el_jit_emit_owned_vector(c, in->a, in->b);
+			for(int k = 0; k < in->b; ++k)
+			{
+				el_x64_mov(a, el_X64_RCX, el_jit_staging(c, k));
+				el_x64_mov_store(a, el_x64_mem(el_X64_RAX, k * (int)sizeof(union el_value)), el_X64_RCX);
+			}
+			el_jit_set_gpr(c, in->a, el_X64_RAX);
+			break;
+		}
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDI), (long long)(uintptr_t)c->runtime);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RSI), c->function_index);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDX), in->b);
+		el_x64_lea(a, el_X64_RCX, el_jit_staging(c, 0));
+		el_jit_emit_helper_call(c, (void (*)(void))el_jit_new_vector);
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	case el_IR_GET_LANE:
+	{
+		el_jit_load_gpr(c, el_X64_RAX, in->b);
+		el_jit_emit_vector_address(c, el_X64_RAX, -1);
+		el_jit_load_value(c, in->a, el_x64_mem(el_X64_RAX, in->c * (int)sizeof(union el_value)));
+		break;
+	}
+	case el_IR_ADD_INT_VECTOR:
+	case el_IR_SUB_INT_VECTOR:
+	case el_IR_MUL_INT_VECTOR:
+	case el_IR_ADD_FLOAT_VECTOR:
+	case el_IR_SUB_FLOAT_VECTOR:
+	case el_IR_MUL_FLOAT_VECTOR:
+	case el_IR_DIV_FLOAT_VECTOR:
+		el_jit_emit_vector_op(c, in);
+		break;
+	case el_IR_GET_ELEMENT:
+	case el_IR_SET_ELEMENT:
+	{
+		// Comparing the index unsigned also catches negative indices, a NULL slice is empty
+		bool is_get = in->op == el_IR_GET_ELEMENT;
+		el_jit_load_gpr(c, el_X64_RAX, is_get ? in->b : in->a);
+		el_jit_load_gpr(c, el_X64_RCX, is_get ? in->c : in->b);
+		el_x64_test(a, el_x64_reg(el_X64_RAX), el_X64_RAX);
+		el_jit_emit_stub_jump(c, el_X64_EQUAL, el_JIT_STUB_INDEX_OUT_OF_RANGE);
+		el_x64_alu(a, el_X64_CMP, el_X64_RCX, el_x64_mem(el_X64_RAX, 0));
+		el_jit_emit_stub_jump(c, el_X64_ABOVE_OR_EQUAL, el_JIT_STUB_INDEX_OUT_OF_RANGE);
+		struct el_x64_operand element = el_x64_mem_indexed(el_X64_RAX, el_X64_RCX, 8, 8);
+		if(is_get)
+		{
+			el_jit_load_value(c, in->a, element);
+		}
+		else
+		{
+			el_jit_store_value(c, element, in->c);
+		}
+		break;
+	}
+	case el_IR_LENGTH:
+	{
+		el_jit_load_gpr(c, el_X64_RAX, in->b);
+		el_x64_test(a, el_x64_reg(el_X64_RAX), el_X64_RAX);
+		int empty = el_x64_jcc(a, el_X64_EQUAL);
+		el_x64_mov(a, el_X64_RAX, el_x64_mem(el_X64_RAX, 0));
+		el_x64_patch(a, empty, el_x64_offset(a));
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	}
+	case el_IR_GET_COLUMN:
+	{
+		el_jit_load_gpr(c, el_X64_RAX, in->b);
+		el_x64_test(a, el_x64_reg(el_X64_RAX), el_X64_RAX);
+		int empty = el_x64_jcc(a, el_X64_EQUAL);
+		el_x64_mov(a, el_X64_RAX, el_x64_mem(el_X64_RAX, el_jit_field_offset(c, in->b, in->c)));
+		el_x64_patch(a, empty, el_x64_offset(a));
+		el_jit_set_gpr(c, in->a, el_X64_RAX);
+		break;
+	}
+	case el_IR_CALL:
+		el_jit_emit_call(c, in);
+		break;
+	case el_IR_KERNEL:
+		el_jit_emit_kernel(c, in);
+		break;
+	case el_IR_PARALLEL_FOR:
+	{
+		// num_chunks is read before the argument registers it may be allocated to are written
+		int num_operands = module->functions[in->b].num_parameters - 2;
+		for(int k = 0; k < num_operands; ++k)
+		{
+			el_jit_store_value(c, el_jit_staging(c, k), c->function->operands[in->c + k]);
+		}
+		el_jit_load_gpr(c, el_X64_RCX, in->a);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDI), (long long)(uintptr_t)c->runtime);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RSI), c->function_index);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDX), in->b);
+		el_x64_lea(a, el_X64_R8, el_jit_staging(c, 0));
+		el_jit_emit_helper_call(c, (void (*)(void))el_jit_parallel_for);
+		break;
+	}
+	case el_IR_JUMP:
+		if(in->a != block + 1)
+		{
+			el_jit_emit_jump(c, -1, in->a);
+		}
+		break;
+	case el_IR_BRANCH:
+	{
+		struct el_x64_operand condition = el_jit_location(c, in->a);
+		if(condition.is_memory)
+		{
+			el_x64_alu_imm(a, el_X64_CMP, condition, 0);
+		}
+		else
+		{
+			el_x64_test(a, condition, condition.reg);
+		}
+		el_jit_emit_branch(c, el_X64_NOT_EQUAL, in->b, in->c, block);
+		break;
+	}
+	case el_IR_RET:
+	case el_IR_RET_VOID:
+		if(in->op == el_IR_RET_VOID)
+		{
+			el_x64_alu(a, el_X64_XOR, el_X64_RAX, el_x64_reg(el_X64_RAX));
+			el_x64_xorpd(a, 0, 0);
+		}
+		else if(c->function->return_type == el_FLOAT_TYPE_ID)
+		{
+			el_jit_load_xmm(c, 0, in->a);
+		}
+		else
+		{
+			el_jit_load_gpr(c, el_X64_RAX, in->a);
+		}
+
+		// The epilogue directly follows the last block
+		if(!is_last)
+		{
+			int * fixup = el_vector_push(c, return_fixups, NULL);
+			int offset = el_x64_jmp(a);
+			if(fixup)
+			{
+				*fixup = offset;
+			}
+			else
+			{
+				a->failed = true;
+			}
+		}
+		break;
+	default:
+		assert(false);
+	}
+}
+
+// Arguments are staged in memory before any argument register is written, as the registers may hold other arguments
+// Set the flags to b compared with c, with c as an immediate if it is a small enough known constant
+static void el_jit_emit_compare(struct el_jit_compiler * c, struct el_ir_instruction const * in)
+{
+	long long value;
+	int lhs = el_jit_gpr_of(c, in->b, el_X64_RAX);
+	if(el_jit_constant_of(c, in->c, &value) && el_jit_is_imm32(value))
+	{
+		el_x64_alu_imm(&c->a, el_X64_CMP, el_x64_reg(lhs), (int)value);
+	}
+	else
+	{
+		el_x64_alu(&c->a, el_X64_CMP, lhs, el_jit_location(c, in->c));
+	}
+}
+
+// Divide by a known constant without idiv, rounding towards zero as idiv does
+// Returns false for a divisor of 0, which must raise, and the smallest int, which has no magic multiplier
+static bool el_jit_emit_constant_division(struct el_jit_compiler * c, struct el_ir_instruction const * in)
+{
+	struct el_x64_assembler * a = &c->a;
+	long long divisor;
+	if(!el_jit_constant_of(c, in->c, &divisor) || divisor == 0 || divisor == LLONG_MIN)
+		return false;
+
+	if(divisor == 1)
+	{
+		el_jit_move(c, in->a, in->b);
+		return true;
+	}
+
+	unsigned long long magnitude = divisor < 0 ? -(unsigned long long)divisor : (unsigned long long)divisor;
+	if((magnitude & (magnitude - 1)) == 0)
+	{
+		// Add 2^k - 1 to negative dividends before shifting, s.t. they round towards zero rather than down
+		int k = 0;
+		while((1ull << k) != magnitude)
+		{
+			++k;
+		}
+		el_jit_load_gpr(c, el_X64_RAX, in->b);
+		if(k > 0)
+		{
+			el_x64_mov(a, el_X64_RDX, el_x64_reg(el_X64_RAX));
+			el_x64_shift(a, el_X64_SAR, el_x64_reg(el_X64_RDX), 63);
+			el_x64_shift(a, el_X64_SHR, el_x64_reg(el_X64_RDX), 64 - k);
+			el_x64_alu(a, el_X64_ADD, el_X64_RAX, el_x64_reg(el_X64_RDX));
+			el_x64_shift(a, el_X64_SAR, el_x64_reg(el_X64_RAX), k);
+		}
+		if(divisor < 0)
+		{
+			el_x64_neg(a, el_x64_reg(el_X64_RAX));
+		}
+	}
+	else
+	{
+		// The high half of the dividend times a fixed point reciprocal, which carries the divisor's sign, then 1 more if that is negative
+		long long multiplier;
+		int shift;
+		el_jit_division_magic(divisor, &multiplier, &shift);
+		el_jit_load_gpr(c, el_X64_RCX, in->b);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RAX), multiplier);
+		el_x64_imul_wide(a, el_x64_reg(el_X64_RCX));
+		if(divisor > 0 && multiplier < 0)
+		{
+			el_x64_alu(a, el_X64_ADD, el_X64_RDX, el_x64_reg(el_X64_RCX));
+		}
+		else if(divisor < 0 && multiplier > 0)
+		{
+			el_x64_alu(a, el_X64_SUB, el_X64_RDX, el_x64_reg(el_X64_RCX));
+		}
+		if(shift > 0)
+		{
+			el_x64_shift(a, el_X64_SAR, el_x64_reg(el_X64_RDX), shift);
+		}
+		el_x64_mov(a, el_X64_RAX, el_x64_reg(el_X64_RDX));
+		el_x64_shift(a, el_X64_SHR, el_x64_reg(el_X64_RAX), 63);
+		el_x64_alu(a, el_X64_ADD, el_X64_RAX, el_x64_reg(el_X64_RDX));
+	}
+	el_jit_set_gpr(c, in->a, el_X64_RAX);
+	return true;
+}
+
+// Signed magic number of divisor, which is not -1, 0, 1 or the smallest int, from Hacker's Delight 10-1
+static void el_jit_division_magic(long long divisor, long long * multiplier, int * shift)
+{
+	unsigned long long const two63 = 1ull << 63;
+	unsigned long long magnitude = divisor < 0 ? -(unsigned long long)divisor : (unsigned long long)divisor;
+	unsigned long long t = two63 + ((unsigned long long)divisor >> 63);
+	unsigned long long anc = t - 1 - t % magnitude; // Absolute value of nc
+	unsigned long long q1 = two63 / anc, r1 = two63 - q1 * anc;
+	unsigned long long q2 = two63 / magnitude, r2 = two63 - q2 * magnitude;
+	unsigned long long delta;
+	int p = 63;
+	do
+	{
+		++p;
+		q1 *= 2;
+		r1 *= 2;
+		if(r1 >= anc)
+		{
+			++q1;
+			r1 -= anc;
+		}
+		q2 *= 2;
+		r2 *= 2;
+		if(r2 >= magnitude)
+		{
+			++q2;
+			r2 -= magnitude;
+		}
+		delta = magnitude - r2;
+	} while(q1 < delta || (q1 == delta && r1 == 0));
+
+	unsigned long long m = q2 + 1;
+	*multiplier = (long long)(divisor < 0 ? -m : m);
+	*shift = p - 64;
+}
+
+static void el_jit_emit_call(struct el_jit_compiler * c, struct el_ir_instruction const * in)
+{
+	struct el_x64_assembler * a = &c->a;
+	struct el_ir_function const * callee = &c->module->functions[in->b];
+	uint16_t const * operands = c->function->operands + in->c;
+	for(int k = 0; k < callee->num_parameters; ++k)
+	{
+		el_jit_store_value(c, el_jit_staging(c, k), operands[k]);
+	}
+
+	int num_gprs = 0;
+	int num_xmms = 0;
+	int num_stack = 0;
+	for(int k = 0; k < callee->num_parameters; ++k)
+	{
+		bool is_float = el_jit_is_float(callee, k);
+		if(is_float && num_xmms < JIT_NUM_ARGUMENT_XMMS)
+		{
+			el_x64_movsd(a, num_xmms++, el_jit_staging(c, k));
+		}
+		else if(!is_float && num_gprs < JIT_NUM_ARGUMENT_GPRS)
+		{
+			el_x64_mov(a, argument_gprs[num_gprs++], el_jit_staging(c, k));
+		}
+		else
+		{
+			el_x64_mov(a, el_X64_R11, el_jit_staging(c, k));
+			el_x64_mov_store(a, el_x64_mem(el_X64_RSP, 8 * num_stack++), el_X64_R11);
+		}
+	}
+
+	struct el_jit_fixup * fixup = el_vector_push(c, call_fixups, NULL);
+	int offset = el_x64_call(a);
+	if(fixup)
+	{
+		*fixup = (struct el_jit_fixup){ offset, in->b };
+	}
+	else
+	{
+		a->failed = true;
+	}
+
+	if(in->a != el_IR_NO_REGISTER)
+	{
+		if(callee->return_type == el_FLOAT_TYPE_ID)
+		{
+			el_jit_set_xmm(c, in->a, 0);
+		}
+		else
+		{
+			el_jit_set_gpr(c, in->a, el_X64_RAX);
+		}
+	}
+}
+
+// Kernels run whole vectors of elements from 0, the loop which follows runs the rest
+// A kernel needing more registers than there are, or run on a cpu without sse4.2, runs for no elements
+static void el_jit_emit_kernel(struct el_jit_compiler * c, struct el_ir_instruction const * in)
+{
+	struct el_x64_assembler * a = &c->a;
+	struct el_ir_kernel const * kernel = &c->function->kernels[in->b];
+	struct el_jit_kernel_plan plan;
+	if(!el_jit_plan_kernel(c, kernel, &plan))
+	{
+		el_jit_set_constant(c, in->a, 0);
+		return;
+	}
+
+	// Staged as a call's arguments are, s.t. scalars can be broadcast from memory
+	uint16_t const * operands = c->function->operands + in->c;
+	for(int k = 0; k <= kernel->num_arguments; ++k)
+	{
+		el_jit_store_value(c, el_jit_staging(c, k), operands[k]);
+	}
+
+	int width = c->vector_width;
+	int lanes = width / 8;
+	int index = kernel->num_arguments;
+	el_x64_mov(a, el_X64_RDX, el_jit_staging(c, 0));
+	el_x64_alu_imm(a, el_X64_AND, el_x64_reg(el_X64_RDX), -lanes);
+	el_x64_alu(a, el_X64_XOR, el_X64_RCX, el_x64_reg(el_X64_RCX));
+	for(int r = 0; r < index; ++r)
+	{
+		if(plan.gprs[r] >= 0)
+		{
+			el_x64_mov(a, plan.gprs[r], el_jit_staging(c, 1 + r));
+		}
+		else if(plan.vectors[r] >= 0)
+		{
+			el_x64_broadcast(a, width, plan.vectors[r], el_jit_staging(c, 1 + r));
+		}
+	}
+	for(int i = 0; i < kernel->num_instructions; ++i)
+	{
+		struct el_ir_instruction const * k = &kernel->instructions[i];
+		if(k->op != el_IR_LOAD_INT && k->op != el_IR_LOAD_FLOAT)
+			continue;
+
+		void const * constant = k->op == el_IR_LOAD_INT ? (void const *)&c->module->int_constants[k->b] : (void const *)&c->module->float_constants[k->b];
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RAX), (long long)(uintptr_t)constant);
+		el_x64_broadcast(a, width, plan.vectors[k->a], el_x64_mem(el_X64_RAX, 0));
+	}
+	if(plan.step >= 0)
+	{
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RAX), (long long)(uintptr_t)kernel_lane_indices);
+		el_x64_packed(a, el_X64_MOVUPD, width, plan.vectors[index], 0, el_x64_mem(el_X64_RAX, 0));
+		el_x64_broadcast(a, width, plan.step, el_x64_mem(el_X64_RAX, 8 * lanes));
+	}
+
+	el_x64_test(a, el_x64_reg(el_X64_RDX), el_X64_RDX);
+	int done = el_x64_jcc(a, el_X64_EQUAL);
+	int loop = el_x64_offset(a);
+	for(int i = 0; i < kernel->num_instructions; ++i)
+	{
+		el_jit_emit_kernel_instruction(c, &plan, &kernel->instructions[i]);
+	}
+	el_x64_alu_imm(a, el_X64_ADD, el_x64_reg(el_X64_RCX), lanes);
+	if(plan.step >= 0)
+	{
+		el_x64_packed(a, el_X64_PADDQ, width, plan.vectors[index], plan.vectors[index], el_x64_reg(plan.step));
+	}
+	el_x64_alu(a, el_X64_CMP, el_X64_RCX, el_x64_reg(el_X64_RDX));
+	el_x64_patch(a, el_x64_jcc(a, el_X64_LESS), loop);
+	el_x64_patch(a, done, el_x64_offset(a));
+	if(width == 32)
+	{
+		el_x64_vzeroupper(a);
+	}
+	el_jit_set_gpr(c, in->a, el_X64_RDX);
+}
+
+// Invariants take their vector registers first, then each other register takes one where it is written and frees it after its last read
+// An instruction's lhs is freed before its result takes a register and its rhs after, s.t. the result is never in rhs's register
+// unless lhs is too, which the destructive sse encoding needs
+static bool el_jit_plan_kernel(struct el_jit_compiler const * c, struct el_ir_kernel const * kernel, struct el_jit_kernel_plan * plan)
+{
+	if(c->vector_width == 0 || kernel->num_registers > JIT_KERNEL_MAX_NUM_REGISTERS)
+		return false;
+
+	int last_reads[JIT_KERNEL_MAX_NUM_REGISTERS];
+	bool is_invariant[JIT_KERNEL_MAX_NUM_REGISTERS];
+	int index = kernel->num_arguments;
+	plan->step = -1;
+	for(int r = 0; r < kernel->num_registers; ++r)
+	{
+		plan->vectors[r] = -1;
+		plan->gprs[r] = -1;
+		last_reads[r] = -1;
+		is_invariant[r] = r <= index;
+	}
+
+	// The index is only read as a value by arithmetic, get.element and set.element take it as the address of their element
+	for(int i = 0; i < kernel->num_instructions; ++i)
+	{
+		struct el_ir_instruction const * in = &kernel->instructions[i];
+		switch(in->op)
+		{
+		case el_IR_LOAD_INT:
+		case el_IR_LOAD_FLOAT:
+			is_invariant[in->a] = true;
+			break;
+		case el_IR_GET_ELEMENT:
+			last_reads[in->b] = i;
+			break;
+		case el_IR_SET_ELEMENT:
+			last_reads[in->a] = i;
+			last_reads[in->c] = i;
+			break;
+		default:
+			last_reads[in->b] = i;
+			last_reads[in->c] = i;
+			break;
+		}
+	}
+
+	uint32_t free_vectors = (1u << JIT_KERNEL_NUM_VECTORS) - 1;
+	int num_slices = 0;
+	for(int r = 0; r < kernel->num_registers; ++r)
+	{
+		if(!is_invariant[r] || last_reads[r] < 0)
+			continue;
+
+		if(r < index && el_get_type(c->module->types, kernel->register_types[r])->kind == el_TYPE_SLICE)
+		{
+			if(num_slices == JIT_KERNEL_NUM_SLICES)
+				return false;
+			plan->gprs[r] = kernel_slice_gprs[num_slices++];
+		}
+		else if(!el_jit_take_vector(&free_vectors, &plan->vectors[r]))
+		{
+			return false;
+		}
+	}
+	if(last_reads[index] >= 0 && !el_jit_take_vector(&free_vectors, &plan->step))
+		return false;
+
+	for(int i = 0; i < kernel->num_instructions; ++i)
+	{
+		struct el_ir_instruction const * in = &kernel->instructions[i];
+		if(in->op == el_IR_LOAD_INT || in->op == el_IR_LOAD_FLOAT || in->op == el_IR_SET_ELEMENT)
+			continue;
+
+		bool reads_lhs = in->op != el_IR_GET_ELEMENT;
+		if(reads_lhs && !is_invariant[in->b] && last_reads[in->b] == i)
+		{
+			free_vectors |= 1u << plan->vectors[in->b];
+		}
+		if(!el_jit_take_vector(&free_vectors, &plan->vectors[in->a]))
+			return false;
+		if(reads_lhs && !is_invariant[in->c] && last_reads[in->c] == i && in->c != in->b)
+		{
+			free_vectors |= 1u << plan->vectors[in->c];
+		}
+		if(last_reads[in->a] <= i)
+		{
+			free_vectors |= 1u << plan->vectors[in->a];
+		}
+	}
+	return true;
+}
+
+// Loads of constants are invariants, broadcast before the loop
+// Comparisons give all ones in each lane which holds, shifted down to 1
+// pcmpgtq is the only signed integer comparison, and the sse encodings overwrite their lhs, s.t. some go through the scratch registers
+static void el_jit_emit_kernel_instruction(struct el_jit_compiler * c, struct el_jit_kernel_plan const * plan, struct el_ir_instruction const * in)
+{
+	struct el_x64_assembler * a = &c->a;
+	if(in->op == el_IR_LOAD_INT || in->op == el_IR_LOAD_FLOAT)
+		return;
+
+	int const t0 = JIT_KERNEL_NUM_VECTORS;
+	int const t1 = JIT_KERNEL_NUM_VECTORS + 1;
+	int width = c->vector_width;
+	int dst = plan->vectors[in->a];
+	int lhs = plan->vectors[in->b];
+	struct el_x64_operand rhs = el_x64_reg(plan->vectors[in->c]);
+	switch(in->op)
+	{
+	case el_IR_ADD_INT:
+		el_x64_packed(a, el_X64_PADDQ, width, dst, lhs, rhs);
+		break;
+	case el_IR_SUB_INT:
+		el_x64_packed(a, el_X64_PSUBQ, width, dst, lhs, rhs);
+		break;
+	case el_IR_MUL_INT:
+		// lhs * rhs = lo(lhs) * lo(rhs) + ((hi(lhs) * lo(rhs) + lo(lhs) * hi(rhs)) << 32), from 32 bit multiplies
+		el_x64_packed_shift(a, el_X64_PSRLQ, width, t0, lhs, 32);
+		el_x64_packed(a, el_X64_PMULUDQ, width, t0, t0, rhs);
+		el_x64_packed_shift(a, el_X64_PSRLQ, width, t1, rhs.reg, 32);
+		el_x64_packed(a, el_X64_PMULUDQ, width, t1, t1, el_x64_reg(lhs));
+		el_x64_packed(a, el_X64_PADDQ, width, t0, t0, el_x64_reg(t1));
+		el_x64_packed_shift(a, el_X64_PSLLQ, width, t0, t0, 32);
+		el_x64_packed(a, el_X64_PMULUDQ, width, dst, lhs, rhs);
+		el_x64_packed(a, el_X64_PADDQ, width, dst, dst, el_x64_reg(t0));
+		break;
+	case el_IR_ADD_FLOAT:
+		el_x64_packed(a, el_X64_ADDPD, width, dst, lhs, rhs);
+		break;
+	case el_IR_SUB_FLOAT:
+		el_x64_packed(a, el_X64_SUBPD, width, dst, lhs, rhs);
+		break;
+	case el_IR_MUL_FLOAT:
+		el_x64_packed(a, el_X64_MULPD, width, dst, lhs, rhs);
+		break;
+	case el_IR_DIV_FLOAT:
+		el_x64_packed(a, el_X64_DIVPD, width, dst, lhs, rhs);
+		break;
+	case el_IR_EQ_INT:
+		el_x64_packed(a, el_X64_PCMPEQQ, width, dst, lhs, rhs);
+		el_x64_packed_shift(a, el_X64_PSRLQ, width, dst, dst, 63);
+		break;
+	case el_IR_LT_INT:
+		el_x64_packed(a, el_X64_PCMPGTQ, width, t0, rhs.reg, el_x64_reg(lhs));
+		el_x64_packed_shift(a, el_X64_PSRLQ, width, dst, t0, 63);
+		break;
+	case el_IR_LE_INT:
+		el_x64_packed(a, el_X64_PCMPGTQ, width, t0, lhs, rhs);
+		el_x64_packed(a, el_X64_PCMPEQQ, width, t1, t1, el_x64_reg(t1));
+		el_x64_packed(a, el_X64_PXOR, width, t0, t0, el_x64_reg(t1));
+		el_x64_packed_shift(a, el_X64_PSRLQ, width, dst, t0, 63);
+		break;
+	case el_IR_EQ_FLOAT:
+	case el_IR_LT_FLOAT:
+	case el_IR_LE_FLOAT:
+	{
+		int predicate = in->op == el_IR_EQ_FLOAT ? el_X64_CMP_EQ : in->op == el_IR_LT_FLOAT ? el_X64_CMP_LT : el_X64_CMP_LE;
+		el_x64_packed_imm(a, el_X64_CMPPD, width, dst, lhs, rhs, predicate);
+		el_x64_packed_shift(a, el_X64_PSRLQ, width, dst, dst, 63);
+		break;
+	}
+	case el_IR_AND:
+	case el_IR_OR:
+		// Lanes where lhs or rhs is 0 for and, both are 0 for or, then inverted
+		el_x64_packed(a, el_X64_PXOR, width, t1, t1, el_x64_reg(t1));
+		el_x64_packed(a, el_X64_PCMPEQQ, width, t0, lhs, el_x64_reg(t1));
+		el_x64_packed(a, el_X64_PCMPEQQ, width, t1, t1, rhs);
+		el_x64_packed(a, in->op == el_IR_AND ? el_X64_POR : el_X64_PAND, width, t0, t0, el_x64_reg(t1));
+		el_x64_packed(a, el_X64_PCMPEQQ, width, t1, t1, el_x64_reg(t1));
+		el_x64_packed(a, el_X64_PXOR, width, t0, t0, el_x64_reg(t1));
+		el_x64_packed_shift(a, el_X64_PSRLQ, width, dst, t0, 63);
+		break;
+	case el_IR_GET_ELEMENT:
+		el_x64_packed(a, el_X64_MOVUPD, width, dst, 0, el_x64_mem_indexed(plan->gprs[in->b], el_X64_RCX, 8, 8));
+		break;
+	case el_IR_SET_ELEMENT:
+		el_x64_packed_store(a, width, el_x64_mem_indexed(plan->gprs[in->a], el_X64_RCX, 8, 8), plan->vectors[in->c]);
+		break;
+	default:
+		assert(false);
+	}
+}
+
+static bool el_jit_take_vector(uint32_t * free_vectors, int * vector)
+{
+	for(int i = 0; i < JIT_KERNEL_NUM_VECTORS; ++i)
+	{
+		if(*free_vectors & (1u << i))
+		{
+			*free_vectors &= ~(1u << i);
+			*vector = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Allocates the result, then runs the lanes in as few packed ops as the vector width allows, e.g. one ymm op for a float4
+// rax holds the result and rcx, rdx its operands, xmm0 to xmm3 are free as the allocation call clobbered them
+static void el_jit_emit_vector_op(struct el_jit_compiler * c, struct el_ir_instruction const * in)
+{
+	struct el_x64_assembler * a = &c->a;
+	int size = el_get_layout(&c->module->layout, c->function->register_types[in->a])->block_size;
+	el_jit_store_value(c, el_jit_staging(c, 0), in->b);
+	el_jit_store_value(c, el_jit_staging(c, 1), in->c);
+	if(c->function->owned_vectors[in->a])
+	{
+		// Lanes are independent, so the block may also be an operand's
+		el_jit_emit_owned_vector(c, in->a, size / (int)sizeof(union el_value));
+	}
+	else
+	{
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDI), (long long)(uintptr_t)c->runtime);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RSI), c->function_index);
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RDX), size / (int)sizeof(union el_value));
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RCX), 0);
+		el_jit_emit_helper_call(c, (void (*)(void))el_jit_new_vector);
+	}
+	el_jit_emit_vector_address(c, el_X64_RCX, 0);
+	el_jit_emit_vector_address(c, el_X64_RDX, 1);
+
+	bool used_ymm = false;
+	for(int offset = 0; offset < size;)
+	{
+		int width = c->vector_width == 32 && size - offset >= 32 ? 32 : 16;
+		// Lanes are only 8 byte aligned, which the sse encoding faults on unless the operand is loaded by movupd
+		struct el_x64_operand rhs = el_x64_mem(el_X64_RDX, offset);
+		el_x64_packed(a, el_X64_MOVUPD, width, 0, 0, el_x64_mem(el_X64_RCX, offset));
+		if(width == 16 || in->op == el_IR_MUL_INT_VECTOR)
+		{
+			el_x64_packed(a, el_X64_MOVUPD, width, 1, 0, rhs);
+			rhs = el_x64_reg(1);
+		}
+		switch(in->op)
+		{
+		case el_IR_ADD_INT_VECTOR:
+			el_x64_packed(a, el_X64_PADDQ, width, 0, 0, rhs);
+			break;
+		case el_IR_SUB_INT_VECTOR:
+			el_x64_packed(a, el_X64_PSUBQ, width, 0, 0, rhs);
+			break;
+		case el_IR_MUL_INT_VECTOR:
+			// As in kernels, the low 64 bits of the product from three 32 bit multiplies
+			el_x64_packed_shift(a, el_X64_PSRLQ, width, 2, 0, 32);
+			el_x64_packed(a, el_X64_PMULUDQ, width, 2, 2, el_x64_reg(1));
+			el_x64_packed_shift(a, el_X64_PSRLQ, width, 3, 1, 32);
+			el_x64_packed(a, el_X64_PMULUDQ, width, 3, 3, el_x64_reg(0));
+			el_x64_packed(a, el_X64_PADDQ, width, 2, 2, el_x64_reg(3));
+			el_x64_packed_shift(a, el_X64_PSLLQ, width, 2, 2, 32);
+			el_x64_packed(a, el_X64_PMULUDQ, width, 0, 0, el_x64_reg(1));
+			el_x64_packed(a, el_X64_PADDQ, width, 0, 0, el_x64_reg(2));
+			break;
+		case el_IR_ADD_FLOAT_VECTOR:
+			el_x64_packed(a, el_X64_ADDPD, width, 0, 0, rhs);
+			break;
+		case el_IR_SUB_FLOAT_VECTOR:
+			el_x64_packed(a, el_X64_SUBPD, width, 0, 0, rhs);
+			break;
+		case el_IR_MUL_FLOAT_VECTOR:
+			el_x64_packed(a, el_X64_MULPD, width, 0, 0, rhs);
+			break;
+		default:
+			el_x64_packed(a, el_X64_DIVPD, width, 0, 0, rhs);
+			break;
+		}
+		el_x64_packed_store(a, width, el_x64_mem(el_X64_RAX, offset), 0);
+		used_ymm = used_ymm || width == 32;
+		offset += width;
+	}
+	if(used_ymm)
+	{
+		el_x64_vzeroupper(a);
+	}
+	el_jit_set_gpr(c, in->a, el_X64_RAX);
+}
+
+// Point rax at the block reg owns, allocating one of num_lanes lanes while reg is NULL, see owned_vectors
+// Staged values survive the allocation, registers are clobbered as by any call
+static void el_jit_emit_owned_vector(struct el_jit_compiler * c, int reg, int num_lanes)
+{
+	struct el_x64_assembler * a = &c->a;
+	el_jit_load_gpr(c, el_X64_RAX, reg);
+	el_x64_test(a, el_x64_reg(el_X64_RAX), el_X64_RAX);
+	int has_block = el_x64_jcc(a, el_X64_NOT_EQUAL);
+	el_x64_mov_imm(a, el_x64_reg(el_X64_RDI), (long long)(uintptr_t)c->runtime);
+	el_x64_mov_imm(a, el_x64_reg(el_X64_RSI), c->function_index);
+	el_x64_mov_imm(a, el_x64_reg(el_X64_RDX), num_lanes);
+	el_x64_mov_imm(a, el_x64_reg(el_X64_RCX), 0);
+	el_jit_emit_helper_call(c, (void (*)(void))el_jit_new_vector);
+	el_x64_patch(a, has_block, el_x64_offset(a));
+}
+
+// Point machine_register at the lanes of the vector it holds, or of vector_zeros if it is NULL
+// slot >= 0 loads the vector from that staging slot first
+static void el_jit_emit_vector_address(struct el_jit_compiler * c, int machine_register, int slot)
+{
+	struct el_x64_assembler * a = &c->a;
+	if(slot >= 0)
+	{
+		el_x64_mov(a, machine_register, el_jit_staging(c, slot));
+	}
+	el_x64_test(a, el_x64_reg(machine_register), machine_register);
+	int has_lanes = el_x64_jcc(a, el_X64_NOT_EQUAL);
+	el_x64_mov_imm(a, el_x64_reg(machine_register), (long long)(uintptr_t)vector_zeros);
+	el_x64_patch(a, has_lanes, el_x64_offset(a));
+}
+
+// Entry thunks take the arguments and result as el_value arrays, and call the function as compiled code does
+static void el_jit_emit_entry(struct el_jit_compiler * c, int function_index)
+{
+	struct el_x64_assembler * a = &c->a;
+	struct el_ir_function const * function = &c->module->functions[function_index];
+
+	// rbx and r12 hold the result and arguments across the call, and with rbp keep rsp aligned
+	el_x64_push(a, el_X64_RBP);
+	el_x64_mov(a, el_X64_RBP, el_x64_reg(el_X64_RSP));
+	el_x64_push(a, el_X64_RBX);
+	el_x64_push(a, el_X64_R12);
+	el_x64_mov(a, el_X64_RBX, el_x64_reg(el_X64_RSI));
+	el_x64_mov(a, el_X64_R12, el_x64_reg(el_X64_RDI));
+
+	int num_gprs = 0;
+	int num_xmms = 0;
+	for(int k = 0; k < function->num_parameters; ++k)
+	{
+		*(el_jit_is_float(function, k) ? &num_xmms : &num_gprs) += 1;
+	}
+	int num_stack = (num_gprs > JIT_NUM_ARGUMENT_GPRS ? num_gprs - JIT_NUM_ARGUMENT_GPRS : 0) + (num_xmms > JIT_NUM_ARGUMENT_XMMS ? num_xmms - JIT_NUM_ARGUMENT_XMMS : 0);
+
+	// Stack arguments are pushed last to first, after padding which keeps rsp aligned
+	if(num_stack % 2 == 1)
+	{
+		el_x64_alu_imm(a, el_X64_SUB, el_x64_reg(el_X64_RSP), 8);
+	}
+	for(int k = function->num_parameters - 1; k >= 0; --k)
+	{
+		bool is_float = el_jit_is_float(function, k);
+		if(is_float ? --num_xmms >= JIT_NUM_ARGUMENT_XMMS : --num_gprs >= JIT_NUM_ARGUMENT_GPRS)
+		{
+			el_x64_mov(a, el_X64_RAX, el_x64_mem(el_X64_R12, 8 * k));
+			el_x64_push(a, el_X64_RAX);
+		}
+	}
+
+	num_gprs = 0;
+	num_xmms = 0;
+	for(int k = 0; k < function->num_parameters; ++k)
+	{
+		bool is_float = el_jit_is_float(function, k);
+		if(is_float && num_xmms < JIT_NUM_ARGUMENT_XMMS)
+		{
+			el_x64_movsd(a, num_xmms++, el_x64_mem(el_X64_R12, 8 * k));
+		}
+		else if(!is_float && num_gprs < JIT_NUM_ARGUMENT_GPRS)
+		{
+			el_x64_mov(a, argument_gprs[num_gprs++], el_x64_mem(el_X64_R12, 8 * k));
+		}
+	}
+
+	struct el_jit_fixup * fixup = el_vector_push(c, call_fixups, NULL);
+	int offset = el_x64_call(a);
+	if(fixup)
+	{
+		*fixup = (struct el_jit_fixup){ offset, function_index };
+	}
+	else
+	{
+		a->failed = true;
+	}
+
+	if(function->return_type == el_FLOAT_TYPE_ID)
+	{
+		el_x64_movsd_store(a, el_x64_mem(el_X64_RBX, 0), 0);
+	}
+	else
+	{
+		el_x64_mov_store(a, el_x64_mem(el_X64_RBX, 0), el_X64_RAX);
+	}
+	el_x64_lea(a, el_X64_RSP, el_x64_mem(el_X64_RBP, -16));
+	el_x64_pop(a, el_X64_R12);
+	el_x64_pop(a, el_X64_RBX);
+	el_x64_pop(a, el_X64_RBP);
+	el_x64_ret(a);
+}
+
+// Stubs run in the frame of the function which failed, s.t. rsp is aligned for the call
+static void el_jit_emit_stubs(struct el_jit_compiler * c)
+{
+	struct el_x64_assembler * a = &c->a;
+	for(int stub = 0; stub < el_jit_stub_count; ++stub)
+	{
+		int start = -1;
+		for(int i = 0; i < c->num_stub_fixups; ++i)
+		{
+			if(c->stub_fixups[i].target != stub)
+				continue;
+
+			if(start < 0)
+			{
+				start = el_x64_offset(a);
+				el_x64_mov_imm(a, el_x64_reg(el_X64_RDI), (long long)(uintptr_t)c->runtime);
+				el_x64_mov_imm(a, el_x64_reg(el_X64_RSI), stub_errors[stub]);
+				el_x64_mov_imm(a, el_x64_reg(el_X64_RDX), c->function_index);
+				el_jit_emit_helper_call(c, (void (*)(void))el_jit_raise);
+			}
+			el_x64_patch(a, c->stub_fixups[i].offset, start);
+		}
+	}
+}
+
+static void el_jit_emit_helper_call(struct el_jit_compiler * c, void (*helper)(void))
+{
+	el_x64_mov_imm(&c->a, el_x64_reg(el_X64_RAX), (long long)(uintptr_t)helper);
+	el_x64_call_indirect(&c->a, el_x64_reg(el_X64_RAX));
+}
+
+// Continue at true_block if condition holds, otherwise at false_block, without jumping to the block laid out next
+static void el_jit_emit_branch(struct el_jit_compiler * c, int condition, int true_block, int false_block, int block)
+{
+	if(true_block == block + 1)
+	{
+		el_jit_emit_jump(c, condition ^ 1, false_block);
+	}
+	else
+	{
+		el_jit_emit_jump(c, condition, true_block);
+		if(false_block != block + 1)
+		{
+			el_jit_emit_jump(c, -1, false_block);
+		}
+	}
+}
+
+// Jump to block if condition holds, or always if condition is -1
+static void el_jit_emit_jump(struct el_jit_compiler * c, int condition, int block)
+{
+	struct el_jit_fixup * fixup = el_vector_push(c, block_fixups, NULL);
+	int offset = condition < 0 ? el_x64_jmp(&c->a) : el_x64_jcc(&c->a, condition);
+	if(fixup)
+	{
+		*fixup = (struct el_jit_fixup){ offset, block };
+	}
+	else
+	{
+		c->a.failed = true;
+	}
+}
+
+static void el_jit_emit_stub_jump(struct el_jit_compiler * c, int condition, int stub)
+{
+	struct el_jit_fixup * fixup = el_vector_push(c, stub_fixups, NULL);
+	int offset = el_x64_jcc(&c->a, condition);
+	if(fixup)
+	{
+		*fixup = (struct el_jit_fixup){ offset, stub };
+	}
+	else
+	{
+		c->a.failed = true;
+	}
+}
+
+static struct el_x64_operand el_jit_location(struct el_jit_compiler const * c, int reg)
+{
+	struct el_lsra_register const * r = &c->allocation.registers[reg];
+	assert(r->location != el_LSRA_UNUSED);
+	if(r->location == el_LSRA_REGISTER)
+		return el_x64_reg(r->index);
+	return el_x64_mem(el_X64_RBP, c->slots_displacement + 8 * r->index);
+}
+
+static struct el_x64_operand el_jit_staging(struct el_jit_compiler const * c, int slot)
+{
+	return el_x64_mem(el_X64_RBP, c->staging_displacement + 8 * slot);
+}
+
+static bool el_jit_is_in_register(struct el_jit_compiler const * c, int reg, int machine_register)
+{
+	struct el_lsra_register const * r = &c->allocation.registers[reg];
+	return r->location == el_LSRA_REGISTER && r->index == machine_register;
+}
+
+static bool el_jit_is_float(struct el_ir_function const * function, int reg)
+{
+	return function->register_types[reg] == el_FLOAT_TYPE_ID;
+}
+
+// a = b op c is computed in a's register, unless writing it before reading c would overwrite c
+static int el_jit_result_register(struct el_jit_compiler const * c, struct el_ir_instruction const * in, int scratch)
+{
+	struct el_lsra_register const * r = &c->allocation.registers[in->a];
+	if(r->location != el_LSRA_REGISTER || (el_jit_is_in_register(c, in->c, r->index) && !el_jit_is_in_register(c, in->b, r->index)))
+		return scratch;
+	return r->index;
+}
+
+// Set value to reg's if it was loaded from an int constant a few instructions before the current one in its block
+static bool el_jit_constant_of(struct el_jit_compiler const * c, int reg, long long * value)
+{
+	struct el_ir_function const * function = c->function;
+	int first = function->blocks[c->block].first_instruction;
+	for(int i = c->instruction - 1; i >= first && i >= c->instruction - JIT_CONSTANT_WINDOW; --i)
+	{
+		struct el_ir_instruction const * in = &function->instructions[i];
+		if(in->a != reg || !el_ir_op_info(in->op)->writes_a)
+			continue;
+
+		if(in->op != el_IR_LOAD_INT)
+			return false;
+
+		*value = c->module->int_constants[in->b];
+		return true;
+	}
+	return false;
+}
+
+static bool el_jit_is_imm32(long long value)
+{
+	return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+static void el_jit_load_gpr(struct el_jit_compiler * c, int machine_register, int reg)
+{
+	if(!el_jit_is_in_register(c, reg, machine_register))
+	{
+		el_x64_mov(&c->a, machine_register, el_jit_location(c, reg));
+	}
+}
+
+static void el_jit_load_xmm(struct el_jit_compiler * c, int machine_register, int reg)
+{
+	if(!el_jit_is_in_register(c, reg, machine_register))
+	{
+		el_x64_movsd(&c->a, machine_register, el_jit_location(c, reg));
+	}
+}
+
+// The machine register holding reg, loading it into scratch if it is on the stack
+static int el_jit_gpr_of(struct el_jit_compiler * c, int reg, int scratch)
+{
+	struct el_x64_operand location = el_jit_location(c, reg);
+	if(!location.is_memory)
+		return location.reg;
+
+	el_x64_mov(&c->a, scratch, location);
+	return scratch;
+}
+
+static int el_jit_xmm_of(struct el_jit_compiler * c, int reg, int scratch)
+{
+	struct el_x64_operand location = el_jit_location(c, reg);
+	if(!location.is_memory)
+		return location.reg;
+
+	el_x64_movsd(&c->a, scratch, location);
+	return scratch;
+}
+
+// Results written to registers nothing reads are dropped
+static void el_jit_set_gpr(struct el_jit_compiler * c, int reg, int machine_register)
+{
+	if(c->allocation.registers[reg].location == el_LSRA_UNUSED || el_jit_is_in_register(c, reg, machine_register))
+		return;
+
+	struct el_x64_operand location = el_jit_location(c, reg);
+	if(location.is_memory)
+	{
+		el_x64_mov_store(&c->a, location, machine_register);
+	}
+	else
+	{
+		el_x64_mov(&c->a, location.reg, el_x64_reg(machine_register));
+	}
+}
+
+static void el_jit_set_xmm(struct el_jit_compiler * c, int reg, int machine_register)
+{
+	if(c->allocation.registers[reg].location == el_LSRA_UNUSED || el_jit_is_in_register(c, reg, machine_register))
+		return;
+
+	el_x64_movsd_store(&c->a, el_jit_location(c, reg), machine_register);
+}
+
+// Set reg to the 8 bytes of bits, which are a float's if reg is a float
+static void el_jit_set_constant(struct el_jit_compiler * c, int reg, long long bits)
+{
+	struct el_x64_assembler * a = &c->a;
+	if(c->allocation.registers[reg].location == el_LSRA_UNUSED)
+		return;
+
+	struct el_x64_operand location = el_jit_location(c, reg);
+	if(!location.is_memory && el_jit_is_float(c->function, reg))
+	{
+		if(bits == 0)
+		{
+			el_x64_xorpd(a, location.reg, location.reg);
+		}
+		else
+		{
+			el_x64_mov_imm(a, el_x64_reg(el_X64_RAX), bits);
+			el_x64_movq_to_xmm(a, location.reg, el_x64_reg(el_X64_RAX));
+		}
+	}
+	else if(!location.is_memory || (bits >= INT32_MIN && bits <= INT32_MAX))
+	{
+		el_x64_mov_imm(a, location, bits);
+	}
+	else
+	{
+		el_x64_mov_imm(a, el_x64_reg(el_X64_RAX), bits);
+		el_x64_mov_store(a, location, el_X64_RAX);
+	}
+}
+
+static void el_jit_move(struct el_jit_compiler * c, int dst, int src)
+{
+	if(c->allocation.registers[dst].location == el_LSRA_UNUSED)
+		return;
+
+	struct el_x64_operand location = el_jit_location(c, dst);
+	if(location.is_memory)
+	{
+		el_jit_store_value(c, location, src);
+	}
+	else if(el_jit_is_float(c->function, dst))
+	{
+		el_jit_load_xmm(c, location.reg, src);
+	}
+	else
+	{
+		el_jit_load_gpr(c, location.reg, src);
+	}
+}
+
+// Copies between memory go through r11, s.t. src and dst may be addressed with the other scratch registers
+static void el_jit_load_value(struct el_jit_compiler * c, int reg, struct el_x64_operand src)
+{
+	struct el_x64_assembler * a = &c->a;
+	if(c->allocation.registers[reg].location == el_LSRA_UNUSED)
+		return;
+
+	struct el_x64_operand location = el_jit_location(c, reg);
+	if(location.is_memory)
+	{
+		el_x64_mov(a, el_X64_R11, src);
+		el_x64_mov_store(a, location, el_X64_R11);
+	}
+	else if(el_jit_is_float(c->function, reg))
+	{
+		el_x64_movsd(a, location.reg, src);
+	}
+	else
+	{
+		el_x64_mov(a, location.reg, src);
+	}
+}
+
+static void el_jit_store_value(struct el_jit_compiler * c, struct el_x64_operand dst, int reg)
+{
+	struct el_x64_assembler * a = &c->a;
+	struct el_x64_operand location = el_jit_location(c, reg);
+	if(location.is_memory)
+	{
+		el_x64_mov(a, el_X64_R11, location);
+		el_x64_mov_store(a, dst, el_X64_R11);
+	}
+	else if(el_jit_is_float(c->function, reg))
+	{
+		el_x64_movsd_store(a, dst, location.reg);
+	}
+	else
+	{
+		el_x64_mov_store(a, dst, location.reg);
+	}
+}
+
+// Of a field of the block reg references
+static int el_jit_field_offset(struct el_jit_compiler const * c, int reg, int field)
+{
+	return el_get_layout(&c->module->layout, c->function->register_types[reg])->field_offsets[field];
+}
+
+// Code is written while the pages are writable and only then made executable, s.t. no page is ever both
+static int el_jit_map_code(struct el_jit * jit, struct el_x64_assembler const * a)
+{
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	size_t size = ((size_t)a->num_code + page_size - 1) / page_size * page_size;
+	size = size > 0 ? size : page_size;
+	void * code = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(code == MAP_FAILED)
+		return el_ALLOCATION_ERROR;
+
+	memcpy(code, a->code, (size_t)a->num_code);
+	if(mprotect(code, size, PROT_READ | PROT_EXEC) != 0)
+	{
+		munmap(code, size);
+		return el_ALLOCATION_ERROR;
+	}
+	jit->code = code;
+	jit->code_size = size;
+	return el_SUCCESS;
+}
+
+static void el_jit_compiler_delete(struct el_jit_compiler * c)
+{
+	el_x64_assembler_delete(&c->a);
+	el_lsra_allocation_delete(&c->allocation);
+	el_vector_free(c, function_starts, NULL);
+	el_vector_free(c, call_fixups, NULL);
+	el_vector_free(c, block_starts, NULL);
+	el_vector_free(c, block_fixups, NULL);
+	el_vector_free(c, stub_fixups, NULL);
+	el_vector_free(c, return_fixups, NULL);
+}
+
+// Unwinds every compiled frame back to the el_jit_call or chunk the thread is running, none of which hold anything to release
+// The error is reported by el_jit_call, s.t. only the first of a parallel for's chunks to fail is reported
+static void el_jit_raise(struct el_jit_runtime * runtime, int err, int function)
+{
+	(void)runtime;
+	struct el_jit_thread * thread = el_jit_current;
+	thread->error = err;
+	thread->error_function = function;
+	longjmp(thread->on_error, 1);
+}
+
+// Run every chunk on the runtime's pool, then move the chunks' heaps to the calling thread s.t. what they allocated lives as long as it does
+// The first runtime error raised by a chunk is raised again on the calling thread, chunks not yet started once one has failed are skipped
+// operands are the parallel for's, the length of its range followed by the values passed to every chunk
+static void el_jit_parallel_for(struct el_jit_runtime * runtime, int function, int chunk_function, long long num_chunks, union el_value const * operands)
+{
+	struct el_jit_thread * caller = el_jit_current;
+	if(num_chunks <= 0)
+		return;
+
+	// A chunk's own parallel for runs in serial on the chunk's thread, as the pool is busy running the chunk
+	bool is_nested = caller->is_chunk;
+	if(!is_nested && !runtime->pool)
+	{
+		runtime->pool = fmalloc(sizeof(struct el_thread_pool));
+		if(!runtime->pool)
+		{
+			el_jit_raise(runtime, el_ALLOCATION_ERROR, function);
+		}
+		if(!el_thread_pool_new(runtime->pool, 0))
+		{
+			el_thread_pool_delete(runtime->pool);
+			ffree(runtime->pool);
+			runtime->pool = NULL;
+			el_jit_raise(runtime, el_ALLOCATION_ERROR, function);
+		}
+	}
+
+	struct el_ir_function const * callee = &runtime->module->functions[chunk_function];
+	int num_threads = is_nested ? 1 : runtime->pool->num_threads + 1;
+	struct el_jit_parallel_for parallel_for = {
+		.entry = (void (*)(union el_value const *, union el_value *))(uintptr_t)(runtime->code + runtime->entries[chunk_function]),
+		.num_parameters = callee->num_parameters,
+		.num_chunks = (int)num_chunks,
+		.length = operands[0].i,
+		.arguments = fmalloc(sizeof(union el_value) * (size_t)callee->num_parameters * (size_t)num_threads),
+		.threads = fmalloc(sizeof(struct el_jit_thread) * (size_t)num_threads),
+		.error = el_SUCCESS
+	};
+	if(!parallel_for.arguments || !parallel_for.threads)
+	{
+		ffree(parallel_for.arguments);
+		ffree(parallel_for.threads);
+		el_jit_raise(runtime, el_ALLOCATION_ERROR, function);
+	}
+	for(int i = 0; i < num_threads; ++i)
+	{
+		parallel_for.threads[i] = (struct el_jit_thread){ .is_chunk = true };
+		union el_value * arguments = parallel_for.arguments + (size_t)callee->num_parameters * (size_t)i;
+		for(int j = 3; j < callee->num_parameters; ++j)
+		{
+			arguments[j] = operands[j - 2];
+		}
+	}
+
+	if(is_nested)
+	{
+		for(int i = 0; i < parallel_for.num_chunks; ++i)
+		{
+			el_jit_run_chunk(&parallel_for, i, 0);
+		}
+	}
+	else
+	{
+		el_thread_pool_for(runtime->pool, parallel_for.num_chunks, el_jit_run_chunk, &parallel_for);
+	}
+
+	// A large chunk may be in front of a thread's heap, which is kept behind the caller's current chunk
+	for(int i = 0; i < num_threads; ++i)
+	{
+		struct el_jit_heap_chunk * heap = parallel_for.threads[i].heap;
+		if(!heap)
+			continue;
+
+		struct el_jit_heap_chunk * last = heap;
+		while(last->next)
+		{
+			last = last->next;
+		}
+		if(caller->heap)
+		{
+			last->next = caller->heap->next;
+			caller->heap->next = heap;
+		}
+		else
+		{
+			caller->heap = heap;
+		}
+	}
+	ffree(parallel_for.arguments);
+	ffree(parallel_for.threads);
+
+	if(parallel_for.error)
+	{
+		el_jit_raise(runtime, parallel_for.error, parallel_for.error_function);
+	}
+}
+
+// Pool threads measure their stack limit from the first chunk they run, the calling thread keeps its own
+static void el_jit_run_chunk(void * context, int chunk, int thread_index)
+{
+	struct el_jit_parallel_for * parallel_for = context;
+	if(parallel_for->num_failed > 0)
+		return;
+
+	struct el_jit_thread * caller = el_jit_current;
+	uintptr_t stack_limit = el_jit_stack_limit;
+	char stack_top;
+	if(!caller)
+	{
+		el_jit_stack_limit = (uintptr_t)&stack_top - JIT_WORKER_STACK_SIZE;
+	}
+
+	struct el_jit_thread * thread = &parallel_for->threads[thread_index];
+	union el_value * arguments = parallel_for->arguments + (size_t)parallel_for->num_parameters * (size_t)thread_index;
+	el_ir_chunk_bounds(parallel_for->length, parallel_for->num_chunks, chunk, &arguments[0].i, &arguments[1].i);
+	arguments[2].i = chunk;
+	union el_value result;
+	el_jit_current = thread;
+	if(setjmp(thread->on_error) == 0)
+	{
+		parallel_for->entry(arguments, &result);
+	}
+	else if(el_atomic_fetch_add(&parallel_for->num_failed, 1) == 0)
+	{
+		parallel_for->error = thread->error;
+		parallel_for->error_function = thread->error_function;
+	}
+	el_jit_current = caller;
+	el_jit_stack_limit = stack_limit;
+}
+
+static union el_value * el_jit_new_dat(struct el_jit_runtime * runtime, int function, long long num_fields)
+{
+	union el_value * fields = el_jit_alloc(el_jit_current, num_fields > 0 ? (size_t)num_fields : 1);
+	if(!fields)
+	{
+		el_jit_raise(runtime, el_ALLOCATION_ERROR, function);
+	}
+	memset(fields, 0, sizeof(union el_value) * (size_t)num_fields);
+	return fields;
+}
+
+// values is NULL for a slice of zeros
+static struct el_vm_slice * el_jit_new_slice(struct el_jit_runtime * runtime, int function, long long length, union el_value const * values)
+{
+	struct el_vm_slice * slice = (struct el_vm_slice *)el_jit_alloc(el_jit_current, 1 + (size_t)length);
+	if(!slice)
+	{
+		el_jit_raise(runtime, el_ALLOCATION_ERROR, function);
+	}
+	slice->length = length;
+	if(values)
+	{
+		memcpy(slice->elements, values, sizeof(union el_value) * (size_t)length);
+	}
+	else
+	{
+		memset(slice->elements, 0, sizeof(union el_value) * (size_t)length);
+	}
+	return slice;
+}
+
+// values is NULL for lanes written by the caller
+static union el_value * el_jit_new_vector(struct el_jit_runtime * runtime, int function, long long num_lanes, union el_value const * values)
+{
+	union el_value * lanes = el_jit_alloc(el_jit_current, (size_t)num_lanes);
+	if(!lanes)
+	{
+		el_jit_raise(runtime, el_ALLOCATION_ERROR, function);
+	}
+	if(values)
+	{
+		memcpy(lanes, values, sizeof(union el_value) * (size_t)num_lanes);
+	}
+	return lanes;
+}
+
+// The zero value of a string is NULL, which equals the empty string
+static long long el_jit_strings_equal(el_string lhs, el_string rhs)
+{
+	if(!lhs || !rhs)
+		return (lhs ? el_string_length(lhs) : 0) == (rhs ? el_string_length(rhs) : 0);
+	return el_string_equals(lhs, rhs);
+}
+
+static union el_value * el_jit_alloc(struct el_jit_thread * thread, size_t num_values)
+{
+	struct el_jit_heap_chunk * chunk = thread->heap;
+	if(!chunk || chunk->capacity - chunk->size < num_values)
+	{
+		size_t capacity = num_values > JIT_HEAP_CHUNK_SIZE ? num_values : JIT_HEAP_CHUNK_SIZE;
+		chunk = fmalloc(sizeof(struct el_jit_heap_chunk) + sizeof(union el_value) * capacity);
+		if(!chunk)
+			return NULL;
+
+		chunk->size = 0;
+		chunk->capacity = capacity;
+
+		// A chunk holding a single large object goes behind the current chunk, s.t. the space left in the current chunk is kept
+		if(thread->heap && capacity > JIT_HEAP_CHUNK_SIZE)
+		{
+			chunk->next = thread->heap->next;
+			thread->heap->next = chunk;
+		}
+		else
+		{
+			chunk->next = thread->heap;
+			thread->heap = chunk;
+		}
+	}
+
+	union el_value * values = chunk->values + chunk->size;
+	chunk->size += num_values;
+	return values;
+}
+
+// Half the thread's stack limit leaves room for the frames below el_jit_call and the largest compiled frame
+static size_t el_jit_stack_size(void)
+{
+	struct rlimit limit;
+	if(getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur / 2 < JIT_MAX_STACK_SIZE)
+		return (size_t)limit.rlim_cur / 2;
+	return JIT_MAX_STACK_SIZE;
+}
+
+// fs:0 holds the thread pointer itself
+static int el_jit_stack_limit_offset(void)
+{
+	uintptr_t thread_pointer;
+	__asm__("mov %%fs:0, %0" : "=r"(thread_pointer));
+	intptr_t offset = (intptr_t)&el_jit_stack_limit - (intptr_t)thread_pointer;
+	assert(offset >= INT_MIN && offset <= INT_MAX);
+	return (int)offset;
+}
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+#include <compiler/ir/ir.h>
+#include <vm/vm.h>
+
+struct el_jit_runtime;
+
+// Functions of an ir module compiled to x86-64 machine code in executable memory
+// Values are laid out as in the vm, s.t. arguments and results are el_values and slices are el_vm_slices
+struct el_jit
+{
+	struct el_ir_module const * module;
+	struct el_jit_runtime * runtime; // Globals, heap and error state the machine code refers to by address
+
+	uint8_t * code; // Mapped executable, and read only once written
+	size_t code_size;
+	int * entries; // Offset in code of each function's entry thunk, which calls the function with el_values
+};
+
+// Compile every function of module, which must outlive the jit
+// Only x86-64 System V platforms are supported, elsewhere el_JIT_UNSUPPORTED_PLATFORM_ERROR is returned
+int el_jit_compile(struct el_jit * jit, struct el_ir_module const * module);
+
+void el_jit_delete(struct el_jit * jit);
+
+// Run the function with the module's num_parameters arguments, result receives its return value if it is not NULL
+// A runtime error is reported along with the function it occurred in and returned, as el_vm_call does
+// Recursion is limited to a few MiB of the calling thread's stack rather than the vm's frame count
+// Parallel for statements run their chunks on a pool of threads created by the first of them, each with 1 MiB of stack
+int el_jit_call(struct el_jit * jit, int function, union el_value const * arguments, union el_value * result);
@@ -0,0 +1,549 @@
+#include "linear-scan.h"
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <compiler/semantic-analysis/type-table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+
+// Loops nested deeper than this weigh the same as this
+#define LSRA_MAX_LOOP_DEPTH 8
+
+// Registers an instruction reads and writes
+struct el_lsra_operands
+{
+	int reads[3];
+	int num_reads;
+	uint16_t const * list; // Registers of a call or slice literal
+	int num_list;
+	int write; // -1 if the instruction writes no register
+};
+
+struct el_lsra_interval
+{
+	int start;
+	int end;
+	int reg;
+};
+
+struct el_lsra
+{
+	struct el_ir_module const * module;
+	struct el_ir_function const * function;
+	struct el_lsra_allocation * allocation;
+
+	// One bitset of registers per block
+	int num_words;
+	uint64_t * live_in;
+	uint64_t * live_out;
+	uint64_t * uses; // Read before they are written in the block
+	uint64_t * defs;
+
+	int * calls; // Instructions which clobber the caller saved registers, in order
+	int num_calls;
+
+	// Cost of spilling each register, its reads and writes weighted by the depth of the loops they are in
+	long long * spill_weights;
+};
+
+static int el_lsra_compute_liveness(struct el_lsra * l);
+static void el_lsra_compute_intervals(struct el_lsra * l);
+static int el_lsra_compute_spill_weights(struct el_lsra * l);
+static int el_lsra_scan(struct el_lsra * l);
+static void el_lsra_get_operands(struct el_lsra const * l, struct el_ir_instruction const * in, struct el_lsra_operands * operands);
+static int el_lsra_successors(struct el_ir_function const * function, int block, int successors[2]);
+static bool el_lsra_crosses_call(struct el_lsra const * l, struct el_lsra_register const * r);
+static bool el_lsra_is_float(struct el_lsra const * l, int reg);
+static bool el_lsra_is_cheaper_to_spill(struct el_lsra const * l, int reg, int other);
+static int el_lsra_take(uint32_t * free, uint32_t candidates);
+static int el_lsra_compare_intervals(void const * lhs, void const * rhs);
+static void el_lsra_delete(struct el_lsra * l);
+
+static inline bool el_bit(uint64_t const * set, int i)
+{
+	return (set[i >> 6] >> (i & 63)) & 1;
+}
+
+static inline void el_set_bit(uint64_t * set, int i)
+{
+	set[i >> 6] |= 1ull << (i & 63);
+}
+
+int el_lsra_allocate(struct el_lsra_allocation * allocation, struct el_ir_module const * module, struct el_ir_function const * function)
+{
+	assert(allocation && module && function);
+	*allocation = (struct el_lsra_allocation){
+		.registers = fmalloc(sizeof(struct el_lsra_register) * (function->num_registers > 0 ? function->num_registers : 1)),
+		.num_registers = function->num_registers
+	};
+	if(!allocation->registers)
+		return el_ALLOCATION_ERROR;
+
+	for(int i = 0; i < function->num_registers; ++i)
+	{
+		allocation->registers[i] = (struct el_lsra_register){ .location = el_LSRA_UNUSED, .start = INT_MAX, .end = -1 };
+	}
+
+	struct el_lsra l = { .module = module, .function = function, .allocation = allocation };
+	int err = el_lsra_compute_liveness(&l);
+	if(err == el_SUCCESS)
+	{
+		el_lsra_compute_intervals(&l);
+		err = el_lsra_compute_spill_weights(&l);
+		err = err || el_lsra_scan(&l);
+	}
+	el_lsra_delete(&l);
+	if(err)
+	{
+		el_lsra_allocation_delete(allocation);
+	}
+	return err;
+}
+
+void el_lsra_allocation_delete(struct el_lsra_allocation * allocation)
+{
+	if(allocation)
+	{
+		ffree(allocation->registers);
+		*allocation = (struct el_lsra_allocation){ 0 };
+	}
+}
+
+// Iterate live_in = uses | (live_out & ~defs) over the blocks backwards until nothing changes
+static int el_lsra_compute_liveness(struct el_lsra * l)
+{
+	struct el_ir_function const * function = l->function;
+	l->num_words = (function->num_registers + 63) / 64;
+	size_t set_size = sizeof(uint64_t) * (size_t)l->num_words * (size_t)function->num_blocks;
+	l->live_in = fmalloc(set_size + 1);
+	l->live_out = fmalloc(set_size + 1);
+	l->uses = fmalloc(set_size + 1);
+	l->defs = fmalloc(set_size + 1);
+	l->calls = fmalloc(sizeof(int) * (size_t)(function->num_instructions + 1));
+	if(!l->live_in || !l->live_out || !l->uses || !l->defs || !l->calls)
+		return el_ALLOCATION_ERROR;
+
+	memset(l->live_in, 0, set_size);
+	memset(l->live_out, 0, set_size);
+	memset(l->uses, 0, set_size);
+	memset(l->defs, 0, set_size);
+
+	for(int b = 0; b < function->num_blocks; ++b)
+	{
+		struct el_ir_block const * block = &function->blocks[b];
+		uint64_t * uses = l->uses + (size_t)b * l->num_words;
+		uint64_t * defs = l->defs + (size_t)b * l->num_words;
+		for(int i = block->first_instruction; i < block->first_instruction + block->num_instructions; ++i)
+		{
+			struct el_lsra_operands operands;
+			el_lsra_get_operands(l, &function->instructions[i], &operands);
+			for(int j = 0; j < operands.num_reads; ++j)
+			{
+				if(!el_bit(defs, operands.reads[j]))
+				{
+					el_set_bit(uses, operands.reads[j]);
+				}
+			}
+			for(int j = 0; j < operands.num_list; ++j)
+			{
+				if(!el_bit(defs, operands.list[j]))
+				{
+					el_set_bit(uses, operands.list[j]);
+				}
+			}
+			if(operands.write >= 0)
+			{
+				el_set_bit(defs, operands.write);
+			}
+		}
+	}
+
+	bool changed = true;
+	while(changed)
+	{
+		changed = false;
+		for(int b = function->num_blocks - 1; b >= 0; --b)
+		{
+			uint64_t * live_in = l->live_in + (size_t)b * l->num_words;
+			uint64_t * live_out = l->live_out + (size_t)b * l->num_words;
+			uint64_t const * uses = l->uses + (size_t)b * l->num_words;
+			uint64_t const * defs = l->defs + (size_t)b * l->num_words;
+			int successors[2];
+			int num_successors = el_lsra_successors(function, b, successors);
+			for(int w = 0; w < l->num_words; ++w)
+			{
+				uint64_t out = 0;
+				for(int s = 0; s < num_successors; ++s)
+				{
+					out |= l->live_in[(size_t)successors[s] * l->num_words + w];
+				}
+				uint64_t in = uses[w] | (out & ~defs[w]);
+				changed = changed || in != live_in[w];
+				live_out[w] = out;
+				live_in[w] = in;
+			}
+		}
+	}
+	return el_SUCCESS;
+}
+
+// A register's interval is the hull of every position it is live at
+static void el_lsra_compute_intervals(struct el_lsra * l)
+{
+	struct el_ir_function const * function = l->function;
+	struct el_lsra_register * registers = l->allocation->registers;
+	for(int b = 0; b < function->num_blocks; ++b)
+	{
+		struct el_ir_block const * block = &function->blocks[b];
+		int first = block->first_instruction;
+		int last = first + block->num_instructions - 1;
+		uint64_t const * live_in = l->live_in + (size_t)b * l->num_words;
+		uint64_t const * live_out = l->live_out + (size_t)b * l->num_words;
+		for(int r = 0; r < function->num_registers; ++r)
+		{
+			if(el_bit(live_in, r) && 2 * first < registers[r].start)
+			{
+				registers[r].start = 2 * first;
+			}
+			if(el_bit(live_out, r) && 2 * last + 1 > registers[r].end)
+			{
+				registers[r].end = 2 * last + 1;
+			}
+		}
+
+		for(int i = first; i <= last; ++i)
+		{
+			struct el_ir_instruction const * in = &function->instructions[i];
+			struct el_lsra_operands operands;
+			el_lsra_get_operands(l, in, &operands);
+			for(int j = 0; j < operands.num_reads + operands.num_list; ++j)
+			{
+				struct el_lsra_register * r = &registers[j < operands.num_reads ? operands.reads[j] : operands.list[j - operands.num_reads]];
+				r->start = 2 * i < r->start ? 2 * i : r->start;
+				r->end = 2 * i > r->end ? 2 * i : r->end;
+			}
+			if(operands.write >= 0)
+			{
+				struct el_lsra_register * r = &registers[operands.write];
+				r->start = 2 * i + 1 < r->start ? 2 * i + 1 : r->start;
+				r->end = 2 * i + 1 > r->end ? 2 * i + 1 : r->end;
+			}
+			if(el_lsra_is_call(in->op))
+			{
+				l->calls[l->num_calls++] = i;
+			}
+		}
+	}
+
+	// Parameters and registers read before they are written hold their value from the entry on
+	// Their intervals start before the read position of instruction 0, s.t. a call there is crossed rather than taken to start them
+	uint64_t const * entry_live_in = l->live_in;
+	for(int r = 0; r < function->num_registers; ++r)
+	{
+		bool is_parameter = r < function->num_parameters;
+		registers[r].is_live_at_entry = !is_parameter && function->num_blocks > 0 && el_bit(entry_live_in, r);
+		if((is_parameter || registers[r].is_live_at_entry) && registers[r].end >= 0)
+		{
+			registers[r].start = -1;
+		}
+	}
+
+	// Blocks need not be in instruction order, but calls must be for el_lsra_crosses_call's binary search
+	for(int i = 1; i < l->num_calls; ++i)
+	{
+		for(int j = i; j > 0 && l->calls[j - 1] > l->calls[j]; --j)
+		{
+			int call = l->calls[j];
+			l->calls[j] = l->calls[j - 1];
+			l->calls[j - 1] = call;
+		}
+	}
+}
+
+// A jump back to an earlier block closes a loop, which every instruction between the two is taken to be in
+static int el_lsra_compute_spill_weights(struct el_lsra * l)
+{
+	struct el_ir_function const * function = l->function;
+	int * depth_changes = fmalloc(sizeof(int) * (size_t)(function->num_instructions + 1));
+	l->spill_weights = fmalloc(sizeof(long long) * (size_t)(function->num_registers + 1));
+	if(!depth_changes || !l->spill_weights)
+	{
+		ffree(depth_changes);
+		return el_ALLOCATION_ERROR;
+	}
+	memset(depth_changes, 0, sizeof(int) * (size_t)(function->num_instructions + 1));
+	memset(l->spill_weights, 0, sizeof(long long) * (size_t)function->num_registers);
+
+	for(int b = 0; b < function->num_blocks; ++b)
+	{
+		struct el_ir_block const * block = &function->blocks[b];
+		int successors[2];
+		int num_successors = el_lsra_successors(function, b, successors);
+		for(int s = 0; s < num_successors; ++s)
+		{
+			int header = function->blocks[successors[s]].first_instruction;
+			if(header <= block->first_instruction)
+			{
+				++depth_changes[header];
+				--depth_changes[block->first_instruction + block->num_instructions];
+			}
+		}
+	}
+
+	int depth = 0;
+	for(int i = 0; i < function->num_instructions; ++i)
+	{
+		depth += depth_changes[i];
+		long long weight = 1ll << (3 * (depth < LSRA_MAX_LOOP_DEPTH ? depth : LSRA_MAX_LOOP_DEPTH));
+		struct el_lsra_operands operands;
+		el_lsra_get_operands(l, &function->instructions[i], &operands);
+		for(int j = 0; j < operands.num_reads; ++j)
+		{
+			l->spill_weights[operands.reads[j]] += weight;
+		}
+		for(int j = 0; j < operands.num_list; ++j)
+		{
+			l->spill_weights[operands.list[j]] += weight;
+		}
+		if(operands.write >= 0)
+		{
+			l->spill_weights[operands.write] += weight;
+		}
+	}
+	ffree(depth_changes);
+	return el_SUCCESS;
+}
+
+static int el_lsra_scan(struct el_lsra * l)
+{
+	struct el_ir_function const * function = l->function;
+	struct el_lsra_allocation * allocation = l->allocation;
+	struct el_lsra_register * registers = allocation->registers;
+
+	struct el_lsra_interval * intervals = fmalloc(sizeof(struct el_lsra_interval) * (size_t)(function->num_registers + 1));
+	if(!intervals)
+		return el_ALLOCATION_ERROR;
+
+	int num_intervals = 0;
+	for(int r = 0; r < function->num_registers; ++r)
+	{
+		if(registers[r].end >= 0)
+		{
+			intervals[num_intervals++] = (struct el_lsra_interval){ registers[r].start, registers[r].end, r };
+		}
+	}
+	qsort(intervals, (size_t)num_intervals, sizeof *intervals, el_lsra_compare_intervals);
+
+	// At most every machine register of both classes is active at once
+	int active[2 * el_x64_register_count];
+	int num_active = 0;
+	uint32_t free_gprs = el_LSRA_CALLER_SAVED_GPRS | el_LSRA_CALLEE_SAVED_GPRS;
+	uint32_t free_xmms = el_LSRA_XMMS;
+	for(int i = 0; i < num_intervals; ++i)
+	{
+		int reg = intervals[i].reg;
+		struct el_lsra_register * current = &registers[reg];
+		bool is_float = el_lsra_is_float(l, reg);
+
+		// Registers of intervals which ended before this one starts are free again
+		for(int j = 0; j < num_active;)
+		{
+			struct el_lsra_register const * other = &registers[active[j]];
+			if(other->end < current->start)
+			{
+				*(el_lsra_is_float(l, active[j]) ? &free_xmms : &free_gprs) |= 1u << other->index;
+				active[j] = active[--num_active];
+			}
+			else
+			{
+				++j;
+			}
+		}
+
+		// xmm registers are all caller saved, so a float live across a call always goes on the stack
+		bool crosses_call = el_lsra_crosses_call(l, current);
+		uint32_t candidates = is_float ? (crosses_call ? 0 : el_LSRA_XMMS) : (crosses_call ? el_LSRA_CALLEE_SAVED_GPRS : el_LSRA_CALLER_SAVED_GPRS | el_LSRA_CALLEE_SAVED_GPRS);
+		uint32_t * free = is_float ? &free_xmms : &free_gprs;
+		int index = el_lsra_take(free, candidates & el_LSRA_CALLER_SAVED_GPRS);
+		index = index >= 0 ? index : el_lsra_take(free, candidates);
+		if(index < 0 && candidates != 0)
+		{
+			// Otherwise whichever of this and the active intervals using one of the candidates is cheapest to spill is spilled
+			int cheapest = -1;
+			for(int j = 0; j < num_active; ++j)
+			{
+				if(el_lsra_is_float(l, active[j]) == is_float && (candidates & (1u << registers[active[j]].index))
+					&& (cheapest < 0 || el_lsra_is_cheaper_to_spill(l, active[j], active[cheapest])))
+				{
+					cheapest = j;
+				}
+			}
+			if(cheapest >= 0 && el_lsra_is_cheaper_to_spill(l, active[cheapest], reg))
+			{
+				struct el_lsra_register * spilled = &registers[active[cheapest]];
+				index = spilled->index;
+				spilled->location = el_LSRA_STACK;
+				spilled->index = allocation->num_stack_slots++;
+				active[cheapest] = active[--num_active];
+			}
+		}
+
+		if(index < 0)
+		{
+			current->location = el_LSRA_STACK;
+			current->index = allocation->num_stack_slots++;
+			continue;
+		}
+
+		current->location = el_LSRA_REGISTER;
+		current->index = index;
+		active[num_active++] = reg;
+		if(!is_float && (el_LSRA_CALLEE_SAVED_GPRS & (1u << index)))
+		{
+			allocation->used_callee_saved |= 1u << index;
+		}
+	}
+
+	ffree(intervals);
+	return el_SUCCESS;
+}
+
+static void el_lsra_get_operands(struct el_lsra const * l, struct el_ir_instruction const * in, struct el_lsra_operands * operands)
+{
+	struct el_ir_op_info const * info = el_ir_op_info(in->op);
+	uint16_t const values[3] = { in->a, in->b, in->c };
+	*operands = (struct el_lsra_operands){ .write = -1 };
+	for(int i = 0; i < 3; ++i)
+	{
+		if(info->operand_kinds[i] != el_IR_OPERAND_REGISTER || values[i] == el_IR_NO_REGISTER)
+			continue;
+
+		if(i == 0 && info->writes_a)
+		{
+			operands->write = values[i];
+		}
+		else
+		{
+			operands->reads[operands->num_reads++] = values[i];
+		}
+	}
+
+	// A vector built in place reads the block a owns, which is allocated while a is NULL
+	if(el_ir_builds_vector(in->op) && l->function->owned_vectors[in->a])
+	{
+		operands->reads[operands->num_reads++] = in->a;
+	}
+
+	if(in->op == el_IR_CALL)
+	{
+		operands->list = l->function->operands + in->c;
+		operands->num_list = l->module->functions[in->b].num_parameters;
+	}
+	else if(in->op == el_IR_NEW_SLICE || in->op == el_IR_NEW_VECTOR)
+	{
+		operands->list = l->function->operands + in->c;
+		operands->num_list = in->b;
+	}
+	else if(in->op == el_IR_KERNEL)
+	{
+		operands->list = l->function->operands + in->c;
+		operands->num_list = 1 + l->function->kernels[in->b].num_arguments;
+	}
+	else if(in->op == el_IR_PARALLEL_FOR)
+	{
+		operands->list = l->function->operands + in->c;
+		operands->num_list = l->module->functions[in->b].num_parameters - 2;
+	}
+}
+
+static int el_lsra_successors(struct el_ir_function const * function, int block, int successors[2])
+{
+	struct el_ir_block const * b = &function->blocks[block];
+	struct el_ir_instruction const * terminator = &function->instructions[b->first_instruction + b->num_instructions - 1];
+	switch(terminator->op)
+	{
+	case el_IR_JUMP:
+		successors[0] = terminator->a;
+		return 1;
+	case el_IR_BRANCH:
+		successors[0] = terminator->b;
+		successors[1] = terminator->c;
+		return 2;
+	default:
+		return 0;
+	}
+}
+
+// Whether the register is live both before and after some call, i.e. its interval contains both of the call's positions
+static bool el_lsra_crosses_call(struct el_lsra const * l, struct el_lsra_register const * r)
+{
+	// Find the first call whose read position is after the interval starts
+	int low = 0;
+	int high = l->num_calls;
+	while(low < high)
+	{
+		int middle = (low + high) / 2;
+		if(2 * l->calls[middle] > r->start)
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle + 1;
+		}
+	}
+	return low < l->num_calls && 2 * l->calls[low] + 1 < r->end;
+}
+
+static bool el_lsra_is_float(struct el_lsra const * l, int reg)
+{
+	return l->function->register_types[reg] == el_FLOAT_TYPE_ID;
+}
+
+// Weights already count the reads and writes an interval's loops repeat, so a long interval is only preferred on a tie
+// Dividing by length would spill the accumulators which live across a whole loop nest but are used in its innermost loop
+static bool el_lsra_is_cheaper_to_spill(struct el_lsra const * l, int reg, int other)
+{
+	struct el_lsra_register const * r = &l->allocation->registers[reg];
+	struct el_lsra_register const * o = &l->allocation->registers[other];
+	long long cost = l->spill_weights[reg];
+	long long other_cost = l->spill_weights[other];
+	return cost < other_cost || (cost == other_cost && r->end > o->end);
+}
+
+// Take the lowest numbered register which is both free and a candidate, or return -1 if there is none
+static int el_lsra_take(uint32_t * free, uint32_t candidates)
+{
+	uint32_t available = *free & candidates;
+	if(available == 0)
+		return -1;
+
+	int index = 0;
+	while(!(available & (1u << index)))
+	{
+		++index;
+	}
+	*free &= ~(1u << index);
+	return index;
+}
+
+static int el_lsra_compare_intervals(void const * lhs, void const * rhs)
+{
+	struct el_lsra_interval const * l = lhs;
+	struct el_lsra_interval const * r = rhs;
+	if(l->start != r->start)
+		return l->start < r->start ? -1 : 1;
+	return l->reg < r->reg ? -1 : l->reg > r->reg;
+}
+
+static void el_lsra_delete(struct el_lsra * l)
+{
+	ffree(l->live_in);
+	ffree(l->live_out);
+	ffree(l->uses);
+	ffree(l->defs);
+	ffree(l->calls);
+	ffree(l->spill_weights);
+}
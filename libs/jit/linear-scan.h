@@ -0,0 +1,51 @@
+#pragma once
+#include "x64-encoder.h"
+#include <compiler/ir/ir.h>
+#include <stdint.h>
+
+// Where an ir register lives for the whole of its function
+enum el_lsra_location
+{
+	el_LSRA_UNUSED, // Never read or written
+	el_LSRA_REGISTER, // A general purpose register, or an xmm register if the ir register is a float
+	el_LSRA_STACK // A stack slot
+};
+
+// Positions number the instructions in order, an instruction's operands are read at 2i and its result written at 2i + 1
+struct el_lsra_register
+{
+	int location;
+	int index; // Machine register or stack slot
+	int start; // First position the register is live at, -1 if it holds a value on entry
+	int end; // Last position the register is live at
+	bool is_live_at_entry; // Read before it is written on some path from the entry, which the vm's zeroing of registers gives a value
+};
+
+struct el_lsra_allocation
+{
+	struct el_lsra_register * registers; // One per ir register
+	int num_registers;
+	int num_stack_slots;
+	uint32_t used_callee_saved; // Mask of the callee saved general purpose registers the allocation uses
+};
+
+// Allocatable registers, the ones not listed are scratch for the code generator
+// Calls clobber every caller saved register, so a register live across a call gets a callee saved one or the stack
+#define el_LSRA_CALLER_SAVED_GPRS ((1u << el_X64_RSI) | (1u << el_X64_RDI) | (1u << el_X64_R8) | (1u << el_X64_R9) | (1u << el_X64_R10))
+#define el_LSRA_CALLEE_SAVED_GPRS ((1u << el_X64_RBX) | (1u << el_X64_R12) | (1u << el_X64_R13) | (1u << el_X64_R14) | (1u << el_X64_R15))
+#define el_LSRA_XMMS 0xfffcu // xmm2 to xmm15, every xmm register is caller saved
+
+// Ops the code generator implements with a call, which clobber the caller saved registers
+// Kernels are not calls but use the caller saved registers and every xmm register as their own
+// Vector arithmetic calls to allocate its result before running its lanes, or when built in place only while its register is NULL
+static inline bool el_lsra_is_call(int op)
+{
+	return op == el_IR_CALL || op == el_IR_NEW_DAT || op == el_IR_NEW_SLICE || op == el_IR_NEW_ZERO_SLICE || op == el_IR_EQ_STRING || op == el_IR_KERNEL
+		|| op == el_IR_PARALLEL_FOR || op == el_IR_NEW_VECTOR || (op >= el_IR_ADD_INT_VECTOR && op <= el_IR_DIV_FLOAT_VECTOR);
+}
+
+// Allocate registers for function by linear scan over the hulls of its registers' live ranges
+// Registers are never split, one which cannot get a machine register for all of its hull is spilled for all of it
+int el_lsra_allocate(struct el_lsra_allocation * allocation, struct el_ir_module const * module, struct el_ir_function const * function);
+
+void el_lsra_allocation_delete(struct el_lsra_allocation * allocation);
@@ -0,0 +1,455 @@
+#include "x64-encoder.h"
+#include <string.h>
+#include <assert.h>
+
+// Longest x86-64 instruction
+#define X64_MAX_INSTRUCTION_LENGTH 15
+
+// Bits of the REX prefix, REX on its own gives access to the low bytes of rsp, rbp, rsi and rdi
+#define REX 0x40
+#define REX_W 0x08
+#define REX_R 0x04
+#define REX_X 0x02
+#define REX_B 0x01
+
+static void el_x64_emit(struct el_x64_assembler * a, uint8_t const * bytes, int length);
+static void el_x64_emit_modrm(struct el_x64_assembler * a, int prefix, int rex, uint32_t opcode, int num_opcode_bytes, int reg, struct el_x64_operand rm);
+static void el_x64_emit_packed(struct el_x64_assembler * a, int op, int width, int reg, int vvvv, struct el_x64_operand rm);
+static int el_x64_encode_rm(uint8_t * bytes, int n, int reg, struct el_x64_operand rm);
+static int el_x64_emit_rel32(struct el_x64_assembler * a, uint8_t const * opcode, int num_opcode_bytes);
+static bool el_x64_fits_int8(long long value);
+static bool el_x64_fits_int32(long long value);
+
+void el_x64_assembler_delete(struct el_x64_assembler * a)
+{
+	el_vector_free(a, code, NULL);
+	a->failed = false;
+}
+
+void el_x64_mov(struct el_x64_assembler * a, int dst, struct el_x64_operand src)
+{
+	el_x64_emit_modrm(a, 0, REX_W, 0x8b, 1, dst, src);
+}
+
+void el_x64_mov_store(struct el_x64_assembler * a, struct el_x64_operand dst, int src)
+{
+	el_x64_emit_modrm(a, 0, REX_W, 0x89, 1, src, dst);
+}
+
+// An absolute address with no base takes a SIB byte in 64 bit mode, a bare ModRM displacement is rip relative
+void el_x64_mov_fs(struct el_x64_assembler * a, int dst, int displacement)
+{
+	uint8_t bytes[9] = { 0x64, (uint8_t)(REX | REX_W | (dst & 8 ? REX_R : 0)), 0x8b, (uint8_t)((dst & 7) << 3 | 4), 0x25 };
+	for(int i = 0; i < 4; ++i)
+	{
+		bytes[5 + i] = (uint8_t)((unsigned int)displacement >> (8 * i));
+	}
+	el_x64_emit(a, bytes, 9);
+}
+
+void el_x64_mov_imm(struct el_x64_assembler * a, struct el_x64_operand dst, long long value)
+{
+	assert(!dst.is_memory || el_x64_fits_int32(value));
+	uint8_t bytes[X64_MAX_INSTRUCTION_LENGTH];
+	int n = 0;
+	if(!dst.is_memory && value >= 0 && value <= UINT32_MAX)
+	{
+		// Writing a 32 bit register zeroes the upper half
+		if(dst.reg & 8)
+		{
+			bytes[n++] = REX | REX_B;
+		}
+		bytes[n++] = (uint8_t)(0xb8 + (dst.reg & 7));
+		for(int i = 0; i < 4; ++i)
+		{
+			bytes[n++] = (uint8_t)((unsigned long long)value >> (8 * i));
+		}
+		el_x64_emit(a, bytes, n);
+	}
+	else if(el_x64_fits_int32(value))
+	{
+		el_x64_emit_modrm(a, 0, REX_W, 0xc7, 1, 0, dst);
+		for(int i = 0; i < 4; ++i)
+		{
+			bytes[n++] = (uint8_t)((unsigned long long)value >> (8 * i));
+		}
+		el_x64_emit(a, bytes, n);
+	}
+	else
+	{
+		bytes[n++] = (uint8_t)(REX | REX_W | ((dst.reg & 8) ? REX_B : 0));
+		bytes[n++] = (uint8_t)(0xb8 + (dst.reg & 7));
+		for(int i = 0; i < 8; ++i)
+		{
+			bytes[n++] = (uint8_t)((unsigned long long)value >> (8 * i));
+		}
+		el_x64_emit(a, bytes, n);
+	}
+}
+
+void el_x64_lea(struct el_x64_assembler * a, int dst, struct el_x64_operand src)
+{
+	assert(src.is_memory);
+	el_x64_emit_modrm(a, 0, REX_W, 0x8d, 1, dst, src);
+}
+
+void el_x64_movzx8(struct el_x64_assembler * a, int dst, int src)
+{
+	el_x64_emit_modrm(a, 0, REX_W, 0x0fb6, 2, dst, el_x64_reg(src));
+}
+
+void el_x64_push(struct el_x64_assembler * a, int reg)
+{
+	uint8_t bytes[2] = { REX | REX_B, (uint8_t)(0x50 + (reg & 7)) };
+	el_x64_emit(a, (reg & 8) ? bytes : bytes + 1, (reg & 8) ? 2 : 1);
+}
+
+void el_x64_pop(struct el_x64_assembler * a, int reg)
+{
+	uint8_t bytes[2] = { REX | REX_B, (uint8_t)(0x58 + (reg & 7)) };
+	el_x64_emit(a, (reg & 8) ? bytes : bytes + 1, (reg & 8) ? 2 : 1);
+}
+
+void el_x64_alu(struct el_x64_assembler * a, int op, int dst, struct el_x64_operand src)
+{
+	el_x64_emit_modrm(a, 0, REX_W, (uint32_t)(op << 3 | 3), 1, dst, src);
+}
+
+void el_x64_alu_store(struct el_x64_assembler * a, int op, struct el_x64_operand dst, int src)
+{
+	el_x64_emit_modrm(a, 0, REX_W, (uint32_t)(op << 3 | 1), 1, src, dst);
+}
+
+void el_x64_alu_imm(struct el_x64_assembler * a, int op, struct el_x64_operand dst, int value)
+{
+	uint8_t bytes[4];
+	if(el_x64_fits_int8(value))
+	{
+		el_x64_emit_modrm(a, 0, REX_W, 0x83, 1, op, dst);
+		bytes[0] = (uint8_t)value;
+		el_x64_emit(a, bytes, 1);
+	}
+	else
+	{
+		el_x64_emit_modrm(a, 0, REX_W, 0x81, 1, op, dst);
+		for(int i = 0; i < 4; ++i)
+		{
+			bytes[i] = (uint8_t)((unsigned int)value >> (8 * i));
+		}
+		el_x64_emit(a, bytes, 4);
+	}
+}
+
+void el_x64_imul(struct el_x64_assembler * a, int dst, struct el_x64_operand src)
+{
+	el_x64_emit_modrm(a, 0, REX_W, 0x0faf, 2, dst, src);
+}
+
+void el_x64_imul_imm(struct el_x64_assembler * a, int dst, struct el_x64_operand src, int value)
+{
+	uint8_t bytes[4];
+	int n = el_x64_fits_int8(value) ? 1 : 4;
+	el_x64_emit_modrm(a, 0, REX_W, n == 1 ? 0x6b : 0x69, 1, dst, src);
+	for(int i = 0; i < n; ++i)
+	{
+		bytes[i] = (uint8_t)((unsigned int)value >> (8 * i));
+	}
+	el_x64_emit(a, bytes, n);
+}
+
+void el_x64_imul_wide(struct el_x64_assembler * a, struct el_x64_operand src)
+{
+	el_x64_emit_modrm(a, 0, REX_W, 0xf7, 1, 5, src);
+}
+
+void el_x64_shift(struct el_x64_assembler * a, int op, struct el_x64_operand dst, int count)
+{
+	assert(count >= 0 && count < 64);
+	uint8_t const bytes[1] = { (uint8_t)count };
+	el_x64_emit_modrm(a, 0, REX_W, 0xc1, 1, op, dst);
+	el_x64_emit(a, bytes, 1);
+}
+
+void el_x64_idiv(struct el_x64_assembler * a, struct el_x64_operand divisor)
+{
+	el_x64_emit_modrm(a, 0, REX_W, 0xf7, 1, 7, divisor);
+}
+
+void el_x64_cqo(struct el_x64_assembler * a)
+{
+	uint8_t const bytes[2] = { REX | REX_W, 0x99 };
+	el_x64_emit(a, bytes, 2);
+}
+
+void el_x64_neg(struct el_x64_assembler * a, struct el_x64_operand dst)
+{
+	el_x64_emit_modrm(a, 0, REX_W, 0xf7, 1, 3, dst);
+}
+
+void el_x64_test(struct el_x64_assembler * a, struct el_x64_operand lhs, int rhs)
+{
+	el_x64_emit_modrm(a, 0, REX_W, 0x85, 1, rhs, lhs);
+}
+
+void el_x64_setcc(struct el_x64_assembler * a, int condition, int dst)
+{
+	el_x64_emit_modrm(a, 0, dst >= el_X64_RSP ? REX : 0, (uint32_t)(0x0f90 + condition), 2, 0, el_x64_reg(dst));
+}
+
+// Register to register moves copy the whole register, s.t. they do not depend on dst's old value
+void el_x64_movsd(struct el_x64_assembler * a, int dst, struct el_x64_operand src)
+{
+	if(src.is_memory)
+	{
+		el_x64_emit_modrm(a, 0xf2, 0, 0x0f10, 2, dst, src);
+	}
+	else
+	{
+		el_x64_emit_modrm(a, 0x66, 0, 0x0f28, 2, dst, src);
+	}
+}
+
+void el_x64_movsd_store(struct el_x64_assembler * a, struct el_x64_operand dst, int src)
+{
+	if(dst.is_memory)
+	{
+		el_x64_emit_modrm(a, 0xf2, 0, 0x0f11, 2, src, dst);
+	}
+	else
+	{
+		el_x64_movsd(a, dst.reg, el_x64_reg(src));
+	}
+}
+
+void el_x64_sse(struct el_x64_assembler * a, int op, int dst, struct el_x64_operand src)
+{
+	el_x64_emit_modrm(a, 0xf2, 0, (uint32_t)(0x0f00 | op), 2, dst, src);
+}
+
+void el_x64_ucomisd(struct el_x64_assembler * a, int lhs, struct el_x64_operand rhs)
+{
+	el_x64_emit_modrm(a, 0x66, 0, 0x0f2e, 2, lhs, rhs);
+}
+
+void el_x64_xorpd(struct el_x64_assembler * a, int dst, int src)
+{
+	el_x64_emit_modrm(a, 0x66, 0, 0x0f57, 2, dst, el_x64_reg(src));
+}
+
+void el_x64_movq_to_xmm(struct el_x64_assembler * a, int dst, struct el_x64_operand src)
+{
+	el_x64_emit_modrm(a, 0x66, REX_W, 0x0f6e, 2, dst, src);
+}
+
+void el_x64_movq_from_xmm(struct el_x64_assembler * a, struct el_x64_operand dst, int src)
+{
+	el_x64_emit_modrm(a, 0x66, REX_W, 0x0f7e, 2, src, dst);
+}
+
+// The sse encoding is destructive, a move of lhs into dst comes first when they differ
+void el_x64_packed(struct el_x64_assembler * a, int op, int width, int dst, int lhs, struct el_x64_operand rhs)
+{
+	bool is_move = op == el_X64_MOVUPD || op == el_X64_MOVAPD;
+	if(width == 16 && !is_move && dst != lhs)
+	{
+		assert(rhs.is_memory || rhs.reg != dst);
+		el_x64_emit_packed(a, el_X64_MOVAPD, width, dst, 0, el_x64_reg(lhs));
+	}
+	el_x64_emit_packed(a, op, width, dst, is_move || width == 16 ? 0 : lhs, rhs);
+}
+
+void el_x64_packed_imm(struct el_x64_assembler * a, int op, int width, int dst, int lhs, struct el_x64_operand rhs, int value)
+{
+	uint8_t const bytes[1] = { (uint8_t)value };
+	el_x64_packed(a, op, width, dst, lhs, rhs);
+	el_x64_emit(a, bytes, 1);
+}
+
+// The vex encoding names dst in vvvv and puts the op in the reg field
+void el_x64_packed_shift(struct el_x64_assembler * a, int op, int width, int dst, int src, int count)
+{
+	assert(count >= 0 && count < 64);
+	uint8_t const bytes[1] = { (uint8_t)count };
+	if(width == 16 && dst != src)
+	{
+		el_x64_emit_packed(a, el_X64_MOVAPD, width, dst, 0, el_x64_reg(src));
+		src = dst;
+	}
+	el_x64_emit_packed(a, 0x660073, width, op, width == 16 ? 0 : dst, el_x64_reg(src));
+	el_x64_emit(a, bytes, 1);
+}
+
+void el_x64_packed_store(struct el_x64_assembler * a, int width, struct el_x64_operand dst, int src)
+{
+	el_x64_emit_packed(a, 0x660011, width, src, 0, dst);
+}
+
+// movddup and vbroadcastsd
+void el_x64_broadcast(struct el_x64_assembler * a, int width, int dst, struct el_x64_operand src)
+{
+	assert(src.is_memory);
+	el_x64_emit_packed(a, width == 16 ? 0xf20012 : 0x663819, width, dst, 0, src);
+}
+
+void el_x64_vzeroupper(struct el_x64_assembler * a)
+{
+	uint8_t const bytes[3] = { 0xc5, 0xf8, 0x77 };
+	el_x64_emit(a, bytes, 3);
+}
+
+int el_x64_jmp(struct el_x64_assembler * a)
+{
+	uint8_t const opcode[1] = { 0xe9 };
+	return el_x64_emit_rel32(a, opcode, 1);
+}
+
+int el_x64_jcc(struct el_x64_assembler * a, int condition)
+{
+	uint8_t const opcode[2] = { 0x0f, (uint8_t)(0x80 + condition) };
+	return el_x64_emit_rel32(a, opcode, 2);
+}
+
+int el_x64_call(struct el_x64_assembler * a)
+{
+	uint8_t const opcode[1] = { 0xe8 };
+	return el_x64_emit_rel32(a, opcode, 1);
+}
+
+void el_x64_call_indirect(struct el_x64_assembler * a, struct el_x64_operand target)
+{
+	el_x64_emit_modrm(a, 0, 0, 0xff, 1, 2, target);
+}
+
+void el_x64_ret(struct el_x64_assembler * a)
+{
+	uint8_t const bytes[1] = { 0xc3 };
+	el_x64_emit(a, bytes, 1);
+}
+
+// Displacements are relative to the end of the instruction, which they are the last 4 bytes of
+void el_x64_patch(struct el_x64_assembler * a, int offset, int target)
+{
+	if(a->failed)
+		return;
+
+	assert(offset >= 0 && offset + 4 <= a->num_code);
+	uint32_t displacement = (uint32_t)(target - (offset + 4));
+	for(int i = 0; i < 4; ++i)
+	{
+		a->code[offset + i] = (uint8_t)(displacement >> (8 * i));
+	}
+}
+
+static void el_x64_emit(struct el_x64_assembler * a, uint8_t const * bytes, int length)
+{
+	if(a->failed || !el_vector_reserve(a, code, a->num_code + length, NULL))
+	{
+		a->failed = true;
+		return;
+	}
+	memcpy(a->code + a->num_code, bytes, (size_t)length);
+	a->num_code += length;
+}
+
+// Emit [prefix] [REX] opcode ModRM [SIB] [displacement], with reg in the reg field and rm as the r/m operand
+// opcode holds num_opcode_bytes bytes, most significant first
+static void el_x64_emit_modrm(struct el_x64_assembler * a, int prefix, int rex, uint32_t opcode, int num_opcode_bytes, int reg, struct el_x64_operand rm)
+{
+	uint8_t bytes[X64_MAX_INSTRUCTION_LENGTH];
+	int n = 0;
+	if(prefix)
+	{
+		bytes[n++] = (uint8_t)prefix;
+	}
+
+	bool has_index = rm.is_memory && rm.index != el_X64_NO_REGISTER;
+	rex |= (reg & 8) ? REX_R : 0;
+	rex |= has_index && (rm.index & 8) ? REX_X : 0;
+	rex |= (rm.reg & 8) ? REX_B : 0;
+	if(rex)
+	{
+		bytes[n++] = (uint8_t)(REX | rex);
+	}
+	for(int i = num_opcode_bytes - 1; i >= 0; --i)
+	{
+		bytes[n++] = (uint8_t)(opcode >> (8 * i));
+	}
+
+	n = el_x64_encode_rm(bytes, n, reg, rm);
+	el_x64_emit(a, bytes, n);
+}
+
+// Emit a packed op, numbered as in el_x64_packed_op, as [prefix] [REX] 0F [escape] opcode ModRM ... when width is 16
+// When width is 32 it is emitted as C4 RXB.mmmmm W.vvvv.L.pp opcode ModRM ..., vvvv names a second source, 0 if there is none
+static void el_x64_emit_packed(struct el_x64_assembler * a, int op, int width, int reg, int vvvv, struct el_x64_operand rm)
+{
+	assert(width == 16 || width == 32);
+	int prefix = op >> 16;
+	int escape = (op >> 8) & 0xff;
+	int opcode = op & 0xff;
+	if(width == 16)
+	{
+		uint32_t opcodes = escape ? (uint32_t)(0x0f0000 | escape << 8 | opcode) : (uint32_t)(0x0f00 | opcode);
+		el_x64_emit_modrm(a, prefix, 0, opcodes, escape ? 3 : 2, reg, rm);
+		return;
+	}
+
+	uint8_t bytes[X64_MAX_INSTRUCTION_LENGTH];
+	int n = 0;
+	bool has_index = rm.is_memory && rm.index != el_X64_NO_REGISTER;
+	int pp = prefix == 0x66 ? 1 : prefix == 0xf3 ? 2 : prefix == 0xf2 ? 3 : 0;
+	int mmmmm = escape == 0x38 ? 2 : escape == 0x3a ? 3 : 1;
+	bytes[n++] = 0xc4;
+	bytes[n++] = (uint8_t)(((reg & 8) ? 0 : 0x80) | (has_index && (rm.index & 8) ? 0 : 0x40) | ((rm.reg & 8) ? 0 : 0x20) | mmmmm);
+	bytes[n++] = (uint8_t)((~vvvv & 15) << 3 | 1 << 2 | pp);
+	bytes[n++] = (uint8_t)opcode;
+	n = el_x64_encode_rm(bytes, n, reg, rm);
+	el_x64_emit(a, bytes, n);
+}
+
+// Append ModRM [SIB] [displacement] to bytes[0, n), returns the new length
+static int el_x64_encode_rm(uint8_t * bytes, int n, int reg, struct el_x64_operand rm)
+{
+	if(!rm.is_memory)
+	{
+		bytes[n++] = (uint8_t)(0xc0 | (reg & 7) << 3 | (rm.reg & 7));
+		return n;
+	}
+
+	// rsp and r12 as a base need a SIB byte, rbp and r13 always need a displacement
+	bool has_index = rm.index != el_X64_NO_REGISTER;
+	assert(!has_index || rm.index != el_X64_RSP);
+	int mod = rm.displacement == 0 && (rm.reg & 7) != el_X64_RBP ? 0 : el_x64_fits_int8(rm.displacement) ? 1 : 2;
+	bool has_sib = has_index || (rm.reg & 7) == el_X64_RSP;
+	bytes[n++] = (uint8_t)(mod << 6 | (reg & 7) << 3 | (has_sib ? 4 : rm.reg & 7));
+	if(has_sib)
+	{
+		int scale = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+		int index = has_index ? rm.index & 7 : 4;
+		bytes[n++] = (uint8_t)(scale << 6 | index << 3 | (rm.reg & 7));
+	}
+	int num_displacement_bytes = mod == 0 ? 0 : mod == 1 ? 1 : 4;
+	for(int i = 0; i < num_displacement_bytes; ++i)
+	{
+		bytes[n++] = (uint8_t)((unsigned int)rm.displacement >> (8 * i));
+	}
+	return n;
+}
+
+static int el_x64_emit_rel32(struct el_x64_assembler * a, uint8_t const * opcode, int num_opcode_bytes)
+{
+	uint8_t bytes[6] = { 0 };
+	memcpy(bytes, opcode, (size_t)num_opcode_bytes);
+	el_x64_emit(a, bytes, num_opcode_bytes + 4);
+	return a->num_code - 4;
+}
+
+static bool el_x64_fits_int8(long long value)
+{
+	return value >= INT8_MIN && value <= INT8_MAX;
+}
+
+static bool el_x64_fits_int32(long long value)
+{
+	return value >= INT32_MIN && value <= INT32_MAX;
+}
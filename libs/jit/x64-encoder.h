@@ -0,0 +1,210 @@
+#pragma once
+#include <containers/vector.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// General purpose registers, numbered as they are encoded
+enum el_x64_register
+{
+	el_X64_RAX,
+	el_X64_RCX,
+	el_X64_RDX,
+	el_X64_RBX,
+	el_X64_RSP,
+	el_X64_RBP,
+	el_X64_RSI,
+	el_X64_RDI,
+	el_X64_R8,
+	el_X64_R9,
+	el_X64_R10,
+	el_X64_R11,
+	el_X64_R12,
+	el_X64_R13,
+	el_X64_R14,
+	el_X64_R15,
+
+	el_x64_register_count
+};
+
+// xmm registers are numbered 0 to 15 in the same space, which of the two a register is depends on the instruction
+#define el_X64_NO_REGISTER -1
+
+// Condition codes, numbered as they are encoded in jcc and setcc
+enum el_x64_condition
+{
+	el_X64_OVERFLOW,
+	el_X64_NOT_OVERFLOW,
+	el_X64_BELOW,
+	el_X64_ABOVE_OR_EQUAL,
+	el_X64_EQUAL,
+	el_X64_NOT_EQUAL,
+	el_X64_BELOW_OR_EQUAL,
+	el_X64_ABOVE,
+	el_X64_SIGN,
+	el_X64_NOT_SIGN,
+	el_X64_PARITY,
+	el_X64_NOT_PARITY,
+	el_X64_LESS,
+	el_X64_GREATER_OR_EQUAL,
+	el_X64_LESS_OR_EQUAL,
+	el_X64_GREATER
+};
+
+// Integer ops which share an encoding, numbered as the reg field of their immediate forms
+enum el_x64_alu_op
+{
+	el_X64_ADD = 0,
+	el_X64_OR = 1,
+	el_X64_AND = 4,
+	el_X64_SUB = 5,
+	el_X64_XOR = 6,
+	el_X64_CMP = 7
+};
+
+// Shifts, numbered as the reg field of their encoding
+enum el_x64_shift_op
+{
+	el_X64_SHL = 4,
+	el_X64_SHR = 5,
+	el_X64_SAR = 7
+};
+
+// Scalar double ops, numbered as their opcode after F2 0F
+enum el_x64_sse_op
+{
+	el_X64_ADDSD = 0x58,
+	el_X64_MULSD = 0x59,
+	el_X64_SUBSD = 0x5c,
+	el_X64_DIVSD = 0x5e
+};
+
+// Packed ops on the lanes of xmm or ymm registers, numbered as their mandatory prefix, escape and opcode, e.g. 66 0F38 29
+// Double ops, integer ops on 64 bit lanes, and bitwise ops on whole registers
+enum el_x64_packed_op
+{
+	el_X64_MOVUPD = 0x660010, // dst = src, unaligned
+	el_X64_MOVAPD = 0x660028,
+	el_X64_ADDPD = 0x660058,
+	el_X64_MULPD = 0x660059,
+	el_X64_SUBPD = 0x66005c,
+	el_X64_DIVPD = 0x66005e,
+	el_X64_PADDQ = 0x6600d4,
+	el_X64_PSUBQ = 0x6600fb,
+	el_X64_PMULUDQ = 0x6600f4, // The low 32 bits of each lane multiplied into 64
+	el_X64_PAND = 0x6600db,
+	el_X64_PANDN = 0x6600df, // dst = ~lhs & rhs
+	el_X64_POR = 0x6600eb,
+	el_X64_PXOR = 0x6600ef,
+	el_X64_PCMPEQQ = 0x663829, // Each lane all ones if lhs == rhs, otherwise 0, needs sse4.1
+	el_X64_PCMPGTQ = 0x663837, // Each lane all ones if lhs > rhs signed, otherwise 0, needs sse4.2
+	el_X64_CMPPD = 0x6600c2 // Each lane all ones if the predicate given as the immediate holds, see el_x64_packed_imm
+};
+
+// Predicates of cmppd
+enum el_x64_cmppd_predicate
+{
+	el_X64_CMP_EQ = 0,
+	el_X64_CMP_LT = 1,
+	el_X64_CMP_LE = 2
+};
+
+// Shifts of 64 bit lanes by an immediate, numbered as the reg field of their encoding
+enum el_x64_packed_shift_op
+{
+	el_X64_PSRLQ = 2,
+	el_X64_PSLLQ = 6
+};
+
+// A register, or the memory at [base + index * scale + displacement]
+struct el_x64_operand
+{
+	bool is_memory;
+	int reg; // The register, or the base of a memory operand
+	int index; // el_X64_NO_REGISTER if the memory operand has none, may not be rsp
+	int scale; // 1, 2, 4 or 8
+	int displacement;
+};
+
+// Bytes of machine code, every instruction is 64 bit unless its name says otherwise
+// Appends set failed rather than returning an error, s.t. a whole function can be encoded before checking once
+struct el_x64_assembler
+{
+	el_VECTOR_MEMBERS(uint8_t, code);
+	bool failed;
+};
+
+static inline struct el_x64_operand el_x64_reg(int reg)
+{
+	return (struct el_x64_operand){ .is_memory = false, .reg = reg, .index = el_X64_NO_REGISTER, .scale = 1 };
+}
+
+static inline struct el_x64_operand el_x64_mem(int base, int displacement)
+{
+	return (struct el_x64_operand){ .is_memory = true, .reg = base, .index = el_X64_NO_REGISTER, .scale = 1, .displacement = displacement };
+}
+
+static inline struct el_x64_operand el_x64_mem_indexed(int base, int index, int scale, int displacement)
+{
+	return (struct el_x64_operand){ .is_memory = true, .reg = base, .index = index, .scale = scale, .displacement = displacement };
+}
+
+void el_x64_assembler_delete(struct el_x64_assembler * a);
+
+static inline int el_x64_offset(struct el_x64_assembler const * a)
+{
+	return a->num_code;
+}
+
+// Moves
+void el_x64_mov(struct el_x64_assembler * a, int dst, struct el_x64_operand src);
+void el_x64_mov_store(struct el_x64_assembler * a, struct el_x64_operand dst, int src);
+void el_x64_mov_fs(struct el_x64_assembler * a, int dst, int displacement); // dst = the 8 bytes at fs:displacement, e.g. the thread pointer at fs:0
+void el_x64_mov_imm(struct el_x64_assembler * a, struct el_x64_operand dst, long long value); // Picks the shortest encoding
+void el_x64_lea(struct el_x64_assembler * a, int dst, struct el_x64_operand src);
+void el_x64_movzx8(struct el_x64_assembler * a, int dst, int src); // dst = the low byte of src
+void el_x64_push(struct el_x64_assembler * a, int reg);
+void el_x64_pop(struct el_x64_assembler * a, int reg);
+
+// Integer arithmetic
+void el_x64_alu(struct el_x64_assembler * a, int op, int dst, struct el_x64_operand src); // dst = dst op src
+void el_x64_alu_store(struct el_x64_assembler * a, int op, struct el_x64_operand dst, int src); // dst = dst op src
+void el_x64_alu_imm(struct el_x64_assembler * a, int op, struct el_x64_operand dst, int value); // dst = dst op value
+void el_x64_imul(struct el_x64_assembler * a, int dst, struct el_x64_operand src);
+void el_x64_imul_imm(struct el_x64_assembler * a, int dst, struct el_x64_operand src, int value); // dst = src * value
+void el_x64_imul_wide(struct el_x64_assembler * a, struct el_x64_operand src); // rdx:rax = rax * src
+void el_x64_shift(struct el_x64_assembler * a, int op, struct el_x64_operand dst, int count);
+void el_x64_idiv(struct el_x64_assembler * a, struct el_x64_operand divisor); // rax, rdx = rdx:rax / divisor, rdx:rax % divisor
+void el_x64_cqo(struct el_x64_assembler * a); // rdx:rax = sign extended rax
+void el_x64_neg(struct el_x64_assembler * a, struct el_x64_operand dst);
+void el_x64_test(struct el_x64_assembler * a, struct el_x64_operand lhs, int rhs);
+void el_x64_setcc(struct el_x64_assembler * a, int condition, int dst); // Low byte of dst = 1 if condition holds, otherwise 0
+
+// Scalar doubles, dst and the register operands are xmm registers
+void el_x64_movsd(struct el_x64_assembler * a, int dst, struct el_x64_operand src);
+void el_x64_movsd_store(struct el_x64_assembler * a, struct el_x64_operand dst, int src);
+void el_x64_sse(struct el_x64_assembler * a, int op, int dst, struct el_x64_operand src); // dst = dst op src
+void el_x64_ucomisd(struct el_x64_assembler * a, int lhs, struct el_x64_operand rhs);
+void el_x64_xorpd(struct el_x64_assembler * a, int dst, int src);
+void el_x64_movq_to_xmm(struct el_x64_assembler * a, int dst, struct el_x64_operand src); // src is a general purpose register or memory
+void el_x64_movq_from_xmm(struct el_x64_assembler * a, struct el_x64_operand dst, int src);
+
+// Packed, width is 16 for the legacy sse encoding on xmm registers or 32 for the vex encoding on ymm registers, which needs avx
+// Each writes dst = lhs op rhs, in the sse encoding rhs may not be dst unless lhs is too
+// lhs is ignored by moves, which read rhs alone
+void el_x64_packed(struct el_x64_assembler * a, int op, int width, int dst, int lhs, struct el_x64_operand rhs);
+void el_x64_packed_imm(struct el_x64_assembler * a, int op, int width, int dst, int lhs, struct el_x64_operand rhs, int value);
+void el_x64_packed_shift(struct el_x64_assembler * a, int op, int width, int dst, int src, int count); // dst = src shifted by count
+void el_x64_packed_store(struct el_x64_assembler * a, int width, struct el_x64_operand dst, int src); // movupd
+void el_x64_broadcast(struct el_x64_assembler * a, int width, int dst, struct el_x64_operand src); // Every lane = the double at src in memory
+void el_x64_vzeroupper(struct el_x64_assembler * a); // Clears the upper halves of the ymm registers, s.t. sse code after avx code runs at full speed
+
+// Control flow
+// Relative jumps and calls return the offset of their 32 bit displacement, which is later set by el_x64_patch
+int el_x64_jmp(struct el_x64_assembler * a);
+int el_x64_jcc(struct el_x64_assembler * a, int condition);
+int el_x64_call(struct el_x64_assembler * a);
+void el_x64_call_indirect(struct el_x64_assembler * a, struct el_x64_operand target);
+void el_x64_ret(struct el_x64_assembler * a);
+
+// Point the displacement at offset at the instruction at target
+void el_x64_patch(struct el_x64_assembler * a, int offset, int target);
@@ -0,0 +1,254 @@
+#include "thread-pool.h"
+#include <allocators/fmalloc.h>
+#include <assert.h>
+
+// Ranges are padded to a cache line, s.t. threads claiming their own tasks do not contend
+#define CACHE_LINE_SIZE 64
+
+struct el_thread_pool_worker
+{
+	struct el_thread_pool * pool;
+	int thread_index;
+};
+
+// Tasks [first, end) packed as end << 32 | first, s.t. the owner claiming the first and a thief taking the back half race on one word
+struct el_thread_pool_range
+{
+	uint64_t volatile tasks;
+	char padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+};
+
+static void el_thread_pool_worker_main(void * arg);
+static void el_thread_pool_run_tasks(struct el_thread_pool * pool, el_task_fn fn, void * context, int thread_index);
+static bool el_thread_pool_claim(struct el_thread_pool_range * range, int * task);
+static bool el_thread_pool_steal(struct el_thread_pool * pool, int thread_index);
+static uint64_t el_pack_range(uint32_t first, uint32_t end);
+
+bool el_thread_pool_new(struct el_thread_pool * pool, int num_threads)
+{
+	assert(pool && num_threads >= 0);
+
+	if(num_threads == 0)
+	{
+		num_threads = el_num_hardware_threads() - 1;
+	}
+
+	pool->threads = NULL;
+	pool->workers = NULL;
+	pool->num_threads = 0;
+	pool->fn = NULL;
+	pool->context = NULL;
+	pool->num_tasks = 0;
+	pool->generation = 0;
+	pool->num_active_workers = 0;
+	pool->shutting_down = false;
+	pool->ranges = NULL;
+	el_mutex_new(&pool->mutex);
+	el_condition_new(&pool->work_available);
+	el_condition_new(&pool->work_finished);
+
+	num_threads = num_threads > 0 ? num_threads : 0;
+	pool->ranges = fmalloc(sizeof(struct el_thread_pool_range) * (num_threads + 1));
+	if(!pool->ranges)
+	{
+		return false;
+	}
+	pool->ranges[num_threads].tasks = 0;
+	if(num_threads == 0)
+	{
+		return true;
+	}
+
+	pool->threads = fmalloc(sizeof(el_thread) * num_threads);
+	pool->workers = fmalloc(sizeof(struct el_thread_pool_worker) * num_threads);
+	if(!pool->threads || !pool->workers)
+	{
+		return false;
+	}
+
+	for(int i = 0; i < num_threads; i++)
+	{
+		pool->ranges[i].tasks = 0;
+		pool->workers[i].pool = pool;
+		pool->workers[i].thread_index = i;
+		if(!el_thread_new(&pool->threads[i], el_thread_pool_worker_main, &pool->workers[i]))
+		{
+			break;
+		}
+		pool->num_threads++;
+	}
+	return pool->num_threads == num_threads;
+}
+
+void el_thread_pool_delete(struct el_thread_pool * pool)
+{
+	el_mutex_lock(&pool->mutex);
+	pool->shutting_down = true;
+	el_condition_broadcast(&pool->work_available);
+	el_mutex_unlock(&pool->mutex);
+
+	for(int i = 0; i < pool->num_threads; i++)
+	{
+		el_thread_join(pool->threads[i]);
+	}
+
+	ffree(pool->threads);
+	ffree(pool->workers);
+	ffree(pool->ranges);
+	pool->threads = NULL;
+	pool->workers = NULL;
+	pool->ranges = NULL;
+	pool->num_threads = 0;
+
+	el_condition_delete(&pool->work_finished);
+	el_condition_delete(&pool->work_available);
+	el_mutex_delete(&pool->mutex);
+}
+
+void el_thread_pool_for(struct el_thread_pool * pool, int num_tasks, el_task_fn fn, void * context)
+{
+	if(num_tasks <= 0)
+	{
+		return;
+	}
+	if(!pool->ranges)
+	{
+		// Creating the pool failed before any thread was started
+		for(int i = 0; i < num_tasks; ++i)
+		{
+			fn(context, i, 0);
+		}
+		return;
+	}
+
+	el_mutex_lock(&pool->mutex);
+
+	// A worker which woke late for the previous batch may still be draining it
+	while(pool->num_active_workers > 0)
+	{
+		el_condition_wait(&pool->work_finished, &pool->mutex);
+	}
+
+	pool->fn = fn;
+	pool->context = context;
+	pool->num_tasks = num_tasks;
+	for(int i = 0; i <= pool->num_threads; ++i)
+	{
+		long long num_participants = pool->num_threads + 1;
+		el_atomic_store_64(&pool->ranges[i].tasks, el_pack_range((uint32_t)(num_tasks * i / num_participants), (uint32_t)(num_tasks * (i + 1) / num_participants)));
+	}
+	pool->generation++;
+	el_condition_broadcast(&pool->work_available);
+	el_mutex_unlock(&pool->mutex);
+
+	el_thread_pool_run_tasks(pool, fn, context, pool->num_threads);
+
+	// Every task has been claimed, so once no workers are active every task has completed
+	el_mutex_lock(&pool->mutex);
+	while(pool->num_active_workers > 0)
+	{
+		el_condition_wait(&pool->work_finished, &pool->mutex);
+	}
+	el_mutex_unlock(&pool->mutex);
+}
+
+static void el_thread_pool_worker_main(void * arg)
+{
+	struct el_thread_pool_worker * worker = arg;
+	struct el_thread_pool * pool = worker->pool;
+	int seen_generation = 0;
+
+	el_mutex_lock(&pool->mutex);
+	while(true)
+	{
+		while(!pool->shutting_down && pool->generation == seen_generation)
+		{
+			el_condition_wait(&pool->work_available, &pool->mutex);
+		}
+		if(pool->shutting_down)
+		{
+			break;
+		}
+
+		seen_generation = pool->generation;
+		el_task_fn fn = pool->fn;
+		void * context = pool->context;
+		pool->num_active_workers++;
+		el_mutex_unlock(&pool->mutex);
+
+		el_thread_pool_run_tasks(pool, fn, context, worker->thread_index);
+
+		el_mutex_lock(&pool->mutex);
+		if(--pool->num_active_workers == 0)
+		{
+			el_condition_broadcast(&pool->work_finished);
+		}
+	}
+	el_mutex_unlock(&pool->mutex);
+}
+
+// Tasks are only ever moved between ranges, s.t. once every range is empty each task has been claimed
+static void el_thread_pool_run_tasks(struct el_thread_pool * pool, el_task_fn fn, void * context, int thread_index)
+{
+	struct el_thread_pool_range * own = &pool->ranges[thread_index];
+	do
+	{
+		int task;
+		while(el_thread_pool_claim(own, &task))
+		{
+			fn(context, task, thread_index);
+		}
+	}
+	while(el_thread_pool_steal(pool, thread_index));
+}
+
+// Claim the first task of the range, returns false if it is empty
+static bool el_thread_pool_claim(struct el_thread_pool_range * range, int * task)
+{
+	uint64_t tasks = el_atomic_load_64(&range->tasks);
+	while(true)
+	{
+		uint32_t first = (uint32_t)tasks;
+		uint32_t end = (uint32_t)(tasks >> 32);
+		if(first >= end)
+			return false;
+		if(el_atomic_compare_exchange_64(&range->tasks, &tasks, el_pack_range(first + 1, end)))
+		{
+			*task = (int)first;
+			return true;
+		}
+	}
+}
+
+// Move the back half of another thread's tasks into the empty range of thread_index, returns false once every range is empty
+// Victims are tried in turn from the next thread on, s.t. thieves spread over the threads with tasks left
+static bool el_thread_pool_steal(struct el_thread_pool * pool, int thread_index)
+{
+	int num_participants = pool->num_threads + 1;
+	for(int i = 1; i < num_participants; ++i)
+	{
+		struct el_thread_pool_range * victim = &pool->ranges[(thread_index + i) % num_participants];
+		uint64_t tasks = el_atomic_load_64(&victim->tasks);
+		while(true)
+		{
+			uint32_t first = (uint32_t)tasks;
+			uint32_t end = (uint32_t)(tasks >> 32);
+			if(first >= end)
+				break;
+
+			// A single task left is taken whole, the owner is running the task before it
+			uint32_t num_stolen = (end - first + 1) / 2;
+			if(el_atomic_compare_exchange_64(&victim->tasks, &tasks, el_pack_range(first, end - num_stolen)))
+			{
+				el_atomic_store_64(&pool->ranges[thread_index].tasks, el_pack_range(end - num_stolen, end));
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static uint64_t el_pack_range(uint32_t first, uint32_t end)
+{
+	return (uint64_t)end << 32 | first;
+}
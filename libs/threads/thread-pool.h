@@ -0,0 +1,44 @@
+#pragma once
+#include "thread.h"
+
+// Called once per task, thread_index is in [0, num_threads] where num_threads is the calling thread
+typedef void (*el_task_fn)(void * context, int task_index, int thread_index);
+
+struct el_thread_pool_worker;
+struct el_thread_pool_range;
+
+struct el_thread_pool
+{
+	el_thread * threads;
+	struct el_thread_pool_worker * workers;
+	int num_threads;
+
+	el_mutex mutex;
+	el_condition work_available;
+	el_condition work_finished;
+
+	// The batch of tasks currently being run, guarded by mutex
+	el_task_fn fn;
+	void * context;
+	int num_tasks;
+	int generation;
+	int num_active_workers;
+	bool shutting_down;
+
+	// Tasks still to run of each thread, the calling thread's last
+	// Tasks are claimed without the mutex held, a thread which runs out steals half of the tasks left to another
+	struct el_thread_pool_range * ranges;
+};
+
+// Create a pool of worker threads, if num_threads is 0 one fewer than the hardware thread count is used
+// The pool must be deleted with el_thread_pool_delete, even if creation fails
+bool el_thread_pool_new(struct el_thread_pool * pool, int num_threads);
+
+// Join all worker threads and free the pool's internal memory
+void el_thread_pool_delete(struct el_thread_pool * pool);
+
+// Run fn for each task index in [0, num_tasks) and wait for all of them to complete
+// Each thread starts on an even share of consecutive tasks, a thread which finishes its own steals from the others
+// The calling thread also runs tasks, so a pool with no workers runs everything in serial
+// Not re-entrant, tasks must not call el_thread_pool_for on the same pool
+void el_thread_pool_for(struct el_thread_pool * pool, int num_tasks, el_task_fn fn, void * context);
@@ -0,0 +1,181 @@
+#include "thread.h"
+#include <allocators/fmalloc.h>
+#include <stdio.h>
+
+#ifndef SYSTEM_WINDOWS
+	#include <unistd.h>
+#endif
+
+// Platform thread entry points have different signatures, so threads start in a trampoline
+struct el_thread_start
+{
+	el_thread_fn fn;
+	void * arg;
+};
+
+#ifdef SYSTEM_WINDOWS
+static DWORD WINAPI el_thread_trampoline(LPVOID param)
+#else
+static void * el_thread_trampoline(void * param)
+#endif
+{
+	struct el_thread_start start = *(struct el_thread_start *)param;
+	ffree(param);
+	start.fn(start.arg);
+	return 0;
+}
+
+bool el_thread_new(el_thread * thread, el_thread_fn fn, void * arg)
+{
+	struct el_thread_start * start = fmalloc(sizeof *start);
+	if(!start)
+	{
+		return false;
+	}
+	start->fn = fn;
+	start->arg = arg;
+
+#ifdef SYSTEM_WINDOWS
+	*thread = CreateThread(NULL, 0, el_thread_trampoline, start, 0, NULL);
+	bool failed = *thread == NULL;
+#else
+	bool failed = pthread_create(thread, NULL, el_thread_trampoline, start) != 0;
+#endif
+
+	if(failed)
+	{
+		fprintf(stderr, "Failed to create thread\n");
+		ffree(start);
+		return false;
+	}
+	return true;
+}
+
+void el_thread_join(el_thread thread)
+{
+#ifdef SYSTEM_WINDOWS
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+#else
+	pthread_join(thread, NULL);
+#endif
+}
+
+int el_num_hardware_threads(void)
+{
+#ifdef SYSTEM_WINDOWS
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	int num_threads = (int)info.dwNumberOfProcessors;
+#else
+	int num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return num_threads > 0 ? num_threads : 1;
+}
+
+void el_mutex_new(el_mutex * mutex)
+{
+#ifdef SYSTEM_WINDOWS
+	InitializeSRWLock(mutex);
+#else
+	pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void el_mutex_delete(el_mutex * mutex)
+{
+#ifndef SYSTEM_WINDOWS
+	pthread_mutex_destroy(mutex);
+#endif
+}
+
+void el_mutex_lock(el_mutex * mutex)
+{
+#ifdef SYSTEM_WINDOWS
+	AcquireSRWLockExclusive(mutex);
+#else
+	pthread_mutex_lock(mutex);
+#endif
+}
+
+void el_mutex_unlock(el_mutex * mutex)
+{
+#ifdef SYSTEM_WINDOWS
+	ReleaseSRWLockExclusive(mutex);
+#else
+	pthread_mutex_unlock(mutex);
+#endif
+}
+
+void el_condition_new(el_condition * condition)
+{
+#ifdef SYSTEM_WINDOWS
+	InitializeConditionVariable(condition);
+#else
+	pthread_cond_init(condition, NULL);
+#endif
+}
+
+void el_condition_delete(el_condition * condition)
+{
+#ifndef SYSTEM_WINDOWS
+	pthread_cond_destroy(condition);
+#endif
+}
+
+void el_condition_wait(el_condition * condition, el_mutex * mutex)
+{
+#ifdef SYSTEM_WINDOWS
+	SleepConditionVariableSRW(condition, mutex, INFINITE, 0);
+#else
+	pthread_cond_wait(condition, mutex);
+#endif
+}
+
+void el_condition_broadcast(el_condition * condition)
+{
+#ifdef SYSTEM_WINDOWS
+	WakeAllConditionVariable(condition);
+#else
+	pthread_cond_broadcast(condition);
+#endif
+}
+
+int el_atomic_fetch_add(int volatile * target, int value)
+{
+#ifdef SYSTEM_WINDOWS
+	return (int)InterlockedExchangeAdd((LONG volatile *)target, value);
+#else
+	return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+uint64_t el_atomic_load_64(uint64_t volatile * target)
+{
+#ifdef SYSTEM_WINDOWS
+	return (uint64_t)InterlockedCompareExchange64((LONG64 volatile *)target, 0, 0);
+#else
+	return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+#endif
+}
+
+void el_atomic_store_64(uint64_t volatile * target, uint64_t value)
+{
+#ifdef SYSTEM_WINDOWS
+	InterlockedExchange64((LONG64 volatile *)target, (LONG64)value);
+#else
+	__atomic_store_n(target, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+bool el_atomic_compare_exchange_64(uint64_t volatile * target, uint64_t * expected, uint64_t desired)
+{
+#ifdef SYSTEM_WINDOWS
+	uint64_t previous = (uint64_t)InterlockedCompareExchange64((LONG64 volatile *)target, (LONG64)desired, (LONG64)*expected);
+	bool is_exchanged = previous == *expected;
+	*expected = previous;
+	return is_exchanged;
+#else
+	return __atomic_compare_exchange_n(target, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
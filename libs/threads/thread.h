@@ -0,0 +1,51 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef SYSTEM_WINDOWS
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+
+	typedef HANDLE el_thread;
+	typedef SRWLOCK el_mutex;
+	typedef CONDITION_VARIABLE el_condition;
+#else
+	#include <pthread.h>
+
+	typedef pthread_t el_thread;
+	typedef pthread_mutex_t el_mutex;
+	typedef pthread_cond_t el_condition;
+#endif
+
+typedef void (*el_thread_fn)(void * arg);
+
+// Start a new thread running fn(arg)
+// Returns false if the thread could not be created, otherwise the thread must be joined with el_thread_join
+bool el_thread_new(el_thread * thread, el_thread_fn fn, void * arg);
+
+void el_thread_join(el_thread thread);
+
+// Returns the number of threads the hardware can run concurrently, at least 1
+int el_num_hardware_threads(void);
+
+void el_mutex_new(el_mutex * mutex);
+void el_mutex_delete(el_mutex * mutex);
+void el_mutex_lock(el_mutex * mutex);
+void el_mutex_unlock(el_mutex * mutex);
+
+void el_condition_new(el_condition * condition);
+void el_condition_delete(el_condition * condition);
+
+// Atomically release the mutex and wait for the condition to be signalled, the mutex is held again on return
+// Spurious wake-ups are possible so the caller must re-check what it was waiting for
+void el_condition_wait(el_condition * condition, el_mutex * mutex);
+void el_condition_broadcast(el_condition * condition);
+
+// Atomically add value to target, returning the previous value
+int el_atomic_fetch_add(int volatile * target, int value);
+
+uint64_t el_atomic_load_64(uint64_t volatile * target);
+void el_atomic_store_64(uint64_t volatile * target, uint64_t value);
+
+// Atomically replace target with desired if it holds *expected and return true, otherwise load it into *expected and return false
+bool el_atomic_compare_exchange_64(uint64_t volatile * target, uint64_t * expected, uint64_t desired);
@@ -0,0 +1,535 @@
+#include "bytecode-compiler.h"
+#include "vm.h"
+#include <compiler/error.h>
+#include <compiler/semantic-analysis/type-table.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+
+// An instruction of the block being compiled, whose jump targets are still ir blocks
+struct el_bc_pending
+{
+	int op;
+	int a;
+	int b;
+	int c;
+	int target; // Block jumped to, or taken by a branch if its condition holds
+	int other_target; // Block taken by a branch if its condition does not hold
+};
+
+// Operand of an emitted jump which is patched with the start of block once every block is laid out
+struct el_bc_fixup
+{
+	int instruction;
+	int operand;
+	int block;
+};
+
+struct el_bc_compiler
+{
+	struct el_bc_program * program;
+	struct el_ir_module const * module;
+	struct el_ir_function const * function;
+
+	// Scratch of the function being compiled
+	el_VECTOR_MEMBERS(int, num_reads);
+	el_VECTOR_MEMBERS(int, num_writes);
+	el_VECTOR_MEMBERS(int, block_starts);
+	el_VECTOR_MEMBERS(struct el_bc_fixup, fixups);
+	el_VECTOR_MEMBERS(struct el_bc_pending, pending);
+	int err;
+};
+
+static int const ir_to_bc_ops[el_ir_op_count] = {
+	[el_IR_LOAD_INT] = el_BC_LOAD_INT,
+	[el_IR_LOAD_FLOAT] = el_BC_LOAD_FLOAT,
+	[el_IR_LOAD_STRING] = el_BC_LOAD_STRING,
+	[el_IR_MOVE] = el_BC_MOVE,
+	[el_IR_LOAD_GLOBAL] = el_BC_LOAD_GLOBAL,
+	[el_IR_STORE_GLOBAL] = el_BC_STORE_GLOBAL,
+	[el_IR_ADD_INT] = el_BC_ADD_INT,
+	[el_IR_SUB_INT] = el_BC_SUB_INT,
+	[el_IR_MUL_INT] = el_BC_MUL_INT,
+	[el_IR_DIV_INT] = el_BC_DIV_INT,
+	[el_IR_ADD_FLOAT] = el_BC_ADD_FLOAT,
+	[el_IR_SUB_FLOAT] = el_BC_SUB_FLOAT,
+	[el_IR_MUL_FLOAT] = el_BC_MUL_FLOAT,
+	[el_IR_DIV_FLOAT] = el_BC_DIV_FLOAT,
+	[el_IR_EQ_INT] = el_BC_EQ_INT,
+	[el_IR_LT_INT] = el_BC_LT_INT,
+	[el_IR_LE_INT] = el_BC_LE_INT,
+	[el_IR_EQ_FLOAT] = el_BC_EQ_FLOAT,
+	[el_IR_LT_FLOAT] = el_BC_LT_FLOAT,
+	[el_IR_LE_FLOAT] = el_BC_LE_FLOAT,
+	[el_IR_EQ_STRING] = el_BC_EQ_STRING,
+	[el_IR_AND] = el_BC_AND,
+	[el_IR_OR] = el_BC_OR,
+	[el_IR_NEW_DAT] = el_BC_NEW_DAT,
+	[el_IR_GET_FIELD] = el_BC_GET_FIELD,
+	[el_IR_SET_FIELD] = el_BC_SET_FIELD,
+	[el_IR_NEW_SLICE] = el_BC_NEW_SLICE,
+	[el_IR_NEW_ZERO_SLICE] = el_BC_NEW_ZERO_SLICE,
+	[el_IR_GET_ELEMENT] = el_BC_GET_ELEMENT,
+	[el_IR_SET_ELEMENT] = el_BC_SET_ELEMENT,
+	[el_IR_LENGTH] = el_BC_LENGTH,
+	[el_IR_GET_COLUMN] = el_BC_GET_COLUMN,
+	[el_IR_CALL] = el_BC_CALL,
+	[el_IR_KERNEL] = el_BC_KERNEL,
+	[el_IR_PARALLEL_FOR] = el_BC_PARALLEL_FOR,
+	[el_IR_NEW_VECTOR] = el_BC_NEW_VECTOR,
+	[el_IR_GET_LANE] = el_BC_GET_LANE,
+	[el_IR_ADD_INT_VECTOR] = el_BC_ADD_INT_VECTOR,
+	[el_IR_SUB_INT_VECTOR] = el_BC_SUB_INT_VECTOR,
+	[el_IR_MUL_INT_VECTOR] = el_BC_MUL_INT_VECTOR,
+	[el_IR_ADD_FLOAT_VECTOR] = el_BC_ADD_FLOAT_VECTOR,
+	[el_IR_SUB_FLOAT_VECTOR] = el_BC_SUB_FLOAT_VECTOR,
+	[el_IR_MUL_FLOAT_VECTOR] = el_BC_MUL_FLOAT_VECTOR,
+	[el_IR_DIV_FLOAT_VECTOR] = el_BC_DIV_FLOAT_VECTOR,
+	[el_IR_JUMP] = el_BC_JUMP,
+	[el_IR_BRANCH] = el_BC_JUMP_IF,
+	[el_IR_RET] = el_BC_RET,
+	[el_IR_RET_VOID] = el_BC_RET_VOID
+};
+
+static int el_compile_function(struct el_bc_compiler * c, struct el_ir_function const * function, struct el_bc_function * compiled);
+static void el_count_register_uses(struct el_bc_compiler * c);
+static void el_translate_block(struct el_bc_compiler * c, struct el_ir_block const * block);
+static int el_push_operand_pair(struct el_bc_compiler * c, int lhs, int rhs);
+static bool el_fuse_into_previous(struct el_bc_compiler const * c, struct el_bc_pending * previous, struct el_bc_pending const * pending);
+static void el_emit_block(struct el_bc_compiler * c, int block);
+static void el_emit(struct el_bc_compiler * c, int op, int a, int b, int c_operand);
+static void el_emit_jump(struct el_bc_compiler * c, int op, int a, int b, int operand, int block);
+static bool el_is_temporary(struct el_bc_compiler const * c, int reg);
+static bool el_writes_a(int op);
+static int el_field_offset(struct el_ir_module const * module, int type, int field);
+static void el_bc_compiler_delete(struct el_bc_compiler * c);
+
+int el_bc_compile(struct el_bc_program * program, struct el_ir_module const * module)
+{
+	assert(program && module);
+	*program = (struct el_bc_program){ .module = module, .init_function = module->init_function, .num_globals = module->num_globals };
+	struct el_bc_compiler c = { .program = program, .module = module, .err = el_SUCCESS };
+
+	int err = el_vector_reserve(program, functions, module->num_functions, NULL) ? el_SUCCESS : el_ALLOCATION_ERROR;
+	for(int i = 0; i < module->num_functions && err == 0; ++i)
+	{
+		struct el_bc_function * compiled = &program->functions[program->num_functions++];
+		err = el_compile_function(&c, &module->functions[i], compiled);
+	}
+
+	// Code and operands no longer move once every function is compiled
+	for(int i = 0; i < program->num_functions && err == 0; ++i)
+	{
+		struct el_bc_function * function = &program->functions[i];
+		function->code = program->code + function->first_instruction;
+		function->operands = program->operands + function->first_operand;
+	}
+
+	el_bc_compiler_delete(&c);
+	if(err == el_ALLOCATION_ERROR)
+	{
+		fprintf(stderr, "Failed to allocate bytecode\n");
+	}
+	if(err)
+	{
+		el_bc_program_delete(program);
+	}
+	return err;
+}
+
+static int el_compile_function(struct el_bc_compiler * c, struct el_ir_function const * function, struct el_bc_function * compiled)
+{
+	struct el_bc_program * program = c->program;
+	c->function = function;
+
+	// The register after the function's own receives the results of calls to void functions
+	*compiled = (struct el_bc_function){
+		.name = function->name,
+		.return_type = function->return_type,
+		.num_parameters = function->num_parameters,
+		.num_registers = function->num_registers + 1,
+		.kernels = function->kernels,
+		.owned_vectors = function->owned_vectors,
+		.first_instruction = program->num_code,
+		.first_operand = program->num_operands,
+		.num_operands = function->num_operands
+	};
+
+	if(function->num_blocks == 0)
+	{
+		fprintf(stderr, "Cannot compile %s, its body was not parsed\n", function->name);
+		return el_UNPARSED_FUNCTION_BODY_ERROR;
+	}
+
+	if(!el_vector_reserve(program, operands, program->num_operands + function->num_operands, NULL)
+		|| !el_vector_reserve(c, block_starts, function->num_blocks, NULL))
+		return el_ALLOCATION_ERROR;
+
+	for(int i = 0; i < function->num_operands; ++i)
+	{
+		program->operands[program->num_operands++] = function->operands[i];
+	}
+
+	el_count_register_uses(c);
+	c->num_fixups = 0;
+	c->num_block_starts = function->num_blocks;
+	for(int i = 0; i < function->num_blocks && c->err == 0; ++i)
+	{
+		c->block_starts[i] = program->num_code - compiled->first_instruction;
+		el_translate_block(c, &function->blocks[i]);
+		el_emit_block(c, i);
+	}
+
+	// Vector ops append their operands after the ir function's
+	compiled->num_operands = program->num_operands - compiled->first_operand;
+	compiled->num_instructions = program->num_code - compiled->first_instruction;
+	if(c->err == 0 && compiled->num_instructions > el_IR_MAX_INDEX)
+	{
+		fprintf(stderr, "Failed to compile %s, it has more than %d instructions\n", function->name ? function->name : "the file scope", el_IR_MAX_INDEX);
+		c->err = el_EXCEEDED_IR_LIMIT_ERROR;
+	}
+	if(c->err)
+		return c->err;
+
+	// Jumps are patched once the blocks after them have been laid out
+	for(int i = 0; i < c->num_fixups; ++i)
+	{
+		struct el_bc_fixup const * fixup = &c->fixups[i];
+		struct el_bc_instruction * instruction = &program->code[compiled->first_instruction + fixup->instruction];
+		uint16_t target = (uint16_t)c->block_starts[fixup->block];
+		if(fixup->operand == 0)
+		{
+			instruction->a = target;
+		}
+		else if(fixup->operand == 1)
+		{
+			instruction->b = target;
+		}
+		else
+		{
+			instruction->c = target;
+		}
+	}
+	return el_SUCCESS;
+}
+
+static void el_count_register_uses(struct el_bc_compiler * c)
+{
+	struct el_ir_function const * function = c->function;
+	if(!el_vector_reserve(c, num_reads, function->num_registers, NULL) || !el_vector_reserve(c, num_writes, function->num_registers, NULL))
+	{
+		c->err = el_ALLOCATION_ERROR;
+		return;
+	}
+	for(int i = 0; i < function->num_registers; ++i)
+	{
+		c->num_reads[i] = 0;
+		c->num_writes[i] = 0;
+	}
+
+	for(int i = 0; i < function->num_instructions; ++i)
+	{
+		struct el_ir_instruction const * instruction = &function->instructions[i];
+		struct el_ir_op_info const * info = el_ir_op_info(instruction->op);
+		uint16_t const operands[3] = { instruction->a, instruction->b, instruction->c };
+		for(int j = 0; j < 3; ++j)
+		{
+			if(info->operand_kinds[j] != el_IR_OPERAND_REGISTER || operands[j] == el_IR_NO_REGISTER)
+				continue;
+
+			if(j == 0 && info->writes_a)
+			{
+				++c->num_writes[operands[j]];
+			}
+			else
+			{
+				++c->num_reads[operands[j]];
+			}
+		}
+
+		// Registers listed in operands are read by the call, slice literal, kernel or parallel for
+		int num_operands = instruction->op == el_IR_NEW_SLICE || instruction->op == el_IR_NEW_VECTOR ? instruction->b
+			: instruction->op == el_IR_CALL ? c->module->functions[instruction->b].num_parameters
+			: instruction->op == el_IR_PARALLEL_FOR ? c->module->functions[instruction->b].num_parameters - 2
+			: instruction->op == el_IR_KERNEL ? 1 + function->kernels[instruction->b].num_arguments : 0;
+		for(int j = 0; j < num_operands; ++j)
+		{
+			++c->num_reads[function->operands[instruction->c + j]];
+		}
+	}
+}
+
+// Translate the block's instructions into pending, fusing each into the one before it where possible
+static void el_translate_block(struct el_bc_compiler * c, struct el_ir_block const * block)
+{
+	struct el_ir_function const * function = c->function;
+	c->num_pending = 0;
+	if(!el_vector_reserve(c, pending, block->num_instructions, NULL))
+	{
+		c->err = el_ALLOCATION_ERROR;
+		return;
+	}
+
+	for(int i = 0; i < block->num_instructions; ++i)
+	{
+		struct el_ir_instruction const * instruction = &function->instructions[block->first_instruction + i];
+		struct el_bc_pending pending = {
+			.op = ir_to_bc_ops[instruction->op],
+			.a = instruction->a,
+			.b = instruction->b,
+			.c = instruction->c,
+			.target = -1,
+			.other_target = -1
+		};
+
+		switch(instruction->op)
+		{
+		case el_IR_NEW_DAT:
+			pending.b = el_get_layout(&c->module->layout, function->register_types[instruction->a])->block_size / (int)sizeof(union el_value);
+			break;
+		case el_IR_GET_FIELD:
+		case el_IR_GET_COLUMN:
+			pending.c = el_field_offset(c->module, function->register_types[instruction->b], instruction->c);
+			break;
+		case el_IR_SET_FIELD:
+			pending.b = el_field_offset(c->module, function->register_types[instruction->a], instruction->b);
+			break;
+		case el_IR_CALL:
+			pending.a = instruction->a == el_IR_NO_REGISTER ? function->num_registers : instruction->a;
+			break;
+		case el_IR_ADD_INT_VECTOR:
+		case el_IR_SUB_INT_VECTOR:
+		case el_IR_MUL_INT_VECTOR:
+		case el_IR_ADD_FLOAT_VECTOR:
+		case el_IR_SUB_FLOAT_VECTOR:
+		case el_IR_MUL_FLOAT_VECTOR:
+		case el_IR_DIV_FLOAT_VECTOR:
+			pending.b = el_get_layout(&c->module->layout, function->register_types[instruction->a])->block_size / (int)sizeof(union el_value);
+			pending.c = el_push_operand_pair(c, instruction->b, instruction->c);
+			break;
+		case el_IR_JUMP:
+			pending.target = instruction->a;
+			break;
+		case el_IR_BRANCH:
+			pending.target = instruction->b;
+			pending.other_target = instruction->c;
+			break;
+		}
+
+		struct el_bc_pending * previous = c->num_pending > 0 ? &c->pending[c->num_pending - 1] : NULL;
+		if(!previous || !el_fuse_into_previous(c, previous, &pending))
+		{
+			c->pending[c->num_pending++] = pending;
+		}
+	}
+}
+
+// Returns the index of lhs, followed by rhs, in the operands of the function being compiled
+static int el_push_operand_pair(struct el_bc_compiler * c, int lhs, int rhs)
+{
+	struct el_bc_program * program = c->program;
+	struct el_bc_function const * compiled = &program->functions[program->num_functions - 1];
+	int first_operand = program->num_operands - compiled->first_operand;
+	if(first_operand + 1 > el_IR_MAX_INDEX)
+	{
+		fprintf(stderr, "Failed to compile %s, it has more than %d operands\n", c->function->name ? c->function->name : "the file scope", el_IR_MAX_INDEX);
+		c->err = c->err ? c->err : el_EXCEEDED_IR_LIMIT_ERROR;
+		return 0;
+	}
+	if(!el_vector_reserve(program, operands, program->num_operands + 2, NULL))
+	{
+		c->err = el_ALLOCATION_ERROR;
+		return 0;
+	}
+	program->operands[program->num_operands++] = (uint16_t)lhs;
+	program->operands[program->num_operands++] = (uint16_t)rhs;
+	return first_operand;
+}
+
+// Returns true if pending was fused into the instruction before it, which writes a temporary pending reads
+static bool el_fuse_into_previous(struct el_bc_compiler const * c, struct el_bc_pending * previous, struct el_bc_pending const * pending)
+{
+	if(!el_writes_a(previous->op) || !el_is_temporary(c, previous->a))
+		return false;
+
+	int temporary = previous->a;
+	switch(pending->op)
+	{
+	case el_BC_MOVE:
+		// The result is written straight to the variable rather than through the temporary
+		if(pending->b != temporary)
+			return false;
+		previous->a = pending->a;
+		return true;
+	case el_BC_ADD_INT:
+	case el_BC_SUB_INT:
+	{
+		// A small int constant becomes an immediate operand
+		if(previous->op != el_BC_LOAD_INT || (pending->c != temporary && (pending->op != el_BC_ADD_INT || pending->b != temporary)))
+			return false;
+
+		long long value = c->module->int_constants[previous->b];
+		value = pending->op == el_BC_SUB_INT ? -value : value;
+		if(value < INT16_MIN || value > INT16_MAX)
+			return false;
+
+		int lhs = pending->c == temporary ? pending->b : pending->c;
+		*previous = (struct el_bc_pending){ el_BC_ADD_INT_IMMEDIATE, pending->a, lhs, (uint16_t)(int16_t)value, -1, -1 };
+		return true;
+	}
+	case el_BC_JUMP_IF:
+	{
+		if(pending->a != temporary)
+			return false;
+
+		int op = 0;
+		switch(previous->op)
+		{
+		case el_BC_EQ_INT:
+			op = el_BC_JUMP_UNLESS_EQ_INT;
+			break;
+		case el_BC_LT_INT:
+			op = el_BC_JUMP_UNLESS_LT_INT;
+			break;
+		case el_BC_LE_INT:
+			op = el_BC_JUMP_UNLESS_LE_INT;
+			break;
+		case el_BC_EQ_FLOAT:
+			op = el_BC_JUMP_UNLESS_EQ_FLOAT;
+			break;
+		case el_BC_LT_FLOAT:
+			op = el_BC_JUMP_UNLESS_LT_FLOAT;
+			break;
+		case el_BC_LE_FLOAT:
+			op = el_BC_JUMP_UNLESS_LE_FLOAT;
+			break;
+		default:
+			return false;
+		}
+		*previous = (struct el_bc_pending){ op, previous->b, previous->c, 0, pending->target, pending->other_target };
+		return true;
+	}
+	}
+	return false;
+}
+
+// Emit the pending instructions of block, dropping jumps to the block laid out after it
+static void el_emit_block(struct el_bc_compiler * c, int block)
+{
+	int next_block = block + 1;
+	for(int i = 0; i < c->num_pending && c->err == 0; ++i)
+	{
+		struct el_bc_pending const * pending = &c->pending[i];
+		switch(pending->op)
+		{
+		case el_BC_LOAD_INT:
+		{
+			long long value = c->module->int_constants[pending->b];
+			if(value >= INT16_MIN && value <= INT16_MAX)
+			{
+				el_emit(c, el_BC_LOAD_IMMEDIATE, pending->a, (uint16_t)(int16_t)value, 0);
+			}
+			else
+			{
+				el_emit(c, el_BC_LOAD_INT, pending->a, pending->b, 0);
+			}
+			break;
+		}
+		case el_BC_JUMP:
+			if(pending->target != next_block)
+			{
+				el_emit_jump(c, el_BC_JUMP, 0, 0, 0, pending->target);
+			}
+			break;
+		case el_BC_JUMP_IF:
+			if(pending->target == next_block)
+			{
+				el_emit_jump(c, el_BC_JUMP_IF_NOT, pending->a, 0, 1, pending->other_target);
+			}
+			else
+			{
+				el_emit_jump(c, el_BC_JUMP_IF, pending->a, 0, 1, pending->target);
+				if(pending->other_target != next_block)
+				{
+					el_emit_jump(c, el_BC_JUMP, 0, 0, 0, pending->other_target);
+				}
+			}
+			break;
+		case el_BC_JUMP_UNLESS_EQ_INT:
+		case el_BC_JUMP_UNLESS_LT_INT:
+		case el_BC_JUMP_UNLESS_LE_INT:
+		case el_BC_JUMP_UNLESS_EQ_FLOAT:
+		case el_BC_JUMP_UNLESS_LT_FLOAT:
+		case el_BC_JUMP_UNLESS_LE_FLOAT:
+			el_emit_jump(c, pending->op, pending->a, pending->b, 2, pending->other_target);
+			if(pending->target != next_block)
+			{
+				el_emit_jump(c, el_BC_JUMP, 0, 0, 0, pending->target);
+			}
+			break;
+		default:
+			el_emit(c, pending->op, pending->a, pending->b, pending->c);
+			break;
+		}
+	}
+}
+
+static void el_emit(struct el_bc_compiler * c, int op, int a, int b, int c_operand)
+{
+	struct el_bc_instruction * instruction = el_vector_push(c->program, code, NULL);
+	if(!instruction)
+	{
+		c->err = el_ALLOCATION_ERROR;
+		return;
+	}
+	*instruction = (struct el_bc_instruction){ (uint16_t)op, (uint16_t)a, (uint16_t)b, (uint16_t)c_operand };
+}
+
+// operand is the index of the operand holding the target, 0 for a, 1 for b and 2 for c
+static void el_emit_jump(struct el_bc_compiler * c, int op, int a, int b, int operand, int block)
+{
+	struct el_bc_fixup * fixup = el_vector_push(c, fixups, NULL);
+	if(!fixup)
+	{
+		c->err = el_ALLOCATION_ERROR;
+		return;
+	}
+	struct el_bc_function const * compiled = &c->program->functions[c->program->num_functions - 1];
+	*fixup = (struct el_bc_fixup){ c->program->num_code - compiled->first_instruction, operand, block };
+	el_emit(c, op, a, b, 0);
+}
+
+// A register written once and read once, s.t. the instruction reading it may take over the instruction writing it
+static bool el_is_temporary(struct el_bc_compiler const * c, int reg)
+{
+	return reg >= c->function->num_parameters && reg < c->function->num_registers && c->num_reads[reg] == 1 && c->num_writes[reg] == 1;
+}
+
+// Calls to void functions write the scratch register, which is never a temporary
+static bool el_writes_a(int op)
+{
+	switch(op)
+	{
+	case el_BC_STORE_GLOBAL:
+	case el_BC_SET_FIELD:
+	case el_BC_SET_ELEMENT:
+	case el_BC_PARALLEL_FOR:
+		return false;
+	default:
+		return op < el_BC_JUMP;
+	}
+}
+
+static int el_field_offset(struct el_ir_module const * module, int type, int field)
+{
+	return el_get_layout(&module->layout, type)->field_offsets[field];
+}
+
+static void el_bc_compiler_delete(struct el_bc_compiler * c)
+{
+	el_vector_free(c, num_reads, NULL);
+	el_vector_free(c, num_writes, NULL);
+	el_vector_free(c, block_starts, NULL);
+	el_vector_free(c, fixups, NULL);
+	el_vector_free(c, pending, NULL);
+}
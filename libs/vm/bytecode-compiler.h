@@ -0,0 +1,8 @@
+#pragma once
+#include "bytecode.h"
+
+// Compile every function of the module to bytecode, the module must outlive the program
+// Blocks are laid out in the order of the ir, s.t. a jump to the next block becomes a fall through
+// Temporaries used once by the next instruction are fused into it, e.g. a compare into the branch on its result
+// On failure the program is left empty
+int el_bc_compile(struct el_bc_program * program, struct el_ir_module const * module);
@@ -0,0 +1,25 @@
+#include "bytecode.h"
+#include <string.h>
+
+void el_bc_program_delete(struct el_bc_program * program)
+{
+	if(program)
+	{
+		el_vector_free(program, functions, NULL);
+		el_vector_free(program, code, NULL);
+		el_vector_free(program, operands, NULL);
+		*program = (struct el_bc_program){ 0 };
+	}
+}
+
+int el_bc_find_function(struct el_bc_program const * program, char const * name)
+{
+	int length = (int)strlen(name);
+	for(int i = 0; i < program->num_functions; ++i)
+	{
+		el_string function_name = program->functions[i].name;
+		if(function_name && el_string_length(function_name) == length && memcmp(function_name, name, length) == 0)
+			return i;
+	}
+	return -1;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <compiler/ir/ir.h>
+#include <containers/vector.h>
+
+// Ops of the interpreter, the ops of the ir along with the forms the bytecode compiler fuses them into
+// Operands are named a, b and c as in the ir, jump targets are indices into the function's code
+enum el_bc_op
+{
+	el_BC_LOAD_INT, // a = int_constants[b]
+	el_BC_LOAD_IMMEDIATE, // a = (int16_t)b
+	el_BC_LOAD_FLOAT, // a = float_constants[b]
+	el_BC_LOAD_STRING, // a = strings[b]
+	el_BC_MOVE, // a = b
+	el_BC_LOAD_GLOBAL, // a = globals[b]
+	el_BC_STORE_GLOBAL, // globals[a] = b
+
+	// a = b op c, int arithmetic wraps on overflow
+	el_BC_ADD_INT,
+	el_BC_ADD_INT_IMMEDIATE, // a = b + (int16_t)c
+	el_BC_SUB_INT,
+	el_BC_MUL_INT,
+	el_BC_DIV_INT,
+	el_BC_ADD_FLOAT,
+	el_BC_SUB_FLOAT,
+	el_BC_MUL_FLOAT,
+	el_BC_DIV_FLOAT,
+	el_BC_EQ_INT,
+	el_BC_LT_INT,
+	el_BC_LE_INT,
+	el_BC_EQ_FLOAT,
+	el_BC_LT_FLOAT,
+	el_BC_LE_FLOAT,
+	el_BC_EQ_STRING,
+	el_BC_AND,
+	el_BC_OR,
+
+	// Fields are addressed by their byte offset in the block, see el_type_layout
+	el_BC_NEW_DAT, // a = block of b values, every value zeroed
+	el_BC_GET_FIELD, // a = the field of b at offset c
+	el_BC_SET_FIELD, // The field of a at offset b = c
+	el_BC_NEW_SLICE, // a = slice of the b registers operands[c], operands[c + 1], ...
+	el_BC_NEW_ZERO_SLICE, // a = slice of b elements, every element zeroed
+	el_BC_GET_ELEMENT, // a = b[c]
+	el_BC_SET_ELEMENT, // a[b] = c
+	el_BC_LENGTH, // a = number of elements of slice b
+	el_BC_GET_COLUMN, // a = the column of soa slice b at offset c, NULL if b is NULL
+	el_BC_CALL, // a = functions[b](operands[c], operands[c + 1], ...)
+	el_BC_KERNEL, // a = number of leading elements the function's kernels[b] ran for, see el_IR_KERNEL
+	el_BC_PARALLEL_FOR, // Run functions[b] for each of the a chunks of a range of operands[c] elements, see el_IR_PARALLEL_FOR
+
+	// Vectors are blocks of their lanes, NULL for the vector of zeros
+	// A vector written to a register which owns its block is written into the block, which is only allocated while a is NULL
+	el_BC_NEW_VECTOR, // a = vector of the b registers operands[c], operands[c + 1], ...
+	el_BC_GET_LANE, // a = lane c of vector b, 0 if b is NULL
+
+	// a = operands[c] op operands[c + 1] lane by lane, as a vector of b lanes, int lanes wrap on overflow
+	el_BC_ADD_INT_VECTOR,
+	el_BC_SUB_INT_VECTOR,
+	el_BC_MUL_INT_VECTOR,
+	el_BC_ADD_FLOAT_VECTOR,
+	el_BC_SUB_FLOAT_VECTOR,
+	el_BC_MUL_FLOAT_VECTOR,
+	el_BC_DIV_FLOAT_VECTOR,
+
+	el_BC_JUMP, // Continue at a
+	el_BC_JUMP_IF, // Continue at b if a is not 0
+	el_BC_JUMP_IF_NOT, // Continue at b if a is 0
+
+	// Continue at c unless a op b, a comparison fused with the branch on its result
+	el_BC_JUMP_UNLESS_EQ_INT,
+	el_BC_JUMP_UNLESS_LT_INT,
+	el_BC_JUMP_UNLESS_LE_INT,
+	el_BC_JUMP_UNLESS_EQ_FLOAT,
+	el_BC_JUMP_UNLESS_LT_FLOAT,
+	el_BC_JUMP_UNLESS_LE_FLOAT,
+
+	el_BC_RET, // Return a
+	el_BC_RET_VOID, // Return the zero value
+
+	el_bc_op_count
+};
+
+// Same size as an ir instruction, s.t. the interpreter streams through 8 bytes per instruction
+struct el_bc_instruction
+{
+	uint16_t op;
+	uint16_t a;
+	uint16_t b;
+	uint16_t c;
+};
+
+struct el_bc_function
+{
+	el_string name; // NULL for the init function
+	int return_type;
+	int num_parameters;
+	int num_registers; // Size of the function's frame, parameters take the first registers
+	struct el_ir_kernel const * kernels; // The ir function's, which the interpreter runs as they are
+	bool const * owned_vectors; // The ir function's, the registers whose vector blocks are written in place
+
+	// Views into the program's code and operands, set once every function is compiled
+	struct el_bc_instruction const * code;
+	uint16_t const * operands;
+
+	int first_instruction;
+	int num_instructions;
+	int first_operand;
+	int num_operands;
+};
+
+// Functions have the indices they have in the module they were compiled from
+// Constants and strings are read from the module, which must outlive the program
+struct el_bc_program
+{
+	struct el_ir_module const * module;
+	el_VECTOR_MEMBERS(struct el_bc_function, functions);
+	el_VECTOR_MEMBERS(struct el_bc_instruction, code);
+	el_VECTOR_MEMBERS(uint16_t, operands);
+	int init_function;
+	int num_globals;
+};
+
+void el_bc_program_delete(struct el_bc_program * program);
+
+// Returns the index of the function named name, or -1 if there is none
+int el_bc_find_function(struct el_bc_program const * program, char const * name);
@@ -0,0 +1,242 @@
+#include "vm-kernels.h"
+#include <string.h>
+#include <assert.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define el_VM_VECTOR_EXTENSIONS
+#endif
+
+#ifdef el_VM_VECTOR_EXTENSIONS
+
+// Elements each instruction runs for before the next instruction runs, s.t. dispatch is paid once per strip
+#define KERNEL_STRIP 32
+#define KERNEL_LANES 4
+#define KERNEL_VECTORS (KERNEL_STRIP / KERNEL_LANES)
+#define KERNEL_MAX_NUM_REGISTERS 64
+
+// Ints and floats share registers, a float vector is the bits of an int vector reinterpreted
+typedef long long el_int_lanes __attribute__((vector_size(KERNEL_LANES * 8)));
+typedef unsigned long long el_uint_lanes __attribute__((vector_size(KERNEL_LANES * 8)));
+typedef double el_float_lanes __attribute__((vector_size(KERNEL_LANES * 8)));
+
+// Every vector type fits in one of these, s.t. an op is the same instructions for any number of lanes
+typedef unsigned long long el_uint_vector __attribute__((vector_size(el_VM_MAX_NUM_LANES * 8)));
+typedef double el_float_vector __attribute__((vector_size(el_VM_MAX_NUM_LANES * 8)));
+
+long long el_vm_run_kernel(struct el_ir_module const * module, struct el_ir_kernel const * kernel, union el_value const * regs, uint16_t const * operands)
+{
+	long long n = regs[operands[0]].i;
+	if(n < KERNEL_STRIP || kernel->num_registers > KERNEL_MAX_NUM_REGISTERS)
+		return 0;
+
+	el_int_lanes lanes[KERNEL_MAX_NUM_REGISTERS][KERNEL_VECTORS];
+	union el_value * elements[KERNEL_MAX_NUM_REGISTERS] = { 0 };
+	el_int_lanes const iota = { 0, 1, 2, 3 };
+	int index = kernel->num_arguments;
+
+	// Arguments and constants are the same in every strip, scalars among them are broadcast to every lane once
+	for(int i = 0; i < kernel->num_arguments; ++i)
+	{
+		union el_value argument = regs[operands[1 + i]];
+		if(el_get_type(module->types, kernel->register_types[i])->kind == el_TYPE_SLICE)
+		{
+			elements[i] = ((struct el_vm_slice *)argument.p)->elements;
+			continue;
+		}
+		for(int j = 0; j < KERNEL_VECTORS; ++j)
+		{
+			lanes[i][j] = (el_int_lanes){ 0 } + argument.i;
+		}
+	}
+	for(int i = 0; i < kernel->num_instructions; ++i)
+	{
+		struct el_ir_instruction const * in = &kernel->instructions[i];
+		if(in->op != el_IR_LOAD_INT && in->op != el_IR_LOAD_FLOAT)
+			continue;
+
+		long long constant = 0;
+		if(in->op == el_IR_LOAD_INT)
+		{
+			constant = module->int_constants[in->b];
+		}
+		else
+		{
+			memcpy(&constant, &module->float_constants[in->b], sizeof constant);
+		}
+		for(int j = 0; j < KERNEL_VECTORS; ++j)
+		{
+			lanes[in->a][j] = (el_int_lanes){ 0 } + constant;
+		}
+	}
+
+#define A lanes[in->a][j]
+#define B lanes[in->b][j]
+#define C lanes[in->c][j]
+#define F(r) ((el_float_lanes)(r))
+#define U(r) ((el_uint_lanes)(r))
+#define LANE_OP(expression) for(int j = 0; j < KERNEL_VECTORS; ++j) { A = (el_int_lanes)(expression); } break
+
+	long long end = n - n % KERNEL_STRIP;
+	for(long long first = 0; first < end; first += KERNEL_STRIP)
+	{
+		for(int j = 0; j < KERNEL_VECTORS; ++j)
+		{
+			lanes[index][j] = iota + (first + j * KERNEL_LANES);
+		}
+
+		for(int i = 0; i < kernel->num_instructions; ++i)
+		{
+			struct el_ir_instruction const * in = &kernel->instructions[i];
+			switch(in->op)
+			{
+			case el_IR_LOAD_INT:
+			case el_IR_LOAD_FLOAT:
+				break;
+			case el_IR_ADD_INT:
+				LANE_OP(U(B) + U(C));
+			case el_IR_SUB_INT:
+				LANE_OP(U(B) - U(C));
+			case el_IR_MUL_INT:
+				LANE_OP(U(B) * U(C));
+			case el_IR_ADD_FLOAT:
+				LANE_OP(F(B) + F(C));
+			case el_IR_SUB_FLOAT:
+				LANE_OP(F(B) - F(C));
+			case el_IR_MUL_FLOAT:
+				LANE_OP(F(B) * F(C));
+			case el_IR_DIV_FLOAT:
+				LANE_OP(F(B) / F(C));
+
+			// Comparisons give -1 in each lane which holds, negated to 1
+			case el_IR_EQ_INT:
+				LANE_OP(-(B == C));
+			case el_IR_LT_INT:
+				LANE_OP(-(B < C));
+			case el_IR_LE_INT:
+				LANE_OP(-(B <= C));
+			case el_IR_EQ_FLOAT:
+				LANE_OP(-(el_int_lanes)(F(B) == F(C)));
+			case el_IR_LT_FLOAT:
+				LANE_OP(-(el_int_lanes)(F(B) < F(C)));
+			case el_IR_LE_FLOAT:
+				LANE_OP(-(el_int_lanes)(F(B) <= F(C)));
+			case el_IR_AND:
+				LANE_OP(-((B != 0) & (C != 0)));
+			case el_IR_OR:
+				LANE_OP(-((B != 0) | (C != 0)));
+			case el_IR_GET_ELEMENT:
+				memcpy(lanes[in->a], elements[in->b] + first, sizeof lanes[in->a]);
+				break;
+			case el_IR_SET_ELEMENT:
+				memcpy(elements[in->a] + first, lanes[in->c], sizeof lanes[in->c]);
+				break;
+			default:
+				assert(false);
+				return 0;
+			}
+		}
+	}
+
+#undef A
+#undef B
+#undef C
+#undef F
+#undef U
+#undef LANE_OP
+
+	return end;
+}
+
+// Lanes past num_lanes are zero on the way in and never written back
+void el_vm_vector_op(int op, union el_value * result, union el_value const * lhs, union el_value const * rhs, int num_lanes)
+{
+	assert(num_lanes <= el_VM_MAX_NUM_LANES);
+	size_t size = sizeof(union el_value) * (size_t)num_lanes;
+	el_uint_vector b = { 0 };
+	el_uint_vector c = { 0 };
+	el_uint_vector a = { 0 };
+	if(lhs)
+	{
+		memcpy(&b, lhs, size);
+	}
+	if(rhs)
+	{
+		memcpy(&c, rhs, size);
+	}
+
+	switch(op)
+	{
+	case el_BC_ADD_INT_VECTOR:
+		a = b + c;
+		break;
+	case el_BC_SUB_INT_VECTOR:
+		a = b - c;
+		break;
+	case el_BC_MUL_INT_VECTOR:
+		a = b * c;
+		break;
+	case el_BC_ADD_FLOAT_VECTOR:
+		a = (el_uint_vector)((el_float_vector)b + (el_float_vector)c);
+		break;
+	case el_BC_SUB_FLOAT_VECTOR:
+		a = (el_uint_vector)((el_float_vector)b - (el_float_vector)c);
+		break;
+	case el_BC_MUL_FLOAT_VECTOR:
+		a = (el_uint_vector)((el_float_vector)b * (el_float_vector)c);
+		break;
+	case el_BC_DIV_FLOAT_VECTOR:
+		a = (el_uint_vector)((el_float_vector)b / (el_float_vector)c);
+		break;
+	default:
+		assert(false);
+		break;
+	}
+	memcpy(result, &a, size);
+}
+
+#else
+
+long long el_vm_run_kernel(struct el_ir_module const * module, struct el_ir_kernel const * kernel, union el_value const * regs, uint16_t const * operands)
+{
+	(void)module;
+	(void)kernel;
+	(void)regs;
+	(void)operands;
+	return 0;
+}
+
+void el_vm_vector_op(int op, union el_value * result, union el_value const * lhs, union el_value const * rhs, int num_lanes)
+{
+	assert(num_lanes <= el_VM_MAX_NUM_LANES);
+	for(int i = 0; i < num_lanes; ++i)
+	{
+		union el_value b = lhs ? lhs[i] : (union el_value){ 0 };
+		union el_value c = rhs ? rhs[i] : (union el_value){ 0 };
+		switch(op)
+		{
+		case el_BC_ADD_INT_VECTOR:
+			result[i].i = (long long)((unsigned long long)b.i + (unsigned long long)c.i);
+			break;
+		case el_BC_SUB_INT_VECTOR:
+			result[i].i = (long long)((unsigned long long)b.i - (unsigned long long)c.i);
+			break;
+		case el_BC_MUL_INT_VECTOR:
+			result[i].i = (long long)((unsigned long long)b.i * (unsigned long long)c.i);
+			break;
+		case el_BC_ADD_FLOAT_VECTOR:
+			result[i].f = b.f + c.f;
+			break;
+		case el_BC_SUB_FLOAT_VECTOR:
+			result[i].f = b.f - c.f;
+			break;
+		case el_BC_MUL_FLOAT_VECTOR:
+			result[i].f = b.f * c.f;
+			break;
+		default:
+			result[i].f = b.f / c.f;
+			break;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+#include "vm.h"
+
+// Run kernel for the leading whole strips of its elements, returns the number of elements it ran for
+// operands are the registers of an el_BC_KERNEL, the number of elements followed by the kernel's arguments
+// Every slice argument holds at least that number of elements, as checked before the kernel is reached
+// Lanes run on the compiler's vector extensions, without them or for a kernel with too many registers no element is run
+long long el_vm_run_kernel(struct el_ir_module const * module, struct el_ir_kernel const * kernel, union el_value const * regs, uint16_t const * operands);
+
+// Most lanes of a vector type
+#define el_VM_MAX_NUM_LANES 8
+
+// Write lhs op rhs lane by lane to result for a vector op of the bytecode, e.g. el_BC_ADD_INT_VECTOR, NULL operands are vectors of zeros
+// result may be lhs or rhs
+// Lanes run on the compiler's vector extensions where it has them
+void el_vm_vector_op(int op, union el_value * result, union el_value const * lhs, union el_value const * rhs, int num_lanes);
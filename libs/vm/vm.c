@@ -0,0 +1,810 @@
+#include "vm.h"
+#include "vm-kernels.h"
+#include <allocators/fmalloc.h>
+#include <compiler/error.h>
+#include <threads/thread-pool.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+
+// Labels as values are a gnu extension, elsewhere the interpreter dispatches through a switch
+#if defined(__GNUC__) || defined(__clang__)
+#define el_VM_COMPUTED_GOTO
+#endif
+
+#define VM_MAX_NUM_REGISTERS (1 << 20)
+#define VM_MAX_NUM_FRAMES (1 << 16)
+
+// Values per heap chunk, larger objects get a chunk of their own
+#define VM_HEAP_CHUNK_SIZE (1 << 13)
+
+// State of a caller, saved while the function it called runs
+struct el_vm_frame
+{
+	struct el_bc_instruction const * return_address;
+	union el_value * registers;
+	struct el_bc_function const * function;
+};
+
+struct el_vm_heap_chunk
+{
+	struct el_vm_heap_chunk * next;
+	size_t size;
+	size_t capacity;
+	union el_value values[];
+};
+
+// A vm for each thread of the pool and one for the calling thread, the last
+// Workers of a worker have no pool, their single vm runs a nested parallel for in serial
+struct el_vm_workers
+{
+	struct el_thread_pool pool;
+	bool has_pool;
+	int num_vms;
+	struct el_vm vms[];
+};
+
+// The parallel for being run, shared by its chunks
+struct el_vm_parallel_for
+{
+	struct el_vm_workers * workers;
+	int function;
+	int num_parameters;
+	int num_chunks;
+	long long length;
+	union el_value * arguments; // num_parameters for each vm, the chunk's bounds followed by the captured values
+	int volatile num_failed;
+	int err;
+	el_string error_function;
+};
+
+static int el_vm_parallel_for(struct el_vm * vm, struct el_bc_instruction const * in, union el_value const * regs, uint16_t const * operands);
+static void el_vm_run_chunk(void * context, int chunk, int thread_index);
+static struct el_vm_workers * el_vm_new_workers(struct el_vm * vm);
+static void el_vm_delete_workers(struct el_vm * vm);
+static void el_vm_report(struct el_vm * vm, el_string function_name, int err);
+static union el_value * el_vm_alloc(struct el_vm * vm, size_t num_values);
+static bool el_vm_strings_equal(el_string lhs, el_string rhs);
+
+bool el_vm_new(struct el_vm * vm, struct el_bc_program const * program)
+{
+	assert(vm && program);
+	*vm = (struct el_vm){
+		.program = program,
+		.globals = fmalloc(sizeof(union el_value) * (program->num_globals > 0 ? program->num_globals : 1)),
+		.registers = fmalloc(sizeof(union el_value) * VM_MAX_NUM_REGISTERS),
+		.max_num_registers = VM_MAX_NUM_REGISTERS,
+		.frames = fmalloc(sizeof(struct el_vm_frame) * VM_MAX_NUM_FRAMES),
+		.max_num_frames = VM_MAX_NUM_FRAMES
+	};
+	if(!vm->globals || !vm->registers || !vm->frames)
+	{
+		el_vm_delete(vm);
+		return false;
+	}
+	memset(vm->globals, 0, sizeof(union el_value) * program->num_globals);
+	return true;
+}
+
+void el_vm_delete(struct el_vm * vm)
+{
+	if(!vm)
+		return;
+
+	el_vm_delete_workers(vm);
+	struct el_vm_heap_chunk * chunk = vm->heap;
+	while(chunk)
+	{
+		struct el_vm_heap_chunk * next = chunk->next;
+		ffree(chunk);
+		chunk = next;
+	}
+	if(!vm->parent)
+	{
+		ffree(vm->globals);
+	}
+	ffree(vm->registers);
+	ffree(vm->frames);
+	*vm = (struct el_vm){ 0 };
+}
+
+int el_vm_call(struct el_vm * vm, int function_index, union el_value const * arguments, union el_value * result)
+{
+	struct el_bc_program const * program = vm->program;
+	struct el_ir_module const * module = program->module;
+	struct el_bc_function const * functions = program->functions;
+	struct el_bc_function const * function = &functions[function_index];
+	if(function->num_registers > vm->max_num_registers)
+	{
+		el_vm_report(vm, function->name, el_STACK_OVERFLOW_RUNTIME_ERROR);
+		return el_STACK_OVERFLOW_RUNTIME_ERROR;
+	}
+
+	// Hot state is kept in locals, s.t. the compiler can keep it in registers
+	long long const * int_constants = module->int_constants;
+	double const * float_constants = module->float_constants;
+	el_string const * strings = module->strings;
+	union el_value * globals = vm->globals;
+	union el_value const * registers_end = vm->registers + vm->max_num_registers;
+	struct el_vm_frame const * frames_end = vm->frames + vm->max_num_frames;
+
+	// The bottom frame marks the return to el_vm_call
+	struct el_vm_frame * frame = vm->frames;
+	union el_value * regs = vm->registers;
+	struct el_bc_instruction const * code = function->code;
+	uint16_t const * operands = function->operands;
+	struct el_bc_instruction const * ip = code;
+	struct el_bc_instruction const * in = NULL;
+	union el_value value = { 0 };
+	long long num_executed = 0;
+	int err = el_SUCCESS;
+
+	if(function->num_parameters > 0)
+	{
+		memcpy(regs, arguments, sizeof(union el_value) * function->num_parameters);
+	}
+	memset(regs + function->num_parameters, 0, sizeof(union el_value) * (function->num_registers - function->num_parameters));
+
+#ifdef el_VM_COMPUTED_GOTO
+	static void const * const labels[el_bc_op_count] = {
+		[el_BC_LOAD_INT] = &&op_el_BC_LOAD_INT,
+		[el_BC_LOAD_IMMEDIATE] = &&op_el_BC_LOAD_IMMEDIATE,
+		[el_BC_LOAD_FLOAT] = &&op_el_BC_LOAD_FLOAT,
+		[el_BC_LOAD_STRING] = &&op_el_BC_LOAD_STRING,
+		[el_BC_MOVE] = &&op_el_BC_MOVE,
+		[el_BC_LOAD_GLOBAL] = &&op_el_BC_LOAD_GLOBAL,
+		[el_BC_STORE_GLOBAL] = &&op_el_BC_STORE_GLOBAL,
+		[el_BC_ADD_INT] = &&op_el_BC_ADD_INT,
+		[el_BC_ADD_INT_IMMEDIATE] = &&op_el_BC_ADD_INT_IMMEDIATE,
+		[el_BC_SUB_INT] = &&op_el_BC_SUB_INT,
+		[el_BC_MUL_INT] = &&op_el_BC_MUL_INT,
+		[el_BC_DIV_INT] = &&op_el_BC_DIV_INT,
+		[el_BC_ADD_FLOAT] = &&op_el_BC_ADD_FLOAT,
+		[el_BC_SUB_FLOAT] = &&op_el_BC_SUB_FLOAT,
+		[el_BC_MUL_FLOAT] = &&op_el_BC_MUL_FLOAT,
+		[el_BC_DIV_FLOAT] = &&op_el_BC_DIV_FLOAT,
+		[el_BC_EQ_INT] = &&op_el_BC_EQ_INT,
+		[el_BC_LT_INT] = &&op_el_BC_LT_INT,
+		[el_BC_LE_INT] = &&op_el_BC_LE_INT,
+		[el_BC_EQ_FLOAT] = &&op_el_BC_EQ_FLOAT,
+		[el_BC_LT_FLOAT] = &&op_el_BC_LT_FLOAT,
+		[el_BC_LE_FLOAT] = &&op_el_BC_LE_FLOAT,
+		[el_BC_EQ_STRING] = &&op_el_BC_EQ_STRING,
+		[el_BC_AND] = &&op_el_BC_AND,
+		[el_BC_OR] = &&op_el_BC_OR,
+		[el_BC_NEW_DAT] = &&op_el_BC_NEW_DAT,
+		[el_BC_GET_FIELD] = &&op_el_BC_GET_FIELD,
+		[el_BC_SET_FIELD] = &&op_el_BC_SET_FIELD,
+		[el_BC_NEW_SLICE] = &&op_el_BC_NEW_SLICE,
+		[el_BC_NEW_ZERO_SLICE] = &&op_el_BC_NEW_ZERO_SLICE,
+		[el_BC_GET_ELEMENT] = &&op_el_BC_GET_ELEMENT,
+		[el_BC_SET_ELEMENT] = &&op_el_BC_SET_ELEMENT,
+		[el_BC_LENGTH] = &&op_el_BC_LENGTH,
+		[el_BC_GET_COLUMN] = &&op_el_BC_GET_COLUMN,
+		[el_BC_CALL] = &&op_el_BC_CALL,
+		[el_BC_KERNEL] = &&op_el_BC_KERNEL,
+		[el_BC_PARALLEL_FOR] = &&op_el_BC_PARALLEL_FOR,
+		[el_BC_NEW_VECTOR] = &&op_el_BC_NEW_VECTOR,
+		[el_BC_GET_LANE] = &&op_el_BC_GET_LANE,
+		[el_BC_ADD_INT_VECTOR] = &&op_el_BC_ADD_INT_VECTOR,
+		[el_BC_SUB_INT_VECTOR] = &&op_el_BC_SUB_INT_VECTOR,
+		[el_BC_MUL_INT_VECTOR] = &&op_el_BC_MUL_INT_VECTOR,
+		[el_BC_ADD_FLOAT_VECTOR] = &&op_el_BC_ADD_FLOAT_VECTOR,
+		[el_BC_SUB_FLOAT_VECTOR] = &&op_el_BC_SUB_FLOAT_VECTOR,
+		[el_BC_MUL_FLOAT_VECTOR] = &&op_el_BC_MUL_FLOAT_VECTOR,
+		[el_BC_DIV_FLOAT_VECTOR] = &&op_el_BC_DIV_FLOAT_VECTOR,
+		[el_BC_JUMP] = &&op_el_BC_JUMP,
+		[el_BC_JUMP_IF] = &&op_el_BC_JUMP_IF,
+		[el_BC_JUMP_IF_NOT] = &&op_el_BC_JUMP_IF_NOT,
+		[el_BC_JUMP_UNLESS_EQ_INT] = &&op_el_BC_JUMP_UNLESS_EQ_INT,
+		[el_BC_JUMP_UNLESS_LT_INT] = &&op_el_BC_JUMP_UNLESS_LT_INT,
+		[el_BC_JUMP_UNLESS_LE_INT] = &&op_el_BC_JUMP_UNLESS_LE_INT,
+		[el_BC_JUMP_UNLESS_EQ_FLOAT] = &&op_el_BC_JUMP_UNLESS_EQ_FLOAT,
+		[el_BC_JUMP_UNLESS_LT_FLOAT] = &&op_el_BC_JUMP_UNLESS_LT_FLOAT,
+		[el_BC_JUMP_UNLESS_LE_FLOAT] = &&op_el_BC_JUMP_UNLESS_LE_FLOAT,
+		[el_BC_RET] = &&op_el_BC_RET,
+		[el_BC_RET_VOID] = &&op_el_BC_RET_VOID
+	};
+
+	// Each op jumps straight to the next op's code, giving every op its own indirect branch to predict
+#define VM_LOOP VM_NEXT;
+#define VM_CASE(op) op_##op:
+#define VM_NEXT { in = ip++; ++num_executed; goto *labels[in->op]; }
+#else
+#define VM_LOOP for(in = ip++;; in = ip++) switch(++num_executed, in->op)
+#define VM_CASE(op) case op:
+#define VM_NEXT continue
+#endif
+
+#define A regs[in->a]
+#define B regs[in->b]
+#define C regs[in->c]
+#define WRAP(op) (long long)((unsigned long long)B.i op (unsigned long long)C.i)
+
+	VM_LOOP
+	{
+	VM_CASE(el_BC_LOAD_INT)
+		A.i = int_constants[in->b];
+		VM_NEXT;
+	VM_CASE(el_BC_LOAD_IMMEDIATE)
+		A.i = (int16_t)in->b;
+		VM_NEXT;
+	VM_CASE(el_BC_LOAD_FLOAT)
+		A.f = float_constants[in->b];
+		VM_NEXT;
+	VM_CASE(el_BC_LOAD_STRING)
+		A.p = strings[in->b];
+		VM_NEXT;
+	VM_CASE(el_BC_MOVE)
+		A = B;
+		VM_NEXT;
+	VM_CASE(el_BC_LOAD_GLOBAL)
+		A = globals[in->b];
+		VM_NEXT;
+	VM_CASE(el_BC_STORE_GLOBAL)
+		globals[in->a] = B;
+		VM_NEXT;
+	VM_CASE(el_BC_ADD_INT)
+		A.i = WRAP(+);
+		VM_NEXT;
+	VM_CASE(el_BC_ADD_INT_IMMEDIATE)
+		A.i = (long long)((unsigned long long)B.i + (unsigned long long)(long long)(int16_t)in->c);
+		VM_NEXT;
+	VM_CASE(el_BC_SUB_INT)
+		A.i = WRAP(-);
+		VM_NEXT;
+	VM_CASE(el_BC_MUL_INT)
+		A.i = WRAP(*);
+		VM_NEXT;
+	VM_CASE(el_BC_DIV_INT)
+	{
+		long long dividend = B.i;
+		long long divisor = C.i;
+		if(divisor == 0)
+		{
+			err = el_DIVISION_BY_ZERO_RUNTIME_ERROR;
+			goto runtime_error;
+		}
+
+		// Dividing the smallest int by -1 wraps like every other int op
+		A.i = divisor == -1 ? (long long)(0ULL - (unsigned long long)dividend) : dividend / divisor;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_ADD_FLOAT)
+		A.f = B.f + C.f;
+		VM_NEXT;
+	VM_CASE(el_BC_SUB_FLOAT)
+		A.f = B.f - C.f;
+		VM_NEXT;
+	VM_CASE(el_BC_MUL_FLOAT)
+		A.f = B.f * C.f;
+		VM_NEXT;
+	VM_CASE(el_BC_DIV_FLOAT)
+		A.f = B.f / C.f;
+		VM_NEXT;
+	VM_CASE(el_BC_EQ_INT)
+		A.i = B.i == C.i;
+		VM_NEXT;
+	VM_CASE(el_BC_LT_INT)
+		A.i = B.i < C.i;
+		VM_NEXT;
+	VM_CASE(el_BC_LE_INT)
+		A.i = B.i <= C.i;
+		VM_NEXT;
+	VM_CASE(el_BC_EQ_FLOAT)
+		A.i = B.f == C.f;
+		VM_NEXT;
+	VM_CASE(el_BC_LT_FLOAT)
+		A.i = B.f < C.f;
+		VM_NEXT;
+	VM_CASE(el_BC_LE_FLOAT)
+		A.i = B.f <= C.f;
+		VM_NEXT;
+	VM_CASE(el_BC_EQ_STRING)
+		A.i = el_vm_strings_equal(B.p, C.p);
+		VM_NEXT;
+	VM_CASE(el_BC_AND)
+		A.i = B.i != 0 && C.i != 0;
+		VM_NEXT;
+	VM_CASE(el_BC_OR)
+		A.i = B.i != 0 || C.i != 0;
+		VM_NEXT;
+	VM_CASE(el_BC_NEW_DAT)
+	{
+		union el_value * fields = el_vm_alloc(vm, in->b > 0 ? in->b : 1);
+		if(!fields)
+		{
+			err = el_ALLOCATION_ERROR;
+			goto runtime_error;
+		}
+		memset(fields, 0, sizeof(union el_value) * in->b);
+		A.p = fields;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_GET_FIELD)
+	{
+		union el_value const * fields = B.p;
+		if(!fields)
+		{
+			err = el_NULL_REFERENCE_RUNTIME_ERROR;
+			goto runtime_error;
+		}
+		A = *(union el_value const *)((char const *)fields + in->c);
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_SET_FIELD)
+	{
+		union el_value * fields = A.p;
+		if(!fields)
+		{
+			err = el_NULL_REFERENCE_RUNTIME_ERROR;
+			goto runtime_error;
+		}
+		*(union el_value *)((char *)fields + in->b) = C;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_NEW_SLICE)
+	{
+		struct el_vm_slice * slice = (struct el_vm_slice *)el_vm_alloc(vm, 1 + (size_t)in->b);
+		if(!slice)
+		{
+			err = el_ALLOCATION_ERROR;
+			goto runtime_error;
+		}
+		slice->length = in->b;
+		for(int i = 0; i < in->b; ++i)
+		{
+			slice->elements[i] = regs[operands[in->c + i]];
+		}
+		A.p = slice;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_NEW_ZERO_SLICE)
+	{
+		size_t length = B.i > 0 ? (size_t)B.i : 0;
+		struct el_vm_slice * slice = (struct el_vm_slice *)el_vm_alloc(vm, 1 + length);
+		if(!slice)
+		{
+			err = el_ALLOCATION_ERROR;
+			goto runtime_error;
+		}
+		slice->length = (long long)length;
+		memset(slice->elements, 0, sizeof(union el_value) * length);
+		A.p = slice;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_GET_ELEMENT)
+	{
+		// The zero value of a slice is an empty slice
+		struct el_vm_slice const * slice = B.p;
+		unsigned long long index = (unsigned long long)C.i;
+		if(!slice || index >= (unsigned long long)slice->length)
+		{
+			err = el_INDEX_OUT_OF_RANGE_RUNTIME_ERROR;
+			goto runtime_error;
+		}
+		A = slice->elements[index];
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_SET_ELEMENT)
+	{
+		struct el_vm_slice * slice = A.p;
+		unsigned long long index = (unsigned long long)B.i;
+		if(!slice || index >= (unsigned long long)slice->length)
+		{
+			err = el_INDEX_OUT_OF_RANGE_RUNTIME_ERROR;
+			goto runtime_error;
+		}
+		slice->elements[index] = C;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_LENGTH)
+	{
+		struct el_vm_slice const * slice = B.p;
+		A.i = slice ? slice->length : 0;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_GET_COLUMN)
+	{
+		// The zero value of a soa slice is empty, as are its columns
+		union el_value const * columns = B.p;
+		A.p = columns ? ((union el_value const *)((char const *)columns + in->c))->p : NULL;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_CALL)
+	{
+		// The callee's frame starts after the caller's registers, its parameters are copied in and the rest zeroed
+		struct el_bc_function const * callee = &functions[in->b];
+		union el_value * callee_regs = regs + function->num_registers;
+		if(callee_regs + callee->num_registers > registers_end || frame + 1 == frames_end)
+		{
+			err = el_STACK_OVERFLOW_RUNTIME_ERROR;
+			goto runtime_error;
+		}
+		for(int i = 0; i < callee->num_parameters; ++i)
+		{
+			callee_regs[i] = regs[operands[in->c + i]];
+		}
+		memset(callee_regs + callee->num_parameters, 0, sizeof(union el_value) * (callee->num_registers - callee->num_parameters));
+
+		*++frame = (struct el_vm_frame){ ip, regs, function };
+		function = callee;
+		regs = callee_regs;
+		code = callee->code;
+		operands = callee->operands;
+		ip = code;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_KERNEL)
+		A.i = el_vm_run_kernel(module, &function->kernels[in->b], regs, operands + in->c);
+		VM_NEXT;
+	VM_CASE(el_BC_PARALLEL_FOR)
+		// The chunks' errors are reported by el_vm_parallel_for
+		err = el_vm_parallel_for(vm, in, regs, operands);
+		if(err)
+			goto finish;
+		VM_NEXT;
+	VM_CASE(el_BC_NEW_VECTOR)
+	{
+		union el_value * lanes = function->owned_vectors[in->a] && A.p ? A.p : el_vm_alloc(vm, in->b);
+		if(!lanes)
+		{
+			err = el_ALLOCATION_ERROR;
+			goto runtime_error;
+		}
+		for(int i = 0; i < in->b; ++i)
+		{
+			lanes[i] = regs[operands[in->c + i]];
+		}
+		A.p = lanes;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_GET_LANE)
+	{
+		union el_value const * lanes = B.p;
+		A.i = 0;
+		if(lanes)
+		{
+			A = lanes[in->c];
+		}
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_ADD_INT_VECTOR)
+	VM_CASE(el_BC_SUB_INT_VECTOR)
+	VM_CASE(el_BC_MUL_INT_VECTOR)
+	VM_CASE(el_BC_ADD_FLOAT_VECTOR)
+	VM_CASE(el_BC_SUB_FLOAT_VECTOR)
+	VM_CASE(el_BC_MUL_FLOAT_VECTOR)
+	VM_CASE(el_BC_DIV_FLOAT_VECTOR)
+	{
+		// Only a register which owns its block is written in place, any other may share it, e.g. with a variable it was moved to
+		union el_value * lanes = function->owned_vectors[in->a] && A.p ? A.p : el_vm_alloc(vm, in->b);
+		if(!lanes)
+		{
+			err = el_ALLOCATION_ERROR;
+			goto runtime_error;
+		}
+		el_vm_vector_op(in->op, lanes, regs[operands[in->c]].p, regs[operands[in->c + 1]].p, in->b);
+		A.p = lanes;
+		VM_NEXT;
+	}
+	VM_CASE(el_BC_JUMP)
+		ip = code + in->a;
+		VM_NEXT;
+	VM_CASE(el_BC_JUMP_IF)
+		if(A.i)
+		{
+			ip = code + in->b;
+		}
+		VM_NEXT;
+	VM_CASE(el_BC_JUMP_IF_NOT)
+		if(!A.i)
+		{
+			ip = code + in->b;
+		}
+		VM_NEXT;
+	VM_CASE(el_BC_JUMP_UNLESS_EQ_INT)
+		if(!(A.i == B.i))
+		{
+			ip = code + in->c;
+		}
+		VM_NEXT;
+	VM_CASE(el_BC_JUMP_UNLESS_LT_INT)
+		if(!(A.i < B.i))
+		{
+			ip = code + in->c;
+		}
+		VM_NEXT;
+	VM_CASE(el_BC_JUMP_UNLESS_LE_INT)
+		if(!(A.i <= B.i))
+		{
+			ip = code + in->c;
+		}
+		VM_NEXT;
+	VM_CASE(el_BC_JUMP_UNLESS_EQ_FLOAT)
+		if(!(A.f == B.f))
+		{
+			ip = code + in->c;
+		}
+		VM_NEXT;
+	VM_CASE(el_BC_JUMP_UNLESS_LT_FLOAT)
+		if(!(A.f < B.f))
+		{
+			ip = code + in->c;
+		}
+		VM_NEXT;
+	VM_CASE(el_BC_JUMP_UNLESS_LE_FLOAT)
+		if(!(A.f <= B.f))
+		{
+			ip = code + in->c;
+		}
+		VM_NEXT;
+	VM_CASE(el_BC_RET_VOID)
+		value = (union el_value){ 0 };
+		goto return_value;
+	VM_CASE(el_BC_RET)
+		value = A;
+	return_value:
+		if(frame == vm->frames)
+			goto finish;
+
+		// The call being returned from names the register receiving the value
+		ip = frame->return_address;
+		regs = frame->registers;
+		function = frame->function;
+		--frame;
+		code = function->code;
+		operands = function->operands;
+		regs[ip[-1].a] = value;
+		VM_NEXT;
+	}
+
+#undef A
+#undef B
+#undef C
+#undef WRAP
+#undef VM_LOOP
+#undef VM_CASE
+#undef VM_NEXT
+
+runtime_error:
+	el_vm_report(vm, function->name, err);
+
+finish:
+	vm->num_executed_instructions += num_executed;
+	if(err == el_SUCCESS && result)
+	{
+		*result = value;
+	}
+	return err;
+}
+
+// Run every chunk on the vm's workers, then move the workers' heaps to the vm s.t. what the chunks allocated lives as long as it does
+// Returns the first runtime error raised by a chunk, chunks not yet started once one has failed are skipped
+static int el_vm_parallel_for(struct el_vm * vm, struct el_bc_instruction const * in, union el_value const * regs, uint16_t const * operands)
+{
+	struct el_bc_function const * callee = &vm->program->functions[in->b];
+	struct el_vm_workers * workers = vm->workers ? vm->workers : el_vm_new_workers(vm);
+	int num_chunks = (int)regs[in->a].i;
+	if(!workers)
+	{
+		el_vm_report(vm, callee->name, el_ALLOCATION_ERROR);
+		return el_ALLOCATION_ERROR;
+	}
+	if(num_chunks <= 0)
+		return el_SUCCESS;
+
+	struct el_vm_parallel_for parallel_for = {
+		.workers = workers,
+		.function = in->b,
+		.num_parameters = callee->num_parameters,
+		.num_chunks = num_chunks,
+		.length = regs[operands[in->c]].i,
+		.arguments = fmalloc(sizeof(union el_value) * (size_t)callee->num_parameters * (size_t)workers->num_vms),
+		.err = el_SUCCESS
+	};
+	if(!parallel_for.arguments)
+	{
+		el_vm_report(vm, callee->name, el_ALLOCATION_ERROR);
+		return el_ALLOCATION_ERROR;
+	}
+	for(int i = 0; i < workers->num_vms; ++i)
+	{
+		union el_value * arguments = parallel_for.arguments + (size_t)callee->num_parameters * (size_t)i;
+		for(int j = 3; j < callee->num_parameters; ++j)
+		{
+			arguments[j] = regs[operands[in->c + j - 2]];
+		}
+	}
+
+	if(workers->has_pool)
+	{
+		el_thread_pool_for(&workers->pool, num_chunks, el_vm_run_chunk, &parallel_for);
+	}
+	else
+	{
+		for(int i = 0; i < num_chunks; ++i)
+		{
+			el_vm_run_chunk(&parallel_for, i, 0);
+		}
+	}
+	ffree(parallel_for.arguments);
+
+	// A large chunk may be in front of a worker's heap, which is kept behind the vm's current chunk
+	for(int i = 0; i < workers->num_vms; ++i)
+	{
+		struct el_vm * worker = &workers->vms[i];
+		vm->num_executed_instructions += worker->num_executed_instructions;
+		worker->num_executed_instructions = 0;
+		if(!worker->heap)
+			continue;
+
+		struct el_vm_heap_chunk * last = worker->heap;
+		while(last->next)
+		{
+			last = last->next;
+		}
+		if(vm->heap)
+		{
+			last->next = vm->heap->next;
+			vm->heap->next = worker->heap;
+		}
+		else
+		{
+			vm->heap = worker->heap;
+		}
+		worker->heap = NULL;
+	}
+
+	if(parallel_for.err)
+	{
+		el_vm_report(vm, parallel_for.error_function, parallel_for.err);
+	}
+	return parallel_for.err;
+}
+
+static void el_vm_run_chunk(void * context, int chunk, int thread_index)
+{
+	struct el_vm_parallel_for * parallel_for = context;
+	if(parallel_for->num_failed > 0)
+		return;
+
+	struct el_vm * worker = &parallel_for->workers->vms[thread_index];
+	union el_value * arguments = parallel_for->arguments + (size_t)parallel_for->num_parameters * (size_t)thread_index;
+	el_ir_chunk_bounds(parallel_for->length, parallel_for->num_chunks, chunk, &arguments[0].i, &arguments[1].i);
+	arguments[2].i = chunk;
+	int err = el_vm_call(worker, parallel_for->function, arguments, NULL);
+	if(err && el_atomic_fetch_add(&parallel_for->num_failed, 1) == 0)
+	{
+		parallel_for->err = err;
+		parallel_for->error_function = worker->error_function;
+	}
+}
+
+// A vm for each thread of a new pool, or a single vm if vm is itself a worker
+// The pool's threads refer to it, s.t. it is created in place
+static struct el_vm_workers * el_vm_new_workers(struct el_vm * vm)
+{
+	bool has_pool = !vm->parent;
+	int num_threads = has_pool ? el_num_hardware_threads() - 1 : 0;
+	struct el_vm_workers * workers = fmalloc(sizeof(struct el_vm_workers) + sizeof(struct el_vm) * (size_t)(num_threads + 1));
+	if(!workers)
+		return NULL;
+
+	workers->has_pool = has_pool;
+	workers->num_vms = 0;
+	vm->workers = workers;
+	if(has_pool && !el_thread_pool_new(&workers->pool, num_threads))
+	{
+		el_vm_delete_workers(vm);
+		return NULL;
+	}
+	for(int i = 0; i <= num_threads; ++i)
+	{
+		struct el_vm * worker = &workers->vms[i];
+		*worker = (struct el_vm){
+			.program = vm->program,
+			.globals = vm->globals,
+			.registers = fmalloc(sizeof(union el_value) * VM_MAX_NUM_REGISTERS),
+			.max_num_registers = VM_MAX_NUM_REGISTERS,
+			.frames = fmalloc(sizeof(struct el_vm_frame) * VM_MAX_NUM_FRAMES),
+			.max_num_frames = VM_MAX_NUM_FRAMES,
+			.parent = vm
+		};
+		++workers->num_vms;
+		if(!worker->registers || !worker->frames)
+		{
+			el_vm_delete_workers(vm);
+			return NULL;
+		}
+	}
+	return workers;
+}
+
+static void el_vm_delete_workers(struct el_vm * vm)
+{
+	struct el_vm_workers * workers = vm->workers;
+	if(!workers)
+		return;
+
+	if(workers->has_pool)
+	{
+		el_thread_pool_delete(&workers->pool);
+	}
+	for(int i = 0; i < workers->num_vms; ++i)
+	{
+		el_vm_delete(&workers->vms[i]);
+	}
+	ffree(workers);
+	vm->workers = NULL;
+}
+
+// Workers leave their errors to be reported by the vm which ran the parallel for
+static void el_vm_report(struct el_vm * vm, el_string function_name, int err)
+{
+	if(vm->parent)
+	{
+		vm->error_function = function_name;
+		return;
+	}
+	fprintf(stderr, "Runtime error in %s: %s\n", function_name ? function_name : "the file scope", el_runtime_error_message(err));
+}
+
+static union el_value * el_vm_alloc(struct el_vm * vm, size_t num_values)
+{
+	struct el_vm_heap_chunk * chunk = vm->heap;
+	if(!chunk || chunk->capacity - chunk->size < num_values)
+	{
+		size_t capacity = num_values > VM_HEAP_CHUNK_SIZE ? num_values : VM_HEAP_CHUNK_SIZE;
+		chunk = fmalloc(sizeof(struct el_vm_heap_chunk) + sizeof(union el_value) * capacity);
+		if(!chunk)
+			return NULL;
+
+		chunk->size = 0;
+		chunk->capacity = capacity;
+
+		// A chunk holding a single large object goes behind the current chunk, s.t. the space left in the current chunk is kept
+		if(vm->heap && capacity > VM_HEAP_CHUNK_SIZE)
+		{
+			chunk->next = vm->heap->next;
+			vm->heap->next = chunk;
+		}
+		else
+		{
+			chunk->next = vm->heap;
+			vm->heap = chunk;
+		}
+	}
+
+	union el_value * values = chunk->values + chunk->size;
+	chunk->size += num_values;
+	return values;
+}
+
+// The zero value of a string is NULL, which equals the empty string
+static bool el_vm_strings_equal(el_string lhs, el_string rhs)
+{
+	if(!lhs || !rhs)
+		return (lhs ? el_string_length(lhs) : 0) == (rhs ? el_string_length(rhs) : 0);
+	return el_string_equals(lhs, rhs);
+}
+
+char const * el_runtime_error_message(int err)
+{
+	switch(err)
+	{
+	case el_ALLOCATION_ERROR:
+		return "out of memory";
+	case el_DIVISION_BY_ZERO_RUNTIME_ERROR:
+		return "division by zero";
+	case el_INDEX_OUT_OF_RANGE_RUNTIME_ERROR:
+		return "index out of range";
+	case el_NULL_REFERENCE_RUNTIME_ERROR:
+		return "field of a zero data block";
+	case el_STACK_OVERFLOW_RUNTIME_ERROR:
+		return "stack overflow";
+	default:
+		return "unknown error";
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "bytecode.h"
+
+// Every register, global, field and element holds one value
+// The zero value of every type has every bit 0, data blocks and slices are references and start NULL
+union el_value
+{
+	long long i;
+	double f;
+	void * p;
+};
+
+// Elements follow the length
+struct el_vm_slice
+{
+	long long length;
+	union el_value elements[];
+};
+
+struct el_vm_frame;
+struct el_vm_heap_chunk;
+struct el_vm_workers;
+
+struct el_vm
+{
+	struct el_bc_program const * program;
+	union el_value * globals;
+
+	// Frames are windows onto the register stack, each starting where its caller's ends
+	union el_value * registers;
+	int max_num_registers;
+	struct el_vm_frame * frames;
+	int max_num_frames;
+
+	// Data blocks and slices are bump allocated and freed together with the vm
+	struct el_vm_heap_chunk * heap;
+
+	// Vms running the chunks of parallel for statements, created on the first one run
+	// Workers share their parent's globals, their heaps are moved to the parent once the chunks have run
+	// A worker reports its runtime errors to its parent rather than printing them, naming the function in error_function
+	struct el_vm_workers * workers;
+	struct el_vm * parent;
+	el_string error_function;
+
+	long long num_executed_instructions;
+};
+
+// program must outlive the vm, every global starts zeroed
+bool el_vm_new(struct el_vm * vm, struct el_bc_program const * program);
+
+void el_vm_delete(struct el_vm * vm);
+
+// Run the function with the program's num_parameters arguments, result receives its return value if it is not NULL
+// A runtime error is reported along with the function it occurred in and returned
+int el_vm_call(struct el_vm * vm, int function, union el_value const * arguments, union el_value * result);
+
+// What a runtime error returned by el_vm_call means, as it is reported
+char const * el_runtime_error_message(int err);